@@ -0,0 +1,169 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+/*---------------------------------------------------------------
+    APPLICATION: bow-vocabulary-train
+    PURPOSE: Learn a vocabulary tree of visual words (mrpt::vision::CVocabularyTree)
+             from the images in one or more rawlogs, for appearance-based place
+             recognition and loop closure detection.
+  ---------------------------------------------------------------*/
+
+#include <mrpt/base.h>
+#include <mrpt/obs.h>
+#include <mrpt/vision.h>
+#include <mrpt/otherlibs/tclap/CmdLine.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::slam;
+using namespace mrpt::vision;
+using namespace std;
+
+// Declare the supported command line switches ===========
+TCLAP::CmdLine cmd("bow-vocabulary-train", ' ', MRPT_getVersion().c_str());
+
+TCLAP::MultiArg<std::string> arg_input("i","input","Input rawlog file(s) with the training images (CObservationImage, or the left image of CObservationStereoImages)",true,"dataset.rawlog",cmd);
+TCLAP::ValueArg<std::string> arg_output("o","output","Output file for the vocabulary (gz-compressed)",false,"vocabulary.bow.gz","vocabulary.bow.gz",cmd);
+TCLAP::ValueArg<std::string> arg_config("c","config","Optional config. file with the feature detection parameters (see CFeatureExtraction::TOptions), in the section [FEATURES]. By default, FASTER-9 corners.",false,"","config.ini",cmd);
+TCLAP::ValueArg<std::string> arg_descriptor("","descriptor","The kind of descriptor of the features",false,"ORB","[ORB|SIFT|SURF|SpinImages]",cmd);
+TCLAP::ValueArg<unsigned int> arg_features("n","features","Number of features to detect in each image",false,500,"500",cmd);
+TCLAP::ValueArg<unsigned int> arg_branching("k","branching","Number of children of each node of the tree (the 'k' of k-means)",false,10,"10",cmd);
+TCLAP::ValueArg<unsigned int> arg_depth("l","levels","Number of levels of the tree: there will be up to branching^levels words",false,5,"5",cmd);
+TCLAP::ValueArg<unsigned int> arg_attempts("","kmeans-attempts","Number of runs of k-means for each node",false,1,"1",cmd);
+TCLAP::ValueArg<unsigned int> arg_max_samples("","max-samples","Maximum number of descriptors used to cluster each node",false,20000,"20000",cmd);
+TCLAP::ValueArg<unsigned int> arg_decimate("d","decimate","Use only one out of every N images",false,1,"1",cmd);
+TCLAP::ValueArg<unsigned int> arg_max_images("m","max-images","Maximum number of training images (0: all). The training needs about features*images KiB for ORB, half of it for SIFT",false,0,"0",cmd);
+
+
+/** Detects the features of an image and computes their descriptors */
+void extractFeatures(const CFeatureExtraction &fext, const CImage &img, const TDescriptorType descriptor, std::vector<CFeatureList> &images)
+{
+	images.push_back(CFeatureList());
+	fext.detectFeatures(img,images.back(),0,arg_features.getValue());
+	fext.computeDescriptors(img,images.back(),descriptor);
+}
+
+// ------------------------------------------------------
+//						MAIN
+// ------------------------------------------------------
+int main(int argc, char **argv)
+{
+	try
+	{
+		printf(" bow-vocabulary-train - Part of the MRPT\n");
+		printf(" MRPT C++ Library: %s - BUILD DATE %s\n", MRPT_getVersion().c_str(), MRPT_getCompilationDate().c_str());
+		printf("-------------------------------------------------------------------\n");
+
+		// Parse arguments:
+		if (!cmd.parse( argc, argv ))
+			return 0; // should exit.
+
+		// The kind of descriptor:
+		const std::string sDesc = arg_descriptor.getValue();
+		TDescriptorType descriptor;
+		if      (sDesc=="ORB")        descriptor = descORB;
+		else if (sDesc=="SIFT")       descriptor = descSIFT;
+		else if (sDesc=="SURF")       descriptor = descSURF;
+		else if (sDesc=="SpinImages") descriptor = descSpinImages;
+		else
+		{
+			cerr << "Error: Unknown descriptor: " << sDesc << endl;
+			TCLAP::StdOutput so;
+			so.usage(cmd);
+			return 1;
+		}
+
+		CFeatureExtraction fext;
+		fext.options.featsType = featFASTER9;
+		if (arg_config.isSet())
+		{
+			ASSERT_FILE_EXISTS_(arg_config.getValue())
+			fext.options.loadFromConfigFile(CConfigFile(arg_config.getValue()),"FEATURES");
+		}
+		fext.options.patchSize = 0;  // Only the descriptors are needed: don't keep a patch with each feature of all the images
+
+		// Extract the features of the training images. All of them are kept in memory until the training, which also needs
+		//  4 bytes per descriptor value (for ORB, 1 KiB per descriptor): use --max-images or --decimate for large datasets.
+		std::vector<CFeatureList> images;
+		const unsigned int decimate = std::max(1u,arg_decimate.getValue());
+		const unsigned int max_images = arg_max_images.getValue();
+		size_t nSeenImages = 0;
+
+		const std::vector<std::string> &inputs = arg_input.getValue();
+		for (size_t f=0;f<inputs.size() && (!max_images || images.size()<max_images);f++)
+		{
+			const std::string &fil = inputs[f];
+			ASSERT_FILE_EXISTS_(fil)
+			cout << "Reading images from: " << fil << endl;
+			CImage::IMAGES_PATH_BASE = CRawlog::detectImagesDirectory(fil);
+
+			CPipelinedRawlogReader rawlog(fil);
+			CActionCollectionPtr action;
+			CSensoryFramePtr     SF;
+			CObservationPtr      obs;
+			size_t               rawlogEntry = 0;
+
+			while ( (!max_images || images.size()<max_images) && rawlog.getActionObservationPairOrObservation(action,SF,obs,rawlogEntry) )
+			{
+				// All the observations of this entry:
+				std::vector<CObservationPtr> lstObs;
+				if (obs.present())
+					lstObs.push_back(obs);
+				else if (SF.present())
+					lstObs.insert(lstObs.end(),SF->begin(),SF->end());
+
+				for (size_t i=0;i<lstObs.size() && (!max_images || images.size()<max_images);i++)
+				{
+					const CImage *img = NULL;
+					if (IS_CLASS(lstObs[i],CObservationImage))
+						img = & CObservationImagePtr(lstObs[i])->image;
+					else if (IS_CLASS(lstObs[i],CObservationStereoImages))
+						img = & CObservationStereoImagesPtr(lstObs[i])->imageLeft;
+					if (!img || (nSeenImages++ % decimate)!=0) continue;
+
+					extractFeatures(fext,*img,descriptor,images);
+					if ((images.size() % 100)==0)
+						cout << "  " << images.size() << " images processed..." << endl;
+				}
+			}
+		}
+
+		size_t nFeats = 0;
+		for (size_t i=0;i<images.size();i++)
+			nFeats += images[i].size();
+		cout << "Training with " << nFeats << " features from " << images.size() << " images..." << endl;
+
+		// Learn the vocabulary:
+		CVocabularyTree voc;
+		voc.params.branching = arg_branching.getValue();
+		voc.params.depth = arg_depth.getValue();
+		voc.params.kmeansAttempts = arg_attempts.getValue();
+		voc.params.maxSamplesPerNode = arg_max_samples.getValue();
+
+		CTicTac tictac;
+		voc.train(images,descriptor);
+		cout << "Vocabulary with " << voc.getWordCount() << " words learnt in " << tictac.Tac() << " s." << endl;
+
+		cout << "Saving to: " << arg_output.getValue() << endl;
+		CFileGZOutputStream fo(arg_output.getValue());
+		fo << voc;
+
+		return 0;
+	}
+	catch(std::exception &e)
+	{
+		cerr << e.what() << endl;
+		return -1;
+	}
+	catch(...)
+	{
+		cerr << "Untyped exception." << endl;
+		return -1;
+	}
+}
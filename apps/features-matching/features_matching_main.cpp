@@ -87,6 +87,7 @@ bool DemoFeatures()
 		cout << "4: Intensity-domain spin image descriptors" << endl;
 		cout << "8: Polar image descriptor" << endl;
 		cout << "16: Log-Polar image descriptor" << endl;
+		cout << "32: ORB descriptor" << endl;
 
 		cout << endl << "Select the number for the desired method [1: SIFT]:";
 
@@ -179,7 +179,7 @@ void MapBuilding_ICP(const string &INI_FILENAME, const string &override_rawlog_f
 	COccupancyGridMap2D::TEntropyInfo	entropy;
 
 	size_t						rawlogEntry = 0;
-	CFileGZInputStream					rawlogFile( RAWLOG_FILE.c_str() );
+	CPipelinedRawlogReader				rawlogFile( RAWLOG_FILE );
 
 
 	// Prepare output directory:
@@ -226,7 +226,7 @@ void MapBuilding_ICP(const string &INI_FILENAME, const string &override_rawlog_f
 
 		// Load action/observation pair from the rawlog:
 		// --------------------------------------------------
-		if (! CRawlog::getActionObservationPairOrObservation( rawlogFile, action, observations, observation, rawlogEntry) )
+		if (! rawlogFile.getActionObservationPairOrObservation( action, observations, observation, rawlogEntry) )
 			break; // file EOF
 
 		const bool isObsBasedRawlog = observation.present();
@@ -295,8 +295,6 @@ void MapBuilding_ICP(const string &INI_FILENAME, const string &override_rawlog_f
 			// -----------
 			f_log.printf("%f %i\n",1000.0f*t_exec,mapBuilder.getCurrentlyBuiltMapSize() );
 
-			const CMultiMetricMap* mostLikMap =  mapBuilder.getCurrentlyBuiltMetricMap();
-
 			if (0==(step % LOG_FREQUENCY))
 			{
 				// Pose log:
@@ -312,6 +310,9 @@ void MapBuilding_ICP(const string &INI_FILENAME, const string &override_rawlog_f
 			// Save a 3D scene view of the mapping process:
 			if (0==(step % LOG_FREQUENCY) || (SAVE_3D_SCENE || win3D.present()))
 			{
+				// (With a sliding-window local map, this waits for the global map to be updated)
+				const CMultiMetricMap* mostLikMap =  mapBuilder.getCurrentlyBuiltMetricMap();
+
                 CPose3D robotPose;
 				mapBuilder.getCurrentPoseEstimation()->getMean(robotPose);
 
@@ -80,14 +80,14 @@ double grid_test_4(int a1, int a2)
 
 	float	p=0.57f;
 	COccupancyGridMap2D::cellType  logodd_obs = COccupancyGridMap2D::p2l( p );
-	COccupancyGridMap2D::cellType  *theMapArray = gridMap.getRow(0);
+	COccupancyGridMap2D::cellType  *theMapArray = gridMap.getRow(2);  // Rows are not contiguous in memory
 	unsigned  theMapSize_x = gridMap.getSizeX();
 	COccupancyGridMap2D::cellType   logodd_thres_occupied = COccupancyGridMap2D::OCCGRID_CELLTYPE_MIN+logodd_obs;
 
 	CTicTac tictac;
 	for (long i=0;i<N;i++)
 	{
-		COccupancyGridMap2D::updateCell_fast_occupied( 2, 2, logodd_obs,logodd_thres_occupied, theMapArray, theMapSize_x);
+		COccupancyGridMap2D::updateCell_fast_occupied( 2, 0, logodd_obs,logodd_thres_occupied, theMapArray, theMapSize_x);
 	}
 	return tictac.Tac()/N;
 }
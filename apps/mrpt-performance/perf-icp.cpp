@@ -60,6 +60,7 @@ double icp_test_1(int a1, int a2)
 	CICP::TConfigParams  icpOptions;
 
 	icpOptions.maxIterations = 40;
+	icpOptions.pyramid_levels = a2>0 ? a2 : 1;
 
 
 	// ---------------------------------
@@ -127,6 +128,7 @@ void register_tests_icpslam()
 {
 	lstTests.push_back( TestData("icp-slam (match points): Run with sample dataset",icp_test_1,  0) );
 	lstTests.push_back( TestData("icp-slam (match grid): Run with sample dataset",icp_test_1,  1) );
+	lstTests.push_back( TestData("icp-slam (match points, 3-level pyramid): Run with sample dataset",icp_test_1,  0, 3) );
 }
 
 
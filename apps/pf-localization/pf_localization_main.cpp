@@ -34,6 +34,7 @@ using namespace std;
 // Forward declaration:
 void do_pf_localization(const std::string &iniFilename,const std::string &cmdline_rawlog_file);
 void getGroundTruth( CPose2D &expectedPose, size_t rawlogEntry, const CMatrixDouble &GT, const TTimeStamp &cur_time);
+void loadMapFile( const std::string &fil, CSerializable &obj );
 
 
 // ------------------------------------------------------
@@ -188,7 +189,7 @@ void do_pf_localization(const std::string &ini_fil, const std::string &cmdline_r
 			// It's a ".simplemap":
 			// -------------------------
 			printf("Loading '.simplemap' file...");
-			CFileGZInputStream(MAP_FILE) >> simpleMap;
+			loadMapFile(MAP_FILE, simpleMap);
 			printf("Ok\n");
 
 			ASSERT_( simpleMap.size()>0 );
@@ -205,7 +206,7 @@ void do_pf_localization(const std::string &ini_fil, const std::string &cmdline_r
 			// -------------------------
 			printf("Loading gridmap from '.gridmap'...");
 			ASSERT_( metricMap.m_gridMaps.size()==1 );
-			CFileGZInputStream(MAP_FILE) >> (*metricMap.m_gridMaps[0]);
+			loadMapFile(MAP_FILE, *metricMap.m_gridMaps[0]);
 			printf("Ok\n");
 		}
 		else
@@ -292,7 +293,7 @@ void do_pf_localization(const std::string &ini_fil, const std::string &cmdline_r
 			// Load the rawlog:
 			// --------------------------
 			printf("Opening the rawlog file...");
-			CFileGZInputStream rawlog_in_stream(RAWLOG_FILE);
+			CPipelinedRawlogReader rawlog_in_stream(RAWLOG_FILE);
 			printf("OK\n");
 
 			// The experiment directory is:
@@ -405,8 +406,7 @@ void do_pf_localization(const std::string &ini_fil, const std::string &cmdline_r
 				CSensoryFramePtr     observations;
 				CObservationPtr 	 obs;
 
-				if (!CRawlog::getActionObservationPairOrObservation(
-					rawlog_in_stream,      // In stream
+				if (!rawlog_in_stream.getActionObservationPairOrObservation(
 					action,	observations,  // Out pair <action,SF>, or:
 					obs,                   // Out single observation
 					rawlogEntry            // In/Out index counter.
@@ -844,6 +844,20 @@ void do_pf_localization(const std::string &ini_fil, const std::string &cmdline_r
 }
 
 
+// Loads a map from a file, which can be gzip-compressed or not. Non-compressed files are memory-mapped,
+//  so large arrays (e.g. grid map cells) are used directly from the file instead of being copied.
+void loadMapFile( const std::string &fil, CSerializable &obj )
+{
+	uint8_t magic[2] = {0,0};
+	{
+		CFileInputStream f(fil);
+		f.ReadBufferImmediate(magic,2);  // (May be 1 byte only for tiny files)
+	}
+	if (magic[0]==0x1f && magic[1]==0x8b)
+			CFileGZInputStream(fil) >> obj;
+	else	CFileMMapInputStream(fil) >> obj;
+}
+
 void getGroundTruth( CPose2D &expectedPose, size_t rawlogEntry, const CMatrixDouble &GT, const TTimeStamp &cur_time)
 {
 	if (GT.getColCount()==4)
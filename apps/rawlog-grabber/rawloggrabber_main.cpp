@@ -86,6 +86,7 @@ int main(int argc, char **argv)
 		bool			use_sensoryframes = false;
 		int				GRABBER_PERIOD_MS = 1000;
 		int 			rawlog_GZ_compress_level  = 1;  // 0: No compress, 1-9: compress level
+		int 			rawlog_GZ_threads  = 0;  // Threads compressing the rawlog in parallel. 0: One per core
 
 		MRPT_LOAD_CONFIG_VAR( rawlog_prefix, string, iniFile, GLOBAL_SECTION_NAME );
 		MRPT_LOAD_CONFIG_VAR( time_between_launches, int, iniFile, GLOBAL_SECTION_NAME );
@@ -94,6 +95,7 @@ int main(int argc, char **argv)
 		MRPT_LOAD_CONFIG_VAR( GRABBER_PERIOD_MS, int, iniFile, GLOBAL_SECTION_NAME );
 
 		MRPT_LOAD_CONFIG_VAR( rawlog_GZ_compress_level, int, iniFile, GLOBAL_SECTION_NAME );
+		MRPT_LOAD_CONFIG_VAR( rawlog_GZ_threads, int, iniFile, GLOBAL_SECTION_NAME );
 
 		// Build full rawlog file name:
 		string	rawlog_postfix = "_";
@@ -155,9 +157,9 @@ int main(int argc, char **argv)
 		// ----------------------------------------------
 		// Run:
 		// ----------------------------------------------
-		CFileGZOutputStream	out_file;
+		CParallelGZOutputStream	out_file;
 
-		out_file.open( rawlog_filename, rawlog_GZ_compress_level );
+		out_file.open( rawlog_filename, rawlog_GZ_compress_level, rawlog_GZ_threads );
 
 		CSensoryFrame						curSF;
 		CGenericSensor::TListObservations	copy_of_global_list_obs;
@@ -346,6 +348,11 @@ int main(int argc, char **argv)
 		// Flush file to disk:
 		out_file.close();
 
+		const CParallelGZOutputStream::TStats gz_stats = out_file.getStats();
+		cout << format("[main thread] Rawlog: %sB in %sB out. The compression threads delayed the grabber %u times (%.03f s in total)\n",
+			unitsFormat(gz_stats.bytes_in).c_str(), unitsFormat(gz_stats.bytes_out).c_str(),
+			static_cast<unsigned int>(gz_stats.stalls), gz_stats.stall_time );
+
 		// Wait all threads:
 		// ----------------------------
 		allThreadsMustExit = true;
@@ -11,6 +11,7 @@
 #define RAWLOG_PROCESSOR_H
 
 #include <mrpt/slam/CRawlog.h>
+#include <mrpt/slam/CPipelinedRawlogReader.h>
 #include <mrpt/base.h>
 
 // Aparently, TCLAP headers can't be included in more than one source file
@@ -59,9 +60,12 @@ namespace mrpt
 
 				m_timParse.Tic();
 
+				// Decompression and deserialization run in other threads while we process the entries:
+				mrpt::slam::CPipelinedRawlogReader  rawlog;
+				rawlog.open(m_in_rawlog);
+
 				// Parse the entire rawlog:
-				while (mrpt::slam::CRawlog::getActionObservationPairOrObservation(
-					m_in_rawlog,
+				while (rawlog.getActionObservationPairOrObservation(
 					actions,SF, obs,
 					m_rawlogEntry ) )
 				{
@@ -74,23 +78,7 @@ namespace mrpt
 						}
 
 					// Update status to the console?
-					const mrpt::system::TTimeStamp tNow = mrpt::system::now();
-					if ( mrpt::system::timeDifference(m_last_console_update,tNow)>0.25)
-					{
-						m_last_console_update = tNow;
-						uint64_t fil_pos = m_in_rawlog.getPosition();
-						if(verbose)
-						{
-							std::cout << mrpt::format("Progress: %7u objects --- Pos: %9sB/%c%9sB \r",
-							(unsigned int)m_rawlogEntry,
-							mrpt::system::unitsFormat(fil_pos).c_str(),
-							(fil_pos>m_filSize ? '>':' '),
-							mrpt::system::unitsFormat(m_filSize).c_str()
-							);  // \r -> don't go to the next line...
-
-							std::cout.flush();
-						}
-					}
+					showProgress(rawlog.getInputPosition());
 
 					// Do whatever:
 					bool process_ret = processOneEntry(actions,SF,obs);
@@ -117,7 +105,6 @@ namespace mrpt
 
 			} // end doProcessRawlog
 
-
 			// The virtual method of the user to be invoked for each read object:
 			//  Return false to abort and stop the read loop.
 			virtual bool processOneEntry(
@@ -134,6 +121,27 @@ namespace mrpt
 				// Default: Do nothing
 			}
 
+		private:
+			void showProgress(const uint64_t fil_pos)
+			{
+				const mrpt::system::TTimeStamp tNow = mrpt::system::now();
+				if ( mrpt::system::timeDifference(m_last_console_update,tNow)>0.25)
+				{
+					m_last_console_update = tNow;
+					if(verbose)
+					{
+						std::cout << mrpt::format("Progress: %7u objects --- Pos: %9sB/%c%9sB \r",
+						(unsigned int)m_rawlogEntry,
+						mrpt::system::unitsFormat(fil_pos).c_str(),
+						(fil_pos>m_filSize ? '>':' '),
+						mrpt::system::unitsFormat(m_filSize).c_str()
+						);  // \r -> don't go to the next line...
+
+						std::cout.flush();
+					}
+				}
+			}
+
 		}; // end CRawlogProcessor
 
 		/** A virtual class that implements the common stuff around parsing a rawlog file
@@ -20,13 +20,14 @@
 
 /** Auxiliary struct that performs all the checks and create the
      output rawlog stream, publishing it as "out_rawlog"
+     (unless open_output_stream=false, for ops which write other file formats)
 */
 struct TOutputRawlogCreator
 {
 	mrpt::utils::CFileGZOutputStream out_rawlog;
 	std::string out_rawlog_filename;
 
-	TOutputRawlogCreator();
+	TOutputRawlogCreator(const bool open_output_stream = true);
 };
 
 // ======================================================================
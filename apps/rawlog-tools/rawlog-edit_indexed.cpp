@@ -0,0 +1,69 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include "rawlog-edit-declarations.h"
+
+#include <mrpt/slam/CIndexedRawlog.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::slam;
+using namespace mrpt::system;
+using namespace mrpt::rawlogtools;
+using namespace std;
+
+
+// ======================================================================
+//		op_to_indexed
+// ======================================================================
+DECLARE_OP_FUNCTION(op_to_indexed)
+{
+	// A class to do this operation:
+	class CRawlogProcessor_ToIndexed : public CRawlogProcessor
+	{
+	protected:
+		CIndexedRawlogWriter  &m_out;
+
+	public:
+		CRawlogProcessor_ToIndexed(CFileGZInputStream &in_rawlog, TCLAP::CmdLine &cmdline, bool verbose, CIndexedRawlogWriter &out) :
+			CRawlogProcessor(in_rawlog,cmdline,verbose),
+			m_out(out)
+		{
+		}
+
+		bool processOneEntry(
+			CActionCollectionPtr &actions,
+			CSensoryFramePtr     &SF,
+			CObservationPtr      &obs)
+		{
+			if (actions) m_out.write(actions);
+			if (SF)      m_out.write(SF);
+			if (obs)     m_out.write(obs);
+			return true;
+		}
+	};
+
+	// Process
+	// ---------------------------------
+	TOutputRawlogCreator	outrawlog(false);
+	CIndexedRawlogWriter	out_irawlog;
+	if (!out_irawlog.open(outrawlog.out_rawlog_filename))
+		throw runtime_error(string("*ABORTING*: Cannot open output file: ") + outrawlog.out_rawlog_filename );
+
+	CRawlogProcessor_ToIndexed proc(in_rawlog,cmdline,verbose,out_irawlog);
+	proc.doProcessRawlog();
+
+	const size_t nEntries = out_irawlog.size();
+	out_irawlog.close(); // Write the index
+
+	// Dump statistics:
+	// ---------------------------------
+	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse << "\n";
+	VERBOSE_COUT << "Indexed entries                   : " << nEntries << "\n";
+}
@@ -58,6 +58,7 @@ DECLARE_OP_FUNCTION(op_stereo_rectify);
 DECLARE_OP_FUNCTION(op_rename_externals);
 DECLARE_OP_FUNCTION(op_list_timestamps);
 DECLARE_OP_FUNCTION(op_remap_timestamps);
+DECLARE_OP_FUNCTION(op_to_indexed);
 
 // Declare the supported command line switches ===========
 TCLAP::CmdLine cmd("rawlog-edit", ' ', MRPT_getVersion().c_str());
@@ -231,6 +232,12 @@ int main(int argc, char **argv)
 			,cmd,false));
 		ops_functors["rename-externals"] = &op_rename_externals;
 
+		arg_ops.push_back(new TCLAP::SwitchArg("","to-indexed",
+			"Op: Convert the input rawlog into a seekable, indexed rawlog file (see mrpt::slam::CIndexedRawlogReader), with O(1) access to any entry.\n"
+			"Requires: -o (or --output)\n"
+			,cmd,false));
+		ops_functors["to-indexed"] = &op_to_indexed;
+
 
 
 		// --------------- End of list of possible operations --------
@@ -317,7 +324,7 @@ int main(int argc, char **argv)
 // ======================================================================
 //   See TOutputRawlogCreator declaration
 // ======================================================================
-TOutputRawlogCreator::TOutputRawlogCreator()
+TOutputRawlogCreator::TOutputRawlogCreator(const bool open_output_stream)
 {
 	if (!arg_output_file.isSet())
 		throw runtime_error("This operation requires an output file. Use '-o file' or '--output file'.");
@@ -326,7 +333,7 @@ TOutputRawlogCreator::TOutputRawlogCreator()
 	if (fileExists(out_rawlog_filename) && !arg_overwrite.getValue() )
 		throw runtime_error(string("*ABORTING*: Output file already exists: ") + out_rawlog_filename + string("\n. Select a different output path, remove the file or force overwrite with '-w' or '--overwrite'.") );
 
-	if (!out_rawlog.open(out_rawlog_filename))
+	if (open_output_stream && !out_rawlog.open(out_rawlog_filename))
 		throw runtime_error(string("*ABORTING*: Cannot open output file: ") + out_rawlog_filename );
 }
 
@@ -164,7 +164,7 @@ void MapBuilding_RBPF()
 	char								strFil[1000];
 
 	size_t								rawlogEntry = 0;
-	CFileGZInputStream					rawlogFile( RAWLOG_FILE );
+	CPipelinedRawlogReader				rawlogFile( RAWLOG_FILE );
 
 	// ---------------------------------
 	//		MapPDF opts
@@ -266,7 +266,7 @@ void MapBuilding_RBPF()
 
 		// Load action/observation pair from the rawlog:
 		// --------------------------------------------------
-		if (! CRawlog::readActionObservationPair( rawlogFile, action, observations, rawlogEntry) )
+		if (! rawlogFile.readActionObservationPair( action, observations, rawlogEntry) )
 			break; // file EOF
 
 		if (rawlogEntry>=rawlog_offset)
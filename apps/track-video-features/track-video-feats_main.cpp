@@ -79,6 +79,7 @@ int DoTrackingDemo(CCameraSensorPtr  cam, bool  DO_SAVE_VIDEO)
 	tracker->extra_params["minimum_KLT_response_to_add"]  = 10;
 	tracker->extra_params["add_new_feat_max_features"]    = 350;
 	tracker->extra_params["add_new_feat_patch_size"]      = 11;
+	tracker->extra_params["add_new_feat_grid_cell_size"]  = 64;  // Detect new features evenly spread over the image, in parallel
 
 	tracker->extra_params["update_patches_every"]		= 0;  // Don't update patches.
 
@@ -92,7 +93,7 @@ int DoTrackingDemo(CCameraSensorPtr  cam, bool  DO_SAVE_VIDEO)
 	//tracker->extra_params["LK_levels"] = 3;
 	//tracker->extra_params["LK_max_iters"] = 10;
 	//tracker->extra_params["LK_epsilon"] = 0.1;
-	//tracker->extra_params["LK_max_tracking_error"] = 150;
+	//tracker->extra_params["LK_max_tracking_error"] = 10;
 
 
 	// --------------------------------
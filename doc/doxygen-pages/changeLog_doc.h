@@ -14,11 +14,94 @@
 
  <a name="1.1.1">
   <h2>Version 1.1.1: (Under development) </h2></a>
+	- Changes in apps:
+		- [rawlog-edit](http://www.mrpt.org/Application%3Arawlog-edit):
+			- New operation: --to-indexed, to convert rawlogs into the seekable format of mrpt::slam::CIndexedRawlogReader
+			- Rawlogs are decompressed and deserialized in a background thread while the entries are processed.
+		- rawlog-grabber: Rawlogs are compressed in parallel with mrpt::utils::CParallelGZOutputStream. New config variable "rawlog_GZ_threads".
+		- icp-slam, rbpf-slam, pf-localization: Rawlogs are read with mrpt::slam::CPipelinedRawlogReader, decoding the next entries while the current one is processed.
+		- pf-localization: Non-compressed map files are loaded with mrpt::utils::CFileMMapInputStream.
+		- features-matching: New ORB descriptor.
+		- track-video-features: New features are detected evenly spread over the image, in parallel.
+	- New apps:
+		- bow-vocabulary-train: Learns a vocabulary tree of visual words (mrpt::vision::CVocabularyTree) from the images of rawlogs.
+	- New classes:
+		- [mrpt-base]
+			- mrpt::utils::CCopyOnWriteGrid: A 2D array of reference-counted rows which are shared between copies until modified.
+			- mrpt::utils::CParallelGZOutputStream: Writes gzip files compressing blocks of data in parallel threads (as "pigz" does), with statistics about the stalls of the writer.
+			- mrpt::utils::CFileMMapInputStream, mrpt::utils::CMemoryMappedRegion: Read-only file streams backed by memory-mapped files, which can lend their memory to the objects being deserialized.
+			- mrpt::utils::CLRUCache: A key-value cache with a maximum size in bytes, which discards the least recently used items.
+			- mrpt::system::CVectorMemoryPool: A thread-safe pool for recycling the buffers of std::vector's, built upon mrpt::system::CGenericMemoryPool.
+		- [mrpt-obs]
+			- mrpt::slam::CIndexedRawlogWriter, mrpt::slam::CIndexedRawlogReader: A seekable rawlog file format, made of independently compressed blocks and an index of entries, with O(1) access to any entry by index or timestamp.
+			- mrpt::slam::CPipelinedRawlogReader: Reads rawlogs through a multi-threaded pipeline of I/O, decompression and deserialization stages connected by bounded queues.
+			- mrpt::slam::CLazyRawlog, mrpt::slam::CLazySimpleMap: Read-only rawlogs and simplemaps which keep in memory only an index of their entries and load them on demand, through a LRU cache of limited size.
+		- [mrpt-vision]
+			- mrpt::vision::CHammingMultiIndex: Nearest neighbor searches of binary descriptors in Hamming space by multi-index hashing.
+			- mrpt::vision::CDescriptorKDForest, mrpt::vision::CDescriptorLSH: Persistent indices of real-valued (randomized KD-forest) and binary (LSH) descriptors, with insertion and removal of descriptors, batched parallel queries with ratio test, and serialization.
+			- mrpt::vision::CVocabularyTree, mrpt::vision::CBoWDatabase: Bag-of-words representation of images, with a vocabulary tree learnt by hierarchical k-means (descriptors are looked up in parallel and in logarithmic time) and a database with inverted files which scores only the images sharing words with the query.
+	- Changes in classes:
+		- [mrpt-base]
+			- mrpt::system::parallel_for() now runs on a pool of worker threads when MRPT is not built against TBB. See mrpt::system::setParallelizationThreadsCount()
+			- Particle filter resampling (mrpt::bayes::CParticleFilterCapable::performResampling()) reuses its buffers and replaces particles in place, without reallocating them. See mrpt::bayes::CParticleFilterData::substituteParticlesInPlace()
+			- mrpt::math::KDTreeCapable has new batch query methods (1-NN, k-NN and radius searches), which solve many queries at once in parallel: kdTreeClosestPoint2DBatch(), kdTreeNClosestPoint3DIdxBatch(), kdTreeRadiusSearch2DBatch(), etc.
+			- mrpt::math::KDTreeCapable can index points appended to the data set in a "logarithmic forest" of small KD-trees, instead of rebuilding the whole index. See mrpt::math::KDTreeCapable::TKDTreeSearchParams::incremental_build
+			- New method mrpt::utils::CStream::ReadBufferBorrow() for zero-copy deserialization from streams whose data is already in memory. mrpt::utils::CImage (JPEG and zip images) and mrpt::compress::zip::decompress() use it.
+			- mrpt::utils::CFileGZInputStream::Seek() is now implemented (forward and backward, on uncompressed positions).
+			- mrpt::utils::CCopyOnWriteGrid can borrow its cells from read-only external memory, copying each row upon the first write. See mrpt::utils::CCopyOnWriteGrid::assignBorrowed()
+			- mrpt::system::CGenericMemoryPool has new methods clear(), size() and getStatistics(), and mrpt::system::CGenericMemoryPool::request_memory() is now thread-safe also when the pool is empty.
+			- mrpt::utils::CImage recycles the memory of destroyed images for new images of the same size and format (only with OpenCV), so grabbing images (e.g. mrpt::slam::CObservationImage, mrpt::slam::CObservationStereoImages) does not allocate new memory for each frame.
+		- [mrpt-obs]
+			- New method mrpt::slam::CMetricMap::computeObservationLikelihoodForPoses() for evaluating one observation at many poses at once.
+			- mrpt::slam::CRawlog::loadFromRawLogFile() also loads indexed rawlog files.
+			- mrpt::slam::CRawlog::loadFromRawLogFile() decodes the file in background threads with mrpt::slam::CPipelinedRawlogReader.
+			- mrpt::slam::CIndexedRawlogReader::getEntry() can return the serialized size of the entry.
+			- mrpt::slam::CObservation2DRangeScan recycles the memory of its scans through a memory pool. Sensor drivers and rawlog readers should use the new method mrpt::slam::CObservation2DRangeScan::resizeScan().
+			- mrpt::slam::CObservation3DRangeScan::project3DPointsFromDepthImageInto() projects rows in parallel and with SSE2 (for any image width and also for non-depth ranges), with per-column and per-row ray tables, writing straight into point maps. New options in mrpt::slam::T3DPointsProjectionParams for decimation and range clipping in the same pass.
+		- [mrpt-maps]
+			- mrpt::slam::COccupancyGridMap2D::computeObservationLikelihoodForPoses() evaluates likelihood-field, ray-tracing and consensus likelihoods in parallel.
+			- mrpt::slam::COccupancyGridMap2D::computeLikelihoodField_Thrun() transforms points and evaluates log-likelihoods with SSE2 when available.
+			- mrpt::slam::COccupancyGridMap2D can keep a tiled, incrementally updated distance transform for the likelihood field model. See mrpt::slam::COccupancyGridMap2D::TLikelihoodOptions::LF_useDistanceTransform
+			- mrpt::slam::COccupancyGridMap2D stores its cells in copy-on-write rows, so copies of a map (e.g. the particles of a RBPF after resampling) share all their unmodified rows. Rows returned by mrpt::slam::COccupancyGridMap2D::getRow() are no longer contiguous in memory.
+			- mrpt::slam::COccupancyGridMap2D uses the cells directly from memory-mapped files (mrpt::utils::CFileMMapInputStream) when loaded from them, until they are modified.
+			- mrpt::slam::CPointsMap::determineMatching2D() and mrpt::slam::CPointsMap::determineMatching3D() look for all the nearest neighbors at once with the parallel batch KD-tree queries.
+			- Point maps (mrpt::slam::CPointsMap) no longer rebuild their whole KD-tree after inserting points or observations, only the new points are indexed.
+			- New method mrpt::slam::CPointsMap::getLocalShapes() estimates (in parallel) and caches the normal vector and curvature of each point.
+			- New methods mrpt::slam::CPointsMap::voxelDownsample() and mrpt::slam::CPointsMap::getVoxelDownsampled() (cached) for voxel-grid decimation of point maps.
+			- New methods mrpt::slam::CPointsMap::saveBinaryColumnsFile() and mrpt::slam::CPointsMap::loadBinaryColumnsFile(), for a binary columnar format where each field of the points is read or written with a single I/O call (optionally, from memory-mapped files). See also mrpt::slam::CPointsMap::getPointsColumns()
+			- New method mrpt::slam::CPointsMap::fuseWithVoxels() and insertion option mrpt::slam::CPointsMap::TInsertionOptions::voxelFusionSize, to insert points keeping one (first or averaged) point per occupied voxel, with O(1) hash table lookups per point.
+			- mrpt::slam::CPointsMap::savePCDFile() and mrpt::slam::CPointsMap::loadPCDFile() no longer require PCL (except for "binary_compressed" files), save all the fields of the points and read them in large blocks.
+		- [mrpt-slam]
+			- mrpt::slam::CMonteCarloLocalization2D evaluates all the particles at once with the batch likelihood API of its map.
+			- mrpt::slam::CMultiMetricMapPDF updates the maps and computes the weights of all the particles in parallel. Timings are available via mrpt::slam::CMultiMetricMapPDF::getTimeLogger()
+			- mrpt::slam::PF_implementation replaces particle sets in place and reuses the buffers of the new particle set between iterations, also in KLD-sampling.
+			- mrpt::slam::CICP has two new 3D methods: point-to-plane ICP (mrpt::slam::icpPointToPlane) and Generalized-ICP (mrpt::slam::icpGICP).
+			- mrpt::slam::CICP can align point maps coarse-to-fine, with a pyramid of voxel-decimated maps. See mrpt::slam::CICP::TConfigParams::pyramid_levels
+			- mrpt::slam::CMetricMapBuilderICP can align scans against a sliding-window local map of the latest keyframes (by distance, age or count), updating the global map in a background thread, so the time per scan does not grow with the map. See mrpt::slam::CMetricMapBuilderICP::TConfigParams::localMapMaxDistance
+		- [mrpt-vision]
+			- New ORB (oriented BRIEF) binary descriptor: mrpt::vision::descORB, stored in mrpt::vision::CFeature::TDescriptors::ORB and serialized in mrpt::vision::CFeature and mrpt::vision::CFeatureList text files.
+			- Binary descriptors are matched by Hamming distance (mrpt::vision::hammingDistance(), with POPCNT or SSSE3 when available) with the new method mrpt::vision::TMatchingOptions::mmDescriptorORB or the parallel brute-force matcher mrpt::vision::find_descriptor_pairings_hamming().
+			- New method mrpt::vision::CFeatureExtraction::detectFeaturesPyramid(): FASTER corners over an image pyramid, detected in parallel over a grid of cells with adaptive thresholds and non-maximum suppression per cell, so they are evenly spread. The low-level version is mrpt::vision::CFeatureExtraction::detectFeatures_SSE2_FASTER_grid().
+			- mrpt::vision::CGenericFeatureTracker can detect new features with the grid detector. See the new parameter "add_new_feat_grid_cell_size".
+			- mrpt::vision::CFeatureTracker_KL no longer calls OpenCV: it is a pyramidal Lucas-Kanade tracker with fixed-point SSE2 interpolation of the patches, which tracks the features in parallel and reuses the image pyramid (with its Scharr gradients) of the previous frame. New parameter "LK_min_eigenvalue".
+			- New method mrpt::vision::CImagePyramid::buildGradients(), which computes (in parallel and with SSE2) the Scharr gradients of all the octaves.
+			- mrpt::slam::CLandmarksMap keeps an index of the SIFT descriptors of its landmarks (mrpt::slam::CLandmarksMap::TCustomSequenceLandmarks::getSIFTDescriptorIndex()), updated as landmarks are inserted or erased, which is used for matching by descriptors (SIFTMatching3DMethod=1).
+		- [mrpt-hmtslam]
+			- New topological loop-closure detector "bow" (mrpt::hmtslam::CTopLCDetector_BoW), which compares the images of the areas as bags of visual words through a mrpt::vision::CBoWDatabase. Its options are read from the section "TLC_BOW".
 	- Build system:
 		- Fixes to build in OS X - [Patch](https://gist.github.com/randvoorhies/9283072) by Randolph Voorhies.
   	- BUG FIXES:
 		- New implementation of mrpt::synch::CSemaphore avoids crashes in OS X - by Randolph Voorhies.
 		- mrpt::opengl::CArrow was always drawn of normalized length.
+		- mrpt::slam::COccupancyGridMap2D::computeClearance() read wrong cells in non-square grid maps.
+		- mrpt::bayes::CParticleFilterCapable::performResampling() did not reset the particle weights if the number of output particles was not given explicitly.
+		- mrpt::slam::CPointsMap::loadPCDFile() did not load the points read from the file.
+		- mrpt::slam::CObservation3DRangeScan::project3DPointsFromDepthImageInto() took the colors of the next pixel when the depth and intensity cameras coincide.
+		- mrpt::bayes::CParticleFilterCapable::computeResampling() read out of bounds when asked for more output particles than input ones, and the residual part of prResidual was biased towards the first particles.
+		- mrpt::vision::CFeatureTracker_KL truncated the parameter "LK_epsilon" to an integer.
+		- mrpt::slam::CPointsMap::boundingBox() took into account stale or zero values past the last point in SSE2 builds, if the number of points was not a multiple of 4, and could return a wrong maximum for negative coordinates.
+		- mrpt::slam::CLandmarksMap::computeMatchingWith3DLandmarks() with SIFTMatching3DMethod=1 paired each landmark with the one of most different descriptor, and reported wrong indices.
+		- mrpt::vision::TSURFDescriptorsKDTreeIndex used the SIFT descriptors of the features.
 
 <hr>
  <a name="1.1.0">
@@ -59,6 +59,10 @@ patch, with or without a set of descriptors.
 
 - mrpt::vision::TSIFTDescriptorsKDTreeIndex, mrpt::vision::find_descriptor_pairings() and others: KD-tree-based SIFT/SURF feature matching.
 
+- mrpt::vision::CDescriptorKDForest, mrpt::vision::CDescriptorLSH: Persistent, incrementally updated indices of descriptors for approximate nearest neighbor searches.
+
+- mrpt::vision::CVocabularyTree, mrpt::vision::CBoWDatabase: Bag of visual words, with a vocabulary tree learnt by hierarchical k-means and inverted files for finding similar images (place recognition).
+
 - mrpt::vision::CVideoFileWriter: A class to write video files.
 
 - mrpt::vision::CUndistortMap: A cache of the map for undistorting image, very efficient for sequences of images all with the same distortion parameters.
@@ -33,7 +33,7 @@ namespace bayes
 
 	public:
 
-		CParticleFilterCapable() : m_fastDrawAuxiliary()
+		CParticleFilterCapable() : m_fastDrawAuxiliary(), m_resamplingAuxiliary()
 		{ }
 
 
@@ -133,6 +133,8 @@ namespace bayes
 			 );
 
 		/**  Performs the substitution for internal use of resample in particle filter algorithm, don't call it directly.
+		 *  The replacement is done in place: particles are not reallocated, and those selected more than once overwrite the
+		 *  data of particles not selected at all (see CParticleFilterData::substituteParticlesInPlace()), hence the order of the resulting particles is unspecified.
 		 *  \param indx The indices of current m_particles to be saved as the new m_particles set.
 		 */
 		virtual void  performSubstitution( const std::vector<size_t> &indx) = 0;
@@ -170,6 +172,31 @@ namespace bayes
 			size_t          out_particle_count = 0
 			);
 
+		/** Auxiliary buffers for computeResampling() and performSubstitution(), kept between calls to avoid memory reallocations.
+		  */
+		struct BASE_IMPEXP TResamplingAuxVars
+		{
+			TResamplingAuxVars() : log_ws(), indexes(), linW(), Q(), T(), N(), subst_counts(), subst_positions()
+			{ }
+
+			vector_double        log_ws;    //!< Used in performResampling()
+			std::vector<size_t>  indexes;   //!< Used in performResampling() and prepareFastDrawSample()
+			std::vector<double>  linW, Q, T;
+			std::vector<size_t>  N;
+			std::vector<size_t>  subst_counts, subst_positions;  //!< Used in performSubstitution()
+		};
+
+		/** Like computeResampling() above, but using (and reusing) the given auxiliary buffers instead of allocating temporary ones.
+		  * \sa performResampling
+		  */
+		static void computeResampling(
+			CParticleFilter::TParticleResamplingAlgorithm	method,
+			const vector_double	&in_logWeights,
+			std::vector<size_t>			&out_indexes,
+			TResamplingAuxVars	&aux,
+			size_t          out_particle_count = 0
+			);
+
 		/** A static method to compute the linear, normalized (the sum the unity) weights from log-weights.
 		  * \sa performResampling
 		  */
@@ -232,6 +259,10 @@ namespace bayes
 		  */
 		mutable TFastDrawAuxVars	m_fastDrawAuxiliary;
 
+		/** Auxiliary buffers for resampling, see CParticleFilterCapable::performResampling
+		  */
+		mutable TResamplingAuxVars	m_resamplingAuxiliary;
+
 	}; // End of class def.
 
 	} // end namespace
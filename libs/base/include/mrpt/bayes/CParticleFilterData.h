@@ -92,71 +92,12 @@ namespace bayes
 			MRPT_END
 		}
 
-		/** Replaces the old particles by copies determined by the indexes in "indx", performing an efficient copy of the necesary particles only and allowing the number of particles to change.*/
+		/** Replaces the old particles by copies determined by the indexes in "indx", allowing the number of particles to change.
+		  *  This is done in place and without reallocating particles (see CParticleFilterData::substituteParticlesInPlace()), so the order of the resulting particles is unspecified. */
 		void  performSubstitution( const std::vector<size_t> &indx)
 		{
 			MRPT_START
-			particle_list_t                      parts;
-			typename particle_list_t::iterator   itDest,itSrc;
-			const size_t   M_old = derived().m_particles.size();
-			size_t         i,j,lastIndxOld = 0;
-			std::vector<bool>  oldParticlesReused(M_old,false);
-			std::vector<bool>::const_iterator  oldPartIt;
-			std::vector<size_t>           sorted_indx(indx);
-			std::vector<size_t>::iterator sort_idx_it;
-
-			/* Assure the input index is sorted: */
-			std::sort( sorted_indx.begin(), sorted_indx.end() );
-			/* Set the new size: */
-			parts.resize( sorted_indx.size() );
-			for (i=0,itDest=parts.begin();itDest!=parts.end();i++,itDest++)
-			{
-				const size_t sorted_idx = sorted_indx[i];
-				itDest->log_w = derived().m_particles[ sorted_idx ].log_w;
-				/* We can safely delete old m_particles from [lastIndxOld,indx[i]-1] (inclusive): */
-				for (j=lastIndxOld;j<sorted_idx;j++)
-				{
-					if (!oldParticlesReused[j])	/* If reused we can not delete that memory! */
-					{
-						delete derived().m_particles[j].d;
-						derived().m_particles[j].d = NULL;
-					}
-				}
-
-				/* For the next iteration:*/
-				lastIndxOld = sorted_idx;
-
-				/* If this is the first time that the old particle "indx[i]" appears, */
-				/*  we can reuse the old "data" instead of creating a new copy: */
-				if (!oldParticlesReused[sorted_idx])
-				{
-					/* Reuse the data from the particle: */
-					parts[i].d = derived().m_particles[ sorted_idx ].d;
-					oldParticlesReused[sorted_idx]=true;
-				}
-				else
-				{
-					/* Make a copy of the particle's data: */
-					ASSERT_( derived().m_particles[ sorted_idx ].d != NULL);
-					parts[i].d = new typename Derived::CParticleDataContent( *derived().m_particles[ sorted_idx ].d );
-				}
-			}
-			/* Free memory of unused particles */
-			for (itSrc=derived().m_particles.begin(),oldPartIt=oldParticlesReused.begin();itSrc!=derived().m_particles.end();itSrc++,oldPartIt++)
-				if (! *oldPartIt )
-				{
-					delete itSrc->d;
-					itSrc->d = NULL;
-				}
-			/* Copy the pointers only to the final destination */
-			derived().m_particles.resize( parts.size() );
-			for (itSrc=parts.begin(),itDest=derived().m_particles.begin(); itSrc!=parts.end(); itSrc++, itDest++ )
-			{
-				itDest->log_w = itSrc->log_w;
-				itDest->d = itSrc->d;
-				itSrc->d = NULL;
-			}
-			parts.clear();
+			Derived::substituteParticlesInPlace( derived().m_particles, indx, m_resamplingAuxiliary.subst_positions, m_resamplingAuxiliary.subst_counts );
 			MRPT_END
 		}
 
@@ -186,6 +127,90 @@ namespace bayes
 		CParticleFilterData() : m_particles(0)
 		{ }
 
+		/** Replaces, in place, the particles in "parts" by a new set of srcIdxs.size() particles, where the i'th new particle is a copy
+		  *  (data and weight) of the old particle srcIdxs[i].
+		  *  The first copy of each old particle just keeps its data object, while further copies overwrite (with T::operator=) the data
+		  *  objects of old particles which were not selected at all, so new objects are only allocated if the number of particles grows.
+		  *  The remaining not selected particles are freed. The surviving particles keep their relative order, and the rest of copies fill the gaps.
+		  * \param[out] out_positions The final index in "parts" of each new particle, i.e. the new particle "i" is parts[out_positions[i]].
+		  * \param aux Scratch buffer, which can be reused between calls to avoid memory reallocations.
+		  */
+		static void substituteParticlesInPlace(
+			CParticleList &parts,
+			const std::vector<size_t> &srcIdxs,
+			std::vector<size_t> &out_positions,
+			std::vector<size_t> &aux )
+		{
+			MRPT_START
+			const size_t M = parts.size(), N = srcIdxs.size();
+			const size_t CLAIMED = static_cast<size_t>(-1);
+
+			// aux[j]: # of times old particle "j" is selected, or CLAIMED once its data object has been taken by a new particle.
+			aux.assign(M,0);
+			for (size_t i=0;i<N;i++)
+			{
+				ASSERTDEB_(srcIdxs[i]<M)
+				aux[srcIdxs[i]]++;
+			}
+
+			out_positions.resize(N);
+			size_t nextFree = 0; // Lowest index which might hold a particle not selected at all
+			for (size_t i=0;i<N;i++)
+			{
+				const size_t s = srcIdxs[i];
+				if (aux[s]!=CLAIMED)
+				{	// 1st copy of "s": keep the particle as is
+					aux[s] = CLAIMED;
+					out_positions[i] = s;
+					continue;
+				}
+				// Further copies: overwrite a not selected particle, or create a new one if there are no more of them:
+				while (nextFree<M && aux[nextFree]!=0) nextFree++;
+				if (nextFree<M)
+				{
+					*parts[nextFree].d = *parts[s].d;
+					parts[nextFree].log_w = parts[s].log_w;
+					aux[nextFree] = CLAIMED;
+					out_positions[i] = nextFree;
+				}
+				else
+				{
+					parts.resize(parts.size()+1);
+					parts.back().d = new T(*parts[s].d);
+					parts.back().log_w = parts[s].log_w;
+					out_positions[i] = parts.size()-1;
+				}
+			}
+
+			// Free the particles not selected at all and compact the rest (nothing to do if all of them were reused, e.g. if some particle was appended above):
+			if (nextFree<M)
+			{
+				size_t nNew = 0;
+				for (size_t j=0;j<M;j++)
+				{
+					if (aux[j]==CLAIMED)
+					{
+						if (nNew!=j)
+						{
+							parts[nNew].d = parts[j].d;
+							parts[nNew].log_w = parts[j].log_w;
+							parts[j].d = NULL;
+						}
+						aux[j] = nNew++; // Now: the new position of old particle "j"
+					}
+					else
+					{
+						delete parts[j].d;
+						parts[j].d = NULL;
+					}
+				}
+				parts.resize(nNew);
+				for (size_t i=0;i<N;i++)
+					out_positions[i] = aux[out_positions[i]];
+			}
+			MRPT_END
+		}
+
         /** Free the memory of all the particles and reset the array "m_particles" to length zero.
           */
         void clearParticles()
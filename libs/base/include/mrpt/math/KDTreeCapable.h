@@ -14,6 +14,7 @@
 // nanoflann library:
 #include <mrpt/otherlibs/nanoflann/nanoflann.hpp>
 #include <mrpt/math/lightweight_geom_data.h>
+#include <mrpt/system/parallelization.h>
 
 namespace mrpt
 {
@@ -24,6 +25,17 @@ namespace mrpt
 		  *  @{ */
 
 
+		namespace detail
+		{
+			/** Gives the type of a nanoflann metric class "METRIC" for a different data set class "DATASET".
+			  *  Only defined for the metrics in nanoflann, which are the ones supported by the incremental build of KDTreeCapable. */
+			template <class METRIC, class DATASET> struct kdtree_rebind_metric;
+
+			template <class T, class DS, typename D, class DATASET> struct kdtree_rebind_metric<nanoflann::L1_Adaptor<T,DS,D>,DATASET>        { typedef nanoflann::L1_Adaptor<T,DATASET,D> type; };
+			template <class T, class DS, typename D, class DATASET> struct kdtree_rebind_metric<nanoflann::L2_Adaptor<T,DS,D>,DATASET>        { typedef nanoflann::L2_Adaptor<T,DATASET,D> type; };
+			template <class T, class DS, typename D, class DATASET> struct kdtree_rebind_metric<nanoflann::L2_Simple_Adaptor<T,DS,D>,DATASET> { typedef nanoflann::L2_Simple_Adaptor<T,DATASET,D> type; };
+		}
+
 		/** A generic adaptor class for providing Approximate Nearest Neighbors (ANN) (via the nanoflann library) to MRPT classses.
 		 *   This makes use of the CRTP design pattern.
 		 *
@@ -55,6 +67,11 @@ namespace mrpt
 		 *
 		 * The KD-tree index will be built on demand only upon call of any of the query methods provided by this class.
 		 *
+		 *  Derived classes which only append new points at the end of their data set can call "kdtree_mark_as_points_appended()"
+		 *  instead of "kdtree_mark_as_outdated()". Then, the next query only indexes the new points in a "logarithmic forest" of
+		 *  smaller KD-trees, and the whole index is only rebuilt each time the number of points doubles, which bounds both the
+		 *  (amortized) cost of insertions and the number of KD-trees to search. See TKDTreeSearchParams::incremental_build.
+		 *
 		 *  Notice that there is only ONE internal cached KD-tree, so if a method to query a 2D point is called,
 		 *  then another method for 3D points, then again the 2D method, three KD-trees will be built. So, try
 		 *  to group all the calls for a given dimensionality together or build different class instances for
@@ -86,12 +103,14 @@ namespace mrpt
 			{
 				TKDTreeSearchParams() :
 					nChecks(32),
-					leaf_max_size(10)
+					leaf_max_size(10),
+					incremental_build(true)
 				{
 				}
 
 				int nChecks; //!< The number of checks for ANN (default: 32) - corresponds to FLANN's SearchParams::check
 				size_t leaf_max_size; //!< Max points per leaf
+				bool incremental_build; //!< If true (default), points appended to the data set (see kdtree_mark_as_points_appended()) are indexed in additional KD-trees instead of rebuilding the whole index.
 			};
 
 			TKDTreeSearchParams  kdtree_search_params; //!< Parameters to tune the ANN searches
@@ -133,7 +152,7 @@ namespace mrpt
 
 				m_kdtree2d_data.query_point[0] = x0;
 				m_kdtree2d_data.query_point[1] = y0;
-		        m_kdtree2d_data.index->findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+		        m_kdtree2d_data.findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				// Copy output to user vars:
 				out_x = derived().kdtree_get_pt(ret_index,0);
@@ -160,7 +179,7 @@ namespace mrpt
 
 				m_kdtree2d_data.query_point[0] = x0;
 				m_kdtree2d_data.query_point[1] = y0;
-		        m_kdtree2d_data.index->findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+		        m_kdtree2d_data.findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				return ret_index;
 				MRPT_END
@@ -229,7 +248,7 @@ namespace mrpt
 
 				m_kdtree2d_data.query_point[0] = x0;
 				m_kdtree2d_data.query_point[1] = y0;
-		        m_kdtree2d_data.index->findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+		        m_kdtree2d_data.findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				// Copy output to user vars:
 				out_x1 = derived().kdtree_get_pt(ret_indexes[0],0);
@@ -293,7 +312,7 @@ namespace mrpt
 
 				m_kdtree2d_data.query_point[0] = x0;
 				m_kdtree2d_data.query_point[1] = y0;
-		        m_kdtree2d_data.index->findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+		        m_kdtree2d_data.findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				for (size_t i=0;i<knn;i++)
 				{
@@ -347,7 +366,7 @@ namespace mrpt
 
 				m_kdtree2d_data.query_point[0] = x0;
 				m_kdtree2d_data.query_point[1] = y0;
-		        m_kdtree2d_data.index->findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+		        m_kdtree2d_data.findNeighbors(resultSet, &m_kdtree2d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 				MRPT_END
 			}
 
@@ -394,7 +413,7 @@ namespace mrpt
 				m_kdtree3d_data.query_point[0] = x0;
 				m_kdtree3d_data.query_point[1] = y0;
 				m_kdtree3d_data.query_point[2] = z0;
-		        m_kdtree3d_data.index->findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+		        m_kdtree3d_data.findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				// Copy output to user vars:
 				out_x = derived().kdtree_get_pt(ret_index,0);
@@ -425,7 +444,7 @@ namespace mrpt
 				m_kdtree3d_data.query_point[0] = x0;
 				m_kdtree3d_data.query_point[1] = y0;
 				m_kdtree3d_data.query_point[2] = z0;
-		        m_kdtree3d_data.index->findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+		        m_kdtree3d_data.findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				return ret_index;
 				MRPT_END
@@ -484,7 +503,7 @@ namespace mrpt
 				m_kdtree3d_data.query_point[0] = x0;
 				m_kdtree3d_data.query_point[1] = y0;
 				m_kdtree3d_data.query_point[2] = z0;
-				m_kdtree3d_data.index->findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+				m_kdtree3d_data.findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				for (size_t i=0;i<knn;i++)
 				{
@@ -540,7 +559,7 @@ namespace mrpt
 				m_kdtree3d_data.query_point[0] = x0;
 				m_kdtree3d_data.query_point[1] = y0;
 				m_kdtree3d_data.query_point[2] = z0;
-				m_kdtree3d_data.index->findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+				m_kdtree3d_data.findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 
 				for (size_t i=0;i<knn;i++)
 				{
@@ -588,7 +607,7 @@ namespace mrpt
 				if ( m_kdtree3d_data.m_num_points!=0 )
 				{
 					const float xyz[3] = {x0,y0,z0};
-					m_kdtree3d_data.index->radiusSearch(&xyz[0], maxRadius, out_indices_dist, nanoflann::SearchParams(kdtree_search_params.nChecks) );
+					m_kdtree3d_data.radiusSearch(&xyz[0], maxRadius, out_indices_dist, nanoflann::SearchParams(kdtree_search_params.nChecks) );
 				}
 				return out_indices_dist.size();
 				MRPT_END
@@ -619,7 +638,7 @@ namespace mrpt
 				if ( m_kdtree2d_data.m_num_points!=0 )
 				{
 					const float xyz[2] = {x0,y0};
-					m_kdtree2d_data.index->radiusSearch(&xyz[0], maxRadius, out_indices_dist, nanoflann::SearchParams(kdtree_search_params.nChecks) );
+					m_kdtree2d_data.radiusSearch(&xyz[0], maxRadius, out_indices_dist, nanoflann::SearchParams(kdtree_search_params.nChecks) );
 				}
 				return out_indices_dist.size();
 				MRPT_END
@@ -660,7 +679,7 @@ namespace mrpt
 				m_kdtree3d_data.query_point[0] = x0;
 				m_kdtree3d_data.query_point[1] = y0;
 				m_kdtree3d_data.query_point[2] = z0;
-				m_kdtree3d_data.index->findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
+				m_kdtree3d_data.findNeighbors(resultSet, &m_kdtree3d_data.query_point[0], nanoflann::SearchParams(kdtree_search_params.nChecks));
 				MRPT_END
 			}
 
@@ -670,20 +689,237 @@ namespace mrpt
 
 			/* @} */
 
+			/** @name Batch queries
+			  *  These methods search the neighbors of a whole set of query points at once, distributing the queries among threads
+			  *  with mrpt::system::parallel_for(). The KD-tree is (re)built if needed before starting, from the calling thread.
+			  *  Output vectors are resized to fit the results, hence passing the same vectors in successive calls avoids reallocations.
+			  *  The derived class data accessors (kdtree_get_pt(), kdtree_distance(),...) must be safe to be called concurrently, which is
+			  *  the case of any class which just reads its own data.
+				@{ */
+
+			/** KD Tree-based search for the closest point to each of N given 2D points.
+			  * \param xs The X coordinates of the N queries.
+			  * \param ys The Y coordinates of the N queries.
+			  * \param N  The number of queries.
+			  * \param out_idx Output with N indexes: the closest point for each query.
+			  * \param out_dist_sqr Output with N square distances between each query and its closest point.
+			  * \exception std::exception If there are no points in the KD-tree and N>0.
+			  *  \sa kdTreeClosestPoint2D, kdTreeClosestPoint3DBatch, kdTreeNClosestPoint2DIdxBatch
+			  */
+			inline void kdTreeClosestPoint2DBatch(
+				const float *xs, const float *ys, const size_t N,
+				std::vector<size_t> &out_idx,
+				std::vector<float>  &out_dist_sqr ) const
+			{
+				kdTreeNClosestPoint2DIdxBatch(xs,ys,N,1,out_idx,out_dist_sqr);
+			}
+
+			/** KD Tree-based search for the closest point to each of N given 3D points.
+			  * \param xs The X coordinates of the N queries.
+			  * \param ys The Y coordinates of the N queries.
+			  * \param zs The Z coordinates of the N queries.
+			  * \param N  The number of queries.
+			  * \param out_idx Output with N indexes: the closest point for each query.
+			  * \param out_dist_sqr Output with N square distances between each query and its closest point.
+			  * \exception std::exception If there are no points in the KD-tree and N>0.
+			  *  \sa kdTreeClosestPoint3D, kdTreeClosestPoint2DBatch, kdTreeNClosestPoint3DIdxBatch
+			  */
+			inline void kdTreeClosestPoint3DBatch(
+				const float *xs, const float *ys, const float *zs, const size_t N,
+				std::vector<size_t> &out_idx,
+				std::vector<float>  &out_dist_sqr ) const
+			{
+				kdTreeNClosestPoint3DIdxBatch(xs,ys,zs,N,1,out_idx,out_dist_sqr);
+			}
+
+			/** KD Tree-based search for the "knn" closest points to each of N given 2D points.
+			  *  The results of the i'th query are stored at out_idx[i*knn+j], out_dist_sqr[i*knn+j], for j=0,...,knn-1, sorted by ascending distances.
+			  *  If there are less than "knn" points in the KD-tree, the extra entries are left with undefined indexes.
+			  * \exception std::exception If there are no points in the KD-tree and N>0.
+			  *  \sa kdTreeNClosestPoint2DIdx, kdTreeNClosestPoint3DIdxBatch
+			  */
+			void kdTreeNClosestPoint2DIdxBatch(
+				const float *xs, const float *ys, const size_t N,
+				const size_t knn,
+				std::vector<size_t> &out_idx,
+				std::vector<float>  &out_dist_sqr ) const
+			{
+				MRPT_START
+				out_idx.resize(N*knn);
+				out_dist_sqr.resize(N*knn);
+				if (!N || !knn) return;
+				rebuild_kdTree_2D(); // First: Create the 2D KD-Tree if required
+				if ( !m_kdtree2d_data.m_num_points ) THROW_EXCEPTION("There are no points in the KD-tree.")
+
+				const float *coords[3] = { xs, ys, NULL };
+				const TBatchKNNSearch<TKDTreeDataHolder<2> > body(&m_kdtree2d_data,coords,2,knn,&out_idx[0],&out_dist_sqr[0],kdtree_search_params.nChecks);
+				mrpt::system::parallel_for( mrpt::system::BlockedRange(0,static_cast<int>(N),KDTREE_BATCH_GRAIN), body );
+				MRPT_END
+			}
+
+			/** KD Tree-based search for the "knn" closest points to each of N given 3D points.
+			  *  The results of the i'th query are stored at out_idx[i*knn+j], out_dist_sqr[i*knn+j], for j=0,...,knn-1, sorted by ascending distances.
+			  *  If there are less than "knn" points in the KD-tree, the extra entries are left with undefined indexes.
+			  * \exception std::exception If there are no points in the KD-tree and N>0.
+			  *  \sa kdTreeNClosestPoint3DIdx, kdTreeNClosestPoint2DIdxBatch
+			  */
+			void kdTreeNClosestPoint3DIdxBatch(
+				const float *xs, const float *ys, const float *zs, const size_t N,
+				const size_t knn,
+				std::vector<size_t> &out_idx,
+				std::vector<float>  &out_dist_sqr ) const
+			{
+				MRPT_START
+				out_idx.resize(N*knn);
+				out_dist_sqr.resize(N*knn);
+				if (!N || !knn) return;
+				rebuild_kdTree_3D(); // First: Create the 3D KD-Tree if required
+				if ( !m_kdtree3d_data.m_num_points ) THROW_EXCEPTION("There are no points in the KD-tree.")
+
+				const float *coords[3] = { xs, ys, zs };
+				const TBatchKNNSearch<TKDTreeDataHolder<3> > body(&m_kdtree3d_data,coords,3,knn,&out_idx[0],&out_dist_sqr[0],kdtree_search_params.nChecks);
+				mrpt::system::parallel_for( mrpt::system::BlockedRange(0,static_cast<int>(N),KDTREE_BATCH_GRAIN), body );
+				MRPT_END
+			}
+
+			/** KD Tree-based search for all the points within a given radius of each of N given 2D points.
+			  *  The output vector is resized to N entries, and the previous contents of each of them are cleared (but its memory is kept for reuse).
+			  * \param maxRadius The search radius, with the same meaning than in kdTreeRadiusSearch2D().
+			  * \param out_indices_dist For each query, the list of pairs of indices/squared distances of the points found.
+			  * \return The total number of found points.
+			  *  \sa kdTreeRadiusSearch2D, kdTreeRadiusSearch3DBatch
+			  */
+			size_t kdTreeRadiusSearch2DBatch(
+				const float *xs, const float *ys, const size_t N,
+				const float maxRadius,
+				std::vector< std::vector<std::pair<size_t,float> > > &out_indices_dist ) const
+			{
+				MRPT_START
+				out_indices_dist.resize(N);
+				if (!N) return 0;
+				rebuild_kdTree_2D(); // First: Create the 2D KD-Tree if required
+				if ( !m_kdtree2d_data.m_num_points )
+				{
+					for (size_t i=0;i<N;i++) out_indices_dist[i].clear();
+					return 0;
+				}
+				const float *coords[3] = { xs, ys, NULL };
+				const TBatchRadiusSearch<TKDTreeDataHolder<2> > body(&m_kdtree2d_data,coords,2,maxRadius,&out_indices_dist[0],kdtree_search_params.nChecks);
+				mrpt::system::parallel_for( mrpt::system::BlockedRange(0,static_cast<int>(N),KDTREE_BATCH_GRAIN), body );
+
+				size_t nFound = 0;
+				for (size_t i=0;i<N;i++) nFound+=out_indices_dist[i].size();
+				return nFound;
+				MRPT_END
+			}
+
+			/** KD Tree-based search for all the points within a given radius of each of N given 3D points.
+			  *  The output vector is resized to N entries, and the previous contents of each of them are cleared (but its memory is kept for reuse).
+			  * \param maxRadius The search radius, with the same meaning than in kdTreeRadiusSearch3D().
+			  * \param out_indices_dist For each query, the list of pairs of indices/squared distances of the points found.
+			  * \return The total number of found points.
+			  *  \sa kdTreeRadiusSearch3D, kdTreeRadiusSearch2DBatch
+			  */
+			size_t kdTreeRadiusSearch3DBatch(
+				const float *xs, const float *ys, const float *zs, const size_t N,
+				const float maxRadius,
+				std::vector< std::vector<std::pair<size_t,float> > > &out_indices_dist ) const
+			{
+				MRPT_START
+				out_indices_dist.resize(N);
+				if (!N) return 0;
+				rebuild_kdTree_3D(); // First: Create the 3D KD-Tree if required
+				if ( !m_kdtree3d_data.m_num_points )
+				{
+					for (size_t i=0;i<N;i++) out_indices_dist[i].clear();
+					return 0;
+				}
+				const float *coords[3] = { xs, ys, zs };
+				const TBatchRadiusSearch<TKDTreeDataHolder<3> > body(&m_kdtree3d_data,coords,3,maxRadius,&out_indices_dist[0],kdtree_search_params.nChecks);
+				mrpt::system::parallel_for( mrpt::system::BlockedRange(0,static_cast<int>(N),KDTREE_BATCH_GRAIN), body );
+
+				size_t nFound = 0;
+				for (size_t i=0;i<N;i++) nFound+=out_indices_dist[i].size();
+				return nFound;
+				MRPT_END
+			}
+
+			/* @} */
+
 		protected:
 			/** To be called by child classes when KD tree data changes. */
 			inline void kdtree_mark_as_outdated() const { m_kdtree_is_uptodate = false; }
 
+			/** To be called by child classes instead of kdtree_mark_as_outdated() when new points have been appended at the end
+			  *  of the data set while all the previous points remain unchanged.
+			  *  If TKDTreeSearchParams::incremental_build is enabled, the next query will only index the new points in small
+			  *  additional KD-trees, instead of rebuilding the whole index. Otherwise, this is equivalent to kdtree_mark_as_outdated().
+			  */
+			inline void kdtree_mark_as_points_appended() const { if (!kdtree_search_params.incremental_build) m_kdtree_is_uptodate = false; }
+
 		private:
+			/** Exposes a contiguous range of the points of the derived class as a dataset, so it can be indexed by a separate KD-tree */
+			struct TSubsetAdaptor
+			{
+				typedef typename metric_t::DistanceType distance_t;
+
+				const Derived *data;
+				size_t         offset;  //!< Index of the first point of the range in the derived class
+				size_t         count;   //!< Number of points in the range
+
+				TSubsetAdaptor(const Derived *_data, size_t _offset, size_t _count) : data(_data), offset(_offset), count(_count) { }
+
+				inline size_t kdtree_get_point_count() const { return count; }
+				inline num_t kdtree_get_pt(const size_t idx, int dim) const { return data->kdtree_get_pt(offset+idx,dim); }
+				inline distance_t kdtree_distance(const num_t *p1, const size_t idx_p2, size_t size) const { return data->kdtree_distance(p1,offset+idx_p2,size); }
+				template <class BBOX> bool kdtree_get_bbox(BBOX &) const { return false; }
+			};
+
+			/** A nanoflann result set adaptor which translates the indices found in a subset KD-tree into indices of the whole data set */
+			template <class RESULTSET>
+			struct TOffsetResultSet
+			{
+				typedef typename metric_t::DistanceType distance_t;
+
+				RESULTSET &rs;
+				size_t     offset;
+
+				TOffsetResultSet(RESULTSET &_rs, size_t _offset) : rs(_rs), offset(_offset) { }
+
+				inline void addPoint(distance_t dist, size_t index) { rs.addPoint(dist,index+offset); }
+				inline distance_t worstDist() const { return rs.worstDist(); }
+			};
+
+			/** A KD-tree for the points appended at the end of the data set after the main KD-tree was built (see kdtree_mark_as_points_appended()) */
+			template <int _DIM>
+			struct TKDTreeSubtree
+			{
+				typedef typename detail::kdtree_rebind_metric<metric_t,TSubsetAdaptor>::type  subset_metric_t;
+				typedef nanoflann::KDTreeSingleIndexAdaptor<subset_metric_t,TSubsetAdaptor,_DIM> subtree_index_t;
+
+				TSubsetAdaptor    data;
+				subtree_index_t   index; // Must be declared after "data", since it keeps a reference to it.
+
+				TKDTreeSubtree(const Derived *_data, size_t offset, size_t count, size_t dim, size_t leaf_max_size) :
+					data(_data,offset,count),
+					index(dim, data, nanoflann::KDTreeSingleIndexAdaptorParams(leaf_max_size, dim) )
+				{
+					index.buildIndex();
+				}
+			private:
+				TKDTreeSubtree(const TKDTreeSubtree &);                 // Not copyable, since index points to data
+				TKDTreeSubtree & operator =(const TKDTreeSubtree &);
+			};
+
 			/** Internal structure with the KD-tree representation (mainly used to avoid copying pointers with the = operator) */
 			template <int _DIM = -1>
 			struct TKDTreeDataHolder
 			{
 				/** Init the pointer to NULL. */
-				inline TKDTreeDataHolder() : index(NULL),m_dim(_DIM), m_num_points(0) { }
+				inline TKDTreeDataHolder() : index(NULL),m_dim(_DIM), m_num_points(0), m_num_points_main(0) { }
 
 				/** Copy constructor: It actually does NOT copy the kd-tree, a new object will be created if required!   */
-				inline TKDTreeDataHolder(const TKDTreeDataHolder &o)  : index(NULL),m_dim(_DIM), m_num_points(0) { }
+				inline TKDTreeDataHolder(const TKDTreeDataHolder &o)  : index(NULL),m_dim(_DIM), m_num_points(0), m_num_points_main(0) { }
 
 				/** Copy operator: It actually does NOT copy the kd-tree, a new object will be created if required!  */
 				inline TKDTreeDataHolder& operator =(const TKDTreeDataHolder &o) {
@@ -695,15 +931,111 @@ namespace mrpt
 				inline ~TKDTreeDataHolder() { clear(); }
 
 				/** Free memory (if allocated)  */
-				inline void clear()	{ mrpt::utils::delete_safe( index ); }
+				inline void clear()
+				{
+					mrpt::utils::delete_safe( index );
+					for (size_t i=0;i<subtrees.size();i++) delete subtrees[i];
+					subtrees.clear();
+				}
+
+				/** Runs a nanoflann search on the main KD-tree and on all the subtrees of appended points. Results are indices of the whole data set. */
+				template <class RESULTSET>
+				void findNeighbors(RESULTSET &resultSet, const num_t *query, const nanoflann::SearchParams &params) const
+				{
+					index->findNeighbors(resultSet, query, params);
+					for (size_t i=0;i<subtrees.size();i++)
+					{
+						TOffsetResultSet<RESULTSET> rs(resultSet, subtrees[i]->data.offset);
+						subtrees[i]->index.findNeighbors(rs, query, params);
+					}
+				}
+
+				/** Like nanoflann's KDTreeSingleIndexAdaptor::radiusSearch(), but also searching in the subtrees of appended points. */
+				size_t radiusSearch(const num_t *query, const num_t radius, std::vector<std::pair<size_t,typename metric_t::DistanceType> > &indices_dists, const nanoflann::SearchParams &params) const
+				{
+					if (subtrees.empty())
+						return index->radiusSearch(query, radius, indices_dists, params);
+
+					nanoflann::RadiusResultSet<typename metric_t::DistanceType,size_t> resultSet(radius,indices_dists);
+					findNeighbors(resultSet, query, params);
+					if (params.sorted)
+						std::sort(indices_dists.begin(),indices_dists.end(), nanoflann::IndexDist_Sorter() );
+					return indices_dists.size();
+				}
 
 				typedef nanoflann::KDTreeSingleIndexAdaptor<metric_t,Derived, _DIM> kdtree_index_t;
 
 				kdtree_index_t *index;  //!< NULL or the up-to-date index
 
+				std::vector<TKDTreeSubtree<_DIM>*> subtrees; //!< KD-trees of points appended after building "index", in decreasing order of size
+
 				std::vector<num_t> query_point;
 				size_t           m_dim;         //!< Dimensionality. typ: 2,3
-				size_t           m_num_points;
+				size_t           m_num_points;  //!< Number of points in "index" and "subtrees"
+				size_t           m_num_points_main; //!< Number of points in "index"
+			};
+
+			/** Minimum number of queries to be processed by each thread in the batch query methods */
+			enum { KDTREE_BATCH_GRAIN = 256 };
+
+			/** Body of the parallel_for() in the batch k-NN searches */
+			template <class HOLDER>
+			struct TBatchKNNSearch
+			{
+				const HOLDER *tree;
+				const float  *coords[3];
+				size_t        dim, knn;
+				size_t       *out_idx;
+				float        *out_dist_sqr;
+				int           nChecks;
+
+				TBatchKNNSearch(const HOLDER *_tree, const float * const _coords[3], size_t _dim, size_t _knn, size_t *_out_idx, float *_out_dist_sqr, int _nChecks) :
+					tree(_tree), dim(_dim), knn(_knn), out_idx(_out_idx), out_dist_sqr(_out_dist_sqr), nChecks(_nChecks)
+				{
+					for (int d=0;d<3;d++) coords[d]=_coords[d];
+				}
+
+				void operator()(const mrpt::system::BlockedRange &r) const
+				{
+					num_t query[3];
+					const nanoflann::SearchParams params(nChecks);
+					for (int i=r.begin();i<r.end();i++)
+					{
+						for (size_t d=0;d<dim;d++) query[d]=coords[d][i];
+						nanoflann::KNNResultSet<num_t> resultSet(knn);
+						resultSet.init(out_idx+i*knn, out_dist_sqr+i*knn);
+						tree->findNeighbors(resultSet, &query[0], params);
+					}
+				}
+			};
+
+			/** Body of the parallel_for() in the batch radius searches */
+			template <class HOLDER>
+			struct TBatchRadiusSearch
+			{
+				const HOLDER *tree;
+				const float  *coords[3];
+				size_t        dim;
+				float         maxRadius;
+				std::vector<std::pair<size_t,float> > *out_indices_dist;
+				int           nChecks;
+
+				TBatchRadiusSearch(const HOLDER *_tree, const float * const _coords[3], size_t _dim, float _maxRadius, std::vector<std::pair<size_t,float> > *_out_indices_dist, int _nChecks) :
+					tree(_tree), dim(_dim), maxRadius(_maxRadius), out_indices_dist(_out_indices_dist), nChecks(_nChecks)
+				{
+					for (int d=0;d<3;d++) coords[d]=_coords[d];
+				}
+
+				void operator()(const mrpt::system::BlockedRange &r) const
+				{
+					num_t query[3];
+					const nanoflann::SearchParams params(nChecks);
+					for (int i=r.begin();i<r.end();i++)
+					{
+						for (size_t d=0;d<dim;d++) query[d]=coords[d][i];
+						tree->radiusSearch(&query[0], maxRadius, out_indices_dist[i], params);
+					}
+				}
 			};
 
 			mutable TKDTreeDataHolder<2>  m_kdtree2d_data;
@@ -711,12 +1043,38 @@ namespace mrpt
 			mutable TKDTreeDataHolder<>   m_kdtreeNd_data;
 			mutable bool                  m_kdtree_is_uptodate; //!< whether the KD tree needs to be rebuilt or not.
 
+			/** Indexes the points appended to the data set since the KD-tree "h" was built, if any, as a "logarithmic forest":
+			  *  the new points are indexed in a new subtree, after merging it with all the previous subtrees which are not larger than it,
+			  *  so there are at most O(log N) subtrees and each point is re-indexed at most O(log N) times.
+			  * \return false if the KD-tree must be rebuilt from scratch instead (e.g. points were removed, or the subtrees would hold more points than the main tree).
+			  */
+			template <int _DIM>
+			bool update_kdTree_incremental(TKDTreeDataHolder<_DIM> &h) const
+			{
+				const size_t N = derived().kdtree_get_point_count();
+				if (N==h.m_num_points) return true; // Nothing new.
+				if (!kdtree_search_params.incremental_build || N<h.m_num_points || N-h.m_num_points_main>h.m_num_points_main)
+					return false;
+
+				size_t first = h.m_num_points;
+				while (!h.subtrees.empty() && h.subtrees.back()->data.count<=N-first)
+				{
+					first = h.subtrees.back()->data.offset;
+					delete h.subtrees.back();
+					h.subtrees.pop_back();
+				}
+				h.subtrees.push_back( new TKDTreeSubtree<_DIM>(&derived(), first, N-first, h.m_dim, kdtree_search_params.leaf_max_size) );
+				h.m_num_points = N;
+				return true;
+			}
+
 			/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ... asking the child class for the data points.
 			void rebuild_kdTree_2D() const
 			{
 				typedef typename TKDTreeDataHolder<2>::kdtree_index_t  tree2d_t;
 
 				if (!m_kdtree_is_uptodate) { m_kdtree2d_data.clear(); m_kdtree3d_data.clear(); m_kdtreeNd_data.clear(); }
+				else if (m_kdtree2d_data.index && !update_kdTree_incremental(m_kdtree2d_data)) m_kdtree2d_data.clear();
 
 				if (!m_kdtree2d_data.index)
 				{
@@ -725,6 +1083,7 @@ namespace mrpt
 					// And build new index:
 					const size_t N = derived().kdtree_get_point_count();
 					m_kdtree2d_data.m_num_points = N;
+					m_kdtree2d_data.m_num_points_main = N;
 					m_kdtree2d_data.m_dim        = 2;
 					m_kdtree2d_data.query_point.resize(2);
 					if (N)
@@ -742,6 +1101,7 @@ namespace mrpt
 				typedef typename TKDTreeDataHolder<3>::kdtree_index_t  tree3d_t;
 
 				if (!m_kdtree_is_uptodate) { m_kdtree2d_data.clear(); m_kdtree3d_data.clear(); m_kdtreeNd_data.clear(); }
+				else if (m_kdtree3d_data.index && !update_kdTree_incremental(m_kdtree3d_data)) m_kdtree3d_data.clear();
 
 				if (!m_kdtree3d_data.index)
 				{
@@ -750,6 +1110,7 @@ namespace mrpt
 					// And build new index:
 					const size_t N = derived().kdtree_get_point_count();
 					m_kdtree3d_data.m_num_points = N;
+					m_kdtree3d_data.m_num_points_main = N;
 					m_kdtree3d_data.m_dim        = 3;
 					m_kdtree3d_data.query_point.resize(3);
 					if (N)
@@ -767,6 +1128,7 @@ namespace mrpt
 				typedef typename TKDTreeDataHolder<>::kdtree_index_t   treeNd_t;
 
 				if (!m_kdtree_is_uptodate) { m_kdtree2d_data.clear(); m_kdtree3d_data.clear(); m_kdtreeNd_data.clear(); }
+				else if (m_kdtreeNd_data.index && m_kdtreeNd_data.m_num_points!=derived().kdtree_get_point_count()) m_kdtreeNd_data.clear(); // No incremental update for N-d trees
 
 				if (!m_kdtreeNd_data.index || m_kdtreeNd_data.m_dim!=nDims )
 				{
@@ -775,6 +1137,7 @@ namespace mrpt
 					// And build new index:
 					const size_t N = derived().kdtree_get_point_count();
 					m_kdtreeNd_data.m_num_points = N;
+					m_kdtreeNd_data.m_num_points_main = N;
 					m_kdtreeNd_data.m_dim        = nDims;
 					m_kdtreeNd_data.query_point.resize(nDims);
 					if (N)
@@ -785,7 +1148,6 @@ namespace mrpt
 					m_kdtree_is_uptodate = true;
 				}
 			} // end of rebuild_kdTree
-
 		};  // end of KDTreeCapable
 
 		/**  @} */  // end of grouping
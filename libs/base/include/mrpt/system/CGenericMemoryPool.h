@@ -27,7 +27,7 @@ namespace mrpt
 		  *
 		  *    bool POOLABLE_DATA::isSuitable(const POOLABLE_DATA & req) const { ... }
 		  *
-		  *   For an example of how to handle a memory pool, see the class mrpt::slam::CObservation3DRangeScan
+		  *   For an example of how to handle a memory pool, see the class mrpt::slam::CObservation3DRangeScan, or CVectorMemoryPool for pools of std::vector buffers.
 		  *
 		  *  \tparam POOLABLE_DATA A struct with user-defined objects which actually contain the memory blocks (e.g. one or more std::vector).
 		  *  \tparam DATA_PARAMS A struct with user information about each memory block (e.g. size of a std::vector)
@@ -41,9 +41,10 @@ namespace mrpt
 			TList                          m_pool;
 			mrpt::synch::CCriticalSection  m_pool_cs;
 			size_t                         m_maxPoolEntries;
+			size_t                         m_nRequests, m_nHits; //!< Statistics
 			bool                           & m_was_destroyed;  //!< With this trick we get rid of the "global destruction order fiasco" ;-)
 
-			CGenericMemoryPool(const size_t max_pool_entries, bool &was_destroyed ) : m_maxPoolEntries(max_pool_entries), m_was_destroyed(was_destroyed)
+			CGenericMemoryPool(const size_t max_pool_entries, bool &was_destroyed ) : m_maxPoolEntries(max_pool_entries), m_nRequests(0), m_nHits(0), m_was_destroyed(was_destroyed)
 			{
 				m_was_destroyed = false;
 			}
@@ -69,15 +70,14 @@ namespace mrpt
 			  */
 			POOLABLE_DATA * request_memory(const DATA_PARAMS &params)
 			{
-				// A quick check first:
-				if (m_pool.empty()) return NULL;
-
 				mrpt::synch::CCriticalSectionLocker lock( &m_pool_cs );
+				m_nRequests++;
 				for (typename TList::iterator it=m_pool.begin();it!=m_pool.end();++it) {
 					if (it->first.isSuitable(params))
 					{
 						POOLABLE_DATA * ret = it->second;
 						m_pool.erase(it);
+						m_nHits++;
 						return ret;
 					}
 				}
@@ -101,6 +101,30 @@ namespace mrpt
 				m_pool.push_back( typename TList::value_type(params,block) );
 			}
 
+			/** Frees all the memory blocks in the pool */
+			void clear()
+			{
+				mrpt::synch::CCriticalSectionLocker lock( &m_pool_cs );
+				for (typename TList::iterator it=m_pool.begin();it!=m_pool.end();++it)
+					delete it->second;
+				m_pool.clear();
+			}
+
+			/** Returns the number of memory blocks currently in the pool */
+			size_t size()
+			{
+				mrpt::synch::CCriticalSectionLocker lock( &m_pool_cs );
+				return m_pool.size();
+			}
+
+			/** Returns the number of calls to request_memory() so far, and how many of them returned a block from the pool */
+			void getStatistics(size_t &nRequests, size_t &nHits)
+			{
+				mrpt::synch::CCriticalSectionLocker lock( &m_pool_cs );
+				nRequests = m_nRequests;
+				nHits = m_nHits;
+			}
+
 			~CGenericMemoryPool()
 			{
 				m_was_destroyed = true;
@@ -112,6 +136,84 @@ namespace mrpt
 			}
 		};
 
+		/** A thread-safe pool of buffers of type VECTOR (std::vector or any other container with capacity(), resize() and swap()), built upon CGenericMemoryPool,
+		  *  to recycle the memory of objects which are created and destroyed at a high rate, as the observations grabbed by sensors or read from rawlogs.
+		  *
+		  *  There is one pool for each VECTOR type. Objects must donate their buffers to the pool when destroyed, and resize them with resize() instead of VECTOR::resize():
+		  *  \code
+		  *    MyClass::~MyClass() {
+		  *      CVectorMemoryPool<std::vector<float> >::donate(m_data);
+		  *    }
+		  *    void MyClass::setDataSize(size_t N) {
+		  *      CVectorMemoryPool<std::vector<float> >::resize(m_data,N);  // Instead of m_data.resize(N)
+		  *    }
+		  *  \endcode
+		  *
+		  *  A buffer in the pool is only given to requests of at least half its capacity, so large buffers are not wasted on small requests.
+		  *  For an example of usage, see mrpt::slam::CObservation2DRangeScan::resizeScan()
+		  * \ingroup mrpt_memory
+		  */
+		template <class VECTOR>
+		class CVectorMemoryPool
+		{
+		public:
+			struct TParams
+			{
+				size_t capacity;
+				inline bool isSuitable(const TParams &req) const {
+					return capacity>=req.capacity && capacity<=2*req.capacity;
+				}
+			};
+			struct TData
+			{
+				VECTOR buf;
+			};
+			typedef CGenericMemoryPool<TParams,TData> pool_t;
+
+			/** The underlying memory pool (to change its size, get its statistics, etc.), or NULL if it was already destroyed (at the end of the program) */
+			static inline pool_t * getPool() { return pool_t::getInstance(16); }
+
+			/** Resizes "v" to "N" elements, exactly as v.resize(N), but if "v" is empty and has not enough capacity, a buffer is taken from the pool instead of allocating a new one.
+			  */
+			static void resize(VECTOR &v, const size_t N)
+			{
+				if (v.empty() && N>v.capacity())
+				{
+					pool_t *pool = getPool();
+					if (pool)
+					{
+						TParams params;
+						params.capacity = N;
+						TData *block = pool->request_memory(params);
+						if (block)
+						{
+							block->buf.swap(v);
+							v.clear();
+							donate(block->buf);
+							delete block;
+						}
+					}
+				}
+				v.resize(N);
+			}
+
+			/** Gives the buffer of "v" to the pool, leaving "v" empty. Empty buffers are just ignored. */
+			static void donate(VECTOR &v)
+			{
+				if (!v.capacity())
+					return;
+				pool_t *pool = getPool();
+				if (!pool)
+					return;
+
+				TParams params;
+				params.capacity = v.capacity();
+				TData *block = new TData();
+				block->buf.swap(v);
+				pool->dump_to_pool(params,block);
+			}
+		};
+
 	} // End of namespace
 } // End of namespace
 
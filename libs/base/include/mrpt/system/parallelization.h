@@ -10,6 +10,7 @@
 #define  __MRPT_PARALLELIZATION_H
 
 #include <mrpt/config.h>
+#include <mrpt/base/link_pragmas.h>  // DLL import/export definitions
 
 // This file declares helper structs for usage with TBB
 //  Refer to http://threadingbuildingblocks.org/
@@ -29,11 +30,20 @@
 #endif
 
 
-// Define a common interface so if we don't have TBB it falls back to a good-old for loop:
+// Define a common interface so if we don't have TBB it falls back to our own pool of worker threads:
 namespace mrpt
 {
 	namespace system
 	{
+		/** Sets the number of threads to be used by mrpt::system::parallel_for() (including the calling thread).
+		  *  By default, it's the number of processors in the system (see mrpt::system::getNumberOfProcessors). Set to 1 to disable parallelization.
+		  *  \note This has no effect when MRPT is built against Intel TBB.
+		  */
+		void BASE_IMPEXP setParallelizationThreadsCount(unsigned int nThreads);
+
+		/** Returns the number of threads used by mrpt::system::parallel_for() \sa setParallelizationThreadsCount */
+		unsigned int BASE_IMPEXP getParallelizationThreadsCount();
+
 #if MRPT_HAS_TBB
         typedef tbb::blocked_range<int> BlockedRange;
 
@@ -59,7 +69,7 @@ namespace mrpt
 
         //typedef tbb::concurrent_vector<Rect> ConcurrentRectVector;
 #else
-		// Emulate TBB-like classes which fall back to an old "for"
+		// Emulate TBB-like classes which fall back to a pool of worker threads (or an old "for")
         class BlockedRange
         {
         public:
@@ -72,12 +82,36 @@ namespace mrpt
             int _begin, _end, _grainsize;
         };
 
+		namespace detail
+		{
+			/** Type-erased interface to the body of a parallel_for(), so the worker threads pool can live in a .cpp file */
+			struct BASE_IMPEXP TParallelForBodyBase
+			{
+				virtual ~TParallelForBodyBase() {}
+				virtual void run(const BlockedRange &r) const = 0;
+			};
+
+			template <typename Body>
+			struct TParallelForBody : public TParallelForBodyBase
+			{
+				const Body &m_body;
+				TParallelForBody(const Body &body) : m_body(body) {}
+				virtual void run(const BlockedRange &r) const { m_body(r); }
+			};
+
+			/** Splits the range into chunks of at least "grainsize" items and runs them in the worker threads pool.
+			  *  Falls back to a single call in the calling thread if there is only one thread or if the pool is already busy (e.g. nested calls). */
+			void BASE_IMPEXP parallel_for_impl( const BlockedRange& range, const TParallelForBodyBase &body );
+		}
+
+        /** Runs body(r) for sub-ranges "r" covering the whole "range", possibly in parallel.
+          *  The body must be safe to be invoked concurrently for disjoint sub-ranges, and must not rely on the order in which sub-ranges are processed. */
         template<typename Body> static inline
         void parallel_for( const BlockedRange& range, const Body& body )
         {
-            body(range);
+            const detail::TParallelForBody<Body> b(body);
+            detail::parallel_for_impl(range,b);
         }
-        typedef std::vector<Rect> ConcurrentRectVector;
 
         template<typename Iterator, typename Body> static inline
         void parallel_do( Iterator first, Iterator last, const Body& body )
@@ -30,9 +30,13 @@
 #include <mrpt/utils/CFileStream.h>
 
 #include <mrpt/utils/CFileInputStream.h>
+#include <mrpt/utils/CFileMMapInputStream.h>
+#include <mrpt/utils/CMemoryMappedRegion.h>
+#include <mrpt/utils/CLRUCache.h>
 #include <mrpt/utils/CFileOutputStream.h>
 #include <mrpt/utils/CFileGZInputStream.h>
 #include <mrpt/utils/CFileGZOutputStream.h>
+#include <mrpt/utils/CParallelGZOutputStream.h>
 
 // TCP sockets:
 #include <mrpt/utils/CServerTCPSocket.h>
@@ -56,6 +60,7 @@
 #include <mrpt/utils/CThreadSafeQueue.h>
 #include <mrpt/utils/CMessageQueue.h>
 #include <mrpt/utils/CDynamicGrid.h>
+#include <mrpt/utils/CCopyOnWriteGrid.h>
 #include <mrpt/utils/CProbabilityDensityFunction.h>
 
 #include <mrpt/utils/CConsoleRedirector.h>
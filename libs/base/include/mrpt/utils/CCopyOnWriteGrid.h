@@ -0,0 +1,212 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CCopyOnWriteGrid_H
+#define CCopyOnWriteGrid_H
+
+#include <mrpt/utils/utils_defs.h>
+#include <mrpt/synch/atomic_incr.h>
+#include <mrpt/utils/CMemoryMappedRegion.h>
+
+namespace mrpt
+{
+	namespace utils
+	{
+		/** A 2D array of cells stored as independent, reference-counted rows which are shared between copies of the grid
+		  *  until one of the copies modifies them ("copy-on-write").
+		  *
+		  *  Copying a grid (copy constructor or operator=) only copies one pointer per row and increments its reference counter,
+		  *  so making many copies of a large grid that only differ in a few rows (e.g. the maps of the particles of a
+		  *  Rao-Blackwellized particle filter after resampling) is cheap both in time and memory. Before writing to a row,
+		  *  the user must obtain a pointer to it with getRowForWrite() (or cellForWrite()), which clones the row if it is
+		  *  currently shared with any other grid.
+		  *
+		  *  Each row is stored in contiguous memory, hence pointers returned by getRow() can be used to scan a whole row,
+		  *  but rows are not contiguous between them.
+		  *
+		  *  The cells can also be "borrowed" from read-only memory owned by someone else, e.g. a memory-mapped file (see assignBorrowed()),
+		  *  in which case each row is copied into memory of its own upon the first write to it.
+		  *
+		  *  Thread safety: reference counters are atomic, so different grid objects which share rows can be read, modified
+		  *  and destroyed concurrently from different threads. Accesses to one same grid object must be synchronized by the user.
+		  *
+		  * \tparam T The type of each cell in the 2D grid.
+		  * \sa CDynamicGrid
+		  * \ingroup mrpt_base_grp
+		  */
+		template <class T>
+		class CCopyOnWriteGrid
+		{
+		private:
+			/** A reference-counted row of cells */
+			struct TRow
+			{
+				TRow(size_t ncols, const T &value, long nRefs) : refs(nRefs), cells(ncols,value), owner(NULL) { }
+				TRow(const T *first, const T *last) : refs(1), cells(first,last), owner(NULL) { }
+				TRow(const CMemoryMappedRegionPtr &borrowedFrom, long nRefs) : refs(nRefs), cells(), owner(new CMemoryMappedRegionPtr(borrowedFrom)) { }
+				~TRow() { delete owner; }
+
+				mrpt::synch::CAtomicCounter refs;
+				std::vector<T>              cells;
+				CMemoryMappedRegionPtr     *owner; //!< Only for borrowed rows (whose cells are not in "cells"): the owner of the read-only memory; NULL otherwise
+			};
+
+			std::vector<TRow*>  m_rows;   //!< The rows, possibly shared with other grids
+			std::vector<T*>     m_ptrs;   //!< Cached pointers to the first cell of each row
+			size_t              m_ncols;
+
+			static inline void releaseRow(TRow *row) { if (--row->refs==0) delete row; }
+
+			/** Clones row "y" into memory owned only by this grid (it was shared or borrowed) */
+			void makeRowUnique(size_t y)
+			{
+				TRow *newRow = new TRow(m_ptrs[y],m_ptrs[y]+m_ncols);
+				releaseRow(m_rows[y]);
+				m_rows[y] = newRow;
+				m_ptrs[y] = newRow->cells.empty() ? NULL : &newRow->cells[0];
+			}
+
+			/** The source is not modified: the rows it shares with this grid are detected from their reference counters upon writing */
+			void copyFrom(const CCopyOnWriteGrid<T> &o)
+			{
+				m_rows  = o.m_rows;
+				m_ptrs  = o.m_ptrs;
+				m_ncols = o.m_ncols;
+				for (size_t y=0;y<m_rows.size();y++)
+					++m_rows[y]->refs;
+			}
+
+		public:
+			/** Default constructor: an empty grid */
+			CCopyOnWriteGrid() : m_rows(), m_ptrs(), m_ncols(0) { }
+
+			/** Constructor: a grid of ncols x nrows cells, all set to "value" */
+			CCopyOnWriteGrid(size_t ncols, size_t nrows, const T &value = T()) : m_rows(), m_ptrs(), m_ncols(0)
+			{
+				resize(ncols,nrows,value);
+			}
+
+			/** Copy constructor: shares all the rows with "o" */
+			CCopyOnWriteGrid(const CCopyOnWriteGrid<T> &o) : m_rows(), m_ptrs(), m_ncols(0)
+			{
+				copyFrom(o);
+			}
+
+			/** Copy operator: shares all the rows with "o" */
+			CCopyOnWriteGrid<T> & operator =(const CCopyOnWriteGrid<T> &o)
+			{
+				if (this!=&o)
+				{
+					CCopyOnWriteGrid<T> aux(o);
+					swap(aux);
+				}
+				return *this;
+			}
+
+			~CCopyOnWriteGrid() { clear(); }
+
+			/** Frees all the rows (those shared with other grids are kept alive by them) */
+			void clear()
+			{
+				for (size_t y=0;y<m_rows.size();y++)
+					releaseRow(m_rows[y]);
+				m_rows.clear();
+				m_ptrs.clear();
+				m_ncols = 0;
+			}
+
+			/** Sets a new size, with all the cells set to "value" (previous contents are lost).
+			  *  Initially all the rows share one same block of memory, which is cloned row by row upon writing.
+			  */
+			void resize(size_t ncols, size_t nrows, const T &value = T())
+			{
+				clear();
+				if (!nrows) return;
+				m_ncols = ncols;
+				TRow *row = new TRow(ncols,value,static_cast<long>(nrows));
+				m_rows.assign(nrows,row);
+				m_ptrs.assign(nrows,ncols ? &row->cells[0] : NULL);
+			}
+
+			/** Sets a new size and makes all the rows point to the given external, read-only memory, without copying it (previous contents are lost).
+			  *  Each row is copied into memory of its own upon the first write to it (getRowForWrite(), cellForWrite()).
+			  * \param data The ncols*nrows cells, row after row. They must remain valid and unmodified while there is any reference to "owner".
+			  * \param owner The owner of the memory, which is kept alive as long as any row of this grid (or its copies) is borrowed from it.
+			  * \sa mrpt::utils::CStream::ReadBufferBorrow
+			  */
+			void assignBorrowed(size_t ncols, size_t nrows, const T *data, const CMemoryMappedRegionPtr &owner)
+			{
+				clear();
+				if (!nrows) return;
+				m_ncols = ncols;
+				TRow *row = new TRow(owner,static_cast<long>(nrows));
+				m_rows.assign(nrows,row);
+				m_ptrs.resize(nrows);
+				for (size_t y=0;y<nrows;y++)
+					m_ptrs[y] = ncols ? const_cast<T*>(data+y*ncols) : NULL;
+			}
+
+			/** Swaps the contents of two grids (no cell is copied) */
+			void swap(CCopyOnWriteGrid<T> &o)
+			{
+				m_rows.swap(o.m_rows);
+				m_ptrs.swap(o.m_ptrs);
+				std::swap(m_ncols,o.m_ncols);
+			}
+
+			inline size_t getColCount() const { return m_ncols; }          //!< Number of cells in each row
+			inline size_t getRowCount() const { return m_rows.size(); }    //!< Number of rows
+			inline size_t size() const { return m_ncols*m_rows.size(); }   //!< Total number of cells
+			inline bool empty() const { return m_rows.empty() || !m_ncols; }
+
+			/** Read-only access to the contiguous cells of row "y" (no bound checks) */
+			inline const T * getRow(size_t y) const { return m_ptrs[y]; }
+
+			/** Read-write access to the contiguous cells of row "y" (no bound checks). The row is cloned first if it is shared with another grid.
+			  *  The returned pointer remains valid until the grid is resized, copied to another grid or assigned from another grid.
+			  */
+			inline T * getRowForWrite(size_t y)
+			{
+				const TRow *row = m_rows[y];
+				if (row->refs>1 || row->owner) makeRowUnique(y);
+				return m_ptrs[y];
+			}
+
+			/** Read-only access to one cell (no bound checks) */
+			inline const T & operator()(size_t x, size_t y) const { return m_ptrs[y][x]; }
+
+			/** Read-write access to one cell (no bound checks). \sa getRowForWrite */
+			inline T & cellForWrite(size_t x, size_t y) { return getRowForWrite(y)[x]; }
+
+			/** Sets all the cells to "value", while keeping the current size */
+			void fill(const T &value) { resize(m_ncols,m_rows.size(),value); }
+
+			/** Returns the number of rows which are currently referenced more than once, either by other grids or by other rows of this grid right after resize() (for statistics and debugging) */
+			size_t getSharedRowCount() const
+			{
+				size_t n=0;
+				for (size_t y=0;y<m_rows.size();y++)
+					if (m_rows[y]->refs>1) n++;
+				return n;
+			}
+
+			/** Returns the number of rows which are still borrowed from external memory (for statistics and debugging). \sa assignBorrowed */
+			size_t getBorrowedRowCount() const
+			{
+				size_t n=0;
+				for (size_t y=0;y<m_rows.size();y++)
+					if (m_rows[y]->owner) n++;
+				return n;
+			}
+
+		}; // end of CCopyOnWriteGrid
+
+	} // End of namespace
+} // end of namespace
+
+#endif
@@ -86,11 +86,12 @@ namespace mrpt
 			 */
 			uint64_t getPosition();
 
-			/** This method is not implemented in this class */
-			uint64_t Seek(uint64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning)
-			{
-				THROW_EXCEPTION("Seek is not implemented in this class");
-			}
+			/** Moves to a position in the <b>uncompressed</b> data (as returned by getPosition()). Only sFromBeginning and sFromCurrent are supported.
+			 *  Note that in compressed files, seeking backwards means decompressing again the file from its beginning, and seeking forward
+			 *  decompresses all the data in between, so it is only efficient for short forward skips or for non-compressed files.
+			 * \exception std::exception On any error or if Origin==sFromEnd
+			 */
+			uint64_t Seek(uint64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning);
 
 		}; // End of class def.
 
@@ -0,0 +1,97 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef  CFileMMapInputStream_H
+#define  CFileMMapInputStream_H
+
+#include <mrpt/utils/CStream.h>
+#include <mrpt/utils/CMemoryMappedRegion.h>
+
+namespace mrpt
+{
+	namespace utils
+	{
+		/** This CStream derived class allows using a (non-compressed) file as a read-only, binary stream by mapping it into memory.
+		 *
+		 *  Reading from this stream only copies data from the mapped pages, without any system call. Moreover, classes which
+		 *  support it (e.g. mrpt::slam::COccupancyGridMap2D) directly use large arrays from the mapped file, without copying them,
+		 *  until they are modified (see CStream::ReadBufferBorrow). In that case, the mapping is kept alive until the last of those
+		 *  objects is destroyed, even after this stream is closed.
+		 *
+		 *  Loading a large map, e.g.:
+		 *  \code
+		 *    CFileMMapInputStream("map.gridmap") >> grid;
+		 *  \endcode
+		 *  is thus much faster than with CFileInputStream, but the file must not be modified or truncated while it is mapped.
+		 *  Note that ".gz" files can't be read with this class: use CFileGZInputStream instead.
+		 *
+		 * \sa CStream, CFileInputStream, CMemoryMappedRegion
+		 * \ingroup mrpt_base_grp
+		 */
+		class BASE_IMPEXP CFileMMapInputStream : public CStream, public CUncopiable
+		{
+		protected:
+			/** Method responsible for reading from the stream: copies data from the mapped file. */
+			size_t  Read(void *Buffer, size_t Count);
+
+			/** This method is not implemented in this class */
+			size_t  Write(const void *Buffer, size_t Count);
+
+		private:
+			CMemoryMappedRegionPtr  m_region;   //!< The mapped file, or a NULL pointer
+			size_t                  m_pos;      //!< The read position
+
+		public:
+			/** Constructor
+			  * \param fileName The file to be open in this stream
+			  * \exception std::exception On error trying to open or map the file.
+			  */
+			CFileMMapInputStream(const std::string &fileName);
+
+			/** Default constructor */
+			CFileMMapInputStream();
+
+			/** Destructor */
+			virtual ~CFileMMapInputStream();
+
+			/** Opens and maps a file for reading, closing the previous one (if any).
+			  * \return true on success.
+			  */
+			bool open(const std::string &fileName);
+
+			/** Closes the stream. The mapped memory is released if it is not used by any other object. */
+			void close();
+
+			/** Says if file was open successfully or not */
+			bool fileOpenCorrectly() const { return m_region.present(); }
+
+			/** Will be true if EOF has been already reached */
+			bool checkEOF() const { return !m_region.present() || m_pos>=m_region->size(); }
+
+			/** Returns the mapped file, or a NULL pointer if none is open */
+			inline const CMemoryMappedRegionPtr & getRegion() const { return m_region; }
+
+			/** Method for moving to a specified position in the file (beyond its end is not allowed).
+			 *   See documentation of CStream::Seek
+			 */
+			uint64_t Seek(uint64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning);
+
+			/** Returns the length of the file */
+			uint64_t getTotalBytesCount();
+
+			/** Method for getting the current cursor position, where 0 is the first byte and TotalBytesCount-1 the last one */
+			uint64_t getPosition();
+
+			/** Returns a pointer to the next Count bytes in the mapped file, without copying them. See CStream::ReadBufferBorrow */
+			const void * ReadBufferBorrow(size_t Count, CMemoryMappedRegionPtr &owner);
+
+		}; // End of class def.
+
+	} // End of namespace
+} // end of namespace
+#endif
@@ -0,0 +1,150 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CLRUCache_H
+#define CLRUCache_H
+
+#include <mrpt/utils/utils_defs.h>
+#include <list>
+#include <map>
+
+namespace mrpt
+{
+	namespace utils
+	{
+		/** A cache of key-value pairs with a maximum total size in bytes, which discards the least recently used (LRU) items to make room for new ones.
+		  *
+		  *  The size of each item is given by the user when inserting it (e.g. an estimation of the memory used by an object), and it is only used
+		  *  to decide when items must be discarded: items larger than the whole budget are not kept at all.
+		  *  Both get() and insert() are O(log N).
+		  *
+		  * \note This class is not thread-safe.
+		  * \tparam KEY Any type which can be the key of a std::map
+		  * \tparam VALUE The type of the values (typically, a smart pointer)
+		  * \sa mrpt::slam::CLazyRawlog, mrpt::slam::CLazySimpleMap
+		  * \ingroup mrpt_base_grp
+		  */
+		template <class KEY, class VALUE>
+		class CLRUCache
+		{
+		public:
+			/** Statistics about the usage of the cache, see getStats() */
+			struct TStats
+			{
+				TStats() : hits(0), misses(0), evictions(0) { }
+
+				size_t hits;       //!< Number of calls to get() which found the item
+				size_t misses;     //!< Number of calls to get() which did not find the item
+				size_t evictions;  //!< Number of items discarded to make room for others
+			};
+
+			/** Constructor, with the maximum total size (in bytes) of the items in the cache */
+			CLRUCache(size_t max_bytes) : m_max_bytes(max_bytes), m_cur_bytes(0) { }
+
+			/** Looks for an item, making it the most recently used one if found.
+			  * \return false if the key is not in the cache.
+			  */
+			bool get(const KEY &key, VALUE &out_value)
+			{
+				typename TIndex::iterator it = m_index.find(key);
+				if (it==m_index.end())
+				{
+					m_stats.misses++;
+					return false;
+				}
+				m_stats.hits++;
+				m_items.splice(m_items.begin(),m_items,it->second);   // Move to the front, without invalidating iterators
+				out_value = it->second->value;
+				return true;
+			}
+
+			/** Returns true if the key is in the cache (it does not change the order of use) */
+			bool contains(const KEY &key) const { return m_index.find(key)!=m_index.end(); }
+
+			/** Inserts (or replaces) an item as the most recently used one, discarding the least recently used ones if needed to respect the maximum size.
+			  * \param bytes The (estimated) size of the item. If it is larger than the maximum size of the cache, the item is not inserted.
+			  */
+			void insert(const KEY &key, const VALUE &value, size_t bytes)
+			{
+				erase(key);
+				if (bytes>m_max_bytes)
+					return;
+
+				shrinkTo(m_max_bytes-bytes);
+
+				m_items.push_front(TItem(key,value,bytes));
+				m_index[key] = m_items.begin();
+				m_cur_bytes+=bytes;
+			}
+
+			/** Removes an item, if it is in the cache */
+			void erase(const KEY &key)
+			{
+				typename TIndex::iterator it = m_index.find(key);
+				if (it==m_index.end()) return;
+				m_cur_bytes-=it->second->bytes;
+				m_items.erase(it->second);
+				m_index.erase(it);
+			}
+
+			/** Removes all the items (statistics are kept) */
+			void clear()
+			{
+				m_items.clear();
+				m_index.clear();
+				m_cur_bytes = 0;
+			}
+
+			/** Changes the maximum total size, discarding the least recently used items if needed */
+			void setMaxBytes(size_t max_bytes)
+			{
+				m_max_bytes = max_bytes;
+				shrinkTo(m_max_bytes);
+			}
+
+			inline size_t getMaxBytes() const { return m_max_bytes; }     //!< The maximum total size in bytes of the items
+			inline size_t getCurrentBytes() const { return m_cur_bytes; } //!< The total size in bytes of the current items
+			inline size_t size() const { return m_index.size(); }         //!< The number of items in the cache
+
+			inline const TStats & getStats() const { return m_stats; }    //!< Statistics of hits, misses and evictions
+			inline void resetStats() { m_stats = TStats(); }
+
+		private:
+			struct TItem
+			{
+				TItem(const KEY &k, const VALUE &v, size_t b) : key(k), value(v), bytes(b) { }
+				KEY     key;
+				VALUE   value;
+				size_t  bytes;
+			};
+			typedef std::list<TItem>   TItemList;  //!< Most recently used first
+			typedef std::map<KEY, typename TItemList::iterator>  TIndex;
+
+			TItemList  m_items;
+			TIndex     m_index;
+			size_t     m_max_bytes, m_cur_bytes;
+			TStats     m_stats;
+
+			/** Discards the least recently used items until their total size is <= max_bytes */
+			void shrinkTo(size_t max_bytes)
+			{
+				while (!m_items.empty() && m_cur_bytes>max_bytes)
+				{
+					const TItem &last = m_items.back();
+					m_cur_bytes-=last.bytes;
+					m_index.erase(last.key);
+					m_items.pop_back();
+					m_stats.evictions++;
+				}
+			}
+		};
+
+	} // End of namespace
+} // end of namespace
+
+#endif
@@ -0,0 +1,66 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef  CMemoryMappedRegion_H
+#define  CMemoryMappedRegion_H
+
+#include <mrpt/utils/utils_defs.h>
+#include <mrpt/utils/CUncopiable.h>
+
+namespace mrpt
+{
+	namespace utils
+	{
+		/** A whole file mapped read-only into the address space of the process (mmap() in POSIX systems, MapViewOfFile() in Windows).
+		  *
+		  *  Pages are loaded by the operating system upon the first access, directly from the page cache, so "reading" data
+		  *  from a mapped file costs page faults instead of system calls and copies into user buffers.
+		  *
+		  *  Objects are normally handled through smart pointers (CMemoryMappedRegionPtr), which are shared by all the
+		  *  objects that keep pointers into the mapped memory (see CStream::ReadBufferBorrow). The file is unmapped when the last
+		  *  of them is destroyed.
+		  *
+		  * \sa CFileMMapInputStream
+		  * \ingroup mrpt_base_grp
+		  */
+		class BASE_IMPEXP CMemoryMappedRegion : public CUncopiable
+		{
+		public:
+			/** Constructor, without mapping any file. \sa mapFile */
+			CMemoryMappedRegion();
+
+			/** Destructor: unmaps the file */
+			virtual ~CMemoryMappedRegion();
+
+			/** Maps a whole file read-only, unmapping the previous one (if any).
+			  * \return false on any error. Empty files are mapped successfully, with data()==NULL.
+			  */
+			bool mapFile(const std::string &fileName);
+
+			/** Unmaps the file. Pointers to the mapped memory become invalid. */
+			void unmap();
+
+			inline bool isMapped() const { return m_is_mapped; }   //!< Whether a file is mapped
+			inline const void * data() const { return m_data; }   //!< The first byte of the file, or NULL if none is mapped
+			inline size_t size() const { return m_size; }         //!< The length of the file in bytes
+
+		private:
+			void   *m_data;
+			size_t  m_size;
+			bool    m_is_mapped;
+#ifdef MRPT_OS_WINDOWS
+			void   *m_hFile, *m_hMapping;  //!< The Windows HANDLEs of the file and the mapping object
+#endif
+		};
+
+		/** A reference-counted pointer to a CMemoryMappedRegion */
+		typedef stlplus::smart_ptr_nocopy<CMemoryMappedRegion> CMemoryMappedRegionPtr;
+
+	} // End of namespace
+} // end of namespace
+#endif
@@ -0,0 +1,111 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef  CParallelGZOutputStream_H
+#define  CParallelGZOutputStream_H
+
+#include <mrpt/utils/CStream.h>
+#include <mrpt/utils/CUncopiable.h>
+
+namespace mrpt
+{
+	namespace utils
+	{
+		/** Saves data to a gzip-compressed file (".gz"), compressing blocks of data in parallel in a pool of worker threads.
+		  *
+		  *  The data written to the stream is split into blocks of a fixed size, which are deflated independently by the worker threads
+		  *  (each one using the last 32KiB of the previous block as dictionary, to keep the compression ratio close to that of a single
+		  *  deflate stream) and written to disk in order by another thread, in the same way than the "pigz" program does. The result is
+		  *  one standard gzip stream, which can be read by CFileGZInputStream, gunzip, etc.
+		  *
+		  *  Write() only copies the data into the current block, so the calling thread is only blocked when all the workers are busy and
+		  *  there are already too many blocks waiting to be compressed or written ("backpressure"). The number and duration of these waits
+		  *  are reported by getStats(), and indicate that compression can not keep up with the incoming data rate: use more threads
+		  *  or a lower compression level.
+		  *
+		  * \sa CFileGZOutputStream, CFileGZInputStream
+		  * \ingroup mrpt_base_grp
+		  */
+		class BASE_IMPEXP CParallelGZOutputStream : public CStream, public CUncopiable
+		{
+		public:
+			/** Statistics about the compression, see getStats() */
+			struct BASE_IMPEXP TStats
+			{
+				TStats();
+
+				uint64_t  bytes_in;       //!< Uncompressed bytes written by the user
+				uint64_t  bytes_out;      //!< Bytes written to the file
+				size_t    blocks;         //!< Number of blocks sent to the workers
+				size_t    stalls;         //!< Number of times Write() had to wait for the workers (backpressure)
+				double    stall_time;     //!< Total time (seconds) Write() has been waiting for the workers
+				size_t    max_pending;    //!< Max. number of blocks being compressed or waiting to be written at any time
+			};
+
+			/** Constructor, without opening the file. \sa open */
+			CParallelGZOutputStream();
+
+			/** Constructor: opens an output file with compression level = 1 (minimum, fastest) and the default number of threads and block size.
+			  * \exception std::exception On error creating the file.
+			  */
+			CParallelGZOutputStream(const std::string &fileName);
+
+			/** Destructor: flushes all the data and closes the file */
+			virtual ~CParallelGZOutputStream();
+
+			/** Opens a file for writing, overwriting any existing one.
+			  * \param fileName The file to be open in this stream
+			  * \param compress_level 0:no compression, 1:fastest, 9:best
+			  * \param num_threads Number of compression threads, or 0 (default) for mrpt::system::getParallelizationThreadsCount()
+			  * \param block_size Size in bytes of the blocks of data which are compressed independently (default: 128KiB)
+			  * \return true on success, false on any error.
+			  */
+			bool open(const std::string &fileName, int compress_level = 1, unsigned int num_threads = 0, size_t block_size = 128*1024);
+
+			/** Compresses all the pending data, writes the gzip trailer and closes the file. Does nothing if no file was open.
+			  * \exception std::exception If there was any error compressing or writing the data.
+			  */
+			void close();
+
+			/** Says if file was open successfully or not */
+			bool fileOpenCorrectly() const { return m_impl!=NULL; }
+
+			/** Returns the number of (uncompressed) bytes written so far */
+			uint64_t getPosition();
+
+			/** Returns the statistics of the current (or last) file */
+			TStats getStats() const;
+
+			/** This method is not implemented in this class */
+			uint64_t Seek(uint64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning)
+			{
+				THROW_EXCEPTION("Seek is not implemented in this class");
+			}
+
+			/** This method is not implemented in this class */
+			uint64_t getTotalBytesCount()
+			{
+				THROW_EXCEPTION("getTotalBytesCount is not implemented in this class");
+			}
+
+		protected:
+			/** This method is not implemented in this class */
+			size_t  Read(void *Buffer, size_t Count);
+
+			/** Copies the data into the current block, handing it over to the workers when it is full. */
+			size_t  Write(const void *Buffer, size_t Count);
+
+		private:
+			struct TImpl;
+			TImpl   *m_impl;   //!< The state of the open file and its threads, or NULL
+			TStats   m_last_stats; //!< The statistics of the last closed file
+		};
+
+	} // End of namespace
+} // end of namespace
+#endif
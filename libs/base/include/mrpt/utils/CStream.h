@@ -12,6 +12,7 @@
 #include <mrpt/utils/utils_defs.h>
 #include <mrpt/utils/CUncopiable.h>
 #include <mrpt/utils/CObject.h>
+#include <mrpt/utils/CMemoryMappedRegion.h>
 #include <mrpt/utils/exceptions.h>
 
 namespace mrpt
@@ -107,6 +108,16 @@ namespace mrpt
 			 */
 			virtual size_t  ReadBufferImmediate(void *Buffer, size_t Count) { return ReadBuffer(Buffer, Count); }
 
+			/** Returns a pointer to the next Count bytes of the stream without copying them, if the stream data is already in memory
+			 *  which can be shared with the caller (e.g. CFileMMapInputStream), and moves the read position after them.
+			 *  Otherwise (the default in most CStream classes), returns NULL without reading anything, and the caller must use ReadBuffer() instead.
+			 *  This allows readFromStream() implementations to use large arrays directly from a memory-mapped file, instead of copying them.
+			 *  \param owner Upon success, a reference to the memory, which must be kept alive while the returned pointer is used.
+			 *	\exception std::exception If the stream has less than Count bytes left.
+			 *  \note The data is not aligned and it is in little endian byte order, as written by WriteBuffer() (see ReadBufferFixEndianness).
+			 */
+			virtual const void * ReadBufferBorrow(size_t Count, CMemoryMappedRegionPtr &owner) { MRPT_UNUSED_PARAM(Count); MRPT_UNUSED_PARAM(owner); return NULL; }
+
 			/** Writes a block of bytes to the stream from Buffer.
 			 *	\exception std::exception On any error
 			 *  \sa Important, see: WriteBufferFixEndianness
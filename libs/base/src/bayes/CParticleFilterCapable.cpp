@@ -32,6 +32,19 @@ using namespace std;
 
 const unsigned CParticleFilterCapable::PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS = 20;
 
+namespace
+{
+	/** Cumulative sum of the weights (mrpt::math::cumsum() only accepts Eigen containers) */
+	void cumsum_weights(const std::vector<double> &w, std::vector<double> &Q)
+	{
+		const size_t N = w.size();
+		Q.resize(N);
+		double last = 0;
+		for (size_t i=0;i<N;i++)
+			last = Q[i] = last + w[i];
+	}
+}
+
 /*---------------------------------------------------------------
 					performResampling
  ---------------------------------------------------------------*/
@@ -45,8 +58,8 @@ void  CParticleFilterCapable::performResampling(
 	const size_t in_particle_count = particlesCount();
 	ASSERT_(in_particle_count>0)
 
-	std::vector<size_t>	indxs;
-	vector_double	log_ws(in_particle_count,0);
+	vector_double	&log_ws = m_resamplingAuxiliary.log_ws;
+	log_ws.resize(in_particle_count);
 	for (size_t i=0;i<in_particle_count;i++)
 		log_ws[i] = getW(i);
 
@@ -54,14 +67,16 @@ void  CParticleFilterCapable::performResampling(
 	computeResampling(
 		PF_options.resamplingMethod,
 		log_ws,
-		indxs,
+		m_resamplingAuxiliary.indexes,
+		m_resamplingAuxiliary,
 		out_particle_count );
 
 	// And perform the particle replacement:
-	performSubstitution( indxs );
+	performSubstitution( m_resamplingAuxiliary.indexes );
 
 	// Finally, equal weights:
-	for (size_t i=0;i<out_particle_count;i++) setW(i, 0 /* Logarithmic weight */ );
+	const size_t new_particle_count = particlesCount();
+	for (size_t i=0;i<new_particle_count;i++) setW(i, 0 /* Logarithmic weight */ );
 
 	MRPT_END
 }
@@ -74,6 +89,17 @@ void CParticleFilterCapable::computeResampling(
 	const vector_double	&in_logWeights,
 	std::vector<size_t>			&out_indexes,
 	size_t out_particle_count )
+{
+	TResamplingAuxVars	aux;
+	computeResampling(method,in_logWeights,out_indexes,aux,out_particle_count);
+}
+
+void CParticleFilterCapable::computeResampling(
+	CParticleFilter::TParticleResamplingAlgorithm	method,
+	const vector_double	&in_logWeights,
+	std::vector<size_t>			&out_indexes,
+	TResamplingAuxVars	&aux,
+	size_t out_particle_count )
 {
 	MRPT_START
 
@@ -86,19 +112,24 @@ void CParticleFilterCapable::computeResampling(
 	if (!out_particle_count)
 		out_particle_count = M;
 
-	vector_double					linW( M,0 );
-	vector_double::const_iterator	inIt;
-	vector_double::iterator			outIt;
-	double							linW_SUM=0;
+	std::vector<double>	&linW = aux.linW;
+	std::vector<double>	&Q = aux.Q;
+	std::vector<double>	&T = aux.T;
+	double				linW_SUM=0;
 
 	// This is to avoid float point range problems:
-	double max_log_w = math::maximum( in_logWeights );
-	for (i=0,inIt=in_logWeights.begin(),outIt=linW.begin();i<M;i++,inIt++,outIt++)
-		linW_SUM += ( (*outIt) = exp( (*inIt) - max_log_w ) );
+	const double max_log_w = math::maximum( in_logWeights );
+	linW.resize(M);
+	for (i=0;i<M;i++)
+		linW_SUM += ( linW[i] = exp( in_logWeights[i] - max_log_w ) );
 
 	// Normalize weights:
 	ASSERT_(linW_SUM>0);
-	linW *= 1.0 / linW_SUM;
+	const double linW_SUM_inv = 1.0 / linW_SUM;
+	for (i=0;i<M;i++)
+		linW[i] *= linW_SUM_inv;
+
+	out_indexes.resize(out_particle_count);
 
 	switch ( method )
 	{
@@ -107,11 +138,10 @@ void CParticleFilterCapable::computeResampling(
 			// ==============================================
 			//   Select with replacement
 			// ==============================================
-			vector_double	Q;
-			mrpt::math::cumsum(linW, Q);
+			cumsum_weights(linW, Q);
 			Q[M-1] = 1.1;
 
-			vector_double	T(M);
+			T.resize(out_particle_count);
 			randomGenerator.drawUniformVector(T,0.0, 0.999999);
 			T.push_back(1.0);
 
@@ -119,14 +149,13 @@ void CParticleFilterCapable::computeResampling(
 			// --------------------
 			std::sort( T.begin(), T.end() );
 
-			out_indexes.resize(out_particle_count);
 			i=j=0;
 
 			while (i < out_particle_count)
 			{
 				if (T[i]<Q[j])
 				{
-					out_indexes[i++] = (unsigned int) j;
+					out_indexes[i++] = j;
 				}
 				else
 				{
@@ -143,19 +172,19 @@ void CParticleFilterCapable::computeResampling(
 			//   prResidual
 			// ==============================================
 			// Repetition counts:
-			vector_uint	N(M);
+			std::vector<size_t>	&N = aux.N;
+			N.resize(M);
 			size_t 		R=0;	// Remainder or residual count
 			for (i=0;i<M;i++)
 			{
-				N[i] = int( M*linW[i] );
+				N[i] = size_t( out_particle_count*linW[i] );
 				R+= N[i];
 			}
 			size_t  N_rnd =  out_particle_count>=R ? (out_particle_count-R) : 0; // # of particles to be drawn randomly (the "residual" part)
 
 			// Fillout the deterministic part of the resampling:
-			out_indexes.resize(out_particle_count);
-			for (i=0, j=0 ;i<out_particle_count;i++)
-				for (size_t k=0;k<N[i];k++)
+			for (i=0, j=0 ;i<M;i++)
+				for (size_t k=0;k<N[i] && j<out_particle_count;k++)
 					out_indexes[j++] = i;
 
 			size_t M_fixed = j;
@@ -165,18 +194,16 @@ void CParticleFilterCapable::computeResampling(
 			// ----------------------------------------------------------
 			if (N_rnd)	// If there are "residual" part (should be virtually always!)
 			{
-				// Compute modified weights:
-				vector_double	linW_mod(M);
+				// Compute modified weights (in place in linW, not needed anymore):
 				const double M_R_1 = 1.0/N_rnd;
 				for (i=0;i<M;i++)
-					linW_mod[i] = M_R_1 * (M*linW[i]-N[i]);
+					linW[i] = M_R_1 * (out_particle_count*linW[i]-N[i]);
 
 				// perform resampling:
-				vector_double	Q;
-				mrpt::math::cumsum(linW_mod, Q);
+				cumsum_weights(linW, Q);
 				Q[M-1] = 1.1;
 
-				vector_double	T(M);
+				T.resize(N_rnd);
 				randomGenerator.drawUniformVector(T, 0.0 , 0.999999);
 				T.push_back(1.0);
 
@@ -190,7 +217,7 @@ void CParticleFilterCapable::computeResampling(
 				{
 					if (T[i]<Q[j])
 					{
-						out_indexes[M_fixed + i++] = (unsigned int) j;
+						out_indexes[M_fixed + i++] = j;
 					}
 					else
 					{
@@ -206,28 +233,26 @@ void CParticleFilterCapable::computeResampling(
 			// ==============================================
 			//   prStratified
 			// ==============================================
-			vector_double	Q;
-			mrpt::math::cumsum(linW, Q);
+			cumsum_weights(linW, Q);
 			Q[M-1] = 1.1;
 
 			// Stratified-uniform random vector:
-			vector_double	T(M+1);
-			const double	_1_M = 1.0 / M;
+			T.resize(out_particle_count+1);
+			const double	_1_M = 1.0 / out_particle_count;
 			const double	_1_M_eps = _1_M - 0.000001;
 			double   		T_offset = 0;
-			for (i=0;i<M;i++)
+			for (i=0;i<out_particle_count;i++)
 			{
 				T[i] = T_offset + randomGenerator.drawUniform(0.0,_1_M_eps);
 				T_offset+= _1_M;
 			}
-			T[M] = 1;
+			T[out_particle_count] = 1;
 
-			out_indexes.resize(out_particle_count);
 			i=j=0;
 			while (i < out_particle_count)
 			{
 				if (T[i]<Q[j])
-					out_indexes[i++] = (unsigned int)j;
+					out_indexes[i++] = j;
 				else
 				{
 					j++;
@@ -241,23 +266,21 @@ void CParticleFilterCapable::computeResampling(
 			// ==============================================
 			//   prSystematic
 			// ==============================================
-			vector_double	Q;
-			mrpt::math::cumsum(linW, Q);
+			cumsum_weights(linW, Q);
 			Q[M-1] = 1.1;
 
 			// Uniform random vector:
-			vector_double	T(M+1);
-			double	_1_M = 1.0 / M;
+			T.resize(out_particle_count+1);
+			const double	_1_M = 1.0 / out_particle_count;
 			T[0] = randomGenerator.drawUniform(0.0,_1_M);
-			for (i=1;i<M;i++)	T[i] = T[i-1] + _1_M;
-			T[M] = 1;
+			for (i=1;i<out_particle_count;i++)	T[i] = T[i-1] + _1_M;
+			T[out_particle_count] = 1;
 
-			out_indexes.resize(out_particle_count);
 			i=j=0;
 			while (i < out_particle_count)
 			{
 				if (T[i]<Q[j])
-					out_indexes[i++] = (unsigned int)j;
+					out_indexes[i++] = j;
 				else
 				{
 					j++;
@@ -435,14 +458,15 @@ void  CParticleFilterCapable::prepareFastDrawSample(
 		// ------------------------------------------------------------------------
 		// Generate the vector with the "probabilities" of each particle being selected:
 		size_t	i,M = particlesCount();
-		vector_double		PDF(M,0);
+		vector_double		&PDF = m_resamplingAuxiliary.log_ws;
+		PDF.resize(M);
 		for (i=0;i<M;i++)
 			PDF[i] = partEvaluator(PF_options,this,i,action,observation); // Default evaluator: takes current weight.
 
-		std::vector<size_t>		idxs;
+		std::vector<size_t>		&idxs = m_resamplingAuxiliary.indexes;
 
 		// Generate the particle samples:
-		computeResampling( PF_options.resamplingMethod, PDF, idxs );
+		computeResampling( PF_options.resamplingMethod, PDF, idxs, m_resamplingAuxiliary );
 
 		std::vector<size_t>::iterator	it;
 		vector_uint::iterator			it2;
@@ -0,0 +1,106 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::poses;
+using namespace mrpt::utils;
+using namespace std;
+
+// Particle "i" is at x=i:
+static void init_particles(CPosePDFParticles &pdf, size_t M)
+{
+	pdf.resetDeterministic(CPose2D(0,0,0),M);
+	for (size_t i=0;i<M;i++)
+	{
+		pdf.m_particles[i].d->x(i);
+		pdf.m_particles[i].log_w = -double(i);
+	}
+}
+
+static std::multiset<int> particles_as_multiset(const CPosePDFParticles &pdf)
+{
+	std::multiset<int> ret;
+	for (size_t i=0;i<pdf.m_particles.size();i++)
+		ret.insert( mrpt::utils::round(pdf.m_particles[i].d->x()) );
+	return ret;
+}
+
+TEST(CParticleFilterCapable, performSubstitutionInPlace)
+{
+	const size_t idxs_arr[] = { 0,0,2,3,3,3, 5,5,5,5,1 }; // Sizes: 6 and 11
+	for (size_t nOut=6;nOut<=11;nOut+=5)
+	{
+		for (size_t nIn=6;nIn<=11;nIn+=5)
+		{
+			const std::vector<size_t> idxs(idxs_arr,idxs_arr+nOut);
+			if (*std::max_element(idxs.begin(),idxs.end())>=nIn) continue;
+
+			CPosePDFParticles pdf;
+			init_particles(pdf,nIn);
+
+			std::set<CPose2D*> oldData;
+			for (size_t i=0;i<nIn;i++) oldData.insert(pdf.m_particles[i].d);
+
+			pdf.performSubstitution(idxs);
+			EXPECT_EQ(pdf.m_particles.size(),nOut);
+
+			std::multiset<int> expected;
+			for (size_t i=0;i<nOut;i++) expected.insert(int(idxs[i]));
+			EXPECT_TRUE(expected==particles_as_multiset(pdf));
+
+			// Weights go with their particles:
+			std::set<CPose2D*> newData;
+			for (size_t i=0;i<pdf.m_particles.size();i++)
+			{
+				EXPECT_DOUBLE_EQ(pdf.m_particles[i].log_w, -pdf.m_particles[i].d->x());
+				newData.insert(pdf.m_particles[i].d);
+			}
+			// All particles are different objects, and reuse the old ones while possible:
+			EXPECT_EQ(newData.size(),nOut);
+			size_t nReused=0;
+			for (std::set<CPose2D*>::const_iterator it=newData.begin();it!=newData.end();++it)
+				if (oldData.count(*it)) nReused++;
+			EXPECT_EQ(nReused,std::min(nIn,nOut));
+		}
+	}
+}
+
+TEST(CParticleFilterCapable, performResampling)
+{
+	const CParticleFilter::TParticleResamplingAlgorithm methods[] = {
+		CParticleFilter::prMultinomial, CParticleFilter::prResidual, CParticleFilter::prStratified, CParticleFilter::prSystematic };
+
+	for (int m=0;m<4;m++)
+	{
+		CParticleFilter::TParticleFilterOptions opts;
+		opts.resamplingMethod = methods[m];
+
+		for (size_t nOut=5;nOut<=40;nOut+=35)
+		{
+			CPosePDFParticles pdf;
+			init_particles(pdf,20);
+			// All the probability mass in particles #3 and #7:
+			for (size_t i=0;i<20;i++)
+				pdf.m_particles[i].log_w = (i==3 || i==7) ? 0 : -1000;
+
+			pdf.performResampling(opts,nOut);
+			ASSERT_EQ(pdf.m_particles.size(),nOut) << "method=" << methods[m];
+			for (size_t i=0;i<nOut;i++)
+			{
+				const int x = mrpt::utils::round(pdf.m_particles[i].d->x());
+				EXPECT_TRUE(x==3 || x==7) << "method=" << methods[m];
+				EXPECT_EQ(pdf.m_particles[i].log_w,0);
+			}
+		}
+	}
+}
@@ -241,13 +241,20 @@ void  mrpt::compress::zip::decompress(
 	unsigned long	actualOutSize = (unsigned long)outDataBufferSize;
 	std::vector<unsigned char>		inData;
 
-	inData.resize(inDataSize);
-	inStream.ReadBuffer( &inData[0], inDataSize );
+	// Decompress directly from the memory of the stream if it allows so (e.g. memory-mapped files), or from a copy otherwise:
+	CMemoryMappedRegionPtr  borrowedOwner;
+	const unsigned char *inPtr = static_cast<const unsigned char*>( inStream.ReadBufferBorrow(inDataSize, borrowedOwner) );
+	if (!inPtr)
+	{
+		inData.resize(inDataSize);
+		inStream.ReadBuffer( &inData[0], inDataSize );
+		inPtr = &inData[0];
+	}
 
 	ret = ::uncompress(
 		(unsigned char*)outData,
 		&actualOutSize,
-		&inData[0],
+		inPtr,
 		(unsigned long)inDataSize
 		);
 
@@ -0,0 +1,67 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>
+#include <mrpt/system/CGenericMemoryPool.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::system;
+using namespace std;
+
+// A vector type not pooled anywhere else in the library, so the pool statistics are only affected by this test:
+typedef std::vector<int16_t>        vector_t;
+typedef CVectorMemoryPool<vector_t> pool_t;
+
+TEST(CVectorMemoryPool, recycleBuffers)
+{
+	pool_t::pool_t *pool = pool_t::getPool();
+	ASSERT_TRUE(pool!=NULL);
+	pool->clear();
+
+	size_t nReq0, nHits0;
+	pool->getStatistics(nReq0,nHits0);
+
+	// Donate a buffer:
+	const int16_t *donated_buf;
+	{
+		vector_t v(1000, 7);
+		donated_buf = &v[0];
+		pool_t::donate(v);
+		EXPECT_TRUE(v.empty());
+		EXPECT_EQ(pool->size(), 1u);
+	}
+
+	// Too small a request for that buffer:
+	vector_t v1;
+	pool_t::resize(v1,300);
+	EXPECT_EQ(v1.size(), 300u);
+	EXPECT_EQ(pool->size(), 1u);
+
+	// A suitable request reuses it:
+	vector_t v2;
+	pool_t::resize(v2,800);
+	EXPECT_EQ(v2.size(), 800u);
+	EXPECT_EQ(&v2[0], donated_buf);
+	EXPECT_EQ(pool->size(), 0u);
+
+	// Non-empty vectors are resized as usual:
+	pool_t::donate(v1);
+	pool_t::resize(v2,900);
+	EXPECT_EQ(v2.size(), 900u);
+	EXPECT_EQ(pool->size(), 1u);
+
+	size_t nReq, nHits;
+	pool->getStatistics(nReq,nHits);
+	EXPECT_EQ(nReq-nReq0, 2u);
+	EXPECT_EQ(nHits-nHits0, 1u);
+
+	pool->clear();
+	EXPECT_EQ(pool->size(), 0u);
+}
@@ -0,0 +1,178 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>  // Precompiled headers
+
+#include <mrpt/system/parallelization.h>
+#include <mrpt/system/threads.h>
+#include <mrpt/synch/CCriticalSection.h>
+#include <mrpt/synch/CSemaphore.h>
+
+using namespace mrpt;
+using namespace mrpt::system;
+using namespace mrpt::synch;
+using namespace std;
+
+namespace
+{
+	unsigned int  g_parallelization_threads = 0;  // 0 means "not set": use the number of processors
+}
+
+void mrpt::system::setParallelizationThreadsCount(unsigned int nThreads)
+{
+	g_parallelization_threads = nThreads;
+}
+
+unsigned int mrpt::system::getParallelizationThreadsCount()
+{
+	return g_parallelization_threads ? g_parallelization_threads : mrpt::system::getNumberOfProcessors();
+}
+
+#if !MRPT_HAS_TBB
+
+namespace
+{
+	/** A pool of worker threads, created upon first use, which runs the chunks of one parallel_for() at a time.
+	  *  The calling thread also takes chunks, so only (nThreads-1) workers are woken up per job.
+	  */
+	class CParallelForWorkers
+	{
+	public:
+		/** The pool is never destroyed on purpose: worker threads may still be blocked on its
+		  *  semaphores during the program global destruction phase. */
+		static CParallelForWorkers & instance()
+		{
+			static CParallelForWorkers *inst = new CParallelForWorkers();
+			return *inst;
+		}
+
+		/** Runs the job in the pool and returns true, or returns false without doing anything
+		  *  if the pool is already running another job (e.g. nested or concurrent parallel_for's). */
+		bool run(const BlockedRange& range, const detail::TParallelForBodyBase &body, const unsigned int nThreads)
+		{
+			{
+				CCriticalSectionLocker lock(&m_busy_cs);
+				if (m_busy) return false;
+				m_busy = true;
+			}
+
+			// Chunks of at least "grainsize", with a few chunks per thread for load balancing:
+			const int len   = range.end()-range.begin();
+			const int grain = std::max(1,range.grainsize());
+			const int nPreferredChunks = 4*nThreads;
+
+			{
+				CCriticalSectionLocker lock(&m_job_cs);
+				m_body  = &body;
+				m_next  = range.begin();
+				m_end   = range.end();
+				m_chunk = std::max(grain, (len+nPreferredChunks-1)/nPreferredChunks );
+				m_error.clear();
+			}
+
+			// Launch new workers only the first time they are needed:
+			const size_t nWorkers = std::min( size_t(nThreads-1), size_t( (len+m_chunk-1)/m_chunk - 1) );
+			while (m_threads.size()<nWorkers)
+				m_threads.push_back( mrpt::system::createThread(&CParallelForWorkers::workerThread, this) );
+
+			m_sem_start.release(nWorkers);
+			processChunks();
+			for (size_t i=0;i<nWorkers;i++)
+				m_sem_done.waitForSignal();
+
+			const std::string errMsg = m_error;
+			{
+				CCriticalSectionLocker lock(&m_busy_cs);
+				m_busy = false;
+			}
+			if (!errMsg.empty())
+				THROW_EXCEPTION(errMsg)
+			return true;
+		}
+
+	private:
+		CParallelForWorkers() :
+			m_busy(false),
+			m_sem_start(0,0x7FFFFFFF),
+			m_sem_done(0,0x7FFFFFFF),
+			m_body(NULL),
+			m_next(0),m_end(0),m_chunk(1)
+		{
+		}
+
+		CCriticalSection  m_busy_cs;
+		bool              m_busy;
+
+		CSemaphore        m_sem_start, m_sem_done;
+		std::vector<TThreadHandle>  m_threads;
+
+		CCriticalSection  m_job_cs;  //!< Protects the job description below:
+		const detail::TParallelForBodyBase *m_body;
+		int               m_next, m_end, m_chunk;
+		std::string       m_error;  //!< Empty, or the message of the first exception thrown by the body
+
+		/** Take chunks of the current job until there're no more left */
+		void processChunks()
+		{
+			for (;;)
+			{
+				int b,e;
+				{
+					CCriticalSectionLocker lock(&m_job_cs);
+					if (m_next>=m_end) return;
+					b = m_next;
+					e = std::min(m_end, m_next+m_chunk);
+					m_next = e;
+				}
+
+				try
+				{
+					m_body->run( BlockedRange(b,e,m_chunk) );
+				}
+				catch (std::exception &ex)
+				{
+					onError(ex.what());
+				}
+				catch (...)
+				{
+					onError("Unknown exception in parallel_for() body");
+				}
+			}
+		}
+
+		void onError(const std::string &msg)
+		{
+			CCriticalSectionLocker lock(&m_job_cs);
+			if (m_error.empty()) m_error = msg;
+			m_next = m_end; // Don't start any other chunk.
+		}
+
+		static void workerThread(CParallelForWorkers *obj)
+		{
+			for (;;)
+			{
+				obj->m_sem_start.waitForSignal();
+				obj->processChunks();
+				obj->m_sem_done.release();
+			}
+		}
+	};
+} // end anonymous NS
+
+void mrpt::system::detail::parallel_for_impl( const BlockedRange& range, const TParallelForBodyBase &body )
+{
+	const int len = range.end()-range.begin();
+	if (len<=0) return;
+
+	const unsigned int nThreads = getParallelizationThreadsCount();
+	if (nThreads<=1 || len<=std::max(1,range.grainsize()) || !CParallelForWorkers::instance().run(range,body,nThreads) )
+		body.run(range);
+}
+
+#endif // !MRPT_HAS_TBB
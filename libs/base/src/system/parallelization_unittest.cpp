@@ -0,0 +1,64 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>
+#include <mrpt/system/parallelization.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::system;
+using namespace std;
+
+struct TCountVisits
+{
+	std::vector<int> &visits;
+	TCountVisits(std::vector<int> &v) : visits(v) {}
+	void operator()(const BlockedRange &r) const {
+		for (int i=r.begin();i!=r.end();++i)
+			visits[i]++;
+	}
+};
+
+struct TThrowAt
+{
+	int bad_idx;
+	TThrowAt(int i) : bad_idx(i) {}
+	void operator()(const BlockedRange &r) const {
+		for (int i=r.begin();i!=r.end();++i)
+			if (i==bad_idx) throw std::runtime_error("bad index");
+	}
+};
+
+TEST(Parallelization, parallel_for_visits_all_once)
+{
+	const unsigned int old_nThreads = getParallelizationThreadsCount();
+	const unsigned int nThreads[] = {1,2,4,7};
+	for (size_t k=0;k<sizeof(nThreads)/sizeof(nThreads[0]);k++)
+	{
+		setParallelizationThreadsCount(nThreads[k]);
+		std::vector<int> visits(1003,0);
+		parallel_for( BlockedRange(0,visits.size(),8), TCountVisits(visits) );
+		for (size_t i=0;i<visits.size();i++)
+			EXPECT_EQ(visits[i],1) << "nThreads=" << nThreads[k] << " index=" << i;
+	}
+	setParallelizationThreadsCount(old_nThreads);
+}
+
+TEST(Parallelization, parallel_for_propagates_exceptions)
+{
+	const unsigned int old_nThreads = getParallelizationThreadsCount();
+	setParallelizationThreadsCount(4);
+	EXPECT_ANY_THROW( parallel_for( BlockedRange(0,1000), TThrowAt(517) ) );
+	// The pool must be usable again afterwards:
+	std::vector<int> visits(100,0);
+	parallel_for( BlockedRange(0,visits.size()), TCountVisits(visits) );
+	for (size_t i=0;i<visits.size();i++)
+		EXPECT_EQ(visits[i],1);
+	setParallelizationThreadsCount(old_nThreads);
+}
@@ -0,0 +1,108 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace std;
+
+
+TEST(CCopyOnWriteGrid, ResizeAndWrite)
+{
+	CCopyOnWriteGrid<int> g(7,5, 3);
+	EXPECT_EQ(g.getColCount(),7u);
+	EXPECT_EQ(g.getRowCount(),5u);
+	EXPECT_EQ(g.size(),35u);
+
+	for (size_t y=0;y<5;y++)
+		for (size_t x=0;x<7;x++)
+			EXPECT_EQ(g(x,y),3);
+
+	g.cellForWrite(2,1) = 10;
+	EXPECT_EQ(g(2,1),10);
+	// The other rows keep sharing the initial block:
+	EXPECT_EQ(g(2,0),3);
+	EXPECT_EQ(g(2,2),3);
+	EXPECT_EQ(g.getSharedRowCount(),4u);
+
+	g.fill(-1);
+	EXPECT_EQ(g(2,1),-1);
+}
+
+TEST(CCopyOnWriteGrid, CopiesAreIndependent)
+{
+	CCopyOnWriteGrid<int> a(4,6, 0);
+	for (size_t y=0;y<6;y++)
+	{
+		int *row = a.getRowForWrite(y);
+		for (size_t x=0;x<4;x++) row[x] = int(x+10*y);
+	}
+	EXPECT_EQ(a.getSharedRowCount(),0u);
+
+	CCopyOnWriteGrid<int> b(a), c;
+	c = a;
+	EXPECT_EQ(a.getSharedRowCount(),6u);
+	EXPECT_EQ(b.getRow(3),a.getRow(3));  // Shared memory
+
+	b.cellForWrite(1,3) = -5;
+	c.cellForWrite(2,3) = -7;
+	a.cellForWrite(0,0) = -9;
+
+	EXPECT_NE(b.getRow(3),a.getRow(3));
+	EXPECT_EQ(b.getRow(4),a.getRow(4));
+
+	for (size_t y=0;y<6;y++)
+		for (size_t x=0;x<4;x++)
+		{
+			const int v = int(x+10*y);
+			EXPECT_EQ(a(x,y), (x==0 && y==0) ? -9 : v );
+			EXPECT_EQ(b(x,y), (x==1 && y==3) ? -5 : v );
+			EXPECT_EQ(c(x,y), (x==2 && y==3) ? -7 : v );
+		}
+
+	// Destroying the original must not affect the copies:
+	a.clear();
+	EXPECT_TRUE(a.empty());
+	EXPECT_EQ(b(3,5),53);
+	EXPECT_EQ(c(3,5),53);
+}
+
+TEST(CCopyOnWriteGrid, RowsAreWrittenInPlaceOnceNotShared)
+{
+	CCopyOnWriteGrid<int> a(3,2, 1);
+	int *row0 = a.getRowForWrite(0);
+	row0[0] = 5;
+	EXPECT_EQ(a.getRowForWrite(0),row0);  // Already owned: no clone
+
+	{
+		// Copying from a const grid:
+		const CCopyOnWriteGrid<int> &ca = a;
+		CCopyOnWriteGrid<int> b(ca);
+		EXPECT_EQ(b.getRow(0),row0);
+		b.cellForWrite(1,0) = 7;
+		EXPECT_NE(b.getRow(0),row0);
+		EXPECT_EQ(a(1,0),1);
+		EXPECT_EQ(b(0,0),5);
+
+		// Still shared with "c": writing to "a" must clone the row
+		CCopyOnWriteGrid<int> c(ca);
+		a.cellForWrite(2,0) = 9;
+		EXPECT_NE(a.getRow(0),c.getRow(0));
+		EXPECT_EQ(c(2,0),1);
+		row0 = a.getRowForWrite(0);
+	}
+
+	// The copies are gone, so "a" is the only owner of its rows again:
+	EXPECT_EQ(a.getSharedRowCount(),0u);
+	EXPECT_EQ(a.getRowForWrite(0),row0);
+	EXPECT_EQ(a(0,0),5);
+	EXPECT_EQ(a(2,0),9);
+}
@@ -19,8 +19,21 @@
 #include <mrpt/system/filesystem.h>
 
 
+#include <mrpt/utils/mrpt_inttypes.h>  // For PRIu64
+
 #include <zlib.h>
 
+// 64-bit offsets within the uncompressed data, if available (zlib>=1.2.4 with large file support):
+#if ZLIB_VERNUM>=0x1240 && defined(_LARGEFILE64_SOURCE) && defined(_LFS64_LARGEFILE) && _LFS64_LARGEFILE-0
+#	define MRPT_GZSEEK  gzseek64
+#	define MRPT_GZTELL  gztell64
+	typedef z_off64_t   mrpt_gz_off_t;
+#else
+#	define MRPT_GZSEEK  gzseek
+#	define MRPT_GZTELL  gztell
+	typedef z_off_t     mrpt_gz_off_t;
+#endif
+
 using namespace mrpt::utils;
 using namespace std;
 
@@ -91,7 +104,13 @@ size_t  CFileGZInputStream::Read(void *Buffer, size_t Count)
 {
 	if (!m_f) { THROW_EXCEPTION("File is not open."); }
 
-	return gzread(THE_GZFILE,Buffer,Count);
+	const int n = gzread(THE_GZFILE,Buffer,Count);
+	if (n<0)
+	{
+		int errnum;
+		THROW_EXCEPTION_CUSTOM_MSG1("Error reading from the gz file: %s", gzerror(THE_GZFILE,&errnum))
+	}
+	return static_cast<size_t>(n);
 }
 
 /*---------------------------------------------------------------
@@ -112,13 +131,34 @@ uint64_t CFileGZInputStream::getTotalBytesCount()
 	return m_file_size;
 }
 
+/*---------------------------------------------------------------
+						Seek
+ ---------------------------------------------------------------*/
+uint64_t CFileGZInputStream::Seek(uint64_t Offset, CStream::TSeekOrigin Origin)
+{
+	if (!m_f) { THROW_EXCEPTION("File is not open."); }
+
+	int whence;
+	switch (Origin)
+	{
+	case sFromBeginning: whence = SEEK_SET; break;
+	case sFromCurrent:   whence = SEEK_CUR; break;
+	default: THROW_EXCEPTION("Seeking from the end is not supported in gz-compressed streams");
+	};
+
+	const mrpt_gz_off_t ret = MRPT_GZSEEK(THE_GZFILE, static_cast<mrpt_gz_off_t>(Offset), whence);
+	if (ret<0)
+		THROW_EXCEPTION_CUSTOM_MSG1("Error seeking to position %" PRIu64, Offset);
+	return static_cast<uint64_t>(ret);
+}
+
 /*---------------------------------------------------------------
 						getPosition
  ---------------------------------------------------------------*/
 uint64_t CFileGZInputStream::getPosition()
 {
 	if (!m_f) { THROW_EXCEPTION("File is not open."); }
-	return gztell(THE_GZFILE);
+	return static_cast<uint64_t>(MRPT_GZTELL(THE_GZFILE));
 }
 
 /*---------------------------------------------------------------
@@ -0,0 +1,153 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>  // Precompiled headers
+
+#include <mrpt/utils/CFileMMapInputStream.h>
+
+using namespace mrpt::utils;
+using namespace std;
+
+/*---------------------------------------------------------------
+							Constructor
+ ---------------------------------------------------------------*/
+CFileMMapInputStream::CFileMMapInputStream( const string &fileName ) : m_region(), m_pos(0)
+{
+	MRPT_START
+
+	if (!open(fileName))
+		THROW_EXCEPTION_CUSTOM_MSG1( "Error trying to open or map file: '%s'",fileName.c_str() );
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+							Constructor
+ ---------------------------------------------------------------*/
+CFileMMapInputStream::CFileMMapInputStream() : m_region(), m_pos(0)
+{
+}
+
+/*---------------------------------------------------------------
+							Destructor
+ ---------------------------------------------------------------*/
+CFileMMapInputStream::~CFileMMapInputStream()
+{
+	close();
+}
+
+/*---------------------------------------------------------------
+							open
+ ---------------------------------------------------------------*/
+bool CFileMMapInputStream::open( const string &fileName )
+{
+	close();
+
+	CMemoryMappedRegion *region = new CMemoryMappedRegion();
+	if (!region->mapFile(fileName))
+	{
+		delete region;
+		return false;
+	}
+	m_region = CMemoryMappedRegionPtr(region);
+	return true;
+}
+
+/*---------------------------------------------------------------
+							close
+ ---------------------------------------------------------------*/
+void CFileMMapInputStream::close()
+{
+	// Objects that borrowed memory from the file keep their own reference to it:
+	m_region.clear_unique();
+	m_pos = 0;
+}
+
+/*---------------------------------------------------------------
+							Read
+			Reads bytes from the stream into Buffer
+ ---------------------------------------------------------------*/
+size_t  CFileMMapInputStream::Read(void *Buffer, size_t Count)
+{
+	if (!m_region.present())
+		THROW_EXCEPTION("File is not open.");
+
+	const size_t n = std::min(Count, m_region->size()-m_pos);
+	if (n)
+	{
+		::memcpy(Buffer, static_cast<const char*>(m_region->data())+m_pos, n);
+		m_pos+=n;
+	}
+	return n;
+}
+
+/*---------------------------------------------------------------
+							Write
+ ---------------------------------------------------------------*/
+size_t  CFileMMapInputStream::Write(const void *, size_t)
+{
+	THROW_EXCEPTION("Trying to write to a read file stream.");
+}
+
+/*---------------------------------------------------------------
+							ReadBufferBorrow
+ ---------------------------------------------------------------*/
+const void * CFileMMapInputStream::ReadBufferBorrow(size_t Count, CMemoryMappedRegionPtr &owner)
+{
+	if (!m_region.present())
+		THROW_EXCEPTION("File is not open.");
+	if (Count>m_region->size()-m_pos)
+		THROW_EXCEPTION_CUSTOM_MSG1("Cannot read requested number of bytes from stream: only %u left (EOF?)",static_cast<unsigned int>(m_region->size()-m_pos));
+
+	const void *ptr = static_cast<const char*>(m_region->data())+m_pos;
+	m_pos+=Count;
+	owner = m_region;
+	return ptr;
+}
+
+/*---------------------------------------------------------------
+							Seek
+	Method for moving to a specified position in the streamed resource.
+	 See documentation of CStream::Seek
+ ---------------------------------------------------------------*/
+uint64_t CFileMMapInputStream::Seek(uint64_t Offset, CStream::TSeekOrigin Origin)
+{
+	if (!m_region.present())
+		THROW_EXCEPTION("File is not open.");
+
+	int64_t newPos = 0;
+	switch (Origin)
+	{
+		case sFromBeginning: newPos = Offset; break;
+		case sFromCurrent:   newPos = static_cast<int64_t>(m_pos) + static_cast<int64_t>(Offset); break;
+		case sFromEnd:       newPos = static_cast<int64_t>(m_region->size()) + static_cast<int64_t>(Offset); break;
+	};
+
+	if (newPos<0 || newPos>static_cast<int64_t>(m_region->size()))
+		THROW_EXCEPTION("Out of bounds seek: beyond the end of the file");
+
+	m_pos = static_cast<size_t>(newPos);
+	return m_pos;
+}
+
+/*---------------------------------------------------------------
+						getTotalBytesCount
+ ---------------------------------------------------------------*/
+uint64_t CFileMMapInputStream::getTotalBytesCount()
+{
+	return m_region.present() ? m_region->size() : 0;
+}
+
+/*---------------------------------------------------------------
+						getPosition
+ ---------------------------------------------------------------*/
+uint64_t CFileMMapInputStream::getPosition()
+{
+	return m_pos;
+}
@@ -0,0 +1,115 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/CFileMMapInputStream.h>
+#include <mrpt/utils/CFileOutputStream.h>
+#include <mrpt/utils/CCopyOnWriteGrid.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace std;
+
+TEST(CFileMMapInputStream, ReadAndSeek)
+{
+	const string fil = mrpt::system::getTempFileName();
+	std::vector<float> data(1000);
+	for (size_t i=0;i<data.size();i++) data[i] = 0.5f*i;
+	{
+		CFileOutputStream out(fil);
+		out << std::string("header") << static_cast<uint32_t>(data.size());
+		out.WriteBufferFixEndianness(&data[0],data.size());
+	}
+
+	CFileMMapInputStream in(fil);
+	EXPECT_EQ(in.getTotalBytesCount(), mrpt::system::getFileSize(fil));
+
+	std::string hdr;
+	uint32_t n;
+	in >> hdr >> n;
+	EXPECT_EQ(hdr,"header");
+	ASSERT_EQ(n,data.size());
+
+	const uint64_t pos = in.getPosition();
+	std::vector<float> readback(n);
+	in.ReadBufferFixEndianness(&readback[0],n);
+	EXPECT_TRUE(readback==data);
+	EXPECT_TRUE(in.checkEOF());
+
+	// No more data:
+	float dummy;
+	EXPECT_THROW(in.ReadBuffer(&dummy,sizeof(dummy)), std::exception);
+
+	// Seek and borrow the data instead of copying it:
+	in.Seek(pos);
+	CMemoryMappedRegionPtr owner;
+	const float *ptr = static_cast<const float*>( in.ReadBufferBorrow(n*sizeof(float),owner) );
+	ASSERT_TRUE(ptr!=NULL);
+	EXPECT_TRUE(owner.present());
+	EXPECT_EQ(in.getPosition(), pos+n*sizeof(float));
+	EXPECT_EQ(0, memcmp(ptr,&data[0],n*sizeof(float)));
+
+	// Borrowed memory remains valid after closing the stream:
+	in.close();
+	EXPECT_FALSE(in.fileOpenCorrectly());
+	EXPECT_EQ(ptr[n-1],data[n-1]);
+
+	// Streams without memory of their own don't lend it:
+	{
+		CFileOutputStream out2(fil+".2");
+		CMemoryMappedRegionPtr owner2;
+		EXPECT_TRUE(out2.ReadBufferBorrow(1,owner2)==NULL);
+	}
+	owner.clear();
+
+	remove(fil.c_str());
+	remove((fil+".2").c_str());
+}
+
+TEST(CFileMMapInputStream, BorrowedGridRows)
+{
+	const string fil = mrpt::system::getTempFileName();
+	const size_t NC = 7, NR = 5;
+	std::vector<int16_t> cells(NC*NR);
+	for (size_t i=0;i<cells.size();i++) cells[i] = int16_t(i);
+	{
+		CFileOutputStream out(fil);
+		out.WriteBuffer(&cells[0],cells.size()*sizeof(cells[0]));
+	}
+
+	CCopyOnWriteGrid<int16_t> g, g2;
+	{
+		CFileMMapInputStream in(fil);
+		CMemoryMappedRegionPtr owner;
+		const void *ptr = in.ReadBufferBorrow(cells.size()*sizeof(cells[0]),owner);
+		ASSERT_TRUE(ptr!=NULL);
+		g.assignBorrowed(NC,NR,static_cast<const int16_t*>(ptr),owner);
+	}
+	EXPECT_EQ(g.getBorrowedRowCount(),NR);
+
+	g2 = g;
+	g.cellForWrite(3,2) = -1;   // Copies only row #2
+	EXPECT_EQ(g.getBorrowedRowCount(),NR-1);
+	EXPECT_EQ(g2.getBorrowedRowCount(),NR);
+
+	for (size_t y=0;y<NR;y++)
+		for (size_t x=0;x<NC;x++)
+		{
+			EXPECT_EQ(g(x,y), (x==3 && y==2) ? -1 : cells[x+y*NC]);
+			EXPECT_EQ(g2(x,y), cells[x+y*NC]);
+		}
+
+	// Releasing the last reference unmaps the file:
+	g.clear();
+	g2.resize(1,1);
+	EXPECT_EQ(g2.getBorrowedRowCount(),0u);
+
+	remove(fil.c_str());
+}
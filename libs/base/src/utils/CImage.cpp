@@ -22,6 +22,7 @@
 #include <mrpt/utils/CTicTac.h>
 #include <mrpt/utils/CTimeLogger.h>
 #include <mrpt/system/memory.h>
+#include <mrpt/system/CGenericMemoryPool.h>
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h>
@@ -56,6 +57,32 @@ std::string CImage::IMAGES_PATH_BASE(".");
 mrpt::utils::CTimeLogger alloc_tims;
 #endif
 
+#if MRPT_HAS_OPENCV
+// Memory pool of IplImage's, so images of the same size which are created and destroyed
+//  at a high rate (e.g. grabbed by cameras, or read from a rawlog) reuse their buffers:
+namespace
+{
+	struct TIplImagePoolParams
+	{
+		int width, height, nChannels, depth;
+
+		inline bool isSuitable(const TIplImagePoolParams &req) const {
+			return width==req.width && height==req.height && nChannels==req.nChannels && depth==req.depth;
+		}
+	};
+	struct TIplImagePoolData
+	{
+		IplImage *img;
+
+		TIplImagePoolData() : img(NULL) { }
+		~TIplImagePoolData() { if (img) cvReleaseImage(&img); }
+	};
+	typedef mrpt::system::CGenericMemoryPool<TIplImagePoolParams,TIplImagePoolData> TIplImagePool;
+
+	const size_t IPL_IMAGE_POOL_MAX_ENTRIES = 10;
+}
+#endif
+
 
 /*---------------------------------------------------------------
 						Constructor
@@ -268,7 +295,25 @@ void  CImage::changeSize(
 	alloc_tims.enter(sLog.c_str());
 #	endif
 
-	img = cvCreateImage( cvSize(width,height),IPL_DEPTH_8U, nChannels );
+	// Reuse an image from the pool, if any:
+	TIplImagePool *pool = TIplImagePool::getInstance(IPL_IMAGE_POOL_MAX_ENTRIES);
+	if (pool)
+	{
+		TIplImagePoolParams params;
+		params.width = width;
+		params.height = height;
+		params.nChannels = nChannels;
+		params.depth = IPL_DEPTH_8U;
+		TIplImagePoolData *block = pool->request_memory(params);
+		if (block)
+		{
+			img = block->img;
+			block->img = NULL;
+			delete block;
+		}
+	}
+	if (!img)
+		img = cvCreateImage( cvSize(width,height),IPL_DEPTH_8U, nChannels );
 	((IplImage*)img)->origin = originTopLeft ? 0:1;
 
 #	if IMAGE_ALLOC_PERFLOG
@@ -688,9 +733,16 @@ void  CImage::readFromStream(CStream &in, int version)
 			uint32_t			nBytes;
 			in >> nBytes;
 
-			aux.changeSize( nBytes + 10 );
-
-			in.ReadBuffer( aux.getRawBufferData(), nBytes );
+			// Decode directly from the memory of the input stream, if it allows so (e.g. memory-mapped files):
+			CMemoryMappedRegionPtr	borrowedOwner;
+			const void *borrowed = in.ReadBufferBorrow(nBytes, borrowedOwner);
+			if (borrowed)
+				aux.assignMemoryNotOwn(borrowed, nBytes);
+			else
+			{
+				aux.changeSize( nBytes + 10 );
+				in.ReadBuffer( aux.getRawBufferData(), nBytes );
+			}
 
 			aux.Seek(0);
 
@@ -822,8 +874,15 @@ void  CImage::readFromStream(CStream &in, int version)
 						CMemoryStream		aux;
 						uint32_t			nBytes;
 						in >> nBytes;
-						aux.changeSize( nBytes + 10 );
-						in.ReadBuffer( aux.getRawBufferData(), nBytes );
+						CMemoryMappedRegionPtr	borrowedOwner;
+						const void *borrowed = in.ReadBufferBorrow(nBytes, borrowedOwner);
+						if (borrowed)
+							aux.assignMemoryNotOwn(borrowed, nBytes);
+						else
+						{
+							aux.changeSize( nBytes + 10 );
+							in.ReadBuffer( aux.getRawBufferData(), nBytes );
+						}
 						aux.Seek(0);
 						loadFromStreamAsJPEG( aux );
 					}
@@ -1918,7 +1977,22 @@ void CImage::releaseIpl(bool thisIsExternalImgUnload) MRPT_NO_THROWS
     if (img && !m_imgIsReadOnly)
     {
 		IplImage *ptr=(IplImage*)img;
-	    cvReleaseImage( &ptr );
+		// Give plain images (without ROI, etc.) to the pool instead of freeing them:
+		TIplImagePool *pool = (!ptr->roi && !ptr->maskROI && ptr->imageData==ptr->imageDataOrigin) ?
+			TIplImagePool::getInstance(IPL_IMAGE_POOL_MAX_ENTRIES) : NULL;
+		if (pool)
+		{
+			TIplImagePoolParams params;
+			params.width = ptr->width;
+			params.height = ptr->height;
+			params.nChannels = ptr->nChannels;
+			params.depth = ptr->depth;
+			TIplImagePoolData *block = new TIplImagePoolData();
+			block->img = ptr;
+			pool->dump_to_pool(params,block);
+		}
+		else
+			cvReleaseImage( &ptr );
     }
 	img = NULL;
 	m_imgIsReadOnly = false;
@@ -0,0 +1,59 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/CLRUCache.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace std;
+
+TEST(CLRUCache, EvictsLeastRecentlyUsed)
+{
+	CLRUCache<int,std::string> cache(100);
+	cache.insert(1,"a",40);
+	cache.insert(2,"b",40);
+	EXPECT_EQ(cache.size(),2u);
+	EXPECT_EQ(cache.getCurrentBytes(),80u);
+
+	std::string v;
+	EXPECT_TRUE(cache.get(1,v));   // Now "2" is the least recently used
+	EXPECT_EQ(v,"a");
+
+	cache.insert(3,"c",40);
+	EXPECT_TRUE(cache.contains(1));
+	EXPECT_FALSE(cache.contains(2));
+	EXPECT_TRUE(cache.contains(3));
+	EXPECT_FALSE(cache.get(2,v));
+	EXPECT_EQ(cache.getCurrentBytes(),80u);
+
+	EXPECT_EQ(cache.getStats().hits,1u);
+	EXPECT_EQ(cache.getStats().misses,1u);
+	EXPECT_EQ(cache.getStats().evictions,1u);
+
+	// Replacing an item updates its size:
+	cache.insert(3,"cc",10);
+	EXPECT_EQ(cache.getCurrentBytes(),50u);
+	EXPECT_TRUE(cache.get(3,v));
+	EXPECT_EQ(v,"cc");
+
+	// Items larger than the whole cache are not kept:
+	cache.insert(4,"d",101);
+	EXPECT_FALSE(cache.contains(4));
+	EXPECT_EQ(cache.size(),2u);
+
+	// Shrinking the cache discards the oldest ones:
+	cache.setMaxBytes(20);
+	EXPECT_EQ(cache.size(),1u);
+	EXPECT_TRUE(cache.contains(3));
+
+	cache.clear();
+	EXPECT_EQ(cache.size(),0u);
+	EXPECT_EQ(cache.getCurrentBytes(),0u);
+}
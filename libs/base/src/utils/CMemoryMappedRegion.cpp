@@ -0,0 +1,126 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>  // Precompiled headers
+
+#include <mrpt/utils/CMemoryMappedRegion.h>
+
+#ifdef MRPT_OS_WINDOWS
+	#include <windows.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+using namespace mrpt::utils;
+using namespace std;
+
+/*---------------------------------------------------------------
+							Constructor
+ ---------------------------------------------------------------*/
+CMemoryMappedRegion::CMemoryMappedRegion() :
+	m_data(NULL),
+	m_size(0),
+	m_is_mapped(false)
+#ifdef MRPT_OS_WINDOWS
+	,m_hFile(INVALID_HANDLE_VALUE),
+	m_hMapping(NULL)
+#endif
+{
+}
+
+/*---------------------------------------------------------------
+							Destructor
+ ---------------------------------------------------------------*/
+CMemoryMappedRegion::~CMemoryMappedRegion()
+{
+	unmap();
+}
+
+/*---------------------------------------------------------------
+							mapFile
+ ---------------------------------------------------------------*/
+bool CMemoryMappedRegion::mapFile(const std::string &fileName)
+{
+	unmap();
+
+#ifdef MRPT_OS_WINDOWS
+	m_hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_hFile==INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_hFile,&fileSize) || static_cast<uint64_t>(fileSize.QuadPart)>static_cast<uint64_t>((std::numeric_limits<size_t>::max)()))
+	{
+		unmap();
+		return false;
+	}
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+
+	if (m_size)
+	{
+		m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0,0, NULL);
+		if (!m_hMapping) { unmap(); return false; }
+
+		m_data = MapViewOfFile(m_hMapping, FILE_MAP_READ, 0,0, 0);
+		if (!m_data) { unmap(); return false; }
+	}
+#else
+	const int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd<0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd,&st)!=0 || static_cast<uint64_t>(st.st_size)>static_cast<uint64_t>((std::numeric_limits<size_t>::max)()))
+	{
+		::close(fd);
+		return false;
+	}
+	m_size = static_cast<size_t>(st.st_size);
+
+	if (m_size)
+	{
+		void *ptr = ::mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr==MAP_FAILED)
+		{
+			::close(fd);
+			m_size = 0;
+			return false;
+		}
+		m_data = ptr;
+	}
+	// The mapping keeps its own reference to the file:
+	::close(fd);
+#endif
+
+	m_is_mapped = true;
+	return true;
+}
+
+/*---------------------------------------------------------------
+							unmap
+ ---------------------------------------------------------------*/
+void CMemoryMappedRegion::unmap()
+{
+#ifdef MRPT_OS_WINDOWS
+	if (m_data)      UnmapViewOfFile(m_data);
+	if (m_hMapping)  CloseHandle(m_hMapping);
+	if (m_hFile!=INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+	m_hMapping = NULL;
+	m_hFile = INVALID_HANDLE_VALUE;
+#else
+	if (m_data)      ::munmap(m_data,m_size);
+#endif
+	m_data = NULL;
+	m_size = 0;
+	m_is_mapped = false;
+}
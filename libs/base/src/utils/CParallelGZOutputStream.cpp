@@ -0,0 +1,386 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/base.h>  // Precompiled headers
+
+#include <mrpt/utils/CParallelGZOutputStream.h>
+#include <mrpt/utils/CFileOutputStream.h>
+#include <mrpt/utils/CTicTac.h>
+#include <mrpt/synch/CSemaphore.h>
+#include <mrpt/synch/CCriticalSection.h>
+#include <mrpt/system/threads.h>
+#include <mrpt/system/parallelization.h>
+
+#include <zlib.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::synch;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	const size_t DEFLATE_DICT_SIZE = 32*1024;  //!< The max. distance of deflate back-references
+
+	/** One block of data, from the user to the file */
+	struct TBlock
+	{
+		TBlock() : last(false), crc(0), done(0,1) { }
+
+		std::vector<unsigned char>  in;    //!< Uncompressed data
+		std::vector<unsigned char>  dict;  //!< The tail of the previous block (empty for the first one)
+		std::vector<unsigned char>  out;   //!< Raw deflate data
+		bool            last;  //!< The last block of the stream
+		uLong           crc;   //!< CRC-32 of "in"
+		std::string     error; //!< Empty, or the description of an error compressing the block
+		CSemaphore      done;  //!< Signaled once compressed
+	};
+
+	/** Compresses one block as a piece of a raw deflate stream: byte-aligned with an empty stored block at the end (Z_SYNC_FLUSH),
+	  *  or terminated (Z_FINISH) if it is the last one. */
+	void deflateBlock(TBlock &b, const int level)
+	{
+		z_stream strm;
+		::memset(&strm,0,sizeof(strm));
+		if (Z_OK!=deflateInit2(&strm, level, Z_DEFLATED, -15 /* raw deflate */, 8, Z_DEFAULT_STRATEGY))
+		{
+			b.error = "deflateInit2() failed";
+			return;
+		}
+		if (!b.dict.empty())
+			deflateSetDictionary(&strm, &b.dict[0], static_cast<uInt>(b.dict.size()));
+
+		b.out.resize( deflateBound(&strm, static_cast<uLong>(b.in.size())) + 16 );
+		strm.next_in   = b.in.empty() ? NULL : &b.in[0];
+		strm.avail_in  = static_cast<uInt>(b.in.size());
+		strm.next_out  = &b.out[0];
+		strm.avail_out = static_cast<uInt>(b.out.size());
+
+		const int ret = deflate(&strm, b.last ? Z_FINISH : Z_SYNC_FLUSH);
+		if ( (b.last && ret!=Z_STREAM_END) || (!b.last && (ret!=Z_OK || strm.avail_in!=0 || strm.avail_out==0)) )
+			b.error = format("deflate() failed (error %i)",ret);
+		b.out.resize(b.out.size()-strm.avail_out);
+		deflateEnd(&strm);
+
+		b.crc = crc32(crc32(0L,Z_NULL,0), b.in.empty() ? Z_NULL : &b.in[0], static_cast<uInt>(b.in.size()));
+	}
+
+	void writeLE32(CStream &out, const uint32_t v)
+	{
+		const unsigned char buf[4] = { static_cast<unsigned char>(v), static_cast<unsigned char>(v>>8), static_cast<unsigned char>(v>>16), static_cast<unsigned char>(v>>24) };
+		out.WriteBuffer(buf,4);
+	}
+}
+
+/** The state of an open file, shared with the worker and writer threads */
+struct CParallelGZOutputStream::TImpl
+{
+	TImpl(const int level, const size_t nThreads, const size_t blockSize) :
+		compress_level(level),
+		block_size(blockSize),
+		num_threads(nThreads),
+		free_slots(2*nThreads+2, 2*nThreads+2),
+		todo_count(0,0x7FFFFFFF),
+		written_count(0,0x7FFFFFFF),
+		cur(NULL),
+		crc(crc32(0L,Z_NULL,0)),
+		total_in(0)
+	{
+	}
+
+	const int     compress_level;
+	const size_t  block_size;
+	const size_t  num_threads;
+
+	CFileOutputStream  file;
+
+	CSemaphore         free_slots;   //!< Limits the number of blocks being compressed or waiting to be written
+	CCriticalSection   cs;           //!< Protects the queues and "stats"
+	std::deque<TBlock*> todo;        //!< Blocks to be compressed. A NULL means "exit" for a worker.
+	CSemaphore         todo_count;
+	std::deque<TBlock*> to_write;    //!< Blocks in file order, to be written as soon as they are compressed. A NULL means "exit" for the writer.
+	CSemaphore         written_count;
+	std::string        error;        //!< Empty, or the first error found by any thread
+
+	TBlock            *cur;          //!< The block being filled by Write() (only accessed by the user thread)
+	uLong              crc;          //!< CRC-32 of all the data written so far (only accessed by the writer thread)
+	uint64_t           total_in;     //!< Only accessed by the writer thread
+	TStats             stats;
+
+	std::vector<TThreadHandle>  threads;
+
+	void setError(const std::string &msg)
+	{
+		CCriticalSectionLocker lock(&cs);
+		if (error.empty()) error = msg;
+	}
+
+	/** Hands the current block over to the workers and starts a new one, unless this is the last one */
+	void submitCurrent(const bool isLast)
+	{
+		TBlock *b = cur;
+		b->last = isLast;
+
+		// Backpressure: wait if there are too many blocks in the pipeline:
+		if (!free_slots.waitForSignal(1))
+		{
+			CTicTac tictac;
+			tictac.Tic();
+			free_slots.waitForSignal();
+			CCriticalSectionLocker lock(&cs);
+			stats.stalls++;
+			stats.stall_time += tictac.Tac();
+		}
+
+		cur = NULL;
+		if (!isLast)
+		{
+			cur = new TBlock;
+			cur->in.reserve(block_size);
+			// The next block uses the tail of this one as dictionary:
+			const size_t nDict = std::min(DEFLATE_DICT_SIZE,b->in.size());
+			cur->dict.assign(b->in.end()-nDict, b->in.end());
+		}
+
+		{
+			CCriticalSectionLocker lock(&cs);
+			todo.push_back(b);
+			to_write.push_back(b);
+			stats.blocks++;
+			stats.bytes_in += b->in.size();
+			stats.max_pending = std::max(stats.max_pending, to_write.size());
+		}
+		todo_count.release();
+		written_count.release();
+	}
+
+	static void threadCompress(TImpl *d)
+	{
+		for (;;)
+		{
+			d->todo_count.waitForSignal();
+			TBlock *b;
+			{
+				CCriticalSectionLocker lock(&d->cs);
+				b = d->todo.front();
+				d->todo.pop_front();
+			}
+			if (!b) return;
+			deflateBlock(*b,d->compress_level);
+			b->done.release();
+		}
+	}
+
+	static void threadWrite(TImpl *d)
+	{
+		for (;;)
+		{
+			d->written_count.waitForSignal();
+			TBlock *b;
+			{
+				CCriticalSectionLocker lock(&d->cs);
+				b = d->to_write.front();
+				d->to_write.pop_front();
+			}
+			if (!b) return;
+
+			b->done.waitForSignal();
+			if (!b->error.empty())
+				d->setError(b->error);
+			else
+			{
+				try
+				{
+					if (!b->out.empty())
+						d->file.WriteBuffer(&b->out[0],b->out.size());
+					d->crc = crc32_combine(d->crc, b->crc, static_cast<z_off_t>(b->in.size()));
+					d->total_in += b->in.size();
+					CCriticalSectionLocker lock(&d->cs);
+					d->stats.bytes_out += b->out.size();
+				}
+				catch (std::exception &e)
+				{
+					d->setError(e.what());
+				}
+			}
+			delete b;
+			d->free_slots.release();
+		}
+	}
+};
+
+/*---------------------------------------------------------------
+						TStats
+ ---------------------------------------------------------------*/
+CParallelGZOutputStream::TStats::TStats() :
+	bytes_in(0), bytes_out(0), blocks(0), stalls(0), stall_time(0), max_pending(0)
+{
+}
+
+CParallelGZOutputStream::CParallelGZOutputStream() : m_impl(NULL)
+{
+}
+
+CParallelGZOutputStream::CParallelGZOutputStream(const std::string &fileName) : m_impl(NULL)
+{
+	MRPT_START
+	if (!open(fileName))
+		THROW_EXCEPTION_CUSTOM_MSG1( "Error trying to open file: '%s'",fileName.c_str() );
+	MRPT_END
+}
+
+CParallelGZOutputStream::~CParallelGZOutputStream()
+{
+	try
+	{
+		close();
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "[~CParallelGZOutputStream] " << e.what() << std::endl;
+	}
+}
+
+/*---------------------------------------------------------------
+							open
+ ---------------------------------------------------------------*/
+bool CParallelGZOutputStream::open(const std::string &fileName, int compress_level, unsigned int num_threads, size_t block_size)
+{
+	MRPT_START
+	close();
+	ASSERT_(block_size>0 && compress_level>=0 && compress_level<=9)
+
+	const size_t nThreads = num_threads ? num_threads : std::max(1U,getParallelizationThreadsCount());
+	TImpl *d = new TImpl(compress_level,nThreads,block_size);
+	if (!d->file.open(fileName))
+	{
+		delete d;
+		return false;
+	}
+
+	// gzip header (RFC 1952): magic, deflate, no flags, no mtime, no extra flags, unknown OS
+	const unsigned char header[10] = { 0x1f,0x8b, 8, 0, 0,0,0,0, 0, 0xff };
+	d->file.WriteBuffer(header,sizeof(header));
+	d->stats.bytes_out = sizeof(header);
+
+	d->cur = new TBlock;
+	d->cur->in.reserve(block_size);
+
+	for (size_t i=0;i<nThreads;i++)
+		d->threads.push_back( createThread(&TImpl::threadCompress, d) );
+	d->threads.push_back( createThread(&TImpl::threadWrite, d) );
+
+	m_impl = d;
+	return true;
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+							close
+ ---------------------------------------------------------------*/
+void CParallelGZOutputStream::close()
+{
+	if (!m_impl) return;
+	TImpl *d = m_impl;
+	m_impl = NULL;
+
+	// The last block (possibly empty) terminates the deflate stream:
+	d->submitCurrent(true);
+
+	// Stop the threads once they have processed all the blocks:
+	{
+		CCriticalSectionLocker lock(&d->cs);
+		for (size_t i=0;i<d->num_threads;i++)
+			d->todo.push_back(NULL);
+		d->to_write.push_back(NULL);
+	}
+	d->todo_count.release(d->num_threads);
+	d->written_count.release();
+	for (size_t i=0;i<d->threads.size();i++)
+		joinThread(d->threads[i]);
+
+	// gzip trailer: CRC-32 and uncompressed size (modulo 2^32)
+	std::string error = d->error;
+	if (error.empty())
+	{
+		try
+		{
+			writeLE32(d->file, static_cast<uint32_t>(d->crc));
+			writeLE32(d->file, static_cast<uint32_t>(d->total_in));
+			d->stats.bytes_out += 8;
+		}
+		catch (std::exception &e)
+		{
+			error = e.what();
+		}
+	}
+	d->file.close();
+
+	m_last_stats = d->stats;
+	delete d;
+
+	if (!error.empty())
+		THROW_EXCEPTION_CUSTOM_MSG1("Error writing compressed file: %s",error.c_str())
+}
+
+/*---------------------------------------------------------------
+							Read
+ ---------------------------------------------------------------*/
+size_t CParallelGZOutputStream::Read(void *Buffer, size_t Count)
+{
+	THROW_EXCEPTION("Trying to read from an output file stream.");
+}
+
+/*---------------------------------------------------------------
+							Write
+ ---------------------------------------------------------------*/
+size_t CParallelGZOutputStream::Write(const void *Buffer, size_t Count)
+{
+	if (!m_impl) { THROW_EXCEPTION("File is not open."); }
+	TImpl *d = m_impl;
+	{
+		CCriticalSectionLocker lock(&d->cs);
+		if (!d->error.empty())
+			THROW_EXCEPTION_CUSTOM_MSG1("Error writing compressed file: %s",d->error.c_str())
+	}
+
+	const unsigned char *data = static_cast<const unsigned char*>(Buffer);
+	size_t done = 0;
+	while (done<Count)
+	{
+		std::vector<unsigned char> &in = d->cur->in;
+		const size_t n = std::min(Count-done, d->block_size-in.size());
+		in.insert(in.end(), data+done, data+done+n);
+		done += n;
+		if (in.size()==d->block_size)
+			d->submitCurrent(false);
+	}
+	return Count;
+}
+
+/*---------------------------------------------------------------
+						getPosition
+ ---------------------------------------------------------------*/
+uint64_t CParallelGZOutputStream::getPosition()
+{
+	if (!m_impl) { THROW_EXCEPTION("File is not open."); }
+	CCriticalSectionLocker lock(&m_impl->cs);
+	return m_impl->stats.bytes_in + m_impl->cur->in.size();
+}
+
+/*---------------------------------------------------------------
+						getStats
+ ---------------------------------------------------------------*/
+CParallelGZOutputStream::TStats CParallelGZOutputStream::getStats() const
+{
+	if (!m_impl) return m_last_stats;
+	CCriticalSectionLocker lock(&m_impl->cs);
+	return m_impl->stats;
+}
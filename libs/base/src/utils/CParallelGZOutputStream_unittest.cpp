@@ -0,0 +1,76 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/utils/CParallelGZOutputStream.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace std;
+
+// Write data of different lengths (including 0 and exact multiples of the block size) and read it back as a regular .gz file:
+TEST(CParallelGZOutputStream, WriteAndReadBack)
+{
+	const size_t BLOCK_SIZE = 1000;
+	const size_t lens[] = { 0, 1, BLOCK_SIZE, 3*BLOCK_SIZE, 12345, 100000 };
+
+	mrpt::random::CRandomGenerator rng(1234);
+	for (size_t k=0;k<sizeof(lens)/sizeof(lens[0]);k++)
+	{
+		// Compressible data: random runs of a few symbols
+		std::vector<unsigned char> data(lens[k]);
+		for (size_t i=0;i<data.size();i++)
+			data[i] = (i/7)%2 ? static_cast<unsigned char>(rng.drawUniform32bit()%4) : 'a'+(i%13);
+
+		const string fil = mrpt::system::getTempFileName();
+		CParallelGZOutputStream::TStats stats;
+		{
+			CParallelGZOutputStream out;
+			ASSERT_TRUE(out.open(fil,6,3,BLOCK_SIZE));
+			// Write in pieces of different sizes:
+			size_t pos = 0;
+			while (pos<data.size())
+			{
+				const size_t n = std::min(data.size()-pos, static_cast<size_t>(1+rng.drawUniform32bit()%2500));
+				out.WriteBuffer(&data[pos],n);
+				pos+=n;
+			}
+			EXPECT_EQ(out.getPosition(),data.size());
+			out.close();
+			stats = out.getStats();
+		}
+		EXPECT_EQ(stats.bytes_in,data.size());
+		EXPECT_EQ(stats.bytes_out,mrpt::system::getFileSize(fil));
+		EXPECT_EQ(stats.blocks,data.size()/BLOCK_SIZE+1);
+		if (data.size()>=10000) {
+			EXPECT_LT(stats.bytes_out,data.size()/2);
+		}
+
+		std::vector<unsigned char> readback(data.size()+10);
+		size_t nRead = 0;
+		{
+			CFileGZInputStream in(fil);
+			while (nRead<readback.size())
+			{
+				size_t n = 0;
+				try { n = in.ReadBuffer(&readback[nRead],readback.size()-nRead); }
+				catch (std::exception &) { break; } // EOF
+				nRead+=n;
+			}
+		}
+		EXPECT_EQ(nRead,data.size());
+		readback.resize(nRead);
+		EXPECT_TRUE(readback==data) << "Length: " << data.size();
+
+		remove(fil.c_str());
+	}
+}
@@ -20,6 +20,7 @@
 
 #include <mrpt/hmtslam/CTopLCDetector_GridMatching.h>
 #include <mrpt/hmtslam/CTopLCDetector_FabMap.h>
+#include <mrpt/hmtslam/CTopLCDetector_BoW.h>
 
 #include <mrpt/hmtslam/link_pragmas.h>
 
@@ -76,6 +77,7 @@ namespace mrpt
 			friend class HMTSLAM_IMPEXP CLSLAM_RBPF_2DLASER;
 			friend class HMTSLAM_IMPEXP CTopLCDetector_GridMatching;
 			friend class HMTSLAM_IMPEXP CTopLCDetector_FabMap;
+			friend class HMTSLAM_IMPEXP CTopLCDetector_BoW;
 
 			// This must be added to any CSerializable derived class:
 			DEFINE_SERIALIZABLE( CHMTSLAM )
@@ -471,11 +473,13 @@ namespace mrpt
 				/** A list of topological loop-closure detectors to use: can be one or more from this list:
 				  *  'gridmaps': Occupancy Grid matching.
 				  *  'fabmap': Mark Cummins' image matching framework.
+				  *  'bow': Image matching through a bag-of-words vocabulary tree and inverted files (see CTopLCDetector_BoW).
 				  */
 				vector_string				TLC_detectors;
 
 				CTopLCDetector_GridMatching::TOptions	TLC_grid_options;	//!< Options passed to this TLC constructor
 				CTopLCDetector_FabMap::TOptions	TLC_fabmap_options;	//!< Options passed to this TLC constructor
+				CTopLCDetector_BoW::TOptions	TLC_bow_options;	//!< Options passed to this TLC constructor
 
 			} m_options;
 
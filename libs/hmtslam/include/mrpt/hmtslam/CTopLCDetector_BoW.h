@@ -0,0 +1,107 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef _CTopLCDetector_BoW_H
+#define _CTopLCDetector_BoW_H
+
+#include <mrpt/hmtslam/CTopLCDetectorBase.h>
+#include <mrpt/vision/CVocabularyTree.h>
+#include <mrpt/vision/CBoWDatabase.h>
+#include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/synch/CCriticalSection.h>
+
+namespace mrpt
+{
+	namespace hmtslam
+	{
+		/** A topological loop-closure detector based on the appearance of the images of each pose, as bags of visual words (see mrpt::vision::CVocabularyTree).
+		  *  The features of each image (CObservationImage, or the left image of CObservationStereoImages) are converted into a bag-of-words vector
+		  *  and stored in a mrpt::vision::CBoWDatabase. The likelihood of two areas being the same one is computed from the best similarity score
+		  *  between the images of their poses, which are found through the inverted files of the database instead of comparing all the pairs of images.
+		  *
+		  *  The vocabulary must be trained offline (e.g. with the application "bow-vocabulary-train") for the same kind of features and descriptors.
+		  *  This detector does not estimate the relative pose between the areas.
+		  *
+		  * \ingroup mrpt_hmtslam_grp
+		  */
+		class CTopLCDetector_BoW : public CTopLCDetectorBase
+		{
+		protected:
+			CTopLCDetector_BoW( CHMTSLAM *hmtslam );
+
+		public:
+			/** A class factory, to be implemented in derived classes.
+			  */
+			static CTopLCDetectorBase* createNewInstance( CHMTSLAM *hmtslam )
+			{
+				return static_cast<CTopLCDetectorBase*>(new CTopLCDetector_BoW(hmtslam));
+			}
+
+			/** Destructor */
+			virtual ~CTopLCDetector_BoW();
+
+			/** Forgets the images of all the poses */
+			void reset();
+
+			/** This method must compute the topological observation model.
+			  * \param out_log_lik The output, a log-likelihood.
+			  * \return NULL (empty smart pointer), since this detector does not estimate the relative pose between the areas.
+			  */
+			CPose3DPDFPtr computeTopologicalObservationModel(
+				const THypothesisID		&hypID,
+				const CHMHMapNodePtr	&currentArea,
+				const CHMHMapNodePtr	&refArea,
+				double					&out_log_lik
+				 );
+
+			/** Hook method for being warned about the insertion of a new poses into the maps.
+			  *  This should be independent of hypothesis IDs.
+			  */
+			void OnNewPose(
+				const TPoseID 			&poseID,
+				const CSensoryFrame		*SF );
+
+
+			/** Options for a TLC-detector of type bag-of-words, used from CHMTSLAM
+			  */
+			struct TOptions : public utils::CLoadableOptions
+			{
+				/** Initialization of default params
+				  */
+				TOptions();
+
+				/** Load parameters from configuration source
+				  */
+				void  loadFromConfigFile(
+					const mrpt::utils::CConfigFileBase	&source,
+					const std::string		&section);
+
+				/** This method must display clearly all the contents of the structure in textual form, sending it to a CStream.
+				  */
+				void  dumpToTextStream(CStream	&out) const;
+
+				std::string		vocabulary_file;   //!< A mrpt::vision::CVocabularyTree, saved to a (possibly gz-compressed) file
+				mrpt::vision::CFeatureExtraction::TOptions  feature_options; //!< The features to detect in the images (Default: FASTER-9 corners), whose descriptors (of the kind of the vocabulary) are computed next. They must be those used to train the vocabulary.
+				unsigned int	nFeatures;         //!< Number of features to detect in each image (Default=500)
+				unsigned int	maxCandidates;     //!< Number of most similar images looked up in the database for each image of the current area (Default=20)
+				double			score_unrelated;   //!< The typical similarity score between images of different places (Default=0.02): a higher score between two areas increases their log-likelihood, a lower one decreases it
+			};
+
+		private:
+			mrpt::vision::CVocabularyTree  m_voc;
+			mrpt::vision::CBoWDatabase     m_db;
+			std::vector<TPoseID>           m_entry_poses;   //!< The pose of each entry of the database
+			std::map<TPoseID, std::vector<size_t> > m_pose_entries; //!< The entries of each pose (one per image)
+			mrpt::synch::CCriticalSection  m_cs;            //!< Protects the database, since OnNewPose() and computeTopologicalObservationModel() may be invoked from different HMT-SLAM threads
+
+		}; // end class
+	} // end namespace
+} // end namespace
+
+
+#endif
@@ -0,0 +1,180 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/hmtslam.h> // Precomp header
+
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/slam/CObservationImage.h>
+#include <mrpt/slam/CObservationStereoImages.h>
+
+using namespace mrpt;
+using namespace mrpt::utils;
+using namespace mrpt::synch;
+using namespace mrpt::slam;
+using namespace mrpt::vision;
+using namespace mrpt::hmtslam;
+using namespace std;
+
+CTopLCDetector_BoW::CTopLCDetector_BoW(CHMTSLAM *hmtslam) :
+	CTopLCDetectorBase(hmtslam)
+{
+	// Use already loaded options:
+	const CTopLCDetector_BoW::TOptions &o = m_hmtslam->m_options.TLC_bow_options;
+
+	if (o.vocabulary_file.empty())
+		THROW_EXCEPTION("The option 'vocabulary_file' must be set to use the bag-of-words detector.")
+	if (!mrpt::system::fileExists(o.vocabulary_file))
+		THROW_EXCEPTION_CUSTOM_MSG1("Vocabulary file not found: %s", o.vocabulary_file.c_str() )
+
+	CFileGZInputStream f(o.vocabulary_file);
+	f >> m_voc;
+	ASSERTMSG_(!m_voc.empty(), "The vocabulary file has an empty vocabulary")
+}
+
+CTopLCDetector_BoW::~CTopLCDetector_BoW()
+{
+}
+
+void CTopLCDetector_BoW::reset()
+{
+	CCriticalSectionLocker lock(&m_cs);
+	m_db.clear();
+	m_entry_poses.clear();
+	m_pose_entries.clear();
+}
+
+/** This method must compute the topological observation model.
+  * \param out_log_lik The output, a log-likelihood.
+  * \return NULL, or a PDF of the estimated translation between the two areas (can be a multi-modal PDF).
+  */
+CPose3DPDFPtr CTopLCDetector_BoW::computeTopologicalObservationModel(
+	const THypothesisID		&hypID,
+	const CHMHMapNodePtr	&currentArea,
+	const CHMHMapNodePtr	&refArea,
+	double					&out_log_lik
+	)
+{
+	out_log_lik = 0;  // If the poses are unknown, or have no images, nothing to say.
+
+	const CTopLCDetector_BoW::TOptions &o = m_hmtslam->m_options.TLC_bow_options;
+
+	CRobotPosesGraphPtr curPoses = currentArea->m_annotations.getAs<CRobotPosesGraph>(NODE_ANNOTATION_POSES_GRAPH, hypID);
+	CRobotPosesGraphPtr refPoses = refArea->m_annotations.getAs<CRobotPosesGraph>(NODE_ANNOTATION_POSES_GRAPH, hypID);
+	if (!curPoses || !refPoses || curPoses->empty() || refPoses->empty())
+		return CPose3DPDFPtr();
+
+	CCriticalSectionLocker lock(&m_cs);
+
+	// The images of the current area:
+	std::vector<size_t> cur_entries;
+	for (CRobotPosesGraph::const_iterator p=curPoses->begin();p!=curPoses->end();++p)
+	{
+		std::map<TPoseID,std::vector<size_t> >::const_iterator e = m_pose_entries.find(p->first);
+		if (e!=m_pose_entries.end())
+			cur_entries.insert(cur_entries.end(),e->second.begin(),e->second.end());
+	}
+	if (cur_entries.empty())
+		return CPose3DPDFPtr();
+
+	// The best similarity between an image of the current area and one of the reference area, among the most similar
+	//  images in the database to each one of the current area (asking for more, since those of the current area are also found):
+	double best = 0;
+	std::vector<size_t> ids;
+	std::vector<double> scores;
+	for (size_t i=0;i<cur_entries.size();i++)
+	{
+		m_db.query(m_db.getEntry(cur_entries[i]),o.maxCandidates+cur_entries.size(),ids,scores);
+		for (size_t k=0;k<ids.size() && scores[k]>best;k++)
+			if (refPoses->find(m_entry_poses[ids[k]])!=refPoses->end())
+				best = scores[k];
+	}
+
+	// Areas with images more similar than those of unrelated places are more likely to be the same one:
+	out_log_lik = std::log( (best + 0.1*o.score_unrelated) / o.score_unrelated );
+
+	m_hmtslam->printf_debug("[TLCD_bow] Areas %i-%i: best image score=%f -> log_lik=%f\n",(int)currentArea->getID(),(int)refArea->getID(),best,out_log_lik);
+
+	return CPose3DPDFPtr();
+}
+
+/** Hook method for being warned about the insertion of a new poses into the maps.
+  *  This should be independent of hypothesis IDs.
+  */
+void CTopLCDetector_BoW::OnNewPose(
+	const TPoseID 			&poseID,
+	const CSensoryFrame		*SF )
+{
+	const CTopLCDetector_BoW::TOptions &o = m_hmtslam->m_options.TLC_bow_options;
+
+	// Monocular images, and the left one of stereo pairs:
+	std::vector<const CImage*> images;
+	for (CSensoryFrame::const_iterator it=SF->begin();it!=SF->end();++it)
+	{
+		if (IS_CLASS(*it,CObservationImage))
+			images.push_back( & CObservationImagePtr(*it)->image );
+		else if (IS_CLASS(*it,CObservationStereoImages))
+			images.push_back( & CObservationStereoImagesPtr(*it)->imageLeft );
+	}
+	if (images.empty())  return; // Not all poses must have images.
+
+	CFeatureExtraction fext;
+	fext.options = o.feature_options;
+
+	// Feature extraction is done out of the critical section:
+	std::vector<TBoWVector> bows(images.size());
+	for (size_t i=0;i<images.size();i++)
+	{
+		CFeatureList feats;
+		fext.detectFeatures(*images[i],feats,0,o.nFeatures);
+		fext.computeDescriptors(*images[i],feats,m_voc.getDescriptorType());
+		m_voc.transform(feats,bows[i]);
+	}
+
+	CCriticalSectionLocker lock(&m_cs);
+	for (size_t i=0;i<bows.size();i++)
+	{
+		const size_t id = m_db.add(bows[i]);
+		m_entry_poses.push_back(poseID);
+		m_pose_entries[poseID].push_back(id);
+	}
+}
+
+
+// Initialization
+CTopLCDetector_BoW::TOptions::TOptions() :
+	vocabulary_file(),
+	feature_options(mrpt::vision::featFASTER9),
+	nFeatures(500),
+	maxCandidates(20),
+	score_unrelated(0.02)
+{
+}
+
+//  Load parameters from configuration source
+void  CTopLCDetector_BoW::TOptions::loadFromConfigFile(
+	const mrpt::utils::CConfigFileBase	&iniFile,
+	const std::string		&section)
+{
+	MRPT_LOAD_CONFIG_VAR(vocabulary_file,string,  			iniFile, section );
+	MRPT_LOAD_CONFIG_VAR(nFeatures,int,  			iniFile, section );
+	MRPT_LOAD_CONFIG_VAR(maxCandidates,int,  			iniFile, section );
+	MRPT_LOAD_CONFIG_VAR(score_unrelated,double,  			iniFile, section );
+	feature_options.loadFromConfigFile(iniFile,section);
+}
+
+//  This method must display clearly all the contents of the structure in textual form, sending it to a CStream.
+void CTopLCDetector_BoW::TOptions::dumpToTextStream(CStream &out) const	{
+	out.printf("\n----------- [CTopLCDetector_BoW::TOptions] ------------ \n\n");
+
+	LOADABLEOPTS_DUMP_VAR(vocabulary_file, string)
+	LOADABLEOPTS_DUMP_VAR(nFeatures, int)
+	LOADABLEOPTS_DUMP_VAR(maxCandidates, int)
+	LOADABLEOPTS_DUMP_VAR(score_unrelated, double)
+	feature_options.dumpToTextStream(out);
+}
@@ -188,8 +188,7 @@ void CBoardDLMS::doProcess()
 					myObs->rightToLeft	= true;									// Scan direction
 					myObs->maxRange		= MAX_RANGE/1000.0f;					// Maximum angle in meters
 
-					myObs->validRange.resize( points );							// Valid range vector
-					myObs->scan.resize( points );								// Scan vector
+					myObs->resizeScan( points );								// Scan and valid range vectors
 
 					// --------------------------------
 					// Fill the vector of measurements
@@ -146,8 +146,7 @@ void  CHokuyoURG::doProcessSimple(
 	outObservation.sensorPose = m_sensorPose;
 	outObservation.sensorLabel = m_sensorLabel;
 
-	outObservation.scan.resize(nRanges);
-	outObservation.validRange.resize(nRanges);
+	outObservation.resizeScan(nRanges);
 	char		*ptr = (char*) &rcv_data[4];
 	for (int i=0;i<nRanges;i++)
 	{
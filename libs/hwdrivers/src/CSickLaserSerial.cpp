@@ -114,8 +114,8 @@ void  CSickLaserSerial::doProcessSimple(
 	outObservation.stdError = 0.003f;
 	outObservation.sensorPose = m_sensorPose;
 
-	outObservation.scan = ranges;
-	outObservation.validRange.resize(ranges.size());
+	outObservation.resizeScan(ranges.size());
+	std::copy(ranges.begin(),ranges.end(),outObservation.scan.begin());
 
 	for (size_t i=0;i<ranges.size();i++)
 		outObservation.validRange[i] = (outObservation.scan[i] <= outObservation.maxRange);
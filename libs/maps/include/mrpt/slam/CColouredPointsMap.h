@@ -171,7 +171,7 @@ namespace mrpt
 			/// \overload
 			inline void  insertPoint( const mrpt::math::TPoint3D &p ) { insertPoint(p.x,p.y,p.z); }
 			/// \overload
-			inline void  insertPoint( float x, float y, float z) { insertPointFast(x,y,z); mark_as_modified(); }
+			inline void  insertPoint( float x, float y, float z) { insertPointFast(x,y,z); mark_as_points_appended(); }
 
 			/** Changes just the color of a given point from the map. First index is 0.
 			 * \exception Throws std::exception on index out of bound.
@@ -207,6 +207,9 @@ namespace mrpt
 			/** Returns true if the point map has a color field for each point */
 			virtual bool hasColorPoints() const { return true; }
 
+			/** See CPointsMap::getPointsColumns(). Adds the fields "color_R", "color_G" and "color_B" (floats in the range [0,1]) */
+			virtual void getPointsColumns(std::vector<TPointsColumn> &cols) const;
+
 			/** Override of the default 3D scene builder to account for the individual points' color.
 			  * \sa mrpt::global_settings::POINTSMAPS_3DOBJECT_POINTSIZE
 			  */
@@ -257,9 +260,6 @@ namespace mrpt
 			/** @name PCL library support
 				@{ */
 
-			/** Save the point cloud as a PCL PCD file, in either ASCII or binary format \return false on any error */
-			virtual bool savePCDFile(const std::string &filename, bool save_as_binary) const;
-
 			/** Loads a PCL point cloud (WITH RGB information) into this MRPT class (for clouds without RGB data, see CPointsMap::setFromPCLPointCloud() ).
 			  *  Usage example:
 			  *  \code
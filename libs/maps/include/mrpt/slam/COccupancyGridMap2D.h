@@ -14,6 +14,8 @@
 #include <mrpt/utils/CLoadableOptions.h>
 #include <mrpt/utils/CImage.h>
 #include <mrpt/utils/CDynamicGrid.h>
+#include <mrpt/utils/CCopyOnWriteGrid.h>
+#include <mrpt/synch/CCriticalSection.h>
 #include <mrpt/slam/CMetricMap.h>
 #include <mrpt/utils/TMatchingPair.h>
 #include <mrpt/slam/CLogOddsGridMap2D.h>
@@ -97,6 +99,16 @@ namespace slam
 	static const cellType OCCGRID_CELLTYPE_MAX  = CLogOddsGridMap2D<cellType>::CELLTYPE_MAX;
 	static const cellType OCCGRID_P2LTABLE_SIZE = CLogOddsGridMap2D<cellType>::P2LTABLE_SIZE;
 
+		/** Scratch buffers of computeLikelihoodField_Thrun(), which may be kept between calls to reuse their memory.
+		  *  A set of buffers must not be used by several threads at once.
+		  */
+		struct TLikelihoodFieldBuffers
+		{
+			std::vector<float>   xs, ys;     //!< The decimated points
+			std::vector<int>     cellIdxs;   //!< The cell of each point (-1: out of the map)
+			std::vector<double>  liks;       //!< The likelihood of each point
+		};
+
 	protected:
 
 		friend class CMultiMetricMap;
@@ -104,11 +116,11 @@ namespace slam
 
 		static CLogOddsGridMapLUT<cellType>  m_logodd_lut; //!< Lookup tables for log-odds
 
-		/** This is the buffer for storing the cells.In this dynamic
-		 *   size buffer are stored the cell values as
-		 *   "bytes", stored row by row, from left to right cells.
+		/** This is the buffer for storing the cells, as size_y rows of size_x cells each (from left to right cells).
+		 *   Rows are shared between copies of the map until modified (see mrpt::utils::CCopyOnWriteGrid), so copying
+		 *   a map (e.g. while resampling the particles of a RBPF) is cheap. Rows must be obtained with map.getRowForWrite() before modifying them.
 		 */
-		std::vector<cellType>    map;
+		mrpt::utils::CCopyOnWriteGrid<cellType>    map;
 
 		/** The size of the grid in cells.
 		 */
@@ -123,10 +135,46 @@ namespace slam
 		float           resolution;
 
 		/** These are auxiliary variables to speed up the computation of observation likelihood values for LF method among others, at a high cost in memory (see TLikelihoodOptions::enableLikelihoodCache).
+		  *  They are not copied along with the map (see the copy constructor).
 		  */
 		std::vector<double>		precomputedLikelihood;
 		bool					precomputedLikelihoodToBeRecomputed;
 
+		/** Distance transform used by the LF method when TLikelihoodOptions::LF_useDistanceTransform is set: the squared distance (in cells) from each cell
+		  *  to its closest occupied cell, saturated to LF_maxCorrsDistance. Cells are stored in tiles of 16x16 cells, in Morton (Z) order inside each tile.
+		  *  Empty if it has not been built yet or if it has been invalidated as a whole (see updateDistanceTransform), or in copies of the map.
+		  */
+		std::vector<uint16_t>	m_dt;
+		std::vector<uint8_t>	m_dt_dirty_tiles;	//!< One entry per tile of m_dt, !=0 if the tile must be recomputed.
+		bool					m_dt_any_dirty;		//!< Whether any entry in m_dt_dirty_tiles is set.
+		uint32_t				m_dt_tiles_x;		//!< Number of tiles of m_dt in the x direction
+		int						m_dt_K;				//!< The half-size (in cells) of the search window m_dt was built for.
+		std::vector<double>		m_dt_lik_table;		//!< The likelihood of a point for each value in m_dt
+
+		/** The likelihood parameters m_dt_lik_table is built for */
+		struct TDistanceTransformLikParams
+		{
+			TDistanceTransformLikParams() : zHit(0), zRandomTerm(0), Q(0), maxCorrDistInt(0), resolution(0) { }
+			bool operator ==(const TDistanceTransformLikParams &o) const { return zHit==o.zHit && zRandomTerm==o.zRandomTerm && Q==o.Q && maxCorrDistInt==o.maxCorrDistInt && resolution==o.resolution; }
+
+			float zHit, zRandomTerm, Q;
+			unsigned int maxCorrDistInt;
+			float resolution;
+		};
+		TDistanceTransformLikParams  m_dt_lik_table_params;
+
+		/** A critical section which is not shared with copies of the grid (unlike a copied CCriticalSection) */
+		struct TDistanceTransformLock : public mrpt::synch::CCriticalSection
+		{
+			TDistanceTransformLock() : mrpt::synch::CCriticalSection("COccupancyGridMap2D::m_dt") { }
+			TDistanceTransformLock(const TDistanceTransformLock &) : mrpt::synch::CCriticalSection("COccupancyGridMap2D::m_dt") { }
+			TDistanceTransformLock & operator =(const TDistanceTransformLock &) { return *this; }
+		};
+		TDistanceTransformLock  m_dt_cs;	//!< Protects the updates of the distance transform of this grid
+
+		/** Marks as dirty all the tiles of the distance transform which may be affected by a change in the occupancy of the cells [cx0,cx1]x[cy0,cy1] */
+		void invalidateDistanceTransform(int cx0,int cy0,int cx1,int cy1);
+
 		/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if not a basis point. */
 		CDynamicGrid<uint8_t>	m_basis_map;
 
@@ -148,6 +196,9 @@ namespace slam
 		 */
 		void            freeMap();
 
+		/** Empties the likelihood caches (precomputedLikelihood and the distance transform), to be recomputed when needed */
+		void            clearLikelihoodCaches();
+
 		/** Entropy computation internal function:
 		 */
 		static double  H(double p);
@@ -156,14 +207,14 @@ namespace slam
 		 */
 		inline void   setCell_nocheck(int x,int y,float value)
 		{
-				map[x+y*size_x]=p2l(value);
+				map.cellForWrite(x,y)=p2l(value);
 		}
 
 		/** Read the real valued [0,1] contents of a cell, given its index.
 		 */
 		inline float  getCell_nocheck(int x,int y) const
 		{
-				return l2p(map[x+y*size_x]);
+				return l2p(map(x,y));
 		}
 
 		/** Changes a cell by its absolute index (Do not use it normally)
@@ -172,7 +223,7 @@ namespace slam
 		{
 			if (cellIndex<size_x*size_y)
 			{
-				map[cellIndex] = b;
+				map.cellForWrite(cellIndex % size_x, cellIndex / size_x) = b;
 			}
 		}
 
@@ -216,7 +267,8 @@ namespace slam
 		  */
 		double	 computeObservationLikelihood_likelihoodField_Thrun(
 					const CObservation		*obs,
-					const CPose2D				&takenFrom );
+					const CPose2D				&takenFrom,
+					TLikelihoodFieldBuffers	*buffers = NULL );
 
 		/** One of the methods that can be selected for implementing "computeObservationLikelihood".
 		  */
@@ -285,6 +337,14 @@ namespace slam
 							 float resolution = 0.05f
 							 );
 
+		/** Copy constructor: the cells are shared with \a o until modified, and the likelihood caches (precomputedLikelihood and the distance transform),
+		  *  whose size is proportional to the number of cells, are not copied but recomputed when needed, so copying a grid is cheap.
+		  */
+		COccupancyGridMap2D( const COccupancyGridMap2D &o );
+
+		/** Copy operator, with the same behavior as the copy constructor */
+		COccupancyGridMap2D & operator =( const COccupancyGridMap2D &o );
+
 		/** Fills all the cells with a default value.
 		  */
 		void  fill(float default_value = 0.5f );
@@ -392,7 +452,11 @@ namespace slam
 			// The x> comparison implicitly holds if x<0
 			if (static_cast<unsigned int>(x)>=size_x ||	static_cast<unsigned int>(y)>=size_y)
 					return;
-			else	map[x+y*size_x]=p2l(value);
+			cellType &cell = map.cellForWrite(x,y);
+			const cellType new_cell = p2l(value);
+			if (!m_dt.empty() && ( (cell<p2l(0.5f)) != (new_cell<p2l(0.5f)) ) )
+				invalidateDistanceTransform(x,y,x,y);
+			cell = new_cell;
 		}
 
 		/** Read the real valued [0,1] contents of a cell, given its index.
@@ -402,16 +466,24 @@ namespace slam
 			// The x> comparison implicitly holds if x<0
 			if (static_cast<unsigned int>(x)>=size_x ||	static_cast<unsigned int>(y)>=size_y)
 					return 0.5f;
-			else	return l2p(map[x+y*size_x]);
+			else	return l2p(map(x,y));
 		}
 
 		/** Access to a "row": mainly used for drawing grid as a bitmap efficiently, do not use it normally.
+		  *  The size_x cells of a row are contiguous in memory, but different rows are not.
+		  *  The row is unshared from other copies of this map before returning it (see mrpt::utils::CCopyOnWriteGrid).
 		  */
-		inline  cellType *getRow( int cy ) { if (cy<0 || static_cast<unsigned int>(cy)>=size_y) return NULL; else return &map[0+cy*size_x]; }
+		inline  cellType *getRow( int cy ) { if (cy<0 || static_cast<unsigned int>(cy)>=size_y) return NULL; else return map.getRowForWrite(cy); }
 
 		/** Access to a "row": mainly used for drawing grid as a bitmap efficiently, do not use it normally.
+		  *  The size_x cells of a row are contiguous in memory, but different rows are not.
+		  */
+		inline  const cellType *getRow( int cy ) const { if (cy<0 || static_cast<unsigned int>(cy)>=size_y) return NULL; else return map.getRow(cy); }
+
+		/** Read-only access to the grid of cells, e.g. to know how many rows are shared with other maps (CCopyOnWriteGrid::getSharedRowCount)
+		  *  or still borrowed from the memory-mapped file the map was loaded from (CCopyOnWriteGrid::getBorrowedRowCount, see mrpt::utils::CFileMMapInputStream).
 		  */
-		inline  const cellType *getRow( int cy ) const { if (cy<0 || static_cast<unsigned int>(cy)>=size_y) return NULL; else return &map[0+cy*size_x]; }
+		inline  const mrpt::utils::CCopyOnWriteGrid<cellType> & getCellGrid() const { return map; }
 
 		/** Change the contents [0,1] of a cell, given its coordinates.
 		 */
@@ -669,6 +741,12 @@ namespace slam
 			  */
 			bool    enableLikelihoodCache;
 
+			/** [LikelihoodField] If set to true (default=false), the distances to the closest occupied cells are looked up in a precomputed distance transform instead of searched for
+			  *  around each point. The transform takes 2 bytes per cell and it's updated incrementally as the map changes, so this is best suited to localization in mostly static maps.
+			  * \sa updateDistanceTransform
+			  */
+			bool    LF_useDistanceTransform;
+
 		} likelihoodOptions;
 
 		/** Auxiliary private class.
@@ -846,6 +924,23 @@ namespace slam
 		// See docs in base class
 		double	 computeObservationLikelihood( const CObservation *obs, const CPose3D &takenFrom );
 
+	protected:
+		/** Implementation of computeObservationLikelihood(), with optional scratch buffers for the LF method (see computeLikelihoodField_Thrun) */
+		double	 internal_computeObservationLikelihood( const CObservation *obs, const CPose3D &takenFrom, TLikelihoodFieldBuffers *buffers );
+
+		struct TLikelihoodForPosesEvaluator;  //!< Body of the parallel_for() in computeObservationLikelihoodForPoses()
+
+	public:
+
+		/** Computes the log-likelihood of one observation for a whole set of robot poses (e.g. all the particles in Monte Carlo localization),
+		  *  distributing the poses among several threads (see mrpt::system::parallel_for).
+		  *  Only the methods lmLikelihoodField_Thrun, lmLikelihoodField_II, lmRayTracing and lmConsensus are evaluated in parallel, since
+		  *  the rest of them modify the grid or "likelihoodOutputs" while computing the likelihood. The results are always the same
+		  *  than those of calling computeObservationLikelihood() for each pose.
+		  * \sa CMetricMap::computeObservationLikelihoodForPoses, mrpt::system::setParallelizationThreadsCount
+		  */
+		void computeObservationLikelihoodForPoses( const CObservation *obs, const std::vector<mrpt::math::TPose3D> &takenFrom, vector_double &out_log_liks );
+
 		/** Returns true if this map is able to compute a sensible likelihood function for this observation (i.e. an occupancy grid map cannot with an image).
 		 * \param obs The observation.
 		 * \sa computeObservationLikelihood
@@ -855,9 +950,19 @@ namespace slam
 		/** Computes the likelihood [0,1] of a set of points, given the current grid map as reference.
 		  * \param pm The points map
 		  * \param relativePose The relative pose of the points map in this map's coordinates, or NULL for (0,0,0).
+		  * \param buffers Optional scratch buffers to reuse between calls (e.g. while evaluating many poses), instead of allocating new ones in each call.
 		  *  See "likelihoodOptions" for configuration parameters.
 		  */
-		double	 computeLikelihoodField_Thrun( const CPointsMap	*pm, const CPose2D *relativePose = NULL);
+		double	 computeLikelihoodField_Thrun( const CPointsMap	*pm, const CPose2D *relativePose = NULL, TLikelihoodFieldBuffers *buffers = NULL);
+
+		/** Brings the distance transform used by computeLikelihoodField_Thrun() up to date, if TLikelihoodOptions::LF_useDistanceTransform is enabled.
+		  *  It is built entirely the first time (or after the grid is resized, cleared or loaded), and afterwards only those tiles
+		  *  affected by updateCell(), setCell() or the insertion of observations are recomputed.
+		  *  This is automatically invoked from computeLikelihoodField_Thrun(), so it only needs to be called explicitly to avoid the delay in the next likelihood evaluation.
+		  *  It is safe to call this method (and computeLikelihoodField_Thrun()) from several threads at once, as long as the grid is not modified meanwhile.
+		  *  If the distance transform is already up to date, it returns immediately without locking.
+		  */
+		void updateDistanceTransform();
 
 		/** Computes the likelihood [0,1] of a set of points, given the current grid map as reference.
 		  * \param pm The points map
@@ -182,6 +182,8 @@ namespace slam
 			float   horizontalTolerance;	     //!< The tolerance in rads in pitch & roll for a laser scan to be considered horizontal, considered only when isPlanarMap=true (default=0).
 			float   maxDistForInterpolatePoints; //!< The maximum distance between two points to interpolate between them (ONLY when also_interpolate=true)
 			bool    insertInvalidPoints;             //!< Points with x,y,z coordinates set to zero will also be inserted
+			float   voxelFusionSize;             //!< If >0 (default=0), 2D and 3D range scans are inserted with fuseWithVoxels(), keeping at most one point per occupied voxel of this size. This takes precedence over fuseWithExisting.
+			bool    voxelFusionAverage;          //!< Only when voxelFusionSize>0: if false (default), the first point of each voxel is kept and the rest are discarded, so the map only grows by appending points and its KD-tree and bounding box are updated incrementally; if true, each voxel keeps the mean of its points, which invalidates the KD-tree after every fused scan.
 
 			void writeToStream(CStream &out) const;		//!< Binary dump to stream - for usage in derived classes' serialization
 			void readFromStream(CStream &in);			//!< Binary dump to stream - for usage in derived classes' serialization
@@ -282,12 +284,34 @@ namespace slam
 			save3D_to_text_file( fil );
 		}
 
-		/** Save the point cloud as a PCL PCD file, in either ASCII or binary format (requires MRPT built against PCL) \return false on any error */
+		/** Save the point cloud as a PCL PCD file, in either ASCII or binary format.
+		  *  All the per-point fields of the map are saved (see getPointsColumns()), with the colors of CColouredPointsMap packed into a PCL-compatible "rgb" field.
+		  *  Binary data is interleaved and written in large blocks, so PCL is not required.
+		  * \return false on any error */
 		virtual bool savePCDFile(const std::string &filename, bool save_as_binary) const;
 
-		/** Load the point cloud from a PCL PCD file (requires MRPT built against PCL) \return false on any error */
+		/** Load the point cloud from a PCL PCD file with "ascii" or "binary" data ("binary_compressed" files require MRPT built against PCL).
+		  *  The fields of the file with the names of the per-point fields of this map (see getPointsColumns()) are loaded, and the rest are ignored.
+		  * \return false on any error */
 		virtual bool loadPCDFile(const std::string &filename);
 
+		/** Save the point cloud in the MRPT binary columnar format, where each per-point field of the map (see getPointsColumns()) is stored as a contiguous array,
+		  *  so it is written (and read back) with a single I/O operation. The format is:
+		  *   - Header: "MRPTPTS" plus a zero byte, uint32 version (=1), uint32 number of columns, uint64 number of points.
+		  *   - For each column: its name (16 bytes, zero-padded), uint8 type ('F' for float, 'U' for uint32_t), uint8 size of each element in bytes (4) and 6 bytes of padding.
+		  *   - The data of each column, starting at a file offset multiple of 16.
+		  *  All numbers are little-endian.
+		  * \sa loadBinaryColumnsFile
+		  * \return false on any error */
+		bool saveBinaryColumnsFile(const std::string &filename) const;
+
+		/** Load the point cloud from a file in the MRPT binary columnar format (see saveBinaryColumnsFile()).
+		  *  Columns of the file which are not fields of this map are skipped, and fields of this map missing in the file keep the values set by setSize():
+		  *  zero, except for the colors of mrpt::slam::CColouredPointsMap and the weights of mrpt::slam::CWeightedPointsMap, which are set to 1.
+		  * \param use_mmap If true, the file is memory-mapped (see mrpt::utils::CFileMMapInputStream) instead of read with standard file I/O.
+		  * \return false on any error */
+		bool loadBinaryColumnsFile(const std::string &filename, bool use_mmap = true);
+
 
 		/** Optional settings for saveLASFile() */
 		struct MAPS_IMPEXP LAS_WriteParams
@@ -408,6 +432,22 @@ namespace slam
 		/** Provides a direct access to a read-only reference of the internal point buffer. \sa getAllPoints */
 		inline const std::vector<float> & getPointsBufferRef_z() const { return z; }
 
+		/** Description of a per-point field of the map (a "column" of its structure-of-arrays storage), see getPointsColumns() */
+		struct MAPS_IMPEXP TPointsColumn
+		{
+			TPointsColumn(const char *name_, char type_, const void *data_) : name(name_), type(type_), data(data_) { }
+
+			std::string  name;  //!< The field name: "x", "y", "z", "color_R", "weight",...
+			char         type;  //!< 'F' for float, 'U' for uint32_t, as in the PCD file format. All the fields are 4 bytes long.
+			const void  *data;  //!< The array with the values of all the points (it may be NULL if the map is empty)
+		};
+
+		/** Returns the per-point fields of the map: the coordinates "x", "y" and "z", plus those of derived classes (e.g. colors or weights).
+		  *  The pointers are into the internal buffers of the map, so they are invalidated by any change of the number of points.
+		  * \sa saveBinaryColumnsFile, savePCDFile
+		  */
+		virtual void getPointsColumns(std::vector<TPointsColumn> &cols) const;
+
 		/** Returns a copy of the 2D/3D points as a std::vector of float coordinates.
 		  * If decimation is greater than 1, only 1 point out of that number will be saved in the output, effectively performing a subsampling of the points.
 		  * \sa getPointsBufferRef_x, getPointsBufferRef_y, getPointsBufferRef_z
@@ -462,7 +502,7 @@ namespace slam
 		/** Provides a way to insert (append) individual points into the map: the missing fields of child
 		  * classes (color, weight, etc) are left to their default values
 		  */
-		inline void  insertPoint( float x, float y, float z=0 ) { insertPointFast(x,y,z); mark_as_modified(); }
+		inline void  insertPoint( float x, float y, float z=0 ) { insertPointFast(x,y,z); mark_as_points_appended(); }
 		/// \overload of \a insertPoint()
 		inline void  insertPoint( const CPoint3D &p ) { insertPoint(p.x(),p.y(),p.z()); }
 		/// \overload
@@ -616,6 +656,22 @@ namespace slam
 			float				minDistForFuse  = 0.02f,
 			std::vector<bool>	*notFusedPoints = NULL);
 
+		/** Insert the points of another map into this one, keeping at most one point per occupied voxel (a cube of size "voxel_size"):
+		  *  points falling into a voxel which already has a point are fused with it (averaged or discarded, see "average"), and the rest are appended.
+		  *  The occupied voxels are kept in a hash table, so the cost is O(1) per point, independently of the size of the map, and the size of the map
+		  *  is bounded by the observed volume instead of growing with the number of insertions.
+		  *
+		  *  The hash table is built the first time, and updated with the points inserted later by any other method, but it is discarded if the map is modified
+		  *  in any other way (e.g. points deleted) or if "voxel_size" changes. Points inserted by other methods do not fuse with each other.
+		  *  As in fuseWith(), "otherMap" must be already in the coordinates of this map.
+		  *
+		  * \param average If true, points are replaced by the mean of all the points fused into them (and their weight is increased in CWeightedPointsMap);
+		  *   in that case, the KD-tree must be rebuilt after any fusion. If false, points already in the map are never modified, so the KD-tree is only updated with the new points.
+		  * \return The number of points appended to the map.
+		  * \sa TInsertionOptions::voxelFusionSize, fuseWith, voxelDownsample
+		  */
+		size_t fuseWithVoxels(const CPointsMap &otherMap, const float voxel_size, const bool average = false);
+
 		/** Replace each point \f$ p_i \f$ by \f$ p'_i = b \oplus p_i \f$ (pose compounding operator).
 		  */
 		void   changeCoordinatesReference(const CPose2D &b);
@@ -673,6 +729,34 @@ namespace slam
 			pMax.z=dmy6;
 		}
 
+		/** The shape of the surface around one point of the map, estimated from its closest neighbors. \sa getLocalShapes */
+		struct MAPS_IMPEXP TLocalShape
+		{
+			float nx,ny,nz;  //!< Unit normal vector: the direction of least variance of the neighbors (its sign is arbitrary)
+			float curvature; //!< "Surface variation": smallest eigenvalue of the covariance of the neighbors divided by the sum of all of them, in the range [0,1/3] (0 means perfectly planar). It's -1 if there were not enough points to estimate the normal.
+		};
+
+		/** Estimates the normal vector of the surface around each point of the map, from the covariance of its "knn" closest neighbors in 3D (including itself).
+		  *  Results are computed in parallel and cached until the map is modified, so successive calls (e.g. from ICP) are free.
+		  *  If points are only appended to the map, only the shapes of the new points are estimated, while the previous ones are kept as they were.
+		  * \return A vector with one entry per point in the map.
+		  * \sa mrpt::slam::CICP, icpPointToPlane, icpGICP
+		  */
+		const std::vector<TLocalShape> & getLocalShapes(const size_t knn = 10) const;
+
+		/** Decimates the map with a 3D grid of cubic voxels of size "voxel_size", replacing all the points within each occupied voxel by their mean.
+		  *  The previous contents of outMap are lost.
+		  * \sa getVoxelDownsampled
+		  */
+		void voxelDownsample(const float voxel_size, CPointsMap &outMap) const;
+
+		/** Like voxelDownsample(), but the decimated map is cached (with its own KD-tree) until this map is modified, so repeated calls with the same voxel size are free.
+		  *  This is used to build the multi-resolution pyramids of mrpt::slam::CICP.
+		  * \return A reference to a CSimplePointsMap, valid until this map is modified or destroyed.
+		  * \sa voxelDownsample, mrpt::slam::CICP::TConfigParams::pyramid_levels
+		  */
+		const CPointsMap & getVoxelDownsampled(const float voxel_size) const;
+
 		/** Extracts the points in the map within a cylinder in 3D defined the provided radius and zmin/zmax values.
 		  */
 		void extractCylinder( const CPoint2D &center, const double radius, const double zmin, const double zmax, CPointsMap *outMap );
@@ -827,15 +911,56 @@ namespace slam
 		mutable bool	m_boundingBoxIsUpdated;
 		mutable float   m_bb_min_x,m_bb_max_x, m_bb_min_y,m_bb_max_y, m_bb_min_z,m_bb_max_z;
 
+		mutable std::vector<TLocalShape> m_local_shapes;     //!< Cache for getLocalShapes()
+		mutable size_t                   m_local_shapes_knn; //!< The number of neighbors used to estimate m_local_shapes
+
+		mutable std::vector<std::pair<float,CPointsMapPtr> > m_voxel_downsampled; //!< Cache for getVoxelDownsampled(): pairs of (voxel size, decimated map)
+
+		/** A hash table (open addressing, linear probing) from the integer coordinates of the occupied voxels to the index of their point, for fuseWithVoxels() */
+		struct MAPS_IMPEXP TVoxelIndex
+		{
+			TVoxelIndex() : voxel_size(0), nIndexed(0), nUsed(0) { }
+
+			float                 voxel_size;
+			size_t                nIndexed;  //!< Points [0,nIndexed) of the map have been processed
+			size_t                nUsed;     //!< Number of occupied slots
+			std::vector<int32_t>  cells;     //!< The voxel of each slot (3 coordinates per slot)
+			std::vector<uint32_t> slots;     //!< The point index of each slot, or EMPTY
+			std::vector<uint32_t> counts;    //!< The number of points fused into each point of the map
+
+			static const uint32_t EMPTY = static_cast<uint32_t>(-1);
+
+			void clear();
+			void swap(TVoxelIndex &o);
+			/** Returns the slot with that voxel, or the empty slot where it must be inserted */
+			size_t find(int32_t cx, int32_t cy, int32_t cz) const;
+			/** Inserts a voxel in an empty slot returned by find(), growing the table if needed */
+			void insert(size_t slot, int32_t cx, int32_t cy, int32_t cz, uint32_t pointIdx);
+		};
+		mutable TVoxelIndex  m_voxel_index; //!< Occupied voxels for fuseWithVoxels(), discarded by mark_as_modified()
+
 
 		/** Called only by this class or children classes, set m_largestDistanceFromOriginIsUpdated=false and such. */
 		inline void mark_as_modified() const
 		{
 			m_largestDistanceFromOriginIsUpdated=false;
 			m_boundingBoxIsUpdated = false;
+			m_local_shapes.clear();
+			m_voxel_downsampled.clear();
+			m_voxel_index.clear();
 			kdtree_mark_as_outdated();
 		}
 
+		/** Like mark_as_modified(), but to be called when new points have been appended at the end of the map while all the previous points remain unchanged,
+		  *  so the KD-tree only needs to index the new points (see mrpt::math::KDTreeCapable::kdtree_mark_as_points_appended()) */
+		inline void mark_as_points_appended() const
+		{
+			m_largestDistanceFromOriginIsUpdated=false;
+			m_boundingBoxIsUpdated = false;
+			m_voxel_downsampled.clear();
+			kdtree_mark_as_points_appended();
+		}
+
 		/** This is a common version of CMetricMap::insertObservation() for point maps (actually, CMetricMap::internal_insertObservation),
 		  *   so derived classes don't need to worry implementing that method unless something special is really necesary.
 		  * See mrpt::slam::CPointsMap for the enumeration of types of observations which are accepted.
@@ -891,10 +1016,23 @@ namespace slam
 		// Friend methods:
 		template <class Derived> friend struct detail::loadFromRangeImpl;
 		template <class Derived> friend struct detail::pointmap_traits;
+		friend bool getPointCloudXYZBuffers(CPointsMap *map, const size_t N, float *&xs, float *&ys, float *&zs);
 
 
 	}; // End of class def.
 
+	/** Overload of the hook used by CObservation3DRangeScan::project3DPointsFromDepthImageInto() to write the points straight into the X,Y,Z arrays of point maps:
+	  *  resizes the map to N points (keeping the first ones) and returns pointers to its arrays. */
+	inline bool getPointCloudXYZBuffers(CPointsMap *map, const size_t N, float *&xs, float *&ys, float *&zs)
+	{
+		map->resize(N);
+		map->mark_as_modified();
+		xs = N ? &map->x[0] : NULL;
+		ys = N ? &map->y[0] : NULL;
+		zs = N ? &map->z[0] : NULL;
+		return true;
+	}
+
 	} // End of namespace
 
 	namespace global_settings
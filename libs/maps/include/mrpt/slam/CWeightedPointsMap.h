@@ -123,6 +123,9 @@ namespace mrpt
 			/// Gets the point weight, which is ignored in all classes (defaults to 1) but in those which actually store that field (Note: No checks are done for out-of-bounds index).  \sa setPointWeight
 			virtual unsigned int getPointWeight(size_t index) const { return pointWeight[index]; }
 
+			/** See CPointsMap::getPointsColumns(). Adds the field "weight" (uint32_t) */
+			virtual void getPointsColumns(std::vector<TPointsColumn> &cols) const;
+
 		protected:
 			std::vector<uint32_t>  pointWeight;  //!< The points weights
 
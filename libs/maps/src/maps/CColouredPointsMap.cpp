@@ -67,13 +67,16 @@ void CColouredPointsMap::reserve(size_t newLength)
 //  and old contents are not changed.
 void CColouredPointsMap::resize(size_t newLength)
 {
+	const bool only_appends = newLength>=x.size();
 	x.resize( newLength, 0 );
 	y.resize( newLength, 0 );
 	z.resize( newLength, 0 );
 	m_color_R.resize( newLength, 1 );
 	m_color_G.resize( newLength, 1 );
 	m_color_B.resize( newLength, 1 );
-	mark_as_modified();
+	if (only_appends)
+	     mark_as_points_appended();
+	else mark_as_modified();
 }
 
 // Resizes all point buffers so they can hold the given number of points, *erasing* all previous contents
@@ -354,7 +357,7 @@ void  CColouredPointsMap::insertPoint( float x, float y, float z, float R, float
 	m_color_G.push_back(G);
 	m_color_B.push_back(B);
 
-	mark_as_modified();
+	mark_as_points_appended();
 }
 
 /*---------------------------------------------------------------
@@ -640,46 +643,16 @@ void  CColouredPointsMap::addFrom_classSpecific(const CPointsMap &anotherMap, co
 	}
 }
 
-/** Save the point cloud as a PCL PCD file, in either ASCII or binary format \return false on any error */
-bool CColouredPointsMap::savePCDFile(const std::string &filename, bool save_as_binary) const
+/*---------------------------------------------------------------
+						getPointsColumns
+ ---------------------------------------------------------------*/
+void  CColouredPointsMap::getPointsColumns(std::vector<TPointsColumn> &cols) const
 {
-#if MRPT_HAS_PCL
-	pcl::PointCloud<pcl::PointXYZRGB> cloud;
-
-	const size_t nThis = this->size();
-
-	// Fill in the cloud data
-	cloud.width    = nThis;
-	cloud.height   = 1;
-	cloud.is_dense = false;
-	cloud.points.resize (cloud.width * cloud.height);
-
-	const float f = 255.f;
-
-	union myaux_t
-	{
-		uint8_t rgb[4];
-		float   f;
-	} aux_val;
-
-	for (size_t i = 0; i < nThis; ++i)
-	{
-		cloud.points[i].x =this->x[i];
-		cloud.points[i].y =this->y[i];
-		cloud.points[i].z =this->z[i];
-
-		aux_val.rgb[0]=static_cast<uint8_t>( this->m_color_B[i] * f);
-		aux_val.rgb[1]=static_cast<uint8_t>( this->m_color_G[i] * f);
-		aux_val.rgb[2]=static_cast<uint8_t>( this->m_color_R[i] * f);
-
-		cloud.points[i].rgb = aux_val.f;
-	}
-
-	return 0 == pcl::io::savePCDFile(filename, cloud, save_as_binary);
-
-#else
-	THROW_EXCEPTION("Operation not available: MRPT was built without PCL")
-#endif
+	CPointsMap::getPointsColumns(cols);
+	const bool empty = m_color_R.empty();
+	cols.push_back(TPointsColumn("color_R",'F', empty ? NULL : &m_color_R[0]));
+	cols.push_back(TPointsColumn("color_G",'F', empty ? NULL : &m_color_G[0]));
+	cols.push_back(TPointsColumn("color_B",'F', empty ? NULL : &m_color_B[0]));
 }
 
 namespace mrpt {
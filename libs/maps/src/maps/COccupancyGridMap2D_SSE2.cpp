@@ -0,0 +1,195 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/maps.h>  // Precompiled header
+
+#if MRPT_HAS_SSE2
+// ---------------------------------------------------------------------------
+//   This file contains the SSE2 optimized functions for mrpt::slam::COccupancyGridMap2D
+//    See the sources and the doxygen documentation page "sse_optimizations" for more details.
+// ---------------------------------------------------------------------------
+
+#include <mrpt/utils/utils_defs.h>
+#include <mrpt/utils/SSE_types.h>
+#include <cfloat>
+#include <cmath>
+#include "COccupancyGridMap2D_SSEx.h"
+
+/** \addtogroup sse_optimizations
+ *  SSE optimized functions
+ *  @{
+ */
+
+/** Transforms N 2D points, given as separate x[] and y[] arrays, by the 2D pose (x,y,phi) and
+  *  returns the linear index (cx+cy*size_x) of the grid cell of each transformed point, or -1 if
+  *  it falls outside of the cells [0,size_x-2]x[0,size_y-2].
+  *  - <b>Preconditions:</b> None (unaligned inputs are allowed).
+  *  - <b>Notes:</b> Cell indices are truncated towards zero, as in COccupancyGridMap2D::x2idx(). All the operations are done in
+  *                  double precision (2 points per SSE2 register), so the cell of points lying close to the border between
+  *                  two cells is exactly the same than that computed by the scalar code.
+  *  - <b>Requires:</b> SSE2
+  *  - <b>Invoked from:</b> mrpt::slam::COccupancyGridMap2D::computeLikelihoodField_Thrun()
+  */
+void grid_SSE2_points_to_cells(
+	const float *xs, const float *ys, size_t N,
+	double pose_x, double pose_y, double ccos, double ssin,
+	double x_min, double y_min, double resolution,
+	unsigned int size_x, unsigned int size_y,
+	int *out_idxs)
+{
+	const __m128d px  = _mm_set1_pd(pose_x);
+	const __m128d py  = _mm_set1_pd(pose_y);
+	const __m128d cc  = _mm_set1_pd(ccos);
+	const __m128d ss  = _mm_set1_pd(ssin);
+	const __m128d xm  = _mm_set1_pd(x_min);
+	const __m128d ym  = _mm_set1_pd(y_min);
+	const __m128d res = _mm_set1_pd(resolution);
+
+	const __m128i minus1 = _mm_set1_epi32(-1);
+	const __m128i sx_1   = _mm_set1_epi32(size_x-1);
+	const __m128i sy_1   = _mm_set1_epi32(size_y-1);
+
+	MRPT_ALIGN16 int cxs[4], cys[4], valid[4];
+
+	const size_t N4 = N & ~size_t(3);
+	size_t i;
+	for (i=0;i<N4;i+=4)
+	{
+		const __m128 lx = _mm_loadu_ps(xs+i);
+		const __m128 ly = _mm_loadu_ps(ys+i);
+
+		// Points (0,1) and (2,3) in double precision:
+		const __m128d lx01 = _mm_cvtps_pd(lx), lx23 = _mm_cvtps_pd(_mm_movehl_ps(lx,lx));
+		const __m128d ly01 = _mm_cvtps_pd(ly), ly23 = _mm_cvtps_pd(_mm_movehl_ps(ly,ly));
+
+		// Global coordinates, with the same order of operations than CPose2D::composePoint():
+		const __m128d gx01 = _mm_sub_pd( _mm_add_pd(px, _mm_mul_pd(lx01,cc)), _mm_mul_pd(ly01,ss) );
+		const __m128d gx23 = _mm_sub_pd( _mm_add_pd(px, _mm_mul_pd(lx23,cc)), _mm_mul_pd(ly23,ss) );
+		const __m128d gy01 = _mm_add_pd( _mm_add_pd(py, _mm_mul_pd(lx01,ss)), _mm_mul_pd(ly01,cc) );
+		const __m128d gy23 = _mm_add_pd( _mm_add_pd(py, _mm_mul_pd(lx23,ss)), _mm_mul_pd(ly23,cc) );
+
+		// Cell indices (out-of-range values become 0x80000000, i.e. negative):
+		const __m128i cx = _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32( _mm_div_pd( _mm_sub_pd(gx01,xm), res ) ),
+			_mm_cvttpd_epi32( _mm_div_pd( _mm_sub_pd(gx23,xm), res ) ) );
+		const __m128i cy = _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32( _mm_div_pd( _mm_sub_pd(gy01,ym), res ) ),
+			_mm_cvttpd_epi32( _mm_div_pd( _mm_sub_pd(gy23,ym), res ) ) );
+
+		// 0 <= cx < size_x-1  &&  0 <= cy < size_y-1
+		const __m128i in_x = _mm_and_si128( _mm_cmpgt_epi32(cx,minus1), _mm_cmplt_epi32(cx,sx_1) );
+		const __m128i in_y = _mm_and_si128( _mm_cmpgt_epi32(cy,minus1), _mm_cmplt_epi32(cy,sy_1) );
+
+		_mm_store_si128( reinterpret_cast<__m128i*>(cxs), cx);
+		_mm_store_si128( reinterpret_cast<__m128i*>(cys), cy);
+		_mm_store_si128( reinterpret_cast<__m128i*>(valid), _mm_and_si128(in_x,in_y) );
+
+		// SSE2 has no 32bit integer multiply: build the linear index here.
+		for (int k=0;k<4;k++)
+			out_idxs[i+k] = valid[k] ? cxs[k]+cys[k]*int(size_x) : -1;
+	}
+
+	// The remaining points:
+	for (;i<N;i++)
+	{
+		const double gx = pose_x + xs[i]*ccos - ys[i]*ssin;
+		const double gy = pose_y + xs[i]*ssin + ys[i]*ccos;
+		const int cx = static_cast<int>( (gx-x_min)/resolution );
+		const int cy = static_cast<int>( (gy-y_min)/resolution );
+		out_idxs[i] = (static_cast<unsigned>(cx)>=size_x-1 || static_cast<unsigned>(cy)>=size_y-1) ? -1 : cx+cy*int(size_x);
+	}
+}
+
+namespace
+{
+	/** Natural logarithm of 4 packed, positive, normalized floats (Cephes' logf polynomial approximation) */
+	inline __m128 log_ps(__m128 x)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		// Split x = m * 2^e, with m in [0.5,1):
+		__m128i e_int = _mm_sub_epi32( _mm_srli_epi32(_mm_castps_si128(x),23), _mm_set1_epi32(0x7f) );
+		x = _mm_or_ps( _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000))), _mm_set1_ps(0.5f) );
+		__m128 e = _mm_add_ps( _mm_cvtepi32_ps(e_int), one );
+
+		// if (m<sqrt(1/2)) { e-=1; x = 2m-1; } else { x = m-1; }
+		const __m128 mask = _mm_cmplt_ps(x, _mm_set1_ps(0.707106781186547524f));
+		const __m128 tmp = _mm_and_ps(x,mask);
+		x = _mm_sub_ps(x,one);
+		e = _mm_sub_ps(e, _mm_and_ps(one,mask));
+		x = _mm_add_ps(x,tmp);
+
+		const __m128 z = _mm_mul_ps(x,x);
+
+		__m128 y =               _mm_set1_ps( 7.0376836292E-2f);
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps(-1.1514610310E-1f));
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps( 1.1676998740E-1f));
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps(-1.2420140846E-1f));
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps( 1.4249322787E-1f));
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps(-1.6668057665E-1f));
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps( 2.0000714765E-1f));
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps(-2.4999993993E-1f));
+		y = _mm_add_ps(_mm_mul_ps(y,x), _mm_set1_ps( 3.3333331174E-1f));
+		y = _mm_mul_ps(_mm_mul_ps(y,x),z);
+
+		y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+		y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+		x = _mm_add_ps(x,y);
+		return _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+	}
+}
+
+/** Returns the sum of the natural logarithms of N positive values.
+  *  - <b>Preconditions:</b> All vals[i]>0
+  *  - <b>Notes:</b> Logarithms are evaluated in single precision (relative error ~1e-7) and accumulated in double precision.
+  *                  Groups of values not representable as normalized floats are evaluated with std::log() instead.
+  *  - <b>Requires:</b> SSE2
+  *  - <b>Invoked from:</b> mrpt::slam::COccupancyGridMap2D::computeLikelihoodField_Thrun()
+  */
+double grid_SSE2_sum_log(const double *vals, size_t N)
+{
+	const __m128 flt_min = _mm_set1_ps(FLT_MIN);
+	const __m128 flt_max = _mm_set1_ps(FLT_MAX);
+
+	__m128d acc = _mm_setzero_pd();
+	double  ret = 0;
+
+	const size_t N4 = N & ~size_t(3);
+	size_t i;
+	for (i=0;i<N4;i+=4)
+	{
+		const __m128d v01 = _mm_loadu_pd(vals+i);
+		const __m128d v23 = _mm_loadu_pd(vals+i+2);
+		const __m128 v = _mm_movelh_ps( _mm_cvtpd_ps(v01), _mm_cvtpd_ps(v23) );
+
+		// Fall back to double precision for tiny (or huge) values:
+		if ( _mm_movemask_ps( _mm_or_ps( _mm_cmplt_ps(v,flt_min), _mm_cmpgt_ps(v,flt_max) ) ) )
+		{
+			ret += std::log(vals[i])+std::log(vals[i+1])+std::log(vals[i+2])+std::log(vals[i+3]);
+			continue;
+		}
+
+		const __m128 l = log_ps(v);
+		acc = _mm_add_pd(acc, _mm_cvtps_pd(l) );
+		acc = _mm_add_pd(acc, _mm_cvtps_pd( _mm_movehl_ps(l,l) ) );
+	}
+
+	MRPT_ALIGN16 double acc2[2];
+	_mm_store_pd(acc2,acc);
+	ret += acc2[0]+acc2[1];
+
+	for (;i<N;i++)
+		ret += std::log(vals[i]);
+
+	return ret;
+}
+
+/**  @}  */
+
+#endif // end if MRPT_HAS_SSE2
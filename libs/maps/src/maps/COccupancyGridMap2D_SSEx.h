@@ -0,0 +1,21 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef COccupancyGridMap2D_SSEx_H
+#define COccupancyGridMap2D_SSEx_H
+
+#include <mrpt/config.h>
+#include <cstddef>
+
+// See documentation in the .cpp files COccupancyGridMap2D_SSE*.cpp
+
+void grid_SSE2_points_to_cells  (const float *xs, const float *ys, size_t N, double pose_x, double pose_y, double ccos, double ssin, double x_min, double y_min, double resolution, unsigned int size_x, unsigned int size_y, int *out_idxs);
+double grid_SSE2_sum_log        (const double *vals, size_t N);
+
+
+#endif
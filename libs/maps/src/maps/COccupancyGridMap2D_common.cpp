@@ -45,6 +45,8 @@ COccupancyGridMap2D::COccupancyGridMap2D(
 		x_min(),x_max(),y_min(),y_max(), resolution(),
 		precomputedLikelihood(),
 		precomputedLikelihoodToBeRecomputed(true),
+		m_dt(), m_dt_dirty_tiles(), m_dt_any_dirty(false), m_dt_tiles_x(0), m_dt_K(0),
+		m_dt_lik_table(), m_dt_lik_table_params(), m_dt_cs(),
 		m_basis_map(),
 		m_voronoi_diagram(),
 		m_is_empty(true),
@@ -61,6 +63,74 @@ COccupancyGridMap2D::COccupancyGridMap2D(
 }
 
 
+/*---------------------------------------------------------------
+						Copy constructor
+  ---------------------------------------------------------------*/
+COccupancyGridMap2D::COccupancyGridMap2D( const COccupancyGridMap2D &o ) :
+		CMetricMap(o),
+		CLogOddsGridMap2D<cellType>(o),
+		map(o.map),
+		size_x(o.size_x),size_y(o.size_y),
+		x_min(o.x_min),x_max(o.x_max),y_min(o.y_min),y_max(o.y_max), resolution(o.resolution),
+		precomputedLikelihood(),
+		precomputedLikelihoodToBeRecomputed(true),
+		m_dt(), m_dt_dirty_tiles(), m_dt_any_dirty(false), m_dt_tiles_x(0), m_dt_K(0),
+		m_dt_lik_table(), m_dt_lik_table_params(), m_dt_cs(),
+		m_basis_map(o.m_basis_map),
+		m_voronoi_diagram(o.m_voronoi_diagram),
+		m_is_empty(o.m_is_empty),
+		voroni_free_threshold(o.voroni_free_threshold),
+		updateInfoChangeOnly(o.updateInfoChangeOnly),
+		insertionOptions(o.insertionOptions),
+		likelihoodOptions(o.likelihoodOptions),
+		likelihoodOutputs(o.likelihoodOutputs),
+		CriticalPointsList(o.CriticalPointsList)
+{
+}
+
+/*---------------------------------------------------------------
+						Copy operator
+  ---------------------------------------------------------------*/
+COccupancyGridMap2D & COccupancyGridMap2D::operator =( const COccupancyGridMap2D &o )
+{
+	if (this==&o) return *this;
+
+	CMetricMap::operator =(o);
+	CLogOddsGridMap2D<cellType>::operator =(o);
+	map = o.map;
+	size_x = o.size_x;  size_y = o.size_y;
+	x_min = o.x_min;  x_max = o.x_max;
+	y_min = o.y_min;  y_max = o.y_max;
+	resolution = o.resolution;
+	clearLikelihoodCaches();
+	m_basis_map = o.m_basis_map;
+	m_voronoi_diagram = o.m_voronoi_diagram;
+	m_is_empty = o.m_is_empty;
+	voroni_free_threshold = o.voroni_free_threshold;
+	updateInfoChangeOnly = o.updateInfoChangeOnly;
+	insertionOptions = o.insertionOptions;
+	likelihoodOptions = o.likelihoodOptions;
+	likelihoodOutputs = o.likelihoodOutputs;
+	CriticalPointsList = o.CriticalPointsList;
+	return *this;
+}
+
+/*---------------------------------------------------------------
+						clearLikelihoodCaches
+  ---------------------------------------------------------------*/
+void COccupancyGridMap2D::clearLikelihoodCaches()
+{
+	std::vector<double>().swap(precomputedLikelihood);
+	precomputedLikelihoodToBeRecomputed = true;
+	std::vector<uint16_t>().swap(m_dt);
+	std::vector<uint8_t>().swap(m_dt_dirty_tiles);
+	m_dt_any_dirty = false;
+	m_dt_tiles_x = 0;
+	m_dt_K = 0;
+	std::vector<double>().swap(m_dt_lik_table);
+	m_dt_lik_table_params = TDistanceTransformLikParams();
+}
+
 /*---------------------------------------------------------------
 						Destructor
   ---------------------------------------------------------------*/
@@ -92,6 +162,7 @@ void  COccupancyGridMap2D::setSize(
 
 	// For the precomputed likelihood trick:
 	precomputedLikelihoodToBeRecomputed = true;
+	m_dt.clear();
 
 	// Adjust sizes to adapt them to full sized cells acording to the resolution:
 	x_min = resolution*round(x_min/resolution);
@@ -122,7 +193,7 @@ void  COccupancyGridMap2D::setSize(
 #endif
 
     // Cells memory:
-    map.resize(size_x*size_y,p2l(default_value));
+    map.resize(size_x,size_y,p2l(default_value));
 
 	// Free these buffers also:
 	m_basis_map.clear();
@@ -139,7 +210,7 @@ void  COccupancyGridMap2D::setSize(
 void  COccupancyGridMap2D::resizeGrid(float new_x_min,float new_x_max,float new_y_min,float new_y_max,float new_cells_default_value, bool additionalMargin) MRPT_NO_THROWS
 {
 	unsigned int			extra_x_izq=0,extra_y_arr=0,new_size_x=0,new_size_y=0;
-	std::vector<cellType>	new_map;
+	mrpt::utils::CCopyOnWriteGrid<cellType>	new_map;
 
 	if( new_x_min > new_x_max )
 	{
@@ -160,6 +231,7 @@ void  COccupancyGridMap2D::resizeGrid(float new_x_min,float new_x_max,float new_
 
 	// For the precomputed likelihood trick:
 	precomputedLikelihoodToBeRecomputed = true;
+	m_dt.clear();
 
 	// Add an additional margin:
 	if (additionalMargin)
@@ -210,23 +282,18 @@ void  COccupancyGridMap2D::resizeGrid(float new_x_min,float new_x_max,float new_
 #endif
 
 	// Reserve new mem block
-	new_map.resize(new_size_x*new_size_y, p2l(new_cells_default_value));
+	new_map.resize(new_size_x,new_size_y, p2l(new_cells_default_value));
 
 	// Copy all the old map rows into the new map:
 	{
-		cellType  	*dest_ptr = &new_map[extra_x_izq + extra_y_arr*new_size_x];
-		cellType  	*src_ptr  = &map[0];
-		size_t 		row_size = size_x*sizeof(cellType);
+		const size_t 	row_size = size_x*sizeof(cellType);
 
 		for (size_t y = 0;y<size_y;y++)
 		{
 #if defined(_DEBUG) || (MRPT_ALWAYS_CHECKS_DEBUG)
-			assert( dest_ptr+row_size-1 <= &new_map[new_map.size()-1] );
-			assert( src_ptr+row_size-1 <= &map[map.size()-1] );
+			assert( extra_x_izq+size_x <= new_size_x && extra_y_arr+y < new_size_y );
 #endif
-			memcpy( dest_ptr, src_ptr, row_size );
-			dest_ptr += new_size_x;
-			src_ptr  += size_x;
+			memcpy( new_map.getRowForWrite(extra_y_arr+y)+extra_x_izq, map.getRow(y), row_size );
 		}
 	}
 
@@ -264,6 +331,7 @@ void COccupancyGridMap2D::freeMap()
 
 	// For the precomputed likelihood trick:
 	precomputedLikelihoodToBeRecomputed = true;
+	m_dt.clear();
 
 	m_is_empty=true;
 
@@ -317,7 +385,8 @@ void  COccupancyGridMap2D::computeEntropy( TEntropyInfo &info ) const
 
 	info.H = info.I = 0;
 	info.effectiveMappedCells = 0;
-	for ( std::vector<cellType>::const_iterator it=map.begin();it!=map.end();++it)
+	for (unsigned int cy=0;cy<size_y;cy++)
+	for (const cellType *it=map.getRow(cy), *it_end=it+size_x;it!=it_end;++it)
 	{
 		cellTypeUnsigned  i = static_cast<cellTypeUnsigned>(*it);
 		h = entropyTable[ i ];
@@ -367,6 +436,7 @@ void  COccupancyGridMap2D::internal_clear()
 	//resetFeaturesCache();
 	// For the precomputed likelihood trick:
 	precomputedLikelihoodToBeRecomputed = true;
+	m_dt.clear();
 }
 
 /*---------------------------------------------------------------
@@ -375,10 +445,10 @@ void  COccupancyGridMap2D::internal_clear()
 void  COccupancyGridMap2D::fill(float default_value)
 {
 	cellType		defValue = p2l( default_value );
-	for (std::vector<cellType>::iterator	it=map.begin();it<map.end();++it)
-		*it = defValue;
+	map.fill(defValue);
 	// For the precomputed likelihood trick:
 	precomputedLikelihoodToBeRecomputed = true;
+	m_dt.clear();
 	//resetFeaturesCache();
 }
 
@@ -392,7 +462,8 @@ void  COccupancyGridMap2D::updateCell(int x,int y, float v)
 		return;
 
 	// Get the current contents of the cell:
-	cellType	&theCell = map[x+y*size_x];
+	cellType	&theCell = map.cellForWrite(x,y);
+	const bool	wasOccupied = theCell<p2l(0.5f);
 
 	// Compute the new Bayesian-fused value of the cell:
 	if ( updateInfoChangeOnly.enabled )
@@ -418,6 +489,9 @@ void  COccupancyGridMap2D::updateCell(int x,int y, float v)
 			else	theCell += obs;
 		}
 	}
+
+	if (!m_dt.empty() && wasOccupied!=(theCell<p2l(0.5f)) )
+		invalidateDistanceTransform(x,y,x,y);
 }
 
 
@@ -426,7 +500,7 @@ void  COccupancyGridMap2D::updateCell(int x,int y, float v)
  ---------------------------------------------------------------*/
 void  COccupancyGridMap2D::subSample( int downRatio )
 {
-	std::vector<cellType>		newMap;
+	mrpt::utils::CCopyOnWriteGrid<cellType>		newMap;
 
 	ASSERT_(downRatio>0);
 
@@ -435,7 +509,7 @@ void  COccupancyGridMap2D::subSample( int downRatio )
 	int		newSizeX = round((x_max-x_min)/resolution);
 	int		newSizeY = round((y_max-y_min)/resolution);
 
-	newMap.resize(newSizeX*newSizeY);
+	newMap.resize(newSizeX,newSizeY);
 
 	for (int x=0;x<newSizeX;x++)
 	{
@@ -449,13 +523,13 @@ void  COccupancyGridMap2D::subSample( int downRatio )
 
 			newCell /= (downRatio*downRatio);
 
-			newMap[ x + y*newSizeX ] = p2l(newCell);
+			newMap.cellForWrite(x,y) = p2l(newCell);
 		}
 	}
 
 
 	setSize(x_min,x_max,y_min,y_max,resolution);
-	map = newMap;
+	map.swap(newMap);
 
 
 }
@@ -575,7 +649,7 @@ void COccupancyGridMap2D::determineMatching2D(
 			for (int cy=cy_min;cy<=cy_max;cy++)
 			{
 				// Is an occupied cell?
-				if ( map[cx+cy*size_x] < thresholdCellValue )//  getCell(cx,cy)<0.49)
+				if ( map(cx,cy) < thresholdCellValue )//  getCell(cx,cy)<0.49)
 				{
 					const float residual_x = idx2x(cx)- x_local;
 					const float residual_y = idx2y(cy)- y_local;
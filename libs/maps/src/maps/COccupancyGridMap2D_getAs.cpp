@@ -35,10 +35,10 @@ void  COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{	// 8bit gray-scale
 			img.resize(size_x,size_y,1,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				const cellType	*srcPtr = map.getRow(y);
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -51,10 +51,10 @@ void  COccupancyGridMap2D::getAsImage(
 		else
 		{	// 24bit RGB:
 			img.resize(size_x,size_y,3,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				const cellType	*srcPtr = map.getRow(y);
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -74,10 +74,10 @@ void  COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{	// 8bit gray-scale
 			img.resize(size_x,size_y,1,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				const cellType	*srcPtr = map.getRow(y);
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -96,10 +96,10 @@ void  COccupancyGridMap2D::getAsImage(
 		else
 		{	// 24bit RGB:
 			img.resize(size_x,size_y,3,true); //verticalFlip);
-			const cellType	*srcPtr = &map[0];
 			unsigned char	*destPtr;
 			for (unsigned int y=0;y<size_y;y++)
 			{
+				const cellType	*srcPtr = map.getRow(y);
 				if (!verticalFlip)
 						destPtr = img(0,size_y-1-y);
 				else 	destPtr = img(0,y);
@@ -166,10 +166,10 @@ void  COccupancyGridMap2D::getAs3DObject(mrpt::opengl::CSetOfObjectsPtr	&outSetO
 	CImage			imgTrans(size_x,size_y,1);
 
 
-	const cellType		*srcPtr = &map[0];
 	
 	for (unsigned int y=0;y<size_y;y++)
 	{
+		const cellType		*srcPtr = map.getRow(y);
 		unsigned char *destPtr_color = imgColor(0,y);
 		unsigned char *destPtr_trans = imgTrans(0,y);
 		for (unsigned int x=0;x<size_x;x++)
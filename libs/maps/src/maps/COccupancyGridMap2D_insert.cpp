@@ -212,9 +212,8 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 				// -----------------------
 				resizeGrid(new_x_min,new_x_max, new_y_min,new_y_max,0.5);
 
-				// For updateCell_fast methods:
-				cellType  *theMapArray = &map[0];
-				unsigned  theMapSize_x = size_x;
+				// Only the cells within maxDistanceInsertion from the sensor may change:
+				invalidateDistanceTransform( x2idx(px-maxDistanceInsertion),y2idx(py-maxDistanceInsertion), x2idx(px+maxDistanceInsertion),y2idx(py+maxDistanceInsertion) );
 
 				int  cx0 = x2idx(px);		// Remember: This must be after the resizeGrid!!
 				int  cy0 = y2idx(py);
@@ -261,7 +260,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 
 					for (int nStep = 0;nStep<nStepsRay;nStep++)
 					{
-						updateCell_fast_free(cx,cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+						updateCell_fast_free( map.getRowForWrite(cy)+cx, logodd_observation, logodd_thres_free );
 
 						frCX += frAcx;
 						frCY += frAcy;
@@ -275,7 +274,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 					//  - It was a valid ray, and
 					//  - The ray was not truncated
 					if ( o->validRange[idx] && o->scan[idx]<maxDistanceInsertion )
-						updateCell_fast_occupied(trg_cx,trg_cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+						updateCell_fast_occupied( map.getRowForWrite(trg_cy)+trg_cx, logodd_observation_occupied, logodd_thres_occupied );
 
 				}  // End of each range
 
@@ -364,9 +363,8 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 				// -----------------------
 				resizeGrid(new_x_min,new_x_max, new_y_min,new_y_max,0.5);
 
-				// For updateCell_fast methods:
-				cellType  *theMapArray = &map[0];
-				unsigned  theMapSize_x = size_x;
+				// Only the cells within maxDistanceInsertion from the sensor may change:
+				invalidateDistanceTransform( x2idx(px-maxDistanceInsertion),y2idx(py-maxDistanceInsertion), x2idx(px+maxDistanceInsertion),y2idx(py+maxDistanceInsertion) );
 
 				//int  cx0 = x2idx(px);		// Remember: This must be after the resizeGrid!!
 				//int  cy0 = y2idx(py);
@@ -454,7 +452,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						int max_cx = max3(P0.cx,P1.cx,P2.cx);
 
 						for (int ccx=min_cx;ccx<=max_cx;ccx++)
-							updateCell_fast_free(ccx,P0.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+							updateCell_fast_free( map.getRowForWrite(P0.cy)+ccx, logodd_observation, logodd_thres_free );
 					}
 					else
 					{
@@ -526,7 +524,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 							//	last_insert_cx = R1.cx;
 
 								for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-									updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+									updateCell_fast_free( map.getRowForWrite(R1.cy)+ccx, logodd_observation, logodd_thres_free );
 							}
 
 							R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -597,7 +595,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 							//	last_insert_cx = R1.cx;
 								last_insert_cy = R1.cy;
 								for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-									updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+									updateCell_fast_free( map.getRowForWrite(R1.cy)+ccx, logodd_observation, logodd_thres_free );
 							}
 
 							R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -638,7 +636,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						// Special case: Only one cell:
 						if (P2.cx==P1.cx && P2.cy==P1.cy)
 						{
-							updateCell_fast_occupied(P1.cx,P1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+							updateCell_fast_occupied( map.getRowForWrite(P1.cy)+P1.cx, logodd_observation_occupied, logodd_thres_occupied );
 						}
 						else
 						{
@@ -660,7 +658,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 
 							for (int nStep=0;nStep<=nSteps;nStep++)
 							{
-								updateCell_fast_occupied(R1.cx,R1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+								updateCell_fast_occupied( map.getRowForWrite(R1.cy)+R1.cx, logodd_observation_occupied, logodd_thres_occupied );
 
 								R1.frX += frAcxE;
 								R1.frY += frAcyE;
@@ -818,9 +816,8 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 			// -----------------------
 			resizeGrid(new_x_min,new_x_max, new_y_min,new_y_max,0.5);
 
-			// For updateCell_fast methods:
-			cellType  *theMapArray = &map[0];
-			unsigned  theMapSize_x = size_x;
+			// Only the cells within maxDistanceInsertion from the sensor may change:
+			invalidateDistanceTransform( x2idx(px-maxDistanceInsertion),y2idx(py-maxDistanceInsertion), x2idx(px+maxDistanceInsertion),y2idx(py+maxDistanceInsertion) );
 
 			//int  cx0 = x2idx(px);		// Remember: This must be after the resizeGrid!!
 			//int  cy0 = y2idx(py);
@@ -900,7 +897,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 					int max_cx = max3(P0.cx,P1.cx,P2.cx);
 
 					for (int ccx=min_cx;ccx<=max_cx;ccx++)
-						updateCell_fast_free(ccx,P0.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+						updateCell_fast_free( map.getRowForWrite(P0.cy)+ccx, logodd_observation, logodd_thres_free );
 				}
 				else
 				{
@@ -971,7 +968,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						//	last_insert_cx = R1.cx;
 
 							for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-								updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+								updateCell_fast_free( map.getRowForWrite(R1.cy)+ccx, logodd_observation, logodd_thres_free );
 						}
 
 						R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -1041,7 +1038,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 						//	last_insert_cx = R1.cx;
 							last_insert_cy = R1.cy;
 							for (int ccx=R1.cx;ccx<=R2.cx;ccx++)
-								updateCell_fast_free(ccx,R1.cy, logodd_observation, logodd_thres_free, theMapArray, theMapSize_x );
+								updateCell_fast_free( map.getRowForWrite(R1.cy)+ccx, logodd_observation, logodd_thres_free );
 						}
 
 						R1.frX += frAx_R1;    R1.frY += frAy_R1;
@@ -1082,7 +1079,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 					// Special case: Only one cell:
 					if (P2.cx==P1.cx && P2.cy==P1.cy)
 					{
-						updateCell_fast_occupied(P1.cx,P1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+						updateCell_fast_occupied( map.getRowForWrite(P1.cy)+P1.cx, logodd_observation_occupied, logodd_thres_occupied );
 					}
 					else
 					{
@@ -1104,7 +1101,7 @@ bool  COccupancyGridMap2D::internal_insertObservation(
 
 						for (int nStep=0;nStep<=nSteps;nStep++)
 						{
-							updateCell_fast_occupied(R1.cx,R1.cy, logodd_observation_occupied, logodd_thres_occupied, theMapArray, theMapSize_x );
+							updateCell_fast_occupied( map.getRowForWrite(R1.cy)+R1.cx, logodd_observation_occupied, logodd_thres_occupied );
 
 							R1.frX += frAcxE;
 							R1.frY += frAcyE;
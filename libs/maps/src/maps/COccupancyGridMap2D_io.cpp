@@ -47,7 +47,7 @@ bool  COccupancyGridMap2D::saveAsBitmapFile(const std::string &file) const
 void  COccupancyGridMap2D::writeToStream(CStream &out, int *version) const
 {
 	if (version)
-		*version = 5;
+		*version = 6;
 	else
 	{
 		// Version 3: Change to log-odds. The only change is in the loader, when translating
@@ -63,11 +63,15 @@ void  COccupancyGridMap2D::writeToStream(CStream &out, int *version) const
 		out << size_x << size_y << x_min << x_max << y_min << y_max << resolution;
 		ASSERT_(size_x*size_y==map.size());
 
+		// Cells are stored row by row in the stream:
+		for (uint32_t cy=0;cy<size_y;cy++)
+		{
 #ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-		out.WriteBuffer(&map[0], sizeof(map[0])*size_x*size_y);
+			out.WriteBuffer(map.getRow(cy), sizeof(cellType)*size_x);
 #else
-		out.WriteBufferFixEndianness(&map[0], size_x*size_y);
+			out.WriteBufferFixEndianness(map.getRow(cy), size_x);
 #endif
+		}
 
 		// insertionOptions:
 		out <<	insertionOptions.mapAltitude
@@ -108,6 +112,9 @@ void  COccupancyGridMap2D::writeToStream(CStream &out, int *version) const
 		// Version: 5;
 		out << insertionOptions.wideningBeamsWithDistance;
 
+		// Version: 6;
+		out << likelihoodOptions.LF_useDistanceTransform;
+
 	}
 }
 
@@ -126,6 +133,7 @@ void  COccupancyGridMap2D::readFromStream(CStream &in, int version)
 	case 3:
 	case 4:
 	case 5:
+	case 6:
 		{
 #			ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
 				const uint8_t	MyBitsPerCell = 8;
@@ -152,14 +160,43 @@ void  COccupancyGridMap2D::readFromStream(CStream &in, int version)
 
 			ASSERT_(size_x*size_y==map.size());
 
-			if (bitsPerCellStream==MyBitsPerCell)
+			// Streams with the data already in memory (e.g. memory-mapped files) can lend us the cells without copying
+			//  them, if they have our cell size, byte order and alignment. Each row will be copied upon the first write to it.
+			const void *borrowedCells = NULL;
+			CMemoryMappedRegionPtr  borrowedOwner;
+#if !MRPT_IS_BIG_ENDIAN || defined(OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS)
+			if (bitsPerCellStream==MyBitsPerCell && map.size())
+			{
+				borrowedCells = in.ReadBufferBorrow(sizeof(cellType)*map.size(), borrowedOwner);
+				if (borrowedCells && (reinterpret_cast<size_t>(borrowedCells) % sizeof(cellType))!=0)
+				{
+					// Misaligned: copy them
+					for (uint32_t cy=0;cy<size_y;cy++)
+						::memcpy(map.getRowForWrite(cy), static_cast<const cellType*>(borrowedCells)+cy*size_x, sizeof(cellType)*size_x);
+					borrowedOwner.clear_unique();
+				}
+				else if (borrowedCells)
+				{
+					map.assignBorrowed(size_x,size_y,static_cast<const cellType*>(borrowedCells),borrowedOwner);
+				}
+			}
+#endif
+
+			if (borrowedCells)
+			{
+				// Nothing else to read: the cells are already in "map"
+			}
+			else if (bitsPerCellStream==MyBitsPerCell)
 			{
 				// Perfect:
+				for (uint32_t cy=0;cy<size_y;cy++)
+				{
 			#ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-				in.ReadBuffer(&map[0], sizeof(map[0])*map.size());
+					in.ReadBuffer(map.getRowForWrite(cy), sizeof(cellType)*size_x);
 			#else
-				in.ReadBufferFixEndianness(&map[0], map.size());
+					in.ReadBufferFixEndianness(map.getRowForWrite(cy), size_x);
 			#endif
+				}
 			}
 			else
 			{
@@ -170,43 +207,50 @@ void  COccupancyGridMap2D::readFromStream(CStream &in, int version)
 				std::vector<uint16_t>    auxMap( map.size() );
 				in.ReadBuffer(&auxMap[0], sizeof(auxMap[0])*auxMap.size());
 
-				size_t  i, N = map.size();
-				uint8_t         *ptrTrg = (uint8_t*)&map[0];
 				const uint16_t  *ptrSrc = (const uint16_t*)&auxMap[0];
-				for (i=0;i<N;i++)
-					*ptrTrg++ = (*ptrSrc++) >> 8;
+				for (uint32_t cy=0;cy<size_y;cy++)
+				{
+					uint8_t  *ptrTrg = (uint8_t*)map.getRowForWrite(cy);
+					for (uint32_t cx=0;cx<size_x;cx++)
+						*ptrTrg++ = (*ptrSrc++) >> 8;
+				}
 #			else
 				// We are 16-bit, stream is 8-bit
 				ASSERT_(bitsPerCellStream==8);
 				std::vector<uint8_t>    auxMap( map.size() );
 				in.ReadBuffer(&auxMap[0], sizeof(auxMap[0])*auxMap.size());
 
-				size_t  i, N = map.size();
-				uint16_t       *ptrTrg = (uint16_t*)&map[0];
 				const uint8_t  *ptrSrc = (const uint8_t*)&auxMap[0];
-				for (i=0;i<N;i++)
-					*ptrTrg++ = (*ptrSrc++) << 8;
+				for (uint32_t cy=0;cy<size_y;cy++)
+				{
+					uint16_t  *ptrTrg = (uint16_t*)map.getRowForWrite(cy);
+					for (uint32_t cx=0;cx<size_x;cx++)
+						*ptrTrg++ = (*ptrSrc++) << 8;
+				}
 #			endif
 			}
 
 			// If we are converting an old dump, convert from probabilities to log-odds:
 			if (version<3)
 			{
-				size_t  i, N = map.size();
-				cellType  *ptr = &map[0];
-				for (i=0;i<N;i++)
+				for (uint32_t cy=0;cy<size_y;cy++)
 				{
-					double p = cellTypeUnsigned(*ptr) * (1.0f/0xFF);
-					if (p<0)
-						p=0;
-					if (p>1)
-						p=1;
-					*ptr++ = p2l( p );
+					cellType  *ptr = map.getRowForWrite(cy);
+					for (uint32_t cx=0;cx<size_x;cx++)
+					{
+						double p = cellTypeUnsigned(*ptr) * (1.0f/0xFF);
+						if (p<0)
+							p=0;
+						if (p>1)
+							p=1;
+						*ptr++ = p2l( p );
+					}
 				}
 			}
 
 			// For the precomputed likelihood trick:
 			precomputedLikelihoodToBeRecomputed = true;
+			m_dt.clear();
 
 			if (version>=1)
 			{
@@ -255,6 +299,12 @@ void  COccupancyGridMap2D::readFromStream(CStream &in, int version)
 				in >> insertionOptions.wideningBeamsWithDistance;
 			}
 
+			if (version>=6)
+			{
+				in >> likelihoodOptions.LF_useDistanceTransform;
+			}
+			else likelihoodOptions.LF_useDistanceTransform = false;
+
 		} break;
 	default:
 		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
@@ -296,6 +346,7 @@ bool  COccupancyGridMap2D::loadFromBitmap(const mrpt::utils::CImage &imgFl, floa
 
 	// For the precomputed likelihood trick:
 	precomputedLikelihoodToBeRecomputed = true;
+	m_dt.clear();
 
 	size_t bmpWidth = imgFl.getWidth();
 	size_t bmpHeight = imgFl.getHeight();
@@ -13,6 +13,10 @@
 #include <mrpt/slam/CObservation2DRangeScan.h>
 #include <mrpt/slam/CObservationRange.h>
 #include <mrpt/slam/CSimplePointsMap.h>
+#include <mrpt/system/parallelization.h>
+#include <mrpt/synch/CCriticalSection.h>
+
+#include "COccupancyGridMap2D_SSEx.h"
 
 
 using namespace mrpt;
@@ -21,6 +25,24 @@ using namespace mrpt::utils;
 using namespace mrpt::poses;
 using namespace std;
 
+namespace
+{
+	// The distance transform is stored in tiles of DT_TILE_SIZE x DT_TILE_SIZE cells:
+	const unsigned int DT_TILE_BITS  = 4;
+	const unsigned int DT_TILE_SIZE  = 1 << DT_TILE_BITS;
+	const unsigned int DT_TILE_CELLS = DT_TILE_SIZE*DT_TILE_SIZE;
+
+	// The bits of a 4-bit number, spread to the even bit positions:
+	const uint8_t dt_morton_spread[DT_TILE_SIZE] = { 0x00,0x01,0x04,0x05,0x10,0x11,0x14,0x15,0x40,0x41,0x44,0x45,0x50,0x51,0x54,0x55 };
+
+	/** Index in COccupancyGridMap2D::m_dt of the cell (cx,cy) */
+	inline size_t dt_cell_offset(unsigned int cx, unsigned int cy, unsigned int tiles_x)
+	{
+		const size_t tile = (cy>>DT_TILE_BITS)*tiles_x + (cx>>DT_TILE_BITS);
+		return (tile<<(2*DT_TILE_BITS)) | dt_morton_spread[cx & (DT_TILE_SIZE-1)] | (dt_morton_spread[cy & (DT_TILE_SIZE-1)]<<1);
+	}
+}
+
 
 
 /*---------------------------------------------------------------
@@ -32,6 +54,17 @@ using namespace std;
 double	 COccupancyGridMap2D::computeObservationLikelihood(
 			const CObservation		*obs,
 			const CPose3D			&takenFrom3D )
+{
+	return internal_computeObservationLikelihood(obs,takenFrom3D,NULL);
+}
+
+/*---------------------------------------------------------------
+			internal_computeObservationLikelihood
+ ---------------------------------------------------------------*/
+double	 COccupancyGridMap2D::internal_computeObservationLikelihood(
+			const CObservation		*obs,
+			const CPose3D			&takenFrom3D,
+			TLikelihoodFieldBuffers	*buffers )
 {
 	// Ignore laser scans if they are not planar or they are not
 	//  at the altitude of this grid map:
@@ -67,7 +100,7 @@ double	 COccupancyGridMap2D::computeObservationLikelihood(
 		return computeObservationLikelihood_CellsDifference(obs,takenFrom);
 
 	case lmLikelihoodField_Thrun:
-		return computeObservationLikelihood_likelihoodField_Thrun(obs,takenFrom);
+		return computeObservationLikelihood_likelihoodField_Thrun(obs,takenFrom,buffers);
 
 	case lmLikelihoodField_II:
 		return computeObservationLikelihood_likelihoodField_II(obs,takenFrom);
@@ -78,6 +111,79 @@ double	 COccupancyGridMap2D::computeObservationLikelihood(
 
 }
 
+// Body of the parallel_for() in computeObservationLikelihoodForPoses():
+struct COccupancyGridMap2D::TLikelihoodForPosesEvaluator
+{
+	COccupancyGridMap2D          &grid;
+	const CObservation           *obs;
+	const std::vector<mrpt::math::TPose3D>   &poses;
+	vector_double                &out_log_liks;
+
+	TLikelihoodForPosesEvaluator(COccupancyGridMap2D &_grid, const CObservation *_obs, const std::vector<mrpt::math::TPose3D> &_poses, vector_double &_out_log_liks) :
+		grid(_grid), obs(_obs), poses(_poses), out_log_liks(_out_log_liks)
+	{ }
+
+	void operator()(const mrpt::system::BlockedRange &r) const
+	{
+		// The scratch buffers are shared by all the poses of this sub-range, which are evaluated by one thread:
+		TLikelihoodFieldBuffers buffers;
+		for (int i=r.begin();i!=r.end();++i)
+			out_log_liks[i] = grid.internal_computeObservationLikelihood(obs, CPose3D(poses[i]), &buffers);
+	}
+};
+
+/*---------------------------------------------------------------
+			computeObservationLikelihoodForPoses
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeObservationLikelihoodForPoses(
+	const CObservation           *obs,
+	const std::vector<mrpt::math::TPose3D>   &takenFrom,
+	vector_double                &out_log_liks )
+{
+	MRPT_START
+
+	const size_t N = takenFrom.size();
+	out_log_liks.resize(N);
+	if (!N) return;
+
+	bool parallelizable = false;
+	switch (likelihoodOptions.likelihoodMethod)
+	{
+	case lmLikelihoodField_Thrun:
+	case lmLikelihoodField_II:
+	case lmRayTracing:
+	case lmConsensus:
+		parallelizable = true;
+		break;
+	default:
+		break;
+	};
+
+	// The distance transform (if used) is brought up to date here, so the threads only read it.
+	// The first pose is always evaluated here, since it also builds all the lazily-initialized data
+	//  (the observation points map, the reset of "precomputedLikelihood",...) which is only read afterwards.
+	//  The only shared state written by the threads are "precomputedLikelihood" entries, which may be computed
+	//  by several threads at once but always with exactly the same value.
+	if (likelihoodOptions.likelihoodMethod==lmLikelihoodField_Thrun)
+		updateDistanceTransform();
+	TLikelihoodFieldBuffers buffers;
+	out_log_liks[0] = internal_computeObservationLikelihood(obs, CPose3D(takenFrom[0]), &buffers);
+
+	if (parallelizable)
+	{
+		mrpt::system::parallel_for(
+			mrpt::system::BlockedRange(1,static_cast<int>(N),16),
+			TLikelihoodForPosesEvaluator(*this,obs,takenFrom,out_log_liks) );
+	}
+	else
+	{
+		for (size_t i=1;i<N;i++)
+			out_log_liks[i] = internal_computeObservationLikelihood(obs, CPose3D(takenFrom[i]), &buffers);
+	}
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 			computeObservationLikelihood_Consensus
 ---------------------------------------------------------------*/
@@ -457,7 +563,8 @@ double	 COccupancyGridMap2D::computeObservationLikelihood_rayTracing(
 ---------------------------------------------------------------*/
 double	 COccupancyGridMap2D::computeObservationLikelihood_likelihoodField_Thrun(
 			const CObservation		*obs,
-			const CPose2D				&takenFrom )
+			const CPose2D				&takenFrom,
+			TLikelihoodFieldBuffers	*buffers )
 {
 	MRPT_START
 
@@ -482,7 +589,7 @@ double	 COccupancyGridMap2D::computeObservationLikelihood_likelihoodField_Thrun(
 		opts.horizontalTolerance		= insertionOptions.horizontalTolerance;
 
 		// Compute the likelihood of the points in this grid map:
-		ret = computeLikelihoodField_Thrun( o->buildAuxPointsMap<mrpt::slam::CPointsMap>(&opts), &takenFrom );
+		ret = computeLikelihoodField_Thrun( o->buildAuxPointsMap<mrpt::slam::CPointsMap>(&opts), &takenFrom, buffers );
 
 	} // end of observation is a scan range 2D
 	else if ( IS_CLASS(obs, CObservationRange) )
@@ -497,7 +604,7 @@ double	 COccupancyGridMap2D::computeObservationLikelihood_likelihoodField_Thrun(
 	    pts.insertObservation(o);
 
 		// Compute the likelihood of the points in this grid map:
-		ret = computeLikelihoodField_Thrun( &pts, &takenFrom );
+		ret = computeLikelihoodField_Thrun( &pts, &takenFrom, buffers );
 	}
 
 	return ret;
@@ -546,7 +653,7 @@ double	 COccupancyGridMap2D::computeObservationLikelihood_likelihoodField_II(
 /*---------------------------------------------------------------
 					computeLikelihoodField_Thrun
  ---------------------------------------------------------------*/
-double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm, const CPose2D *relativePose )
+double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm, const CPose2D *relativePose, TLikelihoodFieldBuffers *buffers )
 {
 	MRPT_START
 
@@ -572,7 +679,6 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 	float		zRandomMaxRange	= likelihoodOptions.LF_maxRange;
 	float		zRandomTerm = zRandom / zRandomMaxRange;
 	float		Q = -0.5f / square(stdHit);
-	int			M = 0;
 
 	unsigned int	size_x_1 = size_x-1;
 	unsigned int	size_y_1 = size_y-1;
@@ -609,54 +715,96 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 
 	if (N<10) decimation = 1;
 
-	TPoint2D	pointLocal;
-	TPoint2D	pointGlobal;
-
-	for (size_t j=0;j<N;j+= decimation)
+	// 1) The (decimated) local points, as separate x[] and y[] arrays:
+	const std::vector<float> &pm_xs = pm->getPointsBufferRef_x();
+	const std::vector<float> &pm_ys = pm->getPointsBufferRef_y();
+	const size_t nPts = (N+decimation-1)/decimation;
+
+	TLikelihoodFieldBuffers local_buffers;
+	TLikelihoodFieldBuffers &bufs = buffers ? *buffers : local_buffers;
+	std::vector<float> &dec_xs = bufs.xs, &dec_ys = bufs.ys;
+	const float *xs = &pm_xs[0];
+	const float *ys = &pm_ys[0];
+	if (decimation>1)
 	{
-
-		occupiedMinDist = maxCorrDist_sq; // The max.distance
-
-		// Get the point and pass it to global coordinates:
-		if (relativePose)
+		dec_xs.resize(nPts);
+		dec_ys.resize(nPts);
+		for (size_t j=0,k=0;j<N;j+=decimation,k++)
 		{
-			pm->getPoint(j,pointLocal);
-			//pointGlobal = *relativePose + pointLocal;
+			dec_xs[k] = pm_xs[j];
+			dec_ys[k] = pm_ys[j];
+		}
+		xs = &dec_xs[0];
+		ys = &dec_ys[0];
+	}
+
+	// 2) Pass them to global coordinates and then to cell indices (-1: out of the map):
+	double pose_x=0, pose_y=0;
+	ccos = 1; ssin = 0;
+	if (relativePose)
+	{
+		pose_x = relativePose->x();
+		pose_y = relativePose->y();
 #ifdef HAVE_SINCOS
-			::sincos(relativePose->phi(), &ssin,&ccos);
+		::sincos(relativePose->phi(), &ssin,&ccos);
 #else
-			ccos = cos(relativePose->phi());
-			ssin = sin(relativePose->phi());
+		ccos = cos(relativePose->phi());
+		ssin = sin(relativePose->phi());
 #endif
-			pointGlobal.x = relativePose->x() + pointLocal.x * ccos - pointLocal.y * ssin;
-			pointGlobal.y = relativePose->y() + pointLocal.x * ssin + pointLocal.y * ccos;
-		}
-		else
-		{
-			pm->getPoint(j,pointGlobal);
-		}
+	}
 
+	std::vector<int> &cellIdxs = bufs.cellIdxs;
+	cellIdxs.resize(nPts);
+#if MRPT_HAS_SSE2
+	grid_SSE2_points_to_cells(xs,ys,nPts, pose_x,pose_y,ccos,ssin, x_min,y_min,resolution, size_x,size_y, &cellIdxs[0]);
+#else
+	for (size_t k=0;k<nPts;k++)
+	{
 		// Point to cell indixes
-		int cx = x2idx( pointGlobal.x );
-		int cy = y2idx( pointGlobal.y );
+		const int cx = x2idx( pose_x + xs[k] * ccos - ys[k] * ssin );
+		const int cy = y2idx( pose_y + xs[k] * ssin + ys[k] * ccos );
 
-		// Precomputed table:
 		// Tip: Comparison cx<0 is implicit in (unsigned)(x)>size...
-		if ( static_cast<unsigned>(cx)>=size_x_1 || static_cast<unsigned>(cy)>=size_y_1 )
+		cellIdxs[k] = ( static_cast<unsigned>(cx)>=size_x_1 || static_cast<unsigned>(cy)>=size_y_1 ) ? -1 : cx+cy*size_x;
+	}
+#endif
+
+	// 3) The likelihood of each point:
+	std::vector<double> &liks = bufs.liks;
+	liks.resize(nPts);
+	if (likelihoodOptions.LF_useDistanceTransform)
+	{
+		// Just look them up in the distance transform:
+		updateDistanceTransform();
+		for (size_t k=0;k<nPts;k++)
 		{
-			// We are outside of the map: Assign the likelihood for the max. correspondence distance:
-			thisLik = minimumLik;
+			const int idx = cellIdxs[k];
+			liks[k] = idx<0 ? minimumLik : m_dt_lik_table[ m_dt[ dt_cell_offset(idx % size_x, idx / size_x, m_dt_tiles_x) ] ];
 		}
-		else
+	}
+	else
+	{
+		for (size_t k=0;k<nPts;k++)
 		{
+			const int idx = cellIdxs[k];
+			if (idx<0)
+			{
+				// We are outside of the map: Assign the likelihood for the max. correspondence distance:
+				liks[k] = minimumLik;
+				continue;
+			}
+
 			// We are into the map limits:
-            if (likelihoodOptions.enableLikelihoodCache)
-            {
-                thisLik = precomputedLikelihood[ cx+cy*size_x ];
-            }
+			if (likelihoodOptions.enableLikelihoodCache)
+			{
+				thisLik = precomputedLikelihood[ idx ];
+			}
 
 			if (!likelihoodOptions.enableLikelihoodCache || thisLik==LIK_LF_CACHE_INVALID )
 			{
+				const int cx = idx % size_x;
+				const int cy = idx / size_x;
+
 				// Compute now:
 				// -------------
 				// Find the closest occupied cell in a certain range, given by K:
@@ -665,18 +813,8 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 				int yy1 = max(0,cy-K);
 				int yy2 = min(size_y_1,(unsigned)(cy+K));
 
-				/** /
-				for (yy=yy1;yy<=yy2;yy++)
-					for (xx=xx1;xx<=xx2;xx++)
-						if ( map[xx+yy*size_x] < thresholdCellValue )
-							occupiedMinDist = min( occupiedMinDist, square(idx2x(xx)-pointGlobal_x)+square(idx2y(yy)-pointGlobal_y) );
-				*/
-
 				// Optimized code: this part will be invoked a *lot* of times:
 				{
-					cellType  *mapPtr  = &map[xx1+yy1*size_x]; // Initial pointer position
-					unsigned   incrAfterRow = size_x - ((xx2-xx1)+1);
-
 					signed int Ax0 = 10*(xx1-cx);
 					signed int Ay  = 10*(yy1-cy);
 
@@ -687,6 +825,7 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 						unsigned int Ay2 = square((unsigned int)(Ay)); // Square is faster with unsigned.
 						signed short Ax=Ax0;
 						cellType  cell;
+						const cellType  *mapPtr = map.getRow(yy)+xx1;  // Initial pointer position
 
 						for (int xx=xx1;xx<=xx2;xx++)
 						{
@@ -697,8 +836,6 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 							}
 							Ax += 10;
 						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
 						Ay += 10;
 					}
 
@@ -707,32 +844,177 @@ double	 COccupancyGridMap2D::computeLikelihoodField_Thrun( const CPointsMap	*pm,
 
 				thisLik = zRandomTerm  + zHit * exp( Q * occupiedMinDist );
 
-                if (likelihoodOptions.enableLikelihoodCache)
-                    // And save it into the table and into "thisLik":
-                    precomputedLikelihood[ cx+cy*size_x ] = thisLik;
+				if (likelihoodOptions.enableLikelihoodCache)
+					// And save it into the table and into "thisLik":
+					precomputedLikelihood[ idx ] = thisLik;
 			}
-		}
+			liks[k] = thisLik;
+		} // end of for each point in the scan
+	}
 
-		// Update the likelihood:
-		if (Product_T_OrSum_F)
-		{
-			ret += log(thisLik);
-		}
-		else
+	// 4) Update the likelihood:
+	if (Product_T_OrSum_F)
+	{
+#if MRPT_HAS_SSE2
+		ret = grid_SSE2_sum_log(&liks[0],nPts);
+#else
+		for (size_t k=0;k<nPts;k++)
+			ret += log(liks[k]);
+#endif
+	}
+	else
+	{
+		for (size_t k=0;k<nPts;k++)
+			ret += liks[k];
+		ret = log( ret / nPts );
+	}
+
+	return ret;
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					updateDistanceTransform
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::updateDistanceTransform()
+{
+	MRPT_START
+
+	if (!likelihoodOptions.LF_useDistanceTransform || map.empty())
+		return;
+
+	// The search window must be the same as in computeLikelihoodField_Thrun():
+	const int K = (int)ceil(likelihoodOptions.LF_maxCorrsDistance/*m*/ / resolution);
+	ASSERT_(K>=0 && K<=255)  // Squared distances must fit into uint16_t
+	const uint16_t maxDist2 = static_cast<uint16_t>(K*K);
+
+	const uint32_t tiles_x = (size_x+DT_TILE_SIZE-1) >> DT_TILE_BITS;
+	const uint32_t tiles_y = (size_y+DT_TILE_SIZE-1) >> DT_TILE_BITS;
+	const size_t nTiles = size_t(tiles_x)*tiles_y;
+
+	// The likelihood for each squared distance is computed exactly as in computeLikelihoodField_Thrun(), with these parameters:
+	const double constDist2DiscrUnits = 100 / (double(resolution) * double(resolution));
+	TDistanceTransformLikParams params;
+	params.zHit = likelihoodOptions.LF_zHit;
+	params.zRandomTerm = likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	params.Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+	params.maxCorrDistInt = mrpt::utils::round( square(likelihoodOptions.LF_maxCorrsDistance) * constDist2DiscrUnits );
+	params.resolution = resolution;
+
+	const bool dt_valid = m_dt.size()==nTiles*DT_TILE_CELLS && m_dt_tiles_x==tiles_x && m_dt_K==K;
+	const bool table_valid = params==m_dt_lik_table_params && m_dt_lik_table.size()==size_t(maxDist2)+1;
+
+	// Already up to date (the usual case, e.g. for all the particles after the first one): no need to lock.
+	if (dt_valid && table_valid && !m_dt_any_dirty)
+		return;
+
+	mrpt::synch::CCriticalSectionLocker lock(&m_dt_cs);
+
+	if (m_dt.size()!=nTiles*DT_TILE_CELLS || m_dt_tiles_x!=tiles_x || m_dt_K!=K)
+	{
+		// (Re)build it entirely:
+		m_dt.assign(nTiles*DT_TILE_CELLS, maxDist2);
+		m_dt_dirty_tiles.assign(nTiles, 1);
+		m_dt_tiles_x = tiles_x;
+		m_dt_K = K;
+		m_dt_any_dirty = true;
+	}
+
+	if (!(params==m_dt_lik_table_params) || m_dt_lik_table.size()!=size_t(maxDist2)+1)
+	{
+		m_dt_lik_table.resize(size_t(maxDist2)+1);
+		for (unsigned int d2=0;d2<=maxDist2;d2++)
 		{
-			ret += thisLik;
-			M++;
+			const float occupiedMinDist = std::min(params.maxCorrDistInt, 100*d2) * (1.0/constDist2DiscrUnits);
+			m_dt_lik_table[d2] = params.zRandomTerm  + params.zHit * exp( params.Q * occupiedMinDist );
 		}
-	} // end of for each point in the scan
+		m_dt_lik_table_params = params;
+	}
 
-	if (!Product_T_OrSum_F)
-		ret = log( ret / M );
+	if (!m_dt_any_dirty)
+		return;
 
-	return ret;
+	const cellType thresholdCellValue = p2l(0.5f);
+	const int NOT_FOUND = K+1;
+	std::vector<int> colDist; // Distance to the closest occupied cell in the same column, for each column and row of a tile.
+
+	for (uint32_t ty=0;ty<tiles_y;ty++)
+	{
+		for (uint32_t tx=0;tx<tiles_x;tx++)
+		{
+			uint8_t &dirty = m_dt_dirty_tiles[tx+ty*tiles_x];
+			if (!dirty) continue;
+			dirty = 0;
+
+			// The cells of this tile, and the window of cells which may affect them:
+			const int x0 = tx*DT_TILE_SIZE, x1 = std::min<int>(x0+DT_TILE_SIZE, size_x);  // [x0,x1)
+			const int y0 = ty*DT_TILE_SIZE, y1 = std::min<int>(y0+DT_TILE_SIZE, size_y);  // [y0,y1)
+			const int xa = std::max(0,x0-K), xb = std::min<int>(size_x-1, x1-1+K);   // [xa,xb]
+			const int ya = std::max(0,y0-K), yb = std::min<int>(size_y-1, y1-1+K);   // [ya,yb]
+			const int W = xb-xa+1;
+
+			// 1st pass: vertical distances, by sweeping each column up and down:
+			colDist.assign(W*(y1-y0), NOT_FOUND);
+			for (int x=xa;x<=xb;x++)
+			{
+				int *col = &colDist[x-xa];
+				int last = -NOT_FOUND-K;
+				for (int y=ya;y<y1;y++)
+				{
+					if (map(x,y)<thresholdCellValue) last = y;
+					if (y>=y0) col[(y-y0)*W] = std::min(NOT_FOUND, y-last);
+				}
+				last = yb+NOT_FOUND+K;
+				for (int y=yb;y>=y0;y--)
+				{
+					if (map(x,y)<thresholdCellValue) last = y;
+					if (y<y1) keep_min(col[(y-y0)*W], last-y);
+				}
+			}
+
+			// 2nd pass: combine with the horizontal distances:
+			for (int y=y0;y<y1;y++)
+			{
+				const int *row = &colDist[(y-y0)*W];
+				for (int x=x0;x<x1;x++)
+				{
+					int d2 = maxDist2;
+					const int xx1 = std::max(xa,x-K), xx2 = std::min(xb,x+K);
+					for (int xx=xx1;xx<=xx2;xx++)
+					{
+						const int dy = row[xx-xa];
+						if (dy<=K) keep_min(d2, square(xx-x)+square(dy));
+					}
+					m_dt[ dt_cell_offset(x,y,tiles_x) ] = static_cast<uint16_t>(d2);
+				}
+			}
+		}
+	}
+	m_dt_any_dirty = false;
 
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+				invalidateDistanceTransform
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::invalidateDistanceTransform(int cx0,int cy0,int cx1,int cy1)
+{
+	if (m_dt.empty()) return;
+
+	// Any cell closer than K cells to the changed ones may have a new distance:
+	const int K = m_dt_K;
+	cx0 = std::max(0,cx0-K); cx1 = std::min<int>(size_x-1,cx1+K);
+	cy0 = std::max(0,cy0-K); cy1 = std::min<int>(size_y-1,cy1+K);
+	if (cx0>cx1 || cy0>cy1) return;
+
+	for (int ty=(cy0>>DT_TILE_BITS);ty<=(cy1>>DT_TILE_BITS);ty++)
+		for (int tx=(cx0>>DT_TILE_BITS);tx<=(cx1>>DT_TILE_BITS);tx++)
+			m_dt_dirty_tiles[tx+ty*m_dt_tiles_x] = 1;
+	m_dt_any_dirty = true;
+}
+
 /*---------------------------------------------------------------
 					computeLikelihoodField_II
  ---------------------------------------------------------------*/
@@ -866,7 +1148,8 @@ COccupancyGridMap2D::TLikelihoodOptions::TLikelihoodOptions() :
 	consensus_pow					( 5 ),
 	OWA_weights						(100,1/100.0f),
 
-	enableLikelihoodCache           ( true )
+	enableLikelihoodCache           ( true ),
+	LF_useDistanceTransform         ( false )
 {
 }
 
@@ -888,6 +1171,7 @@ void  COccupancyGridMap2D::TLikelihoodOptions::loadFromConfigFile(
 	LF_decimation						= iniFile.read_int(section,"LF_decimation",LF_decimation);
 	LF_maxCorrsDistance					= iniFile.read_float(section,"LF_maxCorrsDistance",LF_maxCorrsDistance);
 	LF_alternateAverageMethod			= iniFile.read_bool(section,"LF_alternateAverageMethod",LF_alternateAverageMethod);
+	LF_useDistanceTransform				= iniFile.read_bool(section,"LF_useDistanceTransform",LF_useDistanceTransform);
 
 	MI_exponent							= iniFile.read_float(section,"MI_exponent",MI_exponent);
 	MI_skip_rays						= iniFile.read_int(section,"MI_skip_rays",MI_skip_rays);
@@ -933,6 +1217,7 @@ void  COccupancyGridMap2D::TLikelihoodOptions::dumpToTextStream(CStream	&out) co
 	out.printf("LF_decimation                           = %u\n",	LF_decimation );
 	out.printf("LF_maxCorrsDistance                     = %f\n",	LF_maxCorrsDistance );
 	out.printf("LF_alternateAverageMethod               = %c\n",	LF_alternateAverageMethod ? 'Y':'N');
+	out.printf("LF_useDistanceTransform                 = %c\n",	LF_useDistanceTransform ? 'Y':'N');
 	out.printf("MI_exponent                             = %f\n",	MI_exponent );
 	out.printf("MI_skip_rays                            = %u\n",	MI_skip_rays );
 	out.printf("MI_ratio_max_distance                   = %f\n",	MI_ratio_max_distance );
@@ -54,8 +54,7 @@ void  COccupancyGridMap2D::laserScanSimulator(
 	CPose2D		sensorPose(sensorPose3D);
 
     // Scan size:
-    inout_Scan.scan.resize(N);
-    inout_Scan.validRange.resize(N);
+    inout_Scan.resizeScan(N);
 
     double  A, AA;
 	if (inout_Scan.rightToLeft)
@@ -133,7 +132,11 @@ inline void COccupancyGridMap2D::simulateScanRay(
 	const float threshold_free,
 	const double noiseStd, const double angleNoiseStd ) const
 {
-	const double A_ = angle_direction + randomGenerator.drawGaussian1D_normalized()*angleNoiseStd;
+	// Don't touch the (global, non thread-safe) random generator unless noise is actually requested:
+	const double A_ = angleNoiseStd>0 ?
+		angle_direction + randomGenerator.drawGaussian1D_normalized()*angleNoiseStd
+		:
+		angle_direction;
 
 	// Unit vector in the directorion of the ray:
 #ifdef HAVE_SINCOS
@@ -9,6 +9,10 @@
 
 
 #include <mrpt/maps.h>
+#include <mrpt/utils/CMemoryStream.h>
+#include <mrpt/utils/CFileMMapInputStream.h>
+#include <mrpt/utils/CFileOutputStream.h>
+#include <mrpt/system/filesystem.h>
 #include <gtest/gtest.h>
 
 using namespace mrpt;
@@ -19,7 +23,7 @@ using namespace mrpt::math;
 using namespace std;
 
 
-TEST(COccupancyGridMap2DTests, insert2DScan)
+static void load_test_scan(CObservation2DRangeScan &scan1)
 {
 	float SCAN_RANGES_1[] = {0.910f,0.900f,0.910f,0.900f,0.900f,0.890f,0.890f,0.880f,0.890f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.870f,0.880f,0.870f,0.870f,0.870f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.880f,0.890f,0.880f,0.880f,0.880f,0.890f,0.880f,0.890f,0.890f,0.880f,0.890f,0.890f,0.880f,0.890f,0.890f,0.890f,0.890f,0.890f,0.890f,0.900f,0.900f,0.900f,0.900f,0.900f,0.910f,0.910f,0.910f,0.910f,0.920f,0.920f,0.920f,0.920f,0.920f,0.930f,0.930f,0.930f,0.930f,0.940f,0.940f,0.950f,0.950f,0.950f,0.950f,0.960f,0.960f,0.970f,0.970f,0.970f,0.980f,0.980f,0.990f,1.000f,1.000f,1.000f,1.010f,1.010f,1.020f,1.030f,1.030f,1.030f,1.040f,1.050f,1.060f,1.050f,1.060f,1.070f,1.070f,1.080f,1.080f,1.090f,1.100f,1.110f,1.120f,1.120f,1.130f,1.140f,1.140f,1.160f,1.170f,1.180f,1.180f,1.190f,1.200f,1.220f,1.220f,1.230f,1.230f,1.240f,1.250f,1.270f,1.280f,1.290f,1.300f,1.320f,1.320f,1.350f,1.360f,1.370f,1.390f,1.410f,1.410f,1.420f,1.430f,1.450f,1.470f,1.490f,1.500f,1.520f,1.530f,1.560f,1.580f,1.600f,1.620f,1.650f,1.670f,1.700f,1.730f,1.750f,1.780f,1.800f,1.830f,1.850f,1.880f,1.910f,1.940f,1.980f,2.010f,2.060f,2.090f,2.130f,2.180f,2.220f,2.250f,2.300f,2.350f,2.410f,2.460f,2.520f,2.570f,2.640f,2.700f,2.780f,2.850f,2.930f,3.010f,3.100f,3.200f,3.300f,3.390f,3.500f,3.620f,3.770f,3.920f,4.070f,4.230f,4.430f,4.610f,4.820f,5.040f,5.290f,5.520f,8.970f,8.960f,8.950f,8.930f,8.940f,8.930f,9.050f,9.970f,9.960f,10.110f,13.960f,18.870f,19.290f,81.910f,20.890f,48.750f,48.840f,48.840f,19.970f,19.980f,19.990f,15.410f,20.010f,19.740f,17.650f,17.400f,14.360f,12.860f,11.260f,11.230f,8.550f,8.630f,9.120f,9.120f,8.670f,8.570f,7.230f,7.080f,7.040f,6.980f,6.970f,5.260f,5.030f,4.830f,4.620f,4.440f,4.390f,4.410f,4.410f,4.410f,4.430f,4.440f,4.460f,4.460f,4.490f,4.510f,4.540f,3.970f,3.820f,3.730f,3.640f,3.550f,3.460f,3.400f,3.320f,3.300f,3.320f,3.320f,3.340f,2.790f,2.640f,2.600f,2.570f,2.540f,2.530f,2.510f,2.490f,2.490f,2.480f,2.470f,2.460f,2.460f,2.460f,2.450f,2.450f,2.450f,2.460f,2.460f,2.470f,2.480f,2.490f,2.490f,2.520f,2.510f,2.550f,2.570f,2.610f,2.640f,2.980f,3.040f,3.010f,2.980f,2.940f,2.920f,2.890f,2.870f,2.830f,2.810f,2.780f,2.760f,2.740f,2.720f,2.690f,2.670f,2.650f,2.630f,2.620f,2.610f,2.590f,2.560f,2.550f,2.530f,2.510f,2.500f,2.480f,2.460f,2.450f,2.430f,2.420f,2.400f,2.390f,2.380f,2.360f,2.350f,2.340f,2.330f,2.310f,2.300f,2.290f,2.280f,2.270f,2.260f,2.250f,2.240f,2.230f,2.230f,2.220f,2.210f,2.200f,2.190f,2.180f,2.170f,1.320f,1.140f,1.130f,1.130f,1.120f,1.120f,1.110f,1.110f,1.110f,1.110f,1.100f,1.110f,1.100f};
 	char  SCAN_VALID_1[] = {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
@@ -27,7 +31,6 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 	const size_t SCAN_SIZE = sizeof(SCAN_RANGES_1)/sizeof(SCAN_RANGES_1[0]);
 
 	// Load scans:
-	CObservation2DRangeScan	scan1;
 	scan1.aperture = M_PIf;
 	scan1.rightToLeft = true;
 	scan1.validRange.resize( SCAN_SIZE );
@@ -36,6 +39,12 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 
 	memcpy( &scan1.scan[0], SCAN_RANGES_1, sizeof(SCAN_RANGES_1) );
 	memcpy( &scan1.validRange[0], SCAN_VALID_1, sizeof(SCAN_VALID_1) );
+}
+
+TEST(COccupancyGridMap2DTests, insert2DScan)
+{
+	CObservation2DRangeScan	scan1;
+	load_test_scan(scan1);
 
 	// Insert the scan in the grid map and check expected values:
 	{
@@ -47,3 +56,282 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 
 }
 
+TEST(COccupancyGridMap2DTests, computeObservationLikelihoodForPoses)
+{
+	CObservation2DRangeScan	scan1;
+	load_test_scan(scan1);
+
+	COccupancyGridMap2D  grid(-20,20, -20,20,  0.10);
+	grid.insertObservation( &scan1 );
+
+	std::vector<TPose3D> poses;
+	for (int i=0;i<150;i++)
+		poses.push_back( TPose3D(0.01*(i%10),-0.02*(i%7),0, DEG2RAD(0.5*(i%11)),0,0) );
+
+	const COccupancyGridMap2D::TLikelihoodMethod methods[] = {
+		COccupancyGridMap2D::lmLikelihoodField_Thrun,
+		COccupancyGridMap2D::lmLikelihoodField_II,
+		COccupancyGridMap2D::lmRayTracing,
+		COccupancyGridMap2D::lmConsensus };
+
+	for (size_t m=0;m<sizeof(methods)/sizeof(methods[0]);m++)
+	{
+		grid.likelihoodOptions.likelihoodMethod = methods[m];
+
+		vector_double batch_liks;
+		grid.computeObservationLikelihoodForPoses(&scan1,poses,batch_liks);
+		ASSERT_EQ(size_t(batch_liks.size()),poses.size());
+
+		for (size_t i=0;i<poses.size();i++)
+			EXPECT_DOUBLE_EQ( batch_liks[i], grid.computeObservationLikelihood(&scan1, CPose3D(poses[i])) ) << "method=" << methods[m] << " pose idx=" << i;
+	}
+}
+
+// Brute-force reference of the "likelihood field" model, as documented in COccupancyGridMap2D::computeLikelihoodField_Thrun()
+static double reference_likelihood_Thrun(const COccupancyGridMap2D &grid, const CPointsMap &pts, const CPose2D &pose)
+{
+	const COccupancyGridMap2D::TLikelihoodOptions &lo = grid.likelihoodOptions;
+	const double res = grid.getResolution();
+	const int K = (int)ceil(lo.LF_maxCorrsDistance / res);
+	const double zRandomTerm = lo.LF_zRandom / lo.LF_maxRange;
+	const double Q = -0.5f / square(lo.LF_stdHit);
+	const double units = 100/(res*res);
+	const double maxDist2 = mrpt::utils::round( square(lo.LF_maxCorrsDistance)*units ) / units;
+	const double minimumLik = zRandomTerm + lo.LF_zHit * exp( Q * square(lo.LF_maxCorrsDistance) );
+	const int sx_1 = grid.getSizeX()-1, sy_1 = grid.getSizeY()-1;
+	const size_t decimation = pts.size()<10 ? 1 : lo.LF_decimation;
+
+	double ret = 0;
+	for (size_t i=0;i<pts.size();i+=decimation)
+	{
+		double lx,ly,lz, gx,gy;
+		pts.getPoint(i,lx,ly,lz);
+		pose.composePoint(lx,ly,gx,gy);
+		const int cx = grid.x2idx(gx), cy = grid.y2idx(gy);
+
+		double lik = minimumLik;
+		if (cx>=0 && cy>=0 && cx<sx_1 && cy<sy_1)
+		{
+			double d2 = maxDist2;
+			for (int yy=std::max(0,cy-K);yy<=std::min(sy_1,cy+K);yy++)
+				for (int xx=std::max(0,cx-K);xx<=std::min(sx_1,cx+K);xx++)
+					if (grid.getCell(xx,yy)<0.5f)
+						d2 = std::min(d2, (square(xx-cx)+square(yy-cy))*res*res );
+			lik = zRandomTerm + lo.LF_zHit * exp( Q*d2 );
+		}
+		ret += log(lik);
+	}
+	return ret;
+}
+
+TEST(COccupancyGridMap2DTests, computeLikelihoodField_Thrun)
+{
+	CObservation2DRangeScan	scan1;
+	load_test_scan(scan1);
+
+	COccupancyGridMap2D  grid(-20,20, -20,20,  0.10);
+	grid.insertObservation( &scan1 );
+
+	CSimplePointsMap pts;
+	pts.insertObservation( &scan1 );
+
+	// The scratch buffers are reused for all the evaluations, with different numbers of points:
+	COccupancyGridMap2D::TLikelihoodFieldBuffers buffers;
+	const unsigned int decimations[] = {1,3};
+	for (size_t d=0;d<sizeof(decimations)/sizeof(decimations[0]);d++)
+	{
+		grid.likelihoodOptions.LF_decimation = decimations[d];
+		for (int i=0;i<20;i++)
+		{
+			const CPose2D pose(0.013*(i%5),-0.021*(i%7), DEG2RAD(0.7*(i%11)) );
+			const double lik = grid.computeLikelihoodField_Thrun(&pts,&pose);
+			EXPECT_NEAR( lik, reference_likelihood_Thrun(grid,pts,pose), 1e-3 ) << "decimation=" << decimations[d] << " pose=" << pose;
+			EXPECT_EQ( lik, grid.computeLikelihoodField_Thrun(&pts,&pose,&buffers) ) << "decimation=" << decimations[d] << " pose=" << pose;
+		}
+	}
+}
+
+TEST(COccupancyGridMap2DTests, LF_useDistanceTransform)
+{
+	CObservation2DRangeScan	scan1;
+	load_test_scan(scan1);
+
+	COccupancyGridMap2D  grid(-20,20, -20,20,  0.10);
+	grid.insertObservation( &scan1 );
+	grid.likelihoodOptions.LF_decimation = 1;
+	grid.likelihoodOptions.enableLikelihoodCache = false; // It's not updated by updateCell()
+
+	CSimplePointsMap pts;
+	pts.insertObservation( &scan1 );
+
+	// Compare to the likelihoods computed without the distance transform, as the map is modified:
+	for (int step=0;step<4;step++)
+	{
+		switch (step)
+		{
+		case 1: // Incremental updates around some obstacles:
+			for (int i=0;i<30;i++)
+			{
+				grid.updateCell(grid.x2idx(0.9+0.05*i),grid.y2idx(1.2),0.05f);
+				grid.updateCell(grid.x2idx(0.9+0.05*i),grid.y2idx(1.2),0.05f);
+			}
+			grid.setCell(grid.x2idx(-1.0),grid.y2idx(0.3),0.01f);
+			break;
+		case 2: // Insert an observation, from another pose:
+			{
+				CPose3D pose(0.3,-0.2,0, DEG2RAD(5),0,0);
+				grid.insertObservation( &scan1, &pose);
+			}
+			break;
+		case 3: // Other parameters:
+			grid.likelihoodOptions.LF_maxCorrsDistance = 0.5f;
+			grid.likelihoodOptions.LF_stdHit = 0.2f;
+			break;
+		};
+
+		for (int i=0;i<20;i++)
+		{
+			const CPose2D pose(0.013*(i%5),-0.021*(i%7), DEG2RAD(0.7*(i%11)) );
+
+			grid.likelihoodOptions.LF_useDistanceTransform = false;
+			const double lik_search = grid.computeLikelihoodField_Thrun(&pts,&pose);
+			grid.likelihoodOptions.LF_useDistanceTransform = true;
+			const double lik_dt = grid.computeLikelihoodField_Thrun(&pts,&pose);
+
+			EXPECT_DOUBLE_EQ(lik_search, lik_dt) << "step=" << step << " pose=" << pose;
+		}
+	}
+}
+
+// All the cells of a grid, as probabilities:
+static std::vector<float> grid_cells(const COccupancyGridMap2D &grid)
+{
+	std::vector<float> cells;
+	cells.reserve(grid.getSizeX()*grid.getSizeY());
+	for (unsigned int y=0;y<grid.getSizeY();y++)
+		for (unsigned int x=0;x<grid.getSizeX();x++)
+			cells.push_back(grid.getCell(x,y));
+	return cells;
+}
+
+TEST(COccupancyGridMap2DTests, copiesAreIndependent)
+{
+	CObservation2DRangeScan	scan1;
+	load_test_scan(scan1);
+
+	COccupancyGridMap2D  grid(-20,20, -20,20,  0.10);
+	grid.insertObservation( &scan1 );
+
+	const std::vector<float> cells_orig = grid_cells(grid);
+
+	COccupancyGridMap2D  grid2(grid), grid3;
+	grid3 = grid;
+
+	const CPose3D pose(0.5,0.2,0, DEG2RAD(30),0,0);
+	grid2.insertObservation( &scan1, &pose );
+	grid3.setCell(grid3.x2idx(-3.0),grid3.y2idx(4.0),0.0f);
+
+	const std::vector<float> cells = grid_cells(grid), cells2 = grid_cells(grid2), cells3 = grid_cells(grid3);
+	ASSERT_EQ(cells.size(),cells_orig.size());
+	ASSERT_EQ(cells2.size(),cells.size());
+	ASSERT_EQ(cells3.size(),cells.size());
+
+	size_t nDiffs2=0, nDiffs3=0;
+	for (size_t i=0;i<cells.size();i++)
+	{
+		EXPECT_EQ( cells_orig[i], cells[i] );
+		if (cells2[i]!=cells[i]) nDiffs2++;
+		if (cells3[i]!=cells[i]) nDiffs3++;
+	}
+	EXPECT_GT(nDiffs2, 0u);
+	EXPECT_EQ(nDiffs3, 1u);
+	EXPECT_FLOAT_EQ(grid.getCell(grid.x2idx(-3.0),grid.y2idx(4.0)), 0.5f);
+
+	// Saving/loading a map whose rows are shared must also work:
+	CMemoryStream buf;
+	buf << grid2;
+	buf.Seek(0);
+	COccupancyGridMap2D  grid4;
+	buf >> grid4;
+	EXPECT_TRUE( grid_cells(grid4)==cells2 );
+}
+
+// Gives access to the sizes of the likelihood caches of any grid:
+struct TGridCachesInspector : public COccupancyGridMap2D
+{
+	static size_t cachesSize(const COccupancyGridMap2D &grid)
+	{
+		return (grid.*(&TGridCachesInspector::precomputedLikelihood)).size() + (grid.*(&TGridCachesInspector::m_dt)).size();
+	}
+};
+
+TEST(COccupancyGridMap2DTests, copiesDropLikelihoodCaches)
+{
+	CObservation2DRangeScan	scan1;
+	load_test_scan(scan1);
+
+	CSimplePointsMap pts;
+	pts.insertObservation( &scan1 );
+	const CPose2D pose(0.03,-0.02, DEG2RAD(1.5) );
+
+	for (int useDT=0;useDT<2;useDT++)
+	{
+		COccupancyGridMap2D  grid(-20,20, -20,20,  0.10);
+		grid.insertObservation( &scan1 );
+		grid.likelihoodOptions.LF_useDistanceTransform = useDT!=0;
+		grid.likelihoodOptions.enableLikelihoodCache = !useDT;
+
+		const double lik = grid.computeLikelihoodField_Thrun(&pts,&pose);
+		EXPECT_GT(TGridCachesInspector::cachesSize(grid), 0u);
+
+		COccupancyGridMap2D  grid2(grid), grid3;
+		grid3 = grid;
+		EXPECT_EQ(TGridCachesInspector::cachesSize(grid2), 0u) << "useDT=" << useDT;
+		EXPECT_EQ(TGridCachesInspector::cachesSize(grid3), 0u) << "useDT=" << useDT;
+
+		// The caches are rebuilt on demand:
+		EXPECT_DOUBLE_EQ(lik, grid2.computeLikelihoodField_Thrun(&pts,&pose)) << "useDT=" << useDT;
+		EXPECT_DOUBLE_EQ(lik, grid3.computeLikelihoodField_Thrun(&pts,&pose)) << "useDT=" << useDT;
+		EXPECT_GT(TGridCachesInspector::cachesSize(grid2), 0u);
+
+		// Assigning over a grid with caches also drops them:
+		grid2 = grid3;
+		EXPECT_EQ(TGridCachesInspector::cachesSize(grid2), 0u) << "useDT=" << useDT;
+		EXPECT_DOUBLE_EQ(lik, grid.computeLikelihoodField_Thrun(&pts,&pose)) << "useDT=" << useDT;
+	}
+}
+
+TEST(COccupancyGridMap2DTests, loadFromMemoryMappedFile)
+{
+	CObservation2DRangeScan	scan1;
+	load_test_scan(scan1);
+
+	COccupancyGridMap2D  grid(-20,20, -20,20,  0.10);
+	grid.insertObservation( &scan1 );
+
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		CFileOutputStream f(fil);
+		f << grid;
+	}
+
+	COccupancyGridMap2D  grid2;
+	{
+		CFileMMapInputStream f(fil);
+		f >> grid2;
+	}
+	// The cells are used from the mapped file until they are modified:
+	const std::vector<float> cells = grid_cells(grid);
+	EXPECT_TRUE( grid_cells(grid2)==cells );
+	EXPECT_EQ( grid2.getCellGrid().getBorrowedRowCount(), grid2.getSizeY() );
+
+	grid2.setCell(grid2.x2idx(-3.0),grid2.y2idx(4.0),0.0f);
+	EXPECT_EQ( grid2.getCellGrid().getBorrowedRowCount(), grid2.getSizeY()-1 );
+	EXPECT_NEAR( grid2.getCell(grid2.x2idx(-3.0),grid2.y2idx(4.0)), 0.0f, 1e-3 );  // Up to the log-odds quantization
+
+	grid2.insertObservation( &scan1 );
+	EXPECT_GT( grid2.getPos(0.5,0), 0.51f );
+
+	grid2.clear();
+	remove(fil.c_str());
+}
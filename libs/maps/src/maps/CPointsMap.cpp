@@ -63,6 +63,9 @@ CPointsMap::CPointsMap() :
 	likelihoodOptions(),
 	x(),y(),z(),
 	m_largestDistanceFromOrigin(0),
+	m_local_shapes(),
+	m_local_shapes_knn(0),
+	m_voxel_downsampled(),
 	m_heightfilter_z_min(-10),
 	m_heightfilter_z_max(10),
 	m_heightfilter_enabled(false)
@@ -238,6 +241,18 @@ void  CPointsMap::getPointsBuffer( size_t &outPointsCount, const float *&xs, con
 	}
 }
 
+/*---------------------------------------------------------------
+						getPointsColumns
+ ---------------------------------------------------------------*/
+void  CPointsMap::getPointsColumns(std::vector<TPointsColumn> &cols) const
+{
+	const bool empty = x.empty();
+	cols.clear();
+	cols.push_back(TPointsColumn("x",'F', empty ? NULL : &x[0]));
+	cols.push_back(TPointsColumn("y",'F', empty ? NULL : &y[0]));
+	cols.push_back(TPointsColumn("z",'F', empty ? NULL : &z[0]));
+}
+
 /*---------------------------------------------------------------
 						clipOutOfRangeInZ
  ---------------------------------------------------------------*/
@@ -437,31 +452,49 @@ void CPointsMap::determineMatching2D(
 		local_y_max<global_y_min) return;	// We know for sure there is no matching at all
 
 
+	// KD-TREE implementation =================================
+	// Use a KD-tree to look for the nearnest neighbor of each
+	//  (decimated) local point in "this" (global/reference) points map.
+	// All the queries are solved at once, in parallel:
+	// --------------------------------------------------------
+	const size_t nQueries = (nLocalPoints-params.offset_other_map_points + params.decimation_other_map_points-1)/params.decimation_other_map_points;
+	const float *x_queries = &x_locals[0];
+	const float *y_queries = &y_locals[0];
+	std::vector<float> x_decim, y_decim;
+	if (params.decimation_other_map_points>1)
+	{
+		x_decim.resize(nQueries);
+		y_decim.resize(nQueries);
+		for (size_t i=0;i<nQueries;i++)
+		{
+			x_decim[i] = x_locals[params.offset_other_map_points+i*params.decimation_other_map_points];
+			y_decim[i] = y_locals[params.offset_other_map_points+i*params.decimation_other_map_points];
+		}
+		x_queries = &x_decim[0];
+		y_queries = &y_decim[0];
+	}
+
+	std::vector<size_t> nn_idxs;
+	std::vector<float>  nn_dists_sqr;
+	kdTreeClosestPoint2DBatch(x_queries,y_queries,nQueries, nn_idxs,nn_dists_sqr);
+
 	// Loop for each point in local map:
 	// --------------------------------------------------
-	for ( localIdx=params.offset_other_map_points,
+	size_t queryIdx;
+	for ( queryIdx=0, localIdx=params.offset_other_map_points,
 			x_other_it=&otherMap->x[params.offset_other_map_points],
 			y_other_it=&otherMap->y[params.offset_other_map_points],
 			z_other_it=&otherMap->z[params.offset_other_map_points];
 			localIdx<nLocalPoints;
-			x_other_it+=params.decimation_other_map_points,y_other_it+=params.decimation_other_map_points,z_other_it+=params.decimation_other_map_points,localIdx+=params.decimation_other_map_points )
+			queryIdx++,x_other_it+=params.decimation_other_map_points,y_other_it+=params.decimation_other_map_points,z_other_it+=params.decimation_other_map_points,localIdx+=params.decimation_other_map_points )
 	{
 		// For speed-up:
-		x_local = x_locals[localIdx]; // *x_locals_it;
-		y_local = y_locals[localIdx]; // *y_locals_it;
-
-		// Find all the matchings in the requested distance:
+		x_local = x_queries[queryIdx];
+		y_local = y_queries[queryIdx];
 
-		// KD-TREE implementation =================================
-		// Use a KD-tree to look for the nearnest neighbor of:
-		//   (x_local, y_local, z_local)
-		// In "this" (global/reference) points map.
-
-		float tentativ_err_sq;
-		unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
-			x_local,  y_local,  // Look closest to this guy
-			tentativ_err_sq // save here the min. distance squared
-			);
+		// The closest point in "this" map:
+		const float tentativ_err_sq = nn_dists_sqr[queryIdx];
+		const unsigned int tentativ_this_idx = nn_idxs[queryIdx];
 
 		// Compute max. allowed distance:
 		maxDistForCorrespondenceSquared = square(
@@ -613,20 +646,23 @@ CPointsMap::TInsertionOptions::TInsertionOptions() :
 	isPlanarMap                 ( false),
 	horizontalTolerance         ( DEG2RAD(0.05) ),
 	maxDistForInterpolatePoints ( 2.0f ),
-	insertInvalidPoints         ( false)
+	insertInvalidPoints         ( false),
+	voxelFusionSize             ( 0 ),
+	voxelFusionAverage          ( false )
 {
 }
 
 // Binary dump to/read from stream - for usage in derived classes' serialization
 void CPointsMap::TInsertionOptions::writeToStream(CStream &out) const
 {
-	const int8_t version = 0;
+	const int8_t version = 1;
 	out << version;
 
 	out 
 	<< minDistBetweenLaserPoints << addToExistingPointsMap << also_interpolate
 	<< disableDeletion << fuseWithExisting << isPlanarMap << horizontalTolerance
-	<< maxDistForInterpolatePoints << insertInvalidPoints; // v0
+	<< maxDistForInterpolatePoints << insertInvalidPoints // v0
+	<< voxelFusionSize << voxelFusionAverage; // v1
 }
 
 void CPointsMap::TInsertionOptions::readFromStream(CStream &in)
@@ -636,11 +672,21 @@ void CPointsMap::TInsertionOptions::readFromStream(CStream &in)
 	switch(version)
 	{
 		case 0:
+		case 1:
 		{
 			in 
 			>> minDistBetweenLaserPoints >> addToExistingPointsMap >> also_interpolate
 			>> disableDeletion >> fuseWithExisting >> isPlanarMap >> horizontalTolerance
 			>> maxDistForInterpolatePoints >> insertInvalidPoints; // v0
+			if (version>=1)
+			{
+				in >> voxelFusionSize >> voxelFusionAverage;
+			}
+			else
+			{
+				voxelFusionSize = 0;
+				voxelFusionAverage = false;
+			}
 		}
 		break;
 		default: MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
@@ -698,6 +744,9 @@ void  CPointsMap::TInsertionOptions::dumpToTextStream(CStream	&out) const
 
 	LOADABLEOPTS_DUMP_VAR(insertInvalidPoints,bool);
 
+	LOADABLEOPTS_DUMP_VAR(voxelFusionSize,double);
+	LOADABLEOPTS_DUMP_VAR(voxelFusionAverage,bool);
+
 	out.printf("\n");
 }
 
@@ -729,6 +778,9 @@ void  CPointsMap::TInsertionOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(maxDistForInterpolatePoints,	float, iniFile,section);
 
 	MRPT_LOAD_CONFIG_VAR(insertInvalidPoints,bool, iniFile,section);
+
+	MRPT_LOAD_CONFIG_VAR(voxelFusionSize,float, iniFile,section);
+	MRPT_LOAD_CONFIG_VAR(voxelFusionAverage,bool, iniFile,section);
 }
 
 void  CPointsMap::TLikelihoodOptions::loadFromConfigFile(
@@ -898,6 +950,296 @@ float CPointsMap::squareDistanceToClosestCorrespondence(
 
 
 
+namespace
+{
+	/** Functor for CPointsMap::getLocalShapes(): estimates the local shape of a range of points from their neighbors */
+	struct TEstimateLocalShapes
+	{
+		const CPointsMap                         &m_map;
+		const size_t                              m_first, m_knn;
+		const std::vector<size_t>                &m_idxs;  // m_knn neighbors of each point, starting at m_first
+		std::vector<CPointsMap::TLocalShape>     &m_out;
+
+		TEstimateLocalShapes(const CPointsMap &map, size_t first, size_t knn, const std::vector<size_t> &idxs, std::vector<CPointsMap::TLocalShape> &out) :
+			m_map(map), m_first(first), m_knn(knn), m_idxs(idxs), m_out(out)
+		{ }
+
+		void operator()(const mrpt::system::BlockedRange &r) const
+		{
+			for (int i=r.begin();i<r.end();i++)
+			{
+				CPointsMap::TLocalShape &s = m_out[m_first+i];
+				s.nx = s.ny = 0; s.nz = 1;
+				s.curvature = -1;
+				if (m_knn<3) continue;
+
+				const size_t *nn = &m_idxs[i*m_knn];
+				Eigen::Vector3d  mean = Eigen::Vector3d::Zero();
+				Eigen::Matrix3d  cov  = Eigen::Matrix3d::Zero();
+				for (size_t k=0;k<m_knn;k++)
+				{
+					float px,py,pz;
+					m_map.getPointFast(nn[k],px,py,pz);
+					const Eigen::Vector3d p(px,py,pz);
+					mean += p;
+					cov  += p*p.transpose();
+				}
+				mean /= double(m_knn);
+				cov = cov/double(m_knn) - mean*mean.transpose();
+
+				// Eigenvalues are sorted in increasing order:
+				const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig(cov);
+				const Eigen::Vector3d &lambdas = eig.eigenvalues();
+				const double sum = lambdas.sum();
+				if (sum<=0) continue;
+
+				s.nx = static_cast<float>(eig.eigenvectors()(0,0));
+				s.ny = static_cast<float>(eig.eigenvectors()(1,0));
+				s.nz = static_cast<float>(eig.eigenvectors()(2,0));
+				s.curvature = static_cast<float>( std::max(0.0,lambdas[0])/sum );
+			}
+		}
+	};
+}
+
+/*---------------------------------------------------------------
+				getLocalShapes
+---------------------------------------------------------------*/
+const std::vector<CPointsMap::TLocalShape> & CPointsMap::getLocalShapes(const size_t knn) const
+{
+	const size_t N = x.size();
+
+	if (m_local_shapes_knn!=knn || m_local_shapes.size()>N)
+		m_local_shapes.clear();
+	m_local_shapes_knn = knn;
+
+	const size_t first = m_local_shapes.size();
+	if (first==N)
+		return m_local_shapes;
+
+	m_local_shapes.resize(N);
+
+	// Query the neighbors of all the new points at once:
+	const size_t k = std::min(knn,N);
+	std::vector<size_t> nn_idxs;
+	std::vector<float>  nn_dists_sqr;
+	if (k)
+		kdTreeNClosestPoint3DIdxBatch(&x[first],&y[first],&z[first],N-first,k,nn_idxs,nn_dists_sqr);
+
+	mrpt::system::parallel_for(
+		mrpt::system::BlockedRange(0,static_cast<int>(N-first),256),
+		TEstimateLocalShapes(*this,first,k,nn_idxs,m_local_shapes) );
+
+	return m_local_shapes;
+}
+
+/*---------------------------------------------------------------
+				voxelDownsample
+---------------------------------------------------------------*/
+void CPointsMap::voxelDownsample(const float voxel_size, CPointsMap &outMap) const
+{
+	MRPT_START
+	ASSERT_(voxel_size>0)
+	ASSERT_(&outMap!=this)
+
+	const size_t N = x.size();
+	std::vector<float> xs,ys,zs;
+
+	// Sort the points by the (packed) coordinates of their voxels, so each voxel becomes one run of points:
+	const double inv_size = 1.0/voxel_size;
+	const int64_t OFFSET = int64_t(1)<<20, MASK = (int64_t(1)<<21)-1;
+	std::vector<std::pair<uint64_t,size_t> > keys(N);
+	for (size_t i=0;i<N;i++)
+	{
+		const int64_t cx = (static_cast<int64_t>(floor(x[i]*inv_size))+OFFSET) & MASK;
+		const int64_t cy = (static_cast<int64_t>(floor(y[i]*inv_size))+OFFSET) & MASK;
+		const int64_t cz = (static_cast<int64_t>(floor(z[i]*inv_size))+OFFSET) & MASK;
+		keys[i].first  = static_cast<uint64_t>( cx | (cy<<21) | (cz<<42) );
+		keys[i].second = i;
+	}
+	std::sort(keys.begin(),keys.end());
+
+	for (size_t i=0;i<N; )
+	{
+		double sx=0,sy=0,sz=0;
+		size_t j=i;
+		for ( ; j<N && keys[j].first==keys[i].first;j++)
+		{
+			const size_t k = keys[j].second;
+			sx+=x[k]; sy+=y[k]; sz+=z[k];
+		}
+		const double inv_n = 1.0/(j-i);
+		xs.push_back( static_cast<float>(sx*inv_n) );
+		ys.push_back( static_cast<float>(sy*inv_n) );
+		zs.push_back( static_cast<float>(sz*inv_n) );
+		i=j;
+	}
+
+	outMap.setAllPoints(xs,ys,zs);
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+				getVoxelDownsampled
+---------------------------------------------------------------*/
+const CPointsMap & CPointsMap::getVoxelDownsampled(const float voxel_size) const
+{
+	for (size_t i=0;i<m_voxel_downsampled.size();i++)
+		if (m_voxel_downsampled[i].first==voxel_size)
+			return *m_voxel_downsampled[i].second;
+
+	CSimplePointsMapPtr decimated = CSimplePointsMap::Create();
+	voxelDownsample(voxel_size,*decimated);
+	m_voxel_downsampled.push_back( std::make_pair(voxel_size, CPointsMapPtr(decimated)) );
+	return *decimated;
+}
+
+/*---------------------------------------------------------------
+				TVoxelIndex
+---------------------------------------------------------------*/
+const uint32_t CPointsMap::TVoxelIndex::EMPTY;
+
+void CPointsMap::TVoxelIndex::clear()
+{
+	nIndexed = nUsed = 0;
+	cells.clear();
+	slots.clear();
+	counts.clear();
+}
+
+void CPointsMap::TVoxelIndex::swap(TVoxelIndex &o)
+{
+	std::swap(voxel_size,o.voxel_size);
+	std::swap(nIndexed,o.nIndexed);
+	std::swap(nUsed,o.nUsed);
+	cells.swap(o.cells);
+	slots.swap(o.slots);
+	counts.swap(o.counts);
+}
+
+size_t CPointsMap::TVoxelIndex::find(int32_t cx, int32_t cy, int32_t cz) const
+{
+	const size_t mask = slots.size()-1;  // The size is a power of 2
+	size_t s = ( static_cast<uint32_t>(cx)*73856093u ^ static_cast<uint32_t>(cy)*19349663u ^ static_cast<uint32_t>(cz)*83492791u ) & mask;
+	while (slots[s]!=EMPTY && (cells[3*s]!=cx || cells[3*s+1]!=cy || cells[3*s+2]!=cz))
+		s = (s+1) & mask;
+	return s;
+}
+
+void CPointsMap::TVoxelIndex::insert(size_t slot, int32_t cx, int32_t cy, int32_t cz, uint32_t pointIdx)
+{
+	slots[slot] = pointIdx;
+	cells[3*slot]   = cx;
+	cells[3*slot+1] = cy;
+	cells[3*slot+2] = cz;
+
+	// Keep the load factor below 1/2:
+	if (2*(++nUsed) > slots.size())
+	{
+		std::vector<int32_t>  old_cells;
+		std::vector<uint32_t> old_slots;
+		old_cells.swap(cells);
+		old_slots.swap(slots);
+		slots.assign(2*old_slots.size(), EMPTY);
+		cells.resize(3*slots.size());
+		for (size_t i=0;i<old_slots.size();i++)
+		{
+			if (old_slots[i]==EMPTY) continue;
+			const size_t s = find(old_cells[3*i],old_cells[3*i+1],old_cells[3*i+2]);
+			slots[s] = old_slots[i];
+			cells[3*s]   = old_cells[3*i];
+			cells[3*s+1] = old_cells[3*i+1];
+			cells[3*s+2] = old_cells[3*i+2];
+		}
+	}
+}
+
+/*---------------------------------------------------------------
+				fuseWithVoxels
+---------------------------------------------------------------*/
+size_t CPointsMap::fuseWithVoxels(const CPointsMap &otherMap, const float voxel_size, const bool average)
+{
+	MRPT_START
+	ASSERT_(voxel_size>0)
+	ASSERT_(&otherMap!=this)
+
+	TVoxelIndex &vi = m_voxel_index;
+	if (vi.voxel_size!=voxel_size || vi.nIndexed>x.size())
+	{
+		vi.clear();
+		vi.voxel_size = voxel_size;
+	}
+	if (vi.slots.empty())
+	{
+		vi.slots.assign(1024,TVoxelIndex::EMPTY);
+		vi.cells.resize(3*vi.slots.size());
+	}
+	const float inv_size = 1.0f/voxel_size;
+
+	// Index the points inserted by other means since the last call (weights, if any, count as fused points):
+	const size_t N0 = x.size();
+	vi.counts.resize(N0);
+	for (size_t i=vi.nIndexed;i<N0;i++)
+	{
+		const int32_t cx = static_cast<int32_t>(floor(x[i]*inv_size)), cy = static_cast<int32_t>(floor(y[i]*inv_size)), cz = static_cast<int32_t>(floor(z[i]*inv_size));
+		const size_t s = vi.find(cx,cy,cz);
+		if (vi.slots[s]==TVoxelIndex::EMPTY)
+			vi.insert(s,cx,cy,cz,static_cast<uint32_t>(i));
+		vi.counts[i] = std::max(1u,getPointWeight(i));
+	}
+
+	// Copy the class-specific fields of new points only between maps of the same kind:
+	std::vector<float> fields;
+	const bool copyFields = otherMap.GetRuntimeClass()==GetRuntimeClass();
+
+	bool pointsModified = false;
+	const size_t nOther = otherMap.size();
+	for (size_t j=0;j<nOther;j++)
+	{
+		const float px = otherMap.x[j], py = otherMap.y[j], pz = otherMap.z[j];
+		const int32_t cx = static_cast<int32_t>(floor(px*inv_size)), cy = static_cast<int32_t>(floor(py*inv_size)), cz = static_cast<int32_t>(floor(pz*inv_size));
+		const size_t s = vi.find(cx,cy,cz);
+		const uint32_t i = vi.slots[s];
+		if (i!=TVoxelIndex::EMPTY)
+		{
+			if (!average) continue;
+			// Running mean, which never leaves the voxel:
+			const float w = 1.0f/(++vi.counts[i]);
+			x[i]+=(px-x[i])*w;
+			y[i]+=(py-y[i])*w;
+			z[i]+=(pz-z[i])*w;
+			setPointWeight(i,getPointWeight(i)+1);
+			pointsModified = true;
+		}
+		else
+		{
+			const size_t newIdx = x.size();
+			this->insertPointFast(px,py,pz);
+			if (copyFields)
+			{
+				otherMap.getPointAllFieldsFast(j,fields);
+				this->setPointAllFieldsFast(newIdx,fields);
+			}
+			vi.counts.push_back(1);
+			vi.insert(s,cx,cy,cz,static_cast<uint32_t>(newIdx));
+		}
+	}
+	vi.nIndexed = x.size();
+
+	if (pointsModified)
+	{
+		// Invalidate all the caches but the voxel index itself:
+		TVoxelIndex aux;
+		aux.swap(vi);
+		mark_as_modified();
+		vi.swap(aux);
+	}
+	else mark_as_points_appended();
+
+	return x.size()-N0;
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 				boundingBox
 ---------------------------------------------------------------*/
@@ -922,46 +1264,12 @@ void CPointsMap::boundingBox(
 #if MRPT_HAS_SSE2
 			// Vectorized version: ~ 9x times faster
 
-			// Number of 4-floats:
+			// Number of 4-floats (the remaining 0-3 points are processed below):
 			size_t nPackets = nPoints/4;
-			if ( (nPoints & 0x03)!=0) nPackets++;
-
-			// Pad with zeros to make sure we have a number of points multiple of 4
-			size_t nPoints_4align = nPoints;
-			size_t nExtraPad = 0;
-			if (0!=(nPoints & 0x03))
-			{
-				nExtraPad = 4 - (nPoints & 0x03);
-				nPoints_4align+=nExtraPad;
-			}
-
-			// We'll assume that the real allocated memory in the source buffers at least have room for a maximum
-			//  of 3 more floats, and pad with zeroes there (yeah, fuck correct-constness....)
-			if ( x.capacity()<nPoints_4align ||
-				 y.capacity()<nPoints_4align ||
-				 z.capacity()<nPoints_4align )
-			{
-				// This will happen perhaps...once in a lifetime? Anyway:
-				const_cast<vector<float>*>(&x)->reserve(nPoints_4align+16);
-				const_cast<vector<float>*>(&y)->reserve(nPoints_4align+16);
-				const_cast<vector<float>*>(&z)->reserve(nPoints_4align+16);
-			}
-
-			if (nExtraPad)
-			{
-				float *ptr_in_x = const_cast<float*>(&x[0]);
-				float *ptr_in_y = const_cast<float*>(&y[0]);
-				float *ptr_in_z = const_cast<float*>(&z[0]);
-				for (size_t k=nExtraPad;k; k--) {
-					ptr_in_x[nPoints+k]=0;
-					ptr_in_y[nPoints+k]=0;
-					ptr_in_z[nPoints+k]=0;
-				}
-			}
 
 			// For the bounding box:
-			__m128 x_mins = _mm_set1_ps( std::numeric_limits<float>::max() );
-			__m128 x_maxs = _mm_set1_ps( std::numeric_limits<float>::min() );
+			__m128 x_mins = _mm_set1_ps( (std::numeric_limits<float>::max)() );
+			__m128 x_maxs = _mm_set1_ps( -(std::numeric_limits<float>::max)() );
 			__m128 y_mins = x_mins, y_maxs = x_maxs;
 			__m128 z_mins = x_mins, z_maxs = x_maxs;
 
@@ -991,6 +1299,14 @@ void CPointsMap::boundingBox(
 			_mm_store_ps(temp_nums, y_maxs); m_bb_max_y=max(max(temp_nums[0],temp_nums[1]),max(temp_nums[2],temp_nums[3]));
 			_mm_store_ps(temp_nums, z_maxs); m_bb_max_z=max(max(temp_nums[0],temp_nums[1]),max(temp_nums[2],temp_nums[3]));
 
+			// The last points, if the number is not a multiple of 4:
+			for (size_t i=nPoints & ~size_t(0x03);i<nPoints;i++)
+			{
+				m_bb_min_x = min( m_bb_min_x, x[i] ); m_bb_max_x = max( m_bb_max_x, x[i] );
+				m_bb_min_y = min( m_bb_min_y, y[i] ); m_bb_max_y = max( m_bb_max_y, y[i] );
+				m_bb_min_z = min( m_bb_min_z, z[i] ); m_bb_max_z = max( m_bb_max_z, z[i] );
+			}
+
 #else
 			// Non vectorized version:
 			m_bb_min_x =
@@ -1070,18 +1386,20 @@ void  CPointsMap::determineMatching3D(
 	// -----------------------------------------------------------
 
 	// Transladar y rotar ya todos los puntos locales
-	vector<float> x_locals(nLocalPoints), y_locals(nLocalPoints), z_locals(nLocalPoints);
+	// (only the decimated ones, which are the queries for the KD-tree)
+	const size_t nQueries = (nLocalPoints-params.offset_other_map_points + params.decimation_other_map_points-1)/params.decimation_other_map_points;
+	vector<float> x_locals(nQueries), y_locals(nQueries), z_locals(nQueries);
 
-	for (unsigned int localIdx=params.offset_other_map_points;localIdx<nLocalPoints;localIdx+=params.decimation_other_map_points)
+	for (size_t queryIdx=0,localIdx=params.offset_other_map_points;localIdx<nLocalPoints;queryIdx++,localIdx+=params.decimation_other_map_points)
 	{
 		float x_local,y_local,z_local;
 		otherMapPose.composePoint(
 			otherMap->x[localIdx], otherMap->y[localIdx], otherMap->z[localIdx],
 			x_local,y_local,z_local );
 
-		x_locals[localIdx] = x_local;
-		y_locals[localIdx] = y_local;
-		z_locals[localIdx] = z_local;
+		x_locals[queryIdx] = x_local;
+		y_locals[queryIdx] = y_local;
+		z_locals[queryIdx] = z_local;
 
 		// Find the bounding box:
 		local_x_min = min(local_x_min,x_local);
@@ -1107,26 +1425,26 @@ void  CPointsMap::determineMatching3D(
 		local_y_max<global_y_min) return;	// No hace falta hacer matching,
 											//   porque es de CERO.
 
+	// KD-TREE implementation
+	// Use a KD-tree to look for the nearnest neighbor of each local point
+	// in "this" (global/reference) points map. All the queries are solved at once, in parallel:
+	std::vector<size_t> nn_idxs;
+	std::vector<float>  nn_dists_sqr;
+	kdTreeClosestPoint3DBatch(&x_locals[0],&y_locals[0],&z_locals[0],nQueries, nn_idxs,nn_dists_sqr);
+
 	// Loop for each point in local map:
 	// --------------------------------------------------
-	for (unsigned int localIdx=params.offset_other_map_points; localIdx<nLocalPoints; localIdx+=params.decimation_other_map_points)
+	for (size_t queryIdx=0,localIdx=params.offset_other_map_points; localIdx<nLocalPoints; queryIdx++,localIdx+=params.decimation_other_map_points)
 	{
 		// For speed-up:
-		const float x_local = x_locals[localIdx];
-		const float y_local = y_locals[localIdx];
-		const float z_local = z_locals[localIdx];
+		const float x_local = x_locals[queryIdx];
+		const float y_local = y_locals[queryIdx];
+		const float z_local = z_locals[queryIdx];
 
 		{
-			// KD-TREE implementation
-			// Use a KD-tree to look for the nearnest neighbor of:
-			//   (x_local, y_local, z_local)
-			// In "this" (global/reference) points map.
-
-			float tentativ_err_sq;
-			const unsigned int tentativ_this_idx = kdTreeClosestPoint3D(
-				x_local,  y_local, z_local,  // Look closest to this guy
-				tentativ_err_sq // save here the min. distance squared
-				);
+			// The closest point in "this" map:
+			const float tentativ_err_sq = nn_dists_sqr[queryIdx];
+			const unsigned int tentativ_this_idx = nn_idxs[queryIdx];
 
 			// Compute max. allowed distance:
 			maxDistForCorrespondenceSquared = square(
@@ -1593,41 +1911,9 @@ void  CPointsMap::addFrom(const CPointsMap &anotherMap)
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(anotherMap,nThis);
 
-	mark_as_modified();
-}
-
-/** Save the point cloud as a PCL PCD file, in either ASCII or binary format \return false on any error */
-bool CPointsMap::savePCDFile(const std::string &filename, bool save_as_binary) const
-{
-#if MRPT_HAS_PCL
-	pcl::PointCloud<pcl::PointXYZ> cloud;
-	this->getPCLPointCloud(cloud);
-
-	return 0 == pcl::io::savePCDFile(filename, cloud, save_as_binary);
-
-#else
-	THROW_EXCEPTION("Operation not available: MRPT was built without PCL")
-#endif
-}
-
-/** Load the point cloud from a PCL PCD file (requires MRPT built against PCL) \return false on any error */
-bool CPointsMap::loadPCDFile(const std::string &filename)
-{
-#if MRPT_HAS_PCL
-	pcl::PointCloud<pcl::PointXYZ> cloud;
-	if (0!=pcl::io::loadPCDFile(filename,cloud))
-		return false;
-
-	this->getPCLPointCloud(cloud);
-
-	return true;
-#else
-	THROW_EXCEPTION("Operation not available: MRPT was built without PCL")
-#endif
+	mark_as_points_appended();
 }
 
-
-
 /*---------------------------------------------------------------
 						applyDeletionMask
  ---------------------------------------------------------------*/
@@ -1686,7 +1972,7 @@ void  CPointsMap::insertAnotherMap(
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(*otherMap, N_this);
 
-	mark_as_modified();
+	mark_as_points_appended();
 }
 
 
@@ -1708,6 +1994,8 @@ void  CPointsMap::base_copyFrom(const CPointsMap &obj)
 	// Fill missing fields (R,G,B,min_dist) with default values.
 	this->resize(x.size());
 
+	m_local_shapes.clear();
+	m_voxel_downsampled.clear();
 	kdtree_mark_as_outdated();
 
 	MRPT_END
@@ -1743,7 +2031,7 @@ bool  CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation2DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		// (The map is marked as modified, or with new points, by fuseWith() / loadFromRangeScan() below)
 
 		const CObservation2DRangeScan *o = static_cast<const CObservation2DRangeScan *>(obs);
 		// Insert only HORIZONTAL scans??
@@ -1759,7 +2047,16 @@ bool  CPointsMap::internal_insertObservation(
 
 			// 1) Fuse into the points map or add directly?
 			// ----------------------------------------------
-			if (insertionOptions.fuseWithExisting)
+			if (insertionOptions.voxelFusionSize>0)
+			{
+				CSimplePointsMap	auxMap;
+				auxMap.insertionOptions = insertionOptions;
+				auxMap.insertionOptions.addToExistingPointsMap = false;
+				auxMap.loadFromRangeScan(*o, &robotPose3D);
+
+				fuseWithVoxels(auxMap, insertionOptions.voxelFusionSize, insertionOptions.voxelFusionAverage);
+			}
+			else if (insertionOptions.fuseWithExisting)
 			{
 				CSimplePointsMap	auxMap;
 				// Fuse:
@@ -1836,7 +2133,7 @@ bool  CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation3DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		// (The map is marked as modified, or with new points, by fuseWith() / loadFromRangeScan() below)
 
 		const CObservation3DRangeScan *o = static_cast<const CObservation3DRangeScan *>(obs);
 		// Insert only HORIZONTAL scans??
@@ -1850,7 +2147,16 @@ bool  CPointsMap::internal_insertObservation(
 		{
 			// 1) Fuse into the points map or add directly?
 			// ----------------------------------------------
-			if (insertionOptions.fuseWithExisting)
+			if (insertionOptions.voxelFusionSize>0)
+			{
+				CSimplePointsMap	auxMap;
+				auxMap.insertionOptions = insertionOptions;
+				auxMap.insertionOptions.addToExistingPointsMap = false;
+				auxMap.loadFromRangeScan(*o, &robotPose3D);
+
+				fuseWithVoxels(auxMap, insertionOptions.voxelFusionSize, insertionOptions.voxelFusionAverage);
+			}
+			else if (insertionOptions.fuseWithExisting)
 			{
 				// Fuse:
 				CSimplePointsMap	auxMap;
@@ -0,0 +1,571 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/maps.h>  // Precompiled header
+
+#include <mrpt/slam/CPointsMap.h>
+#include <mrpt/utils/CFileInputStream.h>
+#include <mrpt/utils/CFileOutputStream.h>
+#include <mrpt/utils/CFileMMapInputStream.h>
+#include <mrpt/system/string_utils.h>
+
+#if MRPT_HAS_PCL
+#   include <pcl/io/pcd_io.h>
+#   include <pcl/point_types.h>
+#endif
+
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	// The MRPT binary columnar format (see CPointsMap::saveBinaryColumnsFile()):
+	const char     BINCOLS_MAGIC[8] = {'M','R','P','T','P','T','S',0};
+	const uint32_t BINCOLS_VERSION  = 1;
+	const size_t   BINCOLS_NAME_LEN = 16;
+	const size_t   BINCOLS_ALIGN    = 16;
+
+	// Number of points interleaved or deinterleaved at once in PCD files:
+	const size_t   PCD_CHUNK_POINTS = 1<<16;
+
+	inline uint64_t bincols_align(uint64_t pos)
+	{
+		return pos + (BINCOLS_ALIGN - pos%BINCOLS_ALIGN)%BINCOLS_ALIGN;
+	}
+
+	void readBinaryColumns(CStream &in, CPointsMap &map)
+	{
+		char magic[sizeof(BINCOLS_MAGIC)];
+		in.ReadBuffer(magic,sizeof(magic));
+		if (memcmp(magic,BINCOLS_MAGIC,sizeof(magic)))
+			THROW_EXCEPTION("Not a MRPT binary columnar point cloud file")
+
+		uint32_t version, nCols;
+		uint64_t N;
+		in >> version >> nCols >> N;
+		if (version!=BINCOLS_VERSION)
+			THROW_EXCEPTION_CUSTOM_MSG1("Unsupported file version: %u",static_cast<unsigned int>(version))
+
+		std::vector<std::string> names(nCols);
+		std::vector<uint8_t>     types(nCols), sizes(nCols);
+		for (uint32_t i=0;i<nCols;i++)
+		{
+			char    name[BINCOLS_NAME_LEN];
+			uint8_t desc[8];
+			in.ReadBuffer(name,sizeof(name));
+			in.ReadBuffer(desc,sizeof(desc));
+			names[i] = std::string(name, std::find(name,name+BINCOLS_NAME_LEN,'\0'));
+			types[i] = desc[0];
+			sizes[i] = desc[1];
+		}
+
+		map.setSize(N);
+		std::vector<CPointsMap::TPointsColumn> cols;
+		map.getPointsColumns(cols);
+
+		for (uint32_t i=0;i<nCols;i++)
+		{
+			const uint64_t pos = bincols_align(in.getPosition());
+			in.Seek(pos);
+
+			// The buffers of the map are written directly (the map is not const here):
+			void *dst = NULL;
+			for (size_t j=0;j<cols.size() && !dst;j++)
+				if (cols[j].name==names[i] && cols[j].type==static_cast<char>(types[i]) && sizes[i]==4)
+					dst = const_cast<void*>(cols[j].data);
+
+			if (!dst || !N)
+			{
+				in.Seek(pos+N*sizes[i]);
+				continue;
+			}
+
+			const size_t nRead = types[i]=='F' ?
+				in.ReadBufferFixEndianness(static_cast<float*>(dst),N) :
+				in.ReadBufferFixEndianness(static_cast<uint32_t*>(dst),N);
+			if (nRead!=N*4)
+				THROW_EXCEPTION_CUSTOM_MSG1("Truncated file reading column '%s'",names[i].c_str())
+		}
+	}
+
+	/** The PCD fields of a point map: its columns, with the colors packed into a PCL "rgb" field */
+	void getPCDColumns(const CPointsMap &map, std::vector<CPointsMap::TPointsColumn> &cols, std::vector<uint32_t> &rgb)
+	{
+		map.getPointsColumns(cols);
+
+		int idx[3] = {-1,-1,-1};
+		for (size_t j=0;j<cols.size();j++)
+		{
+			if (cols[j].name=="color_R") idx[0]=static_cast<int>(j);
+			if (cols[j].name=="color_G") idx[1]=static_cast<int>(j);
+			if (cols[j].name=="color_B") idx[2]=static_cast<int>(j);
+		}
+		if (idx[0]<0 || idx[1]<0 || idx[2]<0)
+			return;
+
+		const size_t N = map.size();
+		const float *R = static_cast<const float*>(cols[idx[0]].data);
+		const float *G = static_cast<const float*>(cols[idx[1]].data);
+		const float *B = static_cast<const float*>(cols[idx[2]].data);
+		rgb.resize(N);
+		for (size_t i=0;i<N;i++)
+		{
+			const uint32_t r = static_cast<uint32_t>( std::min(std::max(R[i],0.f),1.f)*255.f+0.5f );
+			const uint32_t g = static_cast<uint32_t>( std::min(std::max(G[i],0.f),1.f)*255.f+0.5f );
+			const uint32_t b = static_cast<uint32_t>( std::min(std::max(B[i],0.f),1.f)*255.f+0.5f );
+			rgb[i] = (r<<16) | (g<<8) | b;
+		}
+
+		// Replace the three color columns by the packed one:
+		std::vector<CPointsMap::TPointsColumn> out;
+		for (size_t j=0;j<cols.size();j++)
+			if (static_cast<int>(j)!=idx[0] && static_cast<int>(j)!=idx[1] && static_cast<int>(j)!=idx[2])
+				out.push_back(cols[j]);
+		out.push_back(CPointsMap::TPointsColumn("rgb",'F', rgb.empty() ? NULL : &rgb[0]));
+		cols.swap(out);
+	}
+
+	/** Where a field of a PCD file is stored in the map */
+	struct TPCDFieldDst
+	{
+		TPCDFieldDst() : kind(0), dst(NULL) { }
+		char   kind;   //!< 0: ignored, 'F': float column, 'U': uint32_t column, 'C': packed colors
+		void  *dst;    //!< The column, or the first of the 3 color columns
+	};
+
+	/** Reads a binary value of any PCD type */
+	double readPCDValue(const uint8_t *p, char type, int size)
+	{
+		switch (type)
+		{
+		case 'F':
+			if (size==4) { float v; memcpy(&v,p,4); return v; }
+			if (size==8) { double v; memcpy(&v,p,8); return v; }
+			break;
+		case 'U':
+			if (size==1) return *p;
+			if (size==2) { uint16_t v; memcpy(&v,p,2); return v; }
+			if (size==4) { uint32_t v; memcpy(&v,p,4); return v; }
+			break;
+		case 'I':
+			if (size==1) return *reinterpret_cast<const int8_t*>(p);
+			if (size==2) { int16_t v; memcpy(&v,p,2); return v; }
+			if (size==4) { int32_t v; memcpy(&v,p,4); return v; }
+			break;
+		};
+		THROW_EXCEPTION_CUSTOM_MSG1("Unsupported PCD field type '%c'",type)
+	}
+
+	inline void storePackedColor(const TPCDFieldDst &d, size_t i, uint32_t bits)
+	{
+		float *R = static_cast<float**>(d.dst)[0], *G = static_cast<float**>(d.dst)[1], *B = static_cast<float**>(d.dst)[2];
+		R[i] = ((bits>>16) & 0xFF)*(1.f/255);
+		G[i] = ((bits>>8)  & 0xFF)*(1.f/255);
+		B[i] = ( bits      & 0xFF)*(1.f/255);
+	}
+
+	/** Reads a line of the PCD header, returning false at the end of the file */
+	bool readPCDLine(CStream &in, std::string &line)
+	{
+		line.clear();
+		const uint64_t total = in.getTotalBytesCount();
+		if (in.getPosition()>=total)
+			return false;
+		char c;
+		while (in.getPosition()<total)
+		{
+			in.ReadBuffer(&c,1);
+			if (c=='\n') break;
+			if (c!='\r') line+=c;
+		}
+		return true;
+	}
+
+	bool readPCD(CStream &in, CPointsMap &map, std::string &out_data_format)
+	{
+		std::vector<std::string> fields;
+		std::vector<int>         sizes, counts;
+		std::vector<char>        types;
+		size_t width=0, height=1, nPoints=0;
+		bool   have_points = false;
+
+		std::string line;
+		std::vector<std::string> toks;
+		out_data_format.clear();
+		while (out_data_format.empty() && readPCDLine(in,line))
+		{
+			if (line.empty() || line[0]=='#') continue;
+			tokenize(line," \t",toks);
+			if (toks.empty()) continue;
+			const std::string &key = toks[0];
+			if (key=="FIELDS")
+				fields.assign(toks.begin()+1,toks.end());
+			else if (key=="SIZE")
+			{
+				sizes.clear();
+				for (size_t k=1;k<toks.size();k++) sizes.push_back(atoi(toks[k].c_str()));
+			}
+			else if (key=="TYPE")
+			{
+				types.clear();
+				for (size_t k=1;k<toks.size();k++) types.push_back(toks[k].empty() ? ' ' : toks[k][0]);
+			}
+			else if (key=="COUNT")
+			{
+				counts.clear();
+				for (size_t k=1;k<toks.size();k++) counts.push_back(atoi(toks[k].c_str()));
+			}
+			else if (key=="WIDTH"  && toks.size()>1) width  = atoi(toks[1].c_str());
+			else if (key=="HEIGHT" && toks.size()>1) height = atoi(toks[1].c_str());
+			else if (key=="POINTS" && toks.size()>1) { nPoints = atoi(toks[1].c_str()); have_points=true; }
+			else if (key=="DATA"   && toks.size()>1) out_data_format = toks[1];
+		}
+
+		if (out_data_format.empty())
+			THROW_EXCEPTION("PCD header without DATA line")
+		if (out_data_format!="ascii" && out_data_format!="binary")
+			return false;  // e.g. "binary_compressed"
+
+		const size_t nFields = fields.size();
+		if (counts.empty()) counts.assign(nFields,1);
+		if (sizes.size()!=nFields || types.size()!=nFields || counts.size()!=nFields)
+			THROW_EXCEPTION("Inconsistent FIELDS, SIZE, TYPE and COUNT lines in PCD header")
+		if (!have_points) nPoints = width*height;
+
+		// Match the fields of the file with the columns of the map:
+		map.setSize(nPoints);
+		std::vector<CPointsMap::TPointsColumn> cols;
+		map.getPointsColumns(cols);
+
+		float *colorCols[3] = {NULL,NULL,NULL};
+		for (size_t j=0;j<cols.size();j++)
+		{
+			if (cols[j].name=="color_R") colorCols[0] = static_cast<float*>(const_cast<void*>(cols[j].data));
+			if (cols[j].name=="color_G") colorCols[1] = static_cast<float*>(const_cast<void*>(cols[j].data));
+			if (cols[j].name=="color_B") colorCols[2] = static_cast<float*>(const_cast<void*>(cols[j].data));
+		}
+
+		std::vector<TPCDFieldDst> dsts(nFields);
+		std::vector<size_t>       offsets(nFields);
+		size_t stride = 0;
+		for (size_t k=0;k<nFields;k++)
+		{
+			offsets[k] = stride;
+			stride += sizes[k]*counts[k];
+			if (counts[k]!=1 || !nPoints) continue;
+
+			if ((fields[k]=="rgb" || fields[k]=="rgba") && sizes[k]==4 && colorCols[0] && colorCols[1] && colorCols[2])
+			{
+				dsts[k].kind = 'C';
+				dsts[k].dst  = colorCols;
+				continue;
+			}
+			for (size_t j=0;j<cols.size();j++)
+				if (cols[j].name==fields[k])
+				{
+					dsts[k].kind = cols[j].type;
+					dsts[k].dst  = const_cast<void*>(cols[j].data);
+				}
+		}
+
+		if (out_data_format=="binary")
+		{
+			std::vector<uint8_t>   buf;
+			CMemoryMappedRegionPtr owner;
+			for (size_t i0=0;i0<nPoints;i0+=PCD_CHUNK_POINTS)
+			{
+				const size_t n = std::min(PCD_CHUNK_POINTS, nPoints-i0);
+				const uint8_t *data = static_cast<const uint8_t*>( in.ReadBufferBorrow(n*stride,owner) );
+				if (!data)
+				{
+					buf.resize(n*stride);
+					if (in.ReadBuffer(&buf[0],buf.size())!=buf.size())
+						THROW_EXCEPTION("Truncated PCD file")
+					data = &buf[0];
+				}
+
+				for (size_t k=0;k<nFields;k++)
+				{
+					const TPCDFieldDst &d = dsts[k];
+					if (!d.kind) continue;
+					const uint8_t *p = data + offsets[k];
+					const bool raw = sizes[k]==4 && (d.kind==types[k] || d.kind=='C');
+					for (size_t i=i0;i<i0+n;i++, p+=stride)
+					{
+						if (raw)
+						{
+							if (d.kind=='C')
+							{
+								uint32_t bits;
+								memcpy(&bits,p,4);
+								storePackedColor(d,i,bits);
+							}
+							else memcpy(static_cast<uint8_t*>(d.dst)+4*i,p,4);
+						}
+						else
+						{
+							const double v = readPCDValue(p,types[k],sizes[k]);
+							if (d.kind=='F') static_cast<float*>(d.dst)[i] = static_cast<float>(v);
+							else if (d.kind=='U') static_cast<uint32_t*>(d.dst)[i] = static_cast<uint32_t>(v);
+							else storePackedColor(d,i,static_cast<uint32_t>(v));
+						}
+					}
+				}
+			}
+		}
+		else
+		{
+			// ASCII: parse the rest of the file at once:
+			const size_t nBytes = static_cast<size_t>(in.getTotalBytesCount()-in.getPosition());
+			std::string txt(nBytes,'\0');
+			if (nBytes)
+				in.ReadBuffer(&txt[0],nBytes);
+
+			const char *ptr = txt.c_str();
+			for (size_t i=0;i<nPoints;i++)
+			{
+				for (size_t k=0;k<nFields;k++)
+				{
+					for (int c=0;c<counts[k];c++)
+					{
+						char *end;
+						const double v = strtod(ptr,&end);
+						if (end==ptr)
+							THROW_EXCEPTION_CUSTOM_MSG1("Error parsing the data of point #%u in PCD file",static_cast<unsigned int>(i))
+						ptr = end;
+
+						const TPCDFieldDst &d = dsts[k];
+						if (d.kind=='F') static_cast<float*>(d.dst)[i] = static_cast<float>(v);
+						else if (d.kind=='U') static_cast<uint32_t*>(d.dst)[i] = static_cast<uint32_t>(v);
+						else if (d.kind=='C')
+						{
+							// PCL writes colors as integers, but they may also be the packed float:
+							uint32_t bits;
+							if (v>=1.0) bits = static_cast<uint32_t>(v);
+							else { const float f = static_cast<float>(v); memcpy(&bits,&f,4); }
+							storePackedColor(d,i,bits);
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+}
+
+/*---------------------------------------------------------------
+				saveBinaryColumnsFile
+  ---------------------------------------------------------------*/
+bool CPointsMap::saveBinaryColumnsFile(const std::string &filename) const
+{
+	try
+	{
+		CFileOutputStream out;
+		if (!out.open(filename))
+			return false;
+
+		std::vector<TPointsColumn> cols;
+		getPointsColumns(cols);
+		const size_t N = size();
+
+		out.WriteBuffer(BINCOLS_MAGIC,sizeof(BINCOLS_MAGIC));
+		out << BINCOLS_VERSION << static_cast<uint32_t>(cols.size()) << static_cast<uint64_t>(N);
+		for (size_t j=0;j<cols.size();j++)
+		{
+			ASSERT_(cols[j].name.size()<BINCOLS_NAME_LEN)
+			char    name[BINCOLS_NAME_LEN];
+			uint8_t desc[8] = { static_cast<uint8_t>(cols[j].type), 4, 0,0,0,0,0,0 };
+			memset(name,0,sizeof(name));
+			memcpy(name,cols[j].name.c_str(),cols[j].name.size());
+			out.WriteBuffer(name,sizeof(name));
+			out.WriteBuffer(desc,sizeof(desc));
+		}
+
+		// Each column with a single write:
+		const char zeros[BINCOLS_ALIGN] = {0};
+		for (size_t j=0;j<cols.size();j++)
+		{
+			const uint64_t pos = out.getPosition();
+			const size_t nPad = static_cast<size_t>(bincols_align(pos)-pos);
+			if (nPad) out.WriteBuffer(zeros,nPad);
+			if (!N) continue;
+
+			if (cols[j].type=='F')
+				out.WriteBufferFixEndianness(static_cast<const float*>(cols[j].data),N);
+			else
+				out.WriteBufferFixEndianness(static_cast<const uint32_t*>(cols[j].data),N);
+		}
+		return true;
+	}
+	catch (std::exception &e)
+	{
+		cerr << "[CPointsMap::saveBinaryColumnsFile] Error: " << e.what() << endl;
+		return false;
+	}
+}
+
+/*---------------------------------------------------------------
+				loadBinaryColumnsFile
+  ---------------------------------------------------------------*/
+bool CPointsMap::loadBinaryColumnsFile(const std::string &filename, bool use_mmap)
+{
+	try
+	{
+		if (use_mmap)
+		{
+			CFileMMapInputStream in;
+			if (!in.open(filename))
+				return false;
+			readBinaryColumns(in,*this);
+		}
+		else
+		{
+			CFileInputStream in;
+			if (!in.open(filename))
+				return false;
+			readBinaryColumns(in,*this);
+		}
+		mark_as_modified();
+		return true;
+	}
+	catch (std::exception &e)
+	{
+		mark_as_modified();  // The map may have been partially loaded
+		cerr << "[CPointsMap::loadBinaryColumnsFile] Error: " << e.what() << endl;
+		return false;
+	}
+}
+
+/*---------------------------------------------------------------
+				savePCDFile
+  ---------------------------------------------------------------*/
+bool CPointsMap::savePCDFile(const std::string &filename, bool save_as_binary) const
+{
+	try
+	{
+		CFileOutputStream out;
+		if (!out.open(filename))
+			return false;
+
+		std::vector<TPointsColumn> cols;
+		std::vector<uint32_t>      rgb;
+		getPCDColumns(*this,cols,rgb);
+		const size_t N = size(), nCols = cols.size();
+
+		std::string sFields, sSizes, sTypes, sCounts;
+		for (size_t j=0;j<nCols;j++)
+		{
+			sFields += " " + cols[j].name;
+			sSizes  += " 4";
+			sTypes  += std::string(" ") + cols[j].type;
+			sCounts += " 1";
+		}
+		out.printf(
+			"# .PCD v0.7 - Point Cloud Data file format\n"
+			"VERSION 0.7\n"
+			"FIELDS%s\n"
+			"SIZE%s\n"
+			"TYPE%s\n"
+			"COUNT%s\n"
+			"WIDTH %u\n"
+			"HEIGHT 1\n"
+			"VIEWPOINT 0 0 0 1 0 0 0\n"
+			"POINTS %u\n"
+			"DATA %s\n",
+			sFields.c_str(), sSizes.c_str(), sTypes.c_str(), sCounts.c_str(),
+			static_cast<unsigned int>(N), static_cast<unsigned int>(N),
+			save_as_binary ? "binary" : "ascii");
+
+		if (save_as_binary)
+		{
+			// Interleave the columns in large blocks:
+			std::vector<uint8_t> buf(std::min(N,PCD_CHUNK_POINTS)*nCols*4);
+			for (size_t i0=0;i0<N;i0+=PCD_CHUNK_POINTS)
+			{
+				const size_t n = std::min(PCD_CHUNK_POINTS, N-i0);
+				for (size_t j=0;j<nCols;j++)
+				{
+					const uint8_t *src = static_cast<const uint8_t*>(cols[j].data) + 4*i0;
+					uint8_t *dst = &buf[4*j];
+					for (size_t i=0;i<n;i++, src+=4, dst+=4*nCols)
+						memcpy(dst,src,4);
+				}
+				out.WriteBuffer(&buf[0],n*nCols*4);
+			}
+		}
+		else
+		{
+			std::string txt;
+			char        val[32];
+			for (size_t i=0;i<N;i++)
+			{
+				for (size_t j=0;j<nCols;j++)
+				{
+					if (j) txt+=' ';
+					// As PCL, write the packed colors as integers:
+					if (cols[j].type=='U' || cols[j].name=="rgb")
+						mrpt::system::os::sprintf(val,sizeof(val),"%u",static_cast<const uint32_t*>(cols[j].data)[i]);
+					else mrpt::system::os::sprintf(val,sizeof(val),"%.9g",static_cast<const float*>(cols[j].data)[i]);
+					txt+=val;
+				}
+				txt+='\n';
+				if (txt.size()>(1<<20) || i+1==N)
+				{
+					out.WriteBuffer(txt.c_str(),txt.size());
+					txt.clear();
+				}
+			}
+		}
+		return true;
+	}
+	catch (std::exception &e)
+	{
+		cerr << "[CPointsMap::savePCDFile] Error: " << e.what() << endl;
+		return false;
+	}
+}
+
+/*---------------------------------------------------------------
+				loadPCDFile
+  ---------------------------------------------------------------*/
+bool CPointsMap::loadPCDFile(const std::string &filename)
+{
+	std::string dataFormat;
+	try
+	{
+		CFileMMapInputStream in;
+		if (!in.open(filename))
+			return false;
+		const bool ok = readPCD(in,*this,dataFormat);
+		mark_as_modified();
+		if (ok)
+			return true;
+	}
+	catch (std::exception &e)
+	{
+		mark_as_modified();  // The map may have been partially loaded
+		cerr << "[CPointsMap::loadPCDFile] Error: " << e.what() << endl;
+		return false;
+	}
+
+#if MRPT_HAS_PCL
+	// Other formats (e.g. "binary_compressed"):
+	pcl::PointCloud<pcl::PointXYZ> cloud;
+	if (0!=pcl::io::loadPCDFile(filename,cloud))
+		return false;
+
+	this->setFromPCLPointCloud(cloud);
+	return true;
+#else
+	cerr << "[CPointsMap::loadPCDFile] Unsupported PCD data format: '" << dataFormat << "' (MRPT was built without PCL)" << endl;
+	return false;
+#endif
+}
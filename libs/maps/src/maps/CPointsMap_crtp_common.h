@@ -24,7 +24,10 @@ namespace detail
 			const CObservation2DRangeScan		&rangeScan,
 			const CPose3D						*robotPose )
 		{
-			obj.mark_as_modified();
+			// Only new points are added to the map, unless it is cleared first:
+			if (obj.insertionOptions.addToExistingPointsMap)
+			     obj.mark_as_points_appended();
+			else obj.mark_as_modified();
 
 			// If robot pose is supplied, compute sensor pose relative to it.
 			CPose3D sensorPose3D(UNINITIALIZED_POSE);
@@ -288,7 +291,10 @@ namespace detail
 			const CObservation3DRangeScan		&rangeScan,
 			const CPose3D						*robotPose )
 		{
-			obj.mark_as_modified();
+			// Only new points are added to the map, unless it is cleared first:
+			if (obj.insertionOptions.addToExistingPointsMap)
+			     obj.mark_as_points_appended();
+			else obj.mark_as_modified();
 
 			// If robot pose is supplied, compute sensor pose relative to it.
 			CPose3D sensorPose3D(UNINITIALIZED_POSE);
@@ -9,6 +9,8 @@
 
 
 #include <mrpt/maps.h>
+#include <mrpt/random.h>
+#include <mrpt/system/filesystem.h>
 #include <gtest/gtest.h>
 
 using namespace mrpt;
@@ -104,6 +106,156 @@ void do_test_clipOutOfRangeInZ()
 
 }
 
+template <class MAP>
+void do_test_kdTreeBatchQueries()
+{
+	mrpt::random::CRandomGenerator rng(1234);
+
+	MAP  pts;
+	for (size_t i=0;i<2000;i++)
+		pts.insertPoint(rng.drawUniform(-10,10),rng.drawUniform(-10,10),rng.drawUniform(-1,1));
+
+	const size_t nQueries = 1000, knn = 3;
+	std::vector<float> qxs(nQueries),qys(nQueries),qzs(nQueries);
+	for (size_t i=0;i<nQueries;i++)
+	{
+		qxs[i]=rng.drawUniform(-12,12);
+		qys[i]=rng.drawUniform(-12,12);
+		qzs[i]=rng.drawUniform(-2,2);
+	}
+
+	std::vector<size_t> idxs, idxs_k;
+	std::vector<float>  dists, dists_k;
+	std::vector< std::vector<std::pair<size_t,float> > > radius_res;
+
+	// 2D:
+	pts.kdTreeClosestPoint2DBatch(&qxs[0],&qys[0],nQueries,idxs,dists);
+	pts.kdTreeNClosestPoint2DIdxBatch(&qxs[0],&qys[0],nQueries,knn,idxs_k,dists_k);
+	pts.kdTreeRadiusSearch2DBatch(&qxs[0],&qys[0],nQueries,0.5f,radius_res);
+	ASSERT_EQ(idxs.size(),nQueries);
+	ASSERT_EQ(idxs_k.size(),nQueries*knn);
+	ASSERT_EQ(radius_res.size(),nQueries);
+	for (size_t i=0;i<nQueries;i++)
+	{
+		float d;
+		const size_t idx = pts.kdTreeClosestPoint2D(qxs[i],qys[i],d);
+		EXPECT_EQ(idx,idxs[i]);
+		EXPECT_EQ(d,dists[i]);
+
+		std::vector<size_t> ki;
+		std::vector<float>  kd;
+		pts.kdTreeNClosestPoint2DIdx(qxs[i],qys[i],knn,ki,kd);
+		for (size_t k=0;k<knn;k++) {
+			EXPECT_EQ(ki[k],idxs_k[i*knn+k]);
+			EXPECT_EQ(kd[k],dists_k[i*knn+k]);
+		}
+
+		std::vector<std::pair<size_t,float> > ri;
+		pts.kdTreeRadiusSearch2D(qxs[i],qys[i],0.5f,ri);
+		EXPECT_EQ(ri.size(),radius_res[i].size());
+	}
+
+	// 3D:
+	pts.kdTreeClosestPoint3DBatch(&qxs[0],&qys[0],&qzs[0],nQueries,idxs,dists);
+	pts.kdTreeNClosestPoint3DIdxBatch(&qxs[0],&qys[0],&qzs[0],nQueries,knn,idxs_k,dists_k);
+	pts.kdTreeRadiusSearch3DBatch(&qxs[0],&qys[0],&qzs[0],nQueries,0.5f,radius_res);
+	for (size_t i=0;i<nQueries;i++)
+	{
+		float d;
+		const size_t idx = pts.kdTreeClosestPoint3D(qxs[i],qys[i],qzs[i],d);
+		EXPECT_EQ(idx,idxs[i]);
+		EXPECT_EQ(d,dists[i]);
+
+		std::vector<size_t> ki;
+		std::vector<float>  kd;
+		pts.kdTreeNClosestPoint3DIdx(qxs[i],qys[i],qzs[i],knn,ki,kd);
+		for (size_t k=0;k<knn;k++) {
+			EXPECT_EQ(ki[k],idxs_k[i*knn+k]);
+			EXPECT_EQ(kd[k],dists_k[i*knn+k]);
+		}
+
+		std::vector<std::pair<size_t,float> > ri;
+		pts.kdTreeRadiusSearch3D(qxs[i],qys[i],qzs[i],0.5f,ri);
+		EXPECT_EQ(ri.size(),radius_res[i].size());
+	}
+}
+
+// Queries on a map which grows between queries (KD-tree "logarithmic forest") must give the same results than brute force:
+template <class MAP>
+void do_test_kdTreeIncrementalBuild()
+{
+	mrpt::random::CRandomGenerator rng(4321);
+
+	MAP  pts;
+	for (size_t step=0;step<40;step++)
+	{
+		const size_t nNew = (step%7)==0 ? 150 : 1+(step%5);
+		for (size_t i=0;i<nNew;i++)
+			pts.insertPoint(rng.drawUniform(-10,10),rng.drawUniform(-10,10),rng.drawUniform(-1,1));
+
+		for (size_t q=0;q<20;q++)
+		{
+			const float qx=rng.drawUniform(-11,11), qy=rng.drawUniform(-11,11), qz=rng.drawUniform(-2,2);
+
+			float best2d = std::numeric_limits<float>::max(), best3d = best2d;
+			for (size_t i=0;i<pts.size();i++)
+			{
+				float x,y,z;
+				pts.getPoint(i,x,y,z);
+				const float d2 = square(x-qx)+square(y-qy);
+				best2d = std::min(best2d,d2);
+				best3d = std::min(best3d,d2+square(z-qz));
+			}
+
+			float d;
+			const size_t idx2d = pts.kdTreeClosestPoint2D(qx,qy,d);
+			EXPECT_FLOAT_EQ(best2d,d);
+			ASSERT_LT(idx2d,pts.size());
+
+			const size_t idx3d = pts.kdTreeClosestPoint3D(qx,qy,qz,d);
+			EXPECT_FLOAT_EQ(best3d,d);
+			ASSERT_LT(idx3d,pts.size());
+		}
+	}
+
+	// Removing points must rebuild the KD-tree:
+	pts.clipOutOfRangeInZ(0,10);
+	float d;
+	const size_t idx = pts.kdTreeClosestPoint3D(0,0,-5,d);
+	ASSERT_LT(idx,pts.size());
+}
+
+// Voxel-grid decimation: one point (the mean) per occupied voxel, and the cached version is invalidated upon changes:
+template <class MAP>
+void do_test_voxelDownsample()
+{
+	MAP  pts;
+	// 4 clusters of 10 points each, in different voxels of 1m:
+	for (int c=0;c<4;c++)
+		for (int i=0;i<10;i++)
+			pts.insertPoint(0.5f+2*c+0.01f*i, -0.5f-0.01f*i, 0.5f);
+
+	CSimplePointsMap  decim;
+	pts.voxelDownsample(1.0f,decim);
+	ASSERT_EQ(decim.size(),4u);
+
+	float sx=0,sy=0,sz=0;
+	for (size_t i=0;i<decim.size();i++)
+	{
+		float x,y,z;
+		decim.getPoint(i,x,y,z);
+		sx+=x; sy+=y; sz+=z;
+	}
+	EXPECT_NEAR(sx, 4*(0.5f+0.045f)+2*(0+1+2+3), 1e-4);
+	EXPECT_NEAR(sy, 4*(-0.5f-0.045f), 1e-4);
+	EXPECT_NEAR(sz, 4*0.5f, 1e-4);
+
+	EXPECT_EQ(pts.getVoxelDownsampled(1.0f).size(),4u);
+	EXPECT_EQ(pts.getVoxelDownsampled(100.0f).size(),1u);
+	pts.insertPoint(-10,-10,-10);
+	EXPECT_EQ(pts.getVoxelDownsampled(1.0f).size(),5u);
+}
+
 template <class MAP>
 void do_test_clipOutOfRange()
 {
@@ -142,6 +294,132 @@ void do_test_clipOutOfRange()
 
 }
 
+// Voxel-hashed fusion: one point per voxel, either the first one or the mean:
+template <class MAP>
+void do_test_fuseWithVoxels()
+{
+	CSimplePointsMap  scan;
+	for (int i=0;i<10;i++)
+		scan.insertPoint(0.05f+i, 0.05f, 0.05f);
+
+	for (int avg=0;avg<2;avg++)
+	{
+		MAP  pts;
+		EXPECT_EQ(pts.fuseWithVoxels(scan,0.5f,avg!=0),10u);
+		ASSERT_EQ(pts.size(),10u);
+
+		// The same points, slightly displaced (within the same voxels): nothing is added
+		CSimplePointsMap  scan2;
+		scan2.changeCoordinatesReference(scan,CPose3D(0.1,0.1,0.1,0,0,0));
+		EXPECT_EQ(pts.fuseWithVoxels(scan2,0.5f,avg!=0),0u);
+		EXPECT_EQ(pts.size(),10u);
+
+		float x,y,z;
+		pts.getPoint(3,x,y,z);
+		EXPECT_NEAR(x, avg ? 3.1f : 3.05f, 1e-5);
+		EXPECT_NEAR(y, avg ? 0.1f : 0.05f, 1e-5);
+		EXPECT_EQ(pts.getPointWeight(3), (avg && pts.GetRuntimeClass()==CLASS_ID(CWeightedPointsMap)) ? 2u : 1u);
+
+		// Points inserted by other means are also indexed, and new voxels are appended:
+		float dist_sq;
+		EXPECT_EQ(pts.kdTreeClosestPoint2D(3.f,0.f,x,y,dist_sq),3u);
+		pts.insertPoint(20.05f,0,0);
+		CSimplePointsMap  scan3;
+		scan3.insertPoint(20.1f,0.1f,0.1f);
+		scan3.insertPoint(30,0,0);
+		EXPECT_EQ(pts.fuseWithVoxels(scan3,0.5f,avg!=0),1u);
+		EXPECT_EQ(pts.size(),12u);
+
+		// The KD-tree is up to date:
+		EXPECT_EQ(pts.kdTreeClosestPoint2D(30.01f,0.f,x,y,dist_sq),11u);
+	}
+
+	// Insertion of observations, as in a long-running mapping process:
+	CObservation2DRangeScan  obs;
+	obs.aperture = M_PIf;
+	obs.rightToLeft = true;
+	obs.scan.assign(181,5.0f);
+	obs.validRange.assign(181,1);
+
+	MAP  pts;
+	pts.insertionOptions.voxelFusionSize = 0.2f;
+	pts.insertionOptions.minDistBetweenLaserPoints = 0;
+	pts.insertObservation(&obs);
+	const size_t n1 = pts.size();
+	for (int k=0;k<20;k++)
+	{
+		const CPose3D robotPose(0.01*k,0,0,0,0,0);
+		pts.insertObservation(&obs,&robotPose);
+	}
+	EXPECT_GT(n1,10u);
+	EXPECT_LT(pts.size(),2*n1);
+}
+
+// Save and load all the fields of the points in the binary columnar and PCD formats:
+template <class MAP>
+void do_test_binaryFiles()
+{
+	MAP  pts;
+	mrpt::random::CRandomGenerator rng(1234);
+	const size_t N = 100000;  // More than one block of PCD data
+	std::vector<float> fields;
+	for (size_t i=0;i<N;i++)
+	{
+		pts.insertPoint(rng.drawUniform(-100,100),rng.drawUniform(-100,100),rng.drawUniform(-10,10));
+		pts.getPointAllFields(i,fields);
+		for (size_t k=3;k<fields.size();k++)
+			fields[k] = k==3 && fields.size()==4 ? static_cast<float>(i%7+1) : rng.drawUniform(0,1);  // weight, or RGB
+		pts.setPointAllFields(i,fields);
+	}
+
+	const std::string fil = mrpt::system::getTempFileName();
+	for (int format=0;format<4;format++)
+	{
+		switch (format)
+		{
+		case 0: ASSERT_TRUE(pts.saveBinaryColumnsFile(fil)); break;
+		case 1: ASSERT_TRUE(pts.saveBinaryColumnsFile(fil)); break;
+		case 2: ASSERT_TRUE(pts.savePCDFile(fil,true)); break;
+		case 3: ASSERT_TRUE(pts.savePCDFile(fil,false)); break;
+		};
+
+		MAP  loaded;
+		loaded.insertPoint(1,2,3);  // It must be replaced
+		float x,y,dist_sq;
+		EXPECT_EQ(loaded.kdTreeClosestPoint2D(50.f,50.f,x,y,dist_sq),0u);  // Builds the KD-tree
+		if (format<2)
+		     ASSERT_TRUE(loaded.loadBinaryColumnsFile(fil, format==0 /* mmap */));
+		else ASSERT_TRUE(loaded.loadPCDFile(fil));
+		ASSERT_EQ(loaded.size(),N);
+
+		// The KD-tree is rebuilt for the loaded points:
+		for (size_t i=0;i<N;i+=N/10)
+		{
+			float px,py,pz;
+			pts.getPoint(i,px,py,pz);
+			EXPECT_EQ(loaded.kdTreeClosestPoint2D(px,py,x,y,dist_sq),i) << "format: " << format;
+			EXPECT_EQ(dist_sq,0) << "format: " << format;
+		}
+
+		// Colors are quantized in PCD files:
+		const float tol = format<2 ? 0 : 0.5f/255+1e-6f;
+		std::vector<float> f0,f1;
+		for (size_t i=0;i<N;i++)
+		{
+			pts.getPointAllFields(i,f0);
+			loaded.getPointAllFields(i,f1);
+			ASSERT_EQ(f0.size(),f1.size());
+			for (size_t k=0;k<f0.size();k++)
+				if (k<3) { ASSERT_EQ(f0[k],f1[k]) << "format: " << format; }
+				else { ASSERT_NEAR(f0[k],f1[k],tol) << "format: " << format; }
+		}
+	}
+	mrpt::system::deleteFile(fil);
+
+	// Wrong files:
+	MAP  loaded;
+	EXPECT_FALSE(loaded.loadBinaryColumnsFile("/nonexistent/file.bin"));
+}
 
 TEST(CSimplePointsMapTests, insertPoints)
 {
@@ -189,3 +467,58 @@ TEST(CColouredPointsMapTests, clipOutOfRange)
 	do_test_clipOutOfRange<CColouredPointsMap>();
 }
 
+
+TEST(CSimplePointsMapTests, kdTreeBatchQueries)
+{
+	do_test_kdTreeBatchQueries<CSimplePointsMap>();
+}
+
+TEST(CSimplePointsMapTests, kdTreeIncrementalBuild)
+{
+	do_test_kdTreeIncrementalBuild<CSimplePointsMap>();
+}
+
+TEST(CColouredPointsMapTests, kdTreeIncrementalBuild)
+{
+	do_test_kdTreeIncrementalBuild<CColouredPointsMap>();
+}
+
+TEST(CSimplePointsMapTests, voxelDownsample)
+{
+	do_test_voxelDownsample<CSimplePointsMap>();
+}
+
+TEST(CColouredPointsMapTests, voxelDownsample)
+{
+	do_test_voxelDownsample<CColouredPointsMap>();
+}
+
+TEST(CSimplePointsMapTests, binaryFiles)
+{
+	do_test_binaryFiles<CSimplePointsMap>();
+}
+
+TEST(CWeightedPointsMapTests, binaryFiles)
+{
+	do_test_binaryFiles<CWeightedPointsMap>();
+}
+
+TEST(CColouredPointsMapTests, binaryFiles)
+{
+	do_test_binaryFiles<CColouredPointsMap>();
+}
+
+TEST(CSimplePointsMapTests, fuseWithVoxels)
+{
+	do_test_fuseWithVoxels<CSimplePointsMap>();
+}
+
+TEST(CWeightedPointsMapTests, fuseWithVoxels)
+{
+	do_test_fuseWithVoxels<CWeightedPointsMap>();
+}
+
+TEST(CColouredPointsMapTests, fuseWithVoxels)
+{
+	do_test_fuseWithVoxels<CColouredPointsMap>();
+}
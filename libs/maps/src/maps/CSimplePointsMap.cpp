@@ -51,10 +51,13 @@ void CSimplePointsMap::reserve(size_t newLength)
 //  and old contents are not changed.
 void CSimplePointsMap::resize(size_t newLength)
 {
+	const bool only_appends = newLength>=x.size();
 	x.resize( newLength, 0 );
 	y.resize( newLength, 0 );
 	z.resize( newLength, 0 );
-	mark_as_modified();
+	if (only_appends)
+	     mark_as_points_appended();
+	else mark_as_modified();
 }
 
 // Resizes all point buffers so they can hold the given number of points, *erasing* all previous contents
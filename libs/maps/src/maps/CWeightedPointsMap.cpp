@@ -67,6 +67,7 @@ void CWeightedPointsMap::setSize(size_t newLength)
 	y.assign( newLength, 0);
 	z.assign( newLength, 0);
 	pointWeight.assign( newLength, 1 );
+	mark_as_modified();
 }
 
 void  CWeightedPointsMap::setPointFast(size_t index,float x,float y,float z)
@@ -118,6 +119,15 @@ void  CWeightedPointsMap::addFrom_classSpecific(const CPointsMap &anotherMap, co
 	}
 }
 
+/*---------------------------------------------------------------
+						getPointsColumns
+ ---------------------------------------------------------------*/
+void  CWeightedPointsMap::getPointsColumns(std::vector<TPointsColumn> &cols) const
+{
+	CPointsMap::getPointsColumns(cols);
+	cols.push_back(TPointsColumn("weight",'U', pointWeight.empty() ? NULL : &pointWeight[0]));
+}
+
 /*---------------------------------------------------------------
 					writeToStream
    Implements the writing to a CStream capability of
@@ -50,11 +50,15 @@
 
 // Others:
 #include <mrpt/slam/CRawlog.h>
+#include <mrpt/slam/CIndexedRawlog.h>
+#include <mrpt/slam/CLazyRawlog.h>
+#include <mrpt/slam/CPipelinedRawlogReader.h>
 #include <mrpt/slam/carmen_log_tools.h>
 
 // Very basic classes for maps:
 #include <mrpt/slam/CMetricMap.h>
 #include <mrpt/slam/CSimpleMap.h>
+#include <mrpt/slam/CLazySimpleMap.h>
 
 
 #endif // end precomp.headers
@@ -0,0 +1,182 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CIndexedRawlog_H
+#define CIndexedRawlog_H
+
+#include <mrpt/utils/CSerializable.h>
+#include <mrpt/utils/CFileInputStream.h>
+#include <mrpt/utils/CFileOutputStream.h>
+#include <mrpt/utils/CMemoryStream.h>
+#include <mrpt/system/datetime.h>
+
+#include <mrpt/obs/link_pragmas.h>
+
+namespace mrpt
+{
+	namespace slam
+	{
+		/** The information kept in the index of an indexed rawlog file for each of its entries.
+		  * \sa CIndexedRawlogReader, CIndexedRawlogWriter
+		  * \ingroup mrpt_obs_grp
+		  */
+		struct OBS_IMPEXP TIndexedRawlogEntry
+		{
+			TIndexedRawlogEntry() : timestamp(INVALID_TIMESTAMP), sensorLabel(), className(), blockOffset(0), offsetInBlock(0) { }
+
+			/** Sets the timestamp, sensor label and class name from the object of this entry (offsets are not modified) */
+			void setFromObject(const mrpt::utils::CSerializable &obj);
+
+			mrpt::system::TTimeStamp  timestamp;     //!< The timestamp of the observation (or the first observation or action of a CSensoryFrame or CActionCollection). It may be INVALID_TIMESTAMP.
+			std::string               sensorLabel;   //!< The sensor label of the observation (empty for CSensoryFrame's and CActionCollection's)
+			std::string               className;     //!< The name of the class of the entry (e.g. "CObservation2DRangeScan")
+			uint64_t                  blockOffset;   //!< The position in the file of the compressed block with this entry
+			uint32_t                  offsetInBlock; //!< The position of the serialized object within the uncompressed block
+		};
+
+		/** Writes a seekable, indexed rawlog file. See CIndexedRawlogReader for a description of the file format.
+		  *  Entries are serialized with the usual CSerializable format into blocks of (approximately) "block_size" bytes,
+		  *  each of them compressed independently, and the index of all the entries is appended at the end of the file when it is closed.
+		  *
+		  * \code
+		  *   CIndexedRawlogWriter  f("dataset.irawlog");
+		  *   f.write(*obs1);
+		  *   f.write(*obs2);
+		  *   f.close(); // Or just let the destructor write the index
+		  * \endcode
+		  *
+		  * \sa CIndexedRawlogReader, CRawlog
+		  * \ingroup mrpt_obs_grp
+		  */
+		class OBS_IMPEXP CIndexedRawlogWriter : public mrpt::utils::CUncopiable
+		{
+		public:
+			/** Default constructor: call open() later */
+			CIndexedRawlogWriter();
+
+			/** Constructor which opens the given file \exception std::exception On error opening the file */
+			CIndexedRawlogWriter(const std::string &fileName, const size_t block_size = 1<<20);
+
+			/** Destructor: closes the file, if open, writing the index. */
+			virtual ~CIndexedRawlogWriter();
+
+			/** Creates a new file, overwriting any existing one.
+			  * \param block_size The approximate size in bytes of each compressed block (default=1MiB). Smaller blocks mean faster random accesses but a worse compression ratio.
+			  * \return false on error creating the file.
+			  */
+			bool open(const std::string &fileName, const size_t block_size = 1<<20);
+
+			/** Writes the pending block and the index of entries, and closes the file. Does nothing if it was not open. */
+			void close();
+
+			bool isOpen() { return m_file.fileOpenCorrectly(); }
+
+			/** Appends one entry (typically, a CSensoryFrame, a CActionCollection or a CObservation) to the file \exception std::exception If the file is not open */
+			void write(const mrpt::utils::CSerializable &obj);
+
+			/** \overload */
+			inline void write(const mrpt::utils::CSerializablePtr &obj) { write(*obj); }
+
+			/** The number of entries written so far */
+			size_t size() const { return m_index.size(); }
+
+		private:
+			mrpt::utils::CFileOutputStream    m_file;
+			mrpt::utils::CMemoryStream        m_block;      //!< The uncompressed contents of the block being built
+			size_t                            m_block_size;
+			std::vector<TIndexedRawlogEntry>  m_index;
+
+			void flushBlock(); //!< Compresses and writes the current block, if not empty
+		};
+
+		/** Reads a seekable, indexed rawlog file, giving random access to any entry by its index or timestamp without decompressing the preceding ones.
+		  *
+		  *  File format (all integers in little endian):
+		  *    - Header: The 8 characters "MRPT_IRL", followed by the uint32_t version number (currently 1).
+		  *    - A sequence of blocks, each one: uint32_t compressed size, uint32_t uncompressed size, the zlib-compressed data. The uncompressed data
+		  *      is a sequence of objects serialized with mrpt::utils::CStream::WriteObject(), as in a regular rawlog file.
+		  *    - The index, stored as one last block which contains: uint32_t number of entries, and for each entry: uint64_t timestamp,
+		  *      string sensor label, string class name, uint64_t block offset, uint32_t offset in the block.
+		  *    - Footer: uint64_t position of the index block, followed by the 8 characters "MRPT_IDX".
+		  *
+		  *  Use rawlog-edit --to-indexed to convert a legacy (.rawlog) file into this format. CRawlog::loadFromRawLogFile() also accepts these files.
+		  *
+		  * \note This class is not thread-safe: each thread must use its own reader.
+		  * \sa CIndexedRawlogWriter, CRawlog
+		  * \ingroup mrpt_obs_grp
+		  */
+		class OBS_IMPEXP CIndexedRawlogReader : public mrpt::utils::CUncopiable
+		{
+		public:
+			/** Default constructor: call open() later */
+			CIndexedRawlogReader();
+
+			/** Constructor which opens the given file \exception std::exception On error opening or parsing the file */
+			CIndexedRawlogReader(const std::string &fileName);
+
+			virtual ~CIndexedRawlogReader();
+
+			/** Opens an indexed rawlog file and loads its index.
+			  * \return false if the file does not exist or is not a valid indexed rawlog.
+			  */
+			bool open(const std::string &fileName);
+
+			void close();
+
+			bool isOpen() { return m_file.fileOpenCorrectly(); }
+
+			/** Returns true if the given file exists and starts with the signature of an indexed rawlog (it does not load it) */
+			static bool isIndexedRawlogFile(const std::string &fileName);
+
+			/** The number of entries in the file */
+			size_t size() const { return m_index.size(); }
+
+			/** The indexed information of the i'th entry (no bound checks) */
+			const TIndexedRawlogEntry & getEntryInfo(size_t index) const { return m_index[index]; }
+
+			/** The whole index of the file */
+			const std::vector<TIndexedRawlogEntry> & getIndex() const { return m_index; }
+
+			/** Deserializes and returns the i'th entry of the file. Only the compressed block which contains it is read from disk
+			  *  (the last decompressed block is cached, so sequential reads are efficient).
+			  * \param out_serialized_size If not NULL, it is set to the length in bytes of the serialized entry.
+			  * \exception std::exception If the index is out of bounds or on any I/O error
+			  */
+			mrpt::utils::CSerializablePtr getEntry(size_t index, size_t *out_serialized_size = NULL);
+
+			/** Returns the index of the first entry whose timestamp is equal or later than "t", or size() if there is none.
+			  *  Entries without a valid timestamp are considered to have the timestamp of the latest previous entry,
+			  *  and the file is assumed to be (approximately) sorted by time, as rawlogs usually are.
+			  */
+			size_t findEntryByTimestamp(const mrpt::system::TTimeStamp t) const;
+
+			/** Reads (without decompressing it) the block which starts at the given file offset.
+			  *  Together with decompressBlock(), this allows doing the I/O and the decompression of blocks in different threads (see CPipelinedRawlogReader).
+			  * \exception std::exception On any I/O error
+			  */
+			void readCompressedBlock(uint64_t offset, std::vector<unsigned char> &out_compressed, uint32_t &out_uncompressed_len);
+
+			/** Decompresses a block as returned by readCompressedBlock(). This method is thread-safe. \exception std::exception On corrupted data */
+			static void decompressBlock(const std::vector<unsigned char> &compressed, const uint32_t uncompressed_len, std::vector<unsigned char> &out_data);
+
+		private:
+			mrpt::utils::CFileInputStream     m_file;
+			std::vector<TIndexedRawlogEntry>  m_index;
+			std::vector<mrpt::system::TTimeStamp> m_seek_times; //!< Running maximum of the timestamps in m_index, for findEntryByTimestamp()
+
+			uint64_t                          m_cached_block_offset; //!< The file offset of the block in m_cached_block (or uint64_t(-1))
+			std::vector<unsigned char>        m_cached_block;
+			std::vector<unsigned char>        m_compressed;
+
+			void loadBlock(uint64_t offset, std::vector<unsigned char> &out_data);
+		};
+
+	} // End of namespace
+} // End of namespace
+
+#endif
@@ -0,0 +1,135 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CLazyRawlog_H
+#define CLazyRawlog_H
+
+#include <mrpt/slam/CRawlog.h>
+#include <mrpt/slam/CIndexedRawlog.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/utils/CLRUCache.h>
+
+namespace mrpt
+{
+	namespace slam
+	{
+		/** A read-only rawlog which keeps in memory only an index of its entries (class, timestamp, sensor label and file offset),
+		  *  and loads the entries from the file on demand, keeping the most recently used ones in a cache of limited size.
+		  *
+		  *  This allows working with datasets much larger than the available memory through an interface similar to that of CRawlog,
+		  *  in the same spirit than the "external storage" of mrpt::utils::CImage or CObservation3DRangeScan, but for whole entries:
+		  *  \code
+		  *    CLazyRawlog  rawlog("dataset.rawlog", 512*1024*1024);  // 512MiB of cache
+		  *    for (size_t i=0;i<rawlog.size();i++)
+		  *      if (rawlog.getType(i)==CRawlog::etObservation)
+		  *      {
+		  *         CObservationPtr obs = rawlog.getAsObservation(i);
+		  *         ...
+		  *      }
+		  *  \endcode
+		  *
+		  *  Any kind of rawlog file can be opened:
+		  *   - Indexed rawlogs (see CIndexedRawlogReader): the index is read from the file, so opening them is immediate, and any entry is loaded in O(1).
+		  *   - Legacy rawlogs, as a sequence of objects: the whole file is read once when opening it, to build the index. Then, entries are loaded
+		  *     by seeking in the file, which is fast for non-compressed files, but requires decompressing the data again for ".gz" files:
+		  *     sequential access to them is efficient, but loading an entry placed before the last one loaded (e.g. a cache miss when going backwards)
+		  *     decompresses the file again from its beginning, with a cost linear in the offset of the entry, up to the size of the whole file.
+		  *     For random access to gz-compressed datasets convert them first with "rawlog-edit --to-indexed".
+		  *
+		  *  As in CRawlog::loadFromRawLogFile(), CObservationComment objects are not entries of the rawlog, but its comment text (see getCommentText()).
+		  *  Files with a whole CRawlog object can't be read lazily.
+		  *
+		  *  The size of each entry in the cache is measured as the length of its serialized data, which is a good estimation of the memory
+		  *  it requires except for compressed data (e.g. JPEG images).
+		  *
+		  * \note Returned objects are shared with the cache: they must not be modified. This class is not thread-safe.
+		  * \sa CRawlog, CIndexedRawlogReader, CLazySimpleMap
+		  * \ingroup mrpt_obs_grp
+		  */
+		class OBS_IMPEXP CLazyRawlog : public mrpt::utils::CUncopiable
+		{
+		public:
+			/** Default constructor: call open() later.
+			  * \param cache_max_bytes The maximum size of the cache of entries (default: 256MiB)
+			  */
+			CLazyRawlog(size_t cache_max_bytes = 256*1024*1024);
+
+			/** Constructor which opens the given file \exception std::exception On error opening or indexing the file */
+			CLazyRawlog(const std::string &fileName, size_t cache_max_bytes = 256*1024*1024);
+
+			virtual ~CLazyRawlog();
+
+			/** Opens a rawlog file (indexed or legacy) and builds its index, closing the previous one.
+			  * \return false if the file does not exist.
+			  * \exception std::exception If the file contains a CRawlog object or on corrupted indexed files.
+			  */
+			bool open(const std::string &fileName);
+
+			/** Closes the file, freeing the index and the cache */
+			void close();
+
+			bool isOpen() const { return m_is_open; }
+
+			/** Returns true if the open file is an indexed rawlog, with O(1) random access to any entry */
+			bool isIndexedFile() const { return m_is_open && m_is_indexed; }
+
+			/** Returns the number of entries in the rawlog */
+			size_t size() const { return m_index.size(); }
+
+			/** The indexed information of the i'th entry (no bound checks). For legacy files, "blockOffset" is the position of the entry in the (uncompressed) file */
+			const TIndexedRawlogEntry & getEntryInfo(size_t index) const { return m_index[index]; }
+
+			/** Returns the type of the i'th entry, without loading it \exception std::exception If index is out of bounds */
+			CRawlog::TEntryType getType(size_t index) const;
+
+			/** Returns the i'th entry, loading it if it is not in the cache \exception std::exception If index is out of bounds or on any I/O error */
+			mrpt::utils::CSerializablePtr getAsGeneric(size_t index);
+
+			/** Returns the i'th entry, which must be a CActionCollection \exception std::exception If index is out of bounds or the entry is of other class */
+			CActionCollectionPtr getAsAction(size_t index);
+
+			/** Returns the i'th entry, which must be a CSensoryFrame \exception std::exception If index is out of bounds or the entry is of other class */
+			CSensoryFramePtr getAsObservations(size_t index);
+
+			/** Returns the i'th entry, which must be a CObservation \exception std::exception If index is out of bounds or the entry is of other class */
+			CObservationPtr getAsObservation(size_t index);
+
+			/** Returns the index of the first entry whose timestamp is equal or later than "t", or size() if there is none.
+			  *  Entries without a valid timestamp are considered to have the timestamp of the latest previous entry.
+			  */
+			size_t findEntryByTimestamp(const mrpt::system::TTimeStamp t) const;
+
+			/** Returns the comment text of the rawlog, if any */
+			std::string getCommentText() const { return m_commentTexts.text; }
+
+			/** Changes the maximum size in bytes of the cache of entries, discarding the least recently used ones if needed */
+			void setCacheMaxBytes(size_t max_bytes) { m_cache.setMaxBytes(max_bytes); }
+
+			/** The cache of entries (e.g. to get its statistics or its current size) */
+			const mrpt::utils::CLRUCache<size_t,mrpt::utils::CSerializablePtr> & getCache() const { return m_cache; }
+
+		private:
+			bool                               m_is_open;
+			bool                               m_is_indexed;
+			CIndexedRawlogReader               m_indexed_file;   //!< Used for indexed files
+			mrpt::utils::CFileGZInputStream    m_legacy_file;    //!< Used for legacy files
+			std::vector<TIndexedRawlogEntry>   m_index;
+			std::vector<size_t>                m_src_indexed;    //!< For indexed files, the index in the file of each of our entries (without comments)
+			std::vector<size_t>                m_legacy_sizes;   //!< For legacy files, the serialized size of each entry
+			std::vector<mrpt::system::TTimeStamp> m_seek_times;  //!< Running maximum of the timestamps in m_index, for findEntryByTimestamp()
+			CObservationComment                m_commentTexts;
+			mrpt::utils::CLRUCache<size_t,mrpt::utils::CSerializablePtr>  m_cache;
+
+			void indexLegacyFile();
+			void buildSeekTimes();
+		};
+
+	} // End of namespace
+} // End of namespace
+
+#endif
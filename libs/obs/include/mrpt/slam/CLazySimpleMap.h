@@ -0,0 +1,99 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CLazySimpleMap_H
+#define CLazySimpleMap_H
+
+#include <mrpt/slam/CSimpleMap.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/utils/CLRUCache.h>
+
+namespace mrpt
+{
+	namespace slam
+	{
+		/** A read-only view of a ".simplemap" file (see CSimpleMap) which keeps in memory only the pose PDFs of the keyframes and an index
+		  *  of their sensory frames (timestamp and file offset), and loads the sensory frames on demand, keeping the most recently used ones in a cache of limited size.
+		  *
+		  *  The whole file is read once when opening it, to build the index. Then, sensory frames are loaded by seeking in the file,
+		  *  which is fast for non-compressed files, but requires decompressing the data again for gz-compressed ones (the default of CSimpleMap::saveToFile()):
+		  *  loading a sensory frame placed before the last one loaded decompresses the file again from its beginning, with a cost linear in its offset,
+		  *  up to the size of the whole file. Hence, for random access to large maps they had better be saved without compression.
+		  *
+		  *  The size of each sensory frame in the cache is measured as the length of its serialized data.
+		  *
+		  * \note Returned objects are shared with the cache: they must not be modified. This class is not thread-safe.
+		  * \sa CSimpleMap, CLazyRawlog
+		  * \ingroup mrpt_obs_grp
+		  */
+		class OBS_IMPEXP CLazySimpleMap : public mrpt::utils::CUncopiable
+		{
+		public:
+			/** The information kept in memory for each keyframe of the map */
+			struct OBS_IMPEXP TEntryInfo
+			{
+				TEntryInfo() : posePDF(), timestamp(INVALID_TIMESTAMP), fileOffset(0), serializedSize(0) { }
+
+				CPose3DPDFPtr             posePDF;        //!< The pose of the keyframe
+				mrpt::system::TTimeStamp  timestamp;      //!< The timestamp of the first observation in the sensory frame (may be INVALID_TIMESTAMP)
+				uint64_t                  fileOffset;     //!< The position in the (uncompressed) file of the sensory frame
+				size_t                    serializedSize; //!< The length of the serialized sensory frame
+			};
+
+			/** Default constructor: call open() later.
+			  * \param cache_max_bytes The maximum size of the cache of sensory frames (default: 256MiB)
+			  */
+			CLazySimpleMap(size_t cache_max_bytes = 256*1024*1024);
+
+			/** Constructor which opens the given file \exception std::exception On error opening or parsing the file */
+			CLazySimpleMap(const std::string &fileName, size_t cache_max_bytes = 256*1024*1024);
+
+			virtual ~CLazySimpleMap();
+
+			/** Opens a ".simplemap" file (gz-compressed or not) and builds its index, closing the previous one.
+			  * \return false if the file does not exist.
+			  * \exception std::exception If the file does not contain a CSimpleMap or it is corrupted.
+			  */
+			bool open(const std::string &fileName);
+
+			/** Closes the file, freeing the index and the cache */
+			void close();
+
+			bool isOpen() const { return m_is_open; }
+
+			/** Returns the number of (pose,sensory frame) pairs */
+			size_t size() const { return m_index.size(); }
+
+			/** The information of the i'th keyframe (no bound checks) */
+			const TEntryInfo & getEntryInfo(size_t index) const { return m_index[index]; }
+
+			/** Returns the sensory frame of the i'th keyframe, loading it if it is not in the cache \exception std::exception If index is out of bounds or on any I/O error */
+			CSensoryFramePtr getSensoryFrame(size_t index);
+
+			/** Returns the i'th pair of pose PDF and sensory frame, as CSimpleMap::get() \exception std::exception If index is out of bounds or on any I/O error */
+			void get(size_t index, CPose3DPDFPtr &out_posePDF, CSensoryFramePtr &out_SF);
+
+			/** Changes the maximum size in bytes of the cache of sensory frames, discarding the least recently used ones if needed */
+			void setCacheMaxBytes(size_t max_bytes) { m_cache.setMaxBytes(max_bytes); }
+
+			/** The cache of sensory frames (e.g. to get its statistics or its current size) */
+			const mrpt::utils::CLRUCache<size_t,CSensoryFramePtr> & getCache() const { return m_cache; }
+
+		private:
+			bool                              m_is_open;
+			mrpt::utils::CFileGZInputStream   m_file;
+			std::vector<TEntryInfo>           m_index;
+			mrpt::utils::CLRUCache<size_t,CSensoryFramePtr>  m_cache;
+
+			void indexFile();
+		};
+
+	} // End of namespace
+} // End of namespace
+
+#endif
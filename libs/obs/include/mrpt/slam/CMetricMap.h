@@ -191,6 +191,21 @@ namespace mrpt
 				return computeObservationLikelihood(obs,CPose3D(takenFrom));
 			}
 
+			/** Computes the log-likelihood of a given observation for a whole set of robot poses at once (e.g. all the particles of a particle filter).
+			 *  The default implementation just calls computeObservationLikelihood() for each pose. Derived classes
+			 *  may redefine it to evaluate the poses in parallel (see COccupancyGridMap2D).
+			 *
+			 * \param obs The observation.
+			 * \param takenFrom The robot poses the observation is supposed to be taken from.
+			 * \param out_log_liks On return, the log-likelihood for each pose in \a takenFrom.
+			 *
+			 * \sa computeObservationLikelihood, Used in CMonteCarloLocalization2D
+			 */
+			virtual void computeObservationLikelihoodForPoses(
+				const CObservation           *obs,
+				const std::vector<mrpt::math::TPose3D>   &takenFrom,
+				vector_double                &out_log_liks );
+
 			/** Returns true if this map is able to compute a sensible likelihood function for this observation (i.e. an occupancy grid map cannot with an image).
 			 * \param obs The observation.
 			 * \sa computeObservationLikelihood
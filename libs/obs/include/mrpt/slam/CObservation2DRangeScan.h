@@ -78,6 +78,11 @@ namespace slam
 		  */
 		std::vector<char>	validRange;
 
+		/** Resizes both \a scan and \a validRange to "len" elements, as their resize() methods do, but recycling the memory of previous (destroyed) scans
+		  *  if they are empty (see mrpt::system::CVectorMemoryPool). Sensor drivers and deserialization use it, to avoid allocating new memory for each scan.
+		  */
+		void resizeScan(const size_t len);
+
 		/** The aperture of the range finder, in radians (typically M_PI = 180 degrees).
 		  */
 		float				aperture;
@@ -25,10 +25,31 @@ namespace slam
 {
 	DEFINE_SERIALIZABLE_PRE_CUSTOM_BASE_LINKAGE( CObservation3DRangeScan, CObservation,OBS_IMPEXP )
 
+	/** Options for CObservation3DRangeScan::project3DPointsFromDepthImageInto()
+	  * \ingroup mrpt_obs_grp
+	  */
+	struct OBS_IMPEXP T3DPointsProjectionParams
+	{
+		/** (Default:false) If true, the points are transformed with the \a sensorPose of the observation. Furthermore, if provided, they are transformed with \a robotPoseInTheWorld. */
+		bool                         takeIntoAccountSensorPoseOnRobot;
+		const mrpt::poses::CPose3D * robotPoseInTheWorld; //!< (Default:NULL) The robot pose to transform the points with, if not NULL
+		bool                         PROJ3D_USE_LUT;      //!< (Default:true) Ignored, kept for backwards compatibility: the directions of the camera rays are computed in each call, see CObservation3DRangeScan::project3DPointsFromDepthImageInto()
+		unsigned int                 decimation;          //!< (Default:1) Only one out of each "decimation" rows and columns of the range image is projected.
+		/** (Default:0,0 = no clipping) If any of them is >0, pixels with a range (or depth, if range_is_depth) of zero or out of [minRange,maxRange] are not projected
+		  *  (a maxRange of 0 means no upper limit), so there will be less points than pixels. */
+		float                        minRange, maxRange;
+		bool                         parallelize;         //!< (Default:true) Project the rows of the range image in parallel, with mrpt::system::parallel_for()
+
+		T3DPointsProjectionParams() :
+			takeIntoAccountSensorPoseOnRobot(false), robotPoseInTheWorld(NULL), PROJ3D_USE_LUT(true),
+			decimation(1), minRange(0), maxRange(0), parallelize(true)
+		{}
+	};
+
 	namespace detail {
 		// Implemented in CObservation3DRangeScan_project3D_impl.h
 		template <class POINTMAP>
-		void project3DPointsFromDepthImageInto(CObservation3DRangeScan    & src_obs,POINTMAP                   & dest_pointcloud,const bool                   takeIntoAccountSensorPoseOnRobot,const mrpt::poses::CPose3D * robotPoseInTheWorld,const bool                   PROJ3D_USE_LUT);
+		void project3DPointsFromDepthImageInto(CObservation3DRangeScan    & src_obs,POINTMAP                   & dest_pointcloud,const T3DPointsProjectionParams & projectParams);
 	}
 
 	/** Declares a class derived from "CObservation" that
@@ -155,7 +176,10 @@ namespace slam
 		  *  By default the local coordinates of points are directly stored into the local map, but if indicated so in \a takeIntoAccountSensorPoseOnRobot
 		  *  the points are transformed with \a sensorPose. Furthermore, if provided, those coordinates are transformed with \a robotPoseInTheWorld
 		  *
-		  * \param[in] PROJ3D_USE_LUT (Only when range_is_depth=true) Whether to use a Look-up-table (LUT) to speed up the conversion. It's thread safe in all situations <b>except</b> when you call this method from different threads <b>and</b> with different camera parameter matrices. In all other cases, it's a good idea to left it enabled.
+		  *  The rows of the range image are projected in parallel, 4 pixels at a time with SSE2 (if available), and the points are written straight into the arrays of
+		  *  the destination if it's a mrpt::slam::CPointsMap or a CObservation3DRangeScan. See T3DPointsProjectionParams for decimating the image and clipping ranges in the same pass.
+		  *
+		  * \param[in] PROJ3D_USE_LUT Ignored, kept for backwards compatibility. The direction of the rays of each column and row are computed in each call (just W+H values), so this method is thread safe in all situations.
 		  * \tparam POINTMAP Supported maps are all those covered by mrpt::utils::PointCloudAdapter (mrpt::slam::CPointsMap and derived, mrpt::opengl::CPointCloudColoured, PCL point clouds,...)
 		  *
 		  * \note In MRPT < 0.9.5, this method always assumes that ranges were in Kinect-like format.
@@ -167,7 +191,20 @@ namespace slam
 			const mrpt::poses::CPose3D *robotPoseInTheWorld=NULL,
 			const bool PROJ3D_USE_LUT=true)
 		{
-			detail::project3DPointsFromDepthImageInto<POINTMAP>(*this,dest_pointcloud,takeIntoAccountSensorPoseOnRobot,robotPoseInTheWorld,PROJ3D_USE_LUT);
+			T3DPointsProjectionParams pp;
+			pp.takeIntoAccountSensorPoseOnRobot = takeIntoAccountSensorPoseOnRobot;
+			pp.robotPoseInTheWorld = robotPoseInTheWorld;
+			pp.PROJ3D_USE_LUT = PROJ3D_USE_LUT;
+			detail::project3DPointsFromDepthImageInto<POINTMAP>(*this,dest_pointcloud,pp);
+		}
+
+		/** \overload With all the options in a T3DPointsProjectionParams structure (e.g. decimation and range clipping) */
+		template <class POINTMAP>
+		inline void project3DPointsFromDepthImageInto(
+			POINTMAP                   & dest_pointcloud,
+			const T3DPointsProjectionParams & projectParams)
+		{
+			detail::project3DPointsFromDepthImageInto<POINTMAP>(*this,dest_pointcloud,projectParams);
 		}
 
 		/** This method is equivalent to \c project3DPointsFromDepthImageInto() storing the projected 3D points (without color, in local coordinates) in this same class.
@@ -313,7 +350,8 @@ namespace slam
 			mrpt::utils::TCamera			&out_camParams,
 			const double camera_offset = 0.01 );
 
-		/** Look-up-table struct for project3DPointsFromDepthImageInto() */
+		/** Look-up-table struct with the direction of the rays, as (r_cx - c)/r_fx for each column (Kys) and (r_cy - r)/r_fy for each row (Kzs).
+		  *  Not used anymore by project3DPointsFromDepthImageInto(), which computes them in each call. */
 		struct TCached3DProjTables
 		{
 			mrpt::vector_float Kzs,Kys;
@@ -11,18 +11,51 @@
 
 namespace mrpt {
 namespace slam {
+	/** Hook used by CObservation3DRangeScan::project3DPointsFromDepthImageInto() for point clouds stored as separate X,Y,Z arrays:
+	  *  it must resize the cloud to N points (keeping the first ones if it shrinks) and return pointers to its arrays, so the points are written straight into them.
+	  *  This generic version returns false, so points are set one by one through mrpt::utils::PointCloudAdapter. It's overloaded for CObservation3DRangeScan below
+	  *  and for mrpt::slam::CPointsMap in mrpt-maps (found by argument-dependent lookup).
+	  */
+	inline bool getPointCloudXYZBuffers(void * /*pointcloud*/, const size_t /*N*/, float *& /*xs*/, float *& /*ys*/, float *& /*zs*/) { return false; }
+
+	/** \overload For CObservation3DRangeScan::points3D_x, points3D_y, points3D_z */
+	inline bool getPointCloudXYZBuffers(CObservation3DRangeScan *obs, const size_t N, float *&xs, float *&ys, float *&zs)
+	{
+		// Only grow through resizePoints3DVectors(), since it may swap the vectors with others from the memory pool:
+		if (N>obs->points3D_x.size())
+			obs->resizePoints3DVectors(N);
+		else
+		{
+			obs->points3D_x.resize(N);
+			obs->points3D_y.resize(N);
+			obs->points3D_z.resize(N);
+		}
+		xs = N ? &obs->points3D_x[0] : NULL;
+		ys = N ? &obs->points3D_y[0] : NULL;
+		zs = N ? &obs->points3D_z[0] : NULL;
+		return true;
+	}
+
 namespace detail {
-	// Auxiliary functions which implement SSE-optimized proyection of 3D point cloud:
-	template <class POINTMAP> void do_project_3d_pointcloud(const int H,const int W,const float *kys,const float *kzs,const mrpt::math::CMatrix &rangeImage, mrpt::utils::PointCloudAdapter<POINTMAP> &pca);
-	template <class POINTMAP> void do_project_3d_pointcloud_SSE2(const int H,const int W,const float *kys,const float *kzs,const mrpt::math::CMatrix &rangeImage, mrpt::utils::PointCloudAdapter<POINTMAP> &pca);
+	/** Projects the range image of \a src_obs into the arrays xs,ys,zs, which must have room for all the pixels after decimation.
+	  *  Rows are projected in parallel (if projectParams.parallelize), 4 pixels at a time with SSE2 (if available and there is no decimation).
+	  * \param[in] HM If not NULL, a 3x4 homogeneous transformation (row-major) applied to the points in the same pass.
+	  * \param[out] out_pixel_idxs If not NULL, it's filled with the index (row*width+column) of the pixel of each point.
+	  * \return The number of points, which may be less than pixels if ranges are clipped.
+	  * \note Implemented in CObservation3DRangeScan_project3D.cpp
+	  */
+	size_t OBS_IMPEXP projectRangeImageToXYZ(
+		CObservation3DRangeScan &src_obs, const T3DPointsProjectionParams &projectParams, const float *HM,
+		float *xs, float *ys, float *zs, std::vector<uint32_t> *out_pixel_idxs);
+
+	/** Applies a 3x4 homogeneous transformation (row-major) to N points, in parallel \note Implemented in CObservation3DRangeScan_project3D.cpp */
+	void OBS_IMPEXP transformPointsXYZ(const float *HM, float *xs, float *ys, float *zs, const size_t N);
 
 	template <class POINTMAP>
 	void project3DPointsFromDepthImageInto(
 			CObservation3DRangeScan    & src_obs,
 			POINTMAP                   & dest_pointcloud,
-			const bool                   takeIntoAccountSensorPoseOnRobot,
-			const mrpt::poses::CPose3D * robotPoseInTheWorld,
-			const bool                   PROJ3D_USE_LUT)
+			const T3DPointsProjectionParams & projectParams)
 	{
 		using namespace mrpt::math;
 
@@ -30,113 +63,70 @@ namespace detail {
 
 		mrpt::utils::PointCloudAdapter<POINTMAP> pca(dest_pointcloud);
 
-		// ------------------------------------------------------------
-		// Stage 1/3: Create 3D point cloud local coordinates
-		// ------------------------------------------------------------
 		const int W = src_obs.rangeImage.cols();
 		const int H = src_obs.rangeImage.rows();
-		const size_t WH = W*H;
-
-		// Reserve memory for 3D points:
-		pca.resize(WH);
-
-		if (src_obs.range_is_depth)
+		const unsigned int decim = std::max(1u,projectParams.decimation);
+		const size_t maxPoints = size_t((W+decim-1)/decim) * size_t((H+decim-1)/decim);
+
+		// Colors are taken from the intensity image, if the destination has colors:
+		const bool fillColors = mrpt::utils::PointCloudAdapter<POINTMAP>::HAS_RGB && src_obs.hasIntensityImage;
+		// Unless we are in a special case (both depth & RGB images coincide), colors require the points in local coordinates:
+		const bool isDirectCorresp = fillColors && src_obs.doDepthAndIntensityCamerasCoincide();
+
+		// The 6D transformation to apply, if any:
+		float HM[12];
+		const bool transformPoints = projectParams.takeIntoAccountSensorPoseOnRobot || projectParams.robotPoseInTheWorld;
+		if (transformPoints)
 		{
-			// range_is_depth = true
+			mrpt::poses::CPose3D  transf_to_apply; // Either ROBOTPOSE or ROBOTPOSE(+)SENSORPOSE or SENSORPOSE
+			if (projectParams.takeIntoAccountSensorPoseOnRobot)
+				transf_to_apply = src_obs.sensorPose;
+			if (projectParams.robotPoseInTheWorld)
+				transf_to_apply.composeFrom(*projectParams.robotPoseInTheWorld, mrpt::poses::CPose3D(transf_to_apply));
 
-			// Use cached tables?
-			if (PROJ3D_USE_LUT)
-			{
-				// Use LUT:
-				if (src_obs.m_3dproj_lut.prev_camParams!=src_obs.cameraParams || WH!=size_t(src_obs.m_3dproj_lut.Kys.size()))
-				{
-					src_obs.m_3dproj_lut.prev_camParams = src_obs.cameraParams;
-					src_obs.m_3dproj_lut.Kys.resize(WH);
-					src_obs.m_3dproj_lut.Kzs.resize(WH);
+			const CMatrixDouble44 HMd = transf_to_apply.getHomogeneousMatrixVal();
+			for (int i=0;i<3;i++)
+				for (int j=0;j<4;j++)
+					HM[4*i+j] = static_cast<float>(HMd(i,j));
+		}
+		const bool transformInKernel = transformPoints && (!fillColors || isDirectCorresp);
 
-					const float r_cx = src_obs.cameraParams.cx();
-					const float r_cy = src_obs.cameraParams.cy();
-					const float r_fx_inv = 1.0f/src_obs.cameraParams.fx();
-					const float r_fy_inv = 1.0f/src_obs.cameraParams.fy();
+		// ------------------------------------------------------------
+		// Stage 1/3: Create 3D point cloud (in local coordinates, unless transformInKernel)
+		// ------------------------------------------------------------
+		// Write straight into the destination, if possible, or through buffers otherwise:
+		float *xs, *ys, *zs;
+		std::vector<float> buf_x, buf_y, buf_z;
+		const bool directWrite = getPointCloudXYZBuffers(&dest_pointcloud, maxPoints, xs,ys,zs);
+		if (!directWrite)
+		{
+			buf_x.resize(maxPoints); buf_y.resize(maxPoints); buf_z.resize(maxPoints);
+			xs = maxPoints ? &buf_x[0] : NULL;
+			ys = maxPoints ? &buf_y[0] : NULL;
+			zs = maxPoints ? &buf_z[0] : NULL;
+		}
 
-					float *kys = &src_obs.m_3dproj_lut.Kys[0];
-					float *kzs = &src_obs.m_3dproj_lut.Kzs[0];
-					for (int r=0;r<H;r++)
-						for (int c=0;c<W;c++)
-						{
-							*kys++ = (r_cx - c) * r_fx_inv;
-							*kzs++ = (r_cy - r) * r_fy_inv;
-						}
-				} // end update LUT.
+		// Pixel of each point, only needed for colors if not all the pixels become points in order:
+		std::vector<uint32_t> pixel_idxs;
+		const bool clipRanges = projectParams.minRange>0 || projectParams.maxRange>0;
+		const bool needPixelIdxs = fillColors && (decim>1 || clipRanges);
 
-				ASSERT_EQUAL_(WH,size_t(src_obs.m_3dproj_lut.Kys.size()))
-				ASSERT_EQUAL_(WH,size_t(src_obs.m_3dproj_lut.Kzs.size()))
-				float *kys = &src_obs.m_3dproj_lut.Kys[0];
-				float *kzs = &src_obs.m_3dproj_lut.Kzs[0];
+		const size_t N = projectRangeImageToXYZ(src_obs, projectParams, transformInKernel ? HM : NULL, xs,ys,zs, needPixelIdxs ? &pixel_idxs : NULL);
 
-	#if MRPT_HAS_SSE2
-				if ((W & 0x07)==0)
-						do_project_3d_pointcloud_SSE2(H,W,kys,kzs,src_obs.rangeImage,pca);
-				else	do_project_3d_pointcloud(H,W,kys,kzs,src_obs.rangeImage,pca);  // if image width is not 8*N, use standard method
-	#else
-				do_project_3d_pointcloud(H,W,kys,kzs,src_obs.rangeImage,pca);
-	#endif
-			}
-			else
-			{
-				// Without LUT:
-				const float r_cx =  src_obs.cameraParams.cx();
-				const float r_cy = src_obs.cameraParams.cy();
-				const float r_fx_inv = 1.0f/src_obs.cameraParams.fx();
-				const float r_fy_inv = 1.0f/src_obs.cameraParams.fy();
-				size_t idx=0;
-				for (int r=0;r<H;r++)
-					for (int c=0;c<W;c++)
-					{
-						const float Kz = (r_cy - r) * r_fy_inv;
-						const float Ky = (r_cx - c) * r_fx_inv;
-						const float D = src_obs.rangeImage.coeff(r,c);
-						pca.setPointXYZ(idx++,
-							D,        // x
-							Ky * D,   // y
-							Kz * D    // z
-							);
-					}
-			}
+		if (directWrite)
+		{
+			if (N!=maxPoints)
+				getPointCloudXYZBuffers(&dest_pointcloud, N, xs,ys,zs);
 		}
 		else
 		{
-			/* range_is_depth = false :
-			  *   Ky = (r_cx - c)/r_fx
-			  *   Kz = (r_cy - r)/r_fy
-			  *
-			  *   x(i) = rangeImage(r,c) / sqrt( 1 + Ky^2 + Kz^2 )
-			  *   y(i) = Ky * x(i)
-			  *   z(i) = Kz * x(i)
-			  */
-			const float r_cx = src_obs.cameraParams.cx();
-			const float r_cy = src_obs.cameraParams.cy();
-			const float r_fx_inv = 1.0f/src_obs.cameraParams.fx();
-			const float r_fy_inv = 1.0f/src_obs.cameraParams.fy();
-			size_t idx=0;
-			for (int r=0;r<H;r++)
-				for (int c=0;c<W;c++)
-				{
-					const float Ky = (r_cx - c) * r_fx_inv;
-					const float Kz = (r_cy - r) * r_fy_inv;
-					const float D = src_obs.rangeImage.coeff(r,c);
-					pca.setPointXYZ(idx++,
-						D / std::sqrt(1+Ky*Ky+Kz*Kz), // x
-						Ky * D,   // y
-						Kz * D    // z
-						);
-				}
+			pca.resize(N);
 		}
 
 		// -------------------------------------------------------------
 		// Stage 2/3: Project local points into RGB image to get colors
 		// -------------------------------------------------------------
-		if (src_obs.hasIntensityImage)
+		if (fillColors)
 		{
 			const int imgW = src_obs.intensityImage.getWidth();
 			const int imgH = src_obs.intensityImage.getHeight();
@@ -147,9 +137,6 @@ namespace detail {
 			const float fx = src_obs.cameraParamsIntensity.fx();
 			const float fy = src_obs.cameraParamsIntensity.fy();
 
-			// Unless we are in a special case (both depth & RGB images coincide)...
-			const bool isDirectCorresp = src_obs.doDepthAndIntensityCamerasCoincide();
-
 			// ...precompute the inverse of the pose transformation out of the loop,
 			//  store as a 4x4 homogeneous matrix to exploit SSE optimizations below:
 			CMatrixFixedNumeric<float,4,4> T_inv;
@@ -173,22 +160,20 @@ namespace detail {
 			mrpt::utils::TColor pCol;
 
 			// For each local point:
-			for (size_t i=0;i<WH;i++)
+			for (size_t i=0;i<N;i++)
 			{
 				bool pointWithinImage = false;
 				if (isDirectCorresp)
 				{
-					pointWithinImage=true;
-					img_idx_x++;
-					if (img_idx_x>=imgW) {
-						img_idx_x=0;
-						img_idx_y++;
-					}
+					const size_t pixel = needPixelIdxs ? pixel_idxs[i] : i;
+					img_idx_x = static_cast<int>(pixel % W);
+					img_idx_y = static_cast<int>(pixel / W);
+					pointWithinImage = img_idx_x<imgW && img_idx_y<imgH;
 				}
 				else
 				{
-					// Project point, which is now in "pca" in local coordinates wrt the depth camera, into the intensity camera:
-					pca.getPointXYZ(i,pt_wrt_depth[0],pt_wrt_depth[1],pt_wrt_depth[2]);
+					// Project point, which is now in local coordinates wrt the depth camera, into the intensity camera:
+					pt_wrt_depth[0]=xs[i]; pt_wrt_depth[1]=ys[i]; pt_wrt_depth[2]=zs[i];
 					pt_wrt_color.noalias() = T_inv*pt_wrt_depth;
 
 					// Project to image plane:
@@ -223,86 +208,19 @@ namespace detail {
 			} // end for each point
 		} // end if src_obs has intensity image
 
-		// ...
-
 		// ------------------------------------------------------------
-		// Stage 3/3: Apply 6D transformations
+		// Stage 3/3: Apply 6D transformations (if not done already)
 		// ------------------------------------------------------------
-		if (takeIntoAccountSensorPoseOnRobot || robotPoseInTheWorld)
-		{
-			mrpt::poses::CPose3D  transf_to_apply; // Either ROBOTPOSE or ROBOTPOSE(+)SENSORPOSE or SENSORPOSE
-			if (takeIntoAccountSensorPoseOnRobot)
-				transf_to_apply = src_obs.sensorPose;
-			if (robotPoseInTheWorld)
-				transf_to_apply.composeFrom(*robotPoseInTheWorld, CPose3D(transf_to_apply));
+		if (transformPoints && !transformInKernel)
+			transformPointsXYZ(HM, xs,ys,zs, N);
 
-			const CMatrixFixedNumeric<float,4,4> HM = transf_to_apply.getHomogeneousMatrixVal().cast<float>();
-			Eigen::Matrix<float,4,1>  pt, pt_transf;
-			pt[3]=1;
+		// Copy the points to point clouds with other memory layouts:
+		if (!directWrite)
+			for (size_t i=0;i<N;i++)
+				pca.setPointXYZ(i,xs[i],ys[i],zs[i]);
 
-			for (size_t i=0;i<WH;i++)
-			{
-				pca.getPointXYZ(i,pt[0],pt[1],pt[2]);
-				pt_transf.noalias() = HM*pt;
-				pca.setPointXYZ(i,pt_transf[0],pt_transf[1],pt_transf[2]);
-			}
-		}
 	} // end of project3DPointsFromDepthImageInto
 
-	// Auxiliary functions which implement proyection of 3D point clouds:
-	template <class POINTMAP>
-	inline void do_project_3d_pointcloud(const int H,const int W,const float *kys,const float *kzs,const mrpt::math::CMatrix &rangeImage, mrpt::utils::PointCloudAdapter<POINTMAP> &pca)
-	{
-		size_t idx=0;
-		for (int r=0;r<H;r++)
-			for (int c=0;c<W;c++)
-			{
-				const float D = rangeImage.coeff(r,c);
-				pca.setPointXYZ(idx++,
-					D,          // x
-					*kys++ * D, // y
-					*kzs++ * D  // z
-					);
-			}
-	}
-
-	// Auxiliary functions which implement proyection of 3D point clouds:
-	template <class POINTMAP>
-	inline void do_project_3d_pointcloud_SSE2(const int H,const int W,const float *kys,const float *kzs,const mrpt::math::CMatrix &rangeImage, mrpt::utils::PointCloudAdapter<POINTMAP> &pca)
-	{
-	#if MRPT_HAS_SSE2
-			// Use optimized version:
-			const int W_4 = W >> 2;  // /=4 , since we process 4 values at a time.
-			size_t idx=0;
-			EIGEN_ALIGN16 float xs[4],ys[4],zs[4];
-			for (int r=0;r<H;r++)
-			{
-				const float *D_ptr = &rangeImage.coeffRef(r,0);  // Matrices are 16-aligned
-
-				for (int c=0;c<W_4;c++)
-				{
-					const __m128 D = _mm_load_ps(D_ptr);
-
-					const __m128 KY = _mm_load_ps(kys);
-					const __m128 KZ = _mm_load_ps(kzs);
-
-					_mm_storeu_ps(xs , D);
-					_mm_storeu_ps(ys , _mm_mul_ps(KY,D));
-					_mm_storeu_ps(zs , _mm_mul_ps(KZ,D));
-
-					D_ptr+=4;
-					kys+=4;
-					kzs+=4;
-					pca.setPointXYZ(idx++,xs[0],ys[0],zs[0]);
-					pca.setPointXYZ(idx++,xs[1],ys[1],zs[1]);
-					pca.setPointXYZ(idx++,xs[2],ys[2],zs[2]);
-					pca.setPointXYZ(idx++,xs[3],ys[3],zs[3]);
-				}
-			}
-	#endif
-	}
-
-
 } // End of namespace
 } // End of namespace
 } // End of namespace
@@ -0,0 +1,126 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+#ifndef CPipelinedRawlogReader_H
+#define CPipelinedRawlogReader_H
+
+#include <mrpt/utils/CSerializable.h>
+#include <mrpt/utils/CStream.h>
+#include <mrpt/slam/CActionCollection.h>
+#include <mrpt/slam/CSensoryFrame.h>
+#include <mrpt/slam/CObservation.h>
+
+#include <mrpt/obs/link_pragmas.h>
+
+namespace mrpt
+{
+	namespace slam
+	{
+		/** Reads the objects of a rawlog file sequentially, decoding them in background threads while the user processes the previous ones.
+		  *
+		  *  The decoding is split into stages, connected by bounded queues so that at most TOptions::max_pending blocks (or objects) are
+		  *  kept in memory ahead of the consumer:
+		  *    - Indexed rawlog files (see CIndexedRawlogReader): one thread reads the compressed blocks from disk, TOptions::num_threads threads
+		  *      decompress them and other TOptions::num_threads threads deserialize the objects of each block. Objects are then delivered
+		  *      to the user in file order, or as soon as each block is ready if TOptions::ordered is false.
+		  *    - Legacy (.rawlog, optionally gz-compressed) files: since object boundaries are unknown until they are deserialized, one thread
+		  *      reads and decompresses the file in chunks of TOptions::chunk_size bytes, and another one deserializes the objects from them.
+		  *
+		  *  Typical usage, as a replacement of CRawlog::getActionObservationPairOrObservation() over a CFileGZInputStream:
+		  * \code
+		  *   CPipelinedRawlogReader  rawlog("dataset.rawlog");
+		  *   CActionCollectionPtr action;
+		  *   CSensoryFramePtr observations;
+		  *   CObservationPtr observation;
+		  *   size_t rawlogEntry = 0;
+		  *   while (rawlog.getActionObservationPairOrObservation(action,observations,observation,rawlogEntry))
+		  *   {
+		  *      ...
+		  *   }
+		  * \endcode
+		  *
+		  *  getNextObject() is thread-safe. With TOptions::ordered=false, several threads may share one reader to process its objects in parallel.
+		  *
+		  * \sa CRawlog, CIndexedRawlogReader
+		  * \ingroup mrpt_obs_grp
+		  */
+		class OBS_IMPEXP CPipelinedRawlogReader : public mrpt::utils::CUncopiable
+		{
+		public:
+			/** Options of the decoding pipeline */
+			struct OBS_IMPEXP TOptions
+			{
+				TOptions();
+
+				unsigned int num_threads;  //!< Number of threads in each of the decompression and deserialization stages of indexed rawlogs. 0 (default) means mrpt::system::getParallelizationThreadsCount().
+				size_t       max_pending;  //!< Max. number of blocks (indexed rawlogs) or objects (legacy rawlogs) decoded ahead of the consumer (default=16)
+				size_t       chunk_size;   //!< Size of the chunks in which legacy rawlogs are read and decompressed (default=1MiB)
+				bool         ordered;      //!< If false, blocks of indexed rawlogs are delivered as soon as they are decoded, not in file order (default=true)
+			};
+
+			/** Default constructor: call open() later */
+			CPipelinedRawlogReader();
+
+			/** Constructor which opens the given file \exception std::exception On error opening the file */
+			CPipelinedRawlogReader(const std::string &fileName, const TOptions &options = TOptions());
+
+			/** Destructor: stops all the threads */
+			virtual ~CPipelinedRawlogReader();
+
+			/** Opens a rawlog file, either indexed or legacy, and starts decoding it in the background.
+			  * \return false on error opening the file.
+			  */
+			bool open(const std::string &fileName, const TOptions &options = TOptions());
+
+			/** Starts decoding the objects from an already opened (legacy rawlog) stream, e.g. a CFileGZInputStream.
+			  *  The stream must be kept alive, and must not be accessed by the user, until close() or the destructor is called.
+			  */
+			void open(mrpt::utils::CStream &in, const TOptions &options = TOptions());
+
+			/** Stops all the threads and closes the file. Does nothing if it was not open. */
+			void close();
+
+			bool isOpen() const { return m_impl!=NULL; }
+
+			/** Returns the next object from the file, or false at the end of the file.
+			  * \exception std::exception If an error was found reading or decoding the file (once all the objects read before the error have been returned).
+			  */
+			bool getNextObject(mrpt::utils::CSerializablePtr &obj);
+
+			/** The equivalent to CRawlog::getActionObservationPairOrObservation() over a stream, with the same semantics.
+			  * \return false at the end of the file, or on any error (which is dumped to std::cerr).
+			  */
+			bool getActionObservationPairOrObservation(
+				CActionCollectionPtr &action,
+				CSensoryFramePtr     &observations,
+				CObservationPtr      &observation,
+				size_t               &rawlogEntry );
+
+			/** The equivalent to CRawlog::readActionObservationPair() over a stream, with the same semantics.
+			  * \return false at the end of the file, or on any error (which is dumped to std::cerr).
+			  */
+			bool readActionObservationPair(
+				CActionCollectionPtr &action,
+				CSensoryFramePtr     &observations,
+				size_t               &rawlogEntry );
+
+			/** The position in the input file (or stream) up to which it has been already read by the pipeline, for progress indicators */
+			uint64_t getInputPosition() const;
+
+			/** The total size of the input file (or stream) */
+			uint64_t getInputSize() const;
+
+		private:
+			struct TImpl;
+			TImpl  *m_impl;  //!< The state of the pipeline, or NULL if not open
+		};
+
+	} // End of namespace
+} // End of namespace
+
+#endif
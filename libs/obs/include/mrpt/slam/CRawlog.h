@@ -124,6 +124,7 @@ namespace mrpt
 			/** Load the contents from a file containing one of these possibilities:
 			  *		- A "CRawlog" object.
 			  *		- Directly the sequence of objects (pairs CSensoryFrame/CActionCollection or CObservation* objects). In this case the method stops reading on EOF of an unrecogniced class name.
+			  *		- A seekable, indexed rawlog file (see CIndexedRawlogReader).
 			  * \returns It returns false if the file does not exists.
 			  */
 			bool  loadFromRawLogFile( const std::string &fileName );
@@ -0,0 +1,322 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/obs.h>   // Precompiled headers
+
+#include <mrpt/slam/CIndexedRawlog.h>
+#include <mrpt/slam/CSensoryFrame.h>
+#include <mrpt/slam/CActionCollection.h>
+#include <mrpt/compress/zip.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	const char     IRAWLOG_HEADER[8]  = {'M','R','P','T','_','I','R','L'};
+	const char     IRAWLOG_FOOTER[8]  = {'M','R','P','T','_','I','D','X'};
+	const uint32_t IRAWLOG_VERSION    = 1;
+	const size_t   IRAWLOG_HEADER_LEN = sizeof(IRAWLOG_HEADER)+sizeof(uint32_t);
+	const size_t   IRAWLOG_FOOTER_LEN = sizeof(uint64_t)+sizeof(IRAWLOG_FOOTER);
+}
+
+/*---------------------------------------------------------------
+					TIndexedRawlogEntry
+  ---------------------------------------------------------------*/
+void TIndexedRawlogEntry::setFromObject(const CSerializable &obj)
+{
+	const TRuntimeClassId *cls = obj.GetRuntimeClass();
+	className = cls->className;
+	timestamp = INVALID_TIMESTAMP;
+	sensorLabel.clear();
+
+	if (cls->derivedFrom(CLASS_ID(CObservation)))
+	{
+		const CObservation &o = static_cast<const CObservation&>(obj);
+		timestamp   = o.timestamp;
+		sensorLabel = o.sensorLabel;
+	}
+	else if (cls->derivedFrom(CLASS_ID(CSensoryFrame)))
+	{
+		const CSensoryFrame &sf = static_cast<const CSensoryFrame&>(obj);
+		for (CSensoryFrame::const_iterator it=sf.begin();it!=sf.end() && timestamp==INVALID_TIMESTAMP;++it)
+			timestamp = (*it)->timestamp;
+	}
+	else if (cls->derivedFrom(CLASS_ID(CActionCollection)))
+	{
+		const CActionCollection &acts = static_cast<const CActionCollection&>(obj);
+		for (CActionCollection::const_iterator it=acts.begin();it!=acts.end() && timestamp==INVALID_TIMESTAMP;++it)
+			timestamp = (*it)->timestamp;
+	}
+}
+
+/*---------------------------------------------------------------
+					CIndexedRawlogWriter
+  ---------------------------------------------------------------*/
+CIndexedRawlogWriter::CIndexedRawlogWriter() :
+	m_file(), m_block(), m_block_size(1<<20), m_index()
+{
+}
+
+CIndexedRawlogWriter::CIndexedRawlogWriter(const std::string &fileName, const size_t block_size) :
+	m_file(), m_block(), m_block_size(block_size), m_index()
+{
+	if (!open(fileName,block_size))
+		THROW_EXCEPTION_CUSTOM_MSG1("Error creating indexed rawlog file: '%s'",fileName.c_str())
+}
+
+CIndexedRawlogWriter::~CIndexedRawlogWriter()
+{
+	try
+	{
+		close();
+	}
+	catch(std::exception &e)
+	{
+		std::cerr << "[~CIndexedRawlogWriter] Exception closing the file:\n" << e.what() << std::endl;
+	}
+}
+
+bool CIndexedRawlogWriter::open(const std::string &fileName, const size_t block_size)
+{
+	close();
+
+	m_block_size = std::max(block_size,size_t(1));
+	m_index.clear();
+	m_block.Clear();
+
+	if (!m_file.open(fileName))
+		return false;
+
+	m_file.WriteBuffer(IRAWLOG_HEADER,sizeof(IRAWLOG_HEADER));
+	m_file << IRAWLOG_VERSION;
+	return true;
+}
+
+void CIndexedRawlogWriter::write(const CSerializable &obj)
+{
+	MRPT_START
+	ASSERTMSG_(m_file.fileOpenCorrectly(), "The indexed rawlog file is not open")
+
+	// Entries point to the block being built, which will be written at the current end of the file:
+	TIndexedRawlogEntry e;
+	e.setFromObject(obj);
+	e.blockOffset   = m_file.getPosition();
+	e.offsetInBlock = static_cast<uint32_t>(m_block.getTotalBytesCount());
+	m_index.push_back(e);
+
+	m_block.WriteObject(&obj);
+
+	if (m_block.getTotalBytesCount()>=m_block_size)
+		flushBlock();
+	MRPT_END
+}
+
+void CIndexedRawlogWriter::flushBlock()
+{
+	const size_t len = static_cast<size_t>(m_block.getTotalBytesCount());
+	if (!len) return;
+
+	std::vector<unsigned char> compressed;
+	mrpt::compress::zip::compress(m_block.getRawBufferData(),len,compressed);
+
+	m_file << static_cast<uint32_t>(compressed.size()) << static_cast<uint32_t>(len);
+	m_file.WriteBuffer(&compressed[0],compressed.size());
+
+	m_block.Clear();
+}
+
+void CIndexedRawlogWriter::close()
+{
+	if (!m_file.fileOpenCorrectly())
+		return;
+
+	flushBlock();
+
+	// The index, as one more block:
+	const uint64_t index_offset = m_file.getPosition();
+	m_block << static_cast<uint32_t>(m_index.size());
+	for (size_t i=0;i<m_index.size();i++)
+	{
+		const TIndexedRawlogEntry &e = m_index[i];
+		m_block << static_cast<uint64_t>(e.timestamp) << e.sensorLabel << e.className << e.blockOffset << e.offsetInBlock;
+	}
+	flushBlock();
+
+	m_file << index_offset;
+	m_file.WriteBuffer(IRAWLOG_FOOTER,sizeof(IRAWLOG_FOOTER));
+	m_file.close();
+	m_index.clear();
+}
+
+/*---------------------------------------------------------------
+					CIndexedRawlogReader
+  ---------------------------------------------------------------*/
+CIndexedRawlogReader::CIndexedRawlogReader() :
+	m_file(), m_index(), m_seek_times(), m_cached_block_offset(uint64_t(-1)), m_cached_block(), m_compressed()
+{
+}
+
+CIndexedRawlogReader::CIndexedRawlogReader(const std::string &fileName) :
+	m_file(), m_index(), m_seek_times(), m_cached_block_offset(uint64_t(-1)), m_cached_block(), m_compressed()
+{
+	if (!open(fileName))
+		THROW_EXCEPTION_CUSTOM_MSG1("Error opening indexed rawlog file: '%s'",fileName.c_str())
+}
+
+CIndexedRawlogReader::~CIndexedRawlogReader()
+{
+	close();
+}
+
+void CIndexedRawlogReader::close()
+{
+	m_file.close();
+	m_index.clear();
+	m_seek_times.clear();
+	m_cached_block_offset = uint64_t(-1);
+	m_cached_block.clear();
+}
+
+bool CIndexedRawlogReader::isIndexedRawlogFile(const std::string &fileName)
+{
+	CFileInputStream f;
+	if (!mrpt::system::fileExists(fileName) || !f.open(fileName))
+		return false;
+	char sig[sizeof(IRAWLOG_HEADER)];
+	return f.ReadBuffer(sig,sizeof(sig))==sizeof(sig) && !memcmp(sig,IRAWLOG_HEADER,sizeof(sig));
+}
+
+bool CIndexedRawlogReader::open(const std::string &fileName)
+{
+	close();
+
+	if (!isIndexedRawlogFile(fileName) || !m_file.open(fileName))
+		return false;
+
+	try
+	{
+		const uint64_t fileSize = m_file.getTotalBytesCount();
+		if (fileSize<IRAWLOG_HEADER_LEN+IRAWLOG_FOOTER_LEN)
+			THROW_EXCEPTION("File too short")
+
+		m_file.Seek(sizeof(IRAWLOG_HEADER));
+		uint32_t version;
+		m_file >> version;
+		if (version>IRAWLOG_VERSION)
+			THROW_EXCEPTION_CUSTOM_MSG1("Unsupported indexed rawlog version: %u",static_cast<unsigned int>(version))
+
+		// Footer:
+		m_file.Seek(fileSize-IRAWLOG_FOOTER_LEN);
+		uint64_t index_offset;
+		char     sig[sizeof(IRAWLOG_FOOTER)];
+		m_file >> index_offset;
+		m_file.ReadBuffer(sig,sizeof(sig));
+		if (memcmp(sig,IRAWLOG_FOOTER,sizeof(sig)) || index_offset<IRAWLOG_HEADER_LEN || index_offset>=fileSize)
+			THROW_EXCEPTION("Missing or corrupted index (was the file properly closed?)")
+
+		// Index:
+		std::vector<unsigned char> idx_data;
+		loadBlock(index_offset,idx_data);
+		CMemoryStream  idx;
+		idx.assignMemoryNotOwn(&idx_data[0],idx_data.size());
+
+		uint32_t N;
+		idx >> N;
+		m_index.resize(N);
+		m_seek_times.resize(N);
+		TTimeStamp  last_t = INVALID_TIMESTAMP;
+		for (uint32_t i=0;i<N;i++)
+		{
+			TIndexedRawlogEntry &e = m_index[i];
+			uint64_t t;
+			idx >> t >> e.sensorLabel >> e.className >> e.blockOffset >> e.offsetInBlock;
+			e.timestamp = static_cast<TTimeStamp>(t);
+			if (e.timestamp!=INVALID_TIMESTAMP && (last_t==INVALID_TIMESTAMP || e.timestamp>last_t))
+				last_t = e.timestamp;
+			m_seek_times[i] = last_t;
+		}
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "[CIndexedRawlogReader::open] Error loading '" << fileName << "':\n" << e.what() << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void CIndexedRawlogReader::readCompressedBlock(uint64_t offset, std::vector<unsigned char> &out_compressed, uint32_t &out_uncompressed_len)
+{
+	MRPT_START
+
+	m_file.Seek(offset);
+	uint32_t compressed_len;
+	m_file >> compressed_len >> out_uncompressed_len;
+
+	out_compressed.resize(compressed_len);
+	if (compressed_len && m_file.ReadBuffer(&out_compressed[0],compressed_len)!=compressed_len)
+		THROW_EXCEPTION("Unexpected end of file reading a block")
+
+	MRPT_END
+}
+
+void CIndexedRawlogReader::decompressBlock(const std::vector<unsigned char> &compressed, const uint32_t uncompressed_len, std::vector<unsigned char> &out_data)
+{
+	MRPT_START
+
+	out_data.resize(uncompressed_len);
+	size_t actual_len = 0;
+	if (uncompressed_len)
+		mrpt::compress::zip::decompress(const_cast<unsigned char*>(&compressed[0]),compressed.size(),&out_data[0],uncompressed_len,actual_len);
+	ASSERT_EQUAL_(actual_len,static_cast<size_t>(uncompressed_len))
+
+	MRPT_END
+}
+
+void CIndexedRawlogReader::loadBlock(uint64_t offset, std::vector<unsigned char> &out_data)
+{
+	uint32_t len;
+	readCompressedBlock(offset,m_compressed,len);
+	decompressBlock(m_compressed,len,out_data);
+}
+
+CSerializablePtr CIndexedRawlogReader::getEntry(size_t index, size_t *out_serialized_size)
+{
+	MRPT_START
+	ASSERTMSG_(index<m_index.size(), "Index out of bounds")
+
+	const TIndexedRawlogEntry &e = m_index[index];
+	if (e.blockOffset!=m_cached_block_offset)
+	{
+		m_cached_block_offset = uint64_t(-1);
+		loadBlock(e.blockOffset,m_cached_block);
+		m_cached_block_offset = e.blockOffset;
+	}
+	ASSERT_(e.offsetInBlock<m_cached_block.size())
+
+	CMemoryStream  mem;
+	mem.assignMemoryNotOwn(&m_cached_block[e.offsetInBlock], m_cached_block.size()-e.offsetInBlock);
+	CSerializablePtr obj = mem.ReadObject();
+	if (out_serialized_size)
+		*out_serialized_size = static_cast<size_t>(mem.getPosition());
+	return obj;
+
+	MRPT_END
+}
+
+size_t CIndexedRawlogReader::findEntryByTimestamp(const TTimeStamp t) const
+{
+	// m_seek_times is sorted, except for INVALID_TIMESTAMP's (=0) at the beginning, which are also lower than any "t":
+	return std::lower_bound(m_seek_times.begin(),m_seek_times.end(),t) - m_seek_times.begin();
+}
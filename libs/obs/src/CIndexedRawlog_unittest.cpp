@@ -0,0 +1,100 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+
+#include <mrpt/obs.h>
+#include <mrpt/base.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+
+// Write a file with many small blocks, then read it back in random order:
+TEST(CIndexedRawlog, WriteReadRandomAccess)
+{
+	const string fil = mrpt::system::getTempFileName();
+	const size_t N = 300;
+	const TTimeStamp t0 = mrpt::system::now();
+
+	{
+		CIndexedRawlogWriter  out(fil, 4096);
+		for (size_t i=0;i<N;i++)
+		{
+			if ((i%10)==5)
+			{
+				CSensoryFrame  sf;
+				CObservationCommentPtr o = CObservationComment::Create();
+				o->timestamp = t0+i*10000;
+				o->text = format("sf %u",static_cast<unsigned int>(i));
+				sf.insert(o);
+				out.write(sf);
+			}
+			else
+			{
+				CObservation2DRangeScan  o;
+				o.timestamp = t0+i*10000;
+				o.sensorLabel = format("LASER%u",static_cast<unsigned int>(i%3));
+				o.scan.assign(100+i,static_cast<float>(i));
+				o.validRange.assign(100+i,1);
+				out.write(o);
+			}
+		}
+		EXPECT_EQ(out.size(),N);
+	} // Dtor writes the index
+
+	EXPECT_TRUE(CIndexedRawlogReader::isIndexedRawlogFile(fil));
+
+	CIndexedRawlogReader  in;
+	ASSERT_TRUE(in.open(fil));
+	ASSERT_EQ(in.size(),N);
+
+	mrpt::random::CRandomGenerator rng(123);
+	for (size_t k=0;k<200;k++)
+	{
+		const size_t i = rng.drawUniform32bit() % N;
+		const TIndexedRawlogEntry &e = in.getEntryInfo(i);
+		EXPECT_EQ(e.timestamp, t0+i*10000);
+
+		CSerializablePtr obj = in.getEntry(i);
+		if ((i%10)==5)
+		{
+			ASSERT_TRUE(IS_CLASS(obj,CSensoryFrame));
+			EXPECT_EQ(e.className,string("CSensoryFrame"));
+			CSensoryFramePtr sf = CSensoryFramePtr(obj);
+			ASSERT_EQ(sf->size(),1u);
+			EXPECT_EQ(CObservationCommentPtr(sf->getObservationByIndex(0))->text, format("sf %u",static_cast<unsigned int>(i)));
+		}
+		else
+		{
+			ASSERT_TRUE(IS_CLASS(obj,CObservation2DRangeScan));
+			CObservation2DRangeScanPtr o = CObservation2DRangeScanPtr(obj);
+			EXPECT_EQ(e.sensorLabel, o->sensorLabel);
+			EXPECT_EQ(o->scan.size(),100+i);
+			EXPECT_EQ(o->scan.back(),static_cast<float>(i));
+		}
+	}
+
+	// Seek by time:
+	EXPECT_EQ(in.findEntryByTimestamp(0),0u);
+	EXPECT_EQ(in.findEntryByTimestamp(t0+123*10000),123u);
+	EXPECT_EQ(in.findEntryByTimestamp(t0+123*10000+1),124u);
+	EXPECT_EQ(in.findEntryByTimestamp(t0+N*10000),N);
+	in.close();
+
+	// Also readable as a whole rawlog:
+	CRawlog  rawlog;
+	ASSERT_TRUE(rawlog.loadFromRawLogFile(fil));
+	EXPECT_EQ(rawlog.size(),N);
+
+	remove(fil.c_str());
+}
@@ -0,0 +1,257 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/obs.h>   // Precompiled headers
+
+#include <mrpt/slam/CLazyRawlog.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+/*---------------------------------------------------------------
+					Constructors
+  ---------------------------------------------------------------*/
+CLazyRawlog::CLazyRawlog(size_t cache_max_bytes) :
+	m_is_open(false), m_is_indexed(false), m_cache(cache_max_bytes)
+{
+}
+
+CLazyRawlog::CLazyRawlog(const std::string &fileName, size_t cache_max_bytes) :
+	m_is_open(false), m_is_indexed(false), m_cache(cache_max_bytes)
+{
+	if (!open(fileName))
+		THROW_EXCEPTION_CUSTOM_MSG1("Error opening rawlog file: '%s'",fileName.c_str())
+}
+
+CLazyRawlog::~CLazyRawlog()
+{
+	close();
+}
+
+/*---------------------------------------------------------------
+					open
+  ---------------------------------------------------------------*/
+bool CLazyRawlog::open(const std::string &fileName)
+{
+	MRPT_START
+
+	close();
+	if (!fileExists(fileName))
+		return false;
+
+	if (CIndexedRawlogReader::isIndexedRawlogFile(fileName))
+	{
+		if (!m_indexed_file.open(fileName))
+			THROW_EXCEPTION_CUSTOM_MSG1("Corrupted indexed rawlog file: '%s'",fileName.c_str())
+		m_is_indexed = true;
+
+		// The index is already in the file, we only have to skip the comments:
+		for (size_t i=0;i<m_indexed_file.size();i++)
+		{
+			const TIndexedRawlogEntry &e = m_indexed_file.getEntryInfo(i);
+			if (e.className==CLASS_ID(CObservationComment)->className)
+			{
+				m_commentTexts = *CObservationCommentPtr(m_indexed_file.getEntry(i));
+				continue;
+			}
+			if (e.className==CLASS_ID(CRawlog)->className)
+				THROW_EXCEPTION("Rawlog files with a whole CRawlog object can't be read lazily: load them with CRawlog instead.")
+			m_index.push_back(e);
+			m_src_indexed.push_back(i);
+		}
+	}
+	else
+	{
+		if (!m_legacy_file.open(fileName))
+			return false;
+		m_is_indexed = false;
+		indexLegacyFile();
+
+		// Start again from the beginning, so sequential accesses never seek backwards:
+		m_legacy_file.close();
+		if (!m_legacy_file.open(fileName))
+			return false;
+	}
+
+	buildSeekTimes();
+	m_is_open = true;
+	return true;
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					indexLegacyFile
+  ---------------------------------------------------------------*/
+void CLazyRawlog::indexLegacyFile()
+{
+	// We must read the whole file once, but only one object is kept in memory at once:
+	for (;;)
+	{
+		const uint64_t pos = m_legacy_file.getPosition();
+		CSerializablePtr obj;
+		try
+		{
+			obj = m_legacy_file.ReadObject();
+		}
+		catch (CExceptionEOF &)
+		{
+			break;
+		}
+		catch (std::exception &e)
+		{
+			// As in CRawlog::loadFromRawLogFile(), stop reading at a truncated or corrupted entry:
+			std::cerr << e.what() << std::endl;
+			break;
+		}
+
+		const TRuntimeClassId *cls = obj->GetRuntimeClass();
+		if (cls==CLASS_ID(CObservationComment))
+		{
+			m_commentTexts = *CObservationCommentPtr(obj);
+			continue;
+		}
+		if (cls==CLASS_ID(CRawlog))
+			THROW_EXCEPTION("Rawlog files with a whole CRawlog object can't be read lazily: load them with CRawlog instead.")
+		if (!cls->derivedFrom(CLASS_ID(CObservation)) && cls!=CLASS_ID(CSensoryFrame) && cls!=CLASS_ID(CActionCollection))
+			break; // Unknown class: stop here, as CRawlog::loadFromRawLogFile() does.
+
+		TIndexedRawlogEntry e;
+		e.setFromObject(*obj);
+		e.blockOffset = pos;
+		m_index.push_back(e);
+		m_legacy_sizes.push_back(static_cast<size_t>(m_legacy_file.getPosition()-pos));
+	}
+}
+
+/*---------------------------------------------------------------
+					buildSeekTimes
+  ---------------------------------------------------------------*/
+void CLazyRawlog::buildSeekTimes()
+{
+	m_seek_times.resize(m_index.size());
+	TTimeStamp last_t = INVALID_TIMESTAMP;
+	for (size_t i=0;i<m_index.size();i++)
+	{
+		const TTimeStamp t = m_index[i].timestamp;
+		if (t!=INVALID_TIMESTAMP && (last_t==INVALID_TIMESTAMP || t>last_t))
+			last_t = t;
+		m_seek_times[i] = last_t;
+	}
+}
+
+/*---------------------------------------------------------------
+					close
+  ---------------------------------------------------------------*/
+void CLazyRawlog::close()
+{
+	m_indexed_file.close();
+	m_legacy_file.close();
+	m_index.clear();
+	m_src_indexed.clear();
+	m_legacy_sizes.clear();
+	m_seek_times.clear();
+	m_commentTexts.text.clear();
+	m_cache.clear();
+	m_is_open = false;
+	m_is_indexed = false;
+}
+
+/*---------------------------------------------------------------
+					getType
+  ---------------------------------------------------------------*/
+CRawlog::TEntryType CLazyRawlog::getType(size_t index) const
+{
+	ASSERTMSG_(index<m_index.size(), "Index out of bounds")
+
+	const TRuntimeClassId *cls = findRegisteredClass(m_index[index].className);
+	ASSERT_(cls!=NULL)
+	if (cls->derivedFrom(CLASS_ID(CObservation)))
+		return CRawlog::etObservation;
+	else if (cls->derivedFrom(CLASS_ID(CSensoryFrame)))
+		return CRawlog::etSensoryFrame;
+	else
+		return CRawlog::etActionCollection;
+}
+
+/*---------------------------------------------------------------
+					getAsGeneric
+  ---------------------------------------------------------------*/
+CSerializablePtr CLazyRawlog::getAsGeneric(size_t index)
+{
+	MRPT_START
+	ASSERTMSG_(index<m_index.size(), "Index out of bounds")
+
+	CSerializablePtr obj;
+	if (m_cache.get(index,obj))
+		return obj;
+
+	size_t nBytes;
+	if (m_is_indexed)
+	{
+		obj = m_indexed_file.getEntry(m_src_indexed[index], &nBytes);
+	}
+	else
+	{
+		if (m_legacy_file.getPosition()!=m_index[index].blockOffset)
+			m_legacy_file.Seek(m_index[index].blockOffset);
+		obj = m_legacy_file.ReadObject();
+		nBytes = m_legacy_sizes[index];
+	}
+
+	m_cache.insert(index,obj,nBytes);
+	return obj;
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					getAsAction
+  ---------------------------------------------------------------*/
+CActionCollectionPtr CLazyRawlog::getAsAction(size_t index)
+{
+	CSerializablePtr obj = getAsGeneric(index);
+	if (obj->GetRuntimeClass()!=CLASS_ID(CActionCollection))
+		THROW_EXCEPTION_CUSTOM_MSG1("Element %u is not a CActionCollection",static_cast<unsigned int>(index))
+	return CActionCollectionPtr(obj);
+}
+
+/*---------------------------------------------------------------
+					getAsObservations
+  ---------------------------------------------------------------*/
+CSensoryFramePtr CLazyRawlog::getAsObservations(size_t index)
+{
+	CSerializablePtr obj = getAsGeneric(index);
+	if (obj->GetRuntimeClass()!=CLASS_ID(CSensoryFrame))
+		THROW_EXCEPTION_CUSTOM_MSG1("Element %u is not a CSensoryFrame",static_cast<unsigned int>(index))
+	return CSensoryFramePtr(obj);
+}
+
+/*---------------------------------------------------------------
+					getAsObservation
+  ---------------------------------------------------------------*/
+CObservationPtr CLazyRawlog::getAsObservation(size_t index)
+{
+	CSerializablePtr obj = getAsGeneric(index);
+	if (!obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
+		THROW_EXCEPTION_CUSTOM_MSG1("Element %u is not a CObservation",static_cast<unsigned int>(index))
+	return CObservationPtr(obj);
+}
+
+/*---------------------------------------------------------------
+					findEntryByTimestamp
+  ---------------------------------------------------------------*/
+size_t CLazyRawlog::findEntryByTimestamp(const TTimeStamp t) const
+{
+	return std::lower_bound(m_seek_times.begin(),m_seek_times.end(),t) - m_seek_times.begin();
+}
@@ -0,0 +1,149 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+
+#include <mrpt/obs.h>
+#include <mrpt/base.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	const size_t N = 50;
+	const TTimeStamp t0 = 1000000000;
+
+	CObservation2DRangeScanPtr makeScan(size_t i)
+	{
+		CObservation2DRangeScanPtr o = CObservation2DRangeScan::Create();
+		o->timestamp = t0+i*10000;
+		o->sensorLabel = "LASER";
+		o->scan.assign(100+i,static_cast<float>(i));
+		o->validRange.assign(100+i,1);
+		return o;
+	}
+
+	// Reads all the entries of a rawlog made of makeScan(i) observations, in random order, with a small cache:
+	void checkRawlog(CLazyRawlog &rawlog)
+	{
+		ASSERT_EQ(rawlog.size(),N);
+		EXPECT_EQ(rawlog.getCommentText(),"test dataset");
+		rawlog.setCacheMaxBytes(4000);  // Only a few scans fit in it
+
+		mrpt::random::CRandomGenerator rng(123);
+		for (size_t k=0;k<200;k++)
+		{
+			const size_t i = rng.drawUniform32bit() % N;
+			EXPECT_EQ(rawlog.getType(i),CRawlog::etObservation);
+			EXPECT_EQ(rawlog.getEntryInfo(i).timestamp,t0+i*10000);
+
+			CObservation2DRangeScanPtr o = CObservation2DRangeScanPtr(rawlog.getAsObservation(i));
+			EXPECT_EQ(o->scan.size(),100+i);
+			EXPECT_EQ(o->scan.back(),static_cast<float>(i));
+			EXPECT_EQ(o->timestamp,t0+i*10000);
+		}
+		EXPECT_GT(rawlog.getCache().getStats().evictions,0u);
+		EXPECT_LE(rawlog.getCache().getCurrentBytes(),rawlog.getCache().getMaxBytes());
+		EXPECT_THROW(rawlog.getAsObservations(0),std::exception);
+
+		EXPECT_EQ(rawlog.findEntryByTimestamp(t0+17*10000),17u);
+		EXPECT_EQ(rawlog.findEntryByTimestamp(t0+17*10000+1),18u);
+	}
+}
+
+TEST(CLazyRawlog, LegacyCompressedFile)
+{
+	const string fil = mrpt::system::getTempFileName();
+	{
+		CFileGZOutputStream out(fil);
+		CObservationComment comment;
+		comment.text = "test dataset";
+		out << comment;
+		for (size_t i=0;i<N;i++)
+			out << *makeScan(i);
+	}
+
+	CLazyRawlog rawlog;
+	ASSERT_TRUE(rawlog.open(fil));
+	EXPECT_FALSE(rawlog.isIndexedFile());
+	checkRawlog(rawlog);
+	rawlog.close();
+	remove(fil.c_str());
+}
+
+TEST(CLazyRawlog, IndexedFile)
+{
+	const string fil = mrpt::system::getTempFileName();
+	{
+		CIndexedRawlogWriter out(fil, 4096);
+		CObservationComment comment;
+		comment.text = "test dataset";
+		out.write(comment);
+		for (size_t i=0;i<N;i++)
+			out.write(*makeScan(i));
+	}
+
+	CLazyRawlog rawlog(fil);
+	EXPECT_TRUE(rawlog.isIndexedFile());
+	checkRawlog(rawlog);
+	rawlog.close();
+	remove(fil.c_str());
+}
+
+TEST(CLazySimpleMap, LoadOnDemand)
+{
+	const string fil = mrpt::system::getTempFileName();
+	{
+		CSimpleMap  smap;
+		for (size_t i=0;i<N;i++)
+		{
+			CSensoryFrame sf;
+			sf.insert(makeScan(i));
+			CPose3DPDFGaussian pdf;
+			pdf.mean = CPose3D(i,0,0);
+			smap.insert(&pdf,sf);
+		}
+		ASSERT_TRUE(smap.saveToFile(fil));
+	}
+
+	CLazySimpleMap  smap(fil, 1);  // Too small to keep anything
+	ASSERT_EQ(smap.size(),N);
+	for (size_t i=0;i<N;i++)
+	{
+		const CLazySimpleMap::TEntryInfo &e = smap.getEntryInfo(i);
+		EXPECT_EQ(e.timestamp,t0+i*10000);
+		EXPECT_NEAR(e.posePDF->getMeanVal().x(),static_cast<double>(i),1e-9);
+	}
+
+	// Backwards, so the gz file must be seeked for each frame:
+	for (size_t i=N;i-->0;)
+	{
+		CPose3DPDFPtr pdf;
+		CSensoryFramePtr sf;
+		smap.get(i,pdf,sf);
+		ASSERT_EQ(sf->size(),1u);
+		CObservation2DRangeScanPtr o = sf->getObservationByClass<CObservation2DRangeScan>();
+		ASSERT_TRUE(o.present());
+		EXPECT_EQ(o->scan.size(),100+i);
+	}
+	EXPECT_EQ(smap.getCache().size(),0u);
+
+	smap.setCacheMaxBytes(1024*1024);
+	smap.getSensoryFrame(3);
+	smap.getSensoryFrame(3);
+	EXPECT_EQ(smap.getCache().getStats().hits,1u);
+
+	smap.close();
+	remove(fil.c_str());
+}
@@ -0,0 +1,158 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/obs.h>   // Precompiled headers
+
+#include <mrpt/slam/CLazySimpleMap.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::system;
+using namespace std;
+
+/*---------------------------------------------------------------
+					Constructors
+  ---------------------------------------------------------------*/
+CLazySimpleMap::CLazySimpleMap(size_t cache_max_bytes) :
+	m_is_open(false), m_cache(cache_max_bytes)
+{
+}
+
+CLazySimpleMap::CLazySimpleMap(const std::string &fileName, size_t cache_max_bytes) :
+	m_is_open(false), m_cache(cache_max_bytes)
+{
+	if (!open(fileName))
+		THROW_EXCEPTION_CUSTOM_MSG1("Error opening simplemap file: '%s'",fileName.c_str())
+}
+
+CLazySimpleMap::~CLazySimpleMap()
+{
+	close();
+}
+
+/*---------------------------------------------------------------
+					open
+  ---------------------------------------------------------------*/
+bool CLazySimpleMap::open(const std::string &fileName)
+{
+	MRPT_START
+
+	close();
+	if (!fileExists(fileName) || !m_file.open(fileName))
+		return false;
+
+	indexFile();
+
+	// Start again from the beginning, so sequential accesses never seek backwards:
+	m_file.close();
+	if (!m_file.open(fileName))
+		return false;
+
+	m_is_open = true;
+	return true;
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					indexFile
+  ---------------------------------------------------------------*/
+void CLazySimpleMap::indexFile()
+{
+	// Parse the header of the CSimpleMap object (see CStream::ReadObject() and CSimpleMap::writeToStream()),
+	//  then read the pose PDFs and skip the sensory frames, keeping only their positions:
+	uint8_t lenClassName;
+	m_file >> lenClassName;
+	if (!(lenClassName & 0x80))
+		THROW_EXCEPTION("Simplemap files saved before MRPT 0.5.5 can't be read lazily: load them with CSimpleMap instead.")
+	lenClassName &= 0x7F;
+
+	std::string className(lenClassName,' ');
+	if (lenClassName)
+		m_file.ReadBuffer(&className[0],lenClassName);
+	if (className!=CLASS_ID(CSimpleMap)->className && className!="CSensFrameProbSequence")
+		THROW_EXCEPTION_CUSTOM_MSG1("The file does not contain a CSimpleMap object, but a '%s'",className.c_str())
+
+	int8_t version;
+	m_file >> version;
+	if (version!=0 && version!=1)
+		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+
+	uint32_t n;
+	m_file >> n;
+	m_index.resize(n);
+	for (uint32_t i=0;i<n;i++)
+	{
+		TEntryInfo &e = m_index[i];
+		if (version==0)
+		{
+			// There are 2D poses PDF instead of 3D: transform them:
+			CPosePDFPtr aux2Dpose;
+			m_file >> aux2Dpose;
+			e.posePDF = CPose3DPDFPtr( CPose3DPDF::createFrom2D( *aux2Dpose ) );
+		}
+		else
+		{
+			m_file >> e.posePDF;
+		}
+
+		e.fileOffset = m_file.getPosition();
+		CSensoryFramePtr sf;
+		m_file >> sf;
+		e.serializedSize = static_cast<size_t>(m_file.getPosition()-e.fileOffset);
+		for (CSensoryFrame::const_iterator it=sf->begin();it!=sf->end() && e.timestamp==INVALID_TIMESTAMP;++it)
+			e.timestamp = (*it)->timestamp;
+	}
+}
+
+/*---------------------------------------------------------------
+					close
+  ---------------------------------------------------------------*/
+void CLazySimpleMap::close()
+{
+	m_file.close();
+	m_index.clear();
+	m_cache.clear();
+	m_is_open = false;
+}
+
+/*---------------------------------------------------------------
+					getSensoryFrame
+  ---------------------------------------------------------------*/
+CSensoryFramePtr CLazySimpleMap::getSensoryFrame(size_t index)
+{
+	MRPT_START
+	ASSERTMSG_(index<m_index.size(), "Index out of bounds")
+
+	CSensoryFramePtr sf;
+	if (m_cache.get(index,sf))
+		return sf;
+
+	const TEntryInfo &e = m_index[index];
+	if (m_file.getPosition()!=e.fileOffset)
+		m_file.Seek(e.fileOffset);
+	m_file >> sf;
+
+	m_cache.insert(index,sf,e.serializedSize);
+	return sf;
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					get
+  ---------------------------------------------------------------*/
+void CLazySimpleMap::get(size_t index, CPose3DPDFPtr &out_posePDF, CSensoryFramePtr &out_SF)
+{
+	out_SF = getSensoryFrame(index);
+	out_posePDF = m_index[index].posePDF;
+}
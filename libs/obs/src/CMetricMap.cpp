@@ -94,6 +94,20 @@ double CMetricMap::computeObservationsLikelihood(
 	return lik;
 }
 
+/*---------------------------------------------------------------
+				computeObservationLikelihoodForPoses
+  ---------------------------------------------------------------*/
+void CMetricMap::computeObservationLikelihoodForPoses(
+	const CObservation           *obs,
+	const std::vector<mrpt::math::TPose3D>   &takenFrom,
+	vector_double                &out_log_liks )
+{
+	const size_t N = takenFrom.size();
+	out_log_liks.resize(N);
+	for (size_t i=0;i<N;i++)
+		out_log_liks[i] = computeObservationLikelihood( obs, CPose3D(takenFrom[i]) );
+}
+
 /*---------------------------------------------------------------
 				canComputeObservationLikelihood
   ---------------------------------------------------------------*/
@@ -13,6 +13,7 @@
 #include <mrpt/poses/CPosePDF.h>
 
 #include <mrpt/math/utils.h>
+#include <mrpt/system/CGenericMemoryPool.h>
 
 using namespace std;
 using namespace mrpt::slam;
@@ -45,6 +46,18 @@ CObservation2DRangeScan::CObservation2DRangeScan( ) :
  ---------------------------------------------------------------*/
 CObservation2DRangeScan::~CObservation2DRangeScan()
 {
+	// Recycle the memory of the scan for future ones:
+	mrpt::system::CVectorMemoryPool<std::vector<float> >::donate(scan);
+	mrpt::system::CVectorMemoryPool<std::vector<char> >::donate(validRange);
+}
+
+/*---------------------------------------------------------------
+							resizeScan
+ ---------------------------------------------------------------*/
+void CObservation2DRangeScan::resizeScan(const size_t len)
+{
+	mrpt::system::CVectorMemoryPool<std::vector<float> >::resize(scan,len);
+	mrpt::system::CVectorMemoryPool<std::vector<char> >::resize(validRange,len);
 }
 
 /*---------------------------------------------------------------
@@ -125,21 +138,19 @@ void  CObservation2DRangeScan::readFromStream(CStream &in, int version)
 
 			in >> N;
 
-			scan.resize(N);
+			resizeScan(N);
 			if (N)
 				in.ReadBufferFixEndianness( &scan[0], N);
 
 			if (version>=1)
 			{
 				// Load validRange:
-				validRange.resize(N);
 				if (N)
 					in.ReadBuffer( &validRange[0], sizeof(validRange[0])*N );
 			}
 			else
 			{
 				// validRange: Default values: If distance is not maxRange
-				validRange.resize(N);
 				for (i=0;i<N;i++)
 					validRange[i]= scan[i] < maxRange;
 			}
@@ -179,8 +190,7 @@ void  CObservation2DRangeScan::readFromStream(CStream &in, int version)
 				in  >> covSensorPose;
 
 			in >> N;
-			scan.resize(N);
-			validRange.resize(N);
+			resizeScan(N);
 			if (N)
 			{
 				in.ReadBuffer( &scan[0], sizeof(scan[0])*N);
@@ -0,0 +1,259 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/obs.h>   // Precompiled headers
+
+#include <mrpt/slam/CObservation3DRangeScan.h>
+#include <mrpt/system/parallelization.h>
+#include <mrpt/utils/SSE_types.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace std;
+
+namespace
+{
+	/** Functor for projectRangeImageToXYZ(): projects a range of (decimated) rows of the range image.
+	  *  The points of each output row "rd" are written, without gaps, from the position rd*Wd of the output arrays. */
+	struct TProjectRows
+	{
+		const CMatrix  &m_ranges;
+		const float    *m_kys, *m_kzs;  // Ray directions, for each column and row
+		const bool      m_range_is_depth;
+		const unsigned  m_decim;
+		const size_t    m_Wd;
+		const bool      m_clip;
+		const float     m_minRange, m_maxRange;
+		const float    *m_HM;           // 3x4 transformation, or NULL
+		float          *m_xs, *m_ys, *m_zs;
+		uint32_t       *m_pixel_idxs;   // May be NULL
+		size_t         *m_row_counts;
+
+		TProjectRows(const CMatrix &ranges, const float *kys, const float *kzs, const bool range_is_depth, const unsigned decim,
+			const size_t Wd, const bool clip, const float minRange, const float maxRange, const float *HM,
+			float *xs, float *ys, float *zs, uint32_t *pixel_idxs, size_t *row_counts) :
+			m_ranges(ranges), m_kys(kys), m_kzs(kzs), m_range_is_depth(range_is_depth), m_decim(decim),
+			m_Wd(Wd), m_clip(clip), m_minRange(minRange), m_maxRange(maxRange), m_HM(HM),
+			m_xs(xs), m_ys(ys), m_zs(zs), m_pixel_idxs(pixel_idxs), m_row_counts(row_counts)
+		{ }
+
+		inline bool isValidRange(const float D) const {
+			return !m_clip || (D>0 && D>=m_minRange && (m_maxRange<=0 || D<=m_maxRange));
+		}
+
+		/** Stores one point (after transforming it, if needed) at position "idx" */
+		inline void storePoint(const size_t idx, const float x, const float y, const float z, const uint32_t pixel) const
+		{
+			if (m_HM)
+			{
+				m_xs[idx] = m_HM[0]*x + m_HM[1]*y + m_HM[2] *z + m_HM[3];
+				m_ys[idx] = m_HM[4]*x + m_HM[5]*y + m_HM[6] *z + m_HM[7];
+				m_zs[idx] = m_HM[8]*x + m_HM[9]*y + m_HM[10]*z + m_HM[11];
+			}
+			else
+			{
+				m_xs[idx] = x;
+				m_ys[idx] = y;
+				m_zs[idx] = z;
+			}
+			if (m_pixel_idxs)
+				m_pixel_idxs[idx] = pixel;
+		}
+
+		void operator()(const mrpt::system::BlockedRange &range) const
+		{
+			const int W = m_ranges.cols();
+			for (int rd=range.begin();rd<range.end();rd++)
+			{
+				const int r = rd*m_decim;
+				const float *D_row = &m_ranges.coeffRef(r,0);
+				const float Kz = m_kzs[r];
+				size_t idx = rd*m_Wd;  // Next point of this row
+				int c = 0;
+
+#if MRPT_HAS_SSE2
+				if (m_decim==1)
+				{
+					const __m128 KZ = _mm_set1_ps(Kz);
+					const __m128 ONE_PLUS_KZ2 = _mm_set1_ps(1+Kz*Kz);
+					__m128 H[12];
+					if (m_HM)
+						for (int k=0;k<12;k++) H[k] = _mm_set1_ps(m_HM[k]);
+					const __m128 MIN_R = _mm_set1_ps(m_minRange);
+					const __m128 MAX_R = _mm_set1_ps(m_maxRange>0 ? m_maxRange : std::numeric_limits<float>::max());
+					const __m128 ZERO = _mm_setzero_ps();
+					EIGEN_ALIGN16 float xs[4],ys[4],zs[4];
+
+					for (;c+4<=W;c+=4)
+					{
+						const __m128 D  = _mm_loadu_ps(D_row+c);
+						const __m128 KY = _mm_loadu_ps(m_kys+c);
+
+						// range_is_depth: x=D, otherwise: x = D/sqrt(1+Ky^2+Kz^2). In both cases, y=Ky*D, z=Kz*D:
+						__m128 X = m_range_is_depth ? D : _mm_div_ps(D, _mm_sqrt_ps(_mm_add_ps(ONE_PLUS_KZ2,_mm_mul_ps(KY,KY))));
+						__m128 Y = _mm_mul_ps(KY,D);
+						__m128 Z = _mm_mul_ps(KZ,D);
+
+						if (m_HM)
+						{
+							const __m128 X2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(H[0],X),_mm_mul_ps(H[1],Y)),_mm_add_ps(_mm_mul_ps(H[2],Z),H[3]));
+							const __m128 Y2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(H[4],X),_mm_mul_ps(H[5],Y)),_mm_add_ps(_mm_mul_ps(H[6],Z),H[7]));
+							const __m128 Z2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(H[8],X),_mm_mul_ps(H[9],Y)),_mm_add_ps(_mm_mul_ps(H[10],Z),H[11]));
+							X=X2; Y=Y2; Z=Z2;
+						}
+
+						const int valid = !m_clip ? 0x0F :
+							_mm_movemask_ps(_mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(D,ZERO),_mm_cmpge_ps(D,MIN_R)),_mm_cmple_ps(D,MAX_R)));
+
+						if (valid==0x0F)
+						{
+							_mm_storeu_ps(m_xs+idx,X);
+							_mm_storeu_ps(m_ys+idx,Y);
+							_mm_storeu_ps(m_zs+idx,Z);
+							if (m_pixel_idxs)
+								for (int k=0;k<4;k++) m_pixel_idxs[idx+k] = r*W+c+k;
+							idx+=4;
+						}
+						else if (valid)
+						{
+							// Keep only the valid points, one by one:
+							_mm_store_ps(xs,X);
+							_mm_store_ps(ys,Y);
+							_mm_store_ps(zs,Z);
+							for (int k=0;k<4;k++)
+								if (valid & (1<<k))
+								{
+									m_xs[idx]=xs[k]; m_ys[idx]=ys[k]; m_zs[idx]=zs[k];
+									if (m_pixel_idxs) m_pixel_idxs[idx] = r*W+c+k;
+									idx++;
+								}
+						}
+					}
+				}
+#endif
+				// The rest of the row (or all of it, without SSE2 or with decimation):
+				for (;c<W;c+=m_decim)
+				{
+					const float D = D_row[c];
+					if (!isValidRange(D))
+						continue;
+					const float Ky = m_kys[c];
+					const float x = m_range_is_depth ? D : D / std::sqrt(1+Ky*Ky+Kz*Kz);
+					storePoint(idx++, x, Ky*D, Kz*D, r*W+c);
+				}
+
+				m_row_counts[rd] = idx - rd*m_Wd;
+			}
+		}
+	};
+
+	/** Functor for transformPointsXYZ() */
+	struct TTransformPoints
+	{
+		const float *m_HM;
+		float       *m_xs, *m_ys, *m_zs;
+
+		TTransformPoints(const float *HM, float *xs, float *ys, float *zs) : m_HM(HM), m_xs(xs), m_ys(ys), m_zs(zs) { }
+
+		void operator()(const mrpt::system::BlockedRange &range) const
+		{
+			for (int i=range.begin();i<range.end();i++)
+			{
+				const float x=m_xs[i], y=m_ys[i], z=m_zs[i];
+				m_xs[i] = m_HM[0]*x + m_HM[1]*y + m_HM[2] *z + m_HM[3];
+				m_ys[i] = m_HM[4]*x + m_HM[5]*y + m_HM[6] *z + m_HM[7];
+				m_zs[i] = m_HM[8]*x + m_HM[9]*y + m_HM[10]*z + m_HM[11];
+			}
+		}
+	};
+
+	/** Fills the tables of the direction of the camera rays, for each column (Kys) and row (Kzs) */
+	void computeRayTables(const TCamera &cam, const int W, const int H, mrpt::vector_float &Kys, mrpt::vector_float &Kzs)
+	{
+		const float r_cx = cam.cx();
+		const float r_cy = cam.cy();
+		const float r_fx_inv = 1.0f/cam.fx();
+		const float r_fy_inv = 1.0f/cam.fy();
+
+		Kys.resize(W);
+		Kzs.resize(H);
+		for (int c=0;c<W;c++) Kys[c] = (r_cx - c) * r_fx_inv;
+		for (int r=0;r<H;r++) Kzs[r] = (r_cy - r) * r_fy_inv;
+	}
+}
+
+/*---------------------------------------------------------------
+					projectRangeImageToXYZ
+  ---------------------------------------------------------------*/
+size_t mrpt::slam::detail::projectRangeImageToXYZ(
+	CObservation3DRangeScan &src_obs, const T3DPointsProjectionParams &projectParams, const float *HM,
+	float *xs, float *ys, float *zs, std::vector<uint32_t> *out_pixel_idxs)
+{
+	const int W = src_obs.rangeImage.cols();
+	const int H = src_obs.rangeImage.rows();
+	const unsigned int decim = std::max(1u,projectParams.decimation);
+	const size_t Wd = (W+decim-1)/decim;
+	const size_t Hd = (H+decim-1)/decim;
+	if (!Wd || !Hd)
+	{
+		if (out_pixel_idxs) out_pixel_idxs->clear();
+		return 0;
+	}
+
+	// The directions of the rays: only W+H values, so they're computed for each call instead of being
+	//  shared through CObservation3DRangeScan::m_3dproj_lut, which would not be thread-safe for different cameras.
+	mrpt::vector_float kys, kzs;
+	computeRayTables(src_obs.cameraParams,W,H,kys,kzs);
+
+	if (out_pixel_idxs)
+		out_pixel_idxs->resize(Wd*Hd);
+
+	const bool clip = projectParams.minRange>0 || projectParams.maxRange>0;
+	std::vector<size_t> row_counts(Hd);
+
+	const TProjectRows body(src_obs.rangeImage, &kys[0], &kzs[0], src_obs.range_is_depth, decim, Wd,
+		clip, projectParams.minRange, projectParams.maxRange, HM,
+		xs,ys,zs, out_pixel_idxs ? &(*out_pixel_idxs)[0] : NULL, &row_counts[0]);
+
+	const mrpt::system::BlockedRange rows(0,static_cast<int>(Hd),16);
+	if (projectParams.parallelize)
+		mrpt::system::parallel_for(rows, body);
+	else body(rows);
+
+	// Without clipping, all the rows are full. Otherwise, remove the gaps between rows:
+	size_t N = 0;
+	for (size_t rd=0;rd<Hd;rd++)
+	{
+		const size_t n = row_counts[rd], src = rd*Wd;
+		if (n && src!=N)
+		{
+			std::memmove(xs+N, xs+src, n*sizeof(float));
+			std::memmove(ys+N, ys+src, n*sizeof(float));
+			std::memmove(zs+N, zs+src, n*sizeof(float));
+			if (out_pixel_idxs)
+				std::memmove(&(*out_pixel_idxs)[N], &(*out_pixel_idxs)[src], n*sizeof(uint32_t));
+		}
+		N+=n;
+	}
+	if (out_pixel_idxs)
+		out_pixel_idxs->resize(N);
+
+	return N;
+}
+
+/*---------------------------------------------------------------
+					transformPointsXYZ
+  ---------------------------------------------------------------*/
+void mrpt::slam::detail::transformPointsXYZ(const float *HM, float *xs, float *ys, float *zs, const size_t N)
+{
+	mrpt::system::parallel_for(
+		mrpt::system::BlockedRange(0,static_cast<int>(N),8192),
+		TTransformPoints(HM,xs,ys,zs) );
+}
@@ -0,0 +1,124 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+
+#include <mrpt/obs.h>
+#include <mrpt/opengl/CPointCloud.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace std;
+
+// A synthetic range image, with a width which is not a multiple of 4 and some invalid (zero) ranges:
+static void fillObservation(CObservation3DRangeScan &obs, const bool range_is_depth)
+{
+	const int W=37, H=23;
+	obs.hasRangeImage = true;
+	obs.range_is_depth = range_is_depth;
+	obs.rangeImage.setSize(H,W);
+	for (int r=0;r<H;r++)
+		for (int c=0;c<W;c++)
+			obs.rangeImage(r,c) = ((r+c)%11==0) ? 0.0f : 0.5f + 0.1f*((r*7+c*3)%40);
+
+	obs.cameraParams.ncols = W;
+	obs.cameraParams.nrows = H;
+	obs.cameraParams.setIntrinsicParamsFromValues(30,31,18.5,11.2);
+	obs.sensorPose = CPose3D(0.1,0.2,0.3,DEG2RAD(10),DEG2RAD(-5),DEG2RAD(3));
+}
+
+// The projection of one pixel, as documented in CObservation3DRangeScan::project3DPointsFromDepthImageInto()
+static TPoint3D projectPixel(const CObservation3DRangeScan &obs, const int r, const int c)
+{
+	const double Ky = (obs.cameraParams.cx()-c)/obs.cameraParams.fx();
+	const double Kz = (obs.cameraParams.cy()-r)/obs.cameraParams.fy();
+	const double D = obs.rangeImage(r,c);
+	return TPoint3D(obs.range_is_depth ? D : D/std::sqrt(1+Ky*Ky+Kz*Kz), Ky*D, Kz*D);
+}
+
+template <class POINTMAP>
+static void checkProjection(CObservation3DRangeScan &obs, POINTMAP &pts, const T3DPointsProjectionParams &pp)
+{
+	obs.project3DPointsFromDepthImageInto(pts,pp);
+
+	CPose3D transf;
+	if (pp.takeIntoAccountSensorPoseOnRobot) transf = obs.sensorPose;
+	if (pp.robotPoseInTheWorld) transf = *pp.robotPoseInTheWorld + transf;
+
+	const unsigned int decim = std::max(1u,pp.decimation);
+	const bool clip = pp.minRange>0 || pp.maxRange>0;
+
+	mrpt::utils::PointCloudAdapter<POINTMAP> pca(pts);
+	size_t idx = 0;
+	for (int r=0;r<obs.rangeImage.rows();r+=decim)
+		for (int c=0;c<obs.rangeImage.cols();c+=decim)
+		{
+			const float D = obs.rangeImage(r,c);
+			if (clip && (D<=0 || D<pp.minRange || (pp.maxRange>0 && D>pp.maxRange)))
+				continue;
+
+			ASSERT_LT(idx,pca.size());
+			TPoint3D expected;
+			transf.composePoint(projectPixel(obs,r,c),expected);
+			float x,y,z;
+			pca.getPointXYZ(idx++,x,y,z);
+			EXPECT_NEAR(x,expected.x,1e-4) << "r=" << r << " c=" << c;
+			EXPECT_NEAR(y,expected.y,1e-4) << "r=" << r << " c=" << c;
+			EXPECT_NEAR(z,expected.z,1e-4) << "r=" << r << " c=" << c;
+		}
+	EXPECT_EQ(idx,pca.size());
+}
+
+TEST(CObservation3DRangeScan, project3DPointsFromDepthImage)
+{
+	for (int range_is_depth=0;range_is_depth<2;range_is_depth++)
+		for (int use_lut=0;use_lut<2;use_lut++)
+		{
+			CObservation3DRangeScan obs;
+			fillObservation(obs, range_is_depth!=0);
+
+			T3DPointsProjectionParams pp;
+			pp.PROJ3D_USE_LUT = use_lut!=0;
+
+			// Into the observation itself (direct write), and into another kind of point cloud:
+			checkProjection(obs,obs,pp);
+			mrpt::opengl::CPointCloudPtr glPts = mrpt::opengl::CPointCloud::Create();
+			checkProjection(obs,*glPts,pp);
+		}
+}
+
+TEST(CObservation3DRangeScan, project3DPointsDecimatedClippedTransformed)
+{
+	const CPose3D robotPose(1,2,0,DEG2RAD(30),0,0);
+
+	for (int range_is_depth=0;range_is_depth<2;range_is_depth++)
+		for (unsigned int decimation=1;decimation<=3;decimation++)
+		{
+			CObservation3DRangeScan obs;
+			fillObservation(obs, range_is_depth!=0);
+
+			T3DPointsProjectionParams pp;
+			pp.decimation = decimation;
+			pp.minRange = 1.0f;
+			pp.maxRange = 3.5f;
+			pp.takeIntoAccountSensorPoseOnRobot = true;
+			pp.robotPoseInTheWorld = &robotPose;
+
+			CObservation3DRangeScan obsPts;
+			checkProjection(obs,obsPts,pp);
+			mrpt::opengl::CPointCloudPtr glPts = mrpt::opengl::CPointCloud::Create();
+			checkProjection(obs,*glPts,pp);
+
+			// Only an upper limit:
+			pp.minRange = 0;
+			checkProjection(obs,*glPts,pp);
+		}
+}
@@ -0,0 +1,678 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/obs.h>   // Precompiled headers
+
+#include <mrpt/slam/CPipelinedRawlogReader.h>
+#include <mrpt/slam/CIndexedRawlog.h>
+#include <mrpt/utils/CFileGZInputStream.h>
+#include <mrpt/utils/CMemoryStream.h>
+#include <mrpt/synch/CSemaphore.h>
+#include <mrpt/synch/CCriticalSection.h>
+#include <mrpt/synch/atomic_incr.h>
+#include <mrpt/system/threads.h>
+#include <mrpt/system/parallelization.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::synch;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	const unsigned int PIPELINE_POLL_MS = 100; //!< Period for checking whether the pipeline has been aborted while a thread is blocked
+
+	/** Waits for the semaphore, giving up if "aborted" becomes true. \return false if aborted */
+	bool waitOrAbort(CSemaphore &sem, const volatile bool &aborted)
+	{
+		while (!aborted)
+			if (sem.waitForSignal(PIPELINE_POLL_MS))
+				return true;
+		return false;
+	}
+
+	/** A FIFO of pointers with a fixed capacity: push() blocks while it is full and pop() while it is empty, unless the pipeline is aborted.
+	  *  The objects left in the queue upon destruction are deleted.
+	  */
+	template <class T>
+	class CBoundedPtrQueue
+	{
+	public:
+		CBoundedPtrQueue(const size_t capacity, const volatile bool &aborted) :
+			m_free(capacity,capacity), m_used(0,capacity), m_aborted(aborted)
+		{
+		}
+
+		~CBoundedPtrQueue()
+		{
+			for (size_t i=0;i<m_queue.size();i++)
+				delete m_queue[i];
+		}
+
+		/** \return false (and does not insert the object) if the pipeline was aborted */
+		bool push(T *obj)
+		{
+			if (!waitOrAbort(m_free,m_aborted)) return false;
+			{
+				CCriticalSectionLocker lock(&m_cs);
+				m_queue.push_back(obj);
+			}
+			m_used.release();
+			return true;
+		}
+
+		/** \return false if the pipeline was aborted */
+		bool pop(T *&obj)
+		{
+			if (!waitOrAbort(m_used,m_aborted)) return false;
+			{
+				CCriticalSectionLocker lock(&m_cs);
+				obj = m_queue.front();
+				m_queue.pop_front();
+			}
+			m_free.release();
+			return true;
+		}
+
+	private:
+		CSemaphore          m_free, m_used;
+		CCriticalSection    m_cs;
+		std::deque<T*>      m_queue;
+		const volatile bool &m_aborted;
+	};
+
+	typedef std::vector<unsigned char> TChunk;
+
+	/** A block of an indexed rawlog, as it goes through the pipeline */
+	struct TBlock
+	{
+		size_t               seq;          //!< Sequential number of the block in the file
+		size_t               first, last;  //!< The range [first,last) of indices of the entries in this block
+		uint64_t             offset;       //!< Position of the block in the file
+		uint32_t             uncompressed_len;
+		std::vector<unsigned char> compressed, data;
+	};
+
+	/** A read-only CStream over the chunks of data which arrive through a queue, until a NULL chunk is found */
+	class CChunkQueueInputStream : public CStream
+	{
+	public:
+		CChunkQueueInputStream(CBoundedPtrQueue<TChunk> &chunks) : m_chunks(chunks), m_cur(NULL), m_cur_pos(0), m_pos(0), m_eof(false) { }
+		virtual ~CChunkQueueInputStream() { delete m_cur; }
+
+		uint64_t Seek(uint64_t, CStream::TSeekOrigin = sFromBeginning) { THROW_EXCEPTION("This stream is not seekable") }
+		uint64_t getTotalBytesCount() { THROW_EXCEPTION("The size of this stream is unknown") }
+		uint64_t getPosition() { return m_pos; }
+
+	protected:
+		size_t Read(void *Buffer, size_t Count)
+		{
+			size_t done = 0;
+			while (done<Count)
+			{
+				if (!m_cur || m_cur_pos==m_cur->size())
+				{
+					delete m_cur;
+					m_cur = NULL;
+					m_cur_pos = 0;
+					if (m_eof || !m_chunks.pop(m_cur) || !m_cur)
+					{
+						m_cur = NULL;
+						m_eof = true;
+						break;
+					}
+				}
+				const size_t n = std::min(Count-done, m_cur->size()-m_cur_pos);
+				::memcpy(static_cast<unsigned char*>(Buffer)+done, &(*m_cur)[m_cur_pos], n);
+				m_cur_pos += n;
+				done += n;
+			}
+			m_pos += done;
+			return done;
+		}
+
+		size_t Write(const void *, size_t) { THROW_EXCEPTION("This stream is read-only") }
+
+	private:
+		CBoundedPtrQueue<TChunk> &m_chunks;
+		TChunk   *m_cur;     //!< The chunk being read, or NULL
+		size_t    m_cur_pos;
+		uint64_t  m_pos;
+		bool      m_eof;
+	};
+}
+
+/** The state of the pipeline shared by all its threads */
+struct CPipelinedRawlogReader::TImpl
+{
+	TImpl(const TOptions &opts, const size_t nThreads) :
+		options(opts),
+		num_threads(nThreads),
+		aborted(false),
+		own_stream(NULL),
+		in(NULL),
+		in_size(0),
+		in_position(0),
+		compressed_blocks(opts.max_pending,aborted),
+		raw_blocks(opts.max_pending,aborted),
+		chunks(opts.max_pending,aborted),
+		pending(opts.max_pending,opts.max_pending),
+		running_decompressors(0),
+		running_deserializers(0),
+		out_next_seq(0),
+		out_finished(false),
+		out_signal(0,0x7FFFFFFF)
+	{
+	}
+
+	/** Stops and waits for all the threads */
+	~TImpl()
+	{
+		aborted = true;
+		for (size_t i=0;i<threads.size();i++)
+			joinThread(threads[i]);
+		delete own_stream;
+	}
+
+	const TOptions         options;
+	const size_t           num_threads;
+	volatile bool          aborted;  //!< Set to true to stop all the threads
+
+	// Input:
+	CIndexedRawlogReader   indexed;     //!< For indexed rawlogs (only used by the I/O thread, once open)
+	CFileGZInputStream    *own_stream;  //!< Legacy rawlog files opened by us (or NULL)
+	CStream               *in;          //!< The input stream, for legacy rawlogs
+	uint64_t               in_size;
+	uint64_t               in_position;  //!< Protected by out_cs
+
+	// Bounded queues between stages:
+	CBoundedPtrQueue<TBlock>  compressed_blocks; //!< I/O -> decompression (indexed rawlogs). A NULL means the end of the file.
+	CBoundedPtrQueue<TBlock>  raw_blocks;        //!< decompression -> deserialization (indexed rawlogs). A NULL means the end of the file.
+	CBoundedPtrQueue<TChunk>  chunks;            //!< I/O+decompression -> deserialization (legacy rawlogs). A NULL means the end of the file.
+	CSemaphore  pending;  //!< Limits the number of blocks or objects which are being decoded or waiting for the consumer
+
+	CAtomicCounter  running_decompressors, running_deserializers;
+
+	// Output: decoded batches of objects, indexed by their sequence number:
+	CCriticalSection  out_cs;
+	std::map<size_t,std::vector<CSerializablePtr> >  out_batches;
+	size_t            out_next_seq;  //!< The next batch to be delivered (when ordered)
+	bool              out_finished;  //!< All the batches have been already decoded (or the pipeline was aborted)
+	std::string       out_error;     //!< Empty, or the description of the first error found while decoding
+	CSemaphore        out_signal;    //!< Signaled when a new batch is decoded and when the pipeline finishes
+
+	CCriticalSection                 consumer_cs;
+	std::deque<CSerializablePtr>     current;  //!< The objects already decoded and not yet returned to the user
+
+	std::vector<TThreadHandle>  threads;
+
+	void setInputPosition(const uint64_t pos)
+	{
+		CCriticalSectionLocker lock(&out_cs);
+		in_position = pos;
+	}
+
+	/** Records an error, which is reported to the user once all the data read before it has been decoded and returned */
+	void recordError(const std::string &msg)
+	{
+		CCriticalSectionLocker lock(&out_cs);
+		if (out_error.empty()) out_error = msg;
+	}
+
+	/** Records an error and stops the pipeline */
+	void onError(const std::string &msg)
+	{
+		recordError(msg);
+		aborted = true;
+	}
+
+	void deliverBatch(const size_t seq, std::vector<CSerializablePtr> &objs)
+	{
+		{
+			CCriticalSectionLocker lock(&out_cs);
+			out_batches[seq].swap(objs);
+		}
+		out_signal.release();
+	}
+
+	void finish()
+	{
+		{
+			CCriticalSectionLocker lock(&out_cs);
+			out_finished = true;
+		}
+		out_signal.release();
+	}
+
+	/** Moves the next batch into "current". \return false at the end of the file \exception std::exception On decoding errors */
+	bool takeNextBatch()
+	{
+		for (;;)
+		{
+			{
+				CCriticalSectionLocker lock(&out_cs);
+				std::map<size_t,std::vector<CSerializablePtr> >::iterator it = options.ordered ? out_batches.find(out_next_seq) : out_batches.begin();
+				if (it!=out_batches.end())
+				{
+					current.insert(current.end(), it->second.begin(), it->second.end());
+					out_batches.erase(it);
+					out_next_seq++;
+					pending.release();
+					return true;
+				}
+				if (out_finished)
+				{
+					if (!out_error.empty())
+						THROW_EXCEPTION_CUSTOM_MSG1("Error decoding rawlog: %s",out_error.c_str())
+					return false;
+				}
+			}
+			out_signal.waitForSignal(PIPELINE_POLL_MS);
+		}
+	}
+
+	// ------------ Indexed rawlogs ------------
+	static void threadReadBlocks(TImpl *d)
+	{
+		const std::vector<TIndexedRawlogEntry> &idx = d->indexed.getIndex();
+		try
+		{
+			size_t seq = 0;
+			for (size_t i=0;i<idx.size(); )
+			{
+				// All the entries in one block are consecutive:
+				size_t j = i+1;
+				while (j<idx.size() && idx[j].blockOffset==idx[i].blockOffset)
+					j++;
+
+				if (!waitOrAbort(d->pending,d->aborted)) break;
+
+				TBlock *b = new TBlock;
+				b->seq    = seq++;
+				b->first  = i;
+				b->last   = j;
+				b->offset = idx[i].blockOffset;
+				try
+				{
+					d->indexed.readCompressedBlock(b->offset,b->compressed,b->uncompressed_len);
+				}
+				catch (std::exception &)
+				{
+					delete b;
+					throw;
+				}
+				d->setInputPosition(b->offset);
+
+				if (!d->compressed_blocks.push(b))
+				{
+					delete b;
+					break;
+				}
+				i = j;
+			}
+			d->setInputPosition(d->in_size);
+		}
+		catch (std::exception &e)
+		{
+			// The blocks already read are still decoded:
+			d->recordError(e.what());
+		}
+		for (size_t k=0;k<d->num_threads;k++)
+			d->compressed_blocks.push(NULL);
+	}
+
+	static void threadDecompressBlocks(TImpl *d)
+	{
+		TBlock *b;
+		while (d->compressed_blocks.pop(b) && b)
+		{
+			try
+			{
+				CIndexedRawlogReader::decompressBlock(b->compressed,b->uncompressed_len,b->data);
+				std::vector<unsigned char>().swap(b->compressed);
+			}
+			catch (std::exception &e)
+			{
+				delete b;
+				d->onError(e.what());
+				break;
+			}
+			if (!d->raw_blocks.push(b))
+			{
+				delete b;
+				break;
+			}
+		}
+		if (--d->running_decompressors==0)
+			for (size_t k=0;k<d->num_threads;k++)
+				d->raw_blocks.push(NULL);
+	}
+
+	static void threadDeserializeBlocks(TImpl *d)
+	{
+		const std::vector<TIndexedRawlogEntry> &idx = d->indexed.getIndex();
+		TBlock *b;
+		while (d->raw_blocks.pop(b) && b)
+		{
+			std::vector<CSerializablePtr> objs(b->last-b->first);
+			try
+			{
+				for (size_t k=0;k<objs.size();k++)
+				{
+					const uint32_t off = idx[b->first+k].offsetInBlock;
+					ASSERT_(off<b->data.size())
+					CMemoryStream mem;
+					mem.assignMemoryNotOwn(&b->data[off], b->data.size()-off);
+					objs[k] = mem.ReadObject();
+				}
+			}
+			catch (std::exception &e)
+			{
+				delete b;
+				d->onError(e.what());
+				break;
+			}
+			d->deliverBatch(b->seq,objs);
+			delete b;
+		}
+		if (--d->running_deserializers==0)
+			d->finish();
+	}
+
+	// ------------ Legacy rawlogs ------------
+	/** Whether the whole stream has been read */
+	static bool isEndOfStream(CStream *in)
+	{
+		CFileGZInputStream *gz = dynamic_cast<CFileGZInputStream*>(in);
+		if (gz) return gz->checkEOF();
+		try
+		{
+			return in->getPosition()>=in->getTotalBytesCount();
+		}
+		catch (std::exception &)
+		{
+			return false;
+		}
+	}
+
+	static void threadReadChunks(TImpl *d)
+	{
+		while (!d->aborted)
+		{
+			TChunk *chunk = new TChunk(d->options.chunk_size);
+			size_t n = 0;
+			try
+			{
+				n = d->in->ReadBuffer(&(*chunk)[0],chunk->size());
+			}
+			catch (std::exception &e)
+			{
+				// ReadBuffer() also throws when there is nothing left to read: any other error ends the input, and is reported to the
+				//  user after the chunks already read are decoded.
+				if (!isEndOfStream(d->in))
+				{
+					delete chunk;
+					d->recordError(e.what());
+					break;
+				}
+			}
+			if (!n)
+			{
+				delete chunk;
+				break;
+			}
+			chunk->resize(n);
+			d->setInputPosition(d->in->getPosition());
+			if (!d->chunks.push(chunk))
+			{
+				delete chunk;
+				break;
+			}
+		}
+		d->chunks.push(NULL);
+	}
+
+	static void threadDeserializeChunks(TImpl *d)
+	{
+		CChunkQueueInputStream  s(d->chunks);
+		try
+		{
+			for (size_t seq=0; ;seq++)
+			{
+				if (!waitOrAbort(d->pending,d->aborted)) break;
+
+				std::vector<CSerializablePtr> objs(1);
+				try
+				{
+					s >> objs[0];
+				}
+				catch (CExceptionEOF &)
+				{
+					break;
+				}
+				d->deliverBatch(seq,objs);
+			}
+		}
+		catch (std::exception &e)
+		{
+			d->onError(e.what());
+		}
+		d->finish();
+	}
+};
+
+/*---------------------------------------------------------------
+						TOptions
+  ---------------------------------------------------------------*/
+CPipelinedRawlogReader::TOptions::TOptions() :
+	num_threads(0),
+	max_pending(16),
+	chunk_size(1<<20),
+	ordered(true)
+{
+}
+
+CPipelinedRawlogReader::CPipelinedRawlogReader() : m_impl(NULL)
+{
+}
+
+CPipelinedRawlogReader::CPipelinedRawlogReader(const std::string &fileName, const TOptions &options) : m_impl(NULL)
+{
+	if (!open(fileName,options))
+		THROW_EXCEPTION_CUSTOM_MSG1("Error opening rawlog file: '%s'",fileName.c_str())
+}
+
+CPipelinedRawlogReader::~CPipelinedRawlogReader()
+{
+	close();
+}
+
+void CPipelinedRawlogReader::close()
+{
+	delete m_impl;
+	m_impl = NULL;
+}
+
+/*---------------------------------------------------------------
+						open
+  ---------------------------------------------------------------*/
+bool CPipelinedRawlogReader::open(const std::string &fileName, const TOptions &options)
+{
+	MRPT_START
+	close();
+	ASSERT_(options.max_pending>0 && options.chunk_size>0)
+
+	if (CIndexedRawlogReader::isIndexedRawlogFile(fileName))
+	{
+		const size_t nThreads = options.num_threads ? options.num_threads : std::max(1U,getParallelizationThreadsCount());
+		TImpl *d = new TImpl(options,nThreads);
+		if (!d->indexed.open(fileName))
+		{
+			delete d;
+			return false;
+		}
+		d->in_size = getFileSize(fileName);
+		m_impl = d;
+
+		for (size_t i=0;i<nThreads;i++) ++d->running_decompressors;
+		for (size_t i=0;i<nThreads;i++) ++d->running_deserializers;
+
+		d->threads.push_back( createThread(&TImpl::threadReadBlocks, d) );
+		for (size_t i=0;i<nThreads;i++)
+			d->threads.push_back( createThread(&TImpl::threadDecompressBlocks, d) );
+		for (size_t i=0;i<nThreads;i++)
+			d->threads.push_back( createThread(&TImpl::threadDeserializeBlocks, d) );
+		return true;
+	}
+
+	// Legacy rawlog:
+	CFileGZInputStream *fil = new CFileGZInputStream();
+	if (!fil->open(fileName))
+	{
+		delete fil;
+		return false;
+	}
+	open(*fil,options);
+	m_impl->own_stream = fil;
+	return true;
+	MRPT_END
+}
+
+void CPipelinedRawlogReader::open(CStream &in, const TOptions &options)
+{
+	MRPT_START
+	close();
+	ASSERT_(options.max_pending>0 && options.chunk_size>0)
+
+	TImpl *d = new TImpl(options,1);
+	d->in      = &in;
+	d->in_size = in.getTotalBytesCount();
+	d->in_position = in.getPosition();
+	m_impl = d;
+
+	d->threads.push_back( createThread(&TImpl::threadReadChunks, d) );
+	d->threads.push_back( createThread(&TImpl::threadDeserializeChunks, d) );
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+						getNextObject
+  ---------------------------------------------------------------*/
+bool CPipelinedRawlogReader::getNextObject(CSerializablePtr &obj)
+{
+	ASSERTMSG_(m_impl!=NULL, "The reader is not open")
+
+	CCriticalSectionLocker lock(&m_impl->consumer_cs);
+	while (m_impl->current.empty())
+		if (!m_impl->takeNextBatch())
+			return false;
+
+	obj = m_impl->current.front();
+	m_impl->current.pop_front();
+	return true;
+}
+
+/*---------------------------------------------------------------
+				getActionObservationPairOrObservation
+  ---------------------------------------------------------------*/
+bool CPipelinedRawlogReader::getActionObservationPairOrObservation(
+	CActionCollectionPtr &action,
+	CSensoryFramePtr     &observations,
+	CObservationPtr      &observation,
+	size_t               &rawlogEntry )
+{
+	try
+	{
+		observations.clear_unique();
+		observation.clear_unique();
+		action.clear_unique();
+
+		CSerializablePtr obj;
+		while (!action)
+		{
+			if (!getNextObject(obj)) return false;
+			if (IS_CLASS(obj,CActionCollection))
+				action = CActionCollectionPtr(obj);
+			else if (IS_DERIVED(obj,CObservation))
+			{
+				observation = CObservationPtr(obj);
+				rawlogEntry++;
+				return true;
+			}
+			rawlogEntry++;
+		}
+
+		while (!observations)
+		{
+			if (!getNextObject(obj)) return false;
+			if (IS_CLASS(obj,CSensoryFrame))
+				observations = CSensoryFramePtr(obj);
+			rawlogEntry++;
+		}
+		return true;
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "[CPipelinedRawlogReader::getActionObservationPairOrObservation] Found exception:" << std::endl << e.what() << std::endl;
+		return false;
+	}
+}
+
+/*---------------------------------------------------------------
+					readActionObservationPair
+  ---------------------------------------------------------------*/
+bool CPipelinedRawlogReader::readActionObservationPair(
+	CActionCollectionPtr &action,
+	CSensoryFramePtr     &observations,
+	size_t               &rawlogEntry )
+{
+	try
+	{
+		action.clear_unique();
+		observations.clear_unique();
+
+		CSerializablePtr obj;
+		while (!action)
+		{
+			if (!getNextObject(obj)) return false;
+			if (IS_CLASS(obj,CActionCollection))
+				action = CActionCollectionPtr(obj);
+			rawlogEntry++;
+		}
+
+		while (!observations)
+		{
+			if (!getNextObject(obj)) return false;
+			if (IS_CLASS(obj,CSensoryFrame))
+				observations = CSensoryFramePtr(obj);
+			rawlogEntry++;
+		}
+		return true;
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "[CPipelinedRawlogReader::readActionObservationPair] Found exception:" << std::endl << e.what() << std::endl;
+		return false;
+	}
+}
+
+uint64_t CPipelinedRawlogReader::getInputPosition() const
+{
+	if (!m_impl) return 0;
+	CCriticalSectionLocker lock(&m_impl->out_cs);
+	return m_impl->in_position;
+}
+
+uint64_t CPipelinedRawlogReader::getInputSize() const
+{
+	return m_impl ? m_impl->in_size : 0;
+}
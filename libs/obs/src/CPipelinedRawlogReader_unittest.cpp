@@ -0,0 +1,199 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+
+#include <mrpt/obs.h>
+#include <mrpt/base.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+const size_t     NUM_ENTRIES = 500;
+const TTimeStamp T0 = 1000000;
+
+// Entries are (action,SF) pairs or single observations, all with consecutive timestamps:
+void writeTestRawlog(CStream &out)
+{
+	for (size_t i=0;i<NUM_ENTRIES;i++)
+	{
+		if ((i%10)==5)
+		{
+			CActionCollection acts;
+			out << acts;
+			CSensoryFrame  sf;
+			CObservationCommentPtr o = CObservationComment::Create();
+			o->timestamp = T0+i;
+			sf.insert(o);
+			out << sf;
+		}
+		else
+		{
+			CObservation2DRangeScan  o;
+			o.timestamp = T0+i;
+			o.scan.assign(50+i%100,static_cast<float>(i));
+			o.validRange.assign(o.scan.size(),1);
+			out << o;
+		}
+	}
+}
+
+void checkPipelinedRead(const string &fil, const CPipelinedRawlogReader::TOptions &opts)
+{
+	CPipelinedRawlogReader  in;
+	ASSERT_TRUE(in.open(fil,opts));
+
+	CActionCollectionPtr action;
+	CSensoryFramePtr     SF;
+	CObservationPtr      obs;
+	size_t               rawlogEntry = 0;
+
+	vector<TTimeStamp> ts;
+	while (in.getActionObservationPairOrObservation(action,SF,obs,rawlogEntry))
+	{
+		if (obs)
+		{
+			ASSERT_TRUE(IS_CLASS(obs,CObservation2DRangeScan));
+			EXPECT_EQ(CObservation2DRangeScanPtr(obs)->scan.size(), 50+(obs->timestamp-T0)%100);
+			ts.push_back(obs->timestamp);
+		}
+		else
+		{
+			ASSERT_TRUE(action.present() && SF.present());
+			ASSERT_EQ(SF->size(),1u);
+			ts.push_back(SF->getObservationByIndex(0)->timestamp);
+		}
+	}
+	ASSERT_EQ(ts.size(),NUM_ENTRIES);
+	for (size_t i=0;i<NUM_ENTRIES;i++)
+		EXPECT_EQ(ts[i],TTimeStamp(T0+i));
+}
+
+TEST(CPipelinedRawlogReader, LegacyGZFile)
+{
+	const string fil = mrpt::system::getTempFileName();
+	{
+		CFileGZOutputStream  out(fil);
+		writeTestRawlog(out);
+	}
+
+	CPipelinedRawlogReader::TOptions opts;
+	checkPipelinedRead(fil,opts);
+
+	// Many small chunks and a short queue:
+	opts.chunk_size  = 100;
+	opts.max_pending = 2;
+	checkPipelinedRead(fil,opts);
+
+	remove(fil.c_str());
+}
+
+TEST(CPipelinedRawlogReader, IndexedFile)
+{
+	const string fil = mrpt::system::getTempFileName();
+	{
+		CMemoryStream  buf;
+		writeTestRawlog(buf);
+		buf.Seek(0);
+
+		CIndexedRawlogWriter  out(fil, 2048);
+		for (size_t i=0;i<NUM_ENTRIES+NUM_ENTRIES/10;i++)
+			out.write(buf.ReadObject());
+	}
+
+	CPipelinedRawlogReader::TOptions opts;
+	opts.num_threads = 3;
+	checkPipelinedRead(fil,opts);
+
+	opts.max_pending = 1;
+	checkPipelinedRead(fil,opts);
+
+	// Unordered: all the objects must be returned, in any order:
+	opts.ordered     = false;
+	opts.max_pending = 8;
+	CPipelinedRawlogReader  in(fil,opts);
+	size_t nObjs = 0;
+	CSerializablePtr obj;
+	while (in.getNextObject(obj))
+		nObjs++;
+	EXPECT_EQ(nObjs, NUM_ENTRIES+NUM_ENTRIES/10);
+
+	// Closing before reaching the end must stop all the threads:
+	opts.ordered = true;
+	in.open(fil,opts);
+	ASSERT_TRUE(in.getNextObject(obj));
+	in.close();
+
+	remove(fil.c_str());
+}
+
+// A stream which fails (instead of reaching its end) after some bytes:
+class CFailingStream : public CMemoryStream
+{
+public:
+	CFailingStream(const size_t failAt) : m_failAt(failAt) { }
+protected:
+	size_t Read(void *Buffer, size_t Count)
+	{
+		if (getPosition()+Count>m_failAt)
+			THROW_EXCEPTION("Simulated read error")
+		return CMemoryStream::Read(Buffer,Count);
+	}
+private:
+	size_t m_failAt;
+};
+
+TEST(CPipelinedRawlogReader, ReadErrorsAreNotEndOfFile)
+{
+	const size_t failAt = 5000;
+	CFailingStream  buf(failAt);
+	writeTestRawlog(buf);
+	buf.Seek(0);
+
+	// The objects entirely within the data read before the error:
+	size_t nComplete = 0;
+	{
+		CMemoryStream  mem;
+		writeTestRawlog(mem);
+		mem.Seek(0);
+		for (;;)
+		{
+			mem.ReadObject();
+			if (mem.getPosition()>failAt) break;
+			nComplete++;
+		}
+	}
+
+	CPipelinedRawlogReader::TOptions opts;
+	opts.chunk_size = 1000;
+	CPipelinedRawlogReader  in;
+	in.open(buf,opts);
+
+	size_t nObjs = 0;
+	bool   failed = false;
+	CSerializablePtr obj;
+	try
+	{
+		while (in.getNextObject(obj))
+			nObjs++;
+	}
+	catch (std::exception &e)
+	{
+		failed = true;
+		EXPECT_TRUE(string(e.what()).find("Simulated read error")!=string::npos);
+	}
+	EXPECT_TRUE(failed);
+	EXPECT_LT(nObjs, NUM_ENTRIES);
+	// They are all returned before the error, even if the error is found while they are still being decoded:
+	EXPECT_EQ(nObjs, nComplete);
+	in.close();
+}
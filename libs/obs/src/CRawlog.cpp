@@ -11,6 +11,7 @@
 
 #include <mrpt/system/filesystem.h>
 #include <mrpt/slam/CRawlog.h>
+#include <mrpt/slam/CPipelinedRawlogReader.h>
 #include <mrpt/utils/CFileInputStream.h>
 #include <mrpt/utils/CFileGZInputStream.h>
 #include <mrpt/utils/CFileGZOutputStream.h>
@@ -277,9 +278,10 @@ bool  CRawlog::loadFromRawLogFile( const std::string &fileName )
 
 	m_commentTexts.text.clear();
 
-	CFileGZInputStream		fs(fileName);
+	// Objects are decoded in background threads, for both legacy and indexed rawlog files:
+	CPipelinedRawlogReader  fs;
 
-	if (!fs.fileOpenCorrectly()) return false;
+	if (!fs.open(fileName)) return false;
 
 	// Clear first:
 	clear();
@@ -290,7 +292,8 @@ bool  CRawlog::loadFromRawLogFile( const std::string &fileName )
 		CSerializablePtr newObj;
 		try
 		{
-			fs >> newObj;
+			if (!fs.getNextObject(newObj))
+				break;  // EOF
             // Check type:
 			if ( newObj->GetRuntimeClass() == CLASS_ID(CRawlog))
         	{
@@ -67,8 +67,7 @@ bool mrpt::slam::carmen_log_parse_line(
 		size_t nRanges;
 		S >> nRanges;
 
-		obsLaser->scan.resize(nRanges);
-		obsLaser->validRange.resize(nRanges);
+		obsLaser->resizeScan(nRanges);
 
 		for(size_t i=0;i<nRanges;i++)
 		{
@@ -164,8 +163,7 @@ bool mrpt::slam::carmen_log_parse_line(
 			obsLaser->aperture = DEG2RAD(resolutionDeg) * nRanges;
 		}
 
-		obsLaser->scan.resize(nRanges);
-		obsLaser->validRange.resize(nRanges);
+		obsLaser->resizeScan(nRanges);
 
 		for(size_t i=0;i<nRanges;i++)
 		{
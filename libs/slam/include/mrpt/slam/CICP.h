@@ -26,7 +26,9 @@ namespace mrpt
 		{
 			icpClassic = 0,
 			icpLevenbergMarquardt,
-			icpIKF
+			icpIKF,
+			icpPointToPlane, //!< 3D only: minimizes the distances from each point to the tangent plane of its correspondence in the reference map
+			icpGICP          //!< 3D only: Generalized-ICP (Segal et al., RSS 2009), a plane-to-plane metric from the local covariances of both point clouds
 		};
 
 		/** Several implementations of ICP (Iterative closest point) algorithms for aligning two point maps or a point map wrt a grid map.
@@ -142,6 +144,24 @@ namespace mrpt
 				  */
 				uint32_t        corresponding_points_decimation;
 
+				/** For icpPointToPlane and icpGICP: the number of neighbors used to estimate the normal of each point (default=10).
+				  * \sa CPointsMap::getLocalShapes */
+				uint32_t        local_shape_knn;
+
+				/** For icpGICP: the variance of the points along their normal direction, relative to the variance along the tangent plane (default=1e-3) */
+				float           GICP_epsilon;
+
+				/** @name Multi-resolution (coarse-to-fine) alignment
+				    @{ */
+				/** Number of levels of the voxel-grid pyramid (default=1: disabled). With N>1 levels, both maps are first aligned after decimating them
+				  *  with voxels of size pyramid_voxel_size*2^(N-2), then with half that size, and so on, and finally the original maps are aligned starting
+				  *  from the result of the coarser levels and with a correspondence threshold of the order of the finest voxel size.
+				  *  The decimated maps (and their KD-trees) are cached in the maps until they are modified. Only used if both maps are point maps.
+				  * \sa CPointsMap::getVoxelDownsampled */
+				uint32_t        pyramid_levels;
+				float           pyramid_voxel_size; //!< The voxel size of the finest decimated level of the pyramid (default=0.10m) \sa pyramid_levels
+				/** @} */
+
 			};
 
 			TConfigParams  options; //!< The options employed by the ICP align.
@@ -243,6 +263,18 @@ namespace mrpt
 			  */
 			float kernel(const float &x2, const float &rho2);
 
+			/** Aligns the coarse levels of the voxel-grid pyramids of both maps (see TConfigParams::pyramid_levels), from the coarsest to the finest one.
+			  * \param inOutEstimation [IN/OUT] The initial estimation, replaced by the result of the finest decimated level.
+			  * \param outThresholdDist [OUT] The correspondence threshold to use for the full-resolution maps (unmodified if no level was aligned).
+			  * \return The number of ICP iterations run at all the coarse levels.
+			  */
+			unsigned int alignCoarseLevels(
+					const CMetricMap	*m1,
+					const CMetricMap	*m2,
+					CPose3D				&inOutEstimation,
+					float				&outThresholdDist,
+					const bool			is3D );
+
 			/** The internal method implementing CICP::AlignPDF when options.ICP_algorithm is icpClassic.
 			  */
 			CPosePDFPtr ICP_Method_Classic(
@@ -267,7 +299,7 @@ namespace mrpt
 					const CPosePDFGaussian	&initialEstimationPDF,
 					TReturnInfo				&outInfo );
 
-			/** The internal method implementing CICP::Align3DPDF when options.ICP_algorithm is icpClassic.
+			/** The internal method implementing CICP::Align3DPDF when options.ICP_algorithm is icpClassic, icpPointToPlane or icpGICP.
 			  */
 			CPose3DPDFPtr ICP3D_Method_Classic(
 					const CMetricMap		*m1,
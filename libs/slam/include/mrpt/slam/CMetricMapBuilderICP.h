@@ -11,7 +11,10 @@
 
 #include <mrpt/slam/CMetricMapBuilder.h>
 #include <mrpt/slam/CICP.h>
+#include <mrpt/slam/CSimplePointsMap.h>
 #include <mrpt/poses/CRobot2DPoseEstimator.h>
+#include <mrpt/synch/CSemaphore.h>
+#include <mrpt/system/threads.h>
 
 #include <mrpt/slam/link_pragmas.h>
 
@@ -23,6 +26,12 @@ namespace slam
 	/** A class for very simple 2D SLAM based on ICP. This is a non-probabilistic pose tracking algorithm.
 	 *   Map are stored as in files as binary dumps of "mrpt::slam::CSimpleMap" objects. The methods are
 	 *	 thread-safe.
+	 *
+	 *  By default, each new scan is aligned against the whole points map built so far, so the cost of ICP and the memory grow without bound
+	 *   in long runs. If any of TConfigParams::localMapMaxDistance, TConfigParams::localMapMaxAge or TConfigParams::localMapMaxKeyframes is set,
+	 *   scans are instead aligned against a sliding-window "local map" with the points of the latest keyframes only, and the global metric map
+	 *   (returned by getCurrentlyBuiltMetricMap()) is updated with the keyframes in a background thread.
+	 *   See TConfigParams::localMapMaxDistance for the details.
 	 * \ingroup metric_slam_grp
 	 */
 	class SLAM_IMPEXP  CMetricMapBuilderICP : public CMetricMapBuilder
@@ -57,6 +66,22 @@ namespace slam
 
 			double minICPgoodnessToAccept;  //!< Minimum ICP goodness (0,1) to accept the resulting corrected position (default: 0.40)
 
+			/** (default:0=disabled) If >0, scans are aligned against a sliding-window local map with only those keyframes (inserted observations) closer
+			  *  than this distance (m) to the current robot pose, instead of against the whole map.
+			  *  The points of the keyframes are kept in the local map as a ring buffer, oldest first: a keyframe is removed from the window when it, or any older one,
+			  *  violates any of localMapMaxDistance, localMapMaxAge or localMapMaxKeyframes (the latest keyframe is always kept). To avoid rebuilding
+			  *  the KD-tree of the local map for each removed keyframe, their points are actually deleted in batches, once they are as many as those of the keyframes
+			  *  in the window, so the size of the local map (and the cost of ICP) is bounded to twice that of the window.
+			  *  With a local map, the global map is updated asynchronously, so the time per scan does not depend on its size.
+			  *  It's ignored if matchAgainstTheGrid=true.
+			  */
+			double localMapMaxDistance;
+			double localMapMaxAge;        //!< (default:0=disabled) If >0, the maximum age (s) of the keyframes in the sliding-window local map. See localMapMaxDistance
+			unsigned int localMapMaxKeyframes; //!< (default:0=disabled) If >0, the maximum number of keyframes in the sliding-window local map. See localMapMaxDistance
+
+			/** Returns true if scans are aligned against a sliding-window local map (see localMapMaxDistance) */
+			bool useLocalMap() const { return !matchAgainstTheGrid && (localMapMaxDistance>0 || localMapMaxAge>0 || localMapMaxKeyframes>0); }
+
 			/** What maps to create (at least one points map and/or a grid map are needed).
 			  *  For the expected format in the .ini file when loaded with loadFromConfigFile(), see documentation of TSetOfMetricMapInitializers.
 			  */
@@ -106,14 +131,24 @@ namespace slam
 		void  getCurrentlyBuiltMap(CSimpleMap &out_map) const;
 
 
-		 /** Returns the 2D points of current local map
+		 /** Returns the 2D points of current map (the global one, also if a sliding-window local map is being used, see TConfigParams::localMapMaxDistance)
 		   */
 		void  getCurrentMapPoints( std::vector<float> &x, std::vector<float> &y);
 
 		/** Returns the map built so far. NOTE that for efficiency a pointer to the internal object is passed, DO NOT delete nor modify the object in any way, if desired, make a copy of ir with "duplicate()".
+		  *  If the global map is being updated in the background (see TConfigParams::localMapMaxDistance), this waits for all pending keyframes to be inserted,
+		  *  and the map must not be accessed while calling processObservation() from other thread.
 		  */
 		CMultiMetricMap*   getCurrentlyBuiltMetricMap();
 
+		/** Returns the sliding-window local map against which scans are aligned (only if TConfigParams::useLocalMap()), including the points of removed
+		  *  keyframes not deleted yet. Same caveats than getCurrentlyBuiltMetricMap() apply.
+		  */
+		const CSimplePointsMap & getCurrentLocalMap() const { return m_localMap; }
+
+		/** Returns the number of keyframes in the sliding-window local map (see TConfigParams::localMapMaxDistance) */
+		size_t getCurrentLocalMapKeyframeCount() const { return m_localKeyframes.size(); }
+
 		/** Returns just how many sensory-frames are stored in the currently build map.
 		  */
 		unsigned int  getCurrentlyBuiltMapSize();
@@ -164,6 +199,44 @@ namespace slam
 		void accumulateRobotDisplacementCounters(const CPose2D & new_pose);
 		void resetRobotDisplacementCounters(const CPose2D & new_pose);
 
+		/** @name Sliding-window local map (see TConfigParams::localMapMaxDistance)
+		    @{ */
+		struct SLAM_IMPEXP TLocalKeyframe
+		{
+			mrpt::math::TPose2D       pose;
+			mrpt::system::TTimeStamp  timestamp;
+			size_t                    nPoints;  //!< Number of points of this keyframe in m_localMap
+		};
+		CSimplePointsMap            m_localMap;       //!< The points of the keyframes in m_localKeyframes, in the same order, preceded by m_localMapEvicted points of removed ones.
+		std::deque<TLocalKeyframe>  m_localKeyframes; //!< The keyframes in the local map, oldest first.
+		size_t                      m_localMapEvicted;//!< Number of points at the beginning of m_localMap from removed keyframes, which are deleted in batches.
+
+		void insertIntoLocalMap(const CObservationPtr &obs, const CPose2D &pose);
+		void updateLocalMapWindow(const CPose2D &currentPose, const mrpt::system::TTimeStamp currentTime);
+		/** @} */
+
+		/** @name Asynchronous update of the global map (only if TConfigParams::useLocalMap())
+		    @{ */
+		struct SLAM_IMPEXP TPendingInsertion
+		{
+			CObservationPtr      obs;
+			mrpt::math::TPose2D  pose;
+		};
+		std::deque<TPendingInsertion>  m_pendingInsertions;   //!< Keyframes to be inserted in metricMap by the background thread.
+		size_t                         m_pendingInsertionsCount; //!< Keyframes queued or being inserted right now.
+		mrpt::synch::CCriticalSection  m_pendingInsertions_cs;
+		mrpt::synch::CSemaphore        m_pendingInsertions_sem; //!< Signaled once per queued keyframe, and to exit the thread.
+		size_t                         m_globalMapWaiters;      //!< Threads blocked in waitForGlobalMapUpdates() (protected by m_pendingInsertions_cs).
+		mrpt::synch::CSemaphore        m_globalMapUpdated_sem;  //!< Signaled once per waiting thread when all the queued keyframes have been inserted.
+		mrpt::system::TThreadHandle    m_globalMapThread;
+		volatile bool                  m_globalMapThread_exit;
+
+		void thread_updateGlobalMap();
+		void enqueueGlobalMapInsertion(const CObservationPtr &obs, const CPose2D &pose);
+		void waitForGlobalMapUpdates(); //!< Blocks until all queued keyframes have been inserted into metricMap.
+		void stopGlobalMapThread();
+		/** @} */
+
 	};
 
 	} // End of namespace
@@ -131,7 +131,7 @@ namespace mrpt
 			void PF_SLAM_implementation_replaceByNewParticleSet(
 				CParticleList	&old_particles,
 				const std::vector<TPose3D>	&newParticles,
-				const vector_double		&newParticlesWeight,
+				const std::vector<double>	&newParticlesWeight,
 				const std::vector<size_t>	&newParticlesDerivedFromIdx )  const;
 
 			/** Evaluate the observation likelihood for one particle at a given location */
@@ -140,6 +140,14 @@ namespace mrpt
 				const size_t			particleIndexForMap,
 				const CSensoryFrame		&observation,
 				const CPose3D			&x ) const;
+
+			/** Evaluate the observation likelihood for all the particles at once: if there is only one map for all the particles,
+			  *  it uses CMetricMap::computeObservationLikelihoodForPoses(), which evaluates grid maps in parallel. */
+			void PF_SLAM_computeObservationLikelihoodForParticles(
+				const CParticleFilter::TParticleFilterOptions	&PF_options,
+				const CSensoryFrame		&observation,
+				const std::vector<TPose3D>	&x,
+				vector_double			&out_log_liks ) const;
 			/** @} */
 
 
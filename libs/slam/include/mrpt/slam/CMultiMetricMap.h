@@ -191,6 +191,10 @@ namespace slam
 		// See docs in base class
 		double	 computeObservationLikelihood( const CObservation *obs, const CPose3D &takenFrom );
 
+		/** Computes the log-likelihood of an observation for a set of robot poses, as the sum of the batch evaluations of each inner map.
+		  * \sa CMetricMap::computeObservationLikelihoodForPoses */
+		void computeObservationLikelihoodForPoses( const CObservation *obs, const std::vector<mrpt::math::TPose3D> &takenFrom, vector_double &out_log_liks );
+
 		/** Returns the ratio of points in a map which are new to the point map while falling into yet static cells of gridmap.
 		  * \param points The set of points to check.
 		  * \param takenFrom The pose for the reference system of points, in global coordinates of this hybrid map.
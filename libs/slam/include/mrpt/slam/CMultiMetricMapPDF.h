@@ -18,6 +18,7 @@
 
 #include <mrpt/bayes/CParticleFilterCapable.h>
 #include <mrpt/utils/CLoadableOptions.h>
+#include <mrpt/utils/CTimeLogger.h>
 #include <mrpt/slam/CICP.h>
 
 #include <mrpt/slam/PF_implementations_data.h>
@@ -200,6 +201,9 @@ namespace slam
 		size_t  getNumberOfObservationsInSimplemap() const { return SFs.size(); }
 
 		/** Insert an observation to the map, at each particle's pose and to each particle's metric map.
+		  *  The maps of the different particles are updated in parallel (see mrpt::system::parallel_for), unless they include maps
+		  *  which use the global random generator or other shared state (CBeaconMap, CLandmarksMap): those are updated sequentially, so the
+		  *  results never depend on the number of threads.
 		  * \param sf The SF to be inserted
 		  */
 		void  insertObservation(CSensoryFrame	&sf);
@@ -229,7 +233,19 @@ namespace slam
 		  */
 		float						newInfoIndex;
 
+		/** The profiler where the time spent updating the particles' maps and weights is logged, under the
+		  *  sections "CMultiMetricMapPDF.insertObservation" and "CMultiMetricMapPDF.computeObservationLikelihoodForParticles".
+		  *  It's disabled by default: call getTimeLogger().enable() to collect these stats.
+		  */
+		mrpt::utils::CTimeLogger & getTimeLogger() const { return m_timeLogger; }
+
 	 private:
+		mutable mrpt::utils::CTimeLogger	m_timeLogger; //!< See getTimeLogger()
+
+		/** Whether the maps of the particles can be updated or evaluated in parallel: not if any of them uses the global (not thread-safe)
+		  *  mrpt::random::randomGenerator or other static data, as the Monte-Carlo beacons of CBeaconMap or the descriptor distances cache of CLandmarksMap. */
+		bool  canProcessParticlesInParallel() const;
+
 		/** Rebuild the "expected" grid map. Used internally, do not call
 		  */
 		void  rebuildAverageMap();
@@ -263,6 +279,13 @@ namespace slam
 				const size_t			particleIndexForMap,
 				const CSensoryFrame		&observation,
 				const CPose3D			&x ) const;
+
+			/** Evaluate the observation likelihood for all the particles, each one with its own map, in parallel. */
+			void PF_SLAM_computeObservationLikelihoodForParticles(
+				const CParticleFilter::TParticleFilterOptions	&PF_options,
+				const CSensoryFrame		&observation,
+				const std::vector<TPose3D>	&x,
+				vector_double			&out_log_liks ) const;
 			/** @} */
 
 
@@ -227,10 +227,13 @@ namespace mrpt
 					// Prepare data for executing "fastDrawSample"
 					me->prepareFastDrawSample(PF_options);
 
-					// The new particle set:
-					std::vector<TPose3D>  newParticles;
-					vector_double         newParticlesWeight;
-					std::vector<size_t>   newParticlesDerivedFromIdx;
+					// The new particle set (buffers reused between iterations):
+					std::vector<TPose3D>  &newParticles = m_pfAux_newParticles;
+					std::vector<double>   &newParticlesWeight = m_pfAux_newParticlesWeight;
+					std::vector<size_t>   &newParticlesDerivedFromIdx = m_pfAux_newParticlesDerivedFromIdx;
+					newParticles.clear();
+					newParticlesWeight.clear();
+					newParticlesDerivedFromIdx.clear();
 
 					CPose3D	 increment_i;
 					size_t N = 1;
@@ -291,14 +294,16 @@ namespace mrpt
 				const size_t M = me->m_particles.size();
 				//	UPDATE STAGE
 				// ----------------------------------------------------------------------
-				// Compute all the likelihood values & update particles weight:
+				// Compute all the likelihood values at once & update particles weight:
+				std::vector<TPose3D>  partPoses(M);
 				for (size_t i=0;i<M;i++)
-				{
-					const TPose3D  *partPose= getLastPose(i); // Take the particle data:
-					CPose3D  partPose2 = CPose3D(*partPose);
-					const double obs_log_likelihood = PF_SLAM_computeObservationLikelihoodForParticle(PF_options,i,*sf,partPose2);
-					me->m_particles[i].log_w += obs_log_likelihood * PF_options.powFactor;
-				} // for each particle "i"
+					partPoses[i] = *getLastPose(i); // Take the particle data:
+
+				vector_double  obs_log_likelihoods;
+				PF_SLAM_computeObservationLikelihoodForParticles(PF_options,*sf,partPoses,obs_log_likelihoods);
+
+				for (size_t i=0;i<M;i++)
+					me->m_particles[i].log_w += obs_log_likelihoods[i] * PF_options.powFactor;
 
 				// Normalization of weights is done outside of this method automatically.
 			}
@@ -574,9 +579,10 @@ namespace mrpt
 			//  X is a single point close to the mean of the robot pose prior (as implemented in
 			//  the aux. function "PF_SLAM_particlesEvaluator_AuxPFStandard").
 			//
-			vector<TPose3D>			newParticles;
-			vector<double>			newParticlesWeight;
-			vector<size_t>			newParticlesDerivedFromIdx;
+			// The new particle set (buffers reused between iterations):
+			vector<TPose3D>			&newParticles = m_pfAux_newParticles;
+			vector<double>			&newParticlesWeight = m_pfAux_newParticlesWeight;
+			vector<size_t>			&newParticlesDerivedFromIdx = m_pfAux_newParticlesDerivedFromIdx;
 
 			// We need the (aproximate) maximum likelihood value for each
 			//  previous particle [i]:
@@ -75,6 +75,11 @@ namespace mrpt
 			mutable std::vector<TPose3D>	m_pfAuxiliaryPFOptimal_maxLikDrawnMovement;		//!< Auxiliary variable used in the "pfAuxiliaryPFOptimal" algorithm.
 			std::vector<bool>				m_pfAuxiliaryPFOptimal_maxLikMovementDrawHasBeenUsed;
 
+			std::vector<TPose3D>			m_pfAux_newParticles;					//!< Auxiliary buffers for the new particle set, reused between iterations
+			std::vector<double>				m_pfAux_newParticlesWeight;				//!< Auxiliary buffers for the new particle set, reused between iterations
+			std::vector<size_t>				m_pfAux_newParticlesDerivedFromIdx;		//!< Auxiliary buffers for the new particle set, reused between iterations
+			mutable std::vector<size_t>		m_pfAux_substPositions, m_pfAux_substCounts; //!< Auxiliary buffers for PF_SLAM_implementation_replaceByNewParticleSet()
+
 			/**  Compute w[i]p(z_t | mu_t^i), with mu_t^i being
 			  *    the mean of the new robot pose
 			  *
@@ -167,15 +172,16 @@ namespace mrpt
 				const TPose3D &newPose) const = 0;
 
 			/** This is the default algorithm to efficiently replace one old set of samples by another new set.
-			  *  The method uses pointers to make fast copies the first time each particle is duplicated, then
-			  *   makes real copies for the next ones.
+			  *  The replacement is done in place (see CParticleFilterData::substituteParticlesInPlace()): the first copy of each
+			  *   old particle keeps its data, next copies overwrite the data of old particles not propagated at all, and only
+			  *   if the number of particles grows new particles are allocated.
 			  *
 			  *  Note that more efficient specializations might exist for specific particle data structs.
 			  */
 			virtual void PF_SLAM_implementation_replaceByNewParticleSet(
 				typename CParticleFilterData<PARTICLE_TYPE>::CParticleList	 &old_particles,
 				const vector<TPose3D>		&newParticles,
-				const vector_double			&newParticlesWeight,
+				const vector<double>		&newParticlesWeight,
 				const vector<size_t>		&newParticlesDerivedFromIdx ) const
 			{
 				// ---------------------------------------------------------------------------------
@@ -184,54 +190,19 @@ namespace mrpt
 				//   New are in "newParticles", "newParticlesWeight","newParticlesDerivedFromIdx"
 				// ---------------------------------------------------------------------------------
 				const size_t N = newParticles.size();
-				typename MYSELF::CParticleList newParticlesArray(N);
+				ASSERT_EQUAL_(newParticlesWeight.size(),N)
+				ASSERT_EQUAL_(newParticlesDerivedFromIdx.size(),N)
 
-				// For efficiency, just copy the "CParticleData" from the old particle into the
-				//  new one, but this can be done only once:
-				std::vector<bool>	oldParticleAlreadyCopied(old_particles.size(),false);
+				std::vector<size_t> &positions = m_pfAux_substPositions;
+				CParticleFilterData<PARTICLE_TYPE>::substituteParticlesInPlace(old_particles,newParticlesDerivedFromIdx,positions,m_pfAux_substCounts);
 
-				size_t i;
-				typename MYSELF::CParticleList::iterator	newPartIt;
-				for (newPartIt=newParticlesArray.begin(),i=0;newPartIt!=newParticlesArray.end();newPartIt++,i++)
-				{
-					// The weight:
-					newPartIt->log_w = newParticlesWeight[i];
-
-					// The data (CParticleData):
-					PARTICLE_TYPE *newPartData;
-					if (!oldParticleAlreadyCopied[newParticlesDerivedFromIdx[i]])
-					{
-						// The first copy of this old particle:
-						newPartData = old_particles[ newParticlesDerivedFromIdx[i] ].d;
-						oldParticleAlreadyCopied[newParticlesDerivedFromIdx[i]] = true;
-					}
-					else
-					{
-						// Make a copy:
-						newPartData = new PARTICLE_TYPE( *old_particles[ newParticlesDerivedFromIdx[i] ].d );
-					}
-
-					newPartIt->d = newPartData;
-				} // end for "newPartIt"
-
-				// Now add the new robot pose to the paths:
-				//  (this MUST be done after the above loop, separately):
+				// Now set the weights and add the new robot pose to the paths:
+				//  (this MUST be done after all the copies above, separately):
 				// Update the particle with the new pose: this part is caller-dependant and must be implemented there:
-				for (newPartIt=newParticlesArray.begin(),i=0;i<N;++newPartIt,++i)
-					PF_SLAM_implementation_custom_update_particle_with_new_pose( newPartIt->d, newParticles[i] );
-
-				// Free those old m_particles not being copied into the new ones:
-				for (size_t i=0;i<old_particles.size();i++)
-					if (!oldParticleAlreadyCopied[i])
-						mrpt::utils::delete_safe( old_particles[ i ].d );
-
-				// Copy into "m_particles"
-				old_particles.resize( newParticlesArray.size() );
-				typename MYSELF::CParticleList::iterator	trgPartIt;
-				for (newPartIt=newParticlesArray.begin(),trgPartIt=old_particles.begin(); newPartIt!=newParticlesArray.end(); ++newPartIt, ++trgPartIt )
+				for (size_t i=0;i<N;i++)
 				{
-					trgPartIt->log_w = newPartIt->log_w;
-					trgPartIt->d = newPartIt->d;
+					old_particles[positions[i]].log_w = newParticlesWeight[i];
+					PF_SLAM_implementation_custom_update_particle_with_new_pose( old_particles[positions[i]].d, newParticles[i] );
 				}
 			} // end of PF_SLAM_implementation_replaceByNewParticleSet
 
@@ -257,6 +228,22 @@ namespace mrpt
 				const CSensoryFrame		&observation,
 				const CPose3D			&x )  const = 0;
 
+			/** Evaluate the observation likelihood for all the particles at once, each one at the given location in \a x.
+			  *  The default implementation just calls PF_SLAM_computeObservationLikelihoodForParticle() for each particle;
+			  *  redefine it if a faster batch evaluation is possible (e.g. in parallel, see CMonteCarloLocalization2D).
+			  */
+			virtual void PF_SLAM_computeObservationLikelihoodForParticles(
+				const CParticleFilter::TParticleFilterOptions	&PF_options,
+				const CSensoryFrame		&observation,
+				const std::vector<TPose3D>	&x,
+				vector_double			&out_log_liks ) const
+			{
+				const size_t N = x.size();
+				out_log_liks.resize(N);
+				for (size_t i=0;i<N;i++)
+					out_log_liks[i] = PF_SLAM_computeObservationLikelihoodForParticle(PF_options,i,observation,CPose3D(x[i]));
+			}
+
 			/** @} */
 
 
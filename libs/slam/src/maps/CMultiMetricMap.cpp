@@ -201,6 +201,32 @@ struct MapComputeLikelihood : public MapTraits
 
 }; // end of MapComputeLikelihood
 
+struct MapComputeLikelihoodForPoses : public MapTraits
+{
+	const CObservation            * obs;
+	const std::vector<mrpt::math::TPose3D>    & takenFrom;
+	vector_double                 & total_log_liks;
+	vector_double                   log_liks;
+
+	MapComputeLikelihoodForPoses(const CMultiMetricMap &m,const CObservation * _obs, const std::vector<mrpt::math::TPose3D> & _takenFrom, vector_double & _total_log_liks) :
+		MapTraits(m),
+		obs(_obs), takenFrom(_takenFrom),
+		total_log_liks(_total_log_liks)
+	{
+		total_log_liks.setZero(takenFrom.size());
+	}
+
+	template <typename PTR>
+	inline void operator()(PTR &ptr) {
+		if (isUsedLik(ptr))
+		{
+			ptr->computeObservationLikelihoodForPoses(obs,takenFrom,log_liks);
+			total_log_liks+=log_liks;
+		}
+	}
+
+}; // end of MapComputeLikelihoodForPoses
+
 struct MapCanComputeLikelihood  : public MapTraits
 {
 	const CObservation    * obs;
@@ -968,6 +994,19 @@ double	 CMultiMetricMap::computeObservationLikelihood(
 	return ret_log_lik;
 }
 
+/*---------------------------------------------------------------
+				computeObservationLikelihoodForPoses
+ ---------------------------------------------------------------*/
+void CMultiMetricMap::computeObservationLikelihoodForPoses(
+	const CObservation            *obs,
+	const std::vector<mrpt::math::TPose3D>    &takenFrom,
+	vector_double                 &out_log_liks )
+{
+	MapComputeLikelihoodForPoses op_likelihood(*this,obs,takenFrom,out_log_liks);
+
+	MapExecutor::run(*this,op_likelihood);
+}
+
 /*---------------------------------------------------------------
 Returns true if this map is able to compute a sensible likelihood function for this observation (i.e. an occupancy grid map cannot with an image).
 \param obs The observation.
@@ -56,21 +56,38 @@ CPosePDFPtr CICP::AlignPDF(
 
 	if (runningTime)  tictac.Tic();
 
+	// Coarse-to-fine: start from the result of the decimated maps, with a tighter threshold:
+	CPosePDFGaussian	initialEst(initialEstimationPDF);
+	CICP				fineICP(options);
+	unsigned int		nCoarseIters = 0;
+	if (options.pyramid_levels>1)
+	{
+		CPose3D  est(initialEst.mean);
+		nCoarseIters = alignCoarseLevels(m1,mm2,est,fineICP.options.thresholdDist,false);
+		initialEst.mean = CPose2D(est);
+	}
+
 	switch( options.ICP_algorithm )
 	{
 	case icpClassic:
-		resultPDF = ICP_Method_Classic( m1, mm2, initialEstimationPDF, outInfo );
+		resultPDF = fineICP.ICP_Method_Classic( m1, mm2, initialEst, outInfo );
 		break;
 	case icpLevenbergMarquardt:
-		resultPDF = ICP_Method_LM( m1, mm2, initialEstimationPDF, outInfo );
+		resultPDF = fineICP.ICP_Method_LM( m1, mm2, initialEst, outInfo );
 		break;
 	case icpIKF:
-		resultPDF = ICP_Method_IKF( m1, mm2, initialEstimationPDF, outInfo );
+		resultPDF = fineICP.ICP_Method_IKF( m1, mm2, initialEst, outInfo );
+		break;
+	case icpPointToPlane:
+	case icpGICP:
+		THROW_EXCEPTION("icpPointToPlane and icpGICP are only implemented for ICP-3D")
 		break;
 	default:
 		THROW_EXCEPTION_CUSTOM_MSG1("Invalid value for ICP_algorithm: %i", static_cast<int>(options.ICP_algorithm));
 	} // end switch
 
+	outInfo.nIterations += nCoarseIters;
+
 	if (runningTime)  *runningTime = tictac.Tac();
 
 	// Copy the output info if requested:
@@ -87,6 +104,73 @@ CPosePDFPtr CICP::AlignPDF(
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+					alignCoarseLevels
+  ---------------------------------------------------------------*/
+unsigned int CICP::alignCoarseLevels(
+	const CMetricMap	*m1,
+	const CMetricMap	*m2,
+	CPose3D				&inOutEstimation,
+	float				&outThresholdDist,
+	const bool			is3D )
+{
+	MRPT_START
+
+	// The pyramids can be only built for point maps (e.g. not when matching against a grid map):
+	if (!m1->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)) ||
+		!m2->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)) )
+		return 0;
+	ASSERT_(options.pyramid_voxel_size>0)
+
+	const CPointsMap *pm1 = static_cast<const CPointsMap*>(m1);
+	const CPointsMap *pm2 = static_cast<const CPointsMap*>(m2);
+
+	// Decimated maps are small: use all their points at all the levels:
+	CICP coarseICP(options);
+	coarseICP.options.pyramid_levels = 1;
+	coarseICP.options.corresponding_points_decimation = 1;
+	coarseICP.options.doRANSAC = false;
+	coarseICP.options.skip_cov_calculation = true;
+	coarseICP.options.skip_quality_calculation = true;
+
+	const size_t MIN_POINTS_PER_LEVEL = 10;
+
+	unsigned int nIters = 0;
+	float        thresholdDist = options.thresholdDist;
+	for (unsigned int level=options.pyramid_levels-1;level>0;level--)
+	{
+		const float voxel_size = options.pyramid_voxel_size * (1<<(level-1));
+		const CPointsMap &d1 = pm1->getVoxelDownsampled(voxel_size);
+		const CPointsMap &d2 = pm2->getVoxelDownsampled(voxel_size);
+		if (d1.size()<MIN_POINTS_PER_LEVEL || d2.size()<MIN_POINTS_PER_LEVEL)
+			continue;
+
+		// Stop refining once the thresholds are below the resolution of this level:
+		coarseICP.options.thresholdDist = std::max(thresholdDist, 2*voxel_size);
+		coarseICP.options.smallestThresholdDist = std::max(options.smallestThresholdDist, 0.5f*voxel_size);
+
+		TReturnInfo  info;
+		if (is3D)
+		{
+			CPose3DPDFPtr pdf = coarseICP.Align3DPDF(&d1,&d2,CPose3DPDFGaussian(inOutEstimation),NULL,&info);
+			inOutEstimation = pdf->getMeanVal();
+		}
+		else
+		{
+			CPosePDFPtr pdf = coarseICP.AlignPDF(&d1,&d2,CPosePDFGaussian(CPose2D(inOutEstimation)),NULL,&info);
+			inOutEstimation = CPose3D(pdf->getMeanVal());
+		}
+		nIters += info.nIterations;
+
+		// The next level starts close to the solution:
+		thresholdDist = std::min(options.thresholdDist, 2*voxel_size);
+		outThresholdDist = std::max(thresholdDist, options.smallestThresholdDist);
+	}
+	return nIters;
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					TConfigParams
   ---------------------------------------------------------------*/
@@ -123,7 +207,11 @@ CICP::TConfigParams::TConfigParams() :
 	skip_cov_calculation		(false),
 	skip_quality_calculation	(true),
 
-	corresponding_points_decimation ( 5 )
+	corresponding_points_decimation ( 5 ),
+	local_shape_knn				( 10 ),
+	GICP_epsilon				( 1e-3f ),
+	pyramid_levels				( 1 ),
+	pyramid_voxel_size			( 0.10f )
 {
 }
 
@@ -168,6 +256,10 @@ void  CICP::TConfigParams::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR( skip_quality_calculation, bool, 				iniFile, section);
 
 	MRPT_LOAD_CONFIG_VAR( corresponding_points_decimation, int, 				iniFile, section);
+	MRPT_LOAD_CONFIG_VAR( local_shape_knn, int, 				iniFile, section);
+	MRPT_LOAD_CONFIG_VAR( GICP_epsilon, float, 				iniFile, section);
+	MRPT_LOAD_CONFIG_VAR( pyramid_levels, int, 				iniFile, section);
+	MRPT_LOAD_CONFIG_VAR( pyramid_voxel_size, float, 				iniFile, section);
 
 }
 
@@ -181,7 +273,9 @@ void  CICP::TConfigParams::dumpToTextStream(CStream	&out) const
 	out.printf("ICP_algorithm                           = %s\n",
 		ICP_algorithm==icpClassic ?  "icpClassic" :
 		ICP_algorithm==icpLevenbergMarquardt ? "icpLevenbergMarquardt" :
-		ICP_algorithm==icpIKF ? "icpIKF" : "(INVALID VALUE!)" );
+		ICP_algorithm==icpIKF ? "icpIKF" :
+		ICP_algorithm==icpPointToPlane ? "icpPointToPlane" :
+		ICP_algorithm==icpGICP ? "icpGICP" : "(INVALID VALUE!)" );
 
 	out.printf("maxIterations                           = %i\n",maxIterations);
 	out.printf("minAbsStep_trans                        = %f\n",minAbsStep_trans);
@@ -210,6 +304,10 @@ void  CICP::TConfigParams::dumpToTextStream(CStream	&out) const
 	out.printf("skip_cov_calculation                    = %c\n",skip_cov_calculation ? 'Y':'N');
 	out.printf("skip_quality_calculation                = %c\n",skip_quality_calculation ? 'Y':'N');
 	out.printf("corresponding_points_decimation         = %u\n",(unsigned int)corresponding_points_decimation);
+	out.printf("local_shape_knn                         = %u\n",(unsigned int)local_shape_knn);
+	out.printf("GICP_epsilon                            = %f\n",GICP_epsilon);
+	out.printf("pyramid_levels                          = %u\n",(unsigned int)pyramid_levels);
+	out.printf("pyramid_voxel_size                      = %f\n",pyramid_voxel_size);
 	out.printf("\n");
 }
 
@@ -922,21 +1020,32 @@ CPose3DPDFPtr CICP::Align3DPDF(
 
 	if (runningTime)  tictac.Tic();
 
+	// Coarse-to-fine: start from the result of the decimated maps, with a tighter threshold:
+	CPose3DPDFGaussian	initialEst(initialEstimationPDF);
+	CICP				fineICP(options);
+	unsigned int		nCoarseIters = 0;
+	if (options.pyramid_levels>1)
+		nCoarseIters = alignCoarseLevels(m1,mm2,initialEst.mean,fineICP.options.thresholdDist,true);
+
 	switch( options.ICP_algorithm )
 	{
 	case icpClassic:
-		resultPDF = ICP3D_Method_Classic( m1, mm2, initialEstimationPDF, outInfo );
+	case icpPointToPlane:
+	case icpGICP:
+		resultPDF = fineICP.ICP3D_Method_Classic( m1, mm2, initialEst, outInfo );
 		break;
 	case icpLevenbergMarquardt:
-		THROW_EXCEPTION("Only icpClassic is implemented for ICP-3D")
+		THROW_EXCEPTION("Only icpClassic, icpPointToPlane and icpGICP are implemented for ICP-3D")
 		break;
 	case icpIKF:
-		THROW_EXCEPTION("Only icpClassic is implemented for ICP-3D")
+		THROW_EXCEPTION("Only icpClassic, icpPointToPlane and icpGICP are implemented for ICP-3D")
 		break;
 	default:
 		THROW_EXCEPTION_CUSTOM_MSG1("Invalid value for ICP_algorithm: %i", static_cast<int>(options.ICP_algorithm));
 	} // end switch
 
+	outInfo.nIterations += nCoarseIters;
+
 	if (runningTime)  *runningTime = tictac.Tac();
 
 	// Copy the output info if requested:
@@ -955,6 +1064,89 @@ CPose3DPDFPtr CICP::Align3DPDF(
 
 
 
+namespace
+{
+	/** Covariance of a point with the given local shape, flattened along its normal: I - (1-eps) n n^T (identity if the normal is unknown) */
+	inline Eigen::Matrix3d gicp_point_cov(const CPointsMap::TLocalShape &s, const Eigen::Matrix3d *R, const double eps)
+	{
+		Eigen::Matrix3d C = Eigen::Matrix3d::Identity();
+		if (s.curvature<0) return C;
+		Eigen::Vector3d n(s.nx,s.ny,s.nz);
+		if (R) n = (*R)*n;
+		C -= (1-eps)*n*n.transpose();
+		return C;
+	}
+
+	/** One Gauss-Newton iteration of the point-to-plane (shapes2==NULL) or Generalized-ICP (shapes2!=NULL) cost,
+	  *  which minimizes sum_i r_i^T M_i r_i, with r_i = q_i - (R*p_i+t) the residual of each pair of correspondences.
+	  *  The increment is applied to "pose" from the left, as a pseudo-exponential of se(3).
+	  * \return false if there were not enough usable correspondences to constraint the 6 DOFs.
+	  */
+	bool icp3D_gauss_newton_step(
+		const TMatchingPairList &corrs,
+		const std::vector<CPointsMap::TLocalShape> &shapes1,
+		const std::vector<CPointsMap::TLocalShape> *shapes2,
+		const double gicp_eps,
+		CPose3D &pose)
+	{
+		Eigen::Matrix3d R;
+		for (int i=0;i<3;i++) for (int j=0;j<3;j++) R(i,j) = pose.getRotationMatrix()(i,j);
+
+		Eigen::Matrix<double,6,6> H = Eigen::Matrix<double,6,6>::Zero();
+		Eigen::Matrix<double,6,1> g = Eigen::Matrix<double,6,1>::Zero();
+		size_t nUsed = 0;
+
+		for (TMatchingPairList::const_iterator it=corrs.begin();it!=corrs.end();++it)
+		{
+			if (it->this_idx>=shapes1.size() || (shapes2 && it->other_idx>=shapes2->size()))
+				continue;
+			const CPointsMap::TLocalShape &s1 = shapes1[it->this_idx];
+
+			// The local metric:
+			Eigen::Matrix3d M;
+			if (!shapes2)
+			{
+				if (s1.curvature<0) continue;
+				const Eigen::Vector3d n(s1.nx,s1.ny,s1.nz);
+				M = n*n.transpose();
+			}
+			else
+			{
+				M = ( gicp_point_cov(s1,NULL,gicp_eps) + gicp_point_cov((*shapes2)[it->other_idx],&R,gicp_eps) ).inverse();
+			}
+
+			double gx,gy,gz;
+			pose.composePoint(it->other_x,it->other_y,it->other_z, gx,gy,gz);
+			const Eigen::Vector3d r(it->this_x-gx, it->this_y-gy, it->this_z-gz);
+
+			// Jacobian of the residual wrt [dt, dw]: [ -I , [p']x ]
+			Eigen::Matrix<double,3,6> J;
+			J.block<3,3>(0,0) = -Eigen::Matrix3d::Identity();
+			J(0,3) =  0;  J(0,4) = -gz; J(0,5) =  gy;
+			J(1,3) =  gz; J(1,4) =  0;  J(1,5) = -gx;
+			J(2,3) = -gy; J(2,4) =  gx; J(2,5) =  0;
+
+			const Eigen::Matrix<double,6,3> JtM = J.transpose()*M;
+			H.noalias() += JtM*J;
+			g.noalias() += JtM*r;
+			nUsed++;
+		}
+
+		if (nUsed<6) return false;
+
+		// Small damping, to cope with degenerate geometries (e.g. a single plane):
+		const double damping = 1e-6 * (H.trace()/6+1e-12);
+		for (int i=0;i<6;i++) H(i,i)+=damping;
+
+		const Eigen::Matrix<double,6,1> delta = -H.ldlt().solve(g);
+
+		mrpt::math::CArrayDouble<6> incr;
+		for (int i=0;i<6;i++) incr[i]=delta[i];
+		pose = CPose3D::exp(incr,true) + pose;
+		return true;
+	}
+}
+
 CPose3DPDFPtr CICP::ICP3D_Method_Classic(
 		const CMetricMap		*m1,
 		const CMetricMap		*mm2,
@@ -981,6 +1173,16 @@ CPose3DPDFPtr CICP::ICP3D_Method_Classic(
 	// -----------------
 	ASSERT_( options.ALFA>0 && options.ALFA<1 );
 
+	// Point-to-plane and GICP need the local shape (normals) of the points:
+	const std::vector<CPointsMap::TLocalShape> *shapes1 = NULL, *shapes2 = NULL;
+	if (options.ICP_algorithm==icpPointToPlane || options.ICP_algorithm==icpGICP)
+	{
+		ASSERTMSG_(m1->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)), "icpPointToPlane and icpGICP require the reference map to be a CPointsMap")
+		shapes1 = &static_cast<const CPointsMap*>(m1)->getLocalShapes(options.local_shape_knn);
+		if (options.ICP_algorithm==icpGICP)
+			shapes2 = &m2->getLocalShapes(options.local_shape_knn);
+	}
+
 	// The algorithm output auxiliar info:
 	// -------------------------------------------------
 	outInfo.cbSize			= sizeof(TReturnInfo);
@@ -1036,10 +1238,14 @@ CPose3DPDFPtr CICP::ICP3D_Method_Classic(
 			}
 			else
 			{
-				// Compute the estimated pose, using Horn's method.
+				// Compute the estimated pose, using Horn's method (icpClassic), or
+				//  one Gauss-Newton step on the point-to-plane / plane-to-plane metric:
 				// ----------------------------------------------------------------------
-				double transf_scale;
-				scanmatching::leastSquareErrorRigidTransformation6D( correspondences, gaussPdf->mean, transf_scale, false );
+				if (!shapes1 || !icp3D_gauss_newton_step(correspondences,*shapes1,shapes2,options.GICP_epsilon,gaussPdf->mean))
+				{
+					double transf_scale;
+					scanmatching::leastSquareErrorRigidTransformation6D( correspondences, gaussPdf->mean, transf_scale, false );
+				}
 
 				// If matching has not changed, decrease the thresholds:
 				// --------------------------------------------------------
@@ -27,7 +27,13 @@ using namespace mrpt::poses;
 /*---------------------------------------------------------------
 		 Constructor
   ---------------------------------------------------------------*/
-CMetricMapBuilderICP::CMetricMapBuilderICP()
+CMetricMapBuilderICP::CMetricMapBuilderICP() :
+	m_localMapEvicted(0),
+	m_pendingInsertionsCount(0),
+	m_pendingInsertions_sem(0,0x7FFFFFFF),
+	m_globalMapWaiters(0),
+	m_globalMapUpdated_sem(0,0x7FFFFFFF),
+	m_globalMapThread_exit(false)
 {
 	this->initialize( CSimpleMap() );
 }
@@ -46,6 +52,9 @@ CMetricMapBuilderICP::~CMetricMapBuilderICP()
 	// Save current map to current file:
 	setCurrentMapFile("");
 
+	// Finish inserting pending keyframes into the global map:
+	stopGlobalMapThread();
+
 	MRPT_END
 }
 
@@ -60,6 +69,9 @@ CMetricMapBuilderICP::TConfigParams::TConfigParams() :
 	localizationLinDistance(0.20),
 	localizationAngDistance(DEG2RAD(30)),
 	minICPgoodnessToAccept(0.40),
+	localMapMaxDistance(0),
+	localMapMaxAge(0),
+	localMapMaxKeyframes(0),
 	mapInitializers()
 {
 }
@@ -76,12 +88,21 @@ void  CMetricMapBuilderICP::TConfigParams::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(minICPgoodnessToAccept, double	,source,section)
 
+	MRPT_LOAD_CONFIG_VAR(localMapMaxDistance, double	,source,section)
+	MRPT_LOAD_CONFIG_VAR(localMapMaxAge, double	,source,section)
+	MRPT_LOAD_CONFIG_VAR(localMapMaxKeyframes, int	,source,section)
 
 	mapInitializers.loadFromConfigFile(source,section);
 }
 
 void  CMetricMapBuilderICP::TConfigParams::dumpToTextStream( CStream	&out) const
 {
+	out.printf("\n----------- [CMetricMapBuilderICP::TConfigParams] ------------ \n\n");
+	out.printf("localMapMaxDistance                     = %f\n", localMapMaxDistance);
+	out.printf("localMapMaxAge                          = %f\n", localMapMaxAge);
+	out.printf("localMapMaxKeyframes                    = %u\n", localMapMaxKeyframes);
+	out.printf("\n");
+
 	mapInitializers.dumpToTextStream(out);
 }
 
@@ -142,6 +163,11 @@ void  CMetricMapBuilderICP::processObservation(const CObservationPtr &obs)
 				m_lastPoseEst.getLatestRobotPose(initialEstimatedRobotPose);
 		}
 
+		// Slide the window of the local map, if used:
+		const bool useLocalMap = ICP_options.useLocalMap();
+		if (useLocalMap)
+			updateLocalMapWindow(initialEstimatedRobotPose, obs->timestamp);
+
 		// To know the total path length:
 		CPose2D  previousKnownRobotPose;
 		m_lastPoseEst.getLatestRobotPose(previousKnownRobotPose);
@@ -166,6 +192,10 @@ void  CMetricMapBuilderICP::processObservation(const CObservationPtr &obs)
 		{
 			matchWith = static_cast<CMetricMap*>(metricMap.m_gridMaps[0].pointer());
 		}
+		else if (useLocalMap)
+		{
+			matchWith = &m_localMap;
+		}
 		else
 		{
 			ASSERTMSG_( metricMap.m_pointsMaps.size(), "No points map in multi-metric map." )
@@ -315,8 +345,18 @@ void  CMetricMapBuilderICP::processObservation(const CObservationPtr &obs)
 			if (options.verbose)
 				printf("[CMetricMapBuilderICP] Updating map from pose %s\n",currentKnownRobotPose.asString().c_str());
 
-			CPose3D		estimatedPose3D(currentKnownRobotPose);
-			metricMap.insertObservationPtr(obs,&estimatedPose3D);
+			if (useLocalMap)
+			{
+				// The local map is updated right now, and the global one in the background:
+				insertIntoLocalMap(obs,currentKnownRobotPose);
+				updateLocalMapWindow(currentKnownRobotPose, obs->timestamp);
+				enqueueGlobalMapInsertion(obs,currentKnownRobotPose);
+			}
+			else
+			{
+				CPose3D		estimatedPose3D(currentKnownRobotPose);
+				metricMap.insertObservationPtr(obs,&estimatedPose3D);
+			}
 
 			// Add to the vector of "poses"-"SFs" pairs:
 			CPosePDFGaussian	posePDF(currentKnownRobotPose);
@@ -426,9 +466,22 @@ void  CMetricMapBuilderICP::initialize(
 	// Init path & map:
 	mrpt::synch::CCriticalSectionLocker lock_cs( &critZoneChangingMap );
 
+	// Do not touch the global map while it is being updated:
+	waitForGlobalMapUpdates();
+
 	// Create metric maps:
 	metricMap.setListOfMaps( &ICP_options.mapInitializers );
 
+	// The local map uses the insertion options of the first points map, but its points must be just appended,
+	//  one keyframe after another, to remove them later:
+	m_localMap.clear();
+	m_localKeyframes.clear();
+	m_localMapEvicted = 0;
+	if (!metricMap.m_pointsMaps.empty())
+		m_localMap.insertionOptions = metricMap.m_pointsMaps[0]->insertionOptions;
+	m_localMap.insertionOptions.fuseWithExisting = false;
+	m_localMap.insertionOptions.voxelFusionSize = 0;
+
 	// copy map:
 	SF_Poses_seq = initialMap;
 
@@ -463,6 +516,21 @@ void  CMetricMapBuilderICP::initialize(
 
 		// Insert observations into the map:
 		SF->insertObservationsInto( &metricMap, &estimatedPose3D );
+
+		if (ICP_options.useLocalMap())
+		{
+			const CPose2D pose2D(estimatedPose3D);
+			for (CSensoryFrame::iterator it=SF->begin();it!=SF->end();++it)
+				insertIntoLocalMap(*it,pose2D);
+		}
+	}
+
+	// Keep only the keyframes around the initial pose:
+	if (ICP_options.useLocalMap())
+	{
+		CPose2D  curPose;
+		m_lastPoseEst.getLatestRobotPose(curPose);
+		updateLocalMapWindow(curPose, m_localKeyframes.empty() ? INVALID_TIMESTAMP : m_localKeyframes.back().timestamp);
 	}
 
 	if (options.verbose)
@@ -480,6 +548,7 @@ void  CMetricMapBuilderICP::getCurrentMapPoints(
 {
 	// Critical section: We are using our global metric map
 	enterCriticalSection();
+	waitForGlobalMapUpdates();
 
 	ASSERT_( metricMap.m_pointsMaps.size()>0 );
 	metricMap.m_pointsMaps[0]->getAllPoints(x,y);
@@ -502,6 +571,7 @@ void  CMetricMapBuilderICP::getCurrentlyBuiltMap(CSimpleMap &out_map) const
   ---------------------------------------------------------------*/
 CMultiMetricMap*   CMetricMapBuilderICP::getCurrentlyBuiltMetricMap()
 {
+	waitForGlobalMapUpdates();
 	return &metricMap;
 }
 
@@ -524,6 +594,8 @@ void  CMetricMapBuilderICP::saveCurrentEstimationToImage(const std::string &file
 	CImage        img;
 	const size_t  nPoses = m_estRobotPath.size();
 
+	waitForGlobalMapUpdates();
+
 	ASSERT_( metricMap.m_gridMaps.size()>0 );
 
 	if (!formatEMF_BMP)
@@ -601,3 +673,157 @@ void CMetricMapBuilderICP::TDist::updatePose(const mrpt::poses::CPose2D &p)
 	lin = 0;
 	ang = 0;
 }
+
+/*---------------------------------------------------------------
+						insertIntoLocalMap
+  ---------------------------------------------------------------*/
+void CMetricMapBuilderICP::insertIntoLocalMap(const CObservationPtr &obs, const CPose2D &pose)
+{
+	const size_t nBefore = m_localMap.size();
+	const CPose3D pose3D(pose);
+	m_localMap.insertObservationPtr(obs,&pose3D);
+
+	// Observations without points are not keyframes of the local map:
+	if (m_localMap.size()==nBefore)
+		return;
+
+	TLocalKeyframe kf;
+	kf.pose = TPose2D(pose);
+	kf.timestamp = obs->timestamp;
+	kf.nPoints = m_localMap.size()-nBefore;
+	m_localKeyframes.push_back(kf);
+}
+
+/*---------------------------------------------------------------
+						updateLocalMapWindow
+  ---------------------------------------------------------------*/
+void CMetricMapBuilderICP::updateLocalMapWindow(const CPose2D &currentPose, const mrpt::system::TTimeStamp currentTime)
+{
+	// Remove keyframes from the front of the window (but never the latest one):
+	while (m_localKeyframes.size()>1)
+	{
+		const TLocalKeyframe &kf = m_localKeyframes.front();
+
+		const bool tooMany = ICP_options.localMapMaxKeyframes>0 && m_localKeyframes.size()>ICP_options.localMapMaxKeyframes;
+		const bool tooFar  = ICP_options.localMapMaxDistance>0 && currentPose.distance2DTo(kf.pose.x,kf.pose.y)>ICP_options.localMapMaxDistance;
+		const bool tooOld  = ICP_options.localMapMaxAge>0 && currentTime!=INVALID_TIMESTAMP && kf.timestamp!=INVALID_TIMESTAMP &&
+			mrpt::system::timeDifference(kf.timestamp,currentTime)>ICP_options.localMapMaxAge;
+
+		if (!tooMany && !tooFar && !tooOld)
+			break;
+
+		m_localMapEvicted+=kf.nPoints;
+		m_localKeyframes.pop_front();
+	}
+
+	// Delete the points of removed keyframes only when they are as many as the rest, so the cost of deleting them
+	//  and rebuilding the KD-tree is amortized among many keyframes:
+	if (m_localMapEvicted>0 && 2*m_localMapEvicted>=m_localMap.size())
+	{
+		std::vector<bool> deletionMask(m_localMap.size(),false);
+		std::fill(deletionMask.begin(),deletionMask.begin()+m_localMapEvicted,true);
+		m_localMap.applyDeletionMask(deletionMask);
+		m_localMapEvicted = 0;
+
+		if (options.verbose)
+			printf("[CMetricMapBuilderICP] Local map compacted to %u points in %u keyframes\n",static_cast<unsigned int>(m_localMap.size()),static_cast<unsigned int>(m_localKeyframes.size()));
+	}
+}
+
+/*---------------------------------------------------------------
+					enqueueGlobalMapInsertion
+  ---------------------------------------------------------------*/
+void CMetricMapBuilderICP::enqueueGlobalMapInsertion(const CObservationPtr &obs, const CPose2D &pose)
+{
+	// Launch the thread the first time:
+	if (m_globalMapThread.isClear())
+	{
+		m_globalMapThread_exit = false;
+		m_globalMapThread = mrpt::system::createThreadFromObjectMethod(this, &CMetricMapBuilderICP::thread_updateGlobalMap);
+	}
+
+	{
+		mrpt::synch::CCriticalSectionLocker lock( &m_pendingInsertions_cs );
+		TPendingInsertion ins;
+		ins.obs = obs;
+		ins.pose = TPose2D(pose);
+		m_pendingInsertions.push_back(ins);
+		m_pendingInsertionsCount++;
+	}
+	m_pendingInsertions_sem.release();
+}
+
+/*---------------------------------------------------------------
+					thread_updateGlobalMap
+  ---------------------------------------------------------------*/
+void CMetricMapBuilderICP::thread_updateGlobalMap()
+{
+	for (;;)
+	{
+		m_pendingInsertions_sem.waitForSignal();
+
+		TPendingInsertion ins;
+		{
+			mrpt::synch::CCriticalSectionLocker lock( &m_pendingInsertions_cs );
+			if (m_pendingInsertions.empty())
+			{
+				if (m_globalMapThread_exit)
+					return;
+				continue;
+			}
+			ins = m_pendingInsertions.front();
+			m_pendingInsertions.pop_front();
+		}
+
+		try
+		{
+			const CPose3D pose3D = CPose3D(CPose2D(ins.pose));
+			metricMap.insertObservationPtr(ins.obs,&pose3D);
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << "[CMetricMapBuilderICP] Error updating the global map:\n" << e.what() << std::endl;
+		}
+
+		mrpt::synch::CCriticalSectionLocker lock( &m_pendingInsertions_cs );
+		if (!--m_pendingInsertionsCount && m_globalMapWaiters)
+		{
+			// Wake up the threads in waitForGlobalMapUpdates():
+			m_globalMapUpdated_sem.release(m_globalMapWaiters);
+			m_globalMapWaiters = 0;
+		}
+	}
+}
+
+/*---------------------------------------------------------------
+					waitForGlobalMapUpdates
+  ---------------------------------------------------------------*/
+void CMetricMapBuilderICP::waitForGlobalMapUpdates()
+{
+	for (;;)
+	{
+		{
+			mrpt::synch::CCriticalSectionLocker lock( &m_pendingInsertions_cs );
+			if (!m_pendingInsertionsCount)
+				return;
+			m_globalMapWaiters++;
+		}
+		m_globalMapUpdated_sem.waitForSignal();
+	}
+}
+
+/*---------------------------------------------------------------
+					stopGlobalMapThread
+  ---------------------------------------------------------------*/
+void CMetricMapBuilderICP::stopGlobalMapThread()
+{
+	if (m_globalMapThread.isClear())
+		return;
+
+	waitForGlobalMapUpdates();
+
+	m_globalMapThread_exit = true;
+	m_pendingInsertions_sem.release();
+	mrpt::system::joinThread(m_globalMapThread);
+	m_globalMapThread.clear();
+}
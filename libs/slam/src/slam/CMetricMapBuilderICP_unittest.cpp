@@ -0,0 +1,106 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/slam.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::system;
+using namespace std;
+
+// A long corridor with a zig-zag wall on each side, so the robot can be localized along it:
+static void buildCorridor(COccupancyGridMap2D &grid)
+{
+	grid.fill(1.0f);
+	for (float x=-5;x<65;x+=grid.getResolution())
+	{
+		const float dy = ((int)((x+5)/0.7f))%2 ? 0.3f : 0.0f;
+		for (float w=0;w<0.2f;w+=grid.getResolution())
+		{
+			grid.setPos(x, 1.5f+dy+w, 0.0f);
+			grid.setPos(x,-1.5f-dy-w, 0.0f);
+		}
+	}
+}
+
+static void initMapBuilder(CMetricMapBuilderICP &mapBuilder, const double localMapMaxDistance)
+{
+	mapBuilder.options.verbose = false;
+	mapBuilder.ICP_options.localMapMaxDistance = localMapMaxDistance;
+	mapBuilder.ICP_options.insertionLinDistance = 1.0;
+	{
+		TMetricMapInitializer mapElement;
+		mapElement.metricMapClassType = CLASS_ID( CSimplePointsMap );
+		mapBuilder.ICP_options.mapInitializers.push_back( mapElement );
+	}
+	mapBuilder.initialize();
+}
+
+TEST(CMetricMapBuilderICP, slidingWindowLocalMap)
+{
+	COccupancyGridMap2D grid(-5,65,-5,5,0.05f);
+	buildCorridor(grid);
+
+	// The same scans are aligned against a sliding window and against the whole map:
+	CMetricMapBuilderICP mapBuilder, refMapBuilder;
+	initMapBuilder(mapBuilder, 5.0);
+	initMapBuilder(refMapBuilder, 0);
+
+	TTimeStamp t = mrpt::system::now();
+	const double STEP = 0.25;
+	size_t maxLocalMapSize = 0, maxKeyframes = 0;
+
+	for (double x=0;x<40;x+=STEP)
+	{
+		const CPose2D truePose(x,0,0);
+		t += mrpt::system::secondsToTimestamp(1.0);
+
+		CObservationOdometryPtr odo = CObservationOdometry::Create();
+		odo->timestamp = t;
+		odo->odometry = truePose;
+		mapBuilder.processObservation(odo);
+		refMapBuilder.processObservation(odo);
+
+		CObservation2DRangeScanPtr scan = CObservation2DRangeScan::Create();
+		scan->sensorLabel = "LASER";
+		scan->timestamp = t;
+		scan->aperture = M_PIf;
+		scan->maxRange = 8.0f;
+		grid.laserScanSimulator(*scan, truePose, 0.5f, 181);
+		mapBuilder.processObservation(scan);
+		refMapBuilder.processObservation(scan);
+
+		maxLocalMapSize = std::max(maxLocalMapSize, mapBuilder.getCurrentLocalMap().size());
+		maxKeyframes = std::max(maxKeyframes, mapBuilder.getCurrentLocalMapKeyframeCount());
+	}
+
+	// The robot pose is tracked as well as with the whole map (ICP itself drifts along the corridor, so both are compared with each other):
+	const CPose3D estPose = mapBuilder.getCurrentPoseEstimation()->getMeanVal();
+	const CPose3D refPose = refMapBuilder.getCurrentPoseEstimation()->getMeanVal();
+	EXPECT_NEAR(estPose.x(), refPose.x(), 0.2);
+	EXPECT_NEAR(estPose.y(), refPose.y(), 0.2);
+	EXPECT_NEAR(estPose.yaw(), refPose.yaw(), DEG2RAD(2.0));
+
+	// The window has at most the keyframes in 5m (one per meter), plus the latest one:
+	EXPECT_LE(maxKeyframes, 7u);
+
+	// The global map has all the keyframes, while the local one is bounded:
+	const CMultiMetricMap *globalMap = mapBuilder.getCurrentlyBuiltMetricMap();
+	ASSERT_EQ(globalMap->m_pointsMaps.size(), 1u);
+	EXPECT_GE(mapBuilder.getCurrentlyBuiltMapSize(), 35u);
+	EXPECT_GT(globalMap->m_pointsMaps[0]->size(), 3*maxLocalMapSize);
+
+	// All the keyframes of the local map are around the robot:
+	float x_min,x_max,y_min,y_max,z_min,z_max;
+	mapBuilder.getCurrentLocalMap().boundingBox(x_min,x_max,y_min,y_max,z_min,z_max);
+	EXPECT_GT(x_min, estPose.x()-2*5.0-8.0);
+}
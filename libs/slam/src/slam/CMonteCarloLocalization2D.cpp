@@ -203,6 +203,33 @@ double CMonteCarloLocalization2D::PF_SLAM_computeObservationLikelihoodForParticl
 	return ret;
 }
 
+/*---------------------------------------------------------------
+			PF_SLAM_computeObservationLikelihoodForParticles
+ ---------------------------------------------------------------*/
+void CMonteCarloLocalization2D::PF_SLAM_computeObservationLikelihoodForParticles(
+	const CParticleFilter::TParticleFilterOptions	&PF_options,
+	const CSensoryFrame		&observation,
+	const std::vector<TPose3D>	&x,
+	vector_double			&out_log_liks ) const
+{
+	if (!options.metricMap)
+	{
+		// One map per particle: evaluate them one by one.
+		PF_implementation<CPose2D,CMonteCarloLocalization2D>::PF_SLAM_computeObservationLikelihoodForParticles(PF_options,observation,x,out_log_liks);
+		return;
+	}
+
+	// For each observation, evaluate all the particles at once:
+	//  (Initial value of 1 to return exactly the same than PF_SLAM_computeObservationLikelihoodForParticle)
+	out_log_liks.setConstant(x.size(), 1.0);
+	vector_double obs_log_liks;
+	for (CSensoryFrame::const_iterator it=observation.begin();it!=observation.end();++it)
+	{
+		options.metricMap->computeObservationLikelihoodForPoses( it->pointer(), x, obs_log_liks );
+		out_log_liks += obs_log_liks;
+	}
+}
+
 // Specialization for my kind of particles:
 void CMonteCarloLocalization2D::PF_SLAM_implementation_custom_update_particle_with_new_pose(
 	CPose2D *particleData,
@@ -215,7 +242,7 @@ void CMonteCarloLocalization2D::PF_SLAM_implementation_custom_update_particle_wi
 void CMonteCarloLocalization2D::PF_SLAM_implementation_replaceByNewParticleSet(
 	CParticleList	&old_particles,
 	const vector<TPose3D>	&newParticles,
-	const vector_double		&newParticlesWeight,
+	const vector<double>	&newParticlesWeight,
 	const vector<size_t>	&newParticlesDerivedFromIdx )  const
 {
 	ASSERT_EQUAL_(size_t(newParticlesWeight.size()),size_t(newParticles.size()))
@@ -225,17 +252,19 @@ void CMonteCarloLocalization2D::PF_SLAM_implementation_replaceByNewParticleSet(
 	//   Old are in "m_particles"
 	//   New are in "newParticles", "newParticlesWeight","newParticlesDerivedFromIdx"
 	// ---------------------------------------------------------------------------------
-	// Free old m_particles:
-	for (size_t i=0;i<old_particles.size();i++)
-			mrpt::utils::delete_safe( old_particles[ i ].d );
-
-	// Copy into "m_particles"
+	// The new poses do not depend on the old particles: just overwrite them in place,
+	//  allocating or freeing only if the number of particles changes:
 	const size_t N = newParticles.size();
+	for (size_t i=N;i<old_particles.size();i++)
+			mrpt::utils::delete_safe( old_particles[ i ].d );
+	const size_t N_old = std::min(N, old_particles.size());
 	old_particles.resize(N);
 	for (size_t i=0;i<N;i++)
 	{
 		old_particles[i].log_w = newParticlesWeight[i];
-		old_particles[i].d = new CPose2D( TPose2D( newParticles[i] ));
+		if (i<N_old)
+				*old_particles[i].d = CPose2D( TPose2D( newParticles[i] ));
+		else	old_particles[i].d = new CPose2D( TPose2D( newParticles[i] ));
 	}
 }
 
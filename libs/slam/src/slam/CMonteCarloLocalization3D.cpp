@@ -206,7 +206,7 @@ void CMonteCarloLocalization3D::PF_SLAM_implementation_custom_update_particle_wi
 void CMonteCarloLocalization3D::PF_SLAM_implementation_replaceByNewParticleSet(
 	CParticleList	&old_particles,
 	const vector<TPose3D>	&newParticles,
-	const vector_double		&newParticlesWeight,
+	const vector<double>	&newParticlesWeight,
 	const vector<size_t>	&newParticlesDerivedFromIdx )  const
 {
 	ASSERT_(size_t(newParticlesWeight.size())==newParticles.size())
@@ -216,17 +216,19 @@ void CMonteCarloLocalization3D::PF_SLAM_implementation_replaceByNewParticleSet(
 	//   Old are in "m_particles"
 	//   New are in "newParticles", "newParticlesWeight","newParticlesDerivedFromIdx"
 	// ---------------------------------------------------------------------------------
-	// Free old m_particles:
-	for (size_t i=0;i<old_particles.size();i++)
-			mrpt::utils::delete_safe( old_particles[ i ].d );
-
-	// Copy into "m_particles"
+	// The new poses do not depend on the old particles: just overwrite them in place,
+	//  allocating or freeing only if the number of particles changes:
 	const size_t N = newParticles.size();
+	for (size_t i=N;i<old_particles.size();i++)
+			mrpt::utils::delete_safe( old_particles[ i ].d );
+	const size_t N_old = std::min(N, old_particles.size());
 	old_particles.resize(N);
 	for (size_t i=0;i<N;i++)
 	{
 		old_particles[i].log_w = newParticlesWeight[i];
-		old_particles[i].d = new CPose3D( newParticles[i] );
+		if (i<N_old)
+				*old_particles[i].d = CPose3D( newParticles[i] );
+		else	old_particles[i].d = new CPose3D( newParticles[i] );
 	}
 }
 
@@ -25,6 +25,7 @@
 #include <mrpt/slam/CSimplePointsMap.h>
 #include <mrpt/slam/CLandmarksMap.h>
 #include <mrpt/math.h>
+#include <mrpt/system/parallelization.h>
 
 #include <mrpt/slam/PF_aux_structs.h>
 
@@ -36,6 +37,29 @@ using namespace mrpt::random;
 using namespace mrpt::utils;
 using namespace std;
 
+namespace
+{
+	/** Inserts a SF into the map of each particle in a range, at the particle's last pose. */
+	struct TParticleMapsUpdater
+	{
+		CMultiMetricMapPDF::CParticleList	&particles;
+		const CSensoryFrame					&sf;
+
+		TParticleMapsUpdater(CMultiMetricMapPDF::CParticleList &_particles, const CSensoryFrame &_sf) :
+			particles(_particles), sf(_sf)
+		{ }
+
+		void operator()(const mrpt::system::BlockedRange &r) const
+		{
+			for (int i=r.begin();i!=r.end();++i)
+			{
+				const CPose3D robotPose( particles[i].d->robotPath.back() );
+				sf.insertObservationsInto( &particles[i].d->mapTillNow, &robotPose );
+			}
+		}
+	};
+}
+
 IMPLEMENTS_SERIALIZABLE( CMultiMetricMapPDF, CSerializable, mrpt::slam )
 IMPLEMENTS_SERIALIZABLE( CRBPFParticleData,  CSerializable, mrpt::slam )
 
@@ -102,7 +126,8 @@ CMultiMetricMapPDF::CMultiMetricMapPDF(
 		SFs(),
 		SF2robotPath(),
 		options(),
-		newInfoIndex(0)
+		newInfoIndex(0),
+		m_timeLogger(false)
 {
 	m_particles.resize( opts.sampleSize );
 	for (CParticleList::iterator it=m_particles.begin();it!=m_particles.end();++it)
@@ -395,31 +420,28 @@ void  CMultiMetricMapPDF::rebuildAverageMap()
 		part=m_particles.begin();
 		do
 		{
-			// The cells in the source map:
-			unsigned short*		srcCell;
-			unsigned short*		firstSrcCell = (unsigned short*)&(*part->d->mapTillNow.m_gridMaps[0]->map.begin());
-			unsigned short*		lastSrcCell = (unsigned short*)&(*part->d->mapTillNow.m_gridMaps[0]->map.end());
-
 			// Assure sizes:
 			ASSERT_(0==(part->d->mapTillNow.m_gridMaps[0]->size_x % 8));
 			ASSERT_(0==(averageMap.m_gridMaps[0]->size_x % 8));
 			ASSERT_(averageMap.m_gridMaps[0]->map.size()==part->d->mapTillNow.m_gridMaps[0]->map.size());
 
-			// The destination cells:
-			unsigned short*		destCell;
-			unsigned short*		firstDestCell = (unsigned short*)&averageMap.m_gridMaps[0]->map[0];
-
 			// The weight of particle:
 			MRPT_ALIGN16 unsigned short weights_array[8];
 			weights_array[0] = weights_array[1] = weights_array[2] = weights_array[3] =
 			weights_array[4] = weights_array[5] = weights_array[6] = weights_array[7] = (unsigned short)(exp(part->log_w) * 65535 / sumLinearWeights);
 			unsigned short*		weights_8 = weights_array;
 
-			srcCell = firstSrcCell;
-			destCell = firstDestCell;
-			//size_t	cellsCount = averageMap.gridMap->map.size();
+			// For each row of cells in individual maps (rows are not contiguous in memory):
+			const size_t nRows = averageMap.m_gridMaps[0]->size_y, nCols = averageMap.m_gridMaps[0]->size_x;
+			for (size_t cy=0;cy<nRows;cy++)
+			{
+			// The cells in the source map:
+			const unsigned short*	srcCell = (const unsigned short*)part->d->mapTillNow.m_gridMaps[0]->map.getRow(cy);
+			const unsigned short*	lastSrcCell = srcCell + nCols;
+
+			// The destination cells:
+			unsigned short*		destCell = (unsigned short*)averageMap.m_gridMaps[0]->map.getRowForWrite(cy);
 
-			// For each cell in individual maps:
 			__asm
 			{
 				push	eax
@@ -464,6 +486,7 @@ void  CMultiMetricMapPDF::rebuildAverageMap()
 				pop		edx
 				pop		eax
 			}
+			} // end for each row
 
 			// Next particle:
 			part++;
@@ -495,31 +518,36 @@ void  CMultiMetricMapPDF::rebuildAverageMap()
 
 		for (part=m_particles.begin();part!=m_particles.end();part++)
 		{
-			// Variables:
-			std::vector<COccupancyGridMap2D::cellType>::iterator	srcCell;
-			std::vector<COccupancyGridMap2D::cellType>::iterator	firstSrcCell = part->d->mapTillNow.m_gridMaps[0]->map.begin();
-			std::vector<COccupancyGridMap2D::cellType>::iterator	lastSrcCell = part->d->mapTillNow.m_gridMaps[0]->map.end();
-			std::vector<float>::iterator							destCell;
+			const COccupancyGridMap2D *srcMap = part->d->mapTillNow.m_gridMaps[0].pointer();
 
 			// The weight of particle:
 			float		w =  exp(part->log_w) / sumW;
 
-			ASSERT_( part->d->mapTillNow.m_gridMaps[0]->map.size() == floatMap.size() );
+			ASSERT_( srcMap->map.size() == floatMap.size() );
 
 			// For each cell in individual maps:
-			for (srcCell = firstSrcCell, destCell = floatMap.begin();srcCell!=lastSrcCell;srcCell++,destCell++)
-				(*destCell) += w * (*srcCell);
+			std::vector<float>::iterator	destCell = floatMap.begin();
+			for (size_t cy=0;cy<srcMap->size_y;cy++)
+			{
+				const COccupancyGridMap2D::cellType	*srcCell = srcMap->map.getRow(cy);
+				for (size_t cx=0;cx<srcMap->size_x;cx++,destCell++)
+					(*destCell) += w * srcCell[cx];
+			}
 
 		}
 
 		// Copy to fixed point map:
-		std::vector<float>::iterator							srcCell;
-		std::vector<COccupancyGridMap2D::cellType>::iterator	destCell = averageMap.m_gridMaps[0]->map.begin();
+		COccupancyGridMap2D *destMap = averageMap.m_gridMaps[0].pointer();
+		std::vector<float>::const_iterator	srcCell = floatMap.begin();
 
-		ASSERT_( averageMap.m_gridMaps[0]->map.size() == floatMap.size() );
+		ASSERT_( destMap->map.size() == floatMap.size() );
 
-		for (srcCell=floatMap.begin();srcCell!=floatMap.end();srcCell++,destCell++)
-			*destCell = static_cast<COccupancyGridMap2D::cellType>( *srcCell );
+		for (size_t cy=0;cy<destMap->size_y;cy++)
+		{
+			COccupancyGridMap2D::cellType	*destCell = destMap->map.getRowForWrite(cy);
+			for (size_t cx=0;cx<destMap->size_x;cx++,srcCell++)
+				destCell[cx] = static_cast<COccupancyGridMap2D::cellType>( *srcCell );
+		}
 
 		MRPT_END
 	}	// End of SSE not supported
@@ -560,15 +588,32 @@ void  CMultiMetricMapPDF::insertObservation(CSensoryFrame	&sf)
 		CSensoryFramePtr( new CSensoryFrame(sf) ) );
 	SF2robotPath.push_back( m_particles[0].d->robotPath.size()-1 );
 
-	for (size_t i=0;i<M;i++)
+	// Each particle has its own map, so all of them can be updated at once. The first one goes alone, so
+	//  data lazily computed by the observations themselves (e.g. their points maps) is ready for the rest:
+	CTimeLoggerEntry tle(m_timeLogger,"CMultiMetricMapPDF.insertObservation");
+	const TParticleMapsUpdater updater(m_particles,sf);
+	if (M>0)
+		updater( mrpt::system::BlockedRange(0,1) );
+	if (M>1)
 	{
-		const CPose3D robotPose(*getLastPose(i));
-		sf.insertObservationsInto( &m_particles[i].d->mapTillNow, &robotPose );
+		if (canProcessParticlesInParallel())
+			mrpt::system::parallel_for( mrpt::system::BlockedRange(1,static_cast<int>(M)), updater );
+		else updater( mrpt::system::BlockedRange(1,static_cast<int>(M)) );
 	}
 
 	averageMapIsUpdated = false;
 }
 
+/*---------------------------------------------------------------
+					canProcessParticlesInParallel
+ ---------------------------------------------------------------*/
+bool CMultiMetricMapPDF::canProcessParticlesInParallel() const
+{
+	if (m_particles.empty()) return true;
+	const CMultiMetricMap &m = m_particles[0].d->mapTillNow;   // All the particles have the same kinds of maps
+	return !m.m_beaconMap.present() && !m.m_landmarksMap.present();
+}
+
 /*---------------------------------------------------------------
 						getPath
  ---------------------------------------------------------------*/
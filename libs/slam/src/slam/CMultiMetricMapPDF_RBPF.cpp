@@ -24,6 +24,7 @@
 #include <mrpt/slam/CSimplePointsMap.h>
 #include <mrpt/slam/CLandmarksMap.h>
 #include <mrpt/math.h>
+#include <mrpt/system/parallelization.h>
 
 #include <mrpt/slam/PF_aux_structs.h>
 
@@ -908,3 +909,60 @@ double CMultiMetricMapPDF::PF_SLAM_computeObservationLikelihoodForParticle(
 	return ret;
 }
 
+namespace
+{
+	/** Evaluates PF_SLAM_computeObservationLikelihoodForParticle() for each particle in a range. */
+	struct TParticleLikelihoodEvaluator
+	{
+		const CMultiMetricMapPDF							&pdf;
+		const CParticleFilter::TParticleFilterOptions	&PF_options;
+		const CSensoryFrame								&observation;
+		const std::vector<TPose3D>						&x;
+		vector_double									&out_log_liks;
+
+		TParticleLikelihoodEvaluator(
+			const CMultiMetricMapPDF &_pdf,
+			const CParticleFilter::TParticleFilterOptions &_PF_options,
+			const CSensoryFrame &_observation,
+			const std::vector<TPose3D> &_x,
+			vector_double &_out_log_liks ) :
+				pdf(_pdf), PF_options(_PF_options), observation(_observation), x(_x), out_log_liks(_out_log_liks)
+		{ }
+
+		void operator()(const mrpt::system::BlockedRange &r) const
+		{
+			for (int i=r.begin();i!=r.end();++i)
+				out_log_liks[i] = pdf.PF_SLAM_computeObservationLikelihoodForParticle(PF_options,i,observation,CPose3D(x[i]));
+		}
+	};
+}
+
+/*---------------------------------------------------------------
+ Evaluate the observation likelihood for all the
+   particles at once, each one with its own map
+ ---------------------------------------------------------------*/
+void CMultiMetricMapPDF::PF_SLAM_computeObservationLikelihoodForParticles(
+	const CParticleFilter::TParticleFilterOptions	&PF_options,
+	const CSensoryFrame		&observation,
+	const std::vector<TPose3D>	&x,
+	vector_double			&out_log_liks ) const
+{
+	CTimeLoggerEntry tle(m_timeLogger,"CMultiMetricMapPDF.computeObservationLikelihoodForParticles");
+
+	const size_t N = x.size();
+	ASSERT_(N<=m_particles.size())
+	out_log_liks.resize(N);
+	if (!N) return;
+
+	// Each particle is evaluated against its own map, so each output value doesn't depend on the
+	//  number of threads. The first one goes alone, so data lazily computed by the observations
+	//  themselves (e.g. their points maps) is ready for the rest:
+	const TParticleLikelihoodEvaluator evaluator(*this,PF_options,observation,x,out_log_liks);
+	evaluator( mrpt::system::BlockedRange(0,1) );
+	if (N>1)
+	{
+		if (canProcessParticlesInParallel())
+			mrpt::system::parallel_for( mrpt::system::BlockedRange(1,static_cast<int>(N)), evaluator );
+		else evaluator( mrpt::system::BlockedRange(1,static_cast<int>(N)) );
+	}
+}
@@ -0,0 +1,89 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/slam.h>
+#include <mrpt/random.h>
+#include <mrpt/system/parallelization.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::utils;
+using namespace mrpt::poses;
+using namespace mrpt::random;
+using namespace std;
+
+// Inserts two range-only observations into a RBPF map of Monte-Carlo beacons (which draw random samples while
+//  inserting), with a given number of threads, and returns the samples of all the beacons of all the particles:
+static std::vector<double> insertBeaconObservations(const unsigned int nThreads)
+{
+	const unsigned int old_nThreads = mrpt::system::getParallelizationThreadsCount();
+	mrpt::system::setParallelizationThreadsCount(nThreads);
+	randomGenerator.randomize(1234);
+
+	TSetOfMetricMapInitializers inits;
+	TMetricMapInitializer init;
+	init.metricMapClassType = CLASS_ID(CBeaconMap);
+	init.beaconMap_options.insertionOpts.insertAsMonteCarlo = true;
+	init.beaconMap_options.insertionOpts.MC_performResampling = true;
+	inits.push_back(init);
+
+	CParticleFilter::TParticleFilterOptions pf_opts;
+	pf_opts.sampleSize = 16;
+	CMultiMetricMapPDF pdf(pf_opts,&inits);
+	for (size_t i=0;i<pdf.m_particles.size();i++)
+		pdf.m_particles[i].d->robotPath.back() = TPose3D(0.1*i,-0.05*i,0,0.01*i,0,0);
+
+	for (int step=0;step<2;step++)
+	{
+		CObservationBeaconRangesPtr obs = CObservationBeaconRanges::Create();
+		obs->minSensorDistance = 0.1f;
+		obs->maxSensorDistance = 20;
+		for (int b=0;b<3;b++)
+		{
+			CObservationBeaconRanges::TMeasurement m;
+			m.beaconID = b;
+			m.sensedDistance = 2.0f + b + 0.2f*step;
+			obs->sensedData.push_back(m);
+		}
+		CSensoryFrame sf;
+		sf.insert(obs);
+		pdf.insertObservation(sf);
+	}
+
+	std::vector<double> samples;
+	for (size_t i=0;i<pdf.m_particles.size();i++)
+	{
+		const CBeaconMapPtr &beacons = pdf.m_particles[i].d->mapTillNow.m_beaconMap;
+		EXPECT_EQ(beacons->size(), 3u);
+		for (CBeaconMap::const_iterator b=beacons->begin();b!=beacons->end();++b)
+		{
+			const CPointPDFParticles::CParticleList &parts = b->m_locationMC.m_particles;
+			EXPECT_FALSE(parts.empty());
+			for (size_t k=0;k<parts.size();k++)
+			{
+				samples.push_back(parts[k].d->x);
+				samples.push_back(parts[k].d->y);
+				samples.push_back(parts[k].d->z);
+				samples.push_back(parts[k].log_w);
+			}
+		}
+	}
+
+	mrpt::system::setParallelizationThreadsCount(old_nThreads);
+	return samples;
+}
+
+TEST(CMultiMetricMapPDF, InsertBeaconsIndependentOfThreads)
+{
+	const std::vector<double> seq = insertBeaconObservations(1);
+	ASSERT_FALSE(seq.empty());
+	for (int rep=0;rep<3;rep++)
+		EXPECT_EQ(seq, insertBeaconObservations(4)) << "rep=" << rep;
+}
@@ -10,6 +10,7 @@
 #define CLandmarksMap_H
 
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/vision/descriptor_index.h>
 #include <mrpt/slam/CMetricMap.h>
 #include <mrpt/slam/CLandmark.h>
 #include <mrpt/slam/CObservationImage.h>
@@ -109,6 +110,13 @@ namespace slam
 			  */
 			mutable bool	m_largestDistanceFromOriginIsUpdated;
 
+			/** An index of the SIFT descriptors of the landmarks, updated lazily in getSIFTDescriptorIndex()
+			  * \sa getSIFTDescriptorIndex
+			  */
+			mutable mrpt::vision::CDescriptorKDForest	m_SIFT_index;
+			mutable std::vector<int>			m_SIFT_index_lm2id;  //!< For each landmark already seen by m_SIFT_index, the ID of its descriptor (-1 if it has none)
+			mutable std::vector<unsigned int>	m_SIFT_index_id2lm;  //!< For each ID in m_SIFT_index, the index of its landmark
+
 		public:
 			/** Default constructor
 			  */
@@ -148,6 +156,15 @@ namespace slam
 			  */
 			float  getLargestDistanceFromOrigin() const;
 
+			/** Returns an index of the SIFT descriptors of all the SIFT landmarks, for (approximate) nearest neighbor searches of descriptors in sublinear time.
+			  *  The index is kept between calls and only updated with the landmarks inserted or erased since the previous one, so the descriptors of the
+			  *  landmarks must not be modified once they are in the map. The landmark of each descriptor in the index is given by getSIFTDescriptorIndexLandmark().
+			  */
+			const mrpt::vision::CDescriptorKDForest & getSIFTDescriptorIndex() const;
+
+			/** The index of the landmark whose descriptor has the ID \a id in getSIFTDescriptorIndex() */
+			inline unsigned int getSIFTDescriptorIndexLandmark(const size_t id) const { return m_SIFT_index_id2lm[id]; }
+
 		} landmarks;
 
 		 /** Constructor
@@ -217,13 +234,13 @@ namespace slam
 			float	SiftLikelihoodThreshold;
 
 			/****************************************** FAMD ******************************************/
-			/** [For SIFT landmarks only] The minimum Euclidean Descriptor Distance value of a match to set as correspondence (Default=200)
+			/** [For SIFT landmarks only] The maximum Euclidean Descriptor Distance value of a match to set as correspondence (Default=200)
 			  */
 			float	SiftEDDThreshold;
 
 			/** [For SIFT landmarks only] Method to compute 3D matching (Default = 0 (Our method))
 			  * 0: Our method -> Euclidean Distance between Descriptors and 3D position
-			  * 1: Sim, Elinas, Griffin, Little -> Euclidean Distance between Descriptors
+			  * 1: Sim, Elinas, Griffin, Little -> Euclidean Distance between Descriptors (the closest descriptor is searched in TCustomSequenceLandmarks::getSIFTDescriptorIndex())
 			  */
 			unsigned int SIFTMatching3DMethod;
 
@@ -29,6 +29,10 @@
 #include <mrpt/vision/tracking.h>
 #include <mrpt/vision/descriptor_kdtrees.h>
 #include <mrpt/vision/descriptor_pairing.h>
+#include <mrpt/vision/descriptor_hamming.h>
+#include <mrpt/vision/descriptor_index.h>
+#include <mrpt/vision/CVocabularyTree.h>
+#include <mrpt/vision/CBoWDatabase.h>
 #include <mrpt/vision/bundle_adjustment.h>
 #include <mrpt/vision/CUndistortMap.h>
 #include <mrpt/vision/CStereoRectifyMap.h>
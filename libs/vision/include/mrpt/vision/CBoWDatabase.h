@@ -0,0 +1,96 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef mrpt_vision_CBoWDatabase_H
+#define mrpt_vision_CBoWDatabase_H
+
+#include <mrpt/vision/CVocabularyTree.h>
+
+namespace mrpt
+{
+	namespace vision
+	{
+		/** \addtogroup mrptvision_bow
+		  *   @{  */
+
+		DEFINE_SERIALIZABLE_PRE_CUSTOM_BASE_LINKAGE( CBoWDatabase, mrpt::utils::CSerializable, VISION_IMPEXP )
+
+		/** A database of images (e.g. the keyframes of a map) as bag-of-words vectors, with inverted files for finding the most similar ones to a query image.
+		  *
+		  *  For each word of the vocabulary, the database keeps the list of entries where the word appears, with its weight, so a query only visits the entries which
+		  *  share at least one word with the query image instead of all the entries. The similarity of two images is scored with the L1 distance of their
+		  *  (L1-normalized) bag-of-words vectors, as in (D. Nister, H. Stewenius, "Scalable Recognition with a Vocabulary Tree", CVPR 2006):
+		  *  \f[ s(q,d) = 1 - \frac{1}{2} \left| q - d \right|_1 = \frac{1}{2} \sum_{i | q_i \neq 0, d_i \neq 0} \left( q_i + d_i - \left|q_i-d_i\right| \right) \f]
+		  *  which is 1 for identical vectors and 0 for vectors without words in common, and only depends on the words that the query shares with each entry.
+		  *
+		  *  Entries are identified by consecutive IDs from 0, in the order they were added. So, if one entry is added for each keyframe of a map in order,
+		  *  the entry IDs are the keyframe IDs, as in mrpt::srba::RbaEngine (mrpt::srba::TKeyFrameID).
+		  *
+		  *  Example of usage, to look for loop closure candidates among all the keyframes but the last 20:
+		  *  \code
+		  *    CBoWDatabase db;
+		  *    ...
+		  *    TBoWVector bow;
+		  *    voc.transform(new_keyframe_feats, bow);  // voc is a CVocabularyTree
+		  *    std::vector<size_t> ids;
+		  *    std::vector<double> scores;
+		  *    if (db.size()>20)
+		  *      db.query(bow, 5, ids, scores, db.size()-20);
+		  *    db.add(bow);
+		  *  \endcode
+		  *
+		  * \sa CVocabularyTree
+		  */
+		class VISION_IMPEXP CBoWDatabase : public mrpt::utils::CSerializable
+		{
+			DEFINE_SERIALIZABLE( CBoWDatabase )
+
+		public:
+			CBoWDatabase();
+
+			/** Removes all the entries */
+			void clear();
+
+			/** Adds a bag-of-words vector (see CVocabularyTree::transform()) as a new entry
+			  * \return The ID of the entry (the number of entries before this one)
+			  */
+			size_t add(const TBoWVector &bow);
+
+			inline size_t size() const { return m_entries.size(); }   //!< Number of entries
+			inline bool   empty() const { return m_entries.empty(); }
+			inline const TBoWVector &getEntry(const size_t id) const { return m_entries[id]; } //!< The bag-of-words vector of an entry
+
+			/** Finds the \a k entries most similar to a bag-of-words vector, sorted by decreasing score, among those with an ID below \a max_id.
+			  *  Entries without any word in common with the query are never returned.
+			  * \param[out] out_ids The IDs of the entries.
+			  * \param[out] out_scores The similarity scores, in the range [0,1] (see score()).
+			  * \return The number of entries found.
+			  */
+			size_t query(
+				const TBoWVector    & bow,
+				const size_t          k,
+				std::vector<size_t> & out_ids,
+				std::vector<double> & out_scores,
+				const size_t          max_id = static_cast<size_t>(-1) ) const;
+
+			/** The similarity score between two bag-of-words vectors, in the range [0,1] (1 for identical vectors) */
+			static double score(const TBoWVector &a, const TBoWVector &b);
+
+		private:
+			typedef std::vector<std::pair<uint32_t,float> > TInvertedFile; //!< The (entry ID, weight) of the entries where a word appears, sorted by entry ID
+
+			std::vector<TBoWVector>    m_entries;        //!< The bag-of-words vector of each entry
+			std::vector<TInvertedFile> m_inverted_files; //!< The inverted file of each word
+		}; // end of class
+
+		/** @} */
+	}
+}
+
+#endif
@@ -99,6 +99,7 @@ namespace mrpt
 				mrpt::math::CMatrix			    LogPolarImg;	        //!< A log-polar image centered at the interest point
 				bool						    polarImgsNoRotation;    //!< If set to true (manually, default=false) the call to "descriptorDistanceTo" will not consider all the rotations between polar image descriptors (PolarImg, LogPolarImg)
 				deque<vector<vector<int32_t> > >    multiSIFTDescriptors;   //!< A set of SIFT-like descriptors for each orientation and scale of the multiResolution feature (there is a vector of descriptors for each scale)
+				std::vector<uint8_t>	        ORB;			        //!< Binary ORB descriptor: 256 bits packed in 32 bytes (bit "i" is "(ORB[i/8]>>(i%8)) & 1")
 
 				bool hasDescriptorSIFT() const { return !SIFT.empty(); };                       //!< Whether this feature has this kind of descriptor
 				bool hasDescriptorSURF() const { return !SURF.empty(); }                        //!< Whether this feature has this kind of descriptor
@@ -108,6 +109,7 @@ namespace mrpt
 				bool hasDescriptorMultiSIFT() const {
                     return (multiSIFTDescriptors.size() > 0 && multiSIFTDescriptors[0].size() > 0); //!< Whether this feature has this kind of descriptor
                 }
+				bool hasDescriptorORB() const { return !ORB.empty(); }                          //!< Whether this feature has this kind of descriptor
 			}
 			descriptors;
 
@@ -123,6 +125,7 @@ namespace mrpt
 			float patchCorrelationTo( const CFeature &oFeature) const;
 
 			/** Computes the Euclidean Distance between this feature's and other feature's descriptors, using the given descriptor or the first present one.
+			  *  For binary descriptors (ORB), this is the Hamming distance (divided by the number of bits if normalize_distances=true).
 			  *  \note If descriptorToUse is not descAny and that descriptor is not present in one of the features, an exception will be raised.
 			  * \sa patchCorrelationTo
 			  */
@@ -134,6 +137,9 @@ namespace mrpt
 			/** Computes the Euclidean Distance between "this" and the "other" descriptors */
 			float descriptorSURFDistanceTo( const CFeature &oFeature, bool normalize_distances = true  ) const;
 
+			/** Computes the Hamming distance (number of different bits) between "this" and the "other" ORB descriptors \sa mrpt::vision::hammingDistance */
+			uint32_t descriptorORBDistanceTo( const CFeature &oFeature ) const;
+
 			/** Computes the Euclidean Distance between "this" and the "other" descriptors */
 			float descriptorSpinImgDistanceTo( const CFeature &oFeature, bool normalize_distances = true ) const;
 
@@ -14,6 +14,7 @@
 #include <mrpt/vision/utils.h>
 #include <mrpt/vision/CFeature.h>
 #include <mrpt/vision/TSimpleFeature.h>
+#include <mrpt/vision/CImagePyramid.h>
 
 namespace mrpt
 {
@@ -37,6 +38,7 @@ namespace mrpt
 		  *		- SURF: OpenCV's implementation of SURF detector and descriptor.
 		  *		- The FAST feature detector (OpenCV's implementation)
 		  *		- The FASTER (9,10,12) detectors (Edward Rosten's libcvd implementation optimized for SSE2).
+		  *		- The FASTER detectors over an image pyramid, evenly spread with a grid of cells processed in parallel (see CFeatureExtraction::detectFeaturesPyramid).
 		  *
 		  *  Additionally, given a list of interest points onto an image, the following
 		  *   <b>descriptors</b> can be computed for each point by calling CFeatureExtraction::computeDescriptors :
@@ -45,12 +47,14 @@ namespace mrpt
 		  *		- Intensity-domain spin images (SpinImage): Creates a vector descriptor with the 2D histogram as a single row.
 		  *		- A circular patch in polar coordinates (Polar images): The matrix descriptor is a 2D polar image centered at the interest point.
 		  *		- A log-polar image patch (Log-polar images): The matrix descriptor is the 2D log-polar image centered at the interest point.
+		  *		- ORB (oriented BRIEF): A 256-bit binary descriptor of smoothed intensity comparisons, steered by the intensity centroid orientation. Matched by Hamming distance (see mrpt::vision::hammingDistance).
 		  *
 		  *
 		  *  Apart from the normal entry point \a detectFeatures(), these other low-level static methods are provided for convenience:
 		  *   - CFeatureExtraction::detectFeatures_SSE2_FASTER9()
 		  *   - CFeatureExtraction::detectFeatures_SSE2_FASTER10()
 		  *   - CFeatureExtraction::detectFeatures_SSE2_FASTER12()
+		  *   - CFeatureExtraction::detectFeatures_SSE2_FASTER_grid()
 		  *
 		  * \note The descriptor "Intensity-domain spin images" is described in "A sparse texture representation using affine-invariant regions", S Lazebnik, C Schmid, J Ponce, 2003 IEEE Computer Society Conference on Computer Vision.
 		  * \sa mrpt::vision::CFeature
@@ -139,6 +143,15 @@ namespace mrpt
 					bool    use_KLT_response; //!< (default=false) If true, use CImage::KLT_response to compute the response at each point instead of the FAST "standard response".
 				} FASTOptions;
 
+				/** Options of the grid-bucketed FASTER detector over image pyramids (see CFeatureExtraction::detectFeaturesPyramid) */
+				struct VISION_IMPEXP TPyramidGridOptions
+				{
+					unsigned int nOctaves;       //!< (default=3) Number of octaves of the pyramid built by detectFeaturesPyramid()
+					bool         smooth_halves;  //!< (default=true) Whether to build the pyramid with smoothed half images (see CImagePyramid::buildPyramid)
+					unsigned int cell_size;      //!< (default=64) Size of the square cells (in pixels of each octave) in which features are detected in parallel and bucketed
+					int          min_threshold;  //!< (default=7) Cells with less features than their share are detected again halving FASTOptions.threshold, down to this value
+				} PyramidGridOptions;
+
 				/** SIFT Options  */
 				struct VISION_IMPEXP TSIFTOptions
 				{
@@ -190,6 +203,13 @@ namespace mrpt
 					double rho_scale;			//!< (default=5) Log-Polar image patch will have dimensions WxH, with:  W=num_angles,  H= rho_scale * log(radius)
 				} LogPolarImagesOptions;
 
+				/** ORBOptions Options
+				  */
+				struct VISION_IMPEXP TORBOptions
+				{
+					bool rotation_invariant;	//!< (default=true) Steer the binary tests with the orientation of each feature (computed by the intensity centroid method), so the descriptor is invariant to in-plane rotations.
+				} ORBOptions;
+
 			};
 
 			TOptions options;  //!< Set all the parameters of the desired method here before calling "detectFeatures"
@@ -218,6 +238,36 @@ namespace mrpt
                                     const CMatrixBool       * mask = NULL ) const; // Important: This was a const ref. in mrpt <0.9.4, but the instantiation of a default value
 			                                                                       // for CMatrixBool being a template generated duplicated linking errors for MSVC, thus it was changed to a pointer.
 
+			/** Detects FASTER corners (of the kind given in options.featsType: featFASTER9, featFASTER10 or featFASTER12) in all the octaves of an image pyramid,
+			*    evenly spread over each image. Each octave is divided into square cells (TOptions::TPyramidGridOptions::cell_size) which are processed
+			*    in parallel threads (see mrpt::system::parallel_for), such as each cell keeps its share of the desired number of features:
+			*     - Corners are detected with FASTOptions.threshold. If a cell has less corners than its share, detection is repeated with
+			*       halved thresholds down to TOptions::TPyramidGridOptions::min_threshold, so low-textured areas also get features.
+			*     - Corners are ranked by their KLT response and those closer than FASTOptions.min_distance (in pixels of their octave) to a better one are discarded.
+			*     - Each cell keeps its best corners up to its share. If the total is below \a nDesiredFeatures, the best remaining corners of all the cells fill the gap.
+			*
+			*   The share of each octave is proportional to its area.
+			*   Features are returned in a single list, with coordinates in the full resolution image and CFeature::scale=2^octave.
+			*   Patches (if options.patchSize>0) are taken from the octave image where each feature was found.
+			*
+			* \param nDesiredFeatures Number of features to detect in all the octaves. Default: all possible.
+			* \param out_pyramid If provided, the pyramid built for detection is saved here, e.g. for later tracking.
+			* \sa detectFeatures_SSE2_FASTER_grid, options.PyramidGridOptions
+			*/
+			void  detectFeaturesPyramid(
+				const CImage            & img,
+				CFeatureList            & feats,
+				const unsigned int      init_ID = 0,
+				const unsigned int      nDesiredFeatures = 0,
+				CImagePyramid           * out_pyramid = NULL ) const;
+
+			/** \overload For an already built image pyramid (grayscale) */
+			void  detectFeaturesPyramid(
+				const CImagePyramid     & pyramid,
+				CFeatureList            & feats,
+				const unsigned int      init_ID = 0,
+				const unsigned int      nDesiredFeatures = 0 ) const;
+
 			/** Compute one (or more) descriptors for the given set of interest points onto the image, which may have been filled out manually or from \a detectFeatures
 			* \param in_img (input) The image from where to compute the descriptors.
 			* \param inout_features (input/output) The list of features whose descriptors are going to be computed.
@@ -303,6 +353,15 @@ namespace mrpt
 				uint8_t octave = 0,
 				std::vector<size_t> * out_feats_index_by_row = NULL );
 
+			/** The low-level grid-bucketed detector of \a detectFeaturesPyramid(): only the pt.{x,y} (in the 0-level image), octave and response fields are filled out for each feature.
+			  *  The pyramid images must be grayscale. Parameters are taken from \a opts: featsType, patchSize (to leave a margin for patches), FASTOptions and PyramidGridOptions.
+			  * \ingroup mrptvision_features */
+			static void detectFeatures_SSE2_FASTER_grid(
+				const CImagePyramid &pyramid,
+				TSimpleFeatureList & corners,
+				const TOptions &opts,
+				const size_t nDesiredFeatures = 0 );
+
 			/** @} */
 
 		private:
@@ -351,6 +410,15 @@ namespace mrpt
 			void  internal_computeLogPolarImageDescriptors( const CImage	&in_img,
 										  CFeatureList		&in_features) const;
 
+			/** Compute the ORB (oriented BRIEF) binary descriptor of the provided features into the input image
+			* \param in_img (input) The image from where to compute the descriptors.
+			* \param in_features (input/output) The list of features whose descriptors are going to be computed.
+			*
+			* \note Additional parameters from CFeatureExtraction::TOptions::ORBOptions are used in this method.
+			*/
+			void  internal_computeORBDescriptors( const CImage	&in_img,
+										  CFeatureList		&in_features) const;
+
 			/** Select good features using the openCV implementation of the KLT method.
 			* \param img (input) The image from where to select extract the images.
 			* \param feats (output) A complete list of features (containing a patch for each one of them if options.patchsize > 0).
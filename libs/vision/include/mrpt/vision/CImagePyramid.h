@@ -45,7 +45,10 @@ namespace mrpt
 		  *   ...
 		  * \endcode
 		  *
-		  *  \note Both converting to grayscale and building the octave images have SSE2-optimized implementations (if available).
+		  *  The Scharr gradients of all the octaves of grayscale pyramids can be also computed and kept along the images, with \a buildGradients(),
+		  *  so they can be reused for all the features tracked in the pyramid (see CFeatureTracker_KL).
+		  *
+		  *  \note Both converting to grayscale and building the octave images have SSE2-optimized implementations (if available). So has computing the gradients.
 		  *
 		  * \sa mrpt::utils::CImage
 		  * \ingroup mrpt_vision_grp 
@@ -71,12 +74,37 @@ namespace mrpt
 			  */
 			void buildPyramidFast(mrpt::utils::CImage &img, const size_t nOctaves, const bool smooth_halves = true, const bool convert_grayscale = false );
 
+			/** Computes the Scharr gradients of all the octaves into \a gradients, if they were not already computed for the current images.
+			  *  Rows are processed in parallel (see mrpt::system::parallel_for). The pyramid must be grayscale.
+			  * \sa hasGradients
+			  */
+			void buildGradients();
+
+			/** Whether \a gradients are up to date with \a images (they are discarded by buildPyramid() and buildPyramidFast()) */
+			inline bool hasGradients() const { return !images.empty() && gradients.size()==images.size(); }
+
+			/** The horizontal and vertical gradients of one octave, computed by buildGradients() with the Scharr operator
+			  *  (the kernel [-3 0 3; -10 0 10; -3 0 3] and its transpose, with replicated borders).
+			  *  Values are in fixed point: 32 times the derivative of the intensity, in intensity units per pixel.
+			  */
+			struct VISION_IMPEXP TImageGradients
+			{
+				size_t width, height;
+				std::vector<int16_t> dx, dy;  //!< Gradients, row after row (width*height)
+
+				inline const int16_t *dx_row(const size_t row) const { return &dx[row*width]; }
+				inline const int16_t *dy_row(const size_t row) const { return &dy[row*width]; }
+			};
+
 			/** The individual images:
 			  *  - images[0]: 1st octave (full-size)
 			  *  - images[1]: 2nd octave (1/2 size)
 			  *  - images[2]: 3rd octave (1/4 size)
 			  */
 			std::vector<mrpt::utils::CImage>  images;
+
+			/** The gradients of each image in \a images, only if computed with buildGradients() */
+			std::vector<TImageGradients>      gradients;
 		};
 
 	}
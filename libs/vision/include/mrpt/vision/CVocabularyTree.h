@@ -0,0 +1,134 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef mrpt_vision_CVocabularyTree_H
+#define mrpt_vision_CVocabularyTree_H
+
+#include <mrpt/vision/types.h>
+#include <mrpt/vision/CFeature.h>
+#include <mrpt/utils/CSerializable.h>
+
+namespace mrpt
+{
+	namespace vision
+	{
+		/** \addtogroup mrptvision_bow Bag of visual words
+		  *  \ingroup mrpt_vision_grp
+		  *   @{  */
+
+		/** A bag-of-words vector: the pairs (word ID, weight) of the words present in an image, sorted by word ID, with weights which add up to 1 (L1-normalized).
+		  * \sa CVocabularyTree::transform(), CBoWDatabase
+		  */
+		typedef std::vector<std::pair<uint32_t,float> > TBoWVector;
+
+		DEFINE_SERIALIZABLE_PRE_CUSTOM_BASE_LINKAGE( CVocabularyTree, mrpt::utils::CSerializable, VISION_IMPEXP )
+
+		/** A vocabulary of visual words organized as a tree of cluster centers obtained by hierarchical k-means (D. Nister, H. Stewenius, "Scalable Recognition with a Vocabulary Tree", CVPR 2006).
+		  *
+		  *  The vocabulary is learnt offline with train() from the descriptors of a set of training images (see the application "bow-vocabulary-train"):
+		  *  their descriptors are split into TParams::branching clusters by mrpt::math::kmeans(), each cluster is split again in the same way, and so on down to TParams::depth levels.
+		  *  The leaves of the tree are the words of the vocabulary, each one with a weight which is its "inverse document frequency" in the training images, log(N/N_i).
+		  *  Each descriptor is assigned the word found by descending from the root to the closest child center at each level, so the cost of looking up a word is
+		  *  logarithmic in the size of the vocabulary (e.g. 60 distance computations for 10^6 words with branching=10, depth=6).
+		  *
+		  *  Real-valued descriptors (SIFT, SURF, spin images) are clustered in Euclidean distance. For ORB, whose distance is Hamming, each bit of the descriptor is taken as a
+		  *  coordinate valued 0 or 1, so squared Euclidean distances between descriptors are their Hamming distances.
+		  *
+		  *  Images are converted with transform() into bag-of-words vectors (TBoWVector), which can be stored in a CBoWDatabase to find the most similar ones to a query image.
+		  *
+		  *  Example of usage:
+		  *  \code
+		  *    CVocabularyTree  voc;
+		  *    voc.params.branching = 10;
+		  *    voc.params.depth = 5;
+		  *    voc.train(training_images, descORB);  // A std::vector<CFeatureList>, with the descriptors of each training image
+		  *
+		  *    TBoWVector bow;
+		  *    voc.transform(frame_feats, bow);
+		  *  \endcode
+		  *
+		  * \sa CBoWDatabase
+		  */
+		class VISION_IMPEXP CVocabularyTree : public mrpt::utils::CSerializable
+		{
+			DEFINE_SERIALIZABLE( CVocabularyTree )
+
+		public:
+			/** Parameters of the training of the vocabulary. They are stored along with the vocabulary. */
+			struct VISION_IMPEXP TParams
+			{
+				TParams();
+
+				unsigned int branching;          //!< Number of children of each node ("k" of the k-means) (Default=10)
+				unsigned int depth;              //!< Maximum number of levels below the root; the vocabulary has up to branching^depth words (Default=6)
+				unsigned int kmeansAttempts;     //!< Number of runs of k-means for each node, of which the best clustering is kept (Default=1)
+				size_t       maxSamplesPerNode;  //!< Maximum number of descriptors (taken evenly among all of them) used to cluster each node; the rest are just assigned to the closest center (Default=20000)
+			};
+
+			TParams params; //!< Parameters of the training of the vocabulary
+
+			CVocabularyTree();
+
+			/** Empties the vocabulary */
+			void clear();
+
+			/** Learns the vocabulary from the descriptors of a set of training images, which must all have the same length.
+			  *  All the descriptors are copied into memory as vectors of floats while training, i.e. 4 bytes per value: 512 bytes for each SIFT descriptor of 128 values,
+			  *  but 1 KiB for each ORB descriptor of 32 bytes (one float per bit, 32 times its size). For example, 10^6 ORB descriptors take 1 GiB, on top of the \a images themselves.
+			  *  Use a subset of the training images (or less features per image) if that doesn't fit in memory.
+			  * \param images The features of each training image.
+			  * \param descriptor The kind of descriptor to use: descSIFT, descSURF, descSpinImages or descORB. Features without it are ignored.
+			  * \exception std::exception If there are no descriptors of the given kind, or of different lengths.
+			  */
+			void train(const std::vector<CFeatureList> &images, const TDescriptorType descriptor);
+
+			inline bool            empty() const { return m_words.empty(); }            //!< Whether the vocabulary has not been trained or loaded yet
+			inline size_t          getWordCount() const { return m_words.size(); }      //!< Number of words of the vocabulary
+			inline TDescriptorType getDescriptorType() const { return m_descriptor; }   //!< The kind of descriptor of the vocabulary
+			inline size_t          getDescriptorLength() const { return m_dim; }        //!< The length of each descriptor, as a vector of floats (i.e. bits for ORB)
+			inline float           getWordWeight(const uint32_t word) const { return m_weights[word]; } //!< The "inverse document frequency" weight of a word
+
+			/** Finds the word of a descriptor, given as getDescriptorLength() floats (for ORB, one 0/1 value per bit; see getFloatDescriptor()) */
+			uint32_t quantize(const float *desc) const;
+
+			/** Converts the descriptors (of the kind of the vocabulary) of a list of features into a bag-of-words vector.
+			  *  The weight of each word is its frequency in the image (term frequency) times its weight in the vocabulary (inverse document frequency), normalized so all of them add up to 1.
+			  *  Features without the descriptor are ignored. Descriptors are quantized in parallel threads.
+			  * \param[out] out_words If not NULL, it's filled with the word of each feature (or -1 for features without the descriptor).
+			  */
+			void transform(const CFeatureList &feats, TBoWVector &out_bow, std::vector<int32_t> *out_words = NULL) const;
+
+			/** Copies the descriptor of a given kind of a feature as a vector of floats (for ORB, one 0/1 value per bit).
+			  * \return false if the feature has no descriptor of that kind.
+			  * \exception std::exception If the kind of descriptor is not SIFT, SURF, spin images or ORB.
+			  */
+			static bool getFloatDescriptor(const CFeature &f, const TDescriptorType descriptor, std::vector<float> &out);
+
+			/** A node of the tree: the node is a leaf (a word) if it has no children */
+			struct TNode
+			{
+				uint32_t firstChild; //!< Index of the first child in the vector of nodes (all the children are consecutive)
+				uint32_t nChildren;  //!< Number of children
+				int32_t  word;       //!< The word of a leaf, or -1
+			};
+
+		private:
+			TDescriptorType       m_descriptor; //!< The kind of descriptor
+			size_t                m_dim;        //!< Length of the descriptors
+			std::vector<TNode>    m_nodes;      //!< The nodes of the tree; the root is the first one
+			std::vector<float>    m_centers;    //!< The cluster center of each node (\a m_dim floats per node)
+			std::vector<uint32_t> m_words;      //!< The node of each word
+			std::vector<float>    m_weights;    //!< The weight of each word
+		}; // end of class
+
+		/** @} */
+	}
+}
+
+#endif
@@ -0,0 +1,138 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef mrpt_vision_descriptor_hamming_H
+#define mrpt_vision_descriptor_hamming_H
+
+#include <mrpt/vision/types.h>
+#include <mrpt/vision/CFeature.h>
+
+namespace mrpt
+{
+	namespace vision
+	{
+		/** \addtogroup  mrptvision_features
+		    @{ */
+
+		/** Returns the Hamming distance (the number of different bits) between two binary descriptors (e.g. ORB) of \a nBytes bytes each.
+		  *  It uses the POPCNT instruction if MRPT was built with SSE4 (or SSSE3 byte shuffles if only SSSE3 is available), and portable bit counting otherwise.
+		  * \sa CFeature::descriptorORBDistanceTo, find_descriptor_pairings_hamming
+		  */
+		uint32_t VISION_IMPEXP hammingDistance(const uint8_t *d1, const uint8_t *d2, const size_t nBytes);
+
+		/** Brute-force search of pairings between two sets of features with binary (ORB) descriptors.
+		  *  For each feature in \a feats_img1, the closest feature in \a feats_img2 (in Hamming distance) is paired with it if:
+		  *   - Its distance is not above \a max_distance bits, and
+		  *   - Its distance is below \a max_ratio times that of the second closest feature (ratio test), if there is more than one feature in \a feats_img2.
+		  *
+		  *  The descriptors of \a feats_img2 are first packed into a contiguous buffer, and the queries run in parallel threads (see mrpt::system::parallel_for).
+		  *  Pairings are sorted by the index in \a feats_img1.
+		  * \param[out] out_distances If not NULL, it's filled with the Hamming distance of each pairing.
+		  * \return The number of pairings.
+		  * \sa CHammingMultiIndex for large sets of descriptors, matchFeatures with TMatchingOptions::mmDescriptorORB
+		  */
+		size_t VISION_IMPEXP find_descriptor_pairings_hamming(
+			std::vector<std::pair<size_t,size_t> > & pairings_1_to_2,
+			const CFeatureList                     & feats_img1,
+			const CFeatureList                     & feats_img2,
+			const unsigned int                       max_distance = 64,
+			const double                             max_ratio = 0.8,
+			std::vector<uint32_t>                  * out_distances = NULL );
+
+		/** An index of binary descriptors for nearest neighbor searches in Hamming space, by "multi-index hashing"
+		  *  (M. Norouzi, A. Punjani, D.J. Fleet, "Fast Search in Hamming Space with Multi-Index Hashing", CVPR 2012).
+		  *
+		  *  Each descriptor is split into substrings of 16 bits, each one indexing a hash table. Two descriptors at a Hamming distance
+		  *  of D bits have, at least, one substring at a distance of floor(D/M) bits or less (M being the number of substrings), so a search up to
+		  *  a maximum distance only has to look into the buckets of the hash tables at that small distance of the query substrings,
+		  *  and then compare the full descriptors of the candidates found there. Searches whose maximum distance would require probing more than
+		  *  3 bits per substring fall back to a (SIMD) linear scan, which is faster for them.
+		  *
+		  *  Example of usage:
+		  *  \code
+		  *    CHammingMultiIndex  index;
+		  *    index.build(map_feats);  // Features with ORB descriptors
+		  *    std::vector<std::pair<size_t,size_t> > pairings;
+		  *    index.find_pairings(pairings, frame_feats, 40);  // Up to 40 bits of distance
+		  *  \endcode
+		  *
+		  *  The index keeps a copy of the descriptors, so it does not depend on the feature list after being built.
+		  * \sa find_descriptor_pairings_hamming
+		  */
+		class VISION_IMPEXP CHammingMultiIndex
+		{
+		public:
+			CHammingMultiIndex();
+
+			/** Empties the index */
+			void clear();
+
+			/** Builds the index from the ORB descriptors of a list of features, all of which must have one. */
+			void build(const CFeatureList &feats);
+
+			/** Builds the index from N descriptors of \a descriptorBytes bytes each (an even number), stored one after the other in \a descs */
+			void build(const uint8_t *descs, const size_t N, const size_t descriptorBytes);
+
+			inline size_t size() const { return m_N; }                        //!< Number of descriptors in the index
+			inline size_t getDescriptorBytes() const { return m_nBytes; }     //!< Length of each descriptor, in bytes
+			inline const uint8_t *getDescriptor(const size_t i) const { return &m_descs[i*m_nBytes]; } //!< The i'th indexed descriptor
+
+			/** Finds the closest descriptor to \a query, among those at a Hamming distance not above \a max_distance.
+			  * \param[out] out_dist_2nd The exact distance to the second closest descriptor, or std::numeric_limits<uint32_t>::max() if there is none within \a max_distance_2nd.
+			  * \param max_distance_2nd How far to look for the second closest descriptor (it is searched up to \a max_distance if this is smaller).
+			  *  The larger it is, the slower the search: find_pairings() uses the smallest one which tells whether the ratio test passes.
+			  * \return false if no descriptor was found within \a max_distance.
+			  */
+			bool nearest(
+				const uint8_t *query,
+				const unsigned int max_distance,
+				size_t &out_idx,
+				uint32_t &out_dist,
+				uint32_t &out_dist_2nd,
+				const unsigned int max_distance_2nd = 0) const;
+
+			/** \overload For many queries: it reuses the temporary buffers \a candidates and \a visited (which must have size()
+			  *  elements, all zero, and are left that way on return) instead of allocating them for each query. */
+			bool nearest(
+				const uint8_t *query,
+				const unsigned int max_distance,
+				size_t &out_idx,
+				uint32_t &out_dist,
+				uint32_t &out_dist_2nd,
+				const unsigned int max_distance_2nd,
+				std::vector<uint32_t> &candidates,
+				std::vector<uint8_t>  &visited) const;
+
+			/** Pairs the features in \a feats_img1 with the indexed descriptors, with the same criteria and in the same format as find_descriptor_pairings_hamming(),
+			  *  so both functions return the same pairings. The queries run in parallel threads.
+			  *  The ratio test requires searching for the second closest descriptor up to a distance of \a max_distance / \a max_ratio, so strict ratios make the search slower.
+			  */
+			size_t find_pairings(
+				std::vector<std::pair<size_t,size_t> > & pairings_1_to_2,
+				const CFeatureList                     & feats_img1,
+				const unsigned int                       max_distance = 64,
+				const double                             max_ratio = 0.8,
+				std::vector<uint32_t>                  * out_distances = NULL ) const;
+
+		private:
+			size_t                m_nBytes; //!< Bytes per descriptor
+			size_t                m_N;      //!< Number of descriptors
+			std::vector<uint8_t>  m_descs;  //!< All the descriptors, one after the other
+			std::vector<std::vector<uint32_t> > m_bucket_starts; //!< For each substring: where each bucket starts in m_bucket_idxs (65537 entries)
+			std::vector<std::vector<uint32_t> > m_bucket_idxs;   //!< For each substring: the indices of all the descriptors, sorted by the value of that substring
+
+			/** Adds to \a out_candidates the indices of the descriptors with any substring within \a radius bits of those of \a query (without duplicates, marking them in \a visited) */
+			void getCandidates(const uint8_t *query, const unsigned int radius, std::vector<uint32_t> &out_candidates, std::vector<uint8_t> &visited) const;
+		};
+
+		/** @} */
+	}
+}
+#endif
+
@@ -0,0 +1,253 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef mrpt_vision_descriptor_index_H
+#define mrpt_vision_descriptor_index_H
+
+#include <mrpt/vision/types.h>
+#include <mrpt/vision/CFeature.h>
+#include <mrpt/utils/CSerializable.h>
+
+namespace mrpt
+{
+	namespace vision
+	{
+		/** \addtogroup  mrptvision_descr_kdtrees
+		    @{ */
+
+		DEFINE_SERIALIZABLE_PRE_CUSTOM_BASE_LINKAGE( CDescriptorKDForest, mrpt::utils::CSerializable, VISION_IMPEXP )
+		DEFINE_SERIALIZABLE_PRE_CUSTOM_BASE_LINKAGE( CDescriptorLSH, mrpt::utils::CSerializable, VISION_IMPEXP )
+
+		/** A persistent index of real-valued descriptors (SIFT, SURF, spin images) for approximate nearest neighbor searches in Euclidean distance,
+		  *  by means of a forest of randomized KD-trees searched "best bin first" (C. Silpa-Anan, R. Hartley, "Optimised KD-trees for fast image descriptor matching", CVPR 2008;
+		  *  M. Muja, D.G. Lowe, "Fast Approximate Nearest Neighbors with Automatic Algorithm Configuration", VISAPP 2009).
+		  *
+		  *  Unlike TSIFTDescriptorsKDTreeIndex, which indexes one CFeatureList and must be rebuilt whenever it changes, this index keeps its own copy of the
+		  *  descriptors and can be updated incrementally: descriptors are inserted into the leaves of the existing trees (which are split as they grow) and
+		  *  removed from them, so it can hold, for example, the descriptors of all the landmarks of a map across many frames. The trees are rebuilt from scratch only when the
+		  *  number of descriptors grows by TParams::rebuildFactor.
+		  *
+		  *  Each descriptor is identified by the ID returned by insert(), which does not change until it's removed (IDs of removed descriptors are reused by later insertions).
+		  *  Searches are approximate: up to TParams::maxChecks descriptors are compared per query. Many queries are solved at once in parallel threads by knnSearchBatch() and find_pairings().
+		  *
+		  *  Example of usage:
+		  *  \code
+		  *    CDescriptorKDForest  index;
+		  *    index.insert(map_feats, descSIFT);
+		  *    std::vector<std::pair<size_t,size_t> > pairings;  // (index in frame_feats, ID in the index)
+		  *    index.find_pairings(pairings, frame_feats, descSIFT, 250.0f, 0.8);
+		  *  \endcode
+		  *
+		  * \sa CDescriptorLSH for binary descriptors, TSIFTDescriptorsKDTreeIndex
+		  */
+		class VISION_IMPEXP CDescriptorKDForest : public mrpt::utils::CSerializable
+		{
+			DEFINE_SERIALIZABLE( CDescriptorKDForest )
+
+		public:
+			/** Parameters of the index. Changing them only affects the trees built afterwards (see rebuild()), except for \a maxChecks */
+			struct VISION_IMPEXP TParams
+			{
+				TParams();
+
+				unsigned int nTrees;        //!< Number of randomized trees (Default=4)
+				unsigned int leafSize;      //!< Number of descriptors in each leaf when building the trees. Leaves are split when they reach twice this size by insertions, or twice the size of their last failed split if their descriptors could not be told apart (Default=16)
+				unsigned int maxChecks;     //!< Maximum number of descriptors compared in each search (Default=256). If 0, searches are exact (by a linear scan)
+				double       rebuildFactor; //!< The trees are rebuilt when the number of descriptors becomes this times the number when they were last built (Default=2)
+				uint32_t     seed;          //!< Seed of the random choices of splitting dimensions (Default=0x1234)
+			};
+
+			TParams params; //!< Parameters of the index
+
+			CDescriptorKDForest();
+
+			/** Empties the index, also forgetting the descriptor length */
+			void clear();
+
+			/** Inserts a descriptor of getDescriptorLength() elements (or of \a length elements, if the index is empty, which sets the descriptor length of the index)
+			  * \return The ID of the descriptor in the index
+			  */
+			size_t insert(const float *desc, const size_t length);
+
+			/** Inserts the descriptors of a given kind (descSIFT, descSURF or descSpinImages) of a list of features, all of which must have one of the same length.
+			  * \param[out] out_ids If not NULL, it's filled with the ID of each inserted descriptor.
+			  */
+			void insert(const CFeatureList &feats, const TDescriptorType descriptor, std::vector<size_t> *out_ids = NULL);
+
+			/** Removes the descriptor with the given ID, which may be reused in later insertions. */
+			void remove(const size_t id);
+
+			/** Rebuilds all the trees from scratch, with the current parameters. It's done automatically as the index grows (see TParams::rebuildFactor). */
+			void rebuild();
+
+			inline size_t size() const { return m_nActive; }                  //!< Number of descriptors in the index
+			inline bool   empty() const { return m_nActive==0; }
+			inline size_t getDescriptorLength() const { return m_dim; }       //!< Length of each descriptor (0 if nothing was inserted yet)
+			inline bool   contains(const size_t id) const { return id<m_removed.size() && !m_removed[id]; } //!< Whether \a id is the ID of a descriptor in the index
+			inline size_t getIDCount() const { return m_removed.size(); }     //!< All the IDs (in use or free) are below this number
+			inline const float *getDescriptor(const size_t id) const { return &m_descs[id*m_dim]; }        //!< The descriptor with a given ID
+
+			/** Finds (approximately) the \a k closest descriptors to \a query, sorted by ascending distance.
+			  * \param[out] out_sqr_dists The squared Euclidean distances of the neighbors.
+			  * \return The number of neighbors found (less than \a k only if the index has less than \a k descriptors).
+			  */
+			size_t knnSearch(const float *query, const size_t k, std::vector<size_t> &out_ids, std::vector<float> &out_sqr_dists) const;
+
+			/** Solves knnSearch() for \a nQueries descriptors stored one after the other in \a queries, in parallel threads. */
+			void knnSearchBatch(
+				const float *queries,
+				const size_t nQueries,
+				const size_t k,
+				std::vector<std::vector<size_t> > &out_ids,
+				std::vector<std::vector<float> >  &out_sqr_dists) const;
+
+			/** Pairs the features in \a feats with the indexed descriptors, with the same criteria as find_descriptor_pairings_hamming():
+			  *  the closest descriptor is accepted if its (Euclidean) distance is not above \a max_distance and below \a max_ratio times that of the second closest one.
+			  *  The queries run in parallel threads.
+			  * \param[out] pairings Pairs of (index in \a feats, ID in the index), sorted by the index in \a feats.
+			  * \param[out] out_distances If not NULL, it's filled with the Euclidean distance of each pairing.
+			  * \return The number of pairings.
+			  */
+			size_t find_pairings(
+				std::vector<std::pair<size_t,size_t> > & pairings,
+				const CFeatureList                     & feats,
+				const TDescriptorType                    descriptor,
+				const float                              max_distance,
+				const double                             max_ratio = 0.8,
+				std::vector<float>                     * out_distances = NULL ) const;
+
+			/** A node of a tree: a leaf if \a dim is negative */
+			struct TNode
+			{
+				int32_t  dim;      //!< Splitting dimension, or -1 for leaves
+				float    split;    //!< Descriptors with a value below this go to child[0], the rest to child[1]
+				uint32_t child[2]; //!< Indices of the children in the vector of nodes
+				std::vector<uint32_t> ids; //!< The descriptors in a leaf
+				uint32_t splitSize; //!< For leaves, the number of descriptors at which insertions try to split it again (0: twice TParams::leafSize). It's raised when the leaf cannot be split, so insertions don't retry it each time
+			};
+
+		private:
+			size_t               m_dim;       //!< Length of the descriptors
+			size_t               m_nActive;   //!< Number of descriptors in the index
+			size_t               m_nAtBuild;  //!< Number of descriptors when the trees were last built
+			std::vector<float>   m_descs;     //!< The descriptors, by ID
+			std::vector<uint8_t> m_removed;   //!< For each ID, whether it's free
+			std::vector<size_t>  m_free_ids;  //!< Removed IDs, for reuse
+			std::vector<std::vector<TNode> > m_trees; //!< The nodes of each tree (the root is the first one)
+			uint32_t             m_rng_state; //!< State of the random choices while building the trees
+
+			uint32_t nextRandom();
+			void     buildTree(std::vector<TNode> &nodes, const uint32_t node_idx, std::vector<uint32_t> &ids);
+			void     splitNode(std::vector<TNode> &nodes, const uint32_t node_idx);
+			uint32_t findLeaf(const std::vector<TNode> &nodes, const float *desc) const;
+
+		public:
+			/** Internal search, with buffers reused across queries (\a visited must have one zeroed entry per ID, and is left that way on return) */
+			void knnSearchImpl(const float *query, const size_t k, std::vector<std::pair<float,size_t> > &out_nn, std::vector<uint8_t> &visited, std::vector<uint32_t> &touched) const;
+		};
+
+		/** A persistent index of binary descriptors (ORB) for approximate nearest neighbor searches in Hamming distance, by locality sensitive hashing (LSH)
+		  *  with bit sampling and multi-probe (Q. Lv et al., "Multi-probe LSH: efficient indexing for high-dimensional similarity search", VLDB 2007).
+		  *
+		  *  Each of the TParams::nTables hash tables is indexed by a key made of TParams::keyBits bits taken at random positions of the descriptors,
+		  *  and each search looks into the bucket of the query key and, if TParams::multiProbe is enabled, those of the keys at one bit from it.
+		  *  Descriptors can be inserted and removed at any time (in O(nTables) operations), and are identified by the ID returned by insert(),
+		  *  which is reused after they are removed.
+		  *
+		  *  For exact searches within a maximum distance over a fixed set of descriptors, see CHammingMultiIndex.
+		  * \sa CDescriptorKDForest, hammingDistance
+		  */
+		class VISION_IMPEXP CDescriptorLSH : public mrpt::utils::CSerializable
+		{
+			DEFINE_SERIALIZABLE( CDescriptorLSH )
+
+		public:
+			/** Parameters of the index, which must be set before inserting the first descriptor (see clear()) */
+			struct VISION_IMPEXP TParams
+			{
+				TParams();
+
+				unsigned int nTables;    //!< Number of hash tables (Default=6)
+				unsigned int keyBits;    //!< Bits of the key of each table, up to 20 (Default=14)
+				bool         multiProbe; //!< Whether to also look into the buckets at one bit from the query keys (Default=true)
+				uint32_t     seed;       //!< Seed for the random bit positions of the keys (Default=0x1234)
+			};
+
+			TParams params; //!< Parameters of the index
+
+			CDescriptorLSH();
+
+			/** Empties the index, also forgetting the descriptor length (and the hash functions, to be regenerated from the current \a params) */
+			void clear();
+
+			/** Inserts a descriptor of getDescriptorBytes() bytes (or of \a nBytes, if the index is empty, which sets the descriptor length of the index)
+			  * \return The ID of the descriptor in the index
+			  */
+			size_t insert(const uint8_t *desc, const size_t nBytes);
+
+			/** Inserts the ORB descriptors of a list of features, all of which must have one of the same length.
+			  * \param[out] out_ids If not NULL, it's filled with the ID of each inserted descriptor.
+			  */
+			void insert(const CFeatureList &feats, std::vector<size_t> *out_ids = NULL);
+
+			/** Removes the descriptor with the given ID, which may be reused in later insertions. */
+			void remove(const size_t id);
+
+			inline size_t size() const { return m_nActive; }                  //!< Number of descriptors in the index
+			inline bool   empty() const { return m_nActive==0; }
+			inline size_t getDescriptorBytes() const { return m_nBytes; }     //!< Length of each descriptor, in bytes (0 if nothing was inserted yet)
+			inline bool   contains(const size_t id) const { return id<m_removed.size() && !m_removed[id]; } //!< Whether \a id is the ID of a descriptor in the index
+			inline size_t getIDCount() const { return m_removed.size(); }     //!< All the IDs (in use or free) are below this number
+			inline const uint8_t *getDescriptor(const size_t id) const { return &m_descs[id*m_nBytes]; }   //!< The descriptor with a given ID
+
+			/** Finds (approximately) the \a k closest descriptors to \a query, among those sharing a bucket with it, sorted by ascending Hamming distance.
+			  * \return The number of neighbors found.
+			  */
+			size_t knnSearch(const uint8_t *query, const size_t k, std::vector<size_t> &out_ids, std::vector<uint32_t> &out_dists) const;
+
+			/** Solves knnSearch() for \a nQueries descriptors stored one after the other in \a queries, in parallel threads. */
+			void knnSearchBatch(
+				const uint8_t *queries,
+				const size_t nQueries,
+				const size_t k,
+				std::vector<std::vector<size_t> >   &out_ids,
+				std::vector<std::vector<uint32_t> > &out_dists) const;
+
+			/** Pairs the features in \a feats (by their ORB descriptors) with the indexed descriptors, with the same criteria and in the same format as
+			  *  find_descriptor_pairings_hamming(), except that the second element of each pairing is the ID in the index. The queries run in parallel threads.
+			  */
+			size_t find_pairings(
+				std::vector<std::pair<size_t,size_t> > & pairings,
+				const CFeatureList                     & feats,
+				const unsigned int                       max_distance = 64,
+				const double                             max_ratio = 0.8,
+				std::vector<uint32_t>                  * out_distances = NULL ) const;
+
+		private:
+			size_t               m_nBytes;    //!< Bytes per descriptor
+			size_t               m_nActive;   //!< Number of descriptors in the index
+			std::vector<uint8_t> m_descs;     //!< The descriptors, by ID
+			std::vector<uint8_t> m_removed;   //!< For each ID, whether it's free
+			std::vector<size_t>  m_free_ids;  //!< Removed IDs, for reuse
+			std::vector<std::vector<uint16_t> > m_key_bits;  //!< For each table, the bit positions of its key
+			std::vector<std::vector<std::vector<uint32_t> > > m_buckets; //!< For each table and key, the IDs of its descriptors
+
+			uint32_t computeKey(const size_t table, const uint8_t *desc) const;
+			void     initTables();
+
+		public:
+			/** Internal search, with buffers reused across queries (\a visited must have one zeroed entry per ID, and is left that way on return) */
+			void knnSearchImpl(const uint8_t *query, const size_t k, std::vector<std::pair<uint32_t,size_t> > &out_nn, std::vector<uint8_t> &visited, std::vector<uint32_t> &touched) const;
+		};
+
+		/** @} */
+	}
+}
+#endif
+
@@ -36,7 +36,8 @@ namespace mrpt
 		  *    TSIFTDescriptorsKDTreeIndex<double>  feats_kdtree(feats);
 		  *    feats_kdtree.get_kdtree().knnSearch( ... );
 		  *  \endcode
-		  * \sa CFeatureList, mrpt::vision::find_descriptor_pairings
+		  *  The index must be rebuilt whenever the list of features changes: see CDescriptorKDForest for an index which can be updated incrementally.
+		  * \sa CFeatureList, mrpt::vision::find_descriptor_pairings, CDescriptorKDForest
 		  */
 		template <
 			typename distance_t, 
@@ -93,7 +94,8 @@ namespace mrpt
 		  *    TSURFDescriptorsKDTreeIndex<double>  feats_kdtree(feats);
 		  *    feats_kdtree.get_kdtree().knnSearch( ... );
 		  *  \endcode
-		  * \sa CFeatureList, mrpt::vision::find_descriptor_pairings
+		  *  The index must be rebuilt whenever the list of features changes: see CDescriptorKDForest for an index which can be updated incrementally.
+		  * \sa CFeatureList, mrpt::vision::find_descriptor_pairings, CDescriptorKDForest
 		  */
 		template <
 			typename distance_t, 
@@ -104,7 +106,7 @@ namespace mrpt
 		public:
 			typedef typename nanoflann::KDTreeSingleIndexAdaptor<metric_t,detail::TSURFDesc2KDTree_Adaptor<distance_t> > kdtree_t;
 
-			/** Constructor from a list of SIFT features. 
+			/** Constructor from a list of SURF features. 
 			  *  Automatically build the KD-tree index. The list of features must NOT be empty or an exception will be raised.
 			  */
 			TSURFDescriptorsKDTreeIndex(const CFeatureList &feats) : 
@@ -112,7 +114,7 @@ namespace mrpt
 				m_kdtree(NULL),
 				m_feats(feats) 
 			{
-				ASSERT_(!feats.empty() && feats[0]->descriptors.hasDescriptorSIFT())
+				ASSERT_(!feats.empty() && feats[0]->descriptors.hasDescriptorSURF())
 				this->regenerate_kdtreee();
 			}
 
@@ -122,7 +124,7 @@ namespace mrpt
 				if (m_kdtree) delete m_kdtree;
 
 				nanoflann::KDTreeSingleIndexAdaptorParams params;
-				m_kdtree = new kdtree_t( m_feats[0]->descriptors.SIFT.size() /* DIM */ , m_adaptor, params );
+				m_kdtree = new kdtree_t( m_feats[0]->descriptors.SURF.size() /* DIM */ , m_adaptor, params );
 				m_kdtree->buildIndex();
 			}
 
@@ -15,6 +15,7 @@
 
 #include <mrpt/vision/CFeature.h>
 #include <mrpt/vision/TSimpleFeature.h>
+#include <mrpt/vision/CImagePyramid.h>
 #include <mrpt/utils/CImage.h>
 #include <mrpt/utils/CTimeLogger.h>
 #include <mrpt/utils/TParameters.h>
@@ -73,6 +74,10 @@ namespace mrpt
 		  *      <td> If <i>add_new_features</i>==1,  this is the minimum separation (in pixels) to any other (old, or new) feature for it
 		  *             being considered a candidate to be added.
 		  *         </td> </tr>
+		  *   <tr><td align="center" > add_new_feat_grid_cell_size  </td>  <td align="center" > 0 </td>
+		  *      <td> If <i>add_new_features</i>==1 and this is >0, new features are detected with CFeatureExtraction::detectFeatures_SSE2_FASTER_grid(), in parallel
+		  *             over a grid of square cells of this size (in pixels), so they are evenly spread over the image (around <i>desired_num_features_adapt</i> raw keypoints).
+		  *         </td> </tr>
 		  *   <tr><td align="center" > desired_num_features_adapt  </td>  <td align="center" > (img_width*img_height)/512 </td>
 		  *      <td> If <i>add_new_features</i>==1, the threshold of the FAST(ER) feature detector is dynamically adapted such as the number of
 		  *        raw FAST keypoints is around this number. This number should be much higher than the real desired numbre of features, since this
@@ -218,13 +223,25 @@ namespace mrpt
 		  *
 		  *  See CGenericFeatureTracker for a more detailed explanation on how to use this class.
 		  *
+		  *  This is a pyramidal Lucas-Kanade tracker (as described by J-Y. Bouguet) with these optimizations:
+		  *   - The Scharr gradients of the old image are computed only once per pyramid level (see CImagePyramid::buildGradients), and
+		  *     the pyramid of the new image (with its gradients) is kept for the next call, where it is normally the old image.
+		  *   - Windows are interpolated in fixed point, and the residuals of each iteration are evaluated 8 pixels at once with SSE2.
+		  *   - Features are tracked in parallel threads (see mrpt::system::parallel_for).
+		  *
+		  *  With the profiler enabled (see CGenericFeatureTracker::enableTimeLogger), the sections "[CFeatureTracker_KL] Build old pyramid" and "[CFeatureTracker_KL] Build new pyramid"
+		  *  measure the construction of the pyramids, so the former is only entered when the old image is not the new one of the previous call.
+		  *
 		  *   List of additional parameters in "extra_params" (apart from those in CGenericFeatureTracker) accepted by this class:
 		  *		- "window_width"  (Default=15)
 		  *		- "window_height" (Default=15)
-		  *		- "LK_levels" (Default=3) Number of pyramids to build for LK tracking (this parameter only has effects when tracking with CImage's, not with CImagePyramid's).
+		  *		- "LK_levels" (Default=3) Number of pyramid levels above the original image for LK tracking.
 		  *		- "LK_max_iters" (Default=10) Max. number of iterations in LK tracking.
 		  *		- "LK_epsilon" (Default=0.1) Minimum epsilon step in interations of LK_tracking.
-		  *		- "LK_max_tracking_error" (Default=150.0) The maximum "tracking error" of LK tracking such as a feature is marked as "lost".
+		  *		- "LK_max_tracking_error" (Default=10.0) The maximum "tracking error" of LK tracking such as a feature is marked as "lost". The tracking error is the mean absolute difference
+		  *		   of the intensities (in the range [0,255]) between the window of the feature in the old image and its aligned window in the new one, hence independent of the window size.
+		  *		   Note that in MRPT < 1.1.1 this tracker relied on OpenCV's cvCalcOpticalFlowPyrLK(), whose tracking error has other units (hence its former default of 150).
+		  *		- "LK_min_eigenvalue" (Default=1e-4) Features whose window has a minimum eigenvalue of the spatial gradient matrix (divided by the number of pixels) below this value are marked as "lost", for their lack of texture.
 		  *
 		  *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
 		  */
@@ -247,6 +264,9 @@ namespace mrpt
 				const CImage &new_img,
 				FEATLIST  &inout_featureList );
 
+			CImagePyramid  m_prev_pyr;  //!< Pyramid (with gradients) of the last tracked image
+			CImagePyramid  m_cur_pyr;   //!< Temporary pyramid of the new image
+
 		};
 
 
@@ -67,7 +67,8 @@ namespace mrpt
 			descSURF			= 2,  //!< SURF descriptors
 			descSpinImages      = 4,  //!< Intensity-domain spin image descriptors
 			descPolarImages     = 8,  //!< Polar image descriptor
-			descLogPolarImages	= 16  //!< Log-Polar image descriptor
+			descLogPolarImages	= 16, //!< Log-Polar image descriptor
+			descORB             = 32  //!< Binary ORB descriptor (oriented and rotated BRIEF), compared by Hamming distance
 		};
 
 		enum TFeatureTrackStatus
@@ -294,7 +295,10 @@ namespace mrpt
 				mmDescriptorSURF,
 				/** Matching by sum of absolute differences of the image patches
 				  */
-				mmSAD
+				mmSAD,
+				/** Matching by Hamming distance between ORB descriptors
+				  */
+				mmDescriptorORB
 			};
 
 			// For determining
@@ -327,6 +331,10 @@ namespace mrpt
 			double	maxSAD_TH;                  //!< Minimum Euclidean Distance Between Sum of Absolute Differences
 			double  SAD_RATIO;                  //!< Boundary Ratio between the two highest SAD
 
+			// ORB
+			float	maxHD_TH;					//!< Maximum Hamming Distance between ORB descriptors, in bits (default=64)
+			float	HD_RATIO;					//!< Boundary Ratio between the two lowest Hamming distances (default=0.8)
+
 //			// To estimate depth
 			bool    estimateDepth;              //!< Whether or not estimate the 3D position of the real features for the matches (only with parallelOpticalAxis by now).
 			double  maxDepthThreshold;          //!< The maximum allowed depth for the matching. If its computed depth is larger than this, the match won't be considered.
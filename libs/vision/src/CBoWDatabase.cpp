@@ -0,0 +1,165 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>  // Precompiled headers
+
+#include <mrpt/vision/CBoWDatabase.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+IMPLEMENTS_SERIALIZABLE(CBoWDatabase, CSerializable, mrpt::vision)
+
+namespace
+{
+	/** Sorts (score,ID) pairs by decreasing score, then by increasing ID */
+	inline bool betterScore(const std::pair<double,size_t> &a, const std::pair<double,size_t> &b)
+	{
+		return a.first>b.first || (a.first==b.first && a.second<b.second);
+	}
+}
+
+CBoWDatabase::CBoWDatabase()
+{
+}
+
+void CBoWDatabase::clear()
+{
+	m_entries.clear();
+	m_inverted_files.clear();
+}
+
+size_t CBoWDatabase::add(const TBoWVector &bow)
+{
+	const size_t id = m_entries.size();
+	m_entries.push_back(bow);
+	for (size_t i=0;i<bow.size();i++)
+	{
+		const uint32_t word = bow[i].first;
+		if (word>=m_inverted_files.size())
+			m_inverted_files.resize(word+1);
+		m_inverted_files[word].push_back(std::make_pair(static_cast<uint32_t>(id),bow[i].second));
+	}
+	return id;
+}
+
+size_t CBoWDatabase::query(
+	const TBoWVector    & bow,
+	const size_t          k,
+	std::vector<size_t> & out_ids,
+	std::vector<double> & out_scores,
+	const size_t          max_id ) const
+{
+	out_ids.clear();
+	out_scores.clear();
+	const size_t nEntries = std::min(max_id,m_entries.size());
+	if (!k || !nEntries || bow.empty())
+		return 0;
+
+	// Accumulate the terms of the score of the entries which share words with the query, through the inverted files:
+	std::vector<float>    acc(nEntries,0.0f);
+	std::vector<uint32_t> touched;
+	for (size_t i=0;i<bow.size();i++)
+	{
+		if (bow[i].first>=m_inverted_files.size()) continue;
+		const float q = bow[i].second;
+		const TInvertedFile &inv = m_inverted_files[bow[i].first];
+		for (size_t j=0;j<inv.size() && inv[j].first<nEntries;j++)
+		{
+			const uint32_t id = inv[j].first;
+			if (acc[id]==0) touched.push_back(id);
+			acc[id] += q + inv[j].second - std::abs(q-inv[j].second);
+		}
+	}
+
+	std::vector<std::pair<double,size_t> > scored(touched.size());
+	for (size_t i=0;i<touched.size();i++)
+		scored[i] = std::make_pair(0.5*acc[touched[i]],static_cast<size_t>(touched[i]));
+
+	const size_t nFound = std::min(k,scored.size());
+	std::partial_sort(scored.begin(),scored.begin()+nFound,scored.end(),betterScore);
+	out_ids.resize(nFound);
+	out_scores.resize(nFound);
+	for (size_t i=0;i<nFound;i++)
+	{
+		out_ids[i]    = scored[i].second;
+		out_scores[i] = scored[i].first;
+	}
+	return nFound;
+}
+
+double CBoWDatabase::score(const TBoWVector &a, const TBoWVector &b)
+{
+	// Both are sorted by word:
+	double s = 0;
+	size_t i=0, j=0;
+	while (i<a.size() && j<b.size())
+	{
+		if (a[i].first<b[j].first) i++;
+		else if (b[j].first<a[i].first) j++;
+		else
+		{
+			s += a[i].second + b[j].second - std::abs(a[i].second-b[j].second);
+			i++; j++;
+		}
+	}
+	return 0.5*s;
+}
+
+void CBoWDatabase::writeToStream(CStream &out, int *version) const
+{
+	if (version)
+		*version = 0;
+	else
+	{
+		// The inverted files are rebuilt when loading:
+		out << static_cast<uint32_t>(m_entries.size());
+		for (size_t e=0;e<m_entries.size();e++)
+		{
+			const TBoWVector &bow = m_entries[e];
+			vector_uint        words(bow.size());
+			std::vector<float> weights(bow.size());
+			for (size_t i=0;i<bow.size();i++)
+			{
+				words[i]   = bow[i].first;
+				weights[i] = bow[i].second;
+			}
+			out << words << weights;
+		}
+	}
+}
+
+void CBoWDatabase::readFromStream(CStream &in, int version)
+{
+	switch(version)
+	{
+	case 0:
+		{
+			clear();
+			uint32_t nEntries;
+			in >> nEntries;
+			TBoWVector         bow;
+			vector_uint        words;
+			std::vector<float> weights;
+			for (uint32_t e=0;e<nEntries;e++)
+			{
+				in >> words >> weights;
+				ASSERT_(words.size()==weights.size())
+				bow.resize(words.size());
+				for (size_t i=0;i<words.size();i++)
+					bow[i] = std::make_pair(words[i],weights[i]);
+				add(bow);
+			}
+		} break;
+	default:
+		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+	};
+}
@@ -17,6 +17,7 @@
 #include <mrpt/utils/CStdOutStream.h>
 #include <mrpt/vision/CFeature.h>
 #include <mrpt/vision/types.h>
+#include <mrpt/vision/descriptor_hamming.h>
 #include <mrpt/math/utils.h>
 
 using namespace mrpt;
@@ -283,6 +284,8 @@ void CFeature::dumpToTextStream( mrpt::utils::CStream &out) const
 	descriptors.hasDescriptorPolarImg() ? out.printf("Yes\n") : out.printf("No\n");
 	out.printf("Has Log Polar descriptor?:      ");
 	descriptors.hasDescriptorLogPolarImg() ? out.printf("Yes\n") : out.printf("No\n");
+	out.printf("Has ORB descriptor?:            ");
+	descriptors.hasDescriptorORB() ? out.printf("Yes\n") : out.printf("No\n");
 
 	out.printf("Has multiscale?:                ");
     if( !descriptors.hasDescriptorMultiSIFT() )
@@ -316,7 +319,7 @@ void CFeature::dumpToConsole() const
 void  CFeature::writeToStream(CStream &out,int *version) const
 {
 	if (version)
-		*version = 1;
+		*version = 2;
 	else
 	{
 		// The coordinates:
@@ -347,7 +350,8 @@ void  CFeature::writeToStream(CStream &out,int *version) const
 			<< descriptors.PolarImg
 			<< descriptors.LogPolarImg
 			<< descriptors.polarImgsNoRotation
-			<< descriptors.multiSIFTDescriptors;
+			<< descriptors.multiSIFTDescriptors
+			<< descriptors.ORB;
 	}
 }
 
@@ -357,6 +361,7 @@ void  CFeature::readFromStream(CStream &in,int version)
 	{
 	case 0:
 	case 1:
+	case 2:
 		{
 			// The coordinates:
 			uint32_t aux_type, aux_KLTS;
@@ -392,6 +397,9 @@ void  CFeature::readFromStream(CStream &in,int version)
 				>> descriptors.polarImgsNoRotation;
             if( version > 0 )
                 in  >> descriptors.multiSIFTDescriptors;
+            if( version > 1 )
+                in  >> descriptors.ORB;
+            else descriptors.ORB.clear();
 
 			type		    = (TFeatureType)aux_type;
 			track_status	= (TFeatureTrackStatus)aux_KLTS;
@@ -420,7 +428,8 @@ CFeature::TDescriptors::TDescriptors() :
 	SpinImg(), SpinImg_range_rows(0),
 	PolarImg(0,0),
 	LogPolarImg(0,0),
-	polarImgsNoRotation(false)
+	polarImgsNoRotation(false),
+	ORB()
 { }
 
 // Return false only for Blob detectors (SIFT, SURF)
@@ -472,6 +481,8 @@ float CFeature::descriptorDistanceTo(
 			descriptorToUse = descPolarImages;
 		else if (descriptors.hasDescriptorLogPolarImg())
 			descriptorToUse = descLogPolarImages;
+		else if (descriptors.hasDescriptorORB())
+			descriptorToUse = descORB;
 		else THROW_EXCEPTION("Feature has no descriptors and descriptorToUse=descAny")
 	}
 
@@ -493,6 +504,11 @@ float CFeature::descriptorDistanceTo(
 			float minAng;
 			return descriptorLogPolarImgDistanceTo(oFeature,minAng,normalize_distances);
 		}
+	case descORB:
+		{
+			const float dist = static_cast<float>(descriptorORBDistanceTo(oFeature));
+			return normalize_distances ? dist/(8*descriptors.ORB.size()) : dist;
+		}
 	default:
 		THROW_EXCEPTION_CUSTOM_MSG1("Unknown value for 'descriptorToUse'=%u",(unsigned)descriptorToUse);
 	}
@@ -545,6 +561,17 @@ float CFeature::descriptorSURFDistanceTo( const CFeature &oFeature, bool normali
 	return dist;
 } // end descriptorSURFDistanceTo
 
+// --------------------------------------------------
+// descriptorORBDistanceTo
+// --------------------------------------------------
+uint32_t CFeature::descriptorORBDistanceTo( const CFeature &oFeature ) const
+{
+	ASSERT_( this->descriptors.ORB.size() == oFeature.descriptors.ORB.size() );
+	ASSERT_( this->descriptors.hasDescriptorORB() && oFeature.descriptors.hasDescriptorORB() )
+
+	return mrpt::vision::hammingDistance( &this->descriptors.ORB[0], &oFeature.descriptors.ORB[0], this->descriptors.ORB.size() );
+} // end descriptorORBDistanceTo
+
 // --------------------------------------------------
 // descriptorSpinImgDistanceTo
 // --------------------------------------------------
@@ -829,13 +856,14 @@ void CFeatureList::saveToTextFile( const std::string &filename, bool APPEND )
 
 	f.printf(
 		"%% Dump of mrpt::vision::CFeatureList. Each line format is:\n"
-		"%% ID TYPE X Y ORIENTATION SCALE TRACK_STATUS RESPONSE HAS_SIFT [SIFT] HAS_SURF [SURF]\n"
-		"%% \\---------------------- feature ------------------/ \\--------- descriptors -------/\n"
+		"%% ID TYPE X Y ORIENTATION SCALE TRACK_STATUS RESPONSE HAS_SIFT [SIFT] HAS_SURF [SURF] HAS_ORB [ORB]\n"
+		"%% \\---------------------- feature ------------------/ \\--------------- descriptors ---------------/\n"
 		"%% with:\n"
 		"%%  TYPE  : The used detector: 0:KLT, 1: Harris, 2: BCD, 3: SIFT, 4: SURF, 5: Beacon, 6: FAST\n"
 		"%%  HAS_* : 1 if a descriptor of that type is associated to the feature. \n"
 		"%%  SIFT  : Present if HAS_SIFT=1: N DESC_0 ... DESC_N-1 \n"
 		"%%  SURF  : Present if HAS_SURF=1: N DESC_0 ... DESC_N-1 \n"
+		"%%  ORB   : Present if HAS_ORB=1: N DESC_0 ... DESC_N-1 (N bytes) \n"
 		"%%-------------------------------------------------------------------------------------------\n");
 
 	for( CFeatureList::iterator it = this->begin(); it != this->end(); ++it )
@@ -861,6 +889,14 @@ void CFeatureList::saveToTextFile( const std::string &filename, bool APPEND )
 				f.printf( "%8.5f ", (*it)->descriptors.SURF[k]);
 		}
 
+		f.printf("%2d ", int((*it)->descriptors.hasDescriptorORB() ? 1:0) );
+		if( (*it)->descriptors.hasDescriptorORB() )
+		{
+			f.printf("%4d ", int((*it)->descriptors.ORB.size()) );
+			for( unsigned int k = 0; k < (*it)->descriptors.ORB.size(); k++ )
+				f.printf( "%3d ", (*it)->descriptors.ORB[k]);
+		}
+
 		f.printf( "\n");
 	} // end for
 
@@ -933,6 +969,22 @@ void CFeatureList::loadFromTextFile( const std::string &filename )
 				if (!line) throw  std::string("SURF-data");
 			}
 
+			// ORB descriptors are optional, for files saved by older versions:
+			int hasORB;
+			if ((line >> hasORB) && hasORB)
+			{
+				size_t N;
+				if (!(line >> N)) throw std::string("ORB-len");
+				feat->descriptors.ORB.resize(N);
+				for (size_t i=0;i<N;i++)
+				{
+					int val;
+					line >> val;
+					feat->descriptors.ORB[i] = val;
+				}
+				if (!line) throw  std::string("ORB-data");
+			}
+
 			push_back( feat_ptr );
 		}
 		catch(std::string &msg)
@@ -10,6 +10,7 @@
 #include <mrpt/vision.h>  // Precompiled headers
 
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/system/parallelization.h>
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h> 
@@ -226,3 +227,288 @@ void  CFeatureExtraction::extractFeaturesFASTER_N(
 }
 
 
+
+// ------------  Grid-bucketed FASTER over image pyramids -------------
+#if MRPT_HAS_OPENCV
+namespace
+{
+	/** One cell of one octave, and the corners detected in it */
+	struct TGridCell
+	{
+		uint8_t            octave;
+		int                x0,y0,x1,y1;   // Limits of the cell, [x0,x1)x[y0,y1), in octave pixels
+		size_t             quota;         // Max. number of features to keep (0: all)
+		TSimpleFeatureList kept;          // Best features, up to "quota"
+		TSimpleFeatureList spare;         // Other features which passed the min-distance filter, sorted by response
+	};
+
+	/** Functor for parallel_for(): detects the features of a range of cells */
+	struct TGridCellDetector
+	{
+		const CImagePyramid                  &m_pyr;
+		const CFeatureExtraction::TOptions   &m_opts;
+		std::vector<TGridCell>               &m_cells;
+
+		TGridCellDetector(const CImagePyramid &pyr, const CFeatureExtraction::TOptions &opts, std::vector<TGridCell> &cells) :
+			m_pyr(pyr), m_opts(opts), m_cells(cells)
+		{ }
+
+		void operator()(const BlockedRange &r) const
+		{
+			const int KLT_half_win = 3;
+			const float min_dist2 = square(m_opts.FASTOptions.min_distance);
+			const bool do_filter_min_dist = m_opts.FASTOptions.nonmax_suppression && m_opts.FASTOptions.min_distance>1;
+
+			TSimpleFeatureList detected;
+			std::vector<size_t> sorted_indices;
+
+			for (int c=r.begin();c!=r.end();++c)
+			{
+				TGridCell &cell = m_cells[c];
+				const CImage &img = m_pyr.images[cell.octave];
+				const IplImage *IPL = img.getAs<IplImage>();
+				const int W = IPL->width, H = IPL->height;
+
+				// The FASTER detectors skip a 3 pixel border: enlarge the cell, starting at a 16-byte aligned column so the SSE2 versions can be used.
+				const int rx0 = std::max(0, cell.x0-3) & ~15;
+				const int ry0 = std::max(0, cell.y0-3);
+				const int rx1 = std::min(W, cell.x1+3);
+				const int ry1 = std::min(H, cell.y1+3);
+
+				IplImage roi = *IPL;
+				roi.roi       = NULL;
+				roi.imageData = IPL->imageData + ry0*IPL->widthStep + rx0;
+				roi.width     = rx1-rx0;
+				roi.height    = ry1-ry0;
+				roi.imageSize = roi.height*roi.widthStep;
+
+				int threshold = m_opts.FASTOptions.threshold;
+				for (;;)
+				{
+					detected.clear();
+					switch (m_opts.featsType)
+					{
+					case featFASTER9:  fast_corner_detect_9 (&roi,detected,threshold,0,NULL); break;
+					case featFASTER10: fast_corner_detect_10(&roi,detected,threshold,0,NULL); break;
+					default:           fast_corner_detect_12(&roi,detected,threshold,0,NULL); break;
+					};
+
+					// Keep those in the cell itself:
+					size_t nIn = 0;
+					for (size_t i=0;i<detected.size();i++)
+					{
+						const int x = detected[i].pt.x + rx0, y = detected[i].pt.y + ry0;
+						if (x>=cell.x0 && x<cell.x1 && y>=cell.y0 && y<cell.y1)
+						{
+							detected[nIn].pt.x = x;
+							detected[nIn].pt.y = y;
+							nIn++;
+						}
+					}
+					detected.resize(nIn);
+
+					// Adaptive threshold: retry with a lower one for low-textured cells
+					if (!cell.quota || nIn>=cell.quota || threshold<=m_opts.PyramidGridOptions.min_threshold)
+						break;
+					threshold = std::max(m_opts.PyramidGridOptions.min_threshold, threshold/2);
+				}
+
+				// Rank by KLT response:
+				const size_t N = detected.size();
+				for (size_t i=0;i<N;i++)
+				{
+					const int x = detected[i].pt.x, y = detected[i].pt.y;
+					detected[i].response = (x>KLT_half_win && y>KLT_half_win && x<W-1-KLT_half_win && y<H-1-KLT_half_win) ?
+						img.KLT_response(x,y,KLT_half_win) : -100;
+				}
+				sorted_indices.resize(N);
+				for (size_t i=0;i<N;i++) sorted_indices[i]=i;
+				std::sort( sorted_indices.begin(), sorted_indices.end(), KeypointResponseSorter<TSimpleFeatureList>(detected) );
+
+				// Non-maximum suppression by min-distance (the accepted features of a cell are few, so brute force is fine):
+				cell.kept.clear();
+				cell.spare.clear();
+				for (size_t k=0;k<N;k++)
+				{
+					const TSimpleFeature &f = detected[sorted_indices[k]];
+					bool too_close = false;
+					if (do_filter_min_dist)
+					{
+						for (size_t j=0;j<cell.kept.size() && !too_close;j++)
+							too_close = square(float(cell.kept[j].pt.x-f.pt.x))+square(float(cell.kept[j].pt.y-f.pt.y)) < min_dist2;
+						for (size_t j=0;j<cell.spare.size() && !too_close;j++)
+							too_close = square(float(cell.spare[j].pt.x-f.pt.x))+square(float(cell.spare[j].pt.y-f.pt.y)) < min_dist2;
+					}
+					if (too_close) continue;
+
+					TSimpleFeature nf = f;
+					nf.octave = cell.octave;
+					if (!cell.quota || cell.kept.size()<cell.quota)
+						cell.kept.push_back(nf);
+					else cell.spare.push_back(nf);
+				}
+			}
+		}
+	};
+
+	// Sorts features by decreasing response:
+	struct TFeatureBetterResponse
+	{
+		bool operator()(const TSimpleFeature &a, const TSimpleFeature &b) const { return a.response > b.response; }
+	};
+}
+#endif
+
+void CFeatureExtraction::detectFeatures_SSE2_FASTER_grid(
+	const CImagePyramid &pyramid,
+	TSimpleFeatureList & corners,
+	const TOptions &opts,
+	const size_t nDesiredFeatures )
+{
+	MRPT_START
+#if MRPT_HAS_OPENCV
+	ASSERTMSG_(opts.featsType==featFASTER9 || opts.featsType==featFASTER10 || opts.featsType==featFASTER12, "featsType must be one of the FASTER detectors")
+	ASSERT_(opts.PyramidGridOptions.cell_size>=8)
+
+	const size_t nOctaves = pyramid.images.size();
+	const int cell_size = opts.PyramidGridOptions.cell_size;
+	const int margin = std::max(3, int(opts.patchSize/2) + 1);  // Keep the patches within the images
+
+	// The share of features of each octave is proportional to its area:
+	double sum_areas = 0;
+	for (size_t o=0;o<nOctaves;o++)
+		sum_areas += 1.0/(1<<(2*o));
+
+	std::vector<TGridCell> cells;
+	for (size_t o=0;o<nOctaves;o++)
+	{
+		const CImage &img = pyramid.images[o];
+		ASSERTMSG_(!img.isColor(), "The pyramid must be grayscale")
+		const int W = img.getWidth(), H = img.getHeight();
+		if (W<=2*margin || H<=2*margin) break;
+
+		const int nCellsX = (W-2*margin + cell_size-1)/cell_size;
+		const int nCellsY = (H-2*margin + cell_size-1)/cell_size;
+		const size_t octave_quota = mrpt::utils::round( nDesiredFeatures/(sum_areas*(1<<(2*o))) );
+		const size_t cell_quota = !nDesiredFeatures ? 0 : std::max(size_t(1), (octave_quota + nCellsX*nCellsY-1)/(nCellsX*nCellsY));
+
+		for (int cy=0;cy<nCellsY;cy++)
+			for (int cx=0;cx<nCellsX;cx++)
+			{
+				TGridCell c;
+				c.octave = static_cast<uint8_t>(o);
+				c.x0 = margin + cx*cell_size;  c.x1 = std::min(W-margin, c.x0+cell_size);
+				c.y0 = margin + cy*cell_size;  c.y1 = std::min(H-margin, c.y0+cell_size);
+				c.quota = cell_quota;
+				cells.push_back(c);
+			}
+	}
+
+	mrpt::system::parallel_for( BlockedRange(0,static_cast<int>(cells.size())), TGridCellDetector(pyramid,opts,cells) );
+
+	// Merge the cells:
+	corners.clear();
+	size_t nKept = 0;
+	for (size_t c=0;c<cells.size();c++) nKept+=cells[c].kept.size();
+	corners.reserve(nKept);
+	for (size_t c=0;c<cells.size();c++)
+		for (size_t i=0;i<cells[c].kept.size();i++)
+			corners.push_back(cells[c].kept[i]);
+
+	if (nDesiredFeatures)
+	{
+		if (corners.size()>nDesiredFeatures)
+		{
+			// Rounding up the quotas may give some more: drop the worst ones.
+			std::sort(corners.begin(),corners.end(),TFeatureBetterResponse());
+			corners.resize(nDesiredFeatures);
+		}
+		else if (corners.size()<nDesiredFeatures)
+		{
+			// Fill with the best features of the cells with more than their share:
+			std::vector<TSimpleFeature> spare;
+			for (size_t c=0;c<cells.size();c++)
+				spare.insert(spare.end(),cells[c].spare.begin(),cells[c].spare.end());
+			const size_t nMore = std::min(spare.size(), nDesiredFeatures-corners.size());
+			std::partial_sort(spare.begin(),spare.begin()+nMore,spare.end(),TFeatureBetterResponse());
+			for (size_t i=0;i<nMore;i++)
+				corners.push_back(spare[i]);
+		}
+	}
+
+	// Coordinates in the 0-level image:
+	for (TSimpleFeatureList::iterator it=corners.begin();it!=corners.end();++it)
+	{
+		it->pt.x <<= it->octave;
+		it->pt.y <<= it->octave;
+	}
+#else
+	THROW_EXCEPTION("MRPT built without OpenCV support!")
+#endif
+	MRPT_END
+}
+
+/************************************************************************************************
+*								detectFeaturesPyramid											*
+************************************************************************************************/
+void CFeatureExtraction::detectFeaturesPyramid(
+	const CImage            & img,
+	CFeatureList            & feats,
+	const unsigned int      init_ID,
+	const unsigned int      nDesiredFeatures,
+	CImagePyramid           * out_pyramid ) const
+{
+	MRPT_START
+	CImagePyramid  local_pyr;
+	CImagePyramid &pyr = out_pyramid ? *out_pyramid : local_pyr;
+	pyr.buildPyramid(img, std::max(1u,options.PyramidGridOptions.nOctaves), options.PyramidGridOptions.smooth_halves, true /*grayscale*/);
+
+	this->detectFeaturesPyramid(pyr,feats,init_ID,nDesiredFeatures);
+	MRPT_END
+}
+
+void CFeatureExtraction::detectFeaturesPyramid(
+	const CImagePyramid     & pyramid,
+	CFeatureList            & feats,
+	const unsigned int      init_ID,
+	const unsigned int      nDesiredFeatures ) const
+{
+	MRPT_START
+
+	TSimpleFeatureList corners;
+	detectFeatures_SSE2_FASTER_grid(pyramid,corners,options,nDesiredFeatures);
+
+	if( !options.addNewFeatures )
+		feats.clear();
+
+	const int offset = (int)options.patchSize/2 + 1;
+	TFeatureID nextID = init_ID;
+
+	for (size_t i=0;i<corners.size();i++)
+	{
+		const TSimpleFeature &feat = corners[i];
+
+		CFeaturePtr ft		= CFeature::Create();
+		ft->type			= options.featsType;
+		ft->ID				= nextID++;
+		ft->x				= feat.pt.x;
+		ft->y				= feat.pt.y;
+		ft->response		= feat.response;
+		ft->orientation		= 0;
+		ft->scale			= 1 << feat.octave;
+		ft->patchSize		= options.patchSize;
+
+		if( options.patchSize > 0 )
+		{
+			pyramid.images[feat.octave].extract_patch(
+				ft->patch,
+				(feat.pt.x >> feat.octave) - offset,
+				(feat.pt.y >> feat.octave) - offset,
+				options.patchSize,
+				options.patchSize );						// Image patch surronding the feature, in its octave
+		}
+		feats.push_back( ft );
+	}
+
+	MRPT_END
+}
@@ -0,0 +1,136 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+// The FASTER detectors require OpenCV:
+#if MRPT_HAS_OPENCV
+
+// A grayscale image textured everywhere, with random blocks of 4x4 pixels:
+static void makeTexturedImage(CImage &img, const unsigned int W, const unsigned int H)
+{
+	CRandomGenerator rng(4321);
+	img = CImage(W,H,CH_GRAY);
+	for (unsigned int by=0;by<H;by+=4)
+		for (unsigned int bx=0;bx<W;bx+=4)
+		{
+			const unsigned char v = static_cast<unsigned char>(rng.drawUniform32bit() & 0xFF);
+			for (unsigned int y=by;y<std::min(H,by+4);y++)
+				for (unsigned int x=bx;x<std::min(W,bx+4);x++)
+					*img(x,y) = v;
+		}
+}
+
+TEST(CFeatureExtraction, FASTERPyramidGrid)
+{
+	const unsigned int W = 320, H = 240;
+	CImage img;
+	makeTexturedImage(img,W,H);
+
+	CFeatureExtraction fext;
+	fext.options.featsType = featFASTER9;
+	fext.options.patchSize = 0;
+	fext.options.PyramidGridOptions.nOctaves = 3;
+	fext.options.PyramidGridOptions.cell_size = 64;
+
+	const unsigned int nDesired[] = { 100, 200, 500 };
+	for (size_t t=0;t<sizeof(nDesired)/sizeof(nDesired[0]);t++)
+	{
+		const unsigned int N = nDesired[t];
+		CFeatureList feats;
+		fext.detectFeaturesPyramid(img,feats,0,N);
+		ASSERT_EQ(feats.size(), N);
+
+		// Full resolution coordinates, with the scale of their octave:
+		size_t nPerOctave[3] = {0,0,0};
+		for (CFeatureList::const_iterator it=feats.begin();it!=feats.end();++it)
+		{
+			const int s = static_cast<int>((*it)->scale);
+			ASSERT_TRUE(s==1 || s==2 || s==4) << "scale=" << s;
+			nPerOctave[s==1 ? 0 : (s==2 ? 1 : 2)]++;
+			const int x = static_cast<int>((*it)->x), y = static_cast<int>((*it)->y);
+			EXPECT_EQ(float(x), (*it)->x);
+			EXPECT_EQ(x % s, 0);
+			EXPECT_EQ(y % s, 0);
+			EXPECT_GE(x, 3*s);  EXPECT_LT(x, int(W)-3*s);
+			EXPECT_GE(y, 3*s);  EXPECT_LT(y, int(H)-3*s);
+		}
+		EXPECT_GT(nPerOctave[0], nPerOctave[1]);
+		EXPECT_GT(nPerOctave[1], 0u);
+
+		// The features of the 0-level octave are spread over all the cells, each one with at most its share:
+		const int margin = 3, cell = 64;
+		const int nCellsX = (W-2*margin+cell-1)/cell, nCellsY = (H-2*margin+cell-1)/cell;
+		const double sum_areas = 1+1./4+1./16;
+		const size_t octave_quota = mrpt::utils::round(N/sum_areas);
+		const size_t cell_quota = std::max(size_t(1), (octave_quota + nCellsX*nCellsY-1)/(nCellsX*nCellsY));
+
+		std::vector<size_t> nPerCell(nCellsX*nCellsY,0);
+		for (CFeatureList::const_iterator it=feats.begin();it!=feats.end();++it)
+			if ((*it)->scale==1)
+				nPerCell[ ((int((*it)->y)-margin)/cell)*nCellsX + (int((*it)->x)-margin)/cell ]++;
+		for (size_t c=0;c<nPerCell.size();c++)
+		{
+			EXPECT_GE(nPerCell[c], 1u) << "N=" << N << " cell=" << c;
+			EXPECT_LE(nPerCell[c], cell_quota) << "N=" << N << " cell=" << c;
+		}
+	}
+}
+
+TEST(CFeatureExtraction, FASTERGridSingleCellMatchesPlainDetector)
+{
+	const unsigned int W = 200, H = 120;
+	CImage img;
+	makeTexturedImage(img,W,H);
+
+	CFeatureExtraction::TOptions opts(featFASTER9);
+	opts.patchSize = 0;
+	opts.FASTOptions.threshold = 20;
+	opts.FASTOptions.nonmax_suppression = false;  // No min-distance filter
+	opts.PyramidGridOptions.cell_size = 1024;     // One cell covers the whole image
+
+	for (int type=0;type<3;type++)
+	{
+		opts.featsType = type==0 ? featFASTER9 : (type==1 ? featFASTER10 : featFASTER12);
+
+		CImagePyramid pyr;
+		pyr.buildPyramid(img,1,false,true);
+		TSimpleFeatureList grid_corners, corners;
+		CFeatureExtraction::detectFeatures_SSE2_FASTER_grid(pyr,grid_corners,opts);
+		switch (type)
+		{
+		case 0: CFeatureExtraction::detectFeatures_SSE2_FASTER9 (img,corners,opts.FASTOptions.threshold); break;
+		case 1: CFeatureExtraction::detectFeatures_SSE2_FASTER10(img,corners,opts.FASTOptions.threshold); break;
+		default: CFeatureExtraction::detectFeatures_SSE2_FASTER12(img,corners,opts.FASTOptions.threshold); break;
+		};
+
+		std::vector<std::pair<int,int> > a, b;
+		for (size_t i=0;i<grid_corners.size();i++)
+		{
+			EXPECT_EQ(grid_corners[i].octave, 0);
+			a.push_back(std::make_pair(grid_corners[i].pt.y,grid_corners[i].pt.x));
+		}
+		for (size_t i=0;i<corners.size();i++)
+			b.push_back(std::make_pair(corners[i].pt.y,corners[i].pt.x));
+		std::sort(a.begin(),a.end());
+		std::sort(b.begin(),b.end());
+		EXPECT_GT(a.size(), 100u);
+		EXPECT_EQ(a, b) << "FASTER type " << type;
+	}
+}
+
+#endif
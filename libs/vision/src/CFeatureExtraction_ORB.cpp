@@ -0,0 +1,152 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>  // Precompiled headers
+
+#include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/random/RandomGenerators.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	const int    ORB_NUM_TESTS       = 256;  // Bits of the descriptor
+	const int    ORB_PATTERN_HALF    = 13;   // Test locations are within [-13,13]^2 of the keypoint
+	const int    ORB_BOX_HALF        = 2;    // Intensities are compared as the sum of 5x5 boxes
+	const int    ORB_CENTROID_RADIUS = 15;   // Radius of the patch for the intensity centroid orientation
+	const int    ORB_NUM_ANGLES      = 30;   // Number of discretized orientations of the steered pattern (12deg steps)
+
+	/** The pairs of test locations (x1,y1,x2,y2), for each of the discretized orientations.
+	  *  They are drawn from an isotropic Gaussian (as BRIEF's "G II" pattern) with a fixed seed, so descriptors are repeatable. */
+	struct TORBPattern
+	{
+		std::vector<int> tests[ORB_NUM_ANGLES];
+
+		TORBPattern()
+		{
+			mrpt::random::CRandomGenerator rng(0x0DB1);
+			std::vector<double> base(4*ORB_NUM_TESTS);
+			for (size_t i=0;i<base.size();i++)
+				base[i] = std::max(-double(ORB_PATTERN_HALF), std::min(double(ORB_PATTERN_HALF), double(mrpt::utils::round(rng.drawGaussian1D(0,2*ORB_PATTERN_HALF/5.0))) ));
+
+			for (int a=0;a<ORB_NUM_ANGLES;a++)
+			{
+				const double ang = a*M_2PI/ORB_NUM_ANGLES;
+				const double ca = cos(ang), sa = sin(ang);
+				std::vector<int> &t = tests[a];
+				t.resize(base.size());
+				for (size_t i=0;i<base.size();i+=2)
+				{
+					t[i]   = mrpt::utils::round( ca*base[i] - sa*base[i+1] );
+					t[i+1] = mrpt::utils::round( sa*base[i] + ca*base[i+1] );
+				}
+			}
+		}
+	};
+	const TORBPattern orb_pattern;
+
+	/** Integral image of a gray-scale image, with one extra row and column of zeros at the top-left */
+	struct TIntegralImage
+	{
+		int W,H;
+		std::vector<int32_t> data;
+
+		explicit TIntegralImage(const CImage &img) : W(img.getWidth()), H(img.getHeight()), data((W+1)*(H+1),0)
+		{
+			for (int y=0;y<H;y++)
+			{
+				const uint8_t *row = img.get_unsafe(0,y);
+				int32_t rowSum = 0;
+				for (int x=0;x<W;x++)
+				{
+					rowSum += row[x];
+					data[(y+1)*(W+1)+x+1] = data[y*(W+1)+x+1] + rowSum;
+				}
+			}
+		}
+
+		/** Sum of the box [x-h,x+h]x[y-h,y+h], clipped to the image, scaled to the whole box area */
+		inline int32_t boxSum(int x, int y, const int h) const
+		{
+			int x0 = std::max(0,x-h), x1 = std::min(W,x+h+1);
+			int y0 = std::max(0,y-h), y1 = std::min(H,y+h+1);
+			if (x0>=x1 || y0>=y1) return 0;
+			const int32_t s = data[y1*(W+1)+x1] - data[y0*(W+1)+x1] - data[y1*(W+1)+x0] + data[y0*(W+1)+x0];
+			const int area = (x1-x0)*(y1-y0), full = (2*h+1)*(2*h+1);
+			return area==full ? s : (s*full)/area;
+		}
+	};
+
+	/** Orientation of a keypoint by the intensity centroid of a circular patch (Rosin, 1999) */
+	double intensityCentroidAngle(const CImage &img, const int cx, const int cy)
+	{
+		const int W = img.getWidth(), H = img.getHeight();
+		int64_t m10 = 0, m01 = 0;
+		for (int dy=-ORB_CENTROID_RADIUS;dy<=ORB_CENTROID_RADIUS;dy++)
+		{
+			const int y = cy+dy;
+			if (y<0 || y>=H) continue;
+			const int dx_max = static_cast<int>(std::sqrt(double(ORB_CENTROID_RADIUS*ORB_CENTROID_RADIUS - dy*dy)));
+			const uint8_t *row = img.get_unsafe(0,y);
+			for (int dx=-dx_max;dx<=dx_max;dx++)
+			{
+				const int x = cx+dx;
+				if (x<0 || x>=W) continue;
+				m10 += dx*row[x];
+				m01 += dy*row[x];
+			}
+		}
+		return (m10==0 && m01==0) ? 0.0 : atan2(double(m01),double(m10));
+	}
+}
+
+/************************************************************************************************
+								internal_computeORBDescriptors
+************************************************************************************************/
+void  CFeatureExtraction::internal_computeORBDescriptors(
+	const CImage	&in_img,
+	CFeatureList		&in_features) const
+{
+	MRPT_START
+
+	// The descriptor works on intensities:
+	const CImage gray_img(in_img, FAST_REF_OR_CONVERT_TO_GRAY);
+	const TIntegralImage integral(gray_img);
+
+	for (CFeatureList::iterator it=in_features.begin();it!=in_features.end();++it)
+	{
+		const int cx = mrpt::utils::round((*it)->x);
+		const int cy = mrpt::utils::round((*it)->y);
+
+		int angle_idx = 0;
+		if (options.ORBOptions.rotation_invariant)
+		{
+			const double ang = intensityCentroidAngle(gray_img,cx,cy);
+			(*it)->orientation = static_cast<float>(ang);
+			angle_idx = mrpt::utils::round( mrpt::math::wrapTo2Pi(ang)*ORB_NUM_ANGLES/M_2PI ) % ORB_NUM_ANGLES;
+		}
+
+		const std::vector<int> &t = orb_pattern.tests[angle_idx];
+		std::vector<uint8_t> &desc = (*it)->descriptors.ORB;
+		desc.assign(ORB_NUM_TESTS/8,0);
+		for (int i=0;i<ORB_NUM_TESTS;i++)
+		{
+			const int32_t s1 = integral.boxSum(cx+t[4*i+0],cy+t[4*i+1],ORB_BOX_HALF);
+			const int32_t s2 = integral.boxSum(cx+t[4*i+2],cy+t[4*i+3],ORB_BOX_HALF);
+			if (s1<s2)
+				desc[i>>3] |= static_cast<uint8_t>(1 << (i & 7));
+		}
+	}
+
+	MRPT_END
+}
@@ -234,6 +234,11 @@ void  CFeatureExtraction::computeDescriptors(
 		this->internal_computeLogPolarImageDescriptors(in_img,inout_features);
 		++nDescComputed;
 	}
+	if ((in_descriptor_list & descORB) != 0)
+	{
+		this->internal_computeORBDescriptors(in_img,inout_features);
+		++nDescComputed;
+	}
 
 	if (!nDescComputed)
 		THROW_EXCEPTION_CUSTOM_MSG1("No known descriptor value found in in_descriptor_list=%u",(unsigned)in_descriptor_list)
@@ -300,6 +305,12 @@ CFeatureExtraction::TOptions::TOptions(const TFeatureType _featsType) :
 	FASTOptions.use_KLT_response		= false;
 	FASTOptions.min_distance 			= 5;
 
+	// PyramidGridOptions
+	PyramidGridOptions.nOctaves			= 3;
+	PyramidGridOptions.smooth_halves	= true;
+	PyramidGridOptions.cell_size		= 64;
+	PyramidGridOptions.min_threshold	= 7;
+
 	// SpinImages Options:
 	SpinImagesOptions.hist_size_distance  = 10;
 	SpinImagesOptions.hist_size_intensity = 10;
@@ -317,6 +328,9 @@ CFeatureExtraction::TOptions::TOptions(const TFeatureType _featsType) :
 	LogPolarImagesOptions.num_angles	= 16; // Log-Polar image patch will have dimensions WxH, with:  W=num_angles,  H= rho_scale * log(radius)
 	LogPolarImagesOptions.rho_scale		= 5;
 
+	// ORBOptions
+	ORBOptions.rotation_invariant		= true;
+
 }
 
 /*---------------------------------------------------------------
@@ -353,6 +367,10 @@ void CFeatureExtraction::TOptions::dumpToTextStream(CStream	&out) const
 	LOADABLEOPTS_DUMP_VAR(FASTOptions.nonmax_suppression,bool)
 	LOADABLEOPTS_DUMP_VAR(FASTOptions.min_distance,float)
 	LOADABLEOPTS_DUMP_VAR(FASTOptions.use_KLT_response,bool)
+	LOADABLEOPTS_DUMP_VAR(PyramidGridOptions.nOctaves,int)
+	LOADABLEOPTS_DUMP_VAR(PyramidGridOptions.smooth_halves,bool)
+	LOADABLEOPTS_DUMP_VAR(PyramidGridOptions.cell_size,int)
+	LOADABLEOPTS_DUMP_VAR(PyramidGridOptions.min_threshold,int)
 
 	LOADABLEOPTS_DUMP_VAR(SpinImagesOptions.hist_size_distance,int)
 	LOADABLEOPTS_DUMP_VAR(SpinImagesOptions.hist_size_intensity,int)
@@ -368,6 +386,8 @@ void CFeatureExtraction::TOptions::dumpToTextStream(CStream	&out) const
 	LOADABLEOPTS_DUMP_VAR(LogPolarImagesOptions.num_angles,int)
 	LOADABLEOPTS_DUMP_VAR(LogPolarImagesOptions.rho_scale,double)
 
+	LOADABLEOPTS_DUMP_VAR(ORBOptions.rotation_invariant,bool)
+
 	out.printf("\n");
 }
 
@@ -408,6 +428,10 @@ void CFeatureExtraction::TOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(FASTOptions.nonmax_suppression,bool,  iniFile,section)
 	MRPT_LOAD_CONFIG_VAR(FASTOptions.min_distance,float,  iniFile,section)
 	MRPT_LOAD_CONFIG_VAR(FASTOptions.use_KLT_response,bool,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(PyramidGridOptions.nOctaves,int,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(PyramidGridOptions.smooth_halves,bool,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(PyramidGridOptions.cell_size,int,  iniFile,section)
+	MRPT_LOAD_CONFIG_VAR(PyramidGridOptions.min_threshold,int,  iniFile,section)
 
 	MRPT_LOAD_CONFIG_VAR(SpinImagesOptions.hist_size_distance,int,  iniFile,section)
 	MRPT_LOAD_CONFIG_VAR(SpinImagesOptions.hist_size_intensity,int,  iniFile,section)
@@ -423,5 +447,7 @@ void CFeatureExtraction::TOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(LogPolarImagesOptions.num_angles,int,  iniFile,section)
 	MRPT_LOAD_CONFIG_VAR(LogPolarImagesOptions.rho_scale,double,  iniFile,section)
 
+	MRPT_LOAD_CONFIG_VAR(ORBOptions.rotation_invariant,bool,  iniFile,section)
+
 }
 
@@ -9,10 +9,13 @@
 
 #include <mrpt/vision.h>  // Precompiled headers
 #include <mrpt/vision/CImagePyramid.h>
+#include <mrpt/system/parallelization.h>
+#include <mrpt/utils/SSE_types.h>
 
 using namespace mrpt;
 using namespace mrpt::utils;
 using namespace mrpt::vision;
+using namespace mrpt::system;
 
 CImagePyramid::CImagePyramid()
 {
@@ -36,6 +39,7 @@ void buildPyramid_templ(
 
 	//TImageSize  img_size = img.getSize();
 	obj.images.resize(nOctaves);
+	obj.gradients.clear();
 
 	// First octave: Just copy the image:
 	if (convert_grayscale && img.isColor())
@@ -77,3 +81,87 @@ void CImagePyramid::buildPyramidFast(
 {
 	buildPyramid_templ<true>(*this,img,nOctaves,smooth_halves,convert_grayscale);
 }
+
+namespace
+{
+	/** Functor for parallel_for(): Scharr gradients of a range of rows of one image */
+	struct TScharrRows
+	{
+		const CImage                    &m_img;
+		CImagePyramid::TImageGradients  &m_grad;
+
+		TScharrRows(const CImage &img, CImagePyramid::TImageGradients &grad) : m_img(img), m_grad(grad) { }
+
+		void operator()(const BlockedRange &r) const
+		{
+			const int W = static_cast<int>(m_grad.width), H = static_cast<int>(m_grad.height);
+			for (int y=r.begin();y!=r.end();++y)
+			{
+				const uint8_t *r0 = m_img.get_unsafe(0,std::max(0,y-1));
+				const uint8_t *r1 = m_img.get_unsafe(0,y);
+				const uint8_t *r2 = m_img.get_unsafe(0,std::min(H-1,y+1));
+				int16_t *dx = &m_grad.dx[y*W];
+				int16_t *dy = &m_grad.dy[y*W];
+
+				int x = 0;
+#if MRPT_HAS_SSE2
+				// 8 pixels at once, for those with both horizontal neighbors and 8 bytes to load:
+				if (W>=10)
+				{
+					const __m128i z = _mm_setzero_si128();
+					const __m128i c3 = _mm_set1_epi16(3), c10 = _mm_set1_epi16(10);
+					for (x=1;x+9<=W;x+=8)
+					{
+#define LOAD8(ptr) _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)),z)
+						const __m128i a0 = LOAD8(r0+x-1), a1 = LOAD8(r0+x), a2 = LOAD8(r0+x+1);
+						const __m128i b0 = LOAD8(r1+x-1),                   b2 = LOAD8(r1+x+1);
+						const __m128i c0 = LOAD8(r2+x-1), c1 = LOAD8(r2+x), c2 = LOAD8(r2+x+1);
+#undef LOAD8
+						// dx = 3*(a2-a0) + 10*(b2-b0) + 3*(c2-c0)
+						const __m128i gx = _mm_add_epi16(
+							_mm_mullo_epi16(c3, _mm_add_epi16(_mm_sub_epi16(a2,a0),_mm_sub_epi16(c2,c0))),
+							_mm_mullo_epi16(c10, _mm_sub_epi16(b2,b0)) );
+						// dy = 3*(c0-a0) + 10*(c1-a1) + 3*(c2-a2)
+						const __m128i gy = _mm_add_epi16(
+							_mm_mullo_epi16(c3, _mm_add_epi16(_mm_sub_epi16(c0,a0),_mm_sub_epi16(c2,a2))),
+							_mm_mullo_epi16(c10, _mm_sub_epi16(c1,a1)) );
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dx+x), gx);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dy+x), gy);
+					}
+				}
+#endif
+				// The rest of pixels (and the borders, replicated):
+				for (int i=0;i<W;i++)
+				{
+					if (i>0 && i<x) continue;
+					const int xm = std::max(0,i-1), xp = std::min(W-1,i+1);
+					dx[i] = static_cast<int16_t>( 3*(r0[xp]-r0[xm]) + 10*(r1[xp]-r1[xm]) + 3*(r2[xp]-r2[xm]) );
+					dy[i] = static_cast<int16_t>( 3*(r2[xm]-r0[xm]) + 10*(r2[i]-r0[i]) + 3*(r2[xp]-r0[xp]) );
+				}
+			}
+		}
+	};
+}
+
+void CImagePyramid::buildGradients()
+{
+	MRPT_START
+	if (hasGradients())
+		return;
+
+	gradients.resize(images.size());
+	for (size_t o=0;o<images.size();o++)
+	{
+		const CImage &img = images[o];
+		ASSERTMSG_(!img.isColor(), "Gradients can be only computed for grayscale pyramids")
+
+		TImageGradients &g = gradients[o];
+		g.width  = img.getWidth();
+		g.height = img.getHeight();
+		g.dx.resize(g.width*g.height);
+		g.dy.resize(g.width*g.height);
+
+		mrpt::system::parallel_for( BlockedRange(0,static_cast<int>(g.height),16), TScharrRows(img,g) );
+	}
+	MRPT_END
+}
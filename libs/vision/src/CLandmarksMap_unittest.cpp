@@ -0,0 +1,138 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+const size_t DESC_LEN = 128;
+
+// A SIFT landmark tagged with its x coordinate. Landmarks without descriptor are not in the SIFT index.
+static CLandmark makeSIFTLandmark(const double tag, const std::vector<unsigned char> &desc)
+{
+	CLandmark lm;
+	lm.createOneFeature();
+	lm.features[0]->type = featSIFT;
+	lm.features[0]->descriptors.SIFT = desc;
+	lm.pose_mean = TPoint3D(tag,0,0);
+	lm.pose_cov_11 = lm.pose_cov_22 = lm.pose_cov_33 = 0.01f;
+	return lm;
+}
+
+static std::vector<unsigned char> perturbed(const std::vector<unsigned char> &desc, CRandomGenerator &rng)
+{
+	std::vector<unsigned char> d = desc;
+	for (size_t j=0;j<d.size();j++)
+		d[j] = static_cast<unsigned char>( std::max(0,std::min(255, int(d[j]) + int(rng.drawUniform32bit()%7)-3 )) );
+	return d;
+}
+
+// Checks that the correspondences of "other" in "map" are those of the landmarks with the expected tags (-1: none),
+//  and that (almost) all of them are found:
+static void checkMatches(const CLandmarksMap &map, const CLandmarksMap &other, const std::vector<double> &expected_tags)
+{
+	TMatchingPairList corrs;
+	float ratio;
+	std::vector<bool> otherCorrs;
+	map.computeMatchingWith3DLandmarks(&other,corrs,ratio,otherCorrs);
+	ASSERT_EQ(otherCorrs.size(), other.size());
+
+	size_t nExpected = 0;
+	for (size_t k=0;k<expected_tags.size();k++)
+		if (expected_tags[k]>=0) nExpected++;
+	EXPECT_GE(corrs.size(), nExpected*9/10);
+	EXPECT_LE(corrs.size(), nExpected);
+
+	for (size_t i=0;i<corrs.size();i++)
+	{
+		const TMatchingPair &m = corrs[i];
+		ASSERT_LT(m.other_idx, other.size());
+		ASSERT_LT(m.this_idx, map.size());
+		EXPECT_TRUE(otherCorrs[m.other_idx]);
+		// The index and the coordinates of the landmark of this map must be those of the right one:
+		EXPECT_EQ(expected_tags[m.other_idx], map.landmarks.get(m.this_idx)->pose_mean.x) << "other_idx=" << m.other_idx;
+		EXPECT_EQ(expected_tags[m.other_idx], m.this_x);
+		EXPECT_EQ(other.landmarks.get(m.other_idx)->pose_mean.x, m.other_x);
+	}
+}
+
+TEST(CLandmarksMap, MatchingWith3DLandmarksThroughSIFTIndex)
+{
+	CRandomGenerator rng(1234);
+
+	// Landmarks tagged 0..N-1, one out of every ten without descriptor:
+	const size_t N = 200;
+	std::vector<std::vector<unsigned char> > descs(N);
+	CLandmarksMap map;
+	map.insertionOptions.SIFTMatching3DMethod = 1;
+	map.insertionOptions.SiftEDDThreshold = 100;
+	for (size_t i=0;i<N;i++)
+	{
+		if ((i%10)!=3)
+		{
+			descs[i].resize(DESC_LEN);
+			for (size_t j=0;j<DESC_LEN;j++)
+				descs[i][j] = static_cast<unsigned char>(rng.drawUniform32bit() % 256);
+		}
+		map.landmarks.push_back(makeSIFTLandmark(i,descs[i]));
+	}
+
+	// The other map: perturbed copies of some of those landmarks, in a different order, plus unrelated ones:
+	CLandmarksMap other;
+	std::vector<double> expected_tags;
+	for (size_t k=0;k<60;k++)
+	{
+		size_t i = (k*7+1)%N;
+		if ((i%10)==3) i++;
+		other.landmarks.push_back(makeSIFTLandmark(1000+k,perturbed(descs[i],rng)));
+		expected_tags.push_back(i);
+	}
+	for (size_t k=0;k<10;k++)
+	{
+		std::vector<unsigned char> d(DESC_LEN);
+		for (size_t j=0;j<DESC_LEN;j++)
+			d[j] = static_cast<unsigned char>(rng.drawUniform32bit() % 256);
+		other.landmarks.push_back(makeSIFTLandmark(2000+k,d));
+		expected_tags.push_back(-1);
+	}
+
+	checkMatches(map,other,expected_tags);
+	EXPECT_EQ(map.landmarks.getSIFTDescriptorIndex().size(), N-N/10);
+
+	// Erase landmarks with and without descriptor (the index is kept, and the landmarks after them renumbered):
+	const size_t to_erase[] = { 190, 120, 113, 8, 3, 1 };  // Tags, which are also the indices in decreasing order
+	for (size_t e=0;e<sizeof(to_erase)/sizeof(to_erase[0]);e++)
+		map.landmarks.erase(to_erase[e]);
+	ASSERT_EQ(map.size(), N-6);
+	EXPECT_EQ(map.landmarks.getSIFTDescriptorIndex().size(), N-N/10-4);
+
+	std::vector<double> expected_after_erase = expected_tags;
+	for (size_t k=0;k<expected_after_erase.size();k++)
+		for (size_t e=0;e<sizeof(to_erase)/sizeof(to_erase[0]);e++)
+			if (expected_after_erase[k]==to_erase[e])
+				expected_after_erase[k] = -1;
+	checkMatches(map,other,expected_after_erase);
+
+	// Landmarks inserted afterwards (whose descriptors take the IDs of the erased ones) are found, at the end of the map:
+	for (size_t e=0;e<sizeof(to_erase)/sizeof(to_erase[0]);e++)
+		if (!descs[to_erase[e]].empty())
+			map.landmarks.push_back(makeSIFTLandmark(500+to_erase[e],descs[to_erase[e]]));
+	for (size_t k=0;k<expected_tags.size();k++)
+		if (expected_after_erase[k]<0 && expected_tags[k]>=0)
+			expected_after_erase[k] = 500+expected_tags[k];
+	checkMatches(map,other,expected_after_erase);
+	EXPECT_EQ(map.landmarks.getSIFTDescriptorIndex().size(), N-N/10);
+}
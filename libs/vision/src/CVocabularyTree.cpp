@@ -0,0 +1,362 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>  // Precompiled headers
+
+#include <mrpt/vision/CVocabularyTree.h>
+#include <mrpt/math/kmeans.h>
+#include <mrpt/system/parallelization.h>
+
+#include "descriptor_internals.h"
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::vision::detail;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+IMPLEMENTS_SERIALIZABLE(CVocabularyTree, CSerializable, mrpt::vision)
+
+namespace
+{
+	/** Index of the closest to \a desc among \a nCenters consecutive centers of length \a dim */
+	inline uint32_t closestCenter(const float *desc, const float *centers, const size_t nCenters, const size_t dim)
+	{
+		uint32_t best = 0;
+		float best_d = sqrDistance(desc,centers,dim);
+		for (size_t c=1;c<nCenters;c++)
+		{
+			const float d = sqrDistance(desc,centers+c*dim,dim);
+			if (d<best_d) { best_d = d; best = c; }
+		}
+		return best;
+	}
+
+	/** Functor for assigning descriptors to their closest center in parallel */
+	struct TAssignToCenters
+	{
+		const std::vector<float>    &m_descs;
+		const std::vector<uint32_t> &m_members;
+		const std::vector<float>    &m_centers;
+		const size_t                 m_nCenters, m_dim;
+		std::vector<uint32_t>       &m_assignments;
+
+		TAssignToCenters(const std::vector<float> &descs, const std::vector<uint32_t> &members, const std::vector<float> &centers, const size_t nCenters, const size_t dim, std::vector<uint32_t> &assignments) :
+			m_descs(descs), m_members(members), m_centers(centers), m_nCenters(nCenters), m_dim(dim), m_assignments(assignments)
+		{ }
+
+		void operator()(const BlockedRange &r) const
+		{
+			for (int i=r.begin();i!=r.end();++i)
+				m_assignments[i] = closestCenter(&m_descs[m_members[i]*m_dim],&m_centers[0],m_nCenters,m_dim);
+		}
+	};
+
+	/** Functor for looking up the words of descriptors in parallel */
+	struct TQuantizeDescriptors
+	{
+		const CVocabularyTree  &m_voc;
+		const float            *m_descs;
+		const size_t            m_dim;
+		std::vector<uint32_t>  &m_words;
+
+		TQuantizeDescriptors(const CVocabularyTree &voc, const float *descs, const size_t dim, std::vector<uint32_t> &words) :
+			m_voc(voc), m_descs(descs), m_dim(dim), m_words(words)
+		{ }
+
+		void operator()(const BlockedRange &r) const
+		{
+			for (int i=r.begin();i!=r.end();++i)
+				m_words[i] = m_voc.quantize(m_descs + i*m_dim);
+		}
+	};
+}
+
+CVocabularyTree::TParams::TParams() :
+	branching(10),
+	depth(6),
+	kmeansAttempts(1),
+	maxSamplesPerNode(20000)
+{
+}
+
+CVocabularyTree::CVocabularyTree() :
+	m_descriptor(descAny),
+	m_dim(0)
+{
+}
+
+void CVocabularyTree::clear()
+{
+	m_descriptor = descAny;
+	m_dim = 0;
+	m_nodes.clear();
+	m_centers.clear();
+	m_words.clear();
+	m_weights.clear();
+}
+
+bool CVocabularyTree::getFloatDescriptor(const CFeature &f, const TDescriptorType descriptor, std::vector<float> &out)
+{
+	return detail::getFloatDescriptor(f,descriptor,out);
+}
+
+void CVocabularyTree::train(const std::vector<CFeatureList> &images, const TDescriptorType descriptor)
+{
+	MRPT_START
+
+	ASSERT_(params.branching>=2 && params.depth>=1)
+	ASSERT_(params.maxSamplesPerNode>params.branching)
+
+	clear();
+
+	// Gather all the descriptors, and the image of each one:
+	std::vector<float>    descs, d;
+	std::vector<uint32_t> desc_images;
+	size_t dim = 0;
+	for (size_t i=0;i<images.size();i++)
+		for (CFeatureList::const_iterator it=images[i].begin();it!=images[i].end();++it)
+		{
+			if (!getFloatDescriptor(**it,descriptor,d)) continue;
+			if (!dim) dim = d.size();
+			ASSERTMSG_(d.size()==dim, "All the training descriptors must have the same length")
+			descs.insert(descs.end(),d.begin(),d.end());
+			desc_images.push_back(static_cast<uint32_t>(i));
+		}
+	ASSERTMSG_(dim>0, "There are no descriptors of the requested kind in the training images")
+	const size_t N = desc_images.size();
+
+	m_descriptor = descriptor;
+	m_dim = dim;
+
+	// The root, with all the descriptors (its center is never used):
+	TNode root;
+	root.firstChild = 0;
+	root.nChildren = 0;
+	root.word = -1;
+	m_nodes.push_back(root);
+	m_centers.assign(dim,0.0f);
+
+	// Split the nodes level by level, keeping the descriptors of the nodes of the current level:
+	std::vector<uint32_t> level(1,0);
+	std::vector<std::vector<uint32_t> > members(1);
+	members[0].resize(N);
+	for (size_t i=0;i<N;i++) members[0][i] = i;
+
+	for (unsigned int lev=0;lev<params.depth && !level.empty();lev++)
+	{
+		std::vector<uint32_t> next_level;
+		std::vector<std::vector<uint32_t> > next_members;
+
+		for (size_t l=0;l<level.size();l++)
+		{
+			std::vector<uint32_t> &mem = members[l];
+			if (mem.size()<=params.branching)
+				continue;  // It's a leaf
+
+			// Cluster a subset of the descriptors, taken evenly:
+			const size_t nSamples = std::min(mem.size(),params.maxSamplesPerNode);
+			std::vector<std::vector<float> > samples(nSamples);
+			for (size_t s=0;s<nSamples;s++)
+			{
+				const float *p = &descs[mem[static_cast<size_t>( (static_cast<double>(s)*mem.size())/nSamples )]*dim];
+				samples[s].assign(p,p+dim);
+			}
+			std::vector<int> sample_assignments;
+			std::vector<std::vector<float> > centers;
+			mrpt::math::kmeans(params.branching,samples,sample_assignments,&centers,params.kmeansAttempts);
+			samples.clear();
+
+			std::vector<float> packed_centers(params.branching*dim);
+			for (size_t c=0;c<params.branching;c++)
+				std::copy(centers[c].begin(),centers[c].end(),packed_centers.begin()+c*dim);
+
+			// Then assign all of them to the closest center:
+			std::vector<uint32_t> assignments(mem.size());
+			mrpt::system::parallel_for(
+				BlockedRange(0,static_cast<int>(mem.size()),16),
+				TAssignToCenters(descs,mem,packed_centers,params.branching,dim,assignments) );
+
+			std::vector<std::vector<uint32_t> > child_members(params.branching);
+			for (size_t i=0;i<mem.size();i++)
+				child_members[assignments[i]].push_back(mem[i]);
+
+			size_t nNonEmpty = 0;
+			for (size_t c=0;c<params.branching;c++)
+				if (!child_members[c].empty()) nNonEmpty++;
+			if (nNonEmpty<2)
+				continue;  // All the descriptors are (almost) equal: it's a leaf
+
+			// The children (only those of non-empty clusters) are consecutive:
+			m_nodes[level[l]].firstChild = m_nodes.size();
+			m_nodes[level[l]].nChildren  = nNonEmpty;
+			for (size_t c=0;c<params.branching;c++)
+			{
+				if (child_members[c].empty()) continue;
+				TNode child;
+				child.firstChild = 0;
+				child.nChildren = 0;
+				child.word = -1;
+				next_level.push_back(m_nodes.size());
+				m_nodes.push_back(child);
+				m_centers.insert(m_centers.end(),centers[c].begin(),centers[c].end());
+				next_members.push_back(std::vector<uint32_t>());
+				next_members.back().swap(child_members[c]);
+			}
+			std::vector<uint32_t>().swap(mem);
+		}
+		level.swap(next_level);
+		members.swap(next_members);
+	}
+
+	// The leaves are the words:
+	for (size_t n=0;n<m_nodes.size();n++)
+	{
+		if (m_nodes[n].nChildren) continue;
+		m_nodes[n].word = m_words.size();
+		m_words.push_back(n);
+	}
+
+	// Inverse document frequency of each word: log(N/N_i), with N_i the number of training images where it appears.
+	std::vector<uint32_t> words(N);
+	mrpt::system::parallel_for(
+		BlockedRange(0,static_cast<int>(N),16),
+		TQuantizeDescriptors(*this,&descs[0],m_dim,words) );
+
+	std::vector<uint32_t> word_images(m_words.size(),0);
+	std::vector<int64_t>  last_image(m_words.size(),-1);
+	size_t nImages = 0;
+	for (size_t i=0;i<N;i++)
+	{
+		if (i==0 || desc_images[i]!=desc_images[i-1]) nImages++;
+		if (last_image[words[i]]==desc_images[i]) continue;  // The descriptors are sorted by image
+		last_image[words[i]] = desc_images[i];
+		word_images[words[i]]++;
+	}
+	m_weights.resize(m_words.size());
+	for (size_t w=0;w<m_words.size();w++)
+		m_weights[w] = static_cast<float>( std::log( static_cast<double>(nImages) / std::max<uint32_t>(1,word_images[w]) ) );
+
+	MRPT_END
+}
+
+uint32_t CVocabularyTree::quantize(const float *desc) const
+{
+	ASSERTDEB_(!m_nodes.empty())
+	size_t n = 0;
+	while (m_nodes[n].nChildren)
+		n = m_nodes[n].firstChild + closestCenter(desc, &m_centers[m_nodes[n].firstChild*m_dim], m_nodes[n].nChildren, m_dim);
+	return static_cast<uint32_t>(m_nodes[n].word);
+}
+
+void CVocabularyTree::transform(const CFeatureList &feats, TBoWVector &out_bow, std::vector<int32_t> *out_words) const
+{
+	MRPT_START
+
+	ASSERTMSG_(!empty(), "The vocabulary has not been trained or loaded")
+
+	out_bow.clear();
+	if (out_words) out_words->assign(feats.size(),-1);
+
+	// Gather the descriptors (sequentially, since it may throw), then look up their words in parallel:
+	std::vector<float>  descs, d;
+	std::vector<size_t> feat_idxs;
+	for (size_t i=0;i<feats.size();i++)
+	{
+		if (!getFloatDescriptor(*feats[i],m_descriptor,d)) continue;
+		ASSERTMSG_(d.size()==m_dim, "The descriptors of the features and those of the vocabulary have different lengths")
+		descs.insert(descs.end(),d.begin(),d.end());
+		feat_idxs.push_back(i);
+	}
+	const size_t N = feat_idxs.size();
+	if (!N) return;
+
+	std::vector<uint32_t> words(N);
+	mrpt::system::parallel_for(
+		BlockedRange(0,static_cast<int>(N),16),
+		TQuantizeDescriptors(*this,&descs[0],m_dim,words) );
+
+	if (out_words)
+		for (size_t i=0;i<N;i++)
+			(*out_words)[feat_idxs[i]] = static_cast<int32_t>(words[i]);
+
+	// Term frequency x inverse document frequency, with the words sorted:
+	std::sort(words.begin(),words.end());
+	double sum = 0;
+	for (size_t i=0;i<N;)
+	{
+		size_t j = i+1;
+		while (j<N && words[j]==words[i]) j++;
+		const float w = (j-i)*m_weights[words[i]];
+		if (w>0)
+		{
+			out_bow.push_back(std::make_pair(words[i],w));
+			sum += w;
+		}
+		i = j;
+	}
+	for (size_t i=0;i<out_bow.size();i++)
+		out_bow[i].second = static_cast<float>(out_bow[i].second/sum);
+
+	MRPT_END
+}
+
+void CVocabularyTree::writeToStream(CStream &out, int *version) const
+{
+	if (version)
+		*version = 0;
+	else
+	{
+		out << params.branching << params.depth << params.kmeansAttempts << static_cast<uint64_t>(params.maxSamplesPerNode);
+		out << static_cast<int32_t>(m_descriptor) << static_cast<uint32_t>(m_dim);
+		out << static_cast<uint32_t>(m_nodes.size());
+		for (size_t n=0;n<m_nodes.size();n++)
+			out << m_nodes[n].firstChild << m_nodes[n].nChildren;
+		out << m_centers << m_weights;
+	}
+}
+
+void CVocabularyTree::readFromStream(CStream &in, int version)
+{
+	switch(version)
+	{
+	case 0:
+		{
+			clear();
+			uint64_t maxSamples;
+			int32_t  descriptor;
+			uint32_t dim, nNodes;
+			in >> params.branching >> params.depth >> params.kmeansAttempts >> maxSamples;
+			in >> descriptor >> dim;
+			params.maxSamplesPerNode = maxSamples;
+			m_descriptor = static_cast<TDescriptorType>(descriptor);
+			m_dim = dim;
+
+			in >> nNodes;
+			m_nodes.resize(nNodes);
+			for (size_t n=0;n<nNodes;n++)
+			{
+				in >> m_nodes[n].firstChild >> m_nodes[n].nChildren;
+				// The words are the leaves, in order:
+				if (m_nodes[n].nChildren)
+					m_nodes[n].word = -1;
+				else
+				{
+					m_nodes[n].word = m_words.size();
+					m_words.push_back(n);
+				}
+			}
+			in >> m_centers >> m_weights;
+			ASSERT_(m_centers.size()==m_dim*m_nodes.size() && m_weights.size()==m_words.size())
+		} break;
+	default:
+		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+	};
+}
@@ -0,0 +1,143 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+// Synthetic "places": each one is seen as a random subset of 40 "landmarks" (SURF-like descriptors) taken from a common pool.
+// Each place is observed twice, with different noise and only 30 of its landmarks the second time.
+static void makePlaces(std::vector<CFeatureList> &first_views, std::vector<CFeatureList> &second_views)
+{
+	CRandomGenerator rng(1234);
+	const size_t nPlaces = 30, nPool = 600, nPerPlace = 40, nRevisited = 30, D = 32;
+
+	std::vector<std::vector<float> > pool(nPool,std::vector<float>(D));
+	for (size_t i=0;i<nPool;i++)
+		for (size_t j=0;j<D;j++)
+			pool[i][j] = rng.drawUniform(0.0,1.0);
+
+	first_views.resize(nPlaces);
+	second_views.resize(nPlaces);
+	for (size_t p=0;p<nPlaces;p++)
+	{
+		for (size_t i=0;i<nPerPlace;i++)
+		{
+			const size_t landmark = rng.drawUniform32bit() % nPool;
+			for (int view=0;view<2;view++)
+			{
+				if (view==1 && i>=nRevisited) break;
+				CFeaturePtr f = CFeature::Create();
+				f->descriptors.SURF = pool[landmark];
+				for (size_t j=0;j<D;j++)
+					f->descriptors.SURF[j] += rng.drawUniform(-0.02,0.02);
+				(view==0 ? first_views[p] : second_views[p]).push_back(f);
+			}
+		}
+	}
+}
+
+TEST(CVocabularyTree, RecognizesRevisitedPlaces)
+{
+	std::vector<CFeatureList> first_views, second_views;
+	makePlaces(first_views,second_views);
+
+	CVocabularyTree voc;
+	voc.params.branching = 4;
+	voc.params.depth = 5;
+	voc.train(first_views,descSURF);
+	EXPECT_FALSE(voc.empty());
+	EXPECT_EQ(voc.getDescriptorLength(), 32u);
+	EXPECT_GT(voc.getWordCount(), 100u);
+	EXPECT_LE(voc.getWordCount(), 1024u);
+
+	CBoWDatabase db;
+	for (size_t p=0;p<first_views.size();p++)
+	{
+		TBoWVector bow;
+		std::vector<int32_t> words;
+		voc.transform(first_views[p],bow,&words);
+		ASSERT_FALSE(bow.empty());
+		ASSERT_EQ(words.size(), first_views[p].size());
+		double sum = 0;
+		for (size_t i=0;i<bow.size();i++)
+		{
+			if (i>0) EXPECT_LT(bow[i-1].first, bow[i].first);
+			sum += bow[i].second;
+		}
+		EXPECT_NEAR(sum, 1.0, 1e-5);
+		EXPECT_NEAR(CBoWDatabase::score(bow,bow), 1.0, 1e-5);
+		EXPECT_EQ(db.add(bow), p);
+	}
+
+	// Each place is recognized from its second view, with the same score as computed directly:
+	for (size_t p=0;p<second_views.size();p++)
+	{
+		TBoWVector bow;
+		voc.transform(second_views[p],bow);
+		std::vector<size_t> ids;
+		std::vector<double> scores;
+		ASSERT_GE(db.query(bow,3,ids,scores), 1u);
+		EXPECT_EQ(ids[0], p);
+		EXPECT_NEAR(scores[0], CBoWDatabase::score(bow,db.getEntry(p)), 1e-5);
+		for (size_t i=1;i<scores.size();i++)
+			EXPECT_GE(scores[i-1], scores[i]);
+		if (ids.size()>1)
+			EXPECT_GT(scores[0], 2*scores[1]);
+
+		// Only entries below max_id are returned:
+		db.query(bow,3,ids,scores,p);
+		for (size_t i=0;i<ids.size();i++)
+			EXPECT_LT(ids[i], p);
+	}
+
+	// Save & load give identical results:
+	CMemoryStream buf;
+	buf << voc << db;
+	buf.Seek(0);
+	CVocabularyTree voc2;
+	CBoWDatabase db2;
+	buf >> voc2 >> db2;
+	EXPECT_EQ(voc2.getWordCount(), voc.getWordCount());
+	EXPECT_EQ(db2.size(), db.size());
+	for (size_t p=0;p<second_views.size();p++)
+	{
+		TBoWVector bow, bow2;
+		voc.transform(second_views[p],bow);
+		voc2.transform(second_views[p],bow2);
+		EXPECT_EQ(bow, bow2);
+
+		std::vector<size_t> ids, ids2;
+		std::vector<double> scores, scores2;
+		db.query(bow,5,ids,scores);
+		db2.query(bow,5,ids2,scores2);
+		EXPECT_EQ(ids, ids2);
+		EXPECT_EQ(scores, scores2);
+	}
+}
+
+TEST(CVocabularyTree, ORBBitsAsFloats)
+{
+	CFeature f;
+	f.descriptors.ORB.resize(2);
+	f.descriptors.ORB[0] = 0x05;
+	f.descriptors.ORB[1] = 0x80;
+	std::vector<float> d;
+	EXPECT_TRUE(CVocabularyTree::getFloatDescriptor(f,descORB,d));
+	ASSERT_EQ(d.size(), 16u);
+	for (size_t i=0;i<16;i++)
+		EXPECT_EQ(d[i], (i==0 || i==2 || i==15) ? 1.0f : 0.0f);
+	EXPECT_FALSE(CVocabularyTree::getFloatDescriptor(f,descSIFT,d));
+}
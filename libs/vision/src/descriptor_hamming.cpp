@@ -0,0 +1,426 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>  // Precompiled headers
+
+#include <mrpt/vision/descriptor_hamming.h>
+#include <mrpt/system/parallelization.h>
+#include <mrpt/utils/SSE_types.h>
+
+#if MRPT_HAS_SSE4 && (defined(__POPCNT__) || defined(_MSC_VER))
+#	include <nmmintrin.h>
+#	define HAMMING_USE_POPCNT 1
+#elif MRPT_HAS_SSE3 && defined(__SSSE3__)
+#	include <tmmintrin.h>
+#	define HAMMING_USE_SSSE3 1
+#endif
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+	inline uint32_t popcount32(uint32_t v)
+	{
+		v = v - ((v >> 1) & 0x55555555);
+		v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+		return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+	}
+
+	// All the 16-bit masks with at most MAX_PROBE_BITS bits set, sorted by the number of bits:
+	const unsigned int MAX_PROBE_BITS = 3;
+
+	struct TProbeMasks
+	{
+		std::vector<uint16_t> masks;
+		size_t count_upto[MAX_PROBE_BITS+1];  // Number of masks with up to "i" bits set
+
+		TProbeMasks()
+		{
+			for (unsigned int nBits=0;nBits<=MAX_PROBE_BITS;nBits++)
+			{
+				for (uint32_t m=0;m<0x10000;m++)
+					if (popcount32(m)==nBits)
+						masks.push_back(static_cast<uint16_t>(m));
+				count_upto[nBits] = masks.size();
+			}
+		}
+	};
+	const TProbeMasks probe_masks;
+
+	/** Copies the ORB descriptors of all the features one after the other, and returns their length */
+	size_t packORBDescriptors(const CFeatureList &feats, std::vector<uint8_t> &out)
+	{
+		if (feats.empty()) { out.clear(); return 0; }
+		const size_t nBytes = feats[0]->descriptors.ORB.size();
+		ASSERTMSG_(nBytes>0, "Features have no ORB descriptors")
+		out.resize(nBytes*feats.size());
+		for (size_t i=0;i<feats.size();i++)
+		{
+			const std::vector<uint8_t> &d = feats[i]->descriptors.ORB;
+			ASSERTMSG_(d.size()==nBytes, "All the features must have ORB descriptors of the same length")
+			std::memcpy(&out[i*nBytes],&d[0],nBytes);
+		}
+		return nBytes;
+	}
+
+	/** Keeps the pairings which pass the absolute and ratio thresholds */
+	size_t acceptPairings(
+		const std::vector<size_t> &best_idx, const std::vector<uint32_t> &best_dist, const std::vector<uint32_t> &second_dist,
+		const unsigned int max_distance, const double max_ratio,
+		std::vector<std::pair<size_t,size_t> > &pairings_1_to_2, std::vector<uint32_t> *out_distances)
+	{
+		pairings_1_to_2.clear();
+		if (out_distances) out_distances->clear();
+		for (size_t i=0;i<best_idx.size();i++)
+		{
+			if (best_dist[i]>max_distance) continue;
+			if (second_dist[i]!=std::numeric_limits<uint32_t>::max() && !(best_dist[i] < max_ratio*second_dist[i])) continue;
+			pairings_1_to_2.push_back(std::make_pair(i,best_idx[i]));
+			if (out_distances) out_distances->push_back(best_dist[i]);
+		}
+		return pairings_1_to_2.size();
+	}
+
+	/** Functor for find_descriptor_pairings_hamming(): brute-force search for a range of query descriptors */
+	struct TBruteForceHamming
+	{
+		const uint8_t          *m_queries, *m_train;
+		const size_t            m_nTrain, m_nBytes;
+		std::vector<size_t>    &m_best_idx;
+		std::vector<uint32_t>  &m_best_dist, &m_second_dist;
+
+		TBruteForceHamming(const uint8_t *queries, const uint8_t *train, const size_t nTrain, const size_t nBytes,
+			std::vector<size_t> &best_idx, std::vector<uint32_t> &best_dist, std::vector<uint32_t> &second_dist) :
+			m_queries(queries), m_train(train), m_nTrain(nTrain), m_nBytes(nBytes),
+			m_best_idx(best_idx), m_best_dist(best_dist), m_second_dist(second_dist)
+		{ }
+
+		void operator()(const BlockedRange &r) const
+		{
+			for (int i=r.begin();i!=r.end();++i)
+			{
+				const uint8_t *q = m_queries + i*m_nBytes;
+				uint32_t d1 = std::numeric_limits<uint32_t>::max(), d2 = d1;
+				size_t idx1 = 0;
+				for (size_t j=0;j<m_nTrain;j++)
+				{
+					const uint32_t d = hammingDistance(q, m_train + j*m_nBytes, m_nBytes);
+					if (d<d1) { d2=d1; d1=d; idx1=j; }
+					else if (d<d2) d2=d;
+				}
+				m_best_idx[i] = idx1;
+				m_best_dist[i] = d1;
+				m_second_dist[i] = d2;
+			}
+		}
+	};
+
+	/** Functor for CHammingMultiIndex::find_pairings() */
+	struct TMultiIndexQueries
+	{
+		const CHammingMultiIndex &m_index;
+		const uint8_t            *m_queries;
+		const unsigned int        m_max_distance, m_max_distance_2nd;
+		std::vector<size_t>      &m_best_idx;
+		std::vector<uint32_t>    &m_best_dist, &m_second_dist;
+
+		TMultiIndexQueries(const CHammingMultiIndex &index, const uint8_t *queries, const unsigned int max_distance, const unsigned int max_distance_2nd,
+			std::vector<size_t> &best_idx, std::vector<uint32_t> &best_dist, std::vector<uint32_t> &second_dist) :
+			m_index(index), m_queries(queries), m_max_distance(max_distance), m_max_distance_2nd(max_distance_2nd),
+			m_best_idx(best_idx), m_best_dist(best_dist), m_second_dist(second_dist)
+		{ }
+
+		void operator()(const BlockedRange &r) const
+		{
+			std::vector<uint32_t> candidates;
+			std::vector<uint8_t>  visited(m_index.size(),0);
+			for (int i=r.begin();i!=r.end();++i)
+			{
+				if (!m_index.nearest(m_queries + i*m_index.getDescriptorBytes(), m_max_distance, m_best_idx[i], m_best_dist[i], m_second_dist[i], m_max_distance_2nd, candidates, visited))
+					m_best_dist[i] = std::numeric_limits<uint32_t>::max();
+			}
+		}
+	};
+}
+
+/*-------------------------------------------------------------
+						hammingDistance
+-------------------------------------------------------------*/
+uint32_t mrpt::vision::hammingDistance(const uint8_t *d1, const uint8_t *d2, const size_t nBytes)
+{
+	uint32_t dist = 0;
+	size_t i = 0;
+
+#if HAMMING_USE_POPCNT
+	for (;i+8<=nBytes;i+=8)
+	{
+		uint64_t a,b;
+		std::memcpy(&a,d1+i,8);
+		std::memcpy(&b,d2+i,8);
+#	if defined(_M_X64) || defined(__x86_64__)
+		dist += static_cast<uint32_t>(_mm_popcnt_u64(a^b));
+#	else
+		const uint64_t x = a^b;
+		dist += _mm_popcnt_u32(static_cast<uint32_t>(x)) + _mm_popcnt_u32(static_cast<uint32_t>(x>>32));
+#	endif
+	}
+#elif HAMMING_USE_SSSE3
+	// Count the bits of each nibble with a 16-entry table, then add up bytes with SAD:
+	const __m128i lut = _mm_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+	const __m128i low_mask = _mm_set1_epi8(0x0f);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc = zero;
+	for (;i+16<=nBytes;i+=16)
+	{
+		const __m128i x  = _mm_xor_si128( _mm_loadu_si128(reinterpret_cast<const __m128i*>(d1+i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(d2+i)) );
+		const __m128i lo = _mm_and_si128(x,low_mask);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(x,4),low_mask);
+		const __m128i cnt = _mm_add_epi8(_mm_shuffle_epi8(lut,lo),_mm_shuffle_epi8(lut,hi));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(cnt,zero));
+	}
+	dist += _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(acc,acc));
+#endif
+
+	for (;i+4<=nBytes;i+=4)
+	{
+		uint32_t a,b;
+		std::memcpy(&a,d1+i,4);
+		std::memcpy(&b,d2+i,4);
+		dist += popcount32(a^b);
+	}
+	for (;i<nBytes;i++)
+		dist += popcount32(static_cast<uint32_t>(d1[i]^d2[i]));
+
+	return dist;
+}
+
+/*-------------------------------------------------------------
+				find_descriptor_pairings_hamming
+-------------------------------------------------------------*/
+size_t mrpt::vision::find_descriptor_pairings_hamming(
+	std::vector<std::pair<size_t,size_t> > & pairings_1_to_2,
+	const CFeatureList                     & feats_img1,
+	const CFeatureList                     & feats_img2,
+	const unsigned int                       max_distance,
+	const double                             max_ratio,
+	std::vector<uint32_t>                  * out_distances )
+{
+	MRPT_START
+
+	pairings_1_to_2.clear();
+	if (out_distances) out_distances->clear();
+	if (feats_img1.empty() || feats_img2.empty())
+		return 0;
+
+	std::vector<uint8_t> queries, train;
+	const size_t nBytes = packORBDescriptors(feats_img1,queries);
+	ASSERTMSG_(packORBDescriptors(feats_img2,train)==nBytes, "Both lists must have ORB descriptors of the same length")
+
+	const size_t N = feats_img1.size();
+	std::vector<size_t>   best_idx(N);
+	std::vector<uint32_t> best_dist(N), second_dist(N);
+
+	mrpt::system::parallel_for(
+		BlockedRange(0,static_cast<int>(N),16),
+		TBruteForceHamming(&queries[0],&train[0],feats_img2.size(),nBytes,best_idx,best_dist,second_dist) );
+
+	return acceptPairings(best_idx,best_dist,second_dist,max_distance,max_ratio,pairings_1_to_2,out_distances);
+
+	MRPT_END
+}
+
+/*-------------------------------------------------------------
+						CHammingMultiIndex
+-------------------------------------------------------------*/
+CHammingMultiIndex::CHammingMultiIndex() : m_nBytes(0), m_N(0)
+{
+}
+
+void CHammingMultiIndex::clear()
+{
+	m_nBytes = 0;
+	m_N = 0;
+	m_descs.clear();
+	m_bucket_starts.clear();
+	m_bucket_idxs.clear();
+}
+
+void CHammingMultiIndex::build(const CFeatureList &feats)
+{
+	MRPT_START
+	std::vector<uint8_t> descs;
+	const size_t nBytes = packORBDescriptors(feats,descs);
+	if (feats.empty())
+		clear();
+	else build(&descs[0],feats.size(),nBytes);
+	MRPT_END
+}
+
+void CHammingMultiIndex::build(const uint8_t *descs, const size_t N, const size_t descriptorBytes)
+{
+	MRPT_START
+	ASSERTMSG_(descriptorBytes>0 && (descriptorBytes%2)==0, "The length of descriptors must be an even number of bytes")
+	ASSERT_BELOW_(N,size_t(std::numeric_limits<uint32_t>::max()))
+
+	m_nBytes = descriptorBytes;
+	m_N = N;
+	m_descs.assign(descs, descs+N*descriptorBytes);
+
+	// One table per 16-bit substring, built by counting sort:
+	const size_t nSubs = m_nBytes/2;
+	m_bucket_starts.resize(nSubs);
+	m_bucket_idxs.resize(nSubs);
+	for (size_t s=0;s<nSubs;s++)
+	{
+		std::vector<uint32_t> &starts = m_bucket_starts[s];
+		std::vector<uint32_t> &idxs = m_bucket_idxs[s];
+		starts.assign(0x10000+1,0);
+		idxs.resize(N);
+
+		for (size_t i=0;i<N;i++)
+		{
+			const uint8_t *d = &m_descs[i*m_nBytes+2*s];
+			starts[ (d[0] | (d[1]<<8)) + 1 ]++;
+		}
+		for (size_t k=1;k<starts.size();k++)
+			starts[k] += starts[k-1];
+
+		std::vector<uint32_t> next(starts.begin(),starts.end()-1);
+		for (size_t i=0;i<N;i++)
+		{
+			const uint8_t *d = &m_descs[i*m_nBytes+2*s];
+			idxs[ next[d[0] | (d[1]<<8)]++ ] = static_cast<uint32_t>(i);
+		}
+	}
+	MRPT_END
+}
+
+void CHammingMultiIndex::getCandidates(const uint8_t *query, const unsigned int radius, std::vector<uint32_t> &out_candidates, std::vector<uint8_t> &visited) const
+{
+	const size_t nMasks = probe_masks.count_upto[radius];
+	for (size_t s=0;s<m_bucket_starts.size();s++)
+	{
+		const uint16_t key = static_cast<uint16_t>(query[2*s] | (query[2*s+1]<<8));
+		const uint32_t *starts = &m_bucket_starts[s][0];
+		const uint32_t *idxs = &m_bucket_idxs[s][0];
+		for (size_t m=0;m<nMasks;m++)
+		{
+			const uint16_t bucket = key ^ probe_masks.masks[m];
+			for (uint32_t k=starts[bucket];k<starts[bucket+1];k++)
+			{
+				const uint32_t idx = idxs[k];
+				if (!visited[idx])
+				{
+					visited[idx] = 1;
+					out_candidates.push_back(idx);
+				}
+			}
+		}
+	}
+}
+
+bool CHammingMultiIndex::nearest(
+	const uint8_t *query,
+	const unsigned int max_distance,
+	size_t &out_idx,
+	uint32_t &out_dist,
+	uint32_t &out_dist_2nd,
+	const unsigned int max_distance_2nd) const
+{
+	std::vector<uint32_t> candidates;
+	std::vector<uint8_t>  visited(m_N,0);
+	return nearest(query,max_distance,out_idx,out_dist,out_dist_2nd,max_distance_2nd,candidates,visited);
+}
+
+bool CHammingMultiIndex::nearest(
+	const uint8_t *query,
+	const unsigned int max_distance,
+	size_t &out_idx,
+	uint32_t &out_dist,
+	uint32_t &out_dist_2nd,
+	const unsigned int max_distance_2nd,
+	std::vector<uint32_t> &candidates,
+	std::vector<uint8_t>  &visited) const
+{
+	uint32_t d1 = std::numeric_limits<uint32_t>::max(), d2 = d1;
+	size_t idx1 = 0;
+
+	// All the descriptors within the largest distance are among the candidates (any others found are just ignored):
+	const unsigned int search_distance = std::max(max_distance,max_distance_2nd);
+	const size_t nSubs = m_bucket_starts.size();
+	const unsigned int radius = nSubs ? search_distance/nSubs : 0;
+	if (radius>MAX_PROBE_BITS)
+	{
+		// Too many buckets to probe: a linear scan is faster.
+		for (size_t j=0;j<m_N;j++)
+		{
+			const uint32_t d = hammingDistance(query, &m_descs[j*m_nBytes], m_nBytes);
+			if (d<d1) { d2=d1; d1=d; idx1=j; }
+			else if (d<d2) d2=d;
+		}
+	}
+	else
+	{
+		candidates.clear();
+		getCandidates(query,radius,candidates,visited);
+		for (size_t c=0;c<candidates.size();c++)
+		{
+			const uint32_t j = candidates[c];
+			visited[j] = 0;
+			const uint32_t d = hammingDistance(query, &m_descs[j*m_nBytes], m_nBytes);
+			if (d<d1 || (d==d1 && j<idx1)) { d2=d1; d1=d; idx1=j; }  // Candidates are unsorted: break ties as a linear scan would
+			else if (d<d2) d2=d;
+		}
+	}
+
+	if (d1>max_distance)
+		return false;
+	out_idx = idx1;
+	out_dist = d1;
+	out_dist_2nd = d2<=search_distance ? d2 : std::numeric_limits<uint32_t>::max();
+	return true;
+}
+
+size_t CHammingMultiIndex::find_pairings(
+	std::vector<std::pair<size_t,size_t> > & pairings_1_to_2,
+	const CFeatureList                     & feats_img1,
+	const unsigned int                       max_distance,
+	const double                             max_ratio,
+	std::vector<uint32_t>                  * out_distances ) const
+{
+	MRPT_START
+
+	pairings_1_to_2.clear();
+	if (out_distances) out_distances->clear();
+	if (feats_img1.empty() || !m_N)
+		return 0;
+
+	std::vector<uint8_t> queries;
+	ASSERTMSG_(packORBDescriptors(feats_img1,queries)==m_nBytes, "The features must have ORB descriptors of the same length than the indexed ones")
+
+	// The ratio test passes if the second closest descriptor is beyond max_distance/max_ratio (or there is none),
+	//  so it must be searched (exactly) up to that distance to take the same decisions than a brute-force search:
+	const unsigned int nBits = static_cast<unsigned int>(8*m_nBytes);
+	const unsigned int max_distance_2nd = max_ratio>0 ? static_cast<unsigned int>( std::min<double>(nBits, max_distance/max_ratio) ) : nBits;
+
+	const size_t N = feats_img1.size();
+	std::vector<size_t>   best_idx(N);
+	std::vector<uint32_t> best_dist(N), second_dist(N);
+
+	mrpt::system::parallel_for(
+		BlockedRange(0,static_cast<int>(N),16),
+		TMultiIndexQueries(*this,&queries[0],max_distance,max_distance_2nd,best_idx,best_dist,second_dist) );
+
+	return acceptPairings(best_idx,best_dist,second_dist,max_distance,max_ratio,pairings_1_to_2,out_distances);
+
+	MRPT_END
+}
@@ -0,0 +1,221 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+static uint32_t naiveHammingDistance(const uint8_t *d1, const uint8_t *d2, const size_t nBytes)
+{
+	uint32_t d = 0;
+	for (size_t i=0;i<nBytes;i++)
+		for (int b=0;b<8;b++)
+			if (((d1[i]^d2[i])>>b)&1) d++;
+	return d;
+}
+
+static void fillRandomDescriptor(CRandomGenerator &rng, std::vector<uint8_t> &d, const size_t nBytes)
+{
+	d.resize(nBytes);
+	for (size_t i=0;i<nBytes;i++)
+		d[i] = static_cast<uint8_t>(rng.drawUniform32bit() & 0xFF);
+}
+
+// A list of features with random descriptors, and another one with perturbed copies of some of them (in shuffled order):
+static void makeFeatureLists(CFeatureList &train, CFeatureList &queries, const size_t nBytes)
+{
+	CRandomGenerator rng(1234);
+	const size_t N = 300;
+	for (size_t i=0;i<N;i++)
+	{
+		CFeaturePtr f = CFeature::Create();
+		f->ID = i;
+		fillRandomDescriptor(rng,f->descriptors.ORB,nBytes);
+		train.push_back(f);
+	}
+	for (size_t i=0;i<N;i+=3)
+	{
+		CFeaturePtr f = CFeature::Create();
+		f->ID = i;
+		f->descriptors.ORB = train[(i*7)%N]->descriptors.ORB;
+		const unsigned int nFlips = rng.drawUniform32bit() % 21;
+		for (unsigned int k=0;k<nFlips;k++)
+		{
+			const unsigned int bit = rng.drawUniform32bit() % (8*nBytes);
+			f->descriptors.ORB[bit/8] ^= static_cast<uint8_t>(1 << (bit%8));
+		}
+		queries.push_back(f);
+	}
+	// And some unrelated ones:
+	for (size_t i=0;i<20;i++)
+	{
+		CFeaturePtr f = CFeature::Create();
+		fillRandomDescriptor(rng,f->descriptors.ORB,nBytes);
+		queries.push_back(f);
+	}
+}
+
+TEST(DescriptorHamming, hammingDistance)
+{
+	CRandomGenerator rng(4321);
+	std::vector<uint8_t> d1,d2;
+	for (size_t nBytes=1;nBytes<=70;nBytes++)
+	{
+		for (int rep=0;rep<10;rep++)
+		{
+			fillRandomDescriptor(rng,d1,nBytes);
+			fillRandomDescriptor(rng,d2,nBytes);
+			EXPECT_EQ(hammingDistance(&d1[0],&d2[0],nBytes), naiveHammingDistance(&d1[0],&d2[0],nBytes)) << "nBytes=" << nBytes;
+			EXPECT_EQ(hammingDistance(&d1[0],&d1[0],nBytes), 0u);
+		}
+	}
+	// All bits different:
+	d1.assign(32,0x00); d2.assign(32,0xFF);
+	EXPECT_EQ(hammingDistance(&d1[0],&d2[0],32), 256u);
+}
+
+TEST(DescriptorHamming, bruteForceVsMultiIndex)
+{
+	const size_t nBytes = 32;
+	CFeatureList train, queries;
+	makeFeatureLists(train,queries,nBytes);
+
+	CHammingMultiIndex index;
+	index.build(train);
+	EXPECT_EQ(index.size(), train.size());
+	EXPECT_EQ(index.getDescriptorBytes(), nBytes);
+
+	// 16 substrings, up to 3 bits each (exact search with hash tables) and beyond that (linear scan):
+	const unsigned int max_dists[] = { 20, 40, 63, 90 };
+	for (size_t k=0;k<sizeof(max_dists)/sizeof(max_dists[0]);k++)
+	{
+		std::vector<std::pair<size_t,size_t> > pairs_bf, pairs_mih;
+		std::vector<uint32_t> dists_bf, dists_mih;
+		// No ratio test (see bruteForceVsMultiIndexRatioTest):
+		find_descriptor_pairings_hamming(pairs_bf,queries,train,max_dists[k],1e10,&dists_bf);
+		index.find_pairings(pairs_mih,queries,max_dists[k],1e10,&dists_mih);
+
+		EXPECT_EQ(pairs_bf, pairs_mih) << "max_distance=" << max_dists[k];
+		EXPECT_EQ(dists_bf, dists_mih) << "max_distance=" << max_dists[k];
+		for (size_t i=0;i<pairs_bf.size();i++)
+		{
+			EXPECT_LE(dists_bf[i], max_dists[k]);
+			EXPECT_EQ(dists_bf[i], queries[pairs_bf[i].first]->descriptorORBDistanceTo(*train[pairs_bf[i].second]) );
+		}
+	}
+
+	// All the perturbed copies (up to 20 flipped bits) are found in the right place, and the unrelated ones rejected:
+	std::vector<std::pair<size_t,size_t> > pairs;
+	index.find_pairings(pairs,queries,40,0.8);
+	EXPECT_EQ(pairs.size(), 100u);
+	for (size_t i=0;i<pairs.size();i++)
+		EXPECT_EQ(pairs[i].second, (queries[pairs[i].first]->ID*7)%train.size());
+}
+
+TEST(DescriptorHamming, bruteForceVsMultiIndexRatioTest)
+{
+	const size_t nBytes = 32;
+	CFeatureList train, queries;
+	makeFeatureLists(train,queries,nBytes);
+
+	// Add some descriptors at 10-60 bits of others, so the second closest one is sometimes within the maximum distance, and sometimes beyond:
+	CRandomGenerator rng(4321);
+	const size_t N = train.size();
+	for (size_t i=0;i<N;i+=2)
+	{
+		CFeaturePtr f = CFeature::Create();
+		f->descriptors.ORB = train[i]->descriptors.ORB;
+		const unsigned int nFlips = 10 + rng.drawUniform32bit() % 51;
+		for (unsigned int k=0;k<nFlips;k++)
+		{
+			const unsigned int bit = rng.drawUniform32bit() % (8*nBytes);
+			f->descriptors.ORB[bit/8] ^= static_cast<uint8_t>(1 << (bit%8));
+		}
+		train.push_back(f);
+	}
+
+	CHammingMultiIndex index;
+	index.build(train);
+
+	// Both hash table probing and linear scans, with ratio tests which need to look beyond the maximum distance:
+	const unsigned int max_dists[] = { 20, 40, 63 };
+	const double max_ratios[] = { 1.0, 0.8, 0.6, 0.3 };
+	size_t nRejectedByRatio = 0;
+	for (size_t k=0;k<sizeof(max_dists)/sizeof(max_dists[0]);k++)
+	{
+		std::vector<std::pair<size_t,size_t> > pairs_no_ratio;
+		find_descriptor_pairings_hamming(pairs_no_ratio,queries,train,max_dists[k],1e10);
+		for (size_t r=0;r<sizeof(max_ratios)/sizeof(max_ratios[0]);r++)
+		{
+			std::vector<std::pair<size_t,size_t> > pairs_bf, pairs_mih;
+			std::vector<uint32_t> dists_bf, dists_mih;
+			find_descriptor_pairings_hamming(pairs_bf,queries,train,max_dists[k],max_ratios[r],&dists_bf);
+			index.find_pairings(pairs_mih,queries,max_dists[k],max_ratios[r],&dists_mih);
+
+			EXPECT_EQ(pairs_bf, pairs_mih) << "max_distance=" << max_dists[k] << " max_ratio=" << max_ratios[r];
+			EXPECT_EQ(dists_bf, dists_mih) << "max_distance=" << max_dists[k] << " max_ratio=" << max_ratios[r];
+			nRejectedByRatio += pairs_no_ratio.size()-pairs_bf.size();
+		}
+	}
+	EXPECT_GT(nRejectedByRatio, 0u);
+
+	// The second closest descriptor is exact up to the requested distance:
+	const unsigned int max_dists_2nd[] = { 0, 40, 63, 140 };
+	for (size_t k=0;k<sizeof(max_dists_2nd)/sizeof(max_dists_2nd[0]);k++)
+	{
+		for (size_t i=0;i<queries.size();i++)
+		{
+			const uint8_t *q = &queries[i]->descriptors.ORB[0];
+			uint32_t d1 = std::numeric_limits<uint32_t>::max(), d2 = d1;
+			for (size_t j=0;j<train.size();j++)
+			{
+				const uint32_t d = hammingDistance(q,&train[j]->descriptors.ORB[0],nBytes);
+				if (d<d1) { d2=d1; d1=d; }
+				else if (d<d2) d2=d;
+			}
+
+			size_t idx;
+			uint32_t dist, dist_2nd;
+			if (!index.nearest(q,30,idx,dist,dist_2nd,max_dists_2nd[k]))
+			{
+				EXPECT_GT(d1, 30u);
+				continue;
+			}
+			EXPECT_EQ(dist, d1);
+			EXPECT_EQ(dist_2nd, d2<=std::max(30u,max_dists_2nd[k]) ? d2 : std::numeric_limits<uint32_t>::max()) << "i=" << i << " max_distance_2nd=" << max_dists_2nd[k];
+		}
+	}
+}
+
+// CFeature serializes its patch as a CImage, which can't be loaded without OpenCV:
+#if MRPT_HAS_OPENCV
+TEST(DescriptorHamming, serializeORB)
+{
+	CFeature f;
+	f.x = 10; f.y = 20;
+	f.descriptors.ORB.resize(32);
+	for (size_t i=0;i<32;i++) f.descriptors.ORB[i] = static_cast<uint8_t>(i*37);
+
+	CMemoryStream buf;
+	buf << f;
+	buf.Seek(0);
+	CFeature f2;
+	buf >> f2;
+
+	EXPECT_TRUE(f2.descriptors.hasDescriptorORB());
+	EXPECT_EQ(f.descriptors.ORB, f2.descriptors.ORB);
+	EXPECT_EQ(f.descriptorORBDistanceTo(f2), 0u);
+}
+#endif
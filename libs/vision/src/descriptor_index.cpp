@@ -0,0 +1,808 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>  // Precompiled headers
+
+#include <mrpt/vision/descriptor_index.h>
+#include <mrpt/vision/descriptor_hamming.h>
+#include <mrpt/system/parallelization.h>
+
+#include <queue>
+
+#include "descriptor_internals.h"
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::vision::detail;
+using namespace mrpt::utils;
+using namespace mrpt::system;
+using namespace std;
+
+IMPLEMENTS_SERIALIZABLE(CDescriptorKDForest, CSerializable, mrpt::vision)
+IMPLEMENTS_SERIALIZABLE(CDescriptorLSH, CSerializable, mrpt::vision)
+
+namespace
+{
+	const unsigned int KDFOREST_RAND_DIMS    = 5;    // The splitting dimension is taken at random among these many with the largest variance
+	const size_t       KDFOREST_MEAN_SAMPLES = 100;  // Maximum number of descriptors used to estimate the mean and variance of a node
+
+	/** Keeps in \a nn the \a k best (distance,ID) pairs, sorted by ascending distance */
+	template <typename DIST>
+	inline void insertNeighbor(std::vector<std::pair<DIST,size_t> > &nn, const size_t k, const DIST d, const size_t id)
+	{
+		if (nn.size()==k && !(d<nn.back().first)) return;
+		if (nn.size()==k) nn.pop_back();
+		typename std::vector<std::pair<DIST,size_t> >::iterator it = nn.end();
+		while (it!=nn.begin() && (it-1)->first > d) --it;
+		nn.insert(it,std::make_pair(d,id));
+	}
+
+	/** Copies into \a out the real-valued descriptor of a given kind of a feature, and returns its length */
+	size_t getIndexableDescriptor(const CFeature &f, const TDescriptorType descriptor, std::vector<float> &out)
+	{
+		if (descriptor!=descSIFT && descriptor!=descSURF && descriptor!=descSpinImages)
+			THROW_EXCEPTION("Only SIFT, SURF and spin image descriptors can be indexed in a CDescriptorKDForest")
+		if (!getFloatDescriptor(f,descriptor,out))
+			THROW_EXCEPTION("A feature has no descriptor of the requested kind")
+		return out.size();
+	}
+
+	/** Keeps the pairings which pass the absolute and ratio thresholds, from the two nearest neighbors of each query */
+	template <typename DIST>
+	size_t acceptNNPairings(
+		const std::vector<std::vector<std::pair<DIST,size_t> > > &nn,
+		const DIST max_distance, const double max_ratio,
+		std::vector<std::pair<size_t,size_t> > &pairings, std::vector<DIST> *out_distances)
+	{
+		pairings.clear();
+		if (out_distances) out_distances->clear();
+		for (size_t i=0;i<nn.size();i++)
+		{
+			if (nn[i].empty() || nn[i][0].first>max_distance) continue;
+			if (nn[i].size()>1 && !(nn[i][0].first < max_ratio*nn[i][1].first)) continue;
+			pairings.push_back(std::make_pair(i,nn[i][0].second));
+			if (out_distances) out_distances->push_back(nn[i][0].first);
+		}
+		return pairings.size();
+	}
+
+	/** Functor for the batch searches of CDescriptorKDForest and CDescriptorLSH */
+	template <class INDEX, typename ELEM, typename DIST>
+	struct TBatchKNNQueries
+	{
+		const INDEX  &m_index;
+		const ELEM   *m_queries;
+		const size_t  m_len, m_k;
+		std::vector<std::vector<std::pair<DIST,size_t> > > &m_nn;
+
+		TBatchKNNQueries(const INDEX &index, const ELEM *queries, const size_t len, const size_t k, std::vector<std::vector<std::pair<DIST,size_t> > > &nn) :
+			m_index(index), m_queries(queries), m_len(len), m_k(k), m_nn(nn)
+		{ }
+
+		void operator()(const BlockedRange &r) const
+		{
+			std::vector<uint8_t>  visited(m_index.getIDCount(),0);
+			std::vector<uint32_t> touched;
+			for (int i=r.begin();i!=r.end();++i)
+				m_index.knnSearchImpl(m_queries + i*m_len, m_k, m_nn[i], visited, touched);
+		}
+	};
+
+	template <typename DIST>
+	void splitNeighbors(const std::vector<std::vector<std::pair<DIST,size_t> > > &nn, std::vector<std::vector<size_t> > &out_ids, std::vector<std::vector<DIST> > &out_dists)
+	{
+		out_ids.resize(nn.size());
+		out_dists.resize(nn.size());
+		for (size_t i=0;i<nn.size();i++)
+		{
+			out_ids[i].resize(nn[i].size());
+			out_dists[i].resize(nn[i].size());
+			for (size_t j=0;j<nn[i].size();j++)
+			{
+				out_ids[i][j] = nn[i][j].second;
+				out_dists[i][j] = nn[i][j].first;
+			}
+		}
+	}
+}
+
+/*-------------------------------------------------------------
+						CDescriptorKDForest
+-------------------------------------------------------------*/
+CDescriptorKDForest::TParams::TParams() :
+	nTrees(4),
+	leafSize(16),
+	maxChecks(256),
+	rebuildFactor(2.0),
+	seed(0x1234)
+{
+}
+
+CDescriptorKDForest::CDescriptorKDForest()
+{
+	clear();
+}
+
+void CDescriptorKDForest::clear()
+{
+	m_dim = 0;
+	m_nActive = 0;
+	m_nAtBuild = 0;
+	m_descs.clear();
+	m_removed.clear();
+	m_free_ids.clear();
+	m_trees.clear();
+	m_rng_state = params.seed;
+}
+
+uint32_t CDescriptorKDForest::nextRandom()
+{
+	// Numerical Recipes' LCG: enough for picking dimensions, and reproducible across platforms
+	m_rng_state = 1664525u*m_rng_state + 1013904223u;
+	return m_rng_state >> 8;
+}
+
+size_t CDescriptorKDForest::insert(const float *desc, const size_t length)
+{
+	MRPT_START
+
+	if (!m_dim)
+	{
+		ASSERT_(length>0)
+		m_dim = length;
+	}
+	else ASSERTMSG_(length==m_dim, "All the descriptors in the index must have the same length")
+	ASSERT_BELOW_(m_removed.size(),size_t(std::numeric_limits<uint32_t>::max()))
+
+	size_t id;
+	if (!m_free_ids.empty())
+	{
+		id = m_free_ids.back();
+		m_free_ids.pop_back();
+		m_removed[id] = 0;
+	}
+	else
+	{
+		id = m_removed.size();
+		m_removed.push_back(0);
+		m_descs.resize(m_descs.size()+m_dim);
+	}
+	std::memcpy(&m_descs[id*m_dim],desc,m_dim*sizeof(float));
+	m_nActive++;
+
+	if (m_trees.empty() || m_nActive > params.rebuildFactor*m_nAtBuild)
+		rebuild();
+	else
+	{
+		// Into the leaves of the current trees:
+		for (size_t t=0;t<m_trees.size();t++)
+		{
+			std::vector<TNode> &nodes = m_trees[t];
+			const uint32_t leaf = findLeaf(nodes,desc);
+			nodes[leaf].ids.push_back(static_cast<uint32_t>(id));
+			const size_t splitSize = nodes[leaf].splitSize ? nodes[leaf].splitSize : 2*std::max(1u,params.leafSize);
+			if (nodes[leaf].ids.size()>=splitSize)
+				splitNode(nodes,leaf);
+		}
+	}
+	return id;
+
+	MRPT_END
+}
+
+void CDescriptorKDForest::insert(const CFeatureList &feats, const TDescriptorType descriptor, std::vector<size_t> *out_ids)
+{
+	MRPT_START
+	if (out_ids) out_ids->resize(feats.size());
+	std::vector<float> desc;
+	for (size_t i=0;i<feats.size();i++)
+	{
+		const size_t len = getIndexableDescriptor(*feats[i],descriptor,desc);
+		const size_t id = insert(&desc[0],len);
+		if (out_ids) (*out_ids)[i] = id;
+	}
+	MRPT_END
+}
+
+void CDescriptorKDForest::remove(const size_t id)
+{
+	MRPT_START
+	ASSERTMSG_(contains(id), "There is no descriptor with that ID in the index")
+
+	// The descriptor is in the leaf each tree assigns to it:
+	for (size_t t=0;t<m_trees.size();t++)
+	{
+		std::vector<uint32_t> &ids = m_trees[t][findLeaf(m_trees[t],getDescriptor(id))].ids;
+		std::vector<uint32_t>::iterator it = std::find(ids.begin(),ids.end(),static_cast<uint32_t>(id));
+		ASSERT_(it!=ids.end())
+		*it = ids.back();
+		ids.pop_back();
+	}
+	m_removed[id] = 1;
+	m_free_ids.push_back(id);
+	m_nActive--;
+	MRPT_END
+}
+
+uint32_t CDescriptorKDForest::findLeaf(const std::vector<TNode> &nodes, const float *desc) const
+{
+	uint32_t n = 0;
+	while (nodes[n].dim>=0)
+		n = nodes[n].child[ desc[nodes[n].dim] < nodes[n].split ? 0:1 ];
+	return n;
+}
+
+void CDescriptorKDForest::rebuild()
+{
+	MRPT_START
+	m_rng_state = params.seed;
+	m_trees.clear();
+	m_trees.resize(std::max(1u,params.nTrees));
+
+	std::vector<uint32_t> all_ids;
+	all_ids.reserve(m_nActive);
+	for (size_t i=0;i<m_removed.size();i++)
+		if (!m_removed[i]) all_ids.push_back(static_cast<uint32_t>(i));
+
+	for (size_t t=0;t<m_trees.size();t++)
+	{
+		std::vector<uint32_t> ids = all_ids;
+		m_trees[t].resize(1);
+		buildTree(m_trees[t],0,ids);
+	}
+	m_nAtBuild = m_nActive;
+	MRPT_END
+}
+
+void CDescriptorKDForest::buildTree(std::vector<TNode> &nodes, const uint32_t node_idx, std::vector<uint32_t> &ids)
+{
+	nodes[node_idx].dim = -1;
+	nodes[node_idx].splitSize = 0;
+	nodes[node_idx].ids.swap(ids);
+	if (nodes[node_idx].ids.size()>std::max(1u,params.leafSize))
+		splitNode(nodes,node_idx);
+}
+
+void CDescriptorKDForest::splitNode(std::vector<TNode> &nodes, const uint32_t node_idx)
+{
+	std::vector<uint32_t> ids;
+	ids.swap(nodes[node_idx].ids);
+	const size_t N = ids.size();
+
+	// Mean and variance of each dimension, from a sample of the descriptors:
+	const size_t nSamples = std::min(N,KDFOREST_MEAN_SAMPLES);
+	std::vector<double> mean(m_dim,0.0), var(m_dim,0.0);
+	for (size_t s=0;s<nSamples;s++)
+	{
+		const float *d = getDescriptor(ids[s*N/nSamples]);
+		for (size_t j=0;j<m_dim;j++) mean[j]+=d[j];
+	}
+	for (size_t j=0;j<m_dim;j++) mean[j]/=nSamples;
+	for (size_t s=0;s<nSamples;s++)
+	{
+		const float *d = getDescriptor(ids[s*N/nSamples]);
+		for (size_t j=0;j<m_dim;j++) var[j]+=mrpt::utils::square(d[j]-mean[j]);
+	}
+
+	// Pick one of the dimensions with the largest variance:
+	std::vector<std::pair<double,size_t> > by_var(m_dim);
+	for (size_t j=0;j<m_dim;j++) by_var[j] = std::make_pair(-var[j],j);
+	const size_t nCandidates = std::min(size_t(KDFOREST_RAND_DIMS),m_dim);
+	std::partial_sort(by_var.begin(),by_var.begin()+nCandidates,by_var.end());
+	const size_t dim = by_var[nextRandom()%nCandidates].second;
+	const float split = static_cast<float>(mean[dim]);
+
+	std::vector<uint32_t> left, right;
+	for (size_t i=0;i<N;i++)
+		(getDescriptor(ids[i])[dim] < split ? left:right).push_back(ids[i]);
+
+	if (left.empty() || right.empty())
+	{
+		// All the descriptors are equal in that dimension: keep it as a (larger) leaf, which won't be tried
+		//  again until it doubles its size, so the cost of failed splits is amortized over the insertions:
+		nodes[node_idx].ids.swap(ids);
+		nodes[node_idx].splitSize = static_cast<uint32_t>(2*N);
+		return;
+	}
+
+	const uint32_t c0 = static_cast<uint32_t>(nodes.size());
+	nodes.resize(nodes.size()+2);   // Notice: this invalidates references to nodes
+	nodes[node_idx].dim = static_cast<int32_t>(dim);
+	nodes[node_idx].split = split;
+	nodes[node_idx].child[0] = c0;
+	nodes[node_idx].child[1] = c0+1;
+	buildTree(nodes,c0,left);
+	buildTree(nodes,c0+1,right);
+}
+
+void CDescriptorKDForest::knnSearchImpl(const float *query, const size_t k, std::vector<std::pair<float,size_t> > &out_nn, std::vector<uint8_t> &visited, std::vector<uint32_t> &touched) const
+{
+	out_nn.clear();
+	if (!m_nActive || !k) return;
+
+	if (!params.maxChecks)
+	{
+		// Exact search:
+		for (size_t i=0;i<m_removed.size();i++)
+			if (!m_removed[i])
+				insertNeighbor(out_nn,k,sqrDistance(query,getDescriptor(i),m_dim),i);
+		return;
+	}
+
+	// "Best bin first": branches not taken are kept in a priority queue sorted by their (approximate) distance to the query
+	typedef std::pair<float,std::pair<uint32_t,uint32_t> > TBranch;  // (-distance, (tree,node))
+	std::priority_queue<TBranch> branches;
+	for (size_t t=0;t<m_trees.size();t++)
+		branches.push(TBranch(0.0f,std::make_pair(static_cast<uint32_t>(t),0u)));
+
+	touched.clear();
+	size_t nChecks = 0;
+	while (!branches.empty())
+	{
+		const TBranch b = branches.top();
+		branches.pop();
+		const float mindist = -b.first;
+		if (out_nn.size()==k && (nChecks>=params.maxChecks || mindist>=out_nn.back().first))
+			break;
+
+		// Descend to a leaf:
+		const std::vector<TNode> &nodes = m_trees[b.second.first];
+		uint32_t n = b.second.second;
+		while (nodes[n].dim>=0)
+		{
+			const TNode &node = nodes[n];
+			const float diff = query[node.dim]-node.split;
+			const int side = diff<0 ? 0:1;
+			branches.push(TBranch(-(mindist+diff*diff),std::make_pair(b.second.first,node.child[1-side])));
+			n = node.child[side];
+		}
+
+		const std::vector<uint32_t> &ids = nodes[n].ids;
+		for (size_t i=0;i<ids.size();i++)
+		{
+			const uint32_t id = ids[i];
+			if (visited[id]) continue;
+			visited[id] = 1;
+			touched.push_back(id);
+			insertNeighbor(out_nn,k,sqrDistance(query,getDescriptor(id),m_dim),size_t(id));
+			nChecks++;
+		}
+	}
+
+	for (size_t i=0;i<touched.size();i++)
+		visited[touched[i]] = 0;
+}
+
+size_t CDescriptorKDForest::knnSearch(const float *query, const size_t k, std::vector<size_t> &out_ids, std::vector<float> &out_sqr_dists) const
+{
+	std::vector<std::pair<float,size_t> > nn;
+	std::vector<uint8_t>  visited(m_removed.size(),0);
+	std::vector<uint32_t> touched;
+	knnSearchImpl(query,k,nn,visited,touched);
+
+	out_ids.resize(nn.size());
+	out_sqr_dists.resize(nn.size());
+	for (size_t i=0;i<nn.size();i++)
+	{
+		out_ids[i] = nn[i].second;
+		out_sqr_dists[i] = nn[i].first;
+	}
+	return nn.size();
+}
+
+void CDescriptorKDForest::knnSearchBatch(
+	const float *queries,
+	const size_t nQueries,
+	const size_t k,
+	std::vector<std::vector<size_t> > &out_ids,
+	std::vector<std::vector<float> >  &out_sqr_dists) const
+{
+	std::vector<std::vector<std::pair<float,size_t> > > nn(nQueries);
+	if (nQueries)
+		mrpt::system::parallel_for(
+			BlockedRange(0,static_cast<int>(nQueries),16),
+			TBatchKNNQueries<CDescriptorKDForest,float,float>(*this,queries,m_dim,k,nn) );
+	splitNeighbors(nn,out_ids,out_sqr_dists);
+}
+
+size_t CDescriptorKDForest::find_pairings(
+	std::vector<std::pair<size_t,size_t> > & pairings,
+	const CFeatureList                     & feats,
+	const TDescriptorType                    descriptor,
+	const float                              max_distance,
+	const double                             max_ratio,
+	std::vector<float>                     * out_distances ) const
+{
+	MRPT_START
+
+	pairings.clear();
+	if (out_distances) out_distances->clear();
+	if (feats.empty() || !m_nActive)
+		return 0;
+
+	// Pack the query descriptors:
+	const size_t N = feats.size();
+	std::vector<float> queries(N*m_dim), desc;
+	for (size_t i=0;i<N;i++)
+	{
+		ASSERTMSG_(getIndexableDescriptor(*feats[i],descriptor,desc)==m_dim, "The descriptors of the features and those in the index have different lengths")
+		std::memcpy(&queries[i*m_dim],&desc[0],m_dim*sizeof(float));
+	}
+
+	std::vector<std::vector<std::pair<float,size_t> > > nn(N);
+	mrpt::system::parallel_for(
+		BlockedRange(0,static_cast<int>(N),16),
+		TBatchKNNQueries<CDescriptorKDForest,float,float>(*this,&queries[0],m_dim,2,nn) );
+
+	for (size_t i=0;i<N;i++)
+		for (size_t j=0;j<nn[i].size();j++)
+			nn[i][j].first = std::sqrt(nn[i][j].first);
+
+	return acceptNNPairings(nn,max_distance,max_ratio,pairings,out_distances);
+
+	MRPT_END
+}
+
+void CDescriptorKDForest::writeToStream(CStream &out, int *version) const
+{
+	if (version)
+		*version = 1;
+	else
+	{
+		out << params.nTrees << params.leafSize << params.maxChecks << params.rebuildFactor << params.seed;
+		out << static_cast<uint32_t>(m_dim) << static_cast<uint32_t>(m_nAtBuild) << m_rng_state;
+		out << m_descs << m_removed;
+
+		out << static_cast<uint32_t>(m_trees.size());
+		for (size_t t=0;t<m_trees.size();t++)
+		{
+			const std::vector<TNode> &nodes = m_trees[t];
+			out << static_cast<uint32_t>(nodes.size());
+			for (size_t n=0;n<nodes.size();n++)
+			{
+				out << nodes[n].dim;
+				if (nodes[n].dim>=0)
+					out << nodes[n].split << nodes[n].child[0] << nodes[n].child[1];
+				else out << nodes[n].ids << nodes[n].splitSize;
+			}
+		}
+	}
+}
+
+void CDescriptorKDForest::readFromStream(CStream &in, int version)
+{
+	switch(version)
+	{
+	case 0:
+	case 1:
+		{
+			clear();
+			uint32_t dim, nAtBuild, nTrees, nNodes;
+			in >> params.nTrees >> params.leafSize >> params.maxChecks >> params.rebuildFactor >> params.seed;
+			in >> dim >> nAtBuild >> m_rng_state;
+			in >> m_descs >> m_removed;
+			m_dim = dim;
+			m_nAtBuild = nAtBuild;
+			ASSERT_(m_descs.size()==m_dim*m_removed.size())
+
+			for (size_t i=0;i<m_removed.size();i++)
+			{
+				if (m_removed[i])
+					m_free_ids.push_back(i);
+				else m_nActive++;
+			}
+			// Free IDs are reused from the lowest one:
+			std::reverse(m_free_ids.begin(),m_free_ids.end());
+
+			in >> nTrees;
+			m_trees.resize(nTrees);
+			for (size_t t=0;t<nTrees;t++)
+			{
+				in >> nNodes;
+				std::vector<TNode> &nodes = m_trees[t];
+				nodes.resize(nNodes);
+				for (size_t n=0;n<nNodes;n++)
+				{
+					in >> nodes[n].dim;
+					if (nodes[n].dim>=0)
+						in >> nodes[n].split >> nodes[n].child[0] >> nodes[n].child[1];
+					else
+					{
+						in >> nodes[n].ids;
+						if (version>=1)
+							in >> nodes[n].splitSize;
+						else nodes[n].splitSize = 0;
+					}
+				}
+			}
+		} break;
+	default:
+		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+	};
+}
+
+/*-------------------------------------------------------------
+						CDescriptorLSH
+-------------------------------------------------------------*/
+CDescriptorLSH::TParams::TParams() :
+	nTables(6),
+	keyBits(14),
+	multiProbe(true),
+	seed(0x1234)
+{
+}
+
+CDescriptorLSH::CDescriptorLSH()
+{
+	clear();
+}
+
+void CDescriptorLSH::clear()
+{
+	m_nBytes = 0;
+	m_nActive = 0;
+	m_descs.clear();
+	m_removed.clear();
+	m_free_ids.clear();
+	m_key_bits.clear();
+	m_buckets.clear();
+}
+
+void CDescriptorLSH::initTables()
+{
+	ASSERT_(params.nTables>0 && params.keyBits>0 && params.keyBits<=20)
+	const size_t nBits = 8*m_nBytes;
+	const unsigned int keyBits = static_cast<unsigned int>( std::min(size_t(params.keyBits),nBits) );
+
+	// Different random bit positions for each table:
+	uint32_t rng = params.seed;
+	std::vector<uint16_t> all_bits(nBits);
+	for (size_t i=0;i<nBits;i++) all_bits[i] = static_cast<uint16_t>(i);
+
+	m_key_bits.resize(params.nTables);
+	m_buckets.assign(params.nTables, std::vector<std::vector<uint32_t> >(size_t(1)<<keyBits) );
+	for (size_t t=0;t<params.nTables;t++)
+	{
+		// Partial Fisher-Yates shuffle:
+		for (unsigned int b=0;b<keyBits;b++)
+		{
+			rng = 1664525u*rng + 1013904223u;
+			std::swap(all_bits[b], all_bits[b + (rng>>8)%(nBits-b)]);
+		}
+		m_key_bits[t].assign(all_bits.begin(),all_bits.begin()+keyBits);
+	}
+}
+
+uint32_t CDescriptorLSH::computeKey(const size_t table, const uint8_t *desc) const
+{
+	const std::vector<uint16_t> &bits = m_key_bits[table];
+	uint32_t key = 0;
+	for (size_t b=0;b<bits.size();b++)
+		key |= static_cast<uint32_t>((desc[bits[b]>>3] >> (bits[b]&7)) & 1) << b;
+	return key;
+}
+
+size_t CDescriptorLSH::insert(const uint8_t *desc, const size_t nBytes)
+{
+	MRPT_START
+
+	if (!m_nBytes)
+	{
+		ASSERT_(nBytes>0)
+		m_nBytes = nBytes;
+		initTables();
+	}
+	else ASSERTMSG_(nBytes==m_nBytes, "All the descriptors in the index must have the same length")
+	ASSERT_BELOW_(m_removed.size(),size_t(std::numeric_limits<uint32_t>::max()))
+
+	size_t id;
+	if (!m_free_ids.empty())
+	{
+		id = m_free_ids.back();
+		m_free_ids.pop_back();
+		m_removed[id] = 0;
+	}
+	else
+	{
+		id = m_removed.size();
+		m_removed.push_back(0);
+		m_descs.resize(m_descs.size()+m_nBytes);
+	}
+	std::memcpy(&m_descs[id*m_nBytes],desc,m_nBytes);
+	m_nActive++;
+
+	for (size_t t=0;t<m_buckets.size();t++)
+		m_buckets[t][computeKey(t,desc)].push_back(static_cast<uint32_t>(id));
+	return id;
+
+	MRPT_END
+}
+
+void CDescriptorLSH::insert(const CFeatureList &feats, std::vector<size_t> *out_ids)
+{
+	MRPT_START
+	if (out_ids) out_ids->resize(feats.size());
+	for (size_t i=0;i<feats.size();i++)
+	{
+		const std::vector<uint8_t> &d = feats[i]->descriptors.ORB;
+		ASSERTMSG_(!d.empty(), "A feature has no ORB descriptor")
+		const size_t id = insert(&d[0],d.size());
+		if (out_ids) (*out_ids)[i] = id;
+	}
+	MRPT_END
+}
+
+void CDescriptorLSH::remove(const size_t id)
+{
+	MRPT_START
+	ASSERTMSG_(contains(id), "There is no descriptor with that ID in the index")
+	for (size_t t=0;t<m_buckets.size();t++)
+	{
+		std::vector<uint32_t> &ids = m_buckets[t][computeKey(t,getDescriptor(id))];
+		std::vector<uint32_t>::iterator it = std::find(ids.begin(),ids.end(),static_cast<uint32_t>(id));
+		ASSERT_(it!=ids.end())
+		*it = ids.back();
+		ids.pop_back();
+	}
+	m_removed[id] = 1;
+	m_free_ids.push_back(id);
+	m_nActive--;
+	MRPT_END
+}
+
+void CDescriptorLSH::knnSearchImpl(const uint8_t *query, const size_t k, std::vector<std::pair<uint32_t,size_t> > &out_nn, std::vector<uint8_t> &visited, std::vector<uint32_t> &touched) const
+{
+	out_nn.clear();
+	if (!m_nActive || !k) return;
+
+	touched.clear();
+	for (size_t t=0;t<m_buckets.size();t++)
+	{
+		const uint32_t key = computeKey(t,query);
+		const size_t nProbes = params.multiProbe ? m_key_bits[t].size()+1 : 1;
+		for (size_t p=0;p<nProbes;p++)
+		{
+			// The query key, then those with one bit flipped:
+			const std::vector<uint32_t> &ids = m_buckets[t][ p==0 ? key : key^(1u<<(p-1)) ];
+			for (size_t i=0;i<ids.size();i++)
+			{
+				const uint32_t id = ids[i];
+				if (visited[id]) continue;
+				visited[id] = 1;
+				touched.push_back(id);
+				insertNeighbor(out_nn,k,hammingDistance(query,getDescriptor(id),m_nBytes),size_t(id));
+			}
+		}
+	}
+
+	for (size_t i=0;i<touched.size();i++)
+		visited[touched[i]] = 0;
+}
+
+size_t CDescriptorLSH::knnSearch(const uint8_t *query, const size_t k, std::vector<size_t> &out_ids, std::vector<uint32_t> &out_dists) const
+{
+	std::vector<std::pair<uint32_t,size_t> > nn;
+	std::vector<uint8_t>  visited(m_removed.size(),0);
+	std::vector<uint32_t> touched;
+	knnSearchImpl(query,k,nn,visited,touched);
+
+	out_ids.resize(nn.size());
+	out_dists.resize(nn.size());
+	for (size_t i=0;i<nn.size();i++)
+	{
+		out_ids[i] = nn[i].second;
+		out_dists[i] = nn[i].first;
+	}
+	return nn.size();
+}
+
+void CDescriptorLSH::knnSearchBatch(
+	const uint8_t *queries,
+	const size_t nQueries,
+	const size_t k,
+	std::vector<std::vector<size_t> >   &out_ids,
+	std::vector<std::vector<uint32_t> > &out_dists) const
+{
+	std::vector<std::vector<std::pair<uint32_t,size_t> > > nn(nQueries);
+	if (nQueries)
+		mrpt::system::parallel_for(
+			BlockedRange(0,static_cast<int>(nQueries),16),
+			TBatchKNNQueries<CDescriptorLSH,uint8_t,uint32_t>(*this,queries,m_nBytes,k,nn) );
+	splitNeighbors(nn,out_ids,out_dists);
+}
+
+size_t CDescriptorLSH::find_pairings(
+	std::vector<std::pair<size_t,size_t> > & pairings,
+	const CFeatureList                     & feats,
+	const unsigned int                       max_distance,
+	const double                             max_ratio,
+	std::vector<uint32_t>                  * out_distances ) const
+{
+	MRPT_START
+
+	pairings.clear();
+	if (out_distances) out_distances->clear();
+	if (feats.empty() || !m_nActive)
+		return 0;
+
+	const size_t N = feats.size();
+	std::vector<uint8_t> queries(N*m_nBytes);
+	for (size_t i=0;i<N;i++)
+	{
+		const std::vector<uint8_t> &d = feats[i]->descriptors.ORB;
+		ASSERTMSG_(d.size()==m_nBytes, "The ORB descriptors of the features and those in the index have different lengths")
+		std::memcpy(&queries[i*m_nBytes],&d[0],m_nBytes);
+	}
+
+	std::vector<std::vector<std::pair<uint32_t,size_t> > > nn(N);
+	mrpt::system::parallel_for(
+		BlockedRange(0,static_cast<int>(N),16),
+		TBatchKNNQueries<CDescriptorLSH,uint8_t,uint32_t>(*this,&queries[0],m_nBytes,2,nn) );
+
+	return acceptNNPairings(nn,static_cast<uint32_t>(max_distance),max_ratio,pairings,out_distances);
+
+	MRPT_END
+}
+
+void CDescriptorLSH::writeToStream(CStream &out, int *version) const
+{
+	if (version)
+		*version = 0;
+	else
+	{
+		out << params.nTables << params.keyBits << params.multiProbe << params.seed;
+		out << static_cast<uint32_t>(m_nBytes);
+		out << m_descs << m_removed;
+		// The hash tables are rebuilt when loading, from the bit positions of their keys:
+		out << static_cast<uint32_t>(m_key_bits.size());
+		for (size_t t=0;t<m_key_bits.size();t++)
+			out << m_key_bits[t];
+	}
+}
+
+void CDescriptorLSH::readFromStream(CStream &in, int version)
+{
+	switch(version)
+	{
+	case 0:
+		{
+			clear();
+			uint32_t nBytes, nTables;
+			in >> params.nTables >> params.keyBits >> params.multiProbe >> params.seed;
+			in >> nBytes;
+			in >> m_descs >> m_removed;
+			m_nBytes = nBytes;
+			ASSERT_(m_descs.size()==m_nBytes*m_removed.size())
+
+			in >> nTables;
+			m_key_bits.resize(nTables);
+			for (size_t t=0;t<nTables;t++)
+				in >> m_key_bits[t];
+
+			m_buckets.resize(nTables);
+			for (size_t t=0;t<nTables;t++)
+				m_buckets[t].assign(size_t(1)<<m_key_bits[t].size(), std::vector<uint32_t>());
+
+			for (size_t i=0;i<m_removed.size();i++)
+			{
+				if (m_removed[i])
+				{
+					m_free_ids.push_back(i);
+					continue;
+				}
+				m_nActive++;
+				for (size_t t=0;t<nTables;t++)
+					m_buckets[t][computeKey(t,getDescriptor(i))].push_back(static_cast<uint32_t>(i));
+			}
+			std::reverse(m_free_ids.begin(),m_free_ids.end());
+		} break;
+	default:
+		MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+	};
+}
@@ -0,0 +1,227 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace mrpt::random;
+using namespace std;
+
+// SIFT-like features: random descriptors, and queries which are perturbed copies of some of them (query "i" is a copy of train[(i*7)%N]):
+static void makeSIFTFeatureLists(CFeatureList &train, CFeatureList &queries)
+{
+	CRandomGenerator rng(1234);
+	const size_t N = 1000, D = 64;
+	for (size_t i=0;i<N;i++)
+	{
+		CFeaturePtr f = CFeature::Create();
+		f->descriptors.SIFT.resize(D);
+		for (size_t j=0;j<D;j++)
+			f->descriptors.SIFT[j] = static_cast<unsigned char>(rng.drawUniform32bit() % 256);
+		train.push_back(f);
+	}
+	for (size_t i=0;i<N/4;i++)
+	{
+		CFeaturePtr f = CFeature::Create();
+		f->ID = i;
+		f->descriptors.SIFT = train[(i*7)%N]->descriptors.SIFT;
+		for (size_t j=0;j<D;j++)
+			f->descriptors.SIFT[j] = static_cast<unsigned char>( std::max(0,std::min(255, int(f->descriptors.SIFT[j]) + int(rng.drawUniform32bit()%11)-5 )) );
+		queries.push_back(f);
+	}
+}
+
+TEST(DescriptorIndex, KDForestMatchesPerturbedCopies)
+{
+	CFeatureList train, queries;
+	makeSIFTFeatureLists(train,queries);
+
+	CDescriptorKDForest index;
+	std::vector<size_t> ids;
+	index.insert(train,descSIFT,&ids);
+	EXPECT_EQ(index.size(), train.size());
+	EXPECT_EQ(index.getDescriptorLength(), 64u);
+
+	std::vector<std::pair<size_t,size_t> > pairings;
+	std::vector<float> dists;
+	index.find_pairings(pairings,queries,descSIFT,200.0f,0.8,&dists);
+	EXPECT_GE(pairings.size(), queries.size()*95/100);
+	for (size_t i=0;i<pairings.size();i++)
+	{
+		EXPECT_EQ(pairings[i].second, ids[(queries[pairings[i].first]->ID*7)%train.size()]);
+		EXPECT_NEAR(dists[i], queries[pairings[i].first]->descriptorSIFTDistanceTo(*train[(queries[pairings[i].first]->ID*7)%train.size()],false), 1e-2);
+	}
+
+	// Exact searches give the same neighbors as a linear scan:
+	index.params.maxChecks = 0;
+	std::vector<size_t> nn_ids;
+	std::vector<float> nn_dists;
+	std::vector<float> q(queries[0]->descriptors.SIFT.begin(),queries[0]->descriptors.SIFT.end());
+	ASSERT_EQ(index.knnSearch(&q[0],5,nn_ids,nn_dists), 5u);
+	std::vector<double> all_dists(train.size());
+	for (size_t i=0;i<train.size();i++)
+		all_dists[i] = square(queries[0]->descriptorSIFTDistanceTo(*train[i],false));
+	std::sort(all_dists.begin(),all_dists.end());
+	for (size_t k=0;k<5;k++)
+	{
+		EXPECT_NEAR(nn_dists[k], all_dists[k], 1e-4*all_dists[k]);
+		EXPECT_NEAR(nn_dists[k], square(queries[0]->descriptorSIFTDistanceTo(*train[nn_ids[k]],false)), 1e-4*all_dists[k]);
+	}
+}
+
+TEST(DescriptorIndex, KDForestInsertRemoveAndSerialize)
+{
+	CFeatureList train, queries;
+	makeSIFTFeatureLists(train,queries);
+
+	CDescriptorKDForest index;
+	std::vector<size_t> ids;
+	index.insert(train,descSIFT,&ids);
+
+	// Remove every other descriptor: their IDs are never returned, and are reused by new insertions.
+	for (size_t i=0;i<ids.size();i+=2)
+		index.remove(ids[i]);
+	EXPECT_EQ(index.size(), train.size()/2);
+	EXPECT_FALSE(index.contains(ids[0]));
+	EXPECT_TRUE(index.contains(ids[1]));
+
+	std::vector<float> d(train[0]->descriptors.SIFT.begin(),train[0]->descriptors.SIFT.end());
+	const size_t new_id = index.insert(&d[0],d.size());
+	EXPECT_TRUE(new_id < train.size() && (new_id%2)==0);
+	EXPECT_EQ(index.size(), train.size()/2+1);
+
+	std::vector<std::vector<size_t> > nn_ids;
+	std::vector<std::vector<float> > nn_dists;
+	std::vector<float> qs;
+	for (size_t i=0;i<queries.size();i++)
+		qs.insert(qs.end(),queries[i]->descriptors.SIFT.begin(),queries[i]->descriptors.SIFT.end());
+	index.knnSearchBatch(&qs[0],queries.size(),3,nn_ids,nn_dists);
+	ASSERT_EQ(nn_ids.size(), queries.size());
+	for (size_t i=0;i<nn_ids.size();i++)
+	{
+		EXPECT_EQ(nn_ids[i].size(), 3u);
+		for (size_t k=0;k<nn_ids[i].size();k++)
+			EXPECT_TRUE(index.contains(nn_ids[i][k]));
+	}
+	EXPECT_EQ(nn_ids[0][0], new_id);  // The first query is a perturbed copy of train[0]
+
+	// Save & load give identical results:
+	CMemoryStream buf;
+	buf << index;
+	buf.Seek(0);
+	CDescriptorKDForest index2;
+	buf >> index2;
+	EXPECT_EQ(index2.size(), index.size());
+
+	std::vector<std::vector<size_t> > nn_ids2;
+	std::vector<std::vector<float> > nn_dists2;
+	index2.knnSearchBatch(&qs[0],queries.size(),3,nn_ids2,nn_dists2);
+	EXPECT_EQ(nn_ids, nn_ids2);
+
+	// Both remove and insert in the same way after loading:
+	index.remove(new_id);
+	index2.remove(new_id);
+	EXPECT_EQ(index.insert(&d[0],d.size()), index2.insert(&d[0],d.size()));
+}
+
+TEST(DescriptorIndex, KDForestManyEqualDescriptors)
+{
+	// The leaf of equal descriptors cannot be split: it keeps growing, also after saving & loading the index.
+	const size_t N = 5000, D = 32;
+	std::vector<float> d(D,1.0f), other(D,2.0f);
+	CDescriptorKDForest index;
+	index.insert(&other[0],D);
+	for (size_t i=0;i<N;i++)
+		index.insert(&d[0],D);
+	EXPECT_EQ(index.size(), N+1);
+
+	CMemoryStream buf;
+	buf << index;
+	buf.Seek(0);
+	CDescriptorKDForest index2;
+	buf >> index2;
+	for (size_t i=0;i<N;i++)
+	{
+		index.insert(&d[0],D);
+		index2.insert(&d[0],D);
+	}
+	EXPECT_EQ(index2.size(), 2*N+1);
+
+	std::vector<size_t> nn_ids, nn_ids2;
+	std::vector<float> nn_dists, nn_dists2;
+	ASSERT_EQ(index.knnSearch(&other[0],2,nn_ids,nn_dists), 2u);
+	EXPECT_EQ(nn_ids[0], 0u);
+	EXPECT_EQ(nn_dists[0], 0.0f);
+	EXPECT_EQ(nn_dists[1], float(D));
+	ASSERT_EQ(index2.knnSearch(&other[0],2,nn_ids2,nn_dists2), 2u);
+	EXPECT_EQ(nn_ids2[0], 0u);
+	EXPECT_EQ(nn_dists2, nn_dists);
+}
+
+TEST(DescriptorIndex, LSHMatchesPerturbedCopies)
+{
+	CRandomGenerator rng(4321);
+	const size_t N = 2000, nBytes = 32;
+	std::vector<uint8_t> descs(N*nBytes);
+	for (size_t i=0;i<descs.size();i++)
+		descs[i] = static_cast<uint8_t>(rng.drawUniform32bit() & 0xFF);
+
+	CDescriptorLSH index;
+	for (size_t i=0;i<N;i++)
+		EXPECT_EQ(index.insert(&descs[i*nBytes],nBytes), i);
+
+	// Copies with up to 10 flipped bits:
+	CFeatureList queries;
+	for (size_t i=0;i<N;i+=10)
+	{
+		CFeaturePtr f = CFeature::Create();
+		f->ID = i;
+		f->descriptors.ORB.assign(descs.begin()+i*nBytes,descs.begin()+(i+1)*nBytes);
+		const unsigned int nFlips = rng.drawUniform32bit() % 11;
+		for (unsigned int k=0;k<nFlips;k++)
+		{
+			const unsigned int bit = rng.drawUniform32bit() % (8*nBytes);
+			f->descriptors.ORB[bit/8] ^= static_cast<uint8_t>(1 << (bit%8));
+		}
+		queries.push_back(f);
+	}
+
+	std::vector<std::pair<size_t,size_t> > pairings;
+	std::vector<uint32_t> dists;
+	index.find_pairings(pairings,queries,64,0.8,&dists);
+	EXPECT_GE(pairings.size(), queries.size()*95/100);
+	for (size_t i=0;i<pairings.size();i++)
+	{
+		EXPECT_EQ(pairings[i].second, queries[pairings[i].first]->ID);
+		EXPECT_EQ(dists[i], hammingDistance(&queries[pairings[i].first]->descriptors.ORB[0], index.getDescriptor(pairings[i].second), nBytes));
+	}
+
+	// Removed descriptors are no longer found:
+	for (size_t i=0;i<N;i+=20)
+		index.remove(i);
+	EXPECT_EQ(index.size(), N-N/20);
+	index.find_pairings(pairings,queries,64,0.8);
+	for (size_t i=0;i<pairings.size();i++)
+		EXPECT_NE(pairings[i].second%20, 0u);
+
+	// Save & load give identical results:
+	CMemoryStream buf;
+	buf << index;
+	buf.Seek(0);
+	CDescriptorLSH index2;
+	buf >> index2;
+	EXPECT_EQ(index2.size(), index.size());
+	std::vector<std::pair<size_t,size_t> > pairings2;
+	index2.find_pairings(pairings2,queries,64,0.8);
+	EXPECT_EQ(pairings, pairings2);
+}
@@ -0,0 +1,82 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#ifndef descriptor_internals_H
+#define descriptor_internals_H
+
+#include <mrpt/vision/CFeature.h>
+#include <mrpt/utils/SSE_types.h>
+
+// Declarations shared between CVocabularyTree.cpp and descriptor_index.cpp, but which are private to MRPT
+//  not to be seen by an MRPT API user.
+
+namespace mrpt
+{
+	namespace vision
+	{
+		namespace detail
+		{
+			/** Squared Euclidean distance between two vectors of \a n floats */
+			inline float sqrDistance(const float *a, const float *b, const size_t n)
+			{
+				size_t i = 0;
+				float d = 0;
+#if MRPT_HAS_SSE2
+				__m128 acc = _mm_setzero_ps();
+				for (;i+4<=n;i+=4)
+				{
+					const __m128 diff = _mm_sub_ps(_mm_loadu_ps(a+i),_mm_loadu_ps(b+i));
+					acc = _mm_add_ps(acc,_mm_mul_ps(diff,diff));
+				}
+				float MRPT_ALIGN16 parts[4];
+				_mm_store_ps(parts,acc);
+				d = (parts[0]+parts[1])+(parts[2]+parts[3]);
+#endif
+				for (;i<n;i++)
+					d += (a[i]-b[i])*(a[i]-b[i]);
+				return d;
+			}
+
+			/** Copies into \a out the descriptor of a given kind of a feature as a vector of floats (for ORB, one 0/1 value per bit).
+			  * \return false if the feature has no descriptor of that kind.
+			  * \exception std::exception If the kind of descriptor is not SIFT, SURF, spin images or ORB.
+			  */
+			inline bool getFloatDescriptor(const CFeature &f, const TDescriptorType descriptor, std::vector<float> &out)
+			{
+				switch (descriptor)
+				{
+				case descSIFT:
+					out.assign(f.descriptors.SIFT.begin(),f.descriptors.SIFT.end());
+					break;
+				case descSURF:
+					out.assign(f.descriptors.SURF.begin(),f.descriptors.SURF.end());
+					break;
+				case descSpinImages:
+					out.assign(f.descriptors.SpinImg.begin(),f.descriptors.SpinImg.end());
+					break;
+				case descORB:
+					{
+						const std::vector<uint8_t> &orb = f.descriptors.ORB;
+						out.resize(8*orb.size());
+						for (size_t i=0;i<orb.size();i++)
+							for (size_t b=0;b<8;b++)
+								out[8*i+b] = (orb[i] & (1<<b)) ? 1.0f : 0.0f;
+					}
+					break;
+				default:
+					THROW_EXCEPTION("Only SIFT, SURF, spin image and ORB descriptors can be converted into vectors of floats")
+				}
+				return !out.empty();
+			}
+
+		} // end namespace detail
+	} // end namespace vision
+} // end namespace mrpt
+
+#endif
@@ -1183,32 +1183,26 @@ void  CLandmarksMap::computeMatchingWith3DLandmarks(
 		// 3. Compute likelihood based only on the position of the 3D landmarks.
 
 		// 1.- COMPUTE EDD
+		// The closest descriptor of this map to each one of the other map is searched in the (persistent) index of our descriptors:
+		const mrpt::vision::CDescriptorKDForest &index = landmarks.getSIFTDescriptorIndex();
 
-		ASSERT_( !anotherMap->landmarks.begin()->features.empty() )
-		ASSERT_( !landmarks.begin()->features.empty() )
-
-		unsigned int	dLen = anotherMap->landmarks.begin()->features[0]->descriptors.SIFT.size();
+		std::vector<size_t>	nnIdx;
+		std::vector<float>	nnSqrDist;
+		std::vector<float>	query;
 		for (k = 0, otherIt = anotherMap->landmarks.begin(); otherIt != anotherMap->landmarks.end(); otherIt++, k++)
 		{
-			double			mEDD = -1.0;
-			unsigned int	mEDDidx = 0;
-			for (j = 0, thisIt = landmarks.begin(); thisIt != landmarks.end(); thisIt++, j++)
-			{
-				// Compute EDD
-				double EDD = 0.0;
-				for ( i = 0; i < dLen; i++ )
-					EDD += square( otherIt->features[0]->descriptors.SIFT[i] - thisIt->features[0]->descriptors.SIFT[i] );
+			if (otherIt->getType()!=featSIFT || otherIt->features.empty() || !otherIt->features[0].present() ||
+				otherIt->features[0]->descriptors.SIFT.size()!=index.getDescriptorLength() )
+				continue;
 
-				EDD = sqrt(EDD);
+			query.assign(otherIt->features[0]->descriptors.SIFT.begin(),otherIt->features[0]->descriptors.SIFT.end());
+			if (!index.knnSearch(&query[0],1,nnIdx,nnSqrDist))
+				continue;
 
-				if ( EDD > mEDD )
-				{
-					mEDD	= EDD;
-					mEDDidx = j;
-				} // end if
-			} // end for j
+			const double		mEDD	= sqrt(nnSqrDist[0]);
+			const unsigned int	mEDDidx = landmarks.getSIFTDescriptorIndexLandmark(nnIdx[0]);
 
-			if ( mEDD > insertionOptions.SiftEDDThreshold )
+			if ( mEDD < insertionOptions.SiftEDDThreshold )
 			{
 				// There is a correspondence
 				if ( !thisLandmarkAssigned[ mEDDidx ] ) // If there is not multiple correspondence
@@ -1219,10 +1213,7 @@ void  CLandmarksMap::computeMatchingWith3DLandmarks(
 					// OK: A correspondence found!!
 					otherCorrespondences[k] = true;
 
-					otherIt->getPose( pointPDF_k );
-					thisIt->getPose( pointPDF_j );
-
-					match.this_idx	= j;
+					match.this_idx	= mEDDidx;
 					match.this_x	= landmarks.get(mEDDidx)->pose_mean.x;
 					match.this_y	= landmarks.get(mEDDidx)->pose_mean.y;
 					match.this_z	= landmarks.get(mEDDidx)->pose_mean.z;
@@ -1664,6 +1655,10 @@ void  CLandmarksMap::TCustomSequenceLandmarks::clear()
 	m_grid.clear();
 
 	m_largestDistanceFromOriginIsUpdated = false;
+
+	m_SIFT_index.clear();
+	m_SIFT_index_lm2id.clear();
+	m_SIFT_index_id2lm.clear();
 }
 
 void 	CLandmarksMap::TCustomSequenceLandmarks::push_back( const CLandmark	&l)
@@ -1718,6 +1713,17 @@ void 	CLandmarksMap::TCustomSequenceLandmarks::erase(unsigned int indx)
 {
 	m_landmarks.erase( m_landmarks.begin() + indx );
 	m_largestDistanceFromOriginIsUpdated = false;
+
+	// Remove its descriptor from the index, and renumber the landmarks after it:
+	if (indx<m_SIFT_index_lm2id.size())
+	{
+		if (m_SIFT_index_lm2id[indx]>=0)
+			m_SIFT_index.remove(m_SIFT_index_lm2id[indx]);
+		m_SIFT_index_lm2id.erase( m_SIFT_index_lm2id.begin() + indx );
+		for (size_t i=0;i<m_SIFT_index_id2lm.size();i++)
+			if (m_SIFT_index_id2lm[i]>indx)
+				m_SIFT_index_id2lm[i]--;
+	}
 }
 
 void 	CLandmarksMap::TCustomSequenceLandmarks::hasBeenModified(unsigned int indx)
@@ -1771,6 +1777,36 @@ void 	CLandmarksMap::TCustomSequenceLandmarks::hasBeenModifiedAll()
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+						getSIFTDescriptorIndex
+---------------------------------------------------------------*/
+const mrpt::vision::CDescriptorKDForest & CLandmarksMap::TCustomSequenceLandmarks::getSIFTDescriptorIndex() const
+{
+	MRPT_START
+
+	// Add the landmarks inserted since the last call:
+	std::vector<float> desc;
+	for (size_t i=m_SIFT_index_lm2id.size();i<m_landmarks.size();i++)
+	{
+		const CLandmark &lm = m_landmarks[i];
+		int id = -1;
+		if (lm.getType()==featSIFT && !lm.features.empty() && lm.features[0].present() && lm.features[0]->descriptors.hasDescriptorSIFT() &&
+			(!m_SIFT_index.getDescriptorLength() || m_SIFT_index.getDescriptorLength()==lm.features[0]->descriptors.SIFT.size()) )
+		{
+			desc.assign(lm.features[0]->descriptors.SIFT.begin(),lm.features[0]->descriptors.SIFT.end());
+			const size_t new_id = m_SIFT_index.insert(&desc[0],desc.size());
+			if (new_id>=m_SIFT_index_id2lm.size())
+				m_SIFT_index_id2lm.resize(new_id+1);
+			m_SIFT_index_id2lm[new_id] = static_cast<unsigned int>(i);
+			id = static_cast<int>(new_id);
+		}
+		m_SIFT_index_lm2id.push_back(id);
+	}
+	return m_SIFT_index;
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 						getLargestDistanceFromOrigin
 ---------------------------------------------------------------*/
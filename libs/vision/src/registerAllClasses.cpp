@@ -33,6 +33,10 @@ CStartUpClassesRegister  mrpt_vision_class_reg(&registerAllClasses_mrpt_vision);
 void registerAllClasses_mrpt_vision()
 {
 	registerClass( CLASS_ID( CFeature ) );
+	registerClass( CLASS_ID( CDescriptorKDForest ) );
+	registerClass( CLASS_ID( CDescriptorLSH ) );
+	registerClass( CLASS_ID( CVocabularyTree ) );
+	registerClass( CLASS_ID( CBoWDatabase ) );
 
 	registerClass( CLASS_ID( CLandmark ) );
 	registerClass( CLASS_ID( CLandmarksMap ) );
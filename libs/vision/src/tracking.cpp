@@ -596,14 +596,39 @@ void CGenericFeatureTracker::internal_trackFeatures(
 	{
 		m_timlog.enter("[CGenericFeatureTracker] add new features");
 
+		const size_t desired_num_features = extra_params.getWithDefaultVal("desired_num_features_adapt", size_t( (img_width*img_height)>>9 ) );
+		const unsigned int grid_cell_size = extra_params.getWithDefaultVal("add_new_feat_grid_cell_size",0);
+
 		// Look for new features and save in "m_newly_detected_feats", if they're not already computed:
 		if (m_newly_detected_feats.empty())
 		{
 			// Do the detection
-			CFeatureExtraction::detectFeatures_SSE2_FASTER12(
-				cur_gray,
-				m_newly_detected_feats,
-				m_detector_adaptive_thres );
+			if (grid_cell_size>0)
+			{
+				// Evenly spread over the image, detecting in parallel over a grid of cells:
+				CFeatureExtraction::TOptions opts(featFASTER12);
+				opts.patchSize = 0;
+				opts.FASTOptions.threshold = m_detector_adaptive_thres;
+				opts.FASTOptions.nonmax_suppression = false;  // The min. separation is checked below
+				opts.PyramidGridOptions.cell_size = grid_cell_size;
+
+				CImagePyramid  pyr;
+				pyr.images.resize(1);
+				pyr.images[0].setFromImageReadOnly(cur_gray);
+
+				CFeatureExtraction::detectFeatures_SSE2_FASTER_grid(
+					pyr,
+					m_newly_detected_feats,
+					opts,
+					desired_num_features );
+			}
+			else
+			{
+				CFeatureExtraction::detectFeatures_SSE2_FASTER12(
+					cur_gray,
+					m_newly_detected_feats,
+					m_detector_adaptive_thres );
+			}
 		}
 
 		const size_t N = m_newly_detected_feats.size();
@@ -611,7 +636,6 @@ void CGenericFeatureTracker::internal_trackFeatures(
 		last_execution_extra_info.raw_FAST_feats_detected = N; // Extra out info.
 
 		// Update the adaptive threshold.
-		const size_t desired_num_features = extra_params.getWithDefaultVal("desired_num_features_adapt", size_t( (img_width*img_height)>>9 ) );
 		updateAdaptiveNewFeatsThreshold(N,desired_num_features);
 
 		// Use KLT response instead of the OpenCV's original "response" field:
@@ -9,26 +9,312 @@
 
 #include <mrpt/vision.h>  // Precompiled headers
 
-#include <mrpt/system/memory.h>
 #include <mrpt/vision/tracking.h>
-#include <mrpt/vision/CFeatureExtraction.h>
-
-// Universal include for all versions of OpenCV
-#include <mrpt/otherlibs/do_opencv_includes.h>
+#include <mrpt/system/parallelization.h>
+#include <mrpt/utils/SSE_types.h>
 
 
 using namespace mrpt;
 using namespace mrpt::vision;
 using namespace mrpt::utils;
+using namespace mrpt::system;
 using namespace std;
 
 
+namespace
+{
+	// Bilinear interpolation is done in fixed point, with weights of KLT_W_BITS bits.
+	// Interpolated intensities keep 5 fractional bits (32 times the intensity), the same scale than the Scharr gradients in CImagePyramid.
+	const int KLT_W_BITS   = 14;
+	const int KLT_I_SHIFT  = KLT_W_BITS-5;
+
+	/** One octave of a pyramid, as raw pointers */
+	struct TKLTLevel
+	{
+		const uint8_t  *img;
+		size_t          stride;
+		int             W,H;
+		const CImagePyramid::TImageGradients *grad;  // NULL for the images of the "new" pyramid
+	};
+
+	void getLevels(const CImagePyramid &pyr, std::vector<TKLTLevel> &levels)
+	{
+		levels.resize(pyr.images.size());
+		for (size_t i=0;i<levels.size();i++)
+		{
+			levels[i].img    = pyr.images[i].get_unsafe(0,0);
+			levels[i].stride = pyr.images[i].getRowStride();
+			levels[i].W      = pyr.images[i].getWidth();
+			levels[i].H      = pyr.images[i].getHeight();
+			levels[i].grad   = pyr.hasGradients() ? &pyr.gradients[i] : NULL;
+		}
+	}
+
+	/** The four bilinear weights (summing 1<<KLT_W_BITS) of a subpixel offset (a,b) in [0,1) */
+	inline void bilinearWeights(const float a, const float b, int &w00, int &w01, int &w10, int &w11)
+	{
+		w00 = mrpt::utils::round((1.f-a)*(1.f-b)*(1<<KLT_W_BITS));
+		w01 = mrpt::utils::round(a*(1.f-b)*(1<<KLT_W_BITS));
+		w10 = mrpt::utils::round((1.f-a)*b*(1<<KLT_W_BITS));
+		w11 = (1<<KLT_W_BITS) - w00 - w01 - w10;
+	}
+
+	struct TKLTParams
+	{
+		int     half_w, half_h;
+		int     max_iters;
+		float   epsilon_sqr;
+		float   min_eig;
+	};
+
+	/** Per-thread buffers: the interpolated window of the old image and its gradients, with rows padded to multiples of 8 */
+	struct TKLTBuffers
+	{
+		int                   row_stride;
+		std::vector<int16_t>  I, Ix, Iy;
+	};
+
+	/** Sums over the window at (x0,y0)+(a,b) of the new image: (I-J)*Ix and (I-J)*Iy, in fixed point (1024 times the actual values),
+	  *  and (if out_sum_abs_diff!=NULL) |I-J|. The window must be within the image. */
+	void windowResiduals(
+		const TKLTLevel &lev, const TKLTBuffers &buf, const int win_w, const int win_h,
+		const int x0, const int y0, const float a, const float b,
+		float &out_b1, float &out_b2, float *out_sum_abs_diff)
+	{
+		int w00,w01,w10,w11;
+		bilinearWeights(a,b,w00,w01,w10,w11);
+
+		float b1 = 0, b2 = 0, sum_abs = 0;
+#if MRPT_HAS_SSE2
+		const __m128i z    = _mm_setzero_si128();
+		const __m128i qw0  = _mm_set_epi16(w01,w00,w01,w00,w01,w00,w01,w00);
+		const __m128i qw1  = _mm_set_epi16(w11,w10,w11,w10,w11,w10,w11,w10);
+		const __m128i qrnd = _mm_set1_epi32(1 << (KLT_I_SHIFT-1));
+		__m128 qb1 = _mm_setzero_ps(), qb2 = _mm_setzero_ps();
+		// Chunks of 8 pixels can be read while there are 9 bytes left in the image row:
+		const int sse_end = std::min(buf.row_stride, lev.W - x0 - 1);
+#endif
+		for (int j=0;j<win_h;j++)
+		{
+			const uint8_t *r0 = lev.img + (y0+j)*lev.stride + x0;
+			const uint8_t *r1 = r0 + lev.stride;
+			const int16_t *I  = &buf.I [j*buf.row_stride];
+			const int16_t *Ix = &buf.Ix[j*buf.row_stride];
+			const int16_t *Iy = &buf.Iy[j*buf.row_stride];
+
+			int i = 0;
+#if MRPT_HAS_SSE2
+			if (!out_sum_abs_diff)
+			{
+				for (;i+8<=sse_end;i+=8)
+				{
+					const __m128i p00 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r0+i)),z);
+					const __m128i p01 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r0+i+1)),z);
+					const __m128i p10 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r1+i)),z);
+					const __m128i p11 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r1+i+1)),z);
+
+					__m128i t0 = _mm_add_epi32( _mm_madd_epi16(_mm_unpacklo_epi16(p00,p01),qw0), _mm_madd_epi16(_mm_unpacklo_epi16(p10,p11),qw1) );
+					__m128i t1 = _mm_add_epi32( _mm_madd_epi16(_mm_unpackhi_epi16(p00,p01),qw0), _mm_madd_epi16(_mm_unpackhi_epi16(p10,p11),qw1) );
+					t0 = _mm_srai_epi32(_mm_add_epi32(t0,qrnd),KLT_I_SHIFT);
+					t1 = _mm_srai_epi32(_mm_add_epi32(t1,qrnd),KLT_I_SHIFT);
+
+					// Lanes beyond win_w have zero gradients, so they don't count:
+					const __m128i diff = _mm_sub_epi16( _mm_loadu_si128(reinterpret_cast<const __m128i*>(I+i)), _mm_packs_epi32(t0,t1) );
+
+					const __m128i gx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Ix+i));
+					const __m128i gy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Iy+i));
+					const __m128i px_lo = _mm_mullo_epi16(diff,gx), px_hi = _mm_mulhi_epi16(diff,gx);
+					const __m128i py_lo = _mm_mullo_epi16(diff,gy), py_hi = _mm_mulhi_epi16(diff,gy);
+					qb1 = _mm_add_ps(qb1, _mm_add_ps( _mm_cvtepi32_ps(_mm_unpacklo_epi16(px_lo,px_hi)), _mm_cvtepi32_ps(_mm_unpackhi_epi16(px_lo,px_hi)) ));
+					qb2 = _mm_add_ps(qb2, _mm_add_ps( _mm_cvtepi32_ps(_mm_unpacklo_epi16(py_lo,py_hi)), _mm_cvtepi32_ps(_mm_unpackhi_epi16(py_lo,py_hi)) ));
+				}
+			}
+#endif
+			for (;i<win_w;i++)
+			{
+				const int J = (w00*r0[i] + w01*r0[i+1] + w10*r1[i] + w11*r1[i+1] + (1 << (KLT_I_SHIFT-1))) >> KLT_I_SHIFT;
+				const int diff = I[i] - J;
+				b1 += static_cast<float>(diff*Ix[i]);
+				b2 += static_cast<float>(diff*Iy[i]);
+				sum_abs += std::abs(diff);
+			}
+		}
+#if MRPT_HAS_SSE2
+		float s1[4], s2[4];
+		_mm_storeu_ps(s1,qb1);
+		_mm_storeu_ps(s2,qb2);
+		b1 += (s1[0]+s1[1]) + (s1[2]+s1[3]);
+		b2 += (s2[0]+s2[1]) + (s2[2]+s2[3]);
+#endif
+		out_b1 = b1;
+		out_b2 = b2;
+		if (out_sum_abs_diff) *out_sum_abs_diff = sum_abs;
+	}
+
+	/** Pyramidal Lucas-Kanade (after J-Y. Bouguet's description of the method) for one feature.
+	  * \return The new tracking status of the feature. */
+	TFeatureTrackStatus trackOneFeature(
+		const std::vector<TKLTLevel> &prev, const std::vector<TKLTLevel> &cur, const TKLTParams &p, TKLTBuffers &buf,
+		const float x, const float y, float &out_x, float &out_y, float &out_error)
+	{
+		const int win_w = 2*p.half_w+1, win_h = 2*p.half_h+1;
+		const float N = static_cast<float>(win_w*win_h);
+		const int nLevels = static_cast<int>(prev.size());
+
+		// Guess of the new position, in the coordinates of the current level:
+		float nx = x/(1<<(nLevels-1)), ny = y/(1<<(nLevels-1));
+
+		for (int L=nLevels-1;L>=0;L--)
+		{
+			if (L!=nLevels-1) { nx*=2; ny*=2; }
+
+			const TKLTLevel &P = prev[L], &C = cur[L];
+			const float px = x/(1<<L) - p.half_w, py = y/(1<<L) - p.half_h;  // Top-left corner of the window in the old image
+			const int ipx = static_cast<int>(std::floor(px)), ipy = static_cast<int>(std::floor(py));
+
+			if (ipx<0 || ipy<0 || ipx+win_w>=P.W || ipy+win_h>=P.H)
+			{
+				// The window does not fit at this level: try with the finer ones.
+				if (L==0) return status_OOB;
+				continue;
+			}
+
+			// Interpolate the window of the old image and its gradients, and the spatial gradient matrix G=[A11 A12;A12 A22]:
+			{
+				int w00,w01,w10,w11;
+				bilinearWeights(px-ipx,py-ipy,w00,w01,w10,w11);
+				double A11=0,A12=0,A22=0;
+				for (int j=0;j<win_h;j++)
+				{
+					const uint8_t *r0 = P.img + (ipy+j)*P.stride + ipx;
+					const uint8_t *r1 = r0 + P.stride;
+					const int16_t *gx0 = P.grad->dx_row(ipy+j) + ipx, *gx1 = P.grad->dx_row(ipy+j+1) + ipx;
+					const int16_t *gy0 = P.grad->dy_row(ipy+j) + ipx, *gy1 = P.grad->dy_row(ipy+j+1) + ipx;
+					int16_t *I  = &buf.I [j*buf.row_stride];
+					int16_t *Ix = &buf.Ix[j*buf.row_stride];
+					int16_t *Iy = &buf.Iy[j*buf.row_stride];
+					for (int i=0;i<win_w;i++)
+					{
+						I[i]  = static_cast<int16_t>( (w00*r0[i] + w01*r0[i+1] + w10*r1[i] + w11*r1[i+1] + (1 << (KLT_I_SHIFT-1))) >> KLT_I_SHIFT );
+						Ix[i] = static_cast<int16_t>( (w00*gx0[i] + w01*gx0[i+1] + w10*gx1[i] + w11*gx1[i+1] + (1 << (KLT_W_BITS-1))) >> KLT_W_BITS );
+						Iy[i] = static_cast<int16_t>( (w00*gy0[i] + w01*gy0[i+1] + w10*gy1[i] + w11*gy1[i+1] + (1 << (KLT_W_BITS-1))) >> KLT_W_BITS );
+						A11 += Ix[i]*Ix[i];
+						A12 += Ix[i]*Iy[i];
+						A22 += Iy[i]*Iy[i];
+					}
+				}
+				// From fixed point (1024 times) to real values:
+				A11*=(1./1024); A12*=(1./1024); A22*=(1./1024);
+
+				const double D = A11*A22 - A12*A12;
+				const double minEig = (A11 + A22 - std::sqrt((A11-A22)*(A11-A22) + 4*A12*A12))/(2*N);
+				if (minEig<p.min_eig || D<1e-7)
+				{
+					// Not enough texture at this level:
+					if (L==0) return status_LOST;
+					continue;
+				}
+
+				// Newton-Raphson iterations:
+				float prev_dx = 0, prev_dy = 0;
+				for (int it=0;it<p.max_iters;it++)
+				{
+					const float jx = nx - p.half_w, jy = ny - p.half_h;
+					const int ijx = static_cast<int>(std::floor(jx)), ijy = static_cast<int>(std::floor(jy));
+					if (ijx<0 || ijy<0 || ijx+win_w>=C.W || ijy+win_h>=C.H)
+					{
+						if (L==0) return status_OOB;
+						break;
+					}
+
+					float b1,b2;
+					windowResiduals(C,buf,win_w,win_h,ijx,ijy,jx-ijx,jy-ijy,b1,b2,NULL);
+					b1*=(1.f/1024); b2*=(1.f/1024);
+
+					const float dx = static_cast<float>((A22*b1 - A12*b2)/D);
+					const float dy = static_cast<float>((A11*b2 - A12*b1)/D);
+					nx += dx;
+					ny += dy;
+
+					if (dx*dx+dy*dy <= p.epsilon_sqr)
+						break;
+					if (it>0 && std::abs(dx+prev_dx)<0.01f && std::abs(dy+prev_dy)<0.01f)
+					{
+						// Oscillating around the solution:
+						nx -= dx*0.5f;
+						ny -= dy*0.5f;
+						break;
+					}
+					prev_dx = dx; prev_dy = dy;
+				}
+			}
+		}
+
+		// Final tracking error, as the mean absolute difference of intensities (in the range [0,255]):
+		const float jx = nx - p.half_w, jy = ny - p.half_h;
+		const int ijx = static_cast<int>(std::floor(jx)), ijy = static_cast<int>(std::floor(jy));
+		if (ijx<0 || ijy<0 || ijx+win_w>=cur[0].W || ijy+win_h>=cur[0].H)
+			return status_OOB;
+		float b1,b2,sum_abs;
+		windowResiduals(cur[0],buf,win_w,win_h,ijx,ijy,jx-ijx,jy-ijy,b1,b2,&sum_abs);
+
+		out_x = nx;
+		out_y = ny;
+		out_error = sum_abs/(32*N);
+		return status_TRACKED;
+	}
+
+	/** Functor for parallel_for(): tracks a range of features */
+	struct TKLTFeatures
+	{
+		const std::vector<TKLTLevel> &m_prev, &m_cur;
+		const TKLTParams             &m_params;
+		const std::vector<float>     &m_x, &m_y;
+		std::vector<float>           &m_new_x, &m_new_y, &m_error;
+		std::vector<TFeatureTrackStatus> &m_status;
+
+		TKLTFeatures(const std::vector<TKLTLevel> &prev, const std::vector<TKLTLevel> &cur, const TKLTParams &params,
+			const std::vector<float> &x, const std::vector<float> &y,
+			std::vector<float> &new_x, std::vector<float> &new_y, std::vector<float> &error, std::vector<TFeatureTrackStatus> &status) :
+			m_prev(prev), m_cur(cur), m_params(params), m_x(x), m_y(y), m_new_x(new_x), m_new_y(new_y), m_error(error), m_status(status)
+		{ }
+
+		void operator()(const BlockedRange &r) const
+		{
+			TKLTBuffers buf;
+			buf.row_stride = ((2*m_params.half_w+1) + 7) & ~7;
+			const size_t buf_len = buf.row_stride*(2*m_params.half_h+1);
+			buf.I.assign(buf_len,0);  // The padding must be zero
+			buf.Ix.assign(buf_len,0);
+			buf.Iy.assign(buf_len,0);
+
+			for (int i=r.begin();i!=r.end();++i)
+				m_status[i] = trackOneFeature(m_prev,m_cur,m_params,buf,m_x[i],m_y[i],m_new_x[i],m_new_y[i],m_error[i]);
+		}
+	};
+
+	/** Whether the grayscale image is the one at the base of the pyramid */
+	bool isPyramidOf(const CImagePyramid &pyr, const CImage &img, const size_t nOctaves)
+	{
+		if (pyr.images.size()!=nOctaves || !pyr.hasGradients())
+			return false;
+		const CImage &base = pyr.images[0];
+		const size_t W = img.getWidth(), H = img.getHeight();
+		if (base.getWidth()!=W || base.getHeight()!=H || base.isColor()!=img.isColor())
+			return false;
+		for (size_t r=0;r<H;r++)
+			if (0!=std::memcmp(base.get_unsafe(0,r),img.get_unsafe(0,r),W))
+				return false;
+		return true;
+	}
+}
+
 /** Track a set of features from old_img -> new_img using sparse optimal flow (classic KL method)
   *  Optional parameters that can be passed in "extra_params":
   *		- "window_width"  (Default=15)
   *		- "window_height" (Default=15)
   *
-  *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
+  *  The pyramid of new_img (with its gradients) is kept for the next call, where it will be probably old_img.
   */
 template <typename FEATLIST>
 void CFeatureTracker_KL::trackFeatures_impl_templ(
@@ -38,18 +324,19 @@ void CFeatureTracker_KL::trackFeatures_impl_templ(
 {
 MRPT_START
 
-#if MRPT_HAS_OPENCV
 	const unsigned int 	window_width = extra_params.getWithDefaultVal("window_width",15);
 	const unsigned int 	window_height = extra_params.getWithDefaultVal("window_height",15);
 
-	const int 	LK_levels    = extra_params.getWithDefaultVal("LK_levels",3);
-	const int 	LK_max_iters = extra_params.getWithDefaultVal("LK_max_iters",10);
-	const int 	LK_epsilon   = extra_params.getWithDefaultVal("LK_epsilon",0.1);
-	const float LK_max_tracking_error = extra_params.getWithDefaultVal("LK_max_tracking_error",150.0f);
+	const int 	 LK_levels    = extra_params.getWithDefaultVal("LK_levels",3);
+	const int 	 LK_max_iters = extra_params.getWithDefaultVal("LK_max_iters",10);
+	const double LK_epsilon   = extra_params.getWithDefaultVal("LK_epsilon",0.1);
+	const float  LK_max_tracking_error = extra_params.getWithDefaultVal("LK_max_tracking_error",10.0f);
+	const float  LK_min_eigenvalue = extra_params.getWithDefaultVal("LK_min_eigenvalue",1e-4f);
 
 
 	// Both images must be of the same size
 	ASSERT_( old_img.getWidth() == new_img.getWidth() && old_img.getHeight() == new_img.getHeight() );
+	ASSERT_( LK_levels>=0 && window_width>=3 && window_height>=3 )
 
 	const size_t  img_width  = old_img.getWidth();
 	const size_t  img_height = old_img.getHeight();
@@ -60,77 +347,75 @@ MRPT_START
 	const CImage prev_gray(old_img, FAST_REF_OR_CONVERT_TO_GRAY);
 	const CImage cur_gray(new_img, FAST_REF_OR_CONVERT_TO_GRAY);
 
-	// Array conversion MRPT->OpenCV
 	if (nFeatures>0)
 	{
-		CvPoint2D32f *points[2];
-
-		points[0] = reinterpret_cast<CvPoint2D32f *>( mrpt_alloca(sizeof(CvPoint2D32f)*nFeatures) );
-		points[1] = reinterpret_cast<CvPoint2D32f *>( mrpt_alloca(sizeof(CvPoint2D32f)*nFeatures) );
-
-		std::vector<char>	status(nFeatures);
-
+		// Pyramids: the old one, with gradients, is normally the new one of the previous call:
+		const size_t nOctaves = LK_levels+1;
+		if (!isPyramidOf(m_prev_pyr,prev_gray,nOctaves))
+		{
+			m_timlog.enter("[CFeatureTracker_KL] Build old pyramid");
+			m_prev_pyr.buildPyramid(prev_gray,nOctaves,true,true);
+			m_prev_pyr.buildGradients();
+			m_timlog.leave("[CFeatureTracker_KL] Build old pyramid");
+		}
+		m_timlog.enter("[CFeatureTracker_KL] Build new pyramid");
+		m_cur_pyr.buildPyramid(cur_gray,nOctaves,true,true);
+		m_timlog.leave("[CFeatureTracker_KL] Build new pyramid");
+
+		std::vector<TKLTLevel> prev_levels, cur_levels;
+		getLevels(m_prev_pyr,prev_levels);
+		getLevels(m_cur_pyr,cur_levels);
+
+		TKLTParams params;
+		params.half_w      = window_width/2;
+		params.half_h      = window_height/2;
+		params.max_iters   = LK_max_iters;
+		params.epsilon_sqr = static_cast<float>(LK_epsilon*LK_epsilon);
+		params.min_eig     = LK_min_eigenvalue;
+
+		std::vector<float> x(nFeatures), y(nFeatures), new_x(nFeatures), new_y(nFeatures), track_error(nFeatures);
+		std::vector<TFeatureTrackStatus> status(nFeatures);
 		for(size_t i=0;i<nFeatures;++i)
 		{
-			points[0][i].x = featureList.getFeatureX(i);
-			points[0][i].y = featureList.getFeatureY(i);
-		} // end for
-
-		// local scope for auxiliary variables around cvCalcOpticalFlowPyrLK()
-		const IplImage *prev_gray_ipl = prev_gray.getAs<IplImage>();
-		const IplImage *cur_gray_ipl  = cur_gray.getAs<IplImage>();
-
-		// Pyramids
-		// JL: It seems that cache'ing the pyramids of previous images doesn't really improve the efficiency (!?!?)
-		IplImage* pPyr = NULL;
-		IplImage* cPyr = NULL;
+			x[i] = featureList.getFeatureX(i);
+			y[i] = featureList.getFeatureY(i);
+		}
 
-		int	flags = 0;
-
-		float* track_error = reinterpret_cast<float*>( mrpt_alloca(sizeof(float)*nFeatures) );
-
-		cvCalcOpticalFlowPyrLK(prev_gray_ipl, cur_gray_ipl, pPyr, cPyr,
-			&points[0][0], &points[1][0], nFeatures, cvSize( window_width, window_height ), LK_levels, &status[0], track_error,
-			cvTermCriteria(CV_TERMCRIT_ITER|CV_TERMCRIT_EPS,LK_max_iters,LK_epsilon), flags );
-
-		cvReleaseImage( &pPyr );
-		cvReleaseImage( &cPyr );
+		mrpt::system::parallel_for(
+			BlockedRange(0,static_cast<int>(nFeatures),32),
+			TKLTFeatures(prev_levels,cur_levels,params,x,y,new_x,new_y,track_error,status) );
 
 		for(size_t i=0;i<nFeatures;++i)
 		{
-			const bool trck_err_too_large = track_error[i]>LK_max_tracking_error;
+			const bool trck_err_too_large = status[i]==status_TRACKED && track_error[i]>LK_max_tracking_error;
 
-			if( status[i] == 1 &&
+			if( status[i] == status_TRACKED &&
 				!trck_err_too_large &&
-				points[1][i].x > 0 && points[1][i].y > 0 &&
-				points[1][i].x < img_width && points[1][i].y < img_height )
+				new_x[i] > 0 && new_y[i] > 0 &&
+				new_x[i] < img_width && new_y[i] < img_height )
 			{
 				// Feature could be tracked
-				featureList.setFeatureXf(i, points[1][i].x );
-				featureList.setFeatureYf(i, points[1][i].y );
+				featureList.setFeatureXf(i, new_x[i] );
+				featureList.setFeatureYf(i, new_y[i] );
 				featureList.setTrackStatus(i, status_TRACKED );
 			} // end if
 			else	// Feature could not be tracked
 			{
 				featureList.setFeatureX(i,-1);
 				featureList.setFeatureY(i,-1);
-				featureList.setTrackStatus(i, trck_err_too_large ? status_LOST : status_OOB );
+				featureList.setTrackStatus(i, (trck_err_too_large || status[i]==status_LOST) ? status_LOST : status_OOB );
 			} // end else
 		} // end for
 
-		mrpt_alloca_free( points[0] );
-		mrpt_alloca_free( points[1] );
-		mrpt_alloca_free( track_error );
-
+		// The new pyramid will be the old one in the next call:
+		m_prev_pyr.images.swap(m_cur_pyr.images);
+		m_prev_pyr.gradients.swap(m_cur_pyr.gradients);
+		m_prev_pyr.buildGradients();
 
 		// In case it needs to rebuild a kd-tree or whatever
 		featureList.mark_as_outdated();
 	}
 
-#else
-	THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
-#endif
-
 	MRPT_END
 } // end trackFeatures
 
@@ -0,0 +1,95 @@
+/* +---------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)               |
+   |                          http://www.mrpt.org/                             |
+   |                                                                           |
+   | Copyright (c) 2005-2014, Individual contributors, see AUTHORS file        |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                   |
+   | Released under BSD License. See details in http://www.mrpt.org/License    |
+   +---------------------------------------------------------------------------+ */
+
+#include <mrpt/vision.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::utils;
+using namespace std;
+
+// CImage and CImagePyramid require OpenCV:
+#if MRPT_HAS_OPENCV
+
+const unsigned int W = 320, H = 240;
+const double FLAT_X = 260, FLAT_Y = 180;  // Center of a flat square of 50x50 pixels
+
+// A smooth texture, except for the flat square:
+static double intensity(const double x, const double y)
+{
+	if (std::abs(x-FLAT_X)<25 && std::abs(y-FLAT_Y)<25) return 128;
+	return 128 + 45*sin(0.21*x+0.13*y) + 40*cos(0.17*y-0.05*x+1.0) + 30*sin(0.09*x)*cos(0.11*y);
+}
+
+// The texture moved by (dx,dy) pixels:
+static void makeShiftedImage(CImage &img, const double dx, const double dy)
+{
+	img = CImage(W,H,CH_GRAY);
+	for (unsigned int y=0;y<H;y++)
+		for (unsigned int x=0;x<W;x++)
+			*img(x,y) = static_cast<unsigned char>( mrpt::utils::round(intensity(x-dx,y-dy)) );
+}
+
+TEST(CFeatureTracker_KL, SubpixelShift)
+{
+	const double dx = 1.35, dy = -0.65;
+	CImage img0, img1, img2;
+	makeShiftedImage(img0,0,0);
+	makeShiftedImage(img1,dx,dy);
+	makeShiftedImage(img2,2*dx,2*dy);
+
+	// Odd and even window sizes (even sizes use the next odd one):
+	const unsigned int win_sizes[][2] = { {15,15}, {8,8}, {14,9} };
+	for (size_t w=0;w<sizeof(win_sizes)/sizeof(win_sizes[0]);w++)
+	{
+		CFeatureTracker_KL tracker;
+		tracker.extra_params["window_width"]  = win_sizes[w][0];
+		tracker.extra_params["window_height"] = win_sizes[w][1];
+		tracker.enableTimeLogger();
+
+		TSimpleFeaturefList feats;
+		for (int y=40;y<=160;y+=40)
+			for (int x=40;x<=200;x+=40)
+				feats.push_back(TSimpleFeaturef(float(x),float(y)));
+		const size_t nTextured = feats.size();
+		feats.push_back(TSimpleFeaturef(2.f,100.f));      // Near the borders
+		feats.push_back(TSimpleFeaturef(float(W-2),100.f));
+		feats.push_back(TSimpleFeaturef(100.f,1.f));
+		const size_t nBorder = feats.size()-nTextured;
+		feats.push_back(TSimpleFeaturef(float(FLAT_X),float(FLAT_Y)));  // On the flat patch
+		const std::vector<TSimpleFeaturef> initial(feats.begin(),feats.end());
+
+		for (int step=1;step<=2;step++)
+		{
+			tracker.trackFeatures(step==1 ? img0 : img1, step==1 ? img1 : img2, feats);
+			ASSERT_EQ(feats.size(), initial.size());
+
+			for (size_t i=0;i<nTextured;i++)
+			{
+				ASSERT_EQ(feats[i].track_status, status_TRACKED) << "window=" << win_sizes[w][0] << "x" << win_sizes[w][1] << " i=" << i;
+				EXPECT_NEAR(feats[i].pt.x, initial[i].pt.x + step*dx, 0.1) << "window=" << win_sizes[w][0] << "x" << win_sizes[w][1];
+				EXPECT_NEAR(feats[i].pt.y, initial[i].pt.y + step*dy, 0.1) << "window=" << win_sizes[w][0] << "x" << win_sizes[w][1];
+			}
+			for (size_t i=nTextured;i<nTextured+nBorder;i++)
+				EXPECT_EQ(feats[i].track_status, status_OOB) << "i=" << i;
+			EXPECT_EQ(feats.back().track_status, status_LOST);
+		}
+
+		// The pyramid of the new image of the 1st call has been reused as the old one in the 2nd call:
+		std::map<std::string,CTimeLogger::TCallStats> stats;
+		tracker.getProfiler().getStats(stats);
+		ASSERT_TRUE(stats.find("[CFeatureTracker_KL] Build old pyramid")!=stats.end());
+		ASSERT_TRUE(stats.find("[CFeatureTracker_KL] Build new pyramid")!=stats.end());
+		EXPECT_EQ(stats["[CFeatureTracker_KL] Build old pyramid"].n_calls, 1u);
+		EXPECT_EQ(stats["[CFeatureTracker_KL] Build new pyramid"].n_calls, 2u);
+	}
+}
+
+#endif
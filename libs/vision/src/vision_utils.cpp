@@ -474,8 +474,8 @@ size_t vision::matchFeatures(
 
 	CFeatureList::const_iterator	itList1, itList2;	// Iterators for the lists
 
-	// For SIFT & SURF
-	float							distDesc;			// EDD or EDSD
+	// For SIFT, SURF & ORB
+	float							distDesc;			// EDD, EDSD or Hamming distance
 	float							minDist1;		    // Minimum EDD or EDSD
 	float							minDist2;		    // Second minimum EDD or EDSD
 
@@ -675,6 +675,28 @@ size_t vision::matchFeatures(
 #endif
 					break;
 				} // end mmSAD
+
+				case TMatchingOptions::mmDescriptorORB:
+				{
+					// Ensure that both features have ORB descriptors
+					ASSERT_((*itList1)->descriptors.hasDescriptorORB() && (*itList2)->descriptors.hasDescriptorORB() );
+
+					// Compute the Hamming distance between descriptors
+					distDesc = (*itList1)->descriptorORBDistanceTo( *(*itList2) );
+
+					// Search for the two minimum values
+					if( distDesc < minDist1 )
+					{
+						minDist2 = minDist1;
+						minDist1 = distDesc;
+						minLeftIdx  = lFeat;
+						minRightIdx = rFeat;
+					}
+					else if ( distDesc < minDist2 )
+						minDist2 = distDesc;
+
+					break;
+				} // end mmDescriptorORB
 				} // end switch
 			} // end if
 		} // end for 'list2' (right features)
@@ -703,6 +725,11 @@ size_t vision::matchFeatures(
 				cond2 = (minSAD1/minSAD2) < options.SAD_RATIO;
 				minVal = minSAD1;
 				break;
+			case TMatchingOptions::mmDescriptorORB:
+				cond1 = minDist1 <= options.maxHD_TH;						// Maximum Hamming Distance between ORB descriptors (HD)
+				cond2 = (minDist1/minDist2) < options.HD_RATIO;				// Ratio between the two lowest HD
+				minVal = minDist1;
+				break;
 			default:
 				THROW_EXCEPTION("Invalid value of 'matching_method'");
 		}
@@ -2184,6 +2211,10 @@ TMatchingOptions::TMatchingOptions() :
 	maxSAD_TH	( 0.4 ),
 	SAD_RATIO	( 0.5 ),
 
+	// ORB
+	maxHD_TH	( 64 ),
+	HD_RATIO	( 0.8 ),
+
 	// For estimating depth
 	estimateDepth       ( false ),
 	maxDepthThreshold   ( 15.0 )
@@ -2216,6 +2247,9 @@ void  TMatchingOptions::loadFromConfigFile(
 	case 3:
 		matching_method = mmSAD;
 		break;
+	case 4:
+		matching_method = mmDescriptorORB;
+		break;
 	} // end switch
 
     useEpipolarRestriction  = iniFile.read_bool(section.c_str(), "useEpipolarRestriction", useEpipolarRestriction );
@@ -2235,6 +2269,8 @@ void  TMatchingOptions::loadFromConfigFile(
 	maxSAD_TH		= iniFile.read_float(section.c_str(),"maxSAD_TH",maxSAD_TH);
 	SAD_RATIO		= iniFile.read_float(section.c_str(),"SAD_RATIO",SAD_RATIO);
 	SAD_RATIO		= iniFile.read_float(section.c_str(),"SAD_RATIO",SAD_RATIO);
+	maxHD_TH		= iniFile.read_float(section.c_str(),"maxHD_TH",maxHD_TH);
+	HD_RATIO		= iniFile.read_float(section.c_str(),"HD_RATIO",HD_RATIO);
 
 	estimateDepth       = iniFile.read_bool(section.c_str(), "estimateDepth", estimateDepth );
 	maxDepthThreshold   = iniFile.read_float(section.c_str(), "maxDepthThreshold", maxDepthThreshold );
@@ -2275,6 +2311,11 @@ void  TMatchingOptions::dumpToTextStream(
         out.printf("· Max. Dif. SAD Threshold:      %f\n", maxSAD_TH);
         out.printf("· Ratio SAD Threshold:          %f\n", SAD_RATIO);
 		break;
+	case mmDescriptorORB:
+		out.printf("ORB descriptor\n");
+        out.printf("· Max. Hamming Dist. Threshold: %f\n", maxHD_TH);
+        out.printf("· Hamming Dist. Ratio:          %f\n", HD_RATIO);
+		break;
 	} // end switch
 	out.printf("Epipolar Thres:                 %.2f px\n", epipolar_TH);
 	out.printf("Using epipolar restriction?:    ");
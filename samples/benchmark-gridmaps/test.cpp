@@ -144,14 +144,14 @@ void BenchmarkGridmaps()
 		COccupancyGridMap2D::cellType  logodd_obs = COccupancyGridMap2D::p2l( p );
 		//float   p_1 = 1-p;
 
-		COccupancyGridMap2D::cellType  *theMapArray = gridMap->getRow(0);
+		COccupancyGridMap2D::cellType  *theMapArray = gridMap->getRow(2);  // Rows are not contiguous in memory
 		unsigned  theMapSize_x = gridMap->getSizeX();
 		COccupancyGridMap2D::cellType   logodd_thres_occupied =  COccupancyGridMap2D::OCCGRID_CELLTYPE_MIN+logodd_obs;
 
 		tictac.Tic();
 		for (i=0;i<N;i++)
 		{
-			COccupancyGridMap2D::updateCell_fast_occupied( 2, 2, logodd_obs,logodd_thres_occupied, theMapArray, theMapSize_x);
+			COccupancyGridMap2D::updateCell_fast_occupied( 2, 0, logodd_obs,logodd_thres_occupied, theMapArray, theMapSize_x);
 		}
 		double T = tictac.Tac();
 		cout << "-> " << 1e9*T/N << " ns/iter." << endl;  // the "p" is to avoid optimizing out the entire loop!